@@ -589,6 +589,10 @@ struct AsmWaitConfig
     cxuint waitQueuesNum;
     AsmDelayedOpTypeEntry delayOpTypes[ASM_DELAYED_OP_MAX_TYPES_NUM];
     uint16_t waitQueueSizes[ASM_WAIT_MAX_TYPES_NUM];
+    /// estimated latencies of operations in wait queues (in cycles)
+    uint16_t waitQueueLatencies[ASM_WAIT_MAX_TYPES_NUM];
+    /// maximal number of wait states required by hazards between instructions
+    cxuint hazardWaitStates;
 };
 
 enum : cxbyte
@@ -617,6 +621,51 @@ struct AsmWaitInstr
     uint16_t waits[ASM_WAIT_MAX_TYPES_NUM];
 };
 
+/// reordering class of instruction (for moving instructions before wait instructions)
+enum : cxbyte
+{
+    ASMREORDER_NONE = 0,    ///< instruction can not be crossed by moved instructions
+    /// can not be crossed and needs wait states after previous instructions
+    ASMREORDER_HAZARD,
+    ASMREORDER_CROSS,       ///< can be crossed by independent moved instructions
+    ASMREORDER_MOVE         ///< can be moved before independent instructions
+};
+
+/// instruction moved before wait instruction to hide latency of waited operations
+struct AsmMovedInstr
+{
+    size_t offset;  ///< offset of moved instruction
+    size_t target;  ///< offset of instruction before which instruction is moved
+};
+
+/// type of spill instruction
+enum class AsmSpillType: cxbyte
+{
+    SAVE_SGPR = 0,  ///< save SGPR to lane of VGPR
+    RESTORE_SGPR,   ///< restore SGPR from lane of VGPR
+    SAVE_VGPR,      ///< save VGPR to scratch buffer
+    RESTORE_VGPR    ///< restore VGPR from scratch buffer
+};
+
+/// spill instruction (inserted by register allocator)
+struct AsmSpillInstr
+{
+    size_t offset;      ///< offset (for save instruction: offset after instruction)
+    AsmSpillType type;  ///< type of spill instruction
+    cxuint reg;         ///< spilled register (real register index)
+    cxuint spillReg;    ///< VGPR for SGPR spills or scratch resource (first SGPR)
+    cxuint spillOffset; ///< lane of VGPR or offset in scratch buffer
+    cxuint scratchOffsetReg;  ///< scratch wave offset SGPR (for VGPR spills)
+};
+
+/// scratch buffer resources used to spill VGPRs
+struct AsmSpillScratch
+{
+    bool defined;       ///< true if defined
+    cxuint rsrcReg;     ///< first SGPR of scratch buffer resource
+    cxuint offsetReg;   ///< scratch wave offset SGPR
+};
+
 /// code flow type
 enum AsmCodeFlowType
 {
@@ -636,6 +685,15 @@ struct AsmCodeFlowEntry
     AsmCodeFlowType type;   ///< type of code flow entry
 };
 
+/// absolute value computed from code labels (depends on code between labels)
+struct AsmCodeLabelsDiff
+{
+    AsmSectionId sectionId; ///< section of labels
+    size_t minOffset;   ///< lowest offset of labels
+    size_t maxOffset;   ///< highest offset of labels
+    AsmSourcePos sourcePos; ///< source position of expression
+};
+
 /// assembler macro map
 typedef std::unordered_map<CString, RefPtr<const AsmMacro> > AsmMacroMap;
 
@@ -738,6 +796,8 @@ struct AsmKernel
     const char* name;   ///< name of kernel
     AsmSourcePos sourcePos; ///< source position of definition
     std::vector<std::pair<size_t, size_t> > codeRegions; ///< code regions
+    cxuint targetOccupancy; ///< target waves per SIMD (0 - not specified)
+    AsmSpillScratch spillScratch;   ///< scratch resources for VGPR spilling
     
     /// open kernel region in code
     void openCodeRegion(size_t offset);
@@ -745,6 +805,21 @@ struct AsmKernel
     void closeCodeRegion(size_t offset);
 };
 
+/// occupancy of kernel after register allocation
+struct AsmKernelOccupancy
+{
+    bool allocated;     ///< true if registers of kernel has been allocated
+    cxuint targetWaves; ///< target waves per SIMD (0 - not specified)
+    cxuint regsNum[MAX_REGTYPES_NUM];    ///< used registers (SGPRs with extra registers)
+    cxuint regsLimits[MAX_REGTYPES_NUM]; ///< registers limits for target waves
+    size_t localSize;   ///< local (LDS) size used by kernel
+    cxuint regWaves[MAX_REGTYPES_NUM];   ///< waves per SIMD limited by registers
+    cxuint localSizeWaves;   ///< waves per SIMD limited by local size
+    cxuint waves;       ///< resulting waves per SIMD
+    size_t eliminatedCopies;    ///< copies eliminated by coalescing
+    size_t spillScratchSize;    ///< scratch size per lane for spilled VGPRs
+};
+
 /// linears for regvars
 class AsmRegVarLinears: std::vector<std::pair<uint16_t, uint16_t> >
 {
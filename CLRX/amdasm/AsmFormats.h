@@ -213,6 +213,12 @@ public:
     
     /// prepare before section diference resolving
     virtual bool prepareSectionDiffsResolving();
+    
+    /// update allocated registers of kernel (after register allocation)
+    /** new register numbers are maximum of old and given register numbers */
+    virtual void updateKernelAllocRegs(AsmKernelId kernelId, const cxuint* regs);
+    /// get local (LDS) size used by kernel (0 if unknown)
+    virtual size_t getKernelLocalSize(AsmKernelId kernelId) const;
 };
 
 /// format handler with Kcode (kernel-code) handling
@@ -234,6 +240,7 @@ protected:
     void prepareKcodeState();
 public:
     void handleLabel(const CString& label);
+    void updateKernelAllocRegs(AsmKernelId kernelId, const cxuint* regs);
     
     /// return true if current section is code section
     virtual bool isCodeSection() const = 0;
@@ -339,6 +346,8 @@ public:
     bool prepareBinary();
     void writeBinary(std::ostream& os) const;
     void writeBinary(Array<cxbyte>& array) const;
+    void updateKernelAllocRegs(AsmKernelId kernelId, const cxuint* regs);
+    size_t getKernelLocalSize(AsmKernelId kernelId) const;
     /// get output structure pointer
     const AmdInput* getOutput() const
     { return &output; }
@@ -455,6 +464,8 @@ public:
     bool prepareBinary();
     void writeBinary(std::ostream& os) const;
     void writeBinary(Array<cxbyte>& array) const;
+    void updateKernelAllocRegs(AsmKernelId kernelId, const cxuint* regs);
+    size_t getKernelLocalSize(AsmKernelId kernelId) const;
     /// get output structure pointer
     const AmdCL2Input* getOutput() const
     { return &output; }
@@ -540,6 +551,7 @@ public:
     bool prepareBinary();
     void writeBinary(std::ostream& os) const;
     void writeBinary(Array<cxbyte>& array) const;
+    size_t getKernelLocalSize(AsmKernelId kernelId) const;
     /// get output object (input for bingenerator)
     const GalliumInput* getOutput() const
     { return &output; }
@@ -619,6 +631,7 @@ public:
     bool prepareBinary();
     void writeBinary(std::ostream& os) const;
     void writeBinary(Array<cxbyte>& array) const;
+    size_t getKernelLocalSize(AsmKernelId kernelId) const;
     /// get output object (input for bingenerator)
     const ROCmInput* getOutput() const
     { return &output; }
@@ -34,6 +34,8 @@
 #include <utility>
 #include <stack>
 #include <list>
+#include <memory>
+#include <functional>
 #include <unordered_set>
 #include <unordered_map>
 #include <CLRX/utils/Utilities.h>
@@ -62,10 +64,20 @@ enum: Flags
     ASM_BUGGYFPLIT = 8, ///< buggy handling of fpliterals (including fp constants)
     ASM_MACRONOCASE = 16, /// disable case-insensitive naming (default)
     ASM_OLDMODPARAM = 32,   ///< use old modifier parametrization (values 0 and 1 only)
+    ASM_CODEANALYSIS = 64,  ///< collect register usages for code analysis
+    ASM_ALLOCREGS = 128,    ///< allocate registers for register variables
+    ASM_AUTOWAIT = 256,     ///< insert wait instructions automatically
+    ASM_DOMSSA = 512,       ///< use dominator-based SSA construction in allocation
+    ASM_DFLIVENESS = 1024,  ///< compute livenesses by dataflow analysis in allocation
+    ASM_COALESCE = 2048,    ///< coalesce copies of register variables in allocation
+    ASM_LATENCYWAIT = 4096, ///< move independent instructions before inserted waits
+    ASM_MERGESTRTABS = 8192, ///< merge string tables in generated binaries
     ASM_TESTRESOLVE = (1U<<30), ///< enable resolving symbols if ASM_TESTRUN enabled
     ASM_TESTRUN = (1U<<31), ///< only for running tests
     ASM_ALL = FLAGS_ALL&~(ASM_TESTRUN|ASM_TESTRESOLVE|ASM_BUGGYFPLIT|ASM_MACRONOCASE|
-                    ASM_OLDMODPARAM)  ///< all flags
+                    ASM_OLDMODPARAM|ASM_CODEANALYSIS|ASM_ALLOCREGS|
+                    ASM_AUTOWAIT|ASM_DOMSSA|ASM_DFLIVENESS|ASM_COALESCE|
+                    ASM_LATENCYWAIT|ASM_MERGESTRTABS)  ///< all flags
 };
 
 struct AsmRegVar;
@@ -265,6 +277,29 @@ public:
     /// get size of instruction
     virtual size_t getInstructionSize(size_t codeSize, const cxbyte* code) const = 0;
     virtual const AsmWaitConfig& getWaitConfig() const = 0;
+    /// set register field in instruction after register allocation
+    /** returns false if register field can not be set
+     * \param sectionData section content
+     * \param offset instruction offset
+     * \param regField register field
+     * \param rreg first real register (with register range offset) */
+    virtual bool resolveRegVarField(cxbyte* sectionData, size_t offset,
+                AsmRegField regField, cxuint rreg) = 0;
+    /// resolve jump after moving code (jump instruction at offset, target at target)
+    virtual bool resolveJump(const AsmSourcePos& sourcePos, cxbyte* sectionData,
+                size_t offset, size_t target) = 0;
+    /// encode wait instruction and put it to output
+    virtual void encodeWaitInstr(const AsmWaitInstr& waitInstr,
+                std::vector<cxbyte>& output) const = 0;
+    /// encode spill instructions (at this same offset) and put them to output
+    /** encoded code includes waits and nops required by spill instructions */
+    virtual void encodeSpillInstrs(size_t instrsNum, const AsmSpillInstr* instrs,
+                std::vector<cxbyte>& output) const = 0;
+    /// return true if instruction is plain move of single register (without modifiers)
+    virtual bool isCopyInstr(size_t codeSize, const cxbyte* code) const = 0;
+    /// get number of cycles of instruction and its reordering class (ASMREORDER_*)
+    virtual cxuint getInstrSchedInfo(size_t codeSize, const cxbyte* code,
+                cxbyte& reorderClass) const = 0;
 };
 
 /// GCN arch assembler
@@ -352,6 +387,16 @@ public:
     bool parseRegisterType(const char*& linePtr, const char* end, cxuint& type);
     size_t getInstructionSize(size_t codeSize, const cxbyte* code) const;
     const AsmWaitConfig& getWaitConfig() const;
+    bool resolveRegVarField(cxbyte* sectionData, size_t offset,
+                AsmRegField regField, cxuint rreg);
+    bool resolveJump(const AsmSourcePos& sourcePos, cxbyte* sectionData,
+                size_t offset, size_t target);
+    void encodeWaitInstr(const AsmWaitInstr& waitInstr, std::vector<cxbyte>& output) const;
+    void encodeSpillInstrs(size_t instrsNum, const AsmSpillInstr* instrs,
+                std::vector<cxbyte>& output) const;
+    bool isCopyInstr(size_t codeSize, const cxbyte* code) const;
+    cxuint getInstrSchedInfo(size_t codeSize, const cxbyte* code,
+                cxbyte& reorderClass) const;
 };
 
 class AsmRegAllocator
@@ -402,8 +447,77 @@ public:
      // first - orig ssaid, second - dest ssaid
     typedef std::pair<size_t, size_t> SSAReplace;
     typedef std::unordered_map<AsmSingleVReg, VectorSet<SSAReplace> > SSAReplacesMap;
-    // interference graph type
-    typedef Array<DTreeSet<size_t> > InterGraph;
+    /// interference graph
+    /** dense graphs are stored as a bit matrix (one row of bits per node, both
+     * halves of symmetric matrix, thus neighbors of node can be scanned word by word),
+     * sparse graphs are stored as a compressed adjacency lists */
+    class InterGraph
+    {
+    public:
+        /// storage mode
+        enum Mode: cxbyte
+        {
+            AUTO = 0,   ///< choose by size and density of graph
+            DENSE,      ///< bit matrix
+            SPARSE      ///< adjacency lists
+        };
+    private:
+        size_t nodesNum;
+        size_t rowWords;    // words per row in bit matrix
+        bool dense;
+        Array<uint64_t> matrix;
+        Array<size_t> adjStarts;    // nodesNum+1 starts in adjNodes
+        Array<size_t> adjNodes;
+        Array<size_t> degrees;
+        
+        void buildFromEdges(std::vector<std::pair<size_t, size_t> >& edges, Mode mode);
+    public:
+        InterGraph() : nodesNum(0), rowWords(0), dense(false)
+        { }
+        
+        /// build graph from livenesses (by sweeping over sorted live intervals)
+        void build(size_t nodesNum, const Array<OutLiveness>& livenesses,
+                   Mode mode = AUTO);
+        /// clear graph
+        void clear();
+        /// merge nodes into their representatives (reps[node] - representative)
+        /** merged nodes (other than representatives) are left without neighbors */
+        void contract(const std::vector<size_t>& reps);
+        
+        /// get nodes number
+        size_t size() const
+        { return nodesNum; }
+        /// return true if graph stored as bit matrix
+        bool isDense() const
+        { return dense; }
+        /// get node degree
+        size_t degree(size_t node) const
+        { return degrees[node]; }
+        /// return true if two nodes interferes
+        bool interferes(size_t a, size_t b) const
+        {
+            if (dense)
+                return (matrix[a*rowWords + (b>>6)] & (1ULL<<(b&63))) != 0;
+            return std::binary_search(adjNodes.begin()+adjStarts[a],
+                        adjNodes.begin()+adjStarts[a+1], b);
+        }
+        
+        /// call func for every neighbor of node (in increasing order)
+        template<typename F>
+        void forEachNeighbor(size_t node, F func) const
+        {
+            if (dense)
+            {
+                const uint64_t* row = matrix.data() + node*rowWords;
+                for (size_t w = 0; w < rowWords; w++)
+                    for (uint64_t word = row[w]; word != 0; word &= word-1)
+                        func((w<<6) + CTZ64(word));
+            }
+            else
+                for (size_t i = adjStarts[node]; i < adjStarts[node+1]; i++)
+                    func(adjNodes[i]);
+        }
+    };
     typedef std::unordered_map<AsmSingleVReg, std::vector<size_t> > VarIndexMap;
     struct LinearDep
     {
@@ -416,7 +530,31 @@ public:
     {
         DTree<size_t> vs[MAX_REGTYPES_NUM];
     };
+    /// move between single register variables (copy)
+    struct CopyInstr
+    {
+        size_t offset;  ///< instruction offset
+        size_t dstNode; ///< graph node of destination
+        size_t srcNode; ///< graph node of source
+        uint64_t weight;    ///< weight of copy (10^(loop depth))
+    };
 private:
+    // color graph with colors limit, return false if not enough colors
+    // (failedNode is first node that can not be colored)
+    bool colorInterferenceGraph(size_t regType, size_t maxColorsNum, size_t& failedNode);
+    // collect group of linearly dependent nodes with their positions in group
+    void collectLinearGroup(size_t regType, size_t node,
+                std::vector<std::pair<size_t, cxuint> >& group, cxuint& groupAlign) const;
+    // spill register variables until graph can be colored
+    bool spillAndColorInterferenceGraph(size_t regType, size_t maxColorsNum);
+    // compute spill costs and registers needed for spilled variables, find copies
+    void computeSpillCosts(ISAUsageHandler& usageHandler, const cxbyte* code,
+                size_t codeSize);
+    // coalesce copies (Briggs and George tests), return true if any node merged
+    bool coalesceCopies(size_t regType, size_t colorsNum);
+    // collect SSA infos (usages) of code blocks, return false if no usages
+    bool collectSSAInfos(ISAUsageHandler& usageHandler);
+    
     Assembler& assembler;
     std::vector<CodeBlock> codeBlocks;
     SSAReplacesMap ssaReplacesMap;
@@ -428,6 +566,27 @@ private:
     InterGraph interGraphs[MAX_REGTYPES_NUM]; // for 2 register 
     Array<cxuint> graphColorMaps[MAX_REGTYPES_NUM];
     std::unordered_map<size_t, LinearDep> linearDepMaps[MAX_REGTYPES_NUM];
+    // number of failed linear dependencies (reported later by assembler)
+    size_t linearDepsFailures;
+    cxuint targetOccupancy; // target waves per SIMD (0 - not specified)
+    bool targetOccupancyMissed[MAX_REGTYPES_NUM];
+    // loop depths of code blocks (from code structure)
+    std::vector<cxuint> loopDepths;
+    // spill costs of nodes (usages weighted by loop depth)
+    Array<uint64_t> spillCosts[MAX_REGTYPES_NUM];
+    // registers needed to hold spilled register variables in single instruction
+    cxuint spillTempsNums[MAX_REGTYPES_NUM];
+    cxuint spillTempBases[MAX_REGTYPES_NUM];
+    std::vector<bool> spilledNodes[MAX_REGTYPES_NUM];
+    AsmSpillScratch spillScratch;
+    // scratch size per lane needed by spilled VGPRs (in bytes)
+    size_t spillScratchSize;
+    std::vector<AsmSpillInstr> spillInstrs;
+    std::vector<CopyInstr> copyInstrs[MAX_REGTYPES_NUM];
+    // representatives of coalesced nodes (empty if no coalescing)
+    std::vector<size_t> coalescedNodes[MAX_REGTYPES_NUM];
+    // offsets of copies that became moves to same register
+    std::vector<size_t> removedInstrs;
     // key - routine block, value - set of svvregs (lv indexes) used in routine
     std::unordered_map<size_t, VIdxSetEntry> vidxRoutineMap;
     // key - call block, value - set of svvregs (lv indexes) used between this call point
@@ -443,14 +602,92 @@ public:
              size_t codeSize, const cxbyte* code);
     void createSSAData(ISAUsageHandler& usageHandler,
                 ISALinearDepHandler& linDepHandler);
+    /// create SSA data by using dominator tree and dominance frontiers
+    /** alternative to createSSAData, faster for deeply nested loops and routines.
+     * routines are not distinguished by call points, hence SSA ids of register
+     * variables that pass through routine can be joined */
+    void createSSADataByDominators(ISAUsageHandler& usageHandler,
+                ISALinearDepHandler& linDepHandler);
     void applySSAReplaces();
     void createLivenesses(ISAUsageHandler& usageHandler,
                 ISALinearDepHandler& linDepHandler);
+    /// create livenesses by backward dataflow analysis over bitsets
+    /** alternative to createLivenesses. routines are not distinguished by call points,
+     * hence variables that live through routine call live in the routine's code */
+    void createLivenessesByDataflow(ISAUsageHandler& usageHandler,
+                ISALinearDepHandler& linDepHandler);
     void createInterferenceGraph();
     void colorInterferenceGraph();
-    
+    /// create interference graph only for specified register type
+    void createInterferenceGraph(size_t regType);
+    /// color interference graph only for specified register type
+    /** if target occupancy is set, then colors are limited to registers number that
+     * allows to run target waves. If it is not possible, all registers are used.
+     * If all registers are not enough, then register variables are spilled
+     * (SGPRs to lanes of VGPR, VGPRs to scratch buffer).
+     * If ASM_COALESCE is enabled, then copies are coalesced before coloring.
+     * Coalesced graph is used only if it can be colored without spilling */
+    void colorInterferenceGraph(size_t regType);
+    
+    /// prepare allocation: create code structure, SSA data and livenesses
+    void prepareAllocation(AsmSectionId sectionId);
     void allocateRegisters(AsmSectionId sectionId);
     
+    /// register range of register variable after allocation
+    struct AllocRegRange
+    {
+        size_t offset;  ///< instruction offset
+        cxuint regType; ///< register type
+        cxuint rend;    ///< end of register range (in register type range)
+    };
+    /// set allocated registers in instructions of section (after allocation)
+    /** sets register fields of register variables and returns ranges of allocated
+     * registers and used real registers for every usage.
+     * Errors are printed by the assembler.
+     * \return true if no error */
+    bool applyAllocatedRegisters(AsmSectionId sectionId,
+                std::vector<AllocRegRange>& allocRegRanges);
+    
+    /// get register types number (valid after creating livenesses)
+    size_t getRegTypesNum() const
+    { return regTypesNum; }
+    
+    /// get number of failed linear dependencies (valid after creating livenesses)
+    /** failures are not printed by allocator, because it can run in other thread */
+    size_t getLinearDepsFailures() const
+    { return linearDepsFailures; }
+    
+    /// get target occupancy of section (valid after preparing allocation)
+    cxuint getTargetOccupancy() const
+    { return targetOccupancy; }
+    /// return true if registers of type doesn't fit in target occupancy
+    bool isTargetOccupancyMissed(size_t regType) const
+    { return targetOccupancyMissed[regType]; }
+    /// get loop depths of code blocks (valid after creating code structure)
+    const std::vector<cxuint>& getLoopDepths() const
+    { return loopDepths; }
+    /// get spilled nodes of graph (empty if no spilled register variables)
+    const std::vector<bool>* getSpilledNodes() const
+    { return spilledNodes; }
+    /// get scratch size per lane needed by spilled VGPRs in bytes
+    /** valid after applying allocated registers. Scratch buffer given by
+     * spill_scratch must hold this size for every lane */
+    size_t getSpillScratchSize() const
+    { return spillScratchSize; }
+    /// get spill instructions (valid after applying allocated registers)
+    const std::vector<AsmSpillInstr>& getSpillInstrs() const
+    { return spillInstrs; }
+    /// get copies between register variables (valid after preparing allocation)
+    const std::vector<CopyInstr>* getCopyInstrs() const
+    { return copyInstrs; }
+    /// get representatives of coalesced nodes (empty if no node was coalesced)
+    const std::vector<size_t>* getCoalescedNodes() const
+    { return coalescedNodes; }
+    /// get offsets of copies to same register which should be removed
+    /** valid after applying allocated registers if ASM_COALESCE is enabled */
+    const std::vector<size_t>& getRemovedInstrs() const
+    { return removedInstrs; }
+    
     const std::vector<CodeBlock>& getCodeBlocks() const
     { return codeBlocks; }
     const SSAReplacesMap& getSSAReplacesMap() const
@@ -464,13 +701,66 @@ public:
     const VarIndexMap* getVregIndexMaps() const
     { return vregIndexMaps; }
     
+    const InterGraph* getInterGraphs() const
+    { return interGraphs; }
+    const Array<cxuint>* getGraphColorMaps() const
+    { return graphColorMaps; }
+    
     const std::unordered_map<size_t, VIdxSetEntry>& getVIdxRoutineMap() const
     { return vidxRoutineMap; }
     const std::unordered_map<size_t, VIdxSetEntry>& getVIdxCallMap() const
     { return vidxCallMap; }
 };
 
+/// parallel register allocation driver
+/** allocates registers in many code sections, every section has own AsmRegAllocator.
+ * Code structure, SSA data and livenesses are created in task per section,
+ * graphs are built and colored in task per section and register type.
+ * Results are same as in serial allocation */
+class AsmParallelRegAllocator
+{
+private:
+    Assembler& assembler;
+    cxuint threadsNum;
+    std::vector<AsmSectionId> sectionIds;
+    std::vector<std::unique_ptr<AsmRegAllocator> > regAllocs;
+    size_t failedTask;
+    AsmSectionId failedSectionId;
+    
+    void runTasks(size_t tasksNum, const std::function<void(size_t)>& task);
+public:
+    /// constructor
+    /**
+     * \param assembler assembler
+     * \param threadsNum threads number (0 - number of hardware threads)
+     */
+    explicit AsmParallelRegAllocator(Assembler& assembler, cxuint threadsNum = 0);
+    
+    /// allocate registers in all code sections which have usage handler
+    void allocateRegisters();
+    /// allocate registers in specified sections
+    void allocateRegisters(const std::vector<AsmSectionId>& sectionIds);
+    
+    /// get threads number
+    cxuint getThreadsNum() const
+    { return threadsNum; }
+    /// get processed sections
+    const std::vector<AsmSectionId>& getSectionIds() const
+    { return sectionIds; }
+    /// get register allocator for i-th processed section
+    const AsmRegAllocator& getRegAllocator(size_t i) const
+    { return *regAllocs[i]; }
+    /// get register allocator for i-th processed section
+    AsmRegAllocator& getRegAllocator(size_t i)
+    { return *regAllocs[i]; }
+    /// get section where allocation failed (ASMSECT_NONE if not failed)
+    AsmSectionId getFailedSectionId() const
+    { return failedSectionId; }
+};
+
 /// Assembler Wait scheduler
+struct AsmWaitBlocksData;
+
 class AsmWaitScheduler
 {
 private:
@@ -481,16 +771,112 @@ private:
     const Array<cxuint>* graphColorMaps;
     bool onlyWarnings;
     std::vector<AsmWaitInstr> neededWaitInstrs;
+    // queue states of code blocks and code flow (kept between schedulings)
+    std::unique_ptr<AsmWaitBlocksData> blocksData;
+    size_t processedBlocksNum;
+    std::vector<AsmMovedInstr> movedInstrs;
+    
+    void scheduleBlocks(ISAUsageHandler& usageHandler, ISAWaitHandler& waitHandler,
+                const std::vector<size_t>& changedBlocks);
 public:
     AsmWaitScheduler(const AsmWaitConfig& asmWaitConfig, Assembler& assembler,
             const std::vector<AsmRegAllocator::CodeBlock>& codeBlocks,
             const AsmRegAllocator::VarIndexMap* vregIndexMaps,
             const Array<cxuint>* graphColorMaps, bool onlyWarnings);
+    ~AsmWaitScheduler();
     
+    /// schedule wait instructions in all code blocks
+    /** queue states at start and end of code blocks are kept for rescheduling */
     void schedule(ISAUsageHandler& usageHandler, ISAWaitHandler& waitHandler);
+    /// schedule wait instructions again after changes in code region
+    /** code blocks that overlap region [regionStart, regionEnd) are processed again.
+     * other code blocks are processed only if queue state at their start has been
+     * changed. Code blocks and code flow between them must be same as in previous
+     * scheduling (only their code and usages can be changed).
+     * If no scheduling was done before, then all code blocks are processed */
+    void reschedule(ISAUsageHandler& usageHandler, ISAWaitHandler& waitHandler,
+                size_t regionStart, size_t regionEnd);
+    
+    /// move independent instructions before needed wait instructions
+    /** instructions that follow wait instruction in code block are moved before it
+     * while estimated latency of waited operations (from wait configuration and
+     * instruction timings) is not hidden. Moved instructions must not access registers
+     * of pending operations and must not depend on crossed instructions.
+     * Instructions that contain any of fixed offsets are not moved.
+     * Must be called after scheduling
+     * \param usageHandler usage handler
+     * \param waitHandler wait handler
+     * \param codeSize code size
+     * \param code code of section
+     * \param fixedOffsets sorted offsets (relocations, expressions, removed instructions)
+     */
+    void moveInstrsBeforeWaits(ISAUsageHandler& usageHandler,
+                ISAWaitHandler& waitHandler, size_t codeSize, const cxbyte* code,
+                const std::vector<size_t>& fixedOffsets);
     
     const std::vector<AsmWaitInstr>& getNeededWaitInstrs() const
     { return neededWaitInstrs; }
+    /// get instructions moved before wait instructions (sorted by offset)
+    const std::vector<AsmMovedInstr>& getMovedInstrs() const
+    { return movedInstrs; }
+    /// get number of code blocks processed by last scheduling
+    size_t getProcessedBlocksNum() const
+    { return processedBlocksNum; }
+};
+
+/// static performance estimator for assembled code
+/** estimates execution of single wavefront using instruction timings from
+ * GcnTimings.md. memory latencies (waits for memory operations) are not included */
+class AsmPerfEstimator
+{
+public:
+    /// performance estimation of code block
+    struct BlockPerf
+    {
+        size_t start;   ///< start of block in section
+        size_t end;     ///< end of block in section
+        size_t instrsNum;   ///< number of instructions
+        uint64_t issueCycles;   ///< sum of cycles of instructions
+        uint64_t stallCycles;   ///< cycles of waiting for dependencies and hazards
+        uint64_t cycles;    ///< estimated cycles of block (with overlapping)
+        uint64_t criticalPath;  ///< longest chain of dependent instructions
+    };
+    /// performance estimation of kernel
+    struct KernelPerf
+    {
+        CString name;   ///< kernel name (or section name for code outside kernels)
+        AsmSectionId sectionId; ///< code section
+        std::vector<BlockPerf> blocks;  ///< blocks
+        size_t instrsNum;   ///< number of instructions
+        uint64_t issueCycles;   ///< sum of cycles of instructions
+        uint64_t stallCycles;   ///< cycles of waiting for dependencies and hazards
+        uint64_t cycles;    ///< sum of estimated cycles of blocks
+        uint64_t criticalPath;  ///< longest path in code flow (without loops)
+    };
+private:
+    Assembler& assembler;
+    cxuint dpFactor;
+    std::vector<KernelPerf> kernelPerfs;
+    
+    BlockPerf estimateBlock(const AsmSection& section, size_t start, size_t end,
+                ISAUsageHandler::ReadPos& usagePos);
+public:
+    /// constructor
+    /**
+     * \param assembler assembler (after assembling)
+     * \param dpFactor DPFACTOR (1,2,4,8), if zero then determined from device type
+     */
+    explicit AsmPerfEstimator(Assembler& assembler, cxuint dpFactor = 0);
+    
+    /// estimate performance of all code sections
+    void estimate();
+    
+    /// get kernel performance estimations
+    const std::vector<KernelPerf>& getKernelPerfs() const
+    { return kernelPerfs; }
+    
+    /// write report in human-readable form
+    void writeReport(std::ostream& output) const;
 };
 
 /// type of clause
@@ -534,6 +920,7 @@ private:
     friend class AsmROCmHandler;
     friend class ISAAssembler;
     friend class AsmRegAllocator;
+    friend class AsmParallelRegAllocator;
     friend class AsmWaitScheduler;
     
     friend struct AsmParseUtils; // INTERNAL LOGIC
@@ -556,6 +943,8 @@ private:
     bool resolvingRelocs;
     bool doNotRemoveFromSymbolClones;
     cxuint policyVersion;
+    cxuint targetOccupancy;
+    AsmSpillScratch spillScratch;
     ISAAssembler* isaAssembler;
     std::vector<DefSym> defSyms;
     std::vector<CString> includeDirs;
@@ -573,6 +962,7 @@ private:
     AsmScope* currentScope;
     KernelMap kernelMap;
     std::vector<AsmKernel> kernels;
+    std::vector<AsmKernelOccupancy> kernelOccupancies;
     Flags flags;
     uint64_t macroCount;
     uint64_t localCount; // macro's local count
@@ -591,6 +981,8 @@ private:
     bool endOfAssembly;
     bool sectionDiffsPrepared;
     bool collectSourcePoses; /// collect offset->source positions data
+    // absolute values from code labels (checked after inserting code)
+    std::vector<AsmCodeLabelsDiff> codeLabelsDiffs;
     
     cxuint filenameIndex;
     std::stack<AsmInputFilter*> asmInputFilters;
@@ -780,6 +1172,27 @@ private:
     
     void undefineSymbol(AsmSymbolEntry& symEntry);
     
+    // get source position of instruction at offset (if collected)
+    AsmSourcePos findSourcePosByOffset(AsmSectionId sectionId, size_t offset);
+    // allocate registers and insert wait instructions in code sections
+    void allocateRegsAndInsertWaits();
+    void updateKernelsAllocRegs(AsmSectionId sectionId,
+                const std::vector<AsmRegAllocator::AllocRegRange>& allocRegRanges,
+                size_t spillScratchSize);
+    // compute occupancies of kernels after register allocation
+    void computeKernelOccupancies();
+    /* insert wait and spill instructions, remove instructions at removedInstrs
+     * and move instructions before their targets (before wait instructions) */
+    void insertCode(AsmSectionId sectionId, const std::vector<AsmWaitInstr>& waitInstrs,
+                const std::vector<AsmSpillInstr>& spillInstrs,
+                const std::vector<size_t>& removedInstrs,
+                const std::vector<AsmMovedInstr>& movedInstrs);
+    // get sorted offsets of relocations and expression targets in section
+    void getFixedCodeOffsets(AsmSectionId sectionId, std::vector<size_t>& offsets);
+    // count removed instructions in kernels
+    void countKernelsRemovedInstrs(AsmSectionId sectionId,
+                const std::vector<size_t>& removedInstrs);
+    
 protected:
     /// helper for testing
     bool readLine();
@@ -869,6 +1282,18 @@ public:
     /// set policy version
     void setPolicyVersion(cxuint pv)
     { policyVersion = pv; }
+    /// get default target occupancy (waves per SIMD, 0 - not specified)
+    cxuint getTargetOccupancy() const
+    { return targetOccupancy; }
+    /// set default target occupancy (waves per SIMD, 0 - not specified)
+    void setTargetOccupancy(cxuint waves)
+    { targetOccupancy = waves; }
+    /// get default scratch resources for VGPR spilling
+    const AsmSpillScratch& getSpillScratch() const
+    { return spillScratch; }
+    /// set default scratch resources for VGPR spilling
+    void setSpillScratch(const AsmSpillScratch& scratch)
+    { spillScratch = scratch; }
     /// get flags
     Flags getFlags() const
     { return flags; }
@@ -907,6 +1332,11 @@ public:
     /// get kernels
     const std::vector<AsmKernel>& getKernels() const
     { return kernels; }
+    /// get occupancies of kernels (filled after register allocation)
+    const std::vector<AsmKernelOccupancy>& getKernelOccupancies() const
+    { return kernelOccupancies; }
+    /// write occupancy report of kernels
+    void writeOccupancyReport(std::ostream& os) const;
     /// get regvar map
     const AsmRegVarMap& getRegVarMap() const
     { return globalScope.regVarMap; }
@@ -107,7 +107,10 @@ protected:
     size_t inputSize;   ///< size of input
     const cxbyte* input;    ///< input code
     bool dontPrintLabelsAfterCode;
+    bool instrOutOfCode;    ///< last instruction crosses end of input
     std::vector<size_t> labels; ///< list of local labels
+    /// bitmap of local labels at code words (indexed by word offset)
+    std::vector<uint64_t> labelBitmap;
     std::vector<std::pair<size_t, CString> > namedLabels;   ///< named labels
     std::vector<CString> relSymbols;    ///< symbols used by relocations
     std::vector<std::pair<size_t, Relocation> > relocations;    ///< relocations
@@ -116,6 +119,8 @@ protected:
     /// constructor
     explicit ISADisassembler(Disassembler& disassembler, cxuint outBufSize = 600);
     
+    /// add local label (must be called before disassembly)
+    void addLabel(size_t pos);
     /// write location in the code
     void writeLocation(size_t pos);
     /// write relocation to current place in instruction
@@ -143,6 +148,13 @@ public:
     void setDontPrintLabels(bool after)
     { dontPrintLabelsAfterCode = after; }
     
+    /// returns true if last analyzed instruction crosses end of input
+    bool isInstrOutOfCode() const
+    { return instrOutOfCode; }
+    /// set whether last instruction crosses end of input (for windowed disassembly)
+    void setInstrOutOfCode(bool outOfCode)
+    { instrOutOfCode = outOfCode; }
+    
     /// analyze code before disassemblying
     virtual void analyzeBeforeDisassemble() = 0;
     
@@ -189,13 +201,52 @@ public:
     { return output.flush(); }
 };
 
+/// instruction categories for GCN code statistics
+enum : cxuint
+{
+    GCNSTATS_SALU = 0,  ///< scalar ALU (SOP1, SOP2, SOPK, SOPC, SOPP)
+    GCNSTATS_VALU,      ///< vector ALU (VOP1, VOP2, VOPC, VOP3, VINTRP)
+    GCNSTATS_SMEM,      ///< scalar memory (SMRD, SMEM)
+    GCNSTATS_VMEM,      ///< vector memory (MUBUF, MTBUF, MIMG, FLAT)
+    GCNSTATS_LDS,       ///< local data share (DS)
+    GCNSTATS_EXP,       ///< export (EXP)
+    GCNSTATS_ILLEGAL,   ///< illegal instructions
+    GCNSTATS_CATEGORIES_NUM    ///< number of categories
+};
+
+/// GCN code statistics
+struct GCNCodeStats
+{
+    /// basic block statistics
+    struct Block
+    {
+        size_t offset;  ///< offset of block in code
+        size_t size;    ///< size of block in bytes
+        size_t instrsNum;   ///< number of instructions in block
+    };
+    
+    size_t codeSize;    ///< code size
+    size_t instrsNum;   ///< number of instructions
+    /// number of instructions in categories
+    size_t categoryCounts[GCNSTATS_CATEGORIES_NUM];
+    size_t literalsNum; ///< number of instructions with literal
+    size_t sdwaNum;     ///< number of SDWA instructions
+    size_t dppNum;      ///< number of DPP instructions
+    cxuint sgprsNum;    ///< number of used SGPRs (highest SGPR + 1)
+    cxuint vgprsNum;    ///< number of used VGPRs (highest VGPR + 1)
+    /// instruction counts by encoding (sorted by name)
+    std::vector<std::pair<CString, size_t> > encodingCounts;
+    /// instruction counts by mnemonic (sorted by name)
+    std::vector<std::pair<CString, size_t> > mnemonicCounts;
+    std::vector<Block> blocks;  ///< basic blocks
+};
+
 /// GCN architectur dissassembler
 class GCNDisassembler: public ISADisassembler
 {
 private:
-    bool instrOutOfCode;
-    
     friend struct GCNDisasmUtils; // INTERNAL LOGIC
+    bool statsBlockOpen;    // last block of statistics is not finished
 public:
     /// constructor
     GCNDisassembler(Disassembler& disassembler);
@@ -206,6 +257,13 @@ public:
     void analyzeBeforeDisassemble();
     /// disassemble code
     void disassemble();
+    
+    /// collect code statistics (without disassembling)
+    /** must be called after analyzing (beforeDisassemble)
+     * \param stats output statistics
+     * \param append append statistics of next part of code (for windowed code),
+     * start offset of input must be offset of this part */
+    void collectStats(GCNCodeStats& stats, bool append = false);
 };
 
 /// single kernel input for disassembler
@@ -330,6 +388,7 @@ struct ROCmDisasmInput
     CString target;     ///< LLVM target triple
     size_t metadataSize;    ///< metadata size
     const char* metadata;   ///< metadata
+    bool metadataMsgPack;   ///< metadata in MsgPack format (code object v3)
     Array<std::pair<CString, size_t> > gotSymbols; ///< GOT symbols names
 };
 
@@ -364,6 +423,9 @@ struct RawCodeInput
     GPUDeviceType deviceType;   ///< GPU device type
     size_t codeSize;            ///< code size
     const cxbyte* code;         ///< code
+    /// seekable stream with code (if not null, code is read in windows from stream)
+    std::istream* codeStream;
+    size_t codeWindowSize;  ///< size of window for code stream (0 - default size)
 };
 
 /// disassembler class
@@ -475,11 +537,29 @@ public:
     Disassembler(GPUDeviceType deviceType, size_t rawCodeSize, const cxbyte* rawCode,
                  std::ostream& output, Flags flags = 0);
     
+    /// constructor for raw code read from stream
+    /** code is disassembled in two passes in fixed windows, hence memory usage
+     * does not depend on code size
+     * \param deviceType GPU device type
+     * \param rawCodeStream seekable input stream with raw code
+     * \param output output stream
+     * \param flags flags for disassembler
+     * \param codeWindowSize size of window (multiple of 4, 0 - default size)
+     */
+    Disassembler(GPUDeviceType deviceType, std::istream& rawCodeStream,
+                 std::ostream& output, Flags flags = 0, size_t codeWindowSize = 0);
+    
     ~Disassembler();
     
     /// disassembles input
     void disassemble();
     
+    /// collect code statistics for every kernel (or whole code for raw code)
+    /**
+     * \return list of pairs: kernel name and its code statistics
+     */
+    std::vector<std::pair<CString, GCNCodeStats> > collectCodeStats();
+    
     /// get disassemblers flags
     Flags getFlags() const
     { return flags; }
@@ -510,6 +590,26 @@ public:
     { return output; }
 };
 
+/// write code statistics in JSON format
+extern void writeGCNCodeStatsJSON(std::ostream& output,
+            const std::vector<std::pair<CString, GCNCodeStats> >& stats);
+
+/// write code statistics in CSV format (kernel,group,key,value)
+extern void writeGCNCodeStatsCSV(std::ostream& output,
+            const std::vector<std::pair<CString, GCNCodeStats> >& stats);
+
+/// code statistics of kernels from single file (file name and kernels statistics)
+typedef std::pair<CString, std::vector<std::pair<CString, GCNCodeStats> > >
+        GCNFileCodeStats;
+
+/// write code statistics from many files in JSON format (single array)
+extern void writeGCNCodeStatsJSON(std::ostream& output,
+            const std::vector<GCNFileCodeStats>& filesStats);
+
+/// write code statistics from many files in CSV format (file,kernel,group,key,value)
+extern void writeGCNCodeStatsCSV(std::ostream& output,
+            const std::vector<GCNFileCodeStats>& filesStats);
+
 // routines to get binary config inputs
 
 /// prepare AMD OpenCL input from AMD 32-bit binary
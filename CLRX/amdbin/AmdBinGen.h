@@ -208,6 +208,7 @@ class AmdGPUBinGenerator: public NonCopyableAndNonMovable
 private:
     bool manageable;
     const AmdInput* input;
+    bool mergeStrTables;
     
     void generateInternal(std::ostream* osPtr, std::vector<char>* vPtr,
              Array<cxbyte>* aPtr) const;
@@ -241,6 +242,12 @@ public:
     /// set input
     void setInput(const AmdInput* input);
     
+    /// enable merging string tables (removing duplicates and tail merging)
+    /** Merged string tables are smaller, but binary is not identical
+     * with binary generated by original compiler. */
+    void setMergeStrTables(bool merge)
+    { mergeStrTables = merge; }
+    
     /// generates binary
     void generate(Array<cxbyte>& array) const;
     
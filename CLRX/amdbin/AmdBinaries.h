@@ -58,6 +58,8 @@ enum : Flags {
     AMDBIN_INNER_CREATE_SYMBOLMAP = 0x2000,  ///< create map of symbols for inner binaries
     /** create map of dynamic symbols for inner binaries */
     AMDBIN_INNER_CREATE_DYNSYMMAP = 0x4000,
+    /** create hash indexes of names for inner binaries */
+    AMDBIN_INNER_CREATE_HASHINDEX = 0x8000,
     AMDBIN_INNER_CREATE_CALNOTES = 0x10000, ///< create CAL notes for AMD inner GPU binary
     
     AMDBIN_CREATE_ALL = ELF_CREATE_ALL | 0xffff0, ///< all AMD binaries creation flags
@@ -575,6 +577,13 @@ public:
      */
     AmdMainGPUBinary32(size_t binaryCodeSize, cxbyte* binaryCode,
             Flags creationFlags = AMDBIN_CREATE_ALL);
+    /** constructor (mapped file must be destroyed after this object)
+     * \param file mapped file with binary code
+     * \param creationFlags flags that specified what will be created during creation
+     */
+    explicit AmdMainGPUBinary32(MappedFile& file, Flags creationFlags = AMDBIN_CREATE_ALL)
+            : AmdMainGPUBinary32(file.size(), file.data(), creationFlags)
+    { }
     ~AmdMainGPUBinary32() = default;
     
     // determine GPU device type from this binary
@@ -619,6 +628,13 @@ public:
      */
     AmdMainGPUBinary64(size_t binaryCodeSize, cxbyte* binaryCode,
             Flags creationFlags = AMDBIN_CREATE_ALL);
+    /** constructor (mapped file must be destroyed after this object)
+     * \param file mapped file with binary code
+     * \param creationFlags flags that specified what will be created during creation
+     */
+    explicit AmdMainGPUBinary64(MappedFile& file, Flags creationFlags = AMDBIN_CREATE_ALL)
+            : AmdMainGPUBinary64(file.size(), file.data(), creationFlags)
+    { }
     ~AmdMainGPUBinary64() = default;
     
     // determine GPU device type from this binary
@@ -667,6 +683,13 @@ public:
      */
     AmdMainX86Binary32(size_t binaryCodeSize, cxbyte* binaryCode,
             Flags creationFlags = AMDBIN_CREATE_ALL);
+    /** constructor (mapped file must be destroyed after this object)
+     * \param file mapped file with binary code
+     * \param creationFlags flags that specified what will be created during creation
+     */
+    explicit AmdMainX86Binary32(MappedFile& file, Flags creationFlags = AMDBIN_CREATE_ALL)
+            : AmdMainX86Binary32(file.size(), file.data(), creationFlags)
+    { }
     ~AmdMainX86Binary32() = default;
     
     /// returns true if binary has kernel informations
@@ -712,6 +735,13 @@ public:
      */
     AmdMainX86Binary64(size_t binaryCodeSize, cxbyte* binaryCode,
             Flags creationFlags = AMDBIN_CREATE_ALL);
+    /** constructor (mapped file must be destroyed after this object)
+     * \param file mapped file with binary code
+     * \param creationFlags flags that specified what will be created during creation
+     */
+    explicit AmdMainX86Binary64(MappedFile& file, Flags creationFlags = AMDBIN_CREATE_ALL)
+            : AmdMainX86Binary64(file.size(), file.data(), creationFlags)
+    { }
     ~AmdMainX86Binary64() = default;
     
     /// returns true if binary has kernel informations
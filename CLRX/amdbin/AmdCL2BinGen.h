@@ -155,6 +155,7 @@ class AmdCL2GPUBinGenerator: public NonCopyableAndNonMovable
 private:
     bool manageable;
     const AmdCL2Input* input;
+    bool mergeStrTables;
     
     void generateInternal(std::ostream* osPtr, std::vector<char>* vPtr,
              Array<cxbyte>* aPtr) const;
@@ -196,6 +197,12 @@ public:
     /// set input
     void setInput(const AmdCL2Input* input);
     
+    /// enable merging string tables (removing duplicates and tail merging)
+    /** Merged string tables are smaller, but binary is not identical
+     * with binary generated by original compiler. */
+    void setMergeStrTables(bool merge)
+    { mergeStrTables = merge; }
+    
     /// generates binary
     void generate(Array<cxbyte>& array) const;
     
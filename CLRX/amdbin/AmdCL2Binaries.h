@@ -496,6 +496,10 @@ public:
     /// constructor
     AmdCL2MainGPUBinary32(size_t binaryCodeSize, cxbyte* binaryCode,
             Flags creationFlags = AMDBIN_CREATE_ALL);
+    /// constructor (mapped file must be destroyed after this object)
+    explicit AmdCL2MainGPUBinary32(MappedFile& file, Flags creationFlags = AMDBIN_CREATE_ALL)
+            : AmdCL2MainGPUBinary32(file.size(), file.data(), creationFlags)
+    { }
     /// default destructor
     ~AmdCL2MainGPUBinary32() = default;
     
@@ -532,6 +536,10 @@ public:
     /// constructor
     AmdCL2MainGPUBinary64(size_t binaryCodeSize, cxbyte* binaryCode,
             Flags creationFlags = AMDBIN_CREATE_ALL);
+    /// constructor (mapped file must be destroyed after this object)
+    explicit AmdCL2MainGPUBinary64(MappedFile& file, Flags creationFlags = AMDBIN_CREATE_ALL)
+            : AmdCL2MainGPUBinary64(file.size(), file.data(), creationFlags)
+    { }
     /// default destructor
     ~AmdCL2MainGPUBinary64() = default;
     
@@ -572,6 +580,24 @@ extern AmdCL2MainGPUBinaryBase* createAmdCL2BinaryFromCode(
 /// check whether is Amd OpenCL 2.0 binary
 extern bool isAmdCL2Binary(size_t binarySize, const cxbyte* binary);
 
+/// replace code of kernel in AMD OpenCL 2.0 binary (only new binary format)
+/** If new kernel fits in space of old kernel (to next kernel), then kernel will be
+ * replaced in place. Otherwise, kernel will be moved to end of code section of
+ * inner binary and new binary will be written to output. In both cases binary object
+ * must be recreated to get new kernel data. Kernels that have relocations
+ * can not be replaced.
+ * \param binary AMD OpenCL 2.0 binary
+ * \param kernelName kernel name
+ * \param codeSize size of new kernel code
+ * \param code new kernel code
+ * \param setup new kernel setup, if null then old setup is used
+ * \param output output binary (filled only if kernel has been moved)
+ * \return true if kernel has been replaced in place
+ */
+extern bool patchAmdCL2Kernel(AmdCL2MainGPUBinary64& binary, const char* kernelName,
+            size_t codeSize, const cxbyte* code, const cxbyte* setup,
+            Array<cxbyte>& output);
+
 };
 
 #endif
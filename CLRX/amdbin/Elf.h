@@ -662,6 +662,7 @@ typedef struct
 #define DT_PREINIT_ARRAYSZ 33       /* size in bytes of DT_PREINIT_ARRAY */
 #define DT_NUM      34      /* Number used */
 #define DT_LOOS     0x6000000d  /* Start of OS-specific */
+#define DT_GNU_HASH 0x6ffffef5  /* GNU-style hash table */
 #define DT_HIOS     0x6ffff000  /* End of OS-specific */
 #define DT_LOPROC   0x70000000  /* Start of processor-specific */
 #define DT_HIPROC   0x7fffffff  /* End of processor-specific */
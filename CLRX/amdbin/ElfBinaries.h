@@ -29,6 +29,8 @@
 #include <climits>
 #include <string>
 #include <utility>
+#include <vector>
+#include <memory>
 #include <ostream>
 #include <CLRX/amdbin/Elf.h>
 #include <CLRX/utils/MemAccess.h>
@@ -70,7 +72,10 @@ enum : Flags {
     ELF_CREATE_SECTIONMAP = 1,  ///< create map of sections
     ELF_CREATE_SYMBOLMAP = 2,   ///< create map of symbols
     ELF_CREATE_DYNSYMMAP = 4,   ///< create map of dynamic symbols
-    ELF_CREATE_ALL = 0xf  ///< creation flags for ELF binaries
+    ELF_CREATE_HASHINDEX = 8,   ///< create hash indexes of section and symbol names
+    ELF_CREATE_ALL = 0xf,  ///< creation flags for ELF binaries
+    /// create maps and hash indexes on first use (binary is checked at construction)
+    ELF_CREATE_LAZY = 0x80000000U
 };
 
 /// Bin exception class
@@ -162,9 +167,37 @@ protected:
     cxbyte* dynSymTable;          ///< pointer to dynamic symbol table
     cxbyte* noteTable;            ///< pointer to note table
     cxbyte* dynamicTable;         ///< pointer to dynamic table
-    SectionIndexMap sectionIndexMap;    ///< section's index map
-    SymbolIndexMap symbolIndexMap;      ///< symbol's index map
-    SymbolIndexMap dynSymIndexMap;      ///< dynamic symbol's index map
+    mutable SectionIndexMap sectionIndexMap;    ///< section's index map
+    mutable SymbolIndexMap symbolIndexMap;      ///< symbol's index map
+    mutable SymbolIndexMap dynSymIndexMap;      ///< dynamic symbol's index map
+    mutable Array<uint32_t> sectionHashTable;   ///< hash table of section names
+    mutable Array<uint32_t> symbolHashTable;    ///< hash table of symbol names
+    mutable Array<uint32_t> dynSymHashTable;    ///< hash table of dynamic symbol names
+    /// ELF hash section (.hash) of symbols
+    mutable const uint32_t* symbolElfHash;
+    /// ELF hash section (.hash) of dynamic symbols
+    mutable const uint32_t* dynSymElfHash;
+    /// GNU hash section (.gnu.hash) of dynamic symbols
+    mutable const uint32_t* dynSymGnuHash;
+    /// once flags for indexes in lazy mode (copy gets new flags and creates indexes again)
+    struct IndexOnceFlags
+    {
+        std::unique_ptr<OnceFlag[]> flags;  ///< sections, symbols, dynamic symbols
+        
+        IndexOnceFlags()
+        { }
+        IndexOnceFlags(const IndexOnceFlags& b)
+                : flags(b.flags ? new OnceFlag[3] : nullptr)
+        { }
+        IndexOnceFlags& operator=(const IndexOnceFlags& b)
+        {
+            flags.reset(b.flags ? new OnceFlag[3] : nullptr);
+            return *this;
+        }
+    };
+    IndexOnceFlags indexOnceFlags;  ///< once flags for lazy creation of indexes
+    uint16_t symTableIndex; ///< section index of symbol table
+    uint16_t dynSymTableIndex; ///< section index of dynamic symbol table
     
     typename Types::Size symbolsNum;    ///< symbols number
     typename Types::Size dynSymbolsNum; ///< dynamic symbols number
@@ -174,6 +207,35 @@ protected:
     uint16_t dynSymEntSize; ///< dynamic symbol entry size in a dynamic symbol's table
     typename Types::Size dynamicEntSize; ///< get dynamic entry size
     
+    /// check section names, create section map and hash index (if not onlyCheck)
+    void createSectionIndex(bool onlyCheck) const;
+    /// check symbol names, create (dynamic) symbol map and hash index (if not onlyCheck)
+    void createSymbolIndex(bool dynamic, bool onlyCheck) const;
+    /// find valid .hash or .gnu.hash section for symbol table
+    const uint32_t* findElfHashSection(uint16_t symTabIndex, size_t entriesNum,
+                uint32_t type) const;
+    
+    /// create section index at first use (in lazy mode)
+    void ensureSectionIndex() const
+    {
+        if (indexOnceFlags.flags)
+            callOnce(indexOnceFlags.flags[0], &ElfBinaryTemplate::createSectionIndex,
+                        this, false);
+    }
+    /// create symbol index at first use (in lazy mode)
+    void ensureSymbolIndex() const
+    {
+        if (indexOnceFlags.flags)
+            callOnce(indexOnceFlags.flags[1], &ElfBinaryTemplate::createSymbolIndex,
+                        this, false, false);
+    }
+    /// create dynamic symbol index at first use (in lazy mode)
+    void ensureDynSymbolIndex() const
+    {
+        if (indexOnceFlags.flags)
+            callOnce(indexOnceFlags.flags[2], &ElfBinaryTemplate::createSymbolIndex,
+                        this, true, false);
+    }
 public:
     ElfBinaryTemplate();
     /** constructor.
@@ -183,6 +245,13 @@ public:
      */
     ElfBinaryTemplate(size_t binaryCodeSize, cxbyte* binaryCode,
                 Flags creationFlags = ELF_CREATE_ALL);
+    /** constructor (mapped file must be destroyed after this object)
+     * \param file mapped file with binary code
+     * \param creationFlags flags that specified what will be created during creation
+     */
+    explicit ElfBinaryTemplate(MappedFile& file, Flags creationFlags = ELF_CREATE_ALL)
+            : ElfBinaryTemplate(file.size(), file.data(), creationFlags)
+    { }
     virtual ~ElfBinaryTemplate();
     
     /// get creation flags
@@ -201,6 +270,14 @@ public:
     bool hasDynSymbolMap() const
     { return (creationFlags & ELF_CREATE_DYNSYMMAP) != 0; }
     
+    /// returns true if object has hash indexes of section and symbol names
+    bool hasHashIndex() const
+    { return (creationFlags & ELF_CREATE_HASHINDEX) != 0; }
+    
+    /// returns true if object is lazy view (maps and indexes created at first use)
+    bool isLazy() const
+    { return (creationFlags & ELF_CREATE_LAZY) != 0; }
+    
     /// get size of binaries
     size_t getSize() const
     { return binaryCodeSize; }
@@ -327,11 +404,15 @@ public:
     
     /// get end iterator if section index map
     SectionIndexMap::const_iterator getSectionIterEnd() const
-    { return sectionIndexMap.end(); }
+    {
+        ensureSectionIndex();
+        return sectionIndexMap.end();
+    }
     
     /// get section iterator with specified name (requires section index map)
     SectionIndexMap::const_iterator getSectionIter(const char* name) const
     {
+        ensureSectionIndex();
         SectionIndexMap::const_iterator it = binaryMapFind(
                     sectionIndexMap.begin(), sectionIndexMap.end(), name, CStringLess());
         if (it == sectionIndexMap.end())
@@ -342,23 +423,43 @@ public:
     /// get section index with specified name
     uint16_t getSectionIndex(const char* name) const;
     
-    /// get symbol index with specified name (requires symbol index map)
+    /// get symbol index with specified name
     typename Types::Size getSymbolIndex(const char* name) const;
     
-    /// get dynamic symbol index with specified name (requires dynamic symbol index map)
+    /// get dynamic symbol index with specified name
     typename Types::Size getDynSymbolIndex(const char* name) const;
     
+    /// find section index with specified name, returns SHN_UNDEF if not found
+    /** uses hash index or section map if created, otherwise scans section headers */
+    uint16_t findSectionIndex(const char* name) const;
+    
+    /// find symbol index with specified name, returns STN_UNDEF if not found
+    /** uses hash index or symbol map if created, otherwise scans symbol table */
+    typename Types::Size findSymbolIndex(const char* name) const;
+    
+    /// find dynamic symbol index with specified name, returns STN_UNDEF if not found
+    /** uses ELF hash section (.hash or .gnu.hash) or hash index or dynamic symbol map
+     * if they exist, otherwise scans dynamic symbol table */
+    typename Types::Size findDynSymbolIndex(const char* name) const;
+    
     /// get end iterator of symbol index map
     SymbolIndexMap::const_iterator getSymbolIterEnd() const
-    { return symbolIndexMap.end(); }
+    {
+        ensureSymbolIndex();
+        return symbolIndexMap.end();
+    }
     
     /// get end iterator of dynamic symbol index map
     SymbolIndexMap::const_iterator getDynSymbolIterEnd() const
-    { return dynSymIndexMap.end(); }
+    {
+        ensureDynSymbolIndex();
+        return dynSymIndexMap.end();
+    }
     
     /// get symbol iterator with specified name (requires symbol index map)
     SymbolIndexMap::const_iterator getSymbolIter(const char* name) const
     {
+        ensureSymbolIndex();
         SymbolIndexMap::const_iterator it = binaryMapFind(
                     symbolIndexMap.begin(), symbolIndexMap.end(), name, CStringLess());
         if (it == symbolIndexMap.end())
@@ -369,6 +470,7 @@ public:
     /// get dynamic symbol iterator with specified name (requires dynamic symbol index map)
     SymbolIndexMap::const_iterator getDynSymbolIter(const char* name) const
     {
+        ensureDynSymbolIndex();
         SymbolIndexMap::const_iterator it = binaryMapFind(
                     dynSymIndexMap.begin(), dynSymIndexMap.end(), name, CStringLess());
         if (it == dynSymIndexMap.end())
@@ -384,19 +486,19 @@ public:
     typename Types::Shdr& getSectionHeader(const char* name)
     { return getSectionHeader(getSectionIndex(name)); }
     
-    /// get symbol with specified name (requires symbol index map)
+    /// get symbol with specified name
     const typename Types::Sym& getSymbol(const char* name) const
     { return getSymbol(getSymbolIndex(name)); }
     
-    /// get symbol with specified name (requires symbol index map)
+    /// get symbol with specified name
     typename Types::Sym& getSymbol(const char* name)
     { return getSymbol(getSymbolIndex(name)); }
     
-    /// get dynamic symbol with specified name (requires dynamic symbol index map)
+    /// get dynamic symbol with specified name
     const typename Types::Sym& getDynSymbol(const char* name) const
     { return getDynSymbol(getDynSymbolIndex(name)); }
     
-    /// get dynamic symbol with specified name (requires dynamic symbol index map)
+    /// get dynamic symbol with specified name
     typename Types::Sym& getDynSymbol(const char* name)
     { return getDynSymbol(getDynSymbolIndex(name)); }
     
@@ -482,6 +584,42 @@ typedef class ElfBinaryTemplate<Elf32Types> ElfBinary32;
 /// type for 64-bit ELF binary
 typedef class ElfBinaryTemplate<Elf64Types> ElfBinary64;
 
+/// grow section in ELF binary and write new binary to output
+/** Content after section is moved only if new section content does not fit in
+ * a free space after section, and then only file offsets in headers are updated.
+ * Addresses are never changed, hence loaded section must fit in free address space
+ * after it (otherwise exception is thrown). Content of the new part of section
+ * is zeroed.
+ * \param elfBin ELF binary
+ * \param sectionIndex index of section
+ * \param newSize new size of section (must not be smaller than old size)
+ * \param output output binary
+ */
+template<typename Types>
+void growElfSection(const ElfBinaryTemplate<Types>& elfBin, uint16_t sectionIndex,
+            typename Types::Word newSize, Array<cxbyte>& output);
+
+/// replace content of region in section of ELF binary
+/** If content fits in region space, then it will be written in place
+ * (rest of region will be zeroed) and sizes of symbols that pointing to region
+ * will be updated. Otherwise, region will be moved to end of section (section will
+ * be grown by growElfSection) and values and sizes of symbols will be updated.
+ * \param elfBin ELF binary
+ * \param sectionIndex index of section
+ * \param regionOffset region offset (relative to section)
+ * \param regionSize old region size
+ * \param regionSpace space available for region (to next region or end of section)
+ * \param contentSize new content size
+ * \param content new content
+ * \param output output binary (filled only if region is moved)
+ * \return true if content has been written in place
+ */
+template<typename Types>
+bool patchElfSectionRegion(ElfBinaryTemplate<Types>& elfBin, uint16_t sectionIndex,
+            typename Types::Word regionOffset, typename Types::Word regionSize,
+            typename Types::Word regionSpace, size_t contentSize, const cxbyte* content,
+            Array<cxbyte>& output);
+
 /// type of Elf region
 enum class ElfRegionType: cxbyte
 {
@@ -721,6 +859,12 @@ struct ElfRegionTemplate
     { return ElfRegionTemplate(0, (const cxbyte*)nullptr, sizeof(typename Types::Word),
                 ".hash", SHT_HASH, SHF_ALLOC, link); }
     
+    /// get GNU hash section
+    /** dynamic symbols will be sorted by hash buckets */
+    static ElfRegionTemplate gnuHashSection(uint16_t link)
+    { return ElfRegionTemplate(0, (const cxbyte*)nullptr, sizeof(typename Types::Word),
+                ".gnu.hash", SHT_GNU_HASH, SHF_ALLOC, link); }
+    
     /// get note section
     static ElfRegionTemplate noteSection()
     { return ElfRegionTemplate(0, (const cxbyte*)nullptr, 4, ".note", SHT_NOTE, 0); }
@@ -817,6 +961,47 @@ typedef ElfSymbolTemplate<Elf32Types> ElfSymbol32;
 /// 64-bit elf symbol
 typedef ElfSymbolTemplate<Elf64Types> ElfSymbol64;
 
+/// ELF string table builder
+/** Builder removes duplicated strings and merges strings that are suffixes
+ * of other strings (tail merging). Strings are not copied, so they must be
+ * available until build.
+ */
+class ElfStrTabBuilder
+{
+private:
+    bool addNull;
+    std::vector<const char*> strings;
+    std::unique_ptr<uint32_t[]> offsets;
+    std::vector<char> table;
+public:
+    /// constructor
+    /**
+     * \param addNull if true then put null string at the beginning of table
+     */
+    explicit ElfStrTabBuilder(bool addNull = true);
+
+    /// clear strings and table
+    void clear(bool addNull);
+    /// add string (null or empty string refers to empty string), returns its index
+    size_t add(const char* str)
+    {
+        strings.push_back(str);
+        return strings.size()-1;
+    }
+    /// build string table
+    void build();
+
+    /// get offset of added string in table
+    uint32_t getOffset(size_t index) const
+    { return offsets[index]; }
+    /// get table size
+    size_t getSize() const
+    { return table.size(); }
+    /// get table content
+    const char* getTable() const
+    { return table.data(); }
+};
+
 /// ELF binary generator
 template<typename Types>
 class ElfBinaryGenTemplate
@@ -844,8 +1029,25 @@ private:
     uint32_t bucketsNum;
     std::unique_ptr<uint32_t[]> hashCodes;
     bool isHashDynSym;
-    
+    uint32_t gnuBucketsNum;
+    uint32_t gnuSymOffset;
+    uint32_t gnuBloomSize;
+    std::unique_ptr<uint32_t[]> gnuHashCodes;
+    std::unique_ptr<uint32_t[]> dynSymOutIndices;
+    size_t nullSymNameOffset;
+    size_t nullDynSymNameOffset;
+    size_t nullSectionNameOffset;
+    bool mergeStrTables;
+    ElfStrTabBuilder strTabBuilder;
+    ElfStrTabBuilder dynStrBuilder;
+    ElfStrTabBuilder shStrTabBuilder;
+    
+    void prepareGnuHash();
+    void buildStrTables();
     void computeSize();
+    void generateGnuHash(FastOutputBuffer& fob) const;
+    void generateHeader(FastOutputBuffer& fob) const;
+    void generateRegion(FastOutputBuffer& fob, size_t regionIndex) const;
 public:
     ElfBinaryGenTemplate();
     /// construcrtor
@@ -864,6 +1066,12 @@ public:
     void setHeader(const ElfHeaderTemplate<Types>& header)
     { this->header = header; }
     
+    /// enable merging string tables (removing duplicates and tail merging)
+    /** If enabled then .strtab, .dynstr and .shstrtab are built by ElfStrTabBuilder.
+     * Otherwise names are stored in order of symbols and sections. */
+    void setMergeStrTables(bool merge)
+    { mergeStrTables = merge; }
+    
     /// add new region (section, user region or shdr/phdr table
     void addRegion(const ElfRegionTemplate<Types>& region);
     /// add new program header
@@ -898,6 +1106,13 @@ public:
     typename Types::Word getRegionOffset(cxuint i) const
     { return regionOffsets[i]; }
     
+    /// return index of dynamic symbol in output (dynamic symbols can be sorted)
+    /**
+     * \param i index of added dynamic symbol
+     */
+    size_t getDynSymbolOutIndex(size_t i) const
+    { return dynSymOutIndices ? dynSymOutIndices[i] : i + addNullDynSym; }
+    
     /// generate binary
     void generate(FastOutputBuffer& fob);
     
@@ -908,6 +1123,14 @@ public:
         generate(fob);
     }
     
+    /// generate binary to memory region, regions are written in parallel
+    /** Memory region must have countSize() bytes. Regions are written
+     * by separate threads, so content generators of regions must be thread-safe.
+     * \param output output memory region
+     * \param threadsNum threads number (0 - number of hardware threads)
+     */
+    void generate(cxbyte* output, cxuint threadsNum);
+    
     static typename Types::Word getRelInfo(size_t symbolIndex, uint32_t rtype);
 };
 
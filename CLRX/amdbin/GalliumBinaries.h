@@ -48,6 +48,8 @@ enum : Flags {
     GALLIUM_INNER_CREATE_SYMBOLMAP = 0x20,  ///< create map of kernels for inner binaries
     /** create map of dynamic kernels for inner binaries */
     GALLIUM_INNER_CREATE_DYNSYMMAP = 0x40,
+    /** create hash indexes of names for inner binaries */
+    GALLIUM_INNER_CREATE_HASHINDEX = 0x80,
     GALLIUM_INNER_CREATE_PROGINFOMAP = 0x100, ///< create prinfomap for inner binaries
     
     GALLIUM_ELF_CREATE_PROGINFOMAP = 0x10,  ///< create elf proginfomap
@@ -309,6 +311,10 @@ private:
 public:
     /// constructor
     GalliumBinary(size_t binaryCodeSize, cxbyte* binaryCode, Flags creationFlags);
+    /// constructor (mapped file must be destroyed after this object)
+    explicit GalliumBinary(MappedFile& file, Flags creationFlags)
+            : GalliumBinary(file.size(), file.data(), creationFlags)
+    { }
     /// destructor
     ~GalliumBinary() = default;
     
@@ -467,6 +473,7 @@ class GalliumBinGenerator: public NonCopyableAndNonMovable
 private:
     bool manageable;
     const GalliumInput* input;
+    bool mergeStrTables;
     
     void generateInternal(std::ostream* osPtr, std::vector<char>* vPtr,
              Array<cxbyte>* aPtr) const;
@@ -501,6 +508,12 @@ public:
     /// set input
     void setInput(const GalliumInput* input);
     
+    /// enable merging string tables (removing duplicates and tail merging)
+    /** Merged string tables are smaller, but binary is not identical
+     * with binary generated by original compiler. */
+    void setMergeStrTables(bool merge)
+    { mergeStrTables = merge; }
+    
     /// generates binary to array of bytes
     void generate(Array<cxbyte>& array) const;
     
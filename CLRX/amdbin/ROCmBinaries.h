@@ -192,6 +192,8 @@ struct ROCmMetadata
     void initialize();
     /// parse metadata info from metadata string
     void parse(size_t metadataSize, const char* metadata);
+    /// parse metadata info from MsgPack metadata (code object v3)
+    void parseMsgPack(size_t metadataSize, const cxbyte* metadata);
 };
 
 /// ROCm main binary for GPU for 64-bit mode
@@ -214,6 +216,7 @@ private:
     CString target;
     size_t metadataSize;
     char* metadata;
+    bool metadataMsgPack;
     std::unique_ptr<ROCmMetadata> metadataInfo;
     RegionMap kernelInfosMap;
     Array<size_t> gotSymbols;
@@ -222,6 +225,10 @@ public:
     /// constructor
     ROCmBinary(size_t binaryCodeSize, cxbyte* binaryCode,
             Flags creationFlags = ROCMBIN_CREATE_ALL);
+    /// constructor (mapped file must be destroyed after this object)
+    explicit ROCmBinary(MappedFile& file, Flags creationFlags = ROCMBIN_CREATE_ALL)
+            : ROCmBinary(file.size(), file.data(), creationFlags)
+    { }
     /// default destructor
     ~ROCmBinary() = default;
     
@@ -271,6 +278,10 @@ public:
     char* getMetadata()
     { return metadata; }
     
+    /// return true if metadata is in MsgPack format (code object v3)
+    bool isMetadataMsgPack() const
+    { return metadataMsgPack; }
+    
     /// has metadata info
     bool hasMetadataInfo() const
     { return metadataInfo!=nullptr; }
@@ -345,6 +356,25 @@ typedef AmdHsaKernelConfig ROCmKernelConfig;
 /// check whether is Amd OpenCL 2.0 binary
 extern bool isROCmBinary(size_t binarySize, const cxbyte* binary);
 
+/// replace code of kernel in ROCm binary
+/** If new kernel fits in space of old kernel (to next region), then kernel will be
+ * replaced in place. Otherwise, kernel will be moved to end of code section and
+ * new binary will be written to output. In both cases binary object must be recreated
+ * to get new regions. Code must not refer to code outside kernel by relative offsets.
+ * Kernels that have relocations can not be replaced. Moved kernel must fit in
+ * free address space after code section (addresses of other sections are not changed).
+ * \param binary ROCm binary
+ * \param kernelName kernel name
+ * \param codeSize size of new kernel code
+ * \param code new kernel code
+ * \param setup new kernel setup (kernel descriptor), if null then old setup is used
+ * \param output output binary (filled only if kernel has been moved)
+ * \return true if kernel has been replaced in place
+ */
+extern bool patchROCmKernel(ROCmBinary& binary, const char* kernelName,
+            size_t codeSize, const cxbyte* code, const cxbyte* setup,
+            Array<cxbyte>& output);
+
 /*
  * ROCm Binary Generator
  */
@@ -388,6 +418,7 @@ struct ROCmInput
     size_t metadataSize;    ///< metadata size
     const char* metadata;   ///< metadata
     bool useMetadataInfo;   ///< use metadatainfo instead same metadata
+    bool metadataMsgPack;   ///< metadata in MsgPack format (code object v3)
     ROCmMetadata metadataInfo; ///< metadata info
     
     /// list of indices of symbols to GOT section
@@ -410,6 +441,7 @@ private:
     private:
     bool manageable;
     const ROCmInput* input;
+    bool mergeStrTables;
     std::unique_ptr<ElfBinaryGen64> elfBinGen64;
     size_t binarySize;
     size_t commentSize;
@@ -425,7 +457,7 @@ private:
     void* rocmRelaDynGen;
     
     void generateInternal(std::ostream* osPtr, std::vector<char>* vPtr,
-             Array<cxbyte>* aPtr);
+             Array<cxbyte>* aPtr, cxuint threadsNum = 1);
 public:
     /// constructor
     ROCmBinGenerator();
@@ -461,6 +493,12 @@ public:
     /// set input
     void setInput(const ROCmInput* input);
     
+    /// enable merging string tables (removing duplicates and tail merging)
+    /** Merged string tables are smaller, but binary is not identical
+     * with binary generated by original compiler. */
+    void setMergeStrTables(bool merge)
+    { mergeStrTables = merge; }
+    
     /// prepare binary generator (for section diffs)
     void prepareBinaryGen();
     /// get section offset (from main section)
@@ -473,6 +511,13 @@ public:
     /// generates binary to array of bytes
     void generate(Array<cxbyte>& array);
     
+    /// generates binary to array of bytes, regions are written in parallel
+    /**
+     * \param array output array
+     * \param threadsNum threads number (0 - number of hardware threads)
+     */
+    void generate(Array<cxbyte>& array, cxuint threadsNum);
+    
     /// generates binary to output stream
     void generate(std::ostream& os);
     
@@ -199,6 +199,22 @@ extern size_t getGPUMaxGDSSize(GPUArchitecture architecture);
 extern cxuint getGPUExtraRegsNum(GPUArchitecture architecture, cxuint regType,
               Flags flags);
 
+enum: cxuint {
+    GPU_MAX_WAVES_PER_SIMD = 10 ///< maximal number of waves per SIMD
+};
+
+/// get maximum registers number (with extra registers) to run waves per SIMD
+extern cxuint getGPUMaxRegsNumForWaves(GPUArchitecture architecture, cxuint regType,
+              cxuint wavesNum);
+
+/// get number of waves per SIMD for registers number (with extra registers)
+extern cxuint getGPUWavesNumForRegs(GPUArchitecture architecture, cxuint regType,
+              cxuint regsNum);
+
+/// get number of waves per SIMD for local size used by work group
+extern cxuint getGPUWavesNumForLocalSize(GPUArchitecture architecture, size_t localSize,
+              cxuint workGroupSize);
+
 /// structure helper for AMDGPU architecture version
 struct AMDGPUArchVersion
 {
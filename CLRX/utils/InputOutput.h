@@ -347,38 +347,63 @@ public:
 };
 
 /// fast and direct output buffer
+/** Output buffer writes to output stream through internal buffer or directly
+ * to memory (if memory region has been given). In the second case,
+ * memory region must have enough space for all written data.
+ */
 class FastOutputBuffer: public NonCopyableAndNonMovable
 {
 private:
-    std::ostream& os;
-    cxuint endPos;
-    cxuint bufSize;
-    std::unique_ptr<char[]> buffer;
+    std::ostream* os;
+    size_t endPos;
+    size_t bufSize;
+    std::unique_ptr<char[]> bufHolder;
+    char* buffer;
     uint64_t written;
+    
+    // make free space in buffer
+    void flushForSpace()
+    {
+        if (os == nullptr)
+            throw Exception("Output memory region is too small");
+        flush();
+    }
 public:
     /// constructor with inBufSize and output
     /**
      * \param _bufSize max buffer size
      * \param output output stream
      */
-    FastOutputBuffer(cxuint _bufSize, std::ostream& output) : os(output), endPos(0),
-            bufSize(_bufSize), buffer(new char[_bufSize]), written(0)
+    FastOutputBuffer(cxuint _bufSize, std::ostream& output) : os(&output), endPos(0),
+            bufSize(_bufSize), bufHolder(new char[_bufSize]), buffer(bufHolder.get()),
+            written(0)
+    { }
+    /// constructor with output memory region
+    /**
+     * \param outSize size of memory region
+     * \param output memory region
+     */
+    FastOutputBuffer(size_t outSize, char* output) : os(nullptr), endPos(0),
+            bufSize(outSize), buffer(output), written(0)
     { }
     /// destructor
     ~FastOutputBuffer()
     { 
         flush();
-        os.flush();
+        if (os != nullptr)
+            os->flush();
     }
     
     /// get written bytes number
     uint64_t getWritten() const
     { return written; }
     
-    /// write output buffer
+    /// write output buffer (does nothing if output is memory region)
     void flush()
     {
-        os.write(buffer.get(), endPos);
+        if (os == nullptr)
+            return;
+        os->write(buffer, endPos);
         endPos = 0;
     }
     
@@ -386,8 +411,8 @@ public:
     char* reserve(cxuint toReserve)
     {
         if (toReserve > bufSize-endPos)
-            flush();
-        return buffer.get() + endPos;
+            flushForSpace();
+        return buffer + endPos;
     }
     
     /// finish reservation and go forward
@@ -402,12 +427,12 @@ public:
     {
         if (length > bufSize-endPos)
         {
-            flush();
-            os.write(string, length);
+            flushForSpace();
+            os->write(string, length);
         }
         else
         {
-            ::memcpy(buffer.get()+endPos, string, length);
+            ::memcpy(buffer+endPos, string, length);
             endPos += length;
         }
         written += length;
@@ -431,7 +456,7 @@ public:
     void put(char c)
     {
         if (endPos == bufSize)
-            flush();
+            flushForSpace();
         buffer[endPos++] = c;
         written++;
     }
@@ -442,22 +467,26 @@ public:
         size_t count = num;
         while (count != 0)
         {
-             size_t bufNum = std::min(size_t(bufSize-endPos), count);
-             ::memset(buffer.get()+endPos, c, bufNum);
+             if (endPos == bufSize)
+                 flushForSpace();
+             size_t bufNum = std::min(bufSize-endPos, count);
+             ::memset(buffer+endPos, c, bufNum);
              count -= bufNum;
              endPos += bufNum;
-             if (endPos == bufSize)
-                 flush();
         }
         written += num;
     }
     
+    /// returns true if output is memory region (not output stream)
+    bool isMemoryOutput() const
+    { return os == nullptr; }
+    
     /// get output stream
     const std::ostream& getOStream() const
-    { return os; }
+    { return *os; }
     /// get output stream
     std::ostream& getOStream()
-    { return os; }
+    { return *os; }
 };
 
 };
@@ -32,6 +32,7 @@
 #include <cstdint>
 #include <mutex>
 #include <atomic>
+#include <functional>
 #ifdef _MSC_VER
 #include <intrin.h>
 #endif
@@ -778,6 +779,54 @@ extern bool isFileExists(const char* path);
  */
 extern Array<cxbyte> loadDataFromFile(const char* filename);
 
+enum: Flags {
+    MAPFILE_COPYONWRITE = 1 ///< writable private mapping (changes are not stored to file)
+};
+
+/// memory-mapped file
+/** Regular files are mapped into memory (pages are read on first access).
+ * Other files (pipes, devices, empty files) and files on systems without
+ * memory-mapping are loaded by loadDataFromFile.
+ * Content can be modified only if MAPFILE_COPYONWRITE has been given or
+ * if file has been loaded. Object that uses content (for example binary)
+ * must be destroyed before this object.
+ */
+class MappedFile: public NonCopyableAndNonMovable
+{
+private:
+    size_t fileSize;
+    cxbyte* content;
+    bool mapped;
+    bool writable;
+    Array<cxbyte> loadedContent;   // content if file is not mapped
+public:
+    /// empty constructor
+    MappedFile();
+    /** constructor - maps file
+     * \param filename filename
+     * \param flags mapping flags (MAPFILE_COPYONWRITE)
+     */
+    explicit MappedFile(const char* filename, Flags flags = 0);
+    /// destructor
+    ~MappedFile();
+    
+    /// get size of file content
+    size_t size() const
+    { return fileSize; }
+    /// get file content
+    const cxbyte* data() const
+    { return content; }
+    /// get file content (modify only if content is writable)
+    cxbyte* data()
+    { return content; }
+    /// returns true if file is mapped (otherwise is loaded)
+    bool isMapped() const
+    { return mapped; }
+    /// returns true if content can be modified
+    bool isWritable() const
+    { return writable; }
+};
+
 /// convert to filesystem from unified path (with slashes)
 extern void filesystemPath(char* path);
 /// convert to filesystem from unified path (with slashes)
@@ -1047,18 +1096,30 @@ template<class Callable, class... Args>
 inline void callOnce(std::once_flag& flag, Callable&& f, Args&&... args)
 { std::call_once(flag, f, args...); }
 #else
-struct OnceFlag: std::atomic<int>
+/// Once flag type (done flag and mutex for waiting for initialization)
+struct OnceFlag
 {
+    std::atomic<bool> done; ///< true if callable was called successfully
+    std::mutex mutex;   ///< mutex held while calling callable
     // force zero initialization
-    OnceFlag(): std::atomic<int>(0)
+    OnceFlag(): done(false)
     { }
 };
 
+/// callOnce - portable replacement of std::call_once
+/** other threads wait until callable finishes. if callable throws exception,
+ * then next call of callOnce calls callable again */
 template<class Callable, class... Args>
 inline void callOnce(OnceFlag& flag, Callable&& f, Args&&... args)
 {
-    if (flag.exchange(1) == 0)
-        f(args...);
+    if (flag.done.load(std::memory_order_acquire))
+        return;
+    std::lock_guard<std::mutex> lock(flag.mutex);
+    if (!flag.done.load(std::memory_order_relaxed))
+    {
+        std::bind(std::forward<Callable>(f), std::forward<Args>(args)...)();
+        flag.done.store(true, std::memory_order_release);
+    }
 }
 #endif
 
@@ -204,6 +204,38 @@ void AsmAmdCL2Handler::saveCurrentAllocRegs()
     }
 }
 
+void AsmAmdCL2Handler::updateKernelAllocRegs(AsmKernelId kernelId, const cxuint* regs)
+{
+    if (hsaLayout)
+    {
+        AsmKcodeHandler::updateKernelAllocRegs(kernelId, regs);
+        return;
+    }
+    if (assembler.isaAssembler == nullptr)
+        return;
+    // registers of current kernel are held by ISA assembler
+    saveCurrentAllocRegs();
+    size_t regTypesNum;
+    cxuint maxRegs[MAX_REGTYPES_NUM];
+    assembler.isaAssembler->getMaxRegistersNum(regTypesNum, maxRegs);
+    cxuint* allocRegs = kernelStates[kernelId]->allocRegs;
+    for (size_t i = 0; i < regTypesNum; i++)
+        allocRegs[i] = std::max(allocRegs[i], regs[i]);
+    restoreCurrentAllocRegs();
+}
+
+size_t AsmAmdCL2Handler::getKernelLocalSize(AsmKernelId kernelId) const
+{
+    const Kernel& kernel = *kernelStates[kernelId];
+    if (kernel.useHsaConfig && kernel.hsaConfig != nullptr)
+    {
+        const uint32_t localSize = kernel.hsaConfig->workgroupGroupSegmentSize;
+        return (localSize != BINGEN_DEFAULT) ? localSize : 0;
+    }
+    const AmdCL2KernelInput& kernelInput = output.kernels[kernelId];
+    return kernelInput.useConfig ? kernelInput.config.localSize : 0;
+}
+
 AsmKernelId AsmAmdCL2Handler::addKernel(const char* kernelName)
 {
     AsmKernelId thisKernel = output.kernels.size();
@@ -2359,11 +2391,13 @@ bool AsmAmdCL2Handler::resolveRelocation(const AsmExpression* expr, uint64_t& ou
 void AsmAmdCL2Handler::writeBinary(std::ostream& os) const
 {
     AmdCL2GPUBinGenerator binGenerator(&output);
+    binGenerator.setMergeStrTables((assembler.getFlags() & ASM_MERGESTRTABS) != 0);
     binGenerator.generate(os);
 }
 
 void AsmAmdCL2Handler::writeBinary(Array<cxbyte>& array) const
 {
     AmdCL2GPUBinGenerator binGenerator(&output);
+    binGenerator.setMergeStrTables((assembler.getFlags() & ASM_MERGESTRTABS) != 0);
     binGenerator.generate(array);
 }
@@ -138,6 +138,27 @@ void AsmAmdHandler::saveCurrentAllocRegs()
     }
 }
 
+void AsmAmdHandler::updateKernelAllocRegs(AsmKernelId kernelId, const cxuint* regs)
+{
+    if (assembler.isaAssembler == nullptr)
+        return;
+    // registers of current kernel are held by ISA assembler
+    saveCurrentAllocRegs();
+    size_t regTypesNum;
+    cxuint maxRegs[MAX_REGTYPES_NUM];
+    assembler.isaAssembler->getMaxRegistersNum(regTypesNum, maxRegs);
+    cxuint* allocRegs = kernelStates[kernelId]->allocRegs;
+    for (size_t i = 0; i < regTypesNum; i++)
+        allocRegs[i] = std::max(allocRegs[i], regs[i]);
+    restoreCurrentAllocRegs();
+}
+
+size_t AsmAmdHandler::getKernelLocalSize(AsmKernelId kernelId) const
+{
+    const AmdKernelInput& kernel = output.kernels[kernelId];
+    return kernel.useConfig ? kernel.config.hwLocalSize : 0;
+}
+
 AsmKernelId AsmAmdHandler::addKernel(const char* kernelName)
 {
     AsmKernelId thisKernel = output.kernels.size();
@@ -1860,11 +1881,13 @@ bool AsmAmdHandler::prepareBinary()
 void AsmAmdHandler::writeBinary(std::ostream& os) const
 {
     AmdGPUBinGenerator binGenerator(&output);
+    binGenerator.setMergeStrTables((assembler.getFlags() & ASM_MERGESTRTABS) != 0);
     binGenerator.generate(os);
 }
 
 void AsmAmdHandler::writeBinary(Array<cxbyte>& array) const
 {
     AmdGPUBinGenerator binGenerator(&output);
+    binGenerator.setMergeStrTables((assembler.getFlags() & ASM_MERGESTRTABS) != 0);
     binGenerator.generate(array);
 }
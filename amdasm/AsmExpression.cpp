@@ -195,6 +195,20 @@ static bool checkSectionDiffs(size_t n, const RelMultiply* relMultiplies,
     return true;
 }
 
+// add label offset to range of labels in section
+static void addCodeLabelsDiff(std::vector<AsmCodeLabelsDiff>& labelsDiffs,
+            AsmSectionId sectionId, uint64_t offset, const AsmSourcePos& sourcePos)
+{
+    for (AsmCodeLabelsDiff& diff: labelsDiffs)
+        if (diff.sectionId == sectionId)
+        {
+            diff.minOffset = std::min(diff.minOffset, size_t(offset));
+            diff.maxOffset = std::max(diff.maxOffset, size_t(offset));
+            return;
+        }
+    labelsDiffs.push_back({ sectionId, size_t(offset), size_t(offset), sourcePos });
+}
+
 #define CHKSREL(rel) checkSectionDiffs(rel.size(), rel.data(), sections, \
                 withSectionDiffs, sectDiffsPrepared, tryLater)
 
@@ -439,6 +453,8 @@ AsmTryStatus AsmExpression::tryEvaluate(Assembler& assembler, size_t opStart, si
         size_t opPos = 0;
         size_t messagePosIndex = 0;
         std::vector<RelMultiply> relatives;
+        // code labels used by expression (if source positions are collected)
+        std::vector<AsmCodeLabelsDiff> labelsDiffs;
         
         // move messagePosIndex and argument position to opStart position
         for (opPos = 0; opPos < opStart; opPos++)
@@ -462,6 +478,8 @@ AsmTryStatus AsmExpression::tryEvaluate(Assembler& assembler, size_t opStart, si
                 {
                     uint64_t ovalue = args[argPos].relValue.value;
                     AsmSectionId osectId = args[argPos].relValue.sectionId;
+                    if (assembler.collectSourcePoses)
+                        addCodeLabelsDiff(labelsDiffs, osectId, ovalue, sourcePos);
                     if (sectDiffsPrepared && sections[osectId].relSpace!=UINT_MAX)
                     {
                         // resolve section in relspace
@@ -945,6 +963,11 @@ AsmTryStatus AsmExpression::tryEvaluate(Assembler& assembler, size_t opStart, si
             value += sections[sectionId].relAddress - sections[newSectionId].relAddress;
             sectionId = newSectionId;
         }
+        /* absolute value from labels will be invalid if code between labels
+         * will be changed by register allocation or wait insertion */
+        if (!failed && !tryLater && sectionId == ASMSECT_ABS)
+            assembler.codeLabelsDiffs.insert(assembler.codeLabelsDiffs.end(),
+                        labelsDiffs.begin(), labelsDiffs.end());
     }
     if (tryLater)
         return AsmTryStatus::TRY_LATER;
@@ -172,6 +172,9 @@ bool AsmFormatHandler::prepareSectionDiffsResolving()
     return false;
 }
 
+void AsmFormatHandler::updateKernelAllocRegs(AsmKernelId kernelId, const cxuint* regs)
+{ }
+
 /* AsmKcodeHandler */
 
 AsmKcodeHandler::AsmKcodeHandler(Assembler& assembler) : AsmFormatHandler(assembler),
@@ -188,6 +191,11 @@ void AsmKcodeHandler::restoreKcodeCurrentAllocRegs()
     }
 }
 
+size_t AsmFormatHandler::getKernelLocalSize(AsmKernelId kernelId) const
+{
+    return 0;
+}
+
 void AsmKcodeHandler::saveKcodeCurrentAllocRegs()
 {
     if (currentKcodeKernel != ASMKERN_GLOBAL)
@@ -201,6 +209,21 @@ void AsmKcodeHandler::saveKcodeCurrentAllocRegs()
     }
 }
 
+void AsmKcodeHandler::updateKernelAllocRegs(AsmKernelId kernelId, const cxuint* regs)
+{
+    if (assembler.isaAssembler == nullptr)
+        return;
+    // registers of current kernel are held by ISA assembler
+    saveKcodeCurrentAllocRegs();
+    size_t regTypesNum;
+    cxuint maxRegs[MAX_REGTYPES_NUM];
+    assembler.isaAssembler->getMaxRegistersNum(regTypesNum, maxRegs);
+    KernelBase& kernel = getKernelBase(kernelId);
+    for (size_t i = 0; i < regTypesNum; i++)
+        kernel.allocRegs[i] = std::max(kernel.allocRegs[i], regs[i]);
+    restoreKcodeCurrentAllocRegs();
+}
+
 void AsmKcodeHandler::prepareKcodeState()
 {
     if (assembler.isaAssembler!=nullptr)
@@ -1873,11 +1873,22 @@ bool AsmGalliumHandler::prepareBinary()
 void AsmGalliumHandler::writeBinary(std::ostream& os) const
 {
     GalliumBinGenerator binGenerator(&output);
+    binGenerator.setMergeStrTables((assembler.getFlags() & ASM_MERGESTRTABS) != 0);
     binGenerator.generate(os);
 }
 
 void AsmGalliumHandler::writeBinary(Array<cxbyte>& array) const
 {
     GalliumBinGenerator binGenerator(&output);
+    binGenerator.setMergeStrTables((assembler.getFlags() & ASM_MERGESTRTABS) != 0);
     binGenerator.generate(array);
 }
+
+size_t AsmGalliumHandler::getKernelLocalSize(AsmKernelId kernelId) const
+{
+    const GalliumKernelConfig& config = output.kernels[kernelId].config;
+    const AsmAmdHsaKernelConfig* hsaConfig = kernelStates[kernelId]->hsaConfig.get();
+    if (hsaConfig != nullptr && hsaConfig->workgroupGroupSegmentSize != BINGEN_DEFAULT)
+        return hsaConfig->workgroupGroupSegmentSize;
+    return config.localSize;
+}
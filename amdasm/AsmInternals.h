@@ -326,6 +326,10 @@ struct CLRX_INTERNAL AsmPseudoOps: AsmParseUtils
     static void doEnum(Assembler& asmr, const char* linePtr);
     // set policy version
     static void setPolicyVersion(Assembler& asmr, const char* linePtr);
+    // set target occupancy (waves per SIMD) for register allocation
+    static void setTargetOccupancy(Assembler& asmr, const char* linePtr);
+    // set scratch buffer resources for spilling VGPRs
+    static void setSpillScratch(Assembler& asmr, const char* linePtr);
     
     static void ignoreString(Assembler& asmr, const char* linePtr);
     
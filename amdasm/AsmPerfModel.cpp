@@ -0,0 +1,660 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <CLRX/Config.h>
+#include <vector>
+#include <cstring>
+#include <ostream>
+#include <utility>
+#include <algorithm>
+#include <unordered_map>
+#include <CLRX/utils/Utilities.h>
+#include <CLRX/utils/Containers.h>
+#include <CLRX/utils/GPUId.h>
+#include <CLRX/utils/MemAccess.h>
+#include <CLRX/amdasm/Assembler.h>
+#include "GCNInternals.h"
+#include "GCNDisasmInternals.h"
+
+using namespace CLRX;
+
+/*
+ * GCN instruction timings (from GcnTimings.md)
+ */
+
+enum : cxbyte
+{
+    GCNTIM_DPFACTOR = 1,    ///< cycles must be multiplied by DPFACTOR
+    GCNTIM_GLC1 = 2,    ///< one extra cycle if GLC modifier is set
+    GCNTIM_GLC2 = 4,    ///< two extra cycles if GLC modifier is set
+    GCNTIM_FMA32 = 8    ///< 4 cycles for devices with fast DP, otherwise 16 cycles
+};
+
+struct CLRX_INTERNAL GCNInstrTiming
+{
+    const char* mnemonic;
+    cxbyte cycles;
+    cxbyte flags;
+    GPUArchMask archMask;
+};
+
+/* instructions whose timings differ from default timings (4 cycles).
+ * table must be sorted by mnemonic */
+static const GCNInstrTiming gcnInstrTimingsTable[] =
+{
+    { "buffer_atomic_add", 16, GCNTIM_GLC1, ARCH_GCN_ALL },
+    { "buffer_atomic_add_x2", 16, GCNTIM_GLC2, ARCH_GCN_ALL },
+    { "buffer_atomic_and", 16, GCNTIM_GLC1, ARCH_GCN_ALL },
+    { "buffer_atomic_and_x2", 16, 0, ARCH_GCN_ALL },
+    { "buffer_atomic_cmpswap", 32, 0, ARCH_GCN_ALL },
+    { "buffer_atomic_cmpswap_x2", 32, 0, ARCH_GCN_ALL },
+    { "buffer_atomic_dec", 16, GCNTIM_GLC1, ARCH_GCN_ALL },
+    { "buffer_atomic_dec_x2", 16, GCNTIM_GLC2, ARCH_GCN_ALL },
+    { "buffer_atomic_fcmpswap", 32, 0, ARCH_GCN_ALL },
+    { "buffer_atomic_fcmpswap_x2", 32, 0, ARCH_GCN_ALL },
+    { "buffer_atomic_fmax", 16, GCNTIM_GLC1, ARCH_GCN_ALL },
+    { "buffer_atomic_fmax_x2", 16, GCNTIM_GLC2, ARCH_GCN_ALL },
+    { "buffer_atomic_fmin", 16, GCNTIM_GLC1, ARCH_GCN_ALL },
+    { "buffer_atomic_fmin_x2", 16, GCNTIM_GLC2, ARCH_GCN_ALL },
+    { "buffer_atomic_inc", 16, GCNTIM_GLC1, ARCH_GCN_ALL },
+    { "buffer_atomic_inc_x2", 16, GCNTIM_GLC2, ARCH_GCN_ALL },
+    { "buffer_atomic_or", 16, GCNTIM_GLC1, ARCH_GCN_ALL },
+    { "buffer_atomic_or_x2", 16, GCNTIM_GLC2, ARCH_GCN_ALL },
+    { "buffer_atomic_rsub", 16, GCNTIM_GLC1, ARCH_GCN_ALL },
+    { "buffer_atomic_rsub_x2", 16, GCNTIM_GLC2, ARCH_GCN_ALL },
+    { "buffer_atomic_smax", 16, GCNTIM_GLC1, ARCH_GCN_ALL },
+    { "buffer_atomic_smax_x2", 16, GCNTIM_GLC2, ARCH_GCN_ALL },
+    { "buffer_atomic_smin", 16, GCNTIM_GLC1, ARCH_GCN_ALL },
+    { "buffer_atomic_smin_x2", 16, GCNTIM_GLC2, ARCH_GCN_ALL },
+    { "buffer_atomic_sub", 16, GCNTIM_GLC1, ARCH_GCN_ALL },
+    { "buffer_atomic_sub_x2", 16, GCNTIM_GLC2, ARCH_GCN_ALL },
+    { "buffer_atomic_swap", 16, GCNTIM_GLC1, ARCH_GCN_ALL },
+    { "buffer_atomic_swap_x2", 16, GCNTIM_GLC2, ARCH_GCN_ALL },
+    { "buffer_atomic_umax", 16, GCNTIM_GLC1, ARCH_GCN_ALL },
+    { "buffer_atomic_umax_x2", 16, GCNTIM_GLC2, ARCH_GCN_ALL },
+    { "buffer_atomic_umin", 16, GCNTIM_GLC1, ARCH_GCN_ALL },
+    { "buffer_atomic_umin_x2", 16, GCNTIM_GLC2, ARCH_GCN_ALL },
+    { "buffer_atomic_xor", 16, GCNTIM_GLC1, ARCH_GCN_ALL },
+    { "buffer_atomic_xor_x2", 16, GCNTIM_GLC2, ARCH_GCN_ALL },
+    { "buffer_load_dword", 8, 0, ARCH_GCN_ALL },
+    { "buffer_load_dwordx2", 18, 0, ARCH_GCN_ALL },
+    { "buffer_load_dwordx3", 16, 0, ARCH_GCN_ALL },
+    { "buffer_load_dwordx4", 16, 0, ARCH_GCN_ALL },
+    { "buffer_load_format_x", 8, 0, ARCH_GCN_ALL },
+    { "buffer_load_format_xy", 18, 0, ARCH_GCN_ALL },
+    { "buffer_load_format_xyz", 16, 0, ARCH_GCN_ALL },
+    { "buffer_load_format_xyzw", 16, 0, ARCH_GCN_ALL },
+    { "buffer_load_sbyte", 8, 0, ARCH_GCN_ALL },
+    { "buffer_load_sshort", 8, 0, ARCH_GCN_ALL },
+    { "buffer_load_ubyte", 8, 0, ARCH_GCN_ALL },
+    { "buffer_load_ushort", 8, 0, ARCH_GCN_ALL },
+    { "buffer_store_byte", 16, 0, ARCH_GCN_ALL },
+    { "buffer_store_dword", 16, 0, ARCH_GCN_ALL },
+    { "buffer_store_dwordx2", 16, 0, ARCH_GCN_ALL },
+    { "buffer_store_dwordx3", 16, 0, ARCH_GCN_ALL },
+    { "buffer_store_dwordx4", 16, 0, ARCH_GCN_ALL },
+    { "buffer_store_format_x", 16, 0, ARCH_GCN_ALL },
+    { "buffer_store_format_xy", 16, 0, ARCH_GCN_ALL },
+    { "buffer_store_format_xyz", 16, 0, ARCH_GCN_ALL },
+    { "buffer_store_format_xyzw", 16, 0, ARCH_GCN_ALL },
+    { "buffer_store_short", 16, 0, ARCH_GCN_ALL },
+    { "ds_add_rtn_u32", 8, 0, ARCH_GCN_ALL },
+    { "ds_add_rtn_u64", 12, 0, ARCH_GCN_ALL },
+    { "ds_add_src2_u64", 8, 0, ARCH_GCN_ALL },
+    { "ds_add_u32", 8, 0, ARCH_GCN_ALL },
+    { "ds_add_u64", 12, 0, ARCH_GCN_ALL },
+    { "ds_and_b32", 8, 0, ARCH_GCN_ALL },
+    { "ds_and_b64", 12, 0, ARCH_GCN_ALL },
+    { "ds_and_rtn_b32", 8, 0, ARCH_GCN_ALL },
+    { "ds_and_rtn_b64", 12, 0, ARCH_GCN_ALL },
+    { "ds_and_src2_b64", 8, 0, ARCH_GCN_ALL },
+    { "ds_cmpst_b32", 12, 0, ARCH_GCN_ALL },
+    { "ds_cmpst_b64", 20, 0, ARCH_GCN_ALL },
+    { "ds_cmpst_f32", 12, 0, ARCH_GCN_ALL },
+    { "ds_cmpst_f64", 20, 0, ARCH_GCN_ALL },
+    { "ds_cmpst_rtn_b32", 12, 0, ARCH_GCN_ALL },
+    { "ds_cmpst_rtn_b64", 20, 0, ARCH_GCN_ALL },
+    { "ds_cmpst_rtn_f32", 12, 0, ARCH_GCN_ALL },
+    { "ds_cmpst_rtn_f64", 20, 0, ARCH_GCN_ALL },
+    { "ds_dec_rtn_u32", 8, 0, ARCH_GCN_ALL },
+    { "ds_dec_rtn_u64", 12, 0, ARCH_GCN_ALL },
+    { "ds_dec_src2_u64", 8, 0, ARCH_GCN_ALL },
+    { "ds_dec_u32", 8, 0, ARCH_GCN_ALL },
+    { "ds_dec_u64", 12, 0, ARCH_GCN_ALL },
+    { "ds_inc_rtn_u32", 8, 0, ARCH_GCN_ALL },
+    { "ds_inc_rtn_u64", 12, 0, ARCH_GCN_ALL },
+    { "ds_inc_src2_u64", 8, 0, ARCH_GCN_ALL },
+    { "ds_inc_u32", 8, 0, ARCH_GCN_ALL },
+    { "ds_inc_u64", 12, 0, ARCH_GCN_ALL },
+    { "ds_max_f32", 8, 0, ARCH_GCN_ALL },
+    { "ds_max_f64", 12, 0, ARCH_GCN_ALL },
+    { "ds_max_i32", 8, 0, ARCH_GCN_ALL },
+    { "ds_max_i64", 12, 0, ARCH_GCN_ALL },
+    { "ds_max_rtn_f32", 8, 0, ARCH_GCN_ALL },
+    { "ds_max_rtn_f64", 12, 0, ARCH_GCN_ALL },
+    { "ds_max_rtn_i32", 8, 0, ARCH_GCN_ALL },
+    { "ds_max_rtn_i64", 12, 0, ARCH_GCN_ALL },
+    { "ds_max_rtn_u32", 8, 0, ARCH_GCN_ALL },
+    { "ds_max_rtn_u64", 12, 0, ARCH_GCN_ALL },
+    { "ds_max_src2_f64", 8, 0, ARCH_GCN_ALL },
+    { "ds_max_src2_i64", 8, 0, ARCH_GCN_ALL },
+    { "ds_max_src2_u64", 8, 0, ARCH_GCN_ALL },
+    { "ds_max_u32", 8, 0, ARCH_GCN_ALL },
+    { "ds_max_u64", 12, 0, ARCH_GCN_ALL },
+    { "ds_min_f32", 8, 0, ARCH_GCN_ALL },
+    { "ds_min_f64", 12, 0, ARCH_GCN_ALL },
+    { "ds_min_i32", 8, 0, ARCH_GCN_ALL },
+    { "ds_min_i64", 12, 0, ARCH_GCN_ALL },
+    { "ds_min_rtn_f32", 8, 0, ARCH_GCN_ALL },
+    { "ds_min_rtn_f64", 12, 0, ARCH_GCN_ALL },
+    { "ds_min_rtn_i32", 8, 0, ARCH_GCN_ALL },
+    { "ds_min_rtn_i64", 12, 0, ARCH_GCN_ALL },
+    { "ds_min_rtn_u32", 8, 0, ARCH_GCN_ALL },
+    { "ds_min_rtn_u64", 12, 0, ARCH_GCN_ALL },
+    { "ds_min_src2_f64", 8, 0, ARCH_GCN_ALL },
+    { "ds_min_src2_i64", 8, 0, ARCH_GCN_ALL },
+    { "ds_min_src2_u64", 8, 0, ARCH_GCN_ALL },
+    { "ds_min_u32", 8, 0, ARCH_GCN_ALL },
+    { "ds_min_u64", 12, 0, ARCH_GCN_ALL },
+    { "ds_mskor_b32", 12, 0, ARCH_GCN_ALL },
+    { "ds_mskor_b64", 20, 0, ARCH_GCN_ALL },
+    { "ds_mskor_rtn_b32", 12, 0, ARCH_GCN_ALL },
+    { "ds_mskor_rtn_b64", 20, 0, ARCH_GCN_ALL },
+    { "ds_or_b32", 8, 0, ARCH_GCN_ALL },
+    { "ds_or_b64", 12, 0, ARCH_GCN_ALL },
+    { "ds_or_rtn_b32", 8, 0, ARCH_GCN_ALL },
+    { "ds_or_rtn_b64", 12, 0, ARCH_GCN_ALL },
+    { "ds_or_src2_b64", 8, 0, ARCH_GCN_ALL },
+    { "ds_read2_b32", 8, 0, ARCH_GCN_ALL },
+    { "ds_read2_b64", 16, 0, ARCH_GCN_ALL },
+    { "ds_read2st64_b32", 8, 0, ARCH_GCN_ALL },
+    { "ds_read2st64_b64", 16, 0, ARCH_GCN_ALL },
+    { "ds_read_b128", 16, 0, ARCH_GCN_ALL },
+    { "ds_read_b64", 8, 0, ARCH_GCN_ALL },
+    { "ds_read_b96", 16, 0, ARCH_GCN_ALL },
+    { "ds_rsub_rtn_u32", 8, 0, ARCH_GCN_ALL },
+    { "ds_rsub_rtn_u64", 12, 0, ARCH_GCN_ALL },
+    { "ds_rsub_src2_u64", 8, 0, ARCH_GCN_ALL },
+    { "ds_rsub_u32", 8, 0, ARCH_GCN_ALL },
+    { "ds_rsub_u64", 12, 0, ARCH_GCN_ALL },
+    { "ds_sub_rtn_u32", 8, 0, ARCH_GCN_ALL },
+    { "ds_sub_rtn_u64", 12, 0, ARCH_GCN_ALL },
+    { "ds_sub_src2_u64", 8, 0, ARCH_GCN_ALL },
+    { "ds_sub_u32", 8, 0, ARCH_GCN_ALL },
+    { "ds_sub_u64", 12, 0, ARCH_GCN_ALL },
+    { "ds_write2_b32", 12, 0, ARCH_GCN_ALL },
+    { "ds_write2_b64", 20, 0, ARCH_GCN_ALL },
+    { "ds_write2st64_b32", 12, 0, ARCH_GCN_ALL },
+    { "ds_write2st64_b64", 20, 0, ARCH_GCN_ALL },
+    { "ds_write_b128", 20, 0, ARCH_GCN_ALL },
+    { "ds_write_b16", 8, 0, ARCH_GCN_ALL },
+    { "ds_write_b32", 8, 0, ARCH_GCN_ALL },
+    { "ds_write_b64", 12, 0, ARCH_GCN_ALL },
+    { "ds_write_b8", 8, 0, ARCH_GCN_ALL },
+    { "ds_write_b96", 16, 0, ARCH_GCN_ALL },
+    { "ds_write_src2_b32", 12, 0, ARCH_GCN_ALL },
+    { "ds_write_src2_b64", 20, 0, ARCH_GCN_ALL },
+    { "ds_wrxchg2_rtn_b32", 12, 0, ARCH_GCN_ALL },
+    { "ds_wrxchg2_rtn_b64", 20, 0, ARCH_GCN_ALL },
+    { "ds_wrxchg2st64_rtn_b32", 12, 0, ARCH_GCN_ALL },
+    { "ds_wrxchg2st64_rtn_b64", 20, 0, ARCH_GCN_ALL },
+    { "ds_wrxchg_rtn_b32", 8, 0, ARCH_GCN_ALL },
+    { "ds_wrxchg_rtn_b64", 12, 0, ARCH_GCN_ALL },
+    { "ds_xor_b32", 8, 0, ARCH_GCN_ALL },
+    { "ds_xor_b64", 12, 0, ARCH_GCN_ALL },
+    { "ds_xor_rtn_b32", 8, 0, ARCH_GCN_ALL },
+    { "ds_xor_rtn_b64", 12, 0, ARCH_GCN_ALL },
+    { "ds_xor_src2_b64", 8, 0, ARCH_GCN_ALL },
+    { "s_branch", 20, 0, ARCH_GCN_ALL },
+    { "s_buffer_load_dwordx16", 20, 0, ARCH_GCN_ALL },
+    { "s_buffer_load_dwordx8", 8, 0, ARCH_GCN_ALL },
+    { "s_load_dwordx16", 20, 0, ARCH_GCN_ALL },
+    { "s_load_dwordx8", 8, 0, ARCH_GCN_ALL },
+    { "s_setreg_b32", 8, 0, ARCH_GCN_ALL },
+    { "s_setreg_imm32_b32", 8, 0, ARCH_GCN_ALL },
+    { "v_add_f64", 4, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_ashr_i64", 4, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_ashrrev_i64", 4, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_ceil_f64", 4, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_cos_f16", 16, 0, ARCH_GCN_ALL },
+    { "v_cos_f32", 16, 0, ARCH_GCN_ALL },
+    { "v_cvt_f32_f64", 4, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_cvt_f64_f32", 4, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_cvt_f64_i32", 4, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_cvt_f64_u32", 4, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_cvt_i32_f64", 4, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_cvt_u32_f64", 4, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_div_fixup_f32", 16, 0, ARCH_GCN_ALL },
+    { "v_div_fixup_f64", 4, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_div_fmas_f32", 16, 0, ARCH_GCN_ALL },
+    { "v_div_fmas_f64", 8, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_div_scale_f32", 16, 0, ARCH_GCN_ALL },
+    { "v_div_scale_f64", 4, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_exp_f16", 16, 0, ARCH_GCN_ALL },
+    { "v_exp_f32", 16, 0, ARCH_GCN_ALL },
+    { "v_exp_legacy_f32", 16, 0, ARCH_GCN_ALL },
+    { "v_floor_f64", 4, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_fma_f32", 4, GCNTIM_FMA32, ARCH_GCN_ALL },
+    { "v_fma_f64", 8, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_fract_f64", 4, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_frexp_exp_i32_f64", 4, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_frexp_mant_f64", 4, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_ldexp_f64", 4, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_log_clamp_f32", 16, 0, ARCH_GCN_ALL },
+    { "v_log_f16", 16, 0, ARCH_GCN_ALL },
+    { "v_log_f32", 16, 0, ARCH_GCN_ALL },
+    { "v_log_legacy_f32", 16, 0, ARCH_GCN_ALL },
+    { "v_lshl_b64", 4, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_lshlrev_b64", 4, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_lshr_b64", 4, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_lshrrev_b64", 4, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_mad_i64_i32", 16, 0, ARCH_GCN_ALL },
+    { "v_mad_u64_u32", 16, 0, ARCH_GCN_ALL },
+    { "v_max_f64", 4, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_min_f64", 4, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_mqsad_pk_u16_u8", 16, 0, ARCH_GCN_ALL },
+    { "v_mqsad_u32_u8", 16, 0, ARCH_GCN_ALL },
+    { "v_mqsad_u8", 16, 0, ARCH_GCN_ALL },
+    { "v_mul_f64", 8, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_mul_hi_i32", 16, 0, ARCH_GCN_ALL },
+    { "v_mul_hi_u32", 16, 0, ARCH_GCN_ALL },
+    { "v_mul_lo_i32", 16, 0, ARCH_GCN_ALL },
+    { "v_mul_lo_u32", 16, 0, ARCH_GCN_ALL },
+    { "v_qsad_pk_u16_u8", 16, 0, ARCH_GCN_ALL },
+    { "v_qsad_u8", 16, 0, ARCH_GCN_ALL },
+    { "v_rcp_clamp_f32", 16, 0, ARCH_GCN_ALL },
+    { "v_rcp_clamp_f64", 8, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_rcp_f16", 16, 0, ARCH_GCN_ALL },
+    { "v_rcp_f32", 16, 0, ARCH_GCN_ALL },
+    { "v_rcp_f64", 8, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_rcp_iflag_f32", 16, 0, ARCH_GCN_ALL },
+    { "v_rcp_legacy_f32", 16, 0, ARCH_GCN_ALL },
+    { "v_rndne_f64", 4, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_rsq_clamp_f32", 16, 0, ARCH_GCN_ALL },
+    { "v_rsq_clamp_f64", 8, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_rsq_f16", 16, 0, ARCH_GCN_ALL },
+    { "v_rsq_f32", 16, 0, ARCH_GCN_ALL },
+    { "v_rsq_f64", 8, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_rsq_legacy_f32", 16, 0, ARCH_GCN_ALL },
+    { "v_sin_f16", 16, 0, ARCH_GCN_ALL },
+    { "v_sin_f32", 16, 0, ARCH_GCN_ALL },
+    { "v_sqrt_f16", 16, 0, ARCH_GCN_ALL },
+    { "v_sqrt_f32", 16, 0, ARCH_GCN_ALL },
+    { "v_sqrt_f64", 8, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_swap_b32", 8, 0, ARCH_GCN_ALL },
+    { "v_trig_preop_f64", 8, GCNTIM_DPFACTOR, ARCH_GCN_ALL },
+    { "v_trunc_f64", 4, GCNTIM_DPFACTOR, ARCH_GCN_ALL }
+};
+
+static const size_t gcnInstrTimingsTableSize =
+        sizeof(gcnInstrTimingsTable)/sizeof(GCNInstrTiming);
+
+// execution units
+enum : cxuint
+{
+    GCNUNIT_SALU = 0,
+    GCNUNIT_VALU,
+    GCNUNIT_SMEM,
+    GCNUNIT_VMEM,
+    GCNUNIT_LDS,
+    GCNUNIT_EXP,
+    GCNUNIT_NUM
+};
+
+// execution units for encodings
+static const cxbyte gcnEncodingUnits[GCNENC_MAXVAL+1] =
+{
+    GCNUNIT_SALU, GCNUNIT_SALU, GCNUNIT_SALU, GCNUNIT_SALU, GCNUNIT_SALU,
+    GCNUNIT_SALU, GCNUNIT_SMEM, GCNUNIT_VALU, GCNUNIT_VALU, GCNUNIT_VALU,
+    GCNUNIT_VALU, GCNUNIT_VALU, GCNUNIT_VALU, GCNUNIT_LDS, GCNUNIT_VMEM,
+    GCNUNIT_VMEM, GCNUNIT_VMEM, GCNUNIT_EXP, GCNUNIT_VMEM
+};
+
+static inline bool gcnInstrTimingLess(const GCNInstrTiming& t1, const GCNInstrTiming& t2)
+{ return ::strcmp(t1.mnemonic, t2.mnemonic) < 0; }
+
+// get timing entry for instruction (null if not found)
+static const GCNInstrTiming* findGCNInstrTiming(const char* mnemonic,
+                GPUArchMask archMask)
+{
+    const GCNInstrTiming* end = gcnInstrTimingsTable + gcnInstrTimingsTableSize;
+    const GCNInstrTiming* it = std::lower_bound(gcnInstrTimingsTable, end,
+                GCNInstrTiming{ mnemonic }, gcnInstrTimingLess);
+    for (; it != end && ::strcmp(it->mnemonic, mnemonic) == 0; ++it)
+        if ((it->archMask & archMask) != 0)
+            return it;
+    return nullptr;
+}
+
+static bool endsWith(const char* str, const char* suffix)
+{
+    const size_t len = ::strlen(str);
+    const size_t suffixLen = ::strlen(suffix);
+    return len >= suffixLen && ::strcmp(str + len - suffixLen, suffix) == 0;
+}
+
+// get number of cycles of instruction
+cxuint CLRX::getGCNInstrCycles(const GCNInstruction& gcnInsn, cxbyte gcnEncoding,
+            uint32_t insnCode, GPUArchMask archMask, cxuint dpFactor)
+{
+    const char* mnemonic = gcnInsn.mnemonic;
+    const GCNInstrTiming* timing = nullptr;
+    if (gcnEncoding == GCNENC_MTBUF)
+        // tbuffer_* instructions have timings of buffer_* instructions
+        timing = findGCNInstrTiming(mnemonic+1, archMask);
+    else
+        timing = findGCNInstrTiming(mnemonic, archMask);
+
+    if (timing != nullptr)
+    {
+        if ((timing->flags & GCNTIM_FMA32) != 0)
+            return dpFactor <= 4 ? 4 : 16;
+        cxuint cycles = timing->cycles;
+        if ((timing->flags & GCNTIM_DPFACTOR) != 0)
+            cycles *= dpFactor;
+        if ((insnCode & 0x4000U) != 0) // GLC
+            cycles += ((timing->flags & GCNTIM_GLC1) != 0) ? 1 :
+                    ((timing->flags & GCNTIM_GLC2) != 0) ? 2 : 0;
+        return cycles;
+    }
+    // 64-bit comparisons
+    if (gcnInsn.encoding == GCNENC_VOPC && (endsWith(mnemonic, "_f64") ||
+        endsWith(mnemonic, "_i64") || endsWith(mnemonic, "_u64")))
+        return 4*dpFactor;
+    // S_*_SAVEEXEC_B64
+    if (gcnEncoding == GCNENC_SOP1 && ::strstr(mnemonic, "saveexec") != nullptr)
+        return 8;
+    return 4;
+}
+
+// VALU instructions that delay next scalar ALU instructions
+static bool isGCNVALUToSALUDelayed(const char* mnemonic)
+{
+    if (::strncmp(mnemonic, "v_add", 5) == 0 || ::strncmp(mnemonic, "v_sub", 5) == 0)
+        // only integer additions and subtractions
+        return ::strstr(mnemonic, "_f16") == nullptr &&
+                ::strstr(mnemonic, "_f32") == nullptr &&
+                ::strstr(mnemonic, "_f64") == nullptr;
+    return ::strcmp(mnemonic, "v_readlane_b32") == 0 ||
+            ::strcmp(mnemonic, "v_readfirstlane_b32") == 0;
+}
+
+cxuint CLRX::getGCNDPFactor(GPUDeviceType deviceType)
+{
+    return (deviceType == GPUDeviceType::TAHITI) ? 2 :
+            (deviceType == GPUDeviceType::HAWAII) ? 4 : 8;
+}
+
+/*
+ * AsmPerfEstimator
+ */
+
+AsmPerfEstimator::AsmPerfEstimator(Assembler& _assembler, cxuint _dpFactor)
+        : assembler(_assembler), dpFactor(_dpFactor)
+{
+    if (dpFactor == 0)
+        // determine DPFACTOR from device type
+        dpFactor = getGCNDPFactor(assembler.getDeviceType());
+}
+
+// state of register (for dependencies)
+struct CLRX_INTERNAL PerfRegState
+{
+    uint64_t ready;  // cycle when value is ready
+    uint64_t chainEnd;   // end of longest dependency chain to this value
+};
+
+static const uint16_t gcnVccReg = 106;
+static const uint16_t gcnExecReg = 126;
+
+AsmPerfEstimator::BlockPerf AsmPerfEstimator::estimateBlock(const AsmSection& section,
+            size_t start, size_t end, ISAUsageHandler::ReadPos& usagePos)
+{
+    const GPUArchitecture arch = getGPUArchitectureFromDeviceType(
+                assembler.getDeviceType());
+    const GPUArchMask archMask = 1U<<int(arch);
+    const bool isGCN1011 = arch <= GPUArchitecture::GCN1_1;
+    const uint32_t* codeWords = reinterpret_cast<const uint32_t*>(
+                section.content.data());
+    const size_t codeWordsNum = std::min(end, section.content.size())>>2;
+    ISAUsageHandler* usageHandler = section.usageHandler.get();
+
+    BlockPerf blockPerf = { start, end, 0, 0, 0, 0, 0 };
+    std::unordered_map<AsmSingleVReg, PerfRegState> regStates;
+    std::vector<AsmRegVarUsage> rvus;
+    uint64_t unitFree[GCNUNIT_NUM];
+    std::fill(unitFree, unitFree + GCNUNIT_NUM, uint64_t(0));
+    uint64_t nextIssue = 0;
+    uint64_t saluDelayEnd = 0;  // end of VALU to SALU delay
+    bool prevWritesVccExec = false;
+    bool prevWritesSCC = false;
+
+    size_t pos = start>>2;
+    while (pos < codeWordsNum)
+    {
+        const size_t offset = pos<<2;
+        cxbyte gcnEncoding;
+        uint32_t insnCode, insnCode2;
+        const GCNInstruction* gcnInsn = decodeGCNInstruction(arch, codeWords,
+                    codeWordsNum, pos, gcnEncoding, insnCode, insnCode2);
+        const size_t instrWords = pos - (offset>>2);
+        blockPerf.instrsNum++;
+
+        // collect register usages of this instruction
+        rvus.clear();
+        if (usageHandler != nullptr)
+        {
+            while (usageHandler->hasNext(usagePos))
+            {
+                ISAUsageHandler::ReadPos oldPos = usagePos;
+                AsmRegVarUsage rvu = usageHandler->nextUsage(usagePos);
+                if (rvu.offset >= (pos<<2))
+                {
+                    usagePos = oldPos; // belongs to next instruction
+                    break;
+                }
+                if (rvu.offset >= offset)
+                    rvus.push_back(rvu);
+            }
+        }
+
+        const cxuint unit = gcnEncodingUnits[gcnEncoding];
+        cxuint cycles = 4;
+        if (gcnInsn != nullptr)
+            cycles = getGCNInstrCycles(*gcnInsn, gcnEncoding, insnCode, archMask,
+                        dpFactor);
+        // penalty for 2-dword instructions outside first 3 dwords of 32-byte block
+        cxuint penalty = 0;
+        if (isGCN1011 && instrWords == 2 && ((offset>>2)&7) >= 3)
+            penalty = 4;
+
+        // structural constraints (issue and busy execution unit)
+        const uint64_t issueStart = std::max(nextIssue, unitFree[unit]);
+        uint64_t instrStart = issueStart;
+        uint64_t chainStart = 0;
+        bool writesVccExec = false;
+        for (const AsmRegVarUsage& rvu: rvus)
+            for (uint16_t r = rvu.rstart; r < rvu.rend; r++)
+            {
+                if ((rvu.rwFlags & ASMRVU_READ) != 0)
+                {
+                    auto it = regStates.find(AsmSingleVReg{ rvu.regVar, r });
+                    if (it != regStates.end())
+                    {
+                        instrStart = std::max(instrStart, it->second.ready);
+                        chainStart = std::max(chainStart, it->second.chainEnd);
+                    }
+                }
+                if ((rvu.rwFlags & ASMRVU_WRITE) != 0 && rvu.regVar == nullptr &&
+                    ((r&~1U) == gcnVccReg || (r&~1U) == gcnExecReg))
+                    writesVccExec = true;
+            }
+
+        const char* mnemonic = (gcnInsn != nullptr) ? gcnInsn->mnemonic : "";
+        // hazards described in GcnTimings.md
+        if (unit == GCNUNIT_SALU && gcnEncoding != GCNENC_SOPP)
+            instrStart = std::max(instrStart, saluDelayEnd);
+        if (gcnEncoding == GCNENC_SOPP)
+        {
+            if ((::strcmp(mnemonic, "s_cbranch_vccz") == 0 ||
+                ::strcmp(mnemonic, "s_cbranch_vccnz") == 0 ||
+                ::strcmp(mnemonic, "s_cbranch_execz") == 0 ||
+                ::strcmp(mnemonic, "s_cbranch_execnz") == 0) && prevWritesVccExec)
+                instrStart += 4;
+            else if ((::strcmp(mnemonic, "s_cbranch_scc0") == 0 ||
+                ::strcmp(mnemonic, "s_cbranch_scc1") == 0) &&
+                (prevWritesSCC || prevWritesVccExec))
+                instrStart += 4;
+        }
+
+        blockPerf.stallCycles += instrStart - issueStart;
+        blockPerf.issueCycles += cycles + penalty;
+        const uint64_t instrEnd = instrStart + penalty + cycles;
+        unitFree[unit] = instrEnd;
+        nextIssue = instrStart + penalty + 4;
+        blockPerf.cycles = std::max(blockPerf.cycles, instrEnd);
+
+        const uint64_t chainEnd = chainStart + cycles + penalty;
+        blockPerf.criticalPath = std::max(blockPerf.criticalPath, chainEnd);
+        for (const AsmRegVarUsage& rvu: rvus)
+            if ((rvu.rwFlags & ASMRVU_WRITE) != 0)
+                for (uint16_t r = rvu.rstart; r < rvu.rend; r++)
+                    regStates[AsmSingleVReg{ rvu.regVar, r }] = { instrEnd, chainEnd };
+
+        if (unit == GCNUNIT_VALU && isGCNVALUToSALUDelayed(mnemonic))
+            saluDelayEnd = instrStart + 16;
+        prevWritesVccExec = writesVccExec || (gcnEncoding == GCNENC_VOPC) ||
+                ::strstr(mnemonic, "saveexec") != nullptr;
+        prevWritesSCC = (gcnEncoding == GCNENC_SOP1 || gcnEncoding == GCNENC_SOP2 ||
+                gcnEncoding == GCNENC_SOPC || gcnEncoding == GCNENC_SOPK);
+    }
+    return blockPerf;
+}
+
+void AsmPerfEstimator::estimate()
+{
+    kernelPerfs.clear();
+    const std::vector<AsmSection>& sections = assembler.getSections();
+    const std::vector<AsmKernel>& kernels = assembler.getKernels();
+    for (AsmSectionId sectionId = 0; sectionId < sections.size(); sectionId++)
+    {
+        const AsmSection& section = sections[sectionId];
+        if (section.type != AsmSectionType::CODE || section.content.empty())
+            continue;
+
+        AsmRegAllocator regAlloc(assembler);
+        regAlloc.createCodeStructure(section.codeFlow, section.content.size(),
+                    section.content.data());
+        const std::vector<AsmRegAllocator::CodeBlock>& codeBlocks =
+                    regAlloc.getCodeBlocks();
+
+        std::vector<BlockPerf> blockPerfs;
+        ISAUsageHandler::ReadPos usagePos{ 0, 0 };
+        for (const AsmRegAllocator::CodeBlock& cblock: codeBlocks)
+        {
+            if (section.usageHandler != nullptr)
+                usagePos = section.usageHandler->findPositionByOffset(cblock.start);
+            blockPerfs.push_back(estimateBlock(section, cblock.start, cblock.end,
+                        usagePos));
+        }
+
+        // assign blocks to kernels
+        std::vector<AsmKernelId> blockKernels(codeBlocks.size(), ASMKERN_GLOBAL);
+        if (section.kernelId != ASMKERN_GLOBAL && section.kernelId != ASMKERN_INNER)
+            std::fill(blockKernels.begin(), blockKernels.end(), section.kernelId);
+        else
+            for (AsmKernelId k = 0; k < kernels.size(); k++)
+                for (const std::pair<size_t, size_t>& region: kernels[k].codeRegions)
+                    for (size_t i = 0; i < codeBlocks.size(); i++)
+                        if (codeBlocks[i].start >= region.first &&
+                            codeBlocks[i].start < region.second)
+                            blockKernels[i] = k;
+
+        // kernels in order of kernel id, code outside kernels (ASMKERN_GLOBAL) at end
+        std::vector<AsmKernelId> kernelIds(blockKernels);
+        std::sort(kernelIds.begin(), kernelIds.end());
+        kernelIds.resize(std::unique(kernelIds.begin(), kernelIds.end()) -
+                    kernelIds.begin());
+        for (AsmKernelId kernelId: kernelIds)
+        {
+            KernelPerf kernelPerf;
+            kernelPerf.name = (kernelId != ASMKERN_GLOBAL) ? kernels[kernelId].name :
+                        section.name;
+            kernelPerf.sectionId = sectionId;
+            kernelPerf.instrsNum = 0;
+            kernelPerf.issueCycles = kernelPerf.stallCycles = 0;
+            kernelPerf.cycles = kernelPerf.criticalPath = 0;
+
+            /* longest path in code flow graph (backward jumps are ignored)
+             * pathCycles - longest path to end of block */
+            std::vector<uint64_t> pathCycles(codeBlocks.size(), 0);
+            for (size_t i = 0; i < codeBlocks.size(); i++)
+            {
+                if (blockKernels[i] != kernelId)
+                    continue;
+                const BlockPerf& blockPerf = blockPerfs[i];
+                kernelPerf.blocks.push_back(blockPerf);
+                kernelPerf.instrsNum += blockPerf.instrsNum;
+                kernelPerf.issueCycles += blockPerf.issueCycles;
+                kernelPerf.stallCycles += blockPerf.stallCycles;
+                kernelPerf.cycles += blockPerf.cycles;
+
+                pathCycles[i] += blockPerf.cycles;
+                kernelPerf.criticalPath = std::max(kernelPerf.criticalPath,
+                            pathCycles[i]);
+                // propagate to next blocks
+                const AsmRegAllocator::CodeBlock& cblock = codeBlocks[i];
+                for (const AsmRegAllocator::NextBlock& next: cblock.nexts)
+                    if (next.block > i)
+                        pathCycles[next.block] = std::max(pathCycles[next.block],
+                                    pathCycles[i]);
+                if ((cblock.nexts.empty() && !cblock.haveEnd) || cblock.haveCalls)
+                    if (i+1 < codeBlocks.size())
+                        pathCycles[i+1] = std::max(pathCycles[i+1], pathCycles[i]);
+            }
+            kernelPerfs.push_back(std::move(kernelPerf));
+        }
+    }
+}
+
+void AsmPerfEstimator::writeReport(std::ostream& output) const
+{
+    output << "Performance estimation (single wavefront, DPFACTOR=" << dpFactor <<
+            ")\n";
+    for (const KernelPerf& kernelPerf: kernelPerfs)
+    {
+        output << "Kernel '" << kernelPerf.name << "':\n";
+        for (const BlockPerf& blockPerf: kernelPerf.blocks)
+        {
+            char buf[40];
+            itocstrCStyle(blockPerf.start, buf, 20, 16);
+            output << "  block " << buf;
+            itocstrCStyle(blockPerf.end, buf, 20, 16);
+            output << "-" << buf << ": instrs " << blockPerf.instrsNum <<
+                ", issue " << blockPerf.issueCycles << ", stalls " <<
+                blockPerf.stallCycles << ", cycles " << blockPerf.cycles <<
+                ", critical path " << blockPerf.criticalPath << "\n";
+        }
+        output << "  total: instrs " << kernelPerf.instrsNum << ", issue " <<
+            kernelPerf.issueCycles << ", stalls " << kernelPerf.stallCycles <<
+            ", cycles " << kernelPerf.cycles << ", critical path " <<
+            kernelPerf.criticalPath << "\n";
+    }
+    output.flush();
+}
@@ -118,8 +118,8 @@ static const char* pseudoOpNamesTbl[] =
     "rawcode", "regvar", "rept", "rocm", "rodata",
     "rvlin", "rvlin_once", "sbttl", "scope", "section", "set",
     "short", "single", "size", "skip",
-    "space", "string", "string16", "string32",
-    "string64", "struct", "text", "title",
+    "space", "spill_scratch", "string", "string16", "string32",
+    "string64", "struct", "target_occupancy", "text", "title",
     "undef", "unusing", "usereg", "using", "version",
     "warning", "weak", "while", "word"
 };
@@ -161,8 +161,8 @@ enum
     ASMOP_RAWCODE, ASMOP_REGVAR, ASMOP_REPT, ASMOP_ROCM, ASMOP_RODATA,
     ASMOP_RVLIN, ASMOP_RVLIN_ONCE, ASMOP_SBTTL, ASMOP_SCOPE, ASMOP_SECTION, ASMOP_SET,
     ASMOP_SHORT, ASMOP_SINGLE, ASMOP_SIZE, ASMOP_SKIP,
-    ASMOP_SPACE, ASMOP_STRING, ASMOP_STRING16, ASMOP_STRING32,
-    ASMOP_STRING64, ASMOP_STRUCT, ASMOP_TEXT, ASMOP_TITLE,
+    ASMOP_SPACE, ASMOP_SPILL_SCRATCH, ASMOP_STRING, ASMOP_STRING16, ASMOP_STRING32,
+    ASMOP_STRING64, ASMOP_STRUCT, ASMOP_TARGET_OCCUPANCY, ASMOP_TEXT, ASMOP_TITLE,
     ASMOP_UNDEF, ASMOP_UNUSING, ASMOP_USEREG, ASMOP_USING, ASMOP_VERSION,
     ASMOP_WARNING, ASMOP_WEAK, ASMOP_WHILE, ASMOP_WORD
 };
@@ -674,6 +674,12 @@ void Assembler::parsePseudoOps(const CString& firstName,
         case ASMOP_STRUCT:
             AsmPseudoOps::setAbsoluteOffset(*this, linePtr);
             break;
+        case ASMOP_SPILL_SCRATCH:
+            AsmPseudoOps::setSpillScratch(*this, linePtr);
+            break;
+        case ASMOP_TARGET_OCCUPANCY:
+            AsmPseudoOps::setTargetOccupancy(*this, linePtr);
+            break;
         case ASMOP_TEXT:
             AsmPseudoOps::goToSection(*this, stmtPlace, stmtPlace, true);
             break;
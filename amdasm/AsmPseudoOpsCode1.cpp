@@ -397,7 +397,8 @@ void AsmPseudoOps::includeBinFile(Assembler& asmr, const char* pseudoOpPlace,
     sysfilename = filename;
     filesystemPath(sysfilename);
     // try in this directory
-    ifs.open(sysfilename.c_str(), std::ios::binary);
+    std::string openedPath = sysfilename;
+    ifs.open(openedPath.c_str(), std::ios::binary);
     if (!ifs)
     {
         // find in include paths
@@ -405,7 +406,8 @@ void AsmPseudoOps::includeBinFile(Assembler& asmr, const char* pseudoOpPlace,
         {
             std::string incDirPath(incDir.c_str());
             filesystemPath(incDirPath);
-            ifs.open(joinPaths(incDirPath.c_str(), sysfilename).c_str(), std::ios::binary);
+            openedPath = joinPaths(incDirPath.c_str(), sysfilename);
+            ifs.open(openedPath.c_str(), std::ios::binary);
             if (ifs)
                 break;
         }
@@ -427,18 +429,20 @@ void AsmPseudoOps::includeBinFile(Assembler& asmr, const char* pseudoOpPlace,
     ifs.exceptions(std::ios::badbit);  // exceptions for reading
     if (seekingIsWorking)
     {
-        /* for regular files */
-        const uint64_t size = ifs.tellg();
-        if (size < offset)
-            return; // do nothing
-        // skip offset bytes
-        ifs.seekg(offset, std::ios::beg);
-        const uint64_t toRead = std::min(size-offset, count);
-        char* output = reinterpret_cast<char*>(asmr.reserveData(toRead));
-        // and just read directly to output
-        ifs.read(output, toRead);
-        if (ifs.gcount() != std::streamsize(toRead))
-            ASM_RETURN_BY_ERROR(namePlace, "Can't read whole needed file content")
+        /* for regular files - map file and copy only needed part */
+        ifs.close();
+        try
+        {
+            MappedFile binFile(openedPath.c_str());
+            const uint64_t size = binFile.size();
+            if (size < offset)
+                return; // do nothing
+            const uint64_t toRead = std::min(size-offset, count);
+            asmr.putData(toRead, binFile.data() + offset);
+        }
+        catch(const Exception& ex)
+        { ASM_RETURN_BY_ERROR(namePlace, (std::string("Binary file '") + filename +
+                    "' can't be read: " + ex.what()).c_str()) }
     }
     else
     {
@@ -2267,6 +2271,75 @@ void AsmPseudoOps::setPolicyVersion(Assembler& asmr, const char* linePtr)
     asmr.setPolicyVersion(value);
 }
 
+void AsmPseudoOps::setTargetOccupancy(Assembler& asmr, const char* linePtr)
+{
+    const char* end = asmr.line + asmr.lineSize;
+    skipSpacesToEnd(linePtr, end);
+    uint64_t value = 0;
+    const char* valuePlace = linePtr;
+    if (!getAbsoluteValueArg(asmr, value, linePtr, true))
+        return;
+    if (!checkGarbagesAtEnd(asmr, linePtr))
+        return;
+    
+    if (value == 0 || value > GPU_MAX_WAVES_PER_SIMD)
+    {
+        char buf[64];
+        snprintf(buf, 64, "Target occupancy out of range (1-%u)",
+                 cxuint(GPU_MAX_WAVES_PER_SIMD));
+        asmr.printError(valuePlace, buf);
+        return;
+    }
+    if (asmr.currentKernel < asmr.kernels.size())
+        // target for current kernel
+        asmr.kernels[asmr.currentKernel].targetOccupancy = value;
+    else
+        asmr.setTargetOccupancy(value);
+}
+
+void AsmPseudoOps::setSpillScratch(Assembler& asmr, const char* linePtr)
+{
+    const char* end = asmr.line + asmr.lineSize;
+    asmr.initializeOutputFormat();
+    size_t regTypesNum;
+    cxuint regRanges[MAX_REGTYPES_NUM*2];
+    asmr.isaAssembler->getRegisterRanges(regTypesNum, regRanges);
+    
+    skipSpacesToEnd(linePtr, end);
+    const char* rsrcPlace = linePtr;
+    cxuint rsrcStart = 0, rsrcEnd = 0;
+    const AsmRegVar* regVar = nullptr;
+    bool good = asmr.isaAssembler->parseRegisterRange(linePtr, rsrcStart, rsrcEnd, regVar);
+    // scratch resource must be 4 aligned SGPRs
+    if (good && (regVar != nullptr || rsrcEnd-rsrcStart != 4 || (rsrcStart&3) != 0 ||
+            rsrcStart < regRanges[0] || rsrcEnd > regRanges[1]))
+        ASM_NOTGOOD_BY_ERROR(rsrcPlace, "Scratch resource must be 4 aligned SGPRs")
+    
+    if (!skipRequiredComma(asmr, linePtr))
+        return;
+    skipSpacesToEnd(linePtr, end);
+    const char* offsetPlace = linePtr;
+    cxuint offsetStart = 0, offsetEnd = 0;
+    if (asmr.isaAssembler->parseRegisterRange(linePtr, offsetStart, offsetEnd, regVar))
+    {
+        if (regVar != nullptr || offsetEnd-offsetStart != 1 ||
+            offsetStart < regRanges[0] || offsetEnd > regRanges[1])
+            ASM_NOTGOOD_BY_ERROR(offsetPlace, "Scratch offset must be single SGPR")
+    }
+    else
+        good = false;
+    if (!good || !checkGarbagesAtEnd(asmr, linePtr))
+        return;
+    
+    const AsmSpillScratch spillScratch{ true, rsrcStart - regRanges[0],
+                offsetStart - regRanges[0] };
+    if (asmr.currentKernel < asmr.kernels.size())
+        // scratch for current kernel
+        asmr.kernels[asmr.currentKernel].spillScratch = spillScratch;
+    else
+        asmr.setSpillScratch(spillScratch);
+}
+
 void AsmPseudoOps::ignoreString(Assembler& asmr, const char* linePtr)
 {
     const char* end = asmr.line+asmr.lineSize;
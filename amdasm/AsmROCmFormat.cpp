@@ -50,7 +50,8 @@ static const char* rocmPseudoOpNamesTbl[] =
     "localsize", "machine",
     "max_flat_work_group_size", "max_scratch_backing_memory",
     "md_group_segment_fixed_size", "md_kernarg_segment_align",
-    "md_kernarg_segment_size", "md_language","md_private_segment_fixed_size",
+    "md_kernarg_segment_size", "md_language", "md_msgpack",
+    "md_private_segment_fixed_size",
     "md_sgprsnum", "md_symname", "md_version",
     "md_vgprsnum", "md_wavefront_size",
     "metadata", "newbinfmt", "nosectdiffs",
@@ -90,7 +91,7 @@ enum
     ROCMOP_LOCALSIZE, ROCMOP_MACHINE,
     ROCMOP_MAX_FLAT_WORK_GROUP_SIZE, ROCMOP_MAX_SCRATCH_BACKING_MEMORY,
     ROCMOP_MD_GROUP_SEGMENT_FIXED_SIZE, ROCMOP_MD_KERNARG_SEGMENT_ALIGN,
-    ROCMOP_MD_KERNARG_SEGMENT_SIZE, ROCMOP_MD_LANGUAGE,
+    ROCMOP_MD_KERNARG_SEGMENT_SIZE, ROCMOP_MD_LANGUAGE, ROCMOP_MD_MSGPACK,
     ROCMOP_MD_PRIVATE_SEGMENT_FIXED_SIZE, ROCMOP_MD_SGPRSNUM,
     ROCMOP_MD_SYMNAME, ROCMOP_MD_VERSION, ROCMOP_MD_VGPRSNUM, ROCMOP_MD_WAVEFRONT_SIZE,
     ROCMOP_METADATA, ROCMOP_NEWBINFMT, ROCMOP_NOSECTDIFFS,
@@ -456,6 +457,14 @@ void AsmROCmPseudoOps::setNewBinFormat(AsmROCmHandler& handler, const char* line
     handler.output.newBinFormat = true;
 }
 
+void AsmROCmPseudoOps::setMetadataMsgPack(AsmROCmHandler& handler, const char* linePtr)
+{
+    Assembler& asmr = handler.assembler;
+    if (!checkGarbagesAtEnd(asmr, linePtr))
+        return;
+    handler.output.metadataMsgPack = true;
+}
+
 void AsmROCmPseudoOps::addMetadata(AsmROCmHandler& handler, const char* pseudoOpPlace,
                       const char* linePtr)
 {
@@ -1993,6 +2002,9 @@ bool AsmROCmHandler::parsePseudoOp(const CString& firstName, const char* stmtPla
         case ROCMOP_MD_LANGUAGE:
             AsmROCmPseudoOps::setKernelLanguage(*this, stmtPlace, linePtr);
             break;
+        case ROCMOP_MD_MSGPACK:
+            AsmROCmPseudoOps::setMetadataMsgPack(*this, linePtr);
+            break;
         case ROCMOP_NOSECTDIFFS:
             AsmROCmPseudoOps::noSectionDiffs(*this, linePtr);
             break;
@@ -2496,6 +2508,7 @@ bool AsmROCmHandler::prepareSectionDiffsResolving()
     if (good)
     {
         binGen.reset(new ROCmBinGenerator(&output));
+        binGen->setMergeStrTables((assembler.getFlags() & ASM_MERGESTRTABS) != 0);
         binGen->prepareBinaryGen();
         
         // add relSpacesSections
@@ -2677,3 +2690,11 @@ void AsmROCmHandler::writeBinary(Array<cxbyte>& array) const
 {
     binGen->generate(array);
 }
+
+size_t AsmROCmHandler::getKernelLocalSize(AsmKernelId kernelId) const
+{
+    const AsmROCmKernelConfig* config = kernelStates[kernelId]->config.get();
+    if (config == nullptr || config->workgroupGroupSegmentSize == BINGEN_DEFAULT)
+        return 0;
+    return config->workgroupGroupSegmentSize;
+}
@@ -157,6 +157,8 @@ struct CLRX_INTERNAL AsmROCmPseudoOps: AsmPseudoOps
                       const char* linePtr);
     // .newbinfmt
     static void setNewBinFormat(AsmROCmHandler& handler, const char* linePtr);
+    // .md_msgpack
+    static void setMetadataMsgPack(AsmROCmHandler& handler, const char* linePtr);
     
     // checkConfigValue, setConfigValueMain routines used by other handlers
     // to check and set AMD HSA config value
@@ -30,6 +30,9 @@
 #include <set>
 #include <unordered_map>
 #include <algorithm>
+#include <atomic>
+#include <thread>
+#include <exception>
 #include <CLRX/utils/Utilities.h>
 #include <CLRX/utils/Containers.h>
 #include <CLRX/amdasm/Assembler.h>
@@ -142,13 +145,23 @@ ISALinearDepHandler* ISALinearDepHandler::copy() const
  * Asm register allocator stuff
  */
 
-AsmRegAllocator::AsmRegAllocator(Assembler& _assembler) : assembler(_assembler)
-{ }
+AsmRegAllocator::AsmRegAllocator(Assembler& _assembler) : assembler(_assembler),
+        linearDepsFailures(0), targetOccupancy(0), spillScratch{}, spillScratchSize(0)
+{
+    std::fill(targetOccupancyMissed, targetOccupancyMissed+MAX_REGTYPES_NUM, false);
+    std::fill(spillTempsNums, spillTempsNums+MAX_REGTYPES_NUM, 0);
+    std::fill(spillTempBases, spillTempBases+MAX_REGTYPES_NUM, 0);
+}
 
 AsmRegAllocator::AsmRegAllocator(Assembler& _assembler,
         const std::vector<CodeBlock>& _codeBlocks, const SSAReplacesMap& _ssaReplacesMap)
-        : assembler(_assembler), codeBlocks(_codeBlocks), ssaReplacesMap(_ssaReplacesMap)
-{ }
+        : assembler(_assembler), codeBlocks(_codeBlocks), ssaReplacesMap(_ssaReplacesMap),
+          linearDepsFailures(0), targetOccupancy(0), spillScratch{}, spillScratchSize(0)
+{
+    std::fill(targetOccupancyMissed, targetOccupancyMissed+MAX_REGTYPES_NUM, false);
+    std::fill(spillTempsNums, spillTempsNums+MAX_REGTYPES_NUM, 0);
+    std::fill(spillTempBases, spillTempBases+MAX_REGTYPES_NUM, 0);
+}
 
 static inline bool codeBlockStartLess(const AsmRegAllocator::CodeBlock& c1,
                   const AsmRegAllocator::CodeBlock& c2)
@@ -336,6 +349,14 @@ void AsmRegAllocator::createCodeStructure(const std::vector<AsmCodeFlowEntry>& c
                   { return n1.block == n2.block && n1.isCall == n2.isCall; });
         block.nexts.resize(it - block.nexts.begin());
     }
+    
+    // loop depths: every jump to earlier block (back edge) closes a loop
+    loopDepths.assign(codeBlocks.size(), 0);
+    for (size_t i = 0; i < codeBlocks.size(); i++)
+        for (const NextBlock& next: codeBlocks[i].nexts)
+            if (!next.isCall && next.block <= i)
+                for (size_t b = next.block; b <= i; b++)
+                    loopDepths[b]++;
 }
 
 
@@ -567,62 +588,152 @@ void AsmRegAllocator::applySSAReplaces()
     ssaReplacesMap.clear();
 }
 
-void AsmRegAllocator::createInterferenceGraph()
+void AsmRegAllocator::InterGraph::clear()
 {
-    /// construct liveBlockMaps
-    std::set<LiveBlock> liveBlockMaps[MAX_REGTYPES_NUM];
-    for (size_t regType = 0; regType < regTypesNum; regType++)
+    nodesNum = rowWords = 0;
+    dense = false;
+    matrix.clear();
+    adjStarts.clear();
+    adjNodes.clear();
+    degrees.clear();
+}
+
+// graphs with this number of nodes or less are always stored as bit matrix
+static const size_t INTERGRAPH_DENSE_NODES_MAX = 4096;
+
+void AsmRegAllocator::InterGraph::build(size_t _nodesNum,
+            const Array<OutLiveness>& livenesses, Mode mode)
+{
+    clear();
+    nodesNum = _nodesNum;
+    degrees.resize(nodesNum);
+    std::fill(degrees.begin(), degrees.end(), size_t(0));
+    
+    // collect live intervals, sorted by start
+    std::vector<LiveBlock> liveBlocks;
+    for (size_t li = 0; li < livenesses.size(); li++)
+        for (const std::pair<size_t, size_t>& blk: livenesses[li])
+            if (blk.first != blk.second)
+                liveBlocks.push_back({ blk.first, blk.second, li });
+    std::sort(liveBlocks.begin(), liveBlocks.end());
+    
+    if (mode == DENSE || (mode == AUTO && nodesNum <= INTERGRAPH_DENSE_NODES_MAX))
     {
-        std::set<LiveBlock>& liveBlockMap = liveBlockMaps[regType];
-        Array<OutLiveness>& liveness = outLivenesses[regType];
-        for (size_t li = 0; li < liveness.size(); li++)
+        // put edges directly to bit matrix
+        dense = true;
+        rowWords = (nodesNum+63)>>6;
+        matrix.resize(nodesNum*rowWords);
+        std::fill(matrix.begin(), matrix.end(), uint64_t(0));
+    }
+    
+    std::vector<std::pair<size_t, size_t> > edges;
+    // sweep line: active - intervals which can be live at start of current interval
+    std::vector<LiveBlock> active;
+    for (const LiveBlock& lb: liveBlocks)
+    {
+        size_t j = 0;
+        for (size_t k = 0; k < active.size(); k++)
         {
-            OutLiveness& lv = liveness[li];
-            for (const std::pair<size_t, size_t>& blk: lv)
-                if (blk.first != blk.second)
-                    liveBlockMap.insert({ blk.first, blk.second, li });
-            lv.clear();
+            if (active[k].end <= lb.start)
+                continue; // ended before current interval, remove it
+            const size_t v = active[k].vidx;
+            active[j++] = active[k];
+            if (v == lb.vidx)
+                continue;
+            if (dense)
+            {
+                uint64_t& word = matrix[lb.vidx*rowWords + (v>>6)];
+                const uint64_t mask = 1ULL<<(v&63);
+                if ((word & mask) != 0)
+                    continue; // already added
+                word |= mask;
+                matrix[v*rowWords + (lb.vidx>>6)] |= 1ULL<<(lb.vidx&63);
+                degrees[lb.vidx]++;
+                degrees[v]++;
+            }
+            else
+                edges.push_back(std::minmax(v, lb.vidx));
         }
-        liveness.clear();
+        active.resize(j);
+        active.push_back(lb);
     }
     
-    // create interference graphs
-    for (size_t regType = 0; regType < regTypesNum; regType++)
+    if (!dense)
+        buildFromEdges(edges, mode);
+}
+
+void AsmRegAllocator::InterGraph::buildFromEdges(
+            std::vector<std::pair<size_t, size_t> >& edges, Mode mode)
+{
+    std::sort(edges.begin(), edges.end());
+    edges.resize(std::unique(edges.begin(), edges.end()) - edges.begin());
+    
+    // choose bit matrix if it takes no more memory than adjacency lists
+    if (mode == DENSE || (mode == AUTO &&
+            (nodesNum>>3)*nodesNum <= 2*edges.size()*sizeof(size_t)))
     {
-        InterGraph& interGraph = interGraphs[regType];
-        interGraph.resize(graphVregsCounts[regType]);
-        std::set<LiveBlock>& liveBlockMap = liveBlockMaps[regType];
-        
-        auto lit = liveBlockMap.begin();
-        size_t rangeStart = 0;
-        if (lit != liveBlockMap.end())
-            rangeStart = lit->start;
-        while (lit != liveBlockMap.end())
+        dense = true;
+        rowWords = (nodesNum+63)>>6;
+        matrix.resize(nodesNum*rowWords);
+        std::fill(matrix.begin(), matrix.end(), uint64_t(0));
+        for (const auto& e: edges)
         {
-            const size_t blkStart = lit->start;
-            const size_t blkEnd = lit->end;
-            size_t rangeEnd = blkEnd;
-            auto liStart = liveBlockMap.lower_bound({ rangeStart, 0, 0 });
-            auto liEnd = liveBlockMap.lower_bound({ rangeEnd, 0, 0 });
-            // collect from this range, variable indices
-            std::set<size_t> varIndices;
-            for (auto lit2 = liStart; lit2 != liEnd; ++lit2)
-                varIndices.insert(lit2->vidx);
-            // push to intergraph as full subgGraph
-            for (auto vit = varIndices.begin(); vit != varIndices.end(); ++vit)
-                for (auto vit2 = varIndices.begin(); vit2 != varIndices.end(); ++vit2)
-                    if (vit != vit2)
-                        interGraph[*vit].insert(*vit2);
-            // go to next live blocks
-            rangeStart = rangeEnd;
-            for (; lit != liveBlockMap.end(); ++lit)
-                if (lit->start != blkStart && lit->end != blkEnd)
-                    break;
-            if (lit == liveBlockMap.end())
-                break; // 
-            rangeStart = std::max(rangeStart, lit->start);
+            matrix[e.first*rowWords + (e.second>>6)] |= 1ULL<<(e.second&63);
+            matrix[e.second*rowWords + (e.first>>6)] |= 1ULL<<(e.first&63);
+            degrees[e.first]++;
+            degrees[e.second]++;
         }
+        return;
     }
+    
+    for (const auto& e: edges)
+    {
+        degrees[e.first]++;
+        degrees[e.second]++;
+    }
+    adjStarts.resize(nodesNum+1);
+    adjStarts[0] = 0;
+    for (size_t i = 0; i < nodesNum; i++)
+        adjStarts[i+1] = adjStarts[i] + degrees[i];
+    adjNodes.resize(adjStarts[nodesNum]);
+    // edges are sorted, hence, for every node, lower neighbors are put before
+    // higher neighbors and adjacency lists are sorted
+    std::vector<size_t> fillPos(adjStarts.begin(), adjStarts.end()-1);
+    for (const auto& e: edges)
+    {
+        adjNodes[fillPos[e.first]++] = e.second;
+        adjNodes[fillPos[e.second]++] = e.first;
+    }
+}
+
+void AsmRegAllocator::InterGraph::contract(const std::vector<size_t>& reps)
+{
+    std::vector<std::pair<size_t, size_t> > edges;
+    for (size_t node = 0; node < nodesNum; node++)
+        forEachNeighbor(node, [&edges, &reps, node](size_t nb)
+        {
+            if (node < nb && reps[node] != reps[nb])
+                edges.push_back(std::minmax(reps[node], reps[nb]));
+        });
+    const size_t oldNodesNum = nodesNum;
+    clear();
+    nodesNum = oldNodesNum;
+    degrees.resize(nodesNum);
+    std::fill(degrees.begin(), degrees.end(), size_t(0));
+    buildFromEdges(edges, AUTO);
+}
+
+void AsmRegAllocator::createInterferenceGraph()
+{
+    for (size_t regType = 0; regType < regTypesNum; regType++)
+        createInterferenceGraph(regType);
+}
+
+void AsmRegAllocator::createInterferenceGraph(size_t regType)
+{
+    Array<OutLiveness>& liveness = outLivenesses[regType];
+    interGraphs[regType].build(graphVregsCounts[regType], liveness);
+    liveness.clear();
 }
 
 /* algorithm to allocate regranges:
@@ -635,101 +746,592 @@ void AsmRegAllocator::createInterferenceGraph()
  */
 
 void AsmRegAllocator::colorInterferenceGraph()
+{
+    for (size_t regType = 0; regType < regTypesNum; regType++)
+        colorInterferenceGraph(regType);
+}
+
+void AsmRegAllocator::colorInterferenceGraph(size_t regType)
 {
     const GPUArchitecture arch = getGPUArchitectureFromDeviceType(
                     assembler.deviceType);
-    
-    for (size_t regType = 0; regType < regTypesNum; regType++)
+    const size_t maxColorsNum = getGPUMaxRegistersNum(arch, regType);
+    targetOccupancyMissed[regType] = false;
+    spilledNodes[regType].clear();
+    coalescedNodes[regType].clear();
+    size_t failedNode;
+    size_t colorsLimit = maxColorsNum;
+    if (targetOccupancy != 0)
     {
-        const size_t maxColorsNum = getGPUMaxRegistersNum(arch, regType);
-        InterGraph& interGraph = interGraphs[regType];
-        const VarIndexMap& vregIndexMap = vregIndexMaps[regType];
-        Array<cxuint>& gcMap = graphColorMaps[regType];
-        
-        const size_t nodesNum = interGraph.size();
-        gcMap.resize(nodesNum);
-        std::fill(gcMap.begin(), gcMap.end(), cxuint(UINT_MAX));
-        Array<size_t> sdoCounts(nodesNum);
-        std::fill(sdoCounts.begin(), sdoCounts.end(), 0);
-        
-        SDOLDOCompare compare(interGraph, sdoCounts);
-        std::set<size_t, SDOLDOCompare> nodeSet(compare);
-        for (size_t i = 0; i < nodesNum; i++)
-            nodeSet.insert(i);
-        
-        cxuint colorsNum = 0;
-        // firstly, allocate real registers
-        for (const auto& entry: vregIndexMap)
-            if (entry.first.regVar == nullptr)
-                gcMap[entry.second[0]] = colorsNum++;
-        
-        for (size_t colored = 0; colored < nodesNum; colored++)
+        // registers for target waves (extra registers like VCC are not colors)
+        colorsLimit = getGPUMaxRegsNumForWaves(arch, regType, targetOccupancy);
+        if (regType == REGTYPE_SGPR)
+            colorsLimit -= std::min(size_t(getGPUExtraRegsNum(arch, regType, GCN_VCC)),
+                        colorsLimit);
+        colorsLimit = std::min(colorsLimit, maxColorsNum);
+    }
+    if ((assembler.flags & ASM_COALESCE) != 0 && coalesceCopies(regType, colorsLimit))
+    {
+        InterGraph origGraph = interGraphs[regType];
+        interGraphs[regType].contract(coalescedNodes[regType]);
+        if (colorInterferenceGraph(regType, colorsLimit, failedNode))
+            return;
+        // coalesced graph needs more registers, use original graph
+        interGraphs[regType] = std::move(origGraph);
+        coalescedNodes[regType].clear();
+    }
+    if (colorsLimit < maxColorsNum)
+    {
+        if (colorInterferenceGraph(regType, colorsLimit, failedNode))
+            return;
+        // target occupancy can not be reached, use all registers
+        targetOccupancyMissed[regType] = true;
+    }
+    if (colorInterferenceGraph(regType, maxColorsNum, failedNode))
+        return;
+    // all registers are not enough, spill some register variables
+    if (regType == REGTYPE_VGPR && !spillScratch.defined)
+        throw AsmException("Too many register is needed "
+                    "(scratch buffer to spill VGPRs is not defined)");
+    if (!spillAndColorInterferenceGraph(regType, maxColorsNum))
+        throw AsmException("Too many register is needed");
+}
+
+void AsmRegAllocator::collectLinearGroup(size_t regType, size_t node,
+            std::vector<std::pair<size_t, cxuint> >& group, cxuint& groupAlign) const
+{
+    const LinearDepMap& linearDepMap = linearDepMaps[regType];
+    group.clear();
+    groupAlign = 1;
+    int64_t minPos = 0;
+    std::unordered_map<size_t, int64_t> groupPoses;
+    groupPoses.insert(std::make_pair(node, int64_t(0)));
+    std::vector<size_t> stack;
+    stack.push_back(node);
+    while (!stack.empty())
+    {
+        const size_t cur = stack.back();
+        stack.pop_back();
+        auto ldit = linearDepMap.find(cur);
+        if (ldit == linearDepMap.end())
+            continue;
+        const int64_t curPos = groupPoses.find(cur)->second;
+        auto visit = [&](size_t next, int64_t nextPos)
         {
-            size_t node = *nodeSet.begin();
-            if (gcMap[node] != UINT_MAX)
-                continue; // already colored
-            size_t color = 0;
-            
-            for (color = 0; color <= colorsNum; color++)
+            auto res = groupPoses.insert(std::make_pair(next, nextPos));
+            if (!res.second)
             {
-                // find first usable color
-                bool thisSame = false;
-                for (size_t nb: interGraph[node])
-                    if (gcMap[nb] == color)
-                    {
-                        thisSame = true;
-                        break;
-                    }
-                if (!thisSame)
-                    break;
+                if (res.first->second != nextPos)
+                    throw AsmException("Inconsistent linear dependencies "
+                                "between register variables");
+                return;
             }
-            if (color==colorsNum) // add new color if needed
+            minPos = std::min(minPos, nextPos);
+            stack.push_back(next);
+        };
+        for (size_t prev: ldit->second.prevVidxes)
+            visit(prev, curPos-1);
+        for (size_t next: ldit->second.nextVidxes)
+            visit(next, curPos+1);
+    }
+    for (const auto& entry: groupPoses)
+    {
+        group.push_back(std::make_pair(entry.first, cxuint(entry.second-minPos)));
+        auto ldit = linearDepMap.find(entry.first);
+        if (ldit != linearDepMap.end() && ldit->second.align > 1)
+            groupAlign = std::max(groupAlign, cxuint(ldit->second.align));
+    }
+    std::sort(group.begin(), group.end());
+}
+
+bool AsmRegAllocator::colorInterferenceGraph(size_t regType, size_t maxColorsNum,
+            size_t& failedNode)
+{
+    const InterGraph& interGraph = interGraphs[regType];
+    const VarIndexMap& vregIndexMap = vregIndexMaps[regType];
+    const std::vector<bool>& spilled = spilledNodes[regType];
+    const std::vector<size_t>& reps = coalescedNodes[regType];
+    Array<cxuint>& gcMap = graphColorMaps[regType];
+    size_t regTypesNum2;
+    cxuint regRanges[MAX_REGTYPES_NUM*2];
+    assembler.isaAssembler->getRegisterRanges(regTypesNum2, regRanges);
+
+    const size_t nodesNum = interGraph.size();
+    gcMap.resize(nodesNum);
+    std::fill(gcMap.begin(), gcMap.end(), cxuint(UINT_MAX));
+    Array<size_t> sdoCounts(nodesNum);
+    std::fill(sdoCounts.begin(), sdoCounts.end(), 0);
+    auto isSpilled = [&spilled](size_t node) -> bool
+    { return !spilled.empty() && spilled[node]; };
+
+    // firstly, allocate real registers (color is register index in register type)
+    cxuint maxRealColor = 0;
+    for (const auto& entry: vregIndexMap)
+        if (entry.first.regVar == nullptr)
+        {
+            const cxuint color = entry.first.index - regRanges[regType<<1];
+            gcMap[entry.second[0]] = color;
+            maxRealColor = std::max(maxRealColor, color+1);
+        }
+
+    // colors used by neighbors of node (one bitset per node)
+    const size_t colorWords = (std::max(maxColorsNum, size_t(maxRealColor))+63)>>6;
+    Array<uint64_t> satColors(nodesNum*colorWords);
+    std::fill(satColors.begin(), satColors.end(), uint64_t(0));
+
+    // mark color in neighbors of node, returns false if node was already marked
+    auto markNeighbor = [&satColors, &sdoCounts, colorWords]
+                (size_t nb, cxuint color) -> bool
+    {
+        uint64_t& word = satColors[nb*colorWords + (color>>6)];
+        const uint64_t mask = 1ULL<<(color&63);
+        if ((word & mask) != 0)
+            return false;
+        word |= mask;
+        sdoCounts[nb]++;
+        return true;
+    };
+    auto isColorUsed = [&satColors, colorWords](size_t node, size_t color) -> bool
+    { return (satColors[node*colorWords + (color>>6)] & (1ULL<<(color&63))) != 0; };
+
+    for (size_t node = 0; node < nodesNum; node++)
+        if (gcMap[node] != UINT_MAX)
+        {
+            const cxuint color = gcMap[node];
+            interGraph.forEachNeighbor(node, [&markNeighbor, color](size_t nb)
+                    { markNeighbor(nb, color); });
+        }
+    // registers of scratch buffer (used by spill code) are reserved
+    if (regType == REGTYPE_SGPR && spillScratch.defined)
+        for (size_t node = 0; node < nodesNum; node++)
+            if (gcMap[node] == UINT_MAX)
             {
-                if (colorsNum >= maxColorsNum)
-                    throw AsmException("Too many register is needed");
-                colorsNum++;
+                for (cxuint c = spillScratch.rsrcReg; c < spillScratch.rsrcReg+4; c++)
+                    if (c < (colorWords<<6))
+                        markNeighbor(node, c);
+                if (spillScratch.offsetReg < (colorWords<<6))
+                    markNeighbor(node, spillScratch.offsetReg);
             }
-            
-            gcMap[node] = color;
-            // update SDO for node
-            bool colorExists = false;
-            for (size_t nb: interGraph[node])
-                if (gcMap[nb] == color)
+
+    SDOLDOCompare compare(interGraph, sdoCounts);
+    std::set<size_t, SDOLDOCompare> nodeSet(compare);
+    // coalesced nodes get color of their representative
+    for (size_t i = 0; i < nodesNum; i++)
+        if (gcMap[i] == UINT_MAX && !isSpilled(i) && (reps.empty() || reps[i] == i))
+            nodeSet.insert(i);
+
+    // group of linearly dependent nodes: node and position in group
+    std::vector<std::pair<size_t, cxuint> > group;
+    while (!nodeSet.empty())
+    {
+        const size_t node = *nodeSet.begin();
+
+        /* collect group of linearly dependent nodes (nodes that must be
+         * in consecutive registers) with their positions in group */
+        cxuint groupAlign = 1;
+        collectLinearGroup(regType, node, group, groupAlign);
+        size_t groupSize = 0;
+        for (const auto& entry: group)
+            groupSize = std::max(groupSize, size_t(entry.second)+1);
+
+        for (const auto& entry: group)
+            if (gcMap[entry.first] != UINT_MAX)
+                throw AsmException("Register variable is linearly dependent from "
+                            "register or allocated register variable");
+        // nodes in this same position must not interfere
+        for (size_t i = 0; i < group.size(); i++)
+            for (size_t j = i+1; j < group.size(); j++)
+                if (group[i].second == group[j].second &&
+                    interGraph.interferes(group[i].first, group[j].first))
+                    throw AsmException("Register variables in this same position "
+                                "of linear dependency interferes");
+
+        // find first free and aligned range of colors for group
+        size_t color = SIZE_MAX;
+        for (size_t c = 0; c + groupSize <= maxColorsNum; c += groupAlign)
+        {
+            bool free = true;
+            for (const auto& entry: group)
+                if (isColorUsed(entry.first, c + entry.second))
                 {
-                    colorExists = true;
+                    free = false;
                     break;
                 }
-            if (!colorExists)
-                sdoCounts[node]++;
-            // update SDO for neighbors
-            for (size_t nb: interGraph[node])
+            if (free)
             {
-                colorExists = false;
-                for (size_t nb2: interGraph[nb])
-                    if (gcMap[nb2] == color)
-                    {
-                        colorExists = true;
-                        break;
-                    }
-                if (!colorExists)
-                {
-                    if (gcMap[nb] == UINT_MAX)
-                        nodeSet.erase(nb);  // before update we erase from nodeSet
-                    sdoCounts[nb]++;
-                    if (gcMap[nb] == UINT_MAX)
-                        nodeSet.insert(nb); // after update, insert again
-                }
+                color = c;
+                break;
             }
-            
-            gcMap[node] = color;
+        }
+        if (color == SIZE_MAX)
+        {
+            failedNode = node;
+            return false;
+        }
+
+        // before update we erase from nodeSet
+        for (const auto& entry: group)
+            nodeSet.erase(entry.first);
+        for (const auto& entry: group)
+            gcMap[entry.first] = color + entry.second;
+        // update SDO for uncolored neighbors
+        for (const auto& entry: group)
+        {
+            const cxuint ncolor = color + entry.second;
+            interGraph.forEachNeighbor(entry.first, [&](size_t nb)
+            {
+                if (gcMap[nb] != UINT_MAX || isSpilled(nb) || isColorUsed(nb, ncolor))
+                    return;
+                nodeSet.erase(nb);  // before update we erase from nodeSet
+                markNeighbor(nb, ncolor);
+                nodeSet.insert(nb); // after update, insert again
+            });
         }
     }
+    if (!reps.empty())
+        for (size_t i = 0; i < nodesNum; i++)
+            gcMap[i] = gcMap[reps[i]];
+    return true;
 }
 
-void AsmRegAllocator::allocateRegisters(AsmSectionId sectionId)
+/* conservative coalescing: copy-related nodes that do not interfere are merged
+ * if merged node has less than K neighbors of significant degree (Briggs)
+ * or if every neighbor of one node interferes with other node or has insignificant
+ * degree (George). Real registers and linearly dependent nodes are not merged.
+ * Copies in deeper loops are coalesced first */
+bool AsmRegAllocator::coalesceCopies(size_t regType, size_t colorsNum)
+{
+    const std::vector<CopyInstr>& copies = copyInstrs[regType];
+    const InterGraph& interGraph = interGraphs[regType];
+    const size_t nodesNum = interGraph.size();
+    std::vector<size_t>& reps = coalescedNodes[regType];
+    reps.clear();
+    if (copies.empty())
+        return false;
+    
+    std::vector<bool> fixedNodes(nodesNum, false);
+    for (const auto& entry: vregIndexMaps[regType])
+        if (entry.first.regVar == nullptr)
+            fixedNodes[entry.second[0]] = true;
+    for (const auto& entry: linearDepMaps[regType])
+        fixedNodes[entry.first] = true;
+    
+    // sorted neighbors of merged nodes
+    std::vector<std::vector<size_t> > nbs(nodesNum);
+    for (size_t node = 0; node < nodesNum; node++)
+        interGraph.forEachNeighbor(node, [&nbs, node](size_t nb)
+                { nbs[node].push_back(nb); });
+    std::vector<size_t> parents(nodesNum);
+    for (size_t node = 0; node < nodesNum; node++)
+        parents[node] = node;
+    auto findRep = [&parents](size_t node) -> size_t
+    {
+        while (parents[node] != node)
+            node = parents[node] = parents[parents[node]];
+        return node;
+    };
+    auto isNeighbor = [&nbs](size_t node, size_t nb) -> bool
+    { return std::binary_search(nbs[node].begin(), nbs[node].end(), nb); };
+    // George test: every neighbor of b interferes with a or has insignificant degree
+    auto georgeTest = [&nbs, &isNeighbor, colorsNum](size_t a, size_t b) -> bool
+    {
+        for (size_t t: nbs[b])
+            if (nbs[t].size() >= colorsNum && !isNeighbor(a, t))
+                return false;
+        return true;
+    };
+    
+    std::vector<size_t> order(copies.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&copies](size_t i1, size_t i2)
+            { return copies[i1].weight > copies[i2].weight; });
+    
+    bool merged = false;
+    std::vector<size_t> unionNbs;
+    for (size_t ci: order)
+    {
+        size_t a = findRep(copies[ci].dstNode);
+        size_t b = findRep(copies[ci].srcNode);
+        if (a == b || fixedNodes[a] || fixedNodes[b] || isNeighbor(a, b))
+            continue;
+        unionNbs.clear();
+        std::set_union(nbs[a].begin(), nbs[a].end(), nbs[b].begin(), nbs[b].end(),
+                    std::back_inserter(unionNbs));
+        // Briggs test: neighbors of both nodes lose one neighbor after merging
+        size_t significantNum = 0;
+        for (size_t t: unionNbs)
+        {
+            size_t degree = nbs[t].size();
+            if (isNeighbor(a, t) && isNeighbor(b, t))
+                degree--;
+            if (degree >= colorsNum)
+                significantNum++;
+        }
+        if (significantNum >= colorsNum && !georgeTest(a, b) && !georgeTest(b, a))
+            continue;
+        
+        // merge b into a (lower node is representative)
+        if (b < a)
+            std::swap(a, b);
+        parents[b] = a;
+        for (size_t t: nbs[b])
+        {
+            std::vector<size_t>& tnbs = nbs[t];
+            tnbs.erase(std::lower_bound(tnbs.begin(), tnbs.end(), b));
+            auto it = std::lower_bound(tnbs.begin(), tnbs.end(), a);
+            if (it == tnbs.end() || *it != a)
+                tnbs.insert(it, a);
+        }
+        nbs[a].swap(unionNbs);
+        nbs[b].clear();
+        merged = true;
+    }
+    if (!merged)
+        return false;
+    reps.resize(nodesNum);
+    for (size_t node = 0; node < nodesNum; node++)
+        reps[node] = findRep(node);
+    return true;
+}
+
+/* spilling (spill everywhere): spilled register variable lives in memory
+ * (SGPR in lane of VGPR, VGPR in scratch buffer) and it is loaded to temporary
+ * register before every read and stored after every write. Temporary registers
+ * are placed at end of register range, hence graph is colored with remaining registers.
+ * If graph can not be colored, then linear group with smallest ratio of spill cost
+ * to degree is choosen from failed node and its colored neighbors and spilled. */
+bool AsmRegAllocator::spillAndColorInterferenceGraph(size_t regType, size_t maxColorsNum)
+{
+    const InterGraph& interGraph = interGraphs[regType];
+    const VarIndexMap& vregIndexMap = vregIndexMaps[regType];
+    const Array<uint64_t>& costs = spillCosts[regType];
+    const size_t nodesNum = interGraph.size();
+    size_t regTypesNum2;
+    cxuint regRanges[MAX_REGTYPES_NUM*2];
+    assembler.isaAssembler->getRegisterRanges(regTypesNum2, regRanges);
+
+    // temporary registers for spilled register variables
+    const size_t tempsNum = (size_t(spillTempsNums[regType])+3) & ~size_t(3);
+    if (tempsNum >= maxColorsNum)
+        return false;
+    const size_t tempBase = (maxColorsNum - tempsNum) & ~size_t(3);
+    spillTempBases[regType] = tempBase;
+
+    // real registers can not be spilled and can not be in temporary registers
+    std::vector<bool> realNodes(nodesNum, false);
+    for (const auto& entry: vregIndexMap)
+        if (entry.first.regVar == nullptr)
+        {
+            if (entry.first.index - regRanges[regType<<1] >= tempBase)
+                return false;
+            realNodes[entry.second[0]] = true;
+        }
+    if (regType == REGTYPE_SGPR && spillScratch.defined &&
+        (spillScratch.rsrcReg+4 > tempBase || spillScratch.offsetReg >= tempBase))
+        return false;
+
+    std::vector<bool>& spilled = spilledNodes[regType];
+    spilled.assign(nodesNum, false);
+    std::vector<std::pair<size_t, cxuint> > group;
+    std::vector<size_t> candidates;
+    size_t failedNode;
+    while (!colorInterferenceGraph(regType, tempBase, failedNode))
+    {
+        const Array<cxuint>& gcMap = graphColorMaps[regType];
+        // candidates: failed node and its colored neighbors
+        candidates.clear();
+        candidates.push_back(failedNode);
+        interGraph.forEachNeighbor(failedNode, [&](size_t nb)
+        {
+            if (gcMap[nb] != UINT_MAX && !realNodes[nb])
+                candidates.push_back(nb);
+        });
+
+        // choose group with smallest cost/(degree+1)
+        size_t bestNode = SIZE_MAX;
+        uint64_t bestCost = 0, bestDegree = 0;
+        for (size_t cand: candidates)
+        {
+            cxuint groupAlign;
+            collectLinearGroup(regType, cand, group, groupAlign);
+            uint64_t cost = 0, degree = 0;
+            bool canBeSpilled = true;
+            for (const auto& entry: group)
+            {
+                if (realNodes[entry.first])
+                    canBeSpilled = false;
+                cost += costs[entry.first];
+                degree += interGraph.degree(entry.first);
+            }
+            if (!canBeSpilled)
+                continue;
+            if (bestNode == SIZE_MAX ||
+                cost*(bestDegree+1) < bestCost*(degree+1))
+            {
+                bestNode = cand;
+                bestCost = cost;
+                bestDegree = degree;
+            }
+        }
+        if (bestNode == SIZE_MAX)
+            return false;
+
+        cxuint groupAlign;
+        collectLinearGroup(regType, bestNode, group, groupAlign);
+        for (const auto& entry: group)
+            spilled[entry.first] = true;
+    }
+    return true;
+}
+
+/* get SSA id index of register of usage in code block
+ * (every write with SSA increments SSA id index) */
+static size_t getUsageSSAIdIdx(const AsmRegVarUsage& rvu, const AsmSingleVReg& svreg,
+            SVRegMap& ssaIdIdxMap, SVRegMap& svregWriteOffsets)
+{
+    if (checkWriteWithSSA(rvu))
+    {
+        svregWriteOffsets[svreg] = rvu.offset;
+        return ++ssaIdIdxMap[svreg];
+    }
+    size_t ssaIdIdx = ssaIdIdxMap.insert({ svreg, 0 }).first->second;
+    auto swit = svregWriteOffsets.find(svreg);
+    if (swit != svregWriteOffsets.end() && swit->second == rvu.offset)
+        ssaIdIdx--; // before this write
+    return ssaIdIdx;
+}
+
+// get graph node for SSA id index of register in code block (SIZE_MAX if not found)
+static size_t getUsageNode(const AsmRegAllocator::CodeBlock& cblock,
+            const AsmRegAllocator::VarIndexMap& vregIndexMap,
+            const AsmSingleVReg& svreg, size_t ssaIdIdx)
+{
+    auto ssaInfoIt = binaryMapFind(cblock.ssaInfoMap.begin(),
+                cblock.ssaInfoMap.end(), svreg);
+    auto vidxIt = vregIndexMap.find(svreg);
+    if (ssaInfoIt == cblock.ssaInfoMap.end() || vidxIt == vregIndexMap.end())
+        return SIZE_MAX;
+    const AsmRegAllocator::SSAInfo& ssaInfo = ssaInfoIt->second;
+    size_t ssaId;
+    if (ssaIdIdx==0)
+        ssaId = ssaInfo.ssaIdBefore;
+    else if (ssaIdIdx==1)
+        ssaId = ssaInfo.ssaIdFirst;
+    else if (ssaIdIdx<ssaInfo.ssaIdChange)
+        ssaId = ssaInfo.ssaId + ssaIdIdx-1;
+    else // last
+        ssaId = ssaInfo.ssaIdLast;
+    if (ssaId >= vidxIt->second.size())
+        return SIZE_MAX;
+    return vidxIt->second[ssaId];
+}
+
+// alignment of temporary registers for spilled register variable
+static inline cxuint getSpillTempAlign(size_t regType, cxuint regsNum)
+{
+    if (regType != REGTYPE_SGPR)
+        return 1;
+    return regsNum >= 4 ? 4 : (regsNum == 2 ? 2 : 1);
+}
+
+void AsmRegAllocator::computeSpillCosts(ISAUsageHandler& usageHandler,
+            const cxbyte* code, size_t codeSize)
+{
+    ISAAssembler* isaAsm = assembler.isaAssembler;
+    for (size_t regType = 0; regType < regTypesNum; regType++)
+    {
+        spillCosts[regType].resize(graphVregsCounts[regType]);
+        std::fill(spillCosts[regType].begin(), spillCosts[regType].end(), uint64_t(0));
+        spillTempsNums[regType] = 0;
+        copyInstrs[regType].clear();
+    }
+    
+    /* copy: instruction that only writes single register variable and reads
+     * single register variable of this same type (without other usages) */
+    size_t instrUsagesNum = 0;
+    cxuint copyRegType = UINT_MAX;
+    size_t copyDstNode = SIZE_MAX, copySrcNode = SIZE_MAX;
+    auto pushCopy = [&](size_t offset, uint64_t weight)
+    {
+        if (offset != SIZE_MAX && instrUsagesNum == 2 && copyRegType != UINT_MAX &&
+            copyDstNode != SIZE_MAX && copySrcNode != SIZE_MAX &&
+            isaAsm->isCopyInstr(codeSize - offset, code + offset))
+            copyInstrs[copyRegType].push_back({ offset, copyDstNode, copySrcNode,
+                        weight });
+        instrUsagesNum = 0;
+        copyRegType = UINT_MAX;
+        copyDstNode = copySrcNode = SIZE_MAX;
+    };
+
+    // temporary registers needed by current instruction
+    cxuint instrTemps[MAX_REGTYPES_NUM];
+    for (size_t bi = 0; bi < codeBlocks.size(); bi++)
+    {
+        const CodeBlock& cblock = codeBlocks[bi];
+        // every usage inside loop is weighted by 10^(loop depth)
+        uint64_t weight = 1;
+        const cxuint loopDepth = (bi < loopDepths.size()) ? loopDepths[bi] : 0;
+        for (cxuint d = std::min(loopDepth, 6U); d > 0; d--)
+            weight *= 10;
+
+        std::fill(instrTemps, instrTemps+MAX_REGTYPES_NUM, 0);
+        size_t instrOffset = SIZE_MAX;
+        ISAUsageHandler::ReadPos usagePos = cblock.usagePos;
+        SVRegMap ssaIdIdxMap;
+        SVRegMap svregWriteOffsets;
+        while (usageHandler.hasNext(usagePos))
+        {
+            const AsmRegVarUsage rvu = usageHandler.nextUsage(usagePos);
+            if (rvu.offset >= cblock.end)
+                break;
+            if (rvu.offset != instrOffset)
+            {
+                // next instruction
+                for (size_t r = 0; r < regTypesNum; r++)
+                    spillTempsNums[r] = std::max(spillTempsNums[r], instrTemps[r]);
+                std::fill(instrTemps, instrTemps+MAX_REGTYPES_NUM, 0);
+                pushCopy(instrOffset, weight);
+                instrOffset = rvu.offset;
+            }
+            instrUsagesNum++;
+            if (rvu.regVar == nullptr)
+                continue;
+
+            const cxuint regType = rvu.regVar->type;
+            for (uint16_t rindex = rvu.rstart; rindex < rvu.rend; rindex++)
+            {
+                AsmSingleVReg svreg{ rvu.regVar, rindex };
+                const size_t ssaIdIdx = getUsageSSAIdIdx(rvu, svreg, ssaIdIdxMap,
+                            svregWriteOffsets);
+                const size_t node = getUsageNode(cblock, vregIndexMaps[regType],
+                            svreg, ssaIdIdx);
+                if (node != SIZE_MAX)
+                    spillCosts[regType][node] += weight;
+                if (rvu.rend - rvu.rstart != 1 || (copyRegType != UINT_MAX &&
+                            copyRegType != regType))
+                    continue;
+                copyRegType = regType;
+                if (checkWriteWithSSA(rvu))
+                    copyDstNode = node;
+                else if (rvu.rwFlags == ASMRVU_READ && rvu.regField != ASMFIELD_NONE)
+                    copySrcNode = node;
+            }
+            const cxuint regsNum = rvu.rend - rvu.rstart;
+            const cxuint align = getSpillTempAlign(regType, regsNum);
+            instrTemps[regType] = ((instrTemps[regType] + align-1) & ~(align-1)) + regsNum;
+        }
+        for (size_t r = 0; r < regTypesNum; r++)
+            spillTempsNums[r] = std::max(spillTempsNums[r], instrTemps[r]);
+        pushCopy(instrOffset, weight);
+    }
+}
+
+void AsmRegAllocator::prepareAllocation(AsmSectionId sectionId)
 {
     // before any operation, clear all
     codeBlocks.clear();
+    loopDepths.clear();
     for (size_t i = 0; i < MAX_REGTYPES_NUM; i++)
     {
         graphVregsCounts[i] = 0;
@@ -737,17 +1339,398 @@ void AsmRegAllocator::allocateRegisters(AsmSectionId sectionId)
         interGraphs[i].clear();
         linearDepMaps[i].clear();
         graphColorMaps[i].clear();
+        spillCosts[i].clear();
+        spilledNodes[i].clear();
+        spillTempsNums[i] = spillTempBases[i] = 0;
+        copyInstrs[i].clear();
+        coalescedNodes[i].clear();
     }
+    spillInstrs.clear();
+    removedInstrs.clear();
     ssaReplacesMap.clear();
     cxuint maxRegs[MAX_REGTYPES_NUM];
     assembler.isaAssembler->getMaxRegistersNum(regTypesNum, maxRegs);
-    
+
     // set up
     const AsmSection& section = assembler.sections[sectionId];
+    // target occupancy of kernel or highest target of kernels sharing code
+    targetOccupancy = 0;
+    if (section.kernelId != ASMKERN_GLOBAL)
+        targetOccupancy = assembler.kernels[section.kernelId].targetOccupancy;
+    else
+        for (const AsmKernel& kernel: assembler.kernels)
+            targetOccupancy = std::max(targetOccupancy, kernel.targetOccupancy);
+    if (targetOccupancy == 0)
+        targetOccupancy = assembler.targetOccupancy;
+    // scratch buffer for spilling of kernel or default
+    spillScratch = assembler.spillScratch;
+    if (section.kernelId != ASMKERN_GLOBAL &&
+        assembler.kernels[section.kernelId].spillScratch.defined)
+        spillScratch = assembler.kernels[section.kernelId].spillScratch;
     createCodeStructure(section.codeFlow, section.content.size(), section.content.data());
-    createSSAData(*section.usageHandler, *section.linearDepHandler);
+    if ((assembler.flags & ASM_DOMSSA) != 0)
+        createSSADataByDominators(*section.usageHandler, *section.linearDepHandler);
+    else
+        createSSAData(*section.usageHandler, *section.linearDepHandler);
     applySSAReplaces();
-    createLivenesses(*section.usageHandler, *section.linearDepHandler);
+    if ((assembler.flags & ASM_DFLIVENESS) != 0)
+        createLivenessesByDataflow(*section.usageHandler, *section.linearDepHandler);
+    else
+        createLivenesses(*section.usageHandler, *section.linearDepHandler);
+    computeSpillCosts(*section.usageHandler, section.content.data(),
+                section.content.size());
+}
+
+void AsmRegAllocator::allocateRegisters(AsmSectionId sectionId)
+{
+    prepareAllocation(sectionId);
     createInterferenceGraph();
     colorInterferenceGraph();
 }
+
+bool AsmRegAllocator::applyAllocatedRegisters(AsmSectionId sectionId,
+            std::vector<AllocRegRange>& allocRegRanges)
+{
+    AsmSection& section = assembler.sections[sectionId];
+    ISAUsageHandler& usageHandler = *section.usageHandler;
+    ISAAssembler* isaAsm = assembler.isaAssembler;
+    size_t regTypesNum2;
+    cxuint regRanges[MAX_REGTYPES_NUM*2];
+    isaAsm->getRegisterRanges(regTypesNum2, regRanges);
+    const GPUArchitecture arch = getGPUArchitectureFromDeviceType(
+                    assembler.deviceType);
+    bool good = true;
+    spillInstrs.clear();
+    spillScratchSize = 0;
+
+    // spill slots of spilled nodes (lanes of spill VGPRs or dwords in scratch)
+    std::vector<cxuint> spillSlots[MAX_REGTYPES_NUM];
+    cxuint spillSlotsNums[MAX_REGTYPES_NUM];
+    for (size_t r = 0; r < regTypesNum; r++)
+    {
+        spillSlotsNums[r] = 0;
+        if (spilledNodes[r].empty())
+            continue;
+        spillSlots[r].resize(spilledNodes[r].size(), UINT_MAX);
+        for (size_t node = 0; node < spilledNodes[r].size(); node++)
+            if (spilledNodes[r][node])
+                spillSlots[r][node] = spillSlotsNums[r]++;
+    }
+    // spilled SGPRs are held in lanes of first free VGPRs
+    cxuint spillVGPR = 0;
+    cxuint spillVGPRsNum = 0;
+    if (spillSlotsNums[REGTYPE_SGPR] != 0)
+    {
+        for (cxuint color: graphColorMaps[REGTYPE_VGPR])
+            if (color != UINT_MAX)
+                spillVGPR = std::max(spillVGPR, color+1);
+        spillVGPRsNum = (spillSlotsNums[REGTYPE_SGPR]+63)>>6;
+        const cxuint vgprsLimit = !spilledNodes[REGTYPE_VGPR].empty() ?
+                spillTempBases[REGTYPE_VGPR] : getGPUMaxRegistersNum(arch, REGTYPE_VGPR);
+        if (spillVGPR + spillVGPRsNum > vgprsLimit)
+        {
+            assembler.printError(AsmSourcePos(), "No free VGPRs to spill SGPRs");
+            return false;
+        }
+    }
+    if (spillSlotsNums[REGTYPE_VGPR] > 1024)
+    {
+        assembler.printError(AsmSourcePos(), "Too many spilled VGPRs");
+        return false;
+    }
+    // every spilled VGPR takes one dword in scratch of lane
+    spillScratchSize = size_t(spillSlotsNums[REGTYPE_VGPR])<<2;
+    // jumps (spilled register can not be saved after jump)
+    std::unordered_set<size_t> jumpOffsets;
+    for (const AsmCodeFlowEntry& entry: section.codeFlow)
+        if (entry.type == AsmCodeFlowType::JUMP || entry.type == AsmCodeFlowType::CJUMP ||
+            entry.type == AsmCodeFlowType::CALL || entry.type == AsmCodeFlowType::RETURN)
+            jumpOffsets.insert(entry.offset);
+
+    for (const CodeBlock& cblock: codeBlocks)
+    {
+        ISAUsageHandler::ReadPos usagePos = cblock.usagePos;
+        // SSA id indices of svregs in this code block (like in wait scheduler)
+        SVRegMap ssaIdIdxMap;
+        SVRegMap svregWriteOffsets;
+        // temporary registers used by spilled register variables in instruction
+        size_t instrOffset = SIZE_MAX;
+        cxuint instrTemps[MAX_REGTYPES_NUM];
+        while (usageHandler.hasNext(usagePos))
+        {
+            const AsmRegVarUsage rvu = usageHandler.nextUsage(usagePos);
+            if (rvu.offset >= cblock.end)
+                break;
+            if (rvu.regVar == nullptr)
+            {
+                // real registers (except special registers) are counted to usage
+                for (cxuint r = 0; r < regTypesNum2; r++)
+                    if (rvu.rstart >= regRanges[r<<1] &&
+                        rvu.rend <= regRanges[r<<1] + getGPUMaxRegistersNum(arch, r))
+                    {
+                        allocRegRanges.push_back({ rvu.offset, r,
+                                    cxuint(rvu.rend - regRanges[r<<1]) });
+                        break;
+                    }
+                continue;
+            }
+            if (rvu.offset != instrOffset)
+            {
+                std::fill(instrTemps, instrTemps+MAX_REGTYPES_NUM, 0);
+                instrOffset = rvu.offset;
+            }
+
+            const cxuint regType = rvu.regVar->type;
+            const VarIndexMap& vregIndexMap = vregIndexMaps[regType];
+            const std::vector<bool>& spilled = spilledNodes[regType];
+            cxuint rstart = UINT_MAX;
+            bool consecutive = true;
+            bool allocated = true;
+            size_t spilledNum = 0;
+            cxuint slots[16];
+            for (uint16_t rindex = rvu.rstart; rindex < rvu.rend; rindex++)
+            {
+                AsmSingleVReg svreg{ rvu.regVar, rindex };
+                const size_t ssaIdIdx = getUsageSSAIdIdx(rvu, svreg, ssaIdIdxMap,
+                            svregWriteOffsets);
+                const size_t node = getUsageNode(cblock, vregIndexMap, svreg, ssaIdIdx);
+                if (node == SIZE_MAX)
+                {
+                    allocated = false;
+                    break;
+                }
+                if (!spilled.empty() && spilled[node])
+                {
+                    // spilled register variable
+                    if (rindex-rvu.rstart < 16)
+                        slots[rindex-rvu.rstart] = spillSlots[regType][node];
+                    spilledNum++;
+                    continue;
+                }
+                const cxuint color = graphColorMaps[regType][node];
+                if (rindex == rvu.rstart)
+                    rstart = color;
+                else if (color != rstart + (rindex-rvu.rstart))
+                    consecutive = false;
+            }
+
+            if (!allocated)
+            {
+                assembler.printError(assembler.findSourcePosByOffset(sectionId,
+                            rvu.offset), "Register variable has not been allocated");
+                good = false;
+                continue;
+            }
+            const cxuint regsNum = rvu.rend - rvu.rstart;
+            if (spilledNum != 0)
+            {
+                // whole linear group is spilled, thus all registers must be spilled
+                if (spilledNum != regsNum || regsNum > 16)
+                    consecutive = false;
+                else
+                {
+                    // allocate temporary registers for this usage
+                    const cxuint align = getSpillTempAlign(regType, regsNum);
+                    const cxuint temp = (instrTemps[regType] + align-1) & ~(align-1);
+                    instrTemps[regType] = temp + regsNum;
+                    rstart = spillTempBases[regType] + temp;
+                }
+            }
+            if (!consecutive)
+            {
+                assembler.printError(assembler.findSourcePosByOffset(sectionId,
+                            rvu.offset), "Allocated registers for register variable "
+                            "are not consecutive");
+                good = false;
+                continue;
+            }
+            if (rvu.regField != ASMFIELD_NONE &&
+                !isaAsm->resolveRegVarField(section.content.data(),
+                        rvu.offset, rvu.regField, regRanges[regType<<1] + rstart))
+            {
+                assembler.printError(assembler.findSourcePosByOffset(sectionId,
+                            rvu.offset), "Register variable can not be allocated "
+                            "in this place");
+                good = false;
+                continue;
+            }
+            allocRegRanges.push_back({ rvu.offset, regType, cxuint(rstart + regsNum) });
+            if (spilledNum == 0)
+                continue;
+
+            if ((rvu.rwFlags & ASMRVU_WRITE) != 0 &&
+                jumpOffsets.find(rvu.offset) != jumpOffsets.end())
+            {
+                assembler.printError(assembler.findSourcePosByOffset(sectionId,
+                            rvu.offset), "Spilled register variable can not be "
+                            "written by jump instruction");
+                good = false;
+                continue;
+            }
+            const size_t instrAfter = rvu.offset + isaAsm->getInstructionSize(
+                    section.content.size() - rvu.offset,
+                    section.content.data() + rvu.offset);
+            // restore before read and save after write
+            for (cxuint i = 0; i < regsNum; i++)
+            {
+                const cxuint reg = regRanges[regType<<1] + rstart + i;
+                AsmSpillInstr spillInstr;
+                if (regType == REGTYPE_SGPR)
+                {
+                    spillInstr = { 0, AsmSpillType::SAVE_SGPR, reg,
+                        regRanges[REGTYPE_VGPR<<1] + spillVGPR + (slots[i]>>6),
+                        slots[i]&63, 0 };
+                    allocRegRanges.push_back({ rvu.offset, REGTYPE_VGPR,
+                                spillVGPR + spillVGPRsNum });
+                }
+                else
+                    spillInstr = { 0, AsmSpillType::SAVE_VGPR, reg,
+                        spillScratch.rsrcReg, slots[i]<<2, spillScratch.offsetReg };
+                if ((rvu.rwFlags & ASMRVU_READ) != 0)
+                {
+                    spillInstr.offset = rvu.offset;
+                    spillInstr.type = (regType == REGTYPE_SGPR) ?
+                            AsmSpillType::RESTORE_SGPR : AsmSpillType::RESTORE_VGPR;
+                    spillInstrs.push_back(spillInstr);
+                }
+                if ((rvu.rwFlags & ASMRVU_WRITE) != 0)
+                {
+                    spillInstr.offset = instrAfter;
+                    spillInstr.type = (regType == REGTYPE_SGPR) ?
+                            AsmSpillType::SAVE_SGPR : AsmSpillType::SAVE_VGPR;
+                    spillInstrs.push_back(spillInstr);
+                }
+            }
+        }
+    }
+    // copies that became moves to same register will be removed from code
+    removedInstrs.clear();
+    if ((assembler.flags & ASM_COALESCE) != 0)
+    {
+        for (size_t regType = 0; regType < regTypesNum; regType++)
+        {
+            const Array<cxuint>& gcMap = graphColorMaps[regType];
+            const std::vector<bool>& spilled = spilledNodes[regType];
+            for (const CopyInstr& copy: copyInstrs[regType])
+                if (gcMap[copy.dstNode] == gcMap[copy.srcNode] && (spilled.empty() ||
+                        (!spilled[copy.dstNode] && !spilled[copy.srcNode])))
+                    removedInstrs.push_back(copy.offset);
+        }
+        std::sort(removedInstrs.begin(), removedInstrs.end());
+    }
+    // sort by offset, save instructions (after previous instruction) first
+    std::stable_sort(spillInstrs.begin(), spillInstrs.end(),
+            [](const AsmSpillInstr& s1, const AsmSpillInstr& s2)
+            {
+                const bool save1 = s1.type == AsmSpillType::SAVE_SGPR ||
+                        s1.type == AsmSpillType::SAVE_VGPR;
+                const bool save2 = s2.type == AsmSpillType::SAVE_SGPR ||
+                        s2.type == AsmSpillType::SAVE_VGPR;
+                return s1.offset < s2.offset ||
+                    (s1.offset == s2.offset && save1 && !save2);
+            });
+    return good;
+}
+
+AsmParallelRegAllocator::AsmParallelRegAllocator(Assembler& _assembler,
+            cxuint _threadsNum) : assembler(_assembler), threadsNum(_threadsNum),
+            failedTask(SIZE_MAX), failedSectionId(ASMSECT_NONE)
+{
+    if (threadsNum == 0)
+        threadsNum = std::max(std::thread::hardware_concurrency(), 1U);
+}
+
+void AsmParallelRegAllocator::runTasks(size_t tasksNum,
+            const std::function<void(size_t)>& task)
+{
+    // exception from task will be rethrown after finishing all tasks,
+    // if many tasks failed, then exception from first task will be thrown
+    std::vector<std::exception_ptr> exceptions(tasksNum);
+    std::atomic<size_t> nextTask(0);
+    auto worker = [&]()
+    {
+        for (size_t i; (i = nextTask.fetch_add(1)) < tasksNum; )
+            try
+            { task(i); }
+            catch(...)
+            { exceptions[i] = std::current_exception(); }
+    };
+    
+    const size_t workersNum = std::min(size_t(threadsNum), tasksNum);
+    if (workersNum <= 1)
+        worker(); // in this thread
+    else
+    {
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < workersNum; i++)
+            threads.push_back(std::thread(worker));
+        worker();
+        for (std::thread& thread: threads)
+            thread.join();
+    }
+    
+    for (size_t i = 0; i < tasksNum; i++)
+        if (exceptions[i])
+        {
+            failedTask = i;
+            std::rethrow_exception(exceptions[i]);
+        }
+}
+
+void AsmParallelRegAllocator::allocateRegisters()
+{
+    std::vector<AsmSectionId> codeSectionIds;
+    for (AsmSectionId i = 0; i < assembler.sections.size(); i++)
+    {
+        const AsmSection& section = assembler.sections[i];
+        if (section.type == AsmSectionType::CODE && section.usageHandler != nullptr &&
+            section.linearDepHandler != nullptr)
+            codeSectionIds.push_back(i);
+    }
+    allocateRegisters(codeSectionIds);
+}
+
+void AsmParallelRegAllocator::allocateRegisters(
+            const std::vector<AsmSectionId>& _sectionIds)
+{
+    sectionIds = _sectionIds;
+    const size_t sectionsNum = sectionIds.size();
+    regAllocs.clear();
+    for (size_t i = 0; i < sectionsNum; i++)
+        regAllocs.push_back(std::unique_ptr<AsmRegAllocator>(
+                    new AsmRegAllocator(assembler)));
+    
+    failedSectionId = ASMSECT_NONE;
+    // first stage: code structure, SSA data and livenesses (per section)
+    try
+    {
+        runTasks(sectionsNum, [this](size_t i)
+            { regAllocs[i]->prepareAllocation(sectionIds[i]); });
+    }
+    catch(...)
+    {
+        failedSectionId = sectionIds[failedTask];
+        throw;
+    }
+    
+    // second stage: graphs for every register type (per section and register type)
+    // register types uses distinct data in AsmRegAllocator
+    std::vector<std::pair<size_t, size_t> > regTypeTasks;
+    for (size_t i = 0; i < sectionsNum; i++)
+        for (size_t r = 0; r < regAllocs[i]->getRegTypesNum(); r++)
+            regTypeTasks.push_back(std::make_pair(i, r));
+    try
+    {
+        runTasks(regTypeTasks.size(), [this, &regTypeTasks](size_t i)
+        {
+            AsmRegAllocator& regAlloc = *regAllocs[regTypeTasks[i].first];
+            regAlloc.createInterferenceGraph(regTypeTasks[i].second);
+            regAlloc.colorInterferenceGraph(regTypeTasks[i].second);
+        });
+    }
+    catch(...)
+    {
+        failedSectionId = sectionIds[regTypeTasks[failedTask].first];
+        throw;
+    }
+}
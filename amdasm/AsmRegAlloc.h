@@ -450,6 +450,20 @@ struct CLRX_INTERNAL LiveBlock
 typedef AsmRegAllocator::LinearDep LinearDep;
 typedef std::unordered_map<size_t, LinearDep> LinearDepMap;
 
+// graph of code blocks: call edges goes to routine, return edges goes from
+// routine returns to the block after call
+struct CLRX_INTERNAL CodeBlockGraph
+{
+    std::vector<std::vector<size_t> > succs;
+    std::vector<std::vector<size_t> > preds;
+};
+
+extern CLRX_INTERNAL void createCodeBlockGraph(const std::vector<CodeBlock>& codeBlocks,
+            CodeBlockGraph& graph);
+// reverse postorder of code blocks reachable from first block
+extern CLRX_INTERNAL void createReversePostOrder(const CodeBlockGraph& graph,
+            std::vector<size_t>& rpo);
+
 typedef AsmRegAllocator::InterGraph InterGraph;
 
 struct CLRX_INTERNAL SDOLDOCompare
@@ -463,9 +477,13 @@ struct CLRX_INTERNAL SDOLDOCompare
     
     bool operator()(size_t a, size_t b) const
     {
-        if (sdoCounts[a] > sdoCounts[b])
-            return true;
-        return interGraph[a].size() > interGraph[b].size();
+        if (sdoCounts[a] != sdoCounts[b])
+            return sdoCounts[a] > sdoCounts[b];
+        const size_t adeg = interGraph.degree(a);
+        const size_t bdeg = interGraph.degree(b);
+        if (adeg != bdeg)
+            return adeg > bdeg;
+        return a < b;
     }
 };
 
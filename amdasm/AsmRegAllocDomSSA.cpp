@@ -0,0 +1,496 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <CLRX/Config.h>
+#include <vector>
+#include <utility>
+#include <unordered_map>
+#include <algorithm>
+#include <CLRX/utils/Utilities.h>
+#include <CLRX/utils/Containers.h>
+#include <CLRX/amdasm/Assembler.h>
+#include "AsmInternals.h"
+#include "AsmRegAlloc.h"
+
+using namespace CLRX;
+
+/* SSA construction by dominators (Cooper, Harvey, Kennedy - "A Simple, Fast Dominance
+ * Algorithm") and iterated dominance frontiers (Cytron et al.).
+ * Phi-functions are not materialized: values joined by phi-function are merged
+ * by SSA replaces (like in createSSAData). Routines are treated as part of
+ * the control flow graph: call edges goes to routine entry and return edges goes
+ * from routine returns to the block after call. */
+
+// collect returns of routine (routine entry is 'routineBlock')
+static void findRoutineReturns(const std::vector<CodeBlock>& codeBlocks,
+            size_t routineBlock, std::vector<size_t>& returns)
+{
+    std::vector<bool> visited(codeBlocks.size(), false);
+    std::vector<size_t> stack;
+    stack.push_back(routineBlock);
+    visited[routineBlock] = true;
+    while (!stack.empty())
+    {
+        const size_t i = stack.back();
+        stack.pop_back();
+        const CodeBlock& cblock = codeBlocks[i];
+        if (cblock.haveReturn)
+        {
+            returns.push_back(i);
+            continue;
+        }
+        auto pushNext = [&codeBlocks, &visited, &stack](size_t next)
+        {
+            if (next < codeBlocks.size() && !visited[next])
+            {
+                visited[next] = true;
+                stack.push_back(next);
+            }
+        };
+        for (const NextBlock& next: cblock.nexts)
+            if (!next.isCall)
+                pushNext(next.block);
+        /* nested calls are skipped: go to block after call
+         * (block with end, for example with unconditional jump, have no next block) */
+        if (!cblock.haveEnd && (cblock.haveCalls || cblock.nexts.empty()))
+            pushNext(i+1);
+    }
+}
+
+void CLRX::createCodeBlockGraph(const std::vector<CodeBlock>& codeBlocks,
+            CodeBlockGraph& cfg)
+{
+    const size_t blocksNum = codeBlocks.size();
+    cfg.succs.assign(blocksNum, std::vector<size_t>());
+    cfg.preds.assign(blocksNum, std::vector<size_t>());
+    std::unordered_map<size_t, std::vector<size_t> > routineReturns;
+
+    for (size_t i = 0; i < blocksNum; i++)
+    {
+        const CodeBlock& cblock = codeBlocks[i];
+        std::vector<size_t>& succs = cfg.succs[i];
+        bool haveRetPaths = false;
+        for (const NextBlock& next: cblock.nexts)
+        {
+            succs.push_back(next.block);
+            if (!next.isCall)
+                continue;
+            auto res = routineReturns.insert({ next.block, std::vector<size_t>() });
+            if (res.second)
+                findRoutineReturns(codeBlocks, next.block, res.first->second);
+            // return edges from routine to block after call
+            if (i+1 < blocksNum)
+                for (size_t retBlock: res.first->second)
+                {
+                    cfg.succs[retBlock].push_back(i+1);
+                    haveRetPaths = true;
+                }
+        }
+        if (i+1 < blocksNum && ((cblock.haveCalls && !haveRetPaths) ||
+                (cblock.nexts.empty() && !cblock.haveReturn && !cblock.haveEnd)))
+            succs.push_back(i+1);
+    }
+    for (size_t i = 0; i < blocksNum; i++)
+    {
+        std::vector<size_t>& succs = cfg.succs[i];
+        std::sort(succs.begin(), succs.end());
+        succs.resize(std::unique(succs.begin(), succs.end()) - succs.begin());
+        for (size_t succ: succs)
+            cfg.preds[succ].push_back(i);
+    }
+}
+
+void CLRX::createReversePostOrder(const CodeBlockGraph& cfg, std::vector<size_t>& rpo)
+{
+    const size_t blocksNum = cfg.succs.size();
+    std::vector<bool> visited(blocksNum, false);
+    // first - block, second - next successor index
+    std::vector<std::pair<size_t, size_t> > stack;
+    stack.push_back({ 0, 0 });
+    visited[0] = true;
+    while (!stack.empty())
+    {
+        auto& entry = stack.back();
+        const std::vector<size_t>& succs = cfg.succs[entry.first];
+        if (entry.second < succs.size())
+        {
+            const size_t next = succs[entry.second++];
+            if (!visited[next])
+            {
+                visited[next] = true;
+                stack.push_back({ next, 0 });
+            }
+        }
+        else
+        {
+            rpo.push_back(entry.first);
+            stack.pop_back();
+        }
+    }
+    std::reverse(rpo.begin(), rpo.end());
+}
+
+// compute immediate dominators (SIZE_MAX for unreachable blocks)
+static void createDominators(const CodeBlockGraph& cfg, const std::vector<size_t>& rpo,
+            std::vector<size_t>& rpoIndices, std::vector<size_t>& idoms)
+{
+    const size_t blocksNum = cfg.succs.size();
+    rpoIndices.assign(blocksNum, SIZE_MAX);
+    for (size_t i = 0; i < rpo.size(); i++)
+        rpoIndices[rpo[i]] = i;
+    idoms.assign(blocksNum, SIZE_MAX);
+    idoms[0] = 0;
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (size_t i = 1; i < rpo.size(); i++)
+        {
+            const size_t b = rpo[i];
+            size_t newIdom = SIZE_MAX;
+            for (size_t p: cfg.preds[b])
+            {
+                if (idoms[p] == SIZE_MAX)
+                    continue; // not yet processed or unreachable
+                if (newIdom == SIZE_MAX)
+                {
+                    newIdom = p;
+                    continue;
+                }
+                // intersect
+                size_t f1 = p, f2 = newIdom;
+                while (f1 != f2)
+                {
+                    while (rpoIndices[f1] > rpoIndices[f2])
+                        f1 = idoms[f1];
+                    while (rpoIndices[f2] > rpoIndices[f1])
+                        f2 = idoms[f2];
+                }
+                newIdom = f1;
+            }
+            if (idoms[b] != newIdom)
+            {
+                idoms[b] = newIdom;
+                changed = true;
+            }
+        }
+    }
+}
+
+// compute dominance frontiers
+static void createDominanceFrontiers(const CodeBlockGraph& cfg, const std::vector<size_t>& idoms,
+            std::vector<std::vector<size_t> >& frontiers)
+{
+    const size_t blocksNum = cfg.succs.size();
+    frontiers.assign(blocksNum, std::vector<size_t>());
+    for (size_t b = 0; b < blocksNum; b++)
+    {
+        if (idoms[b] == SIZE_MAX)
+            continue;
+        // first block have also implicit predecessor (start of code)
+        if (cfg.preds[b].size() + (b==0) < 2)
+            continue;
+        for (size_t p: cfg.preds[b])
+        {
+            if (idoms[p] == SIZE_MAX)
+                continue;
+            // first block is in frontier of all blocks to its predecessor
+            for (size_t runner = p; b == 0 || runner != idoms[b]; runner = idoms[runner])
+            {
+                std::vector<size_t>& df = frontiers[runner];
+                if (df.empty() || df.back() != b)
+                    df.push_back(b);
+                if (runner == 0)
+                    break;
+            }
+        }
+    }
+}
+
+// values of single regvar: union-find set of values joined by phi-functions
+struct CLRX_INTERNAL DomSSAValues
+{
+    std::vector<size_t> parents;
+    std::vector<size_t> ssaIds; // SSA id of value (SIZE_MAX for phi-function)
+    std::vector<size_t> minSSAIds; // minimal SSA id in set (only for roots)
+    size_t totalSSACount;
+
+    DomSSAValues() : totalSSACount(1)
+    {
+        // value before first write (SSA id 0)
+        parents.push_back(0);
+        ssaIds.push_back(0);
+        minSSAIds.push_back(0);
+    }
+
+    size_t addValue(size_t ssaId)
+    {
+        parents.push_back(parents.size());
+        ssaIds.push_back(ssaId);
+        minSSAIds.push_back(ssaId);
+        return parents.size()-1;
+    }
+
+    size_t find(size_t v)
+    {
+        while (parents[v] != v)
+        {
+            parents[v] = parents[parents[v]];
+            v = parents[v];
+        }
+        return v;
+    }
+
+    void join(size_t a, size_t b)
+    {
+        a = find(a);
+        b = find(b);
+        if (a == b)
+            return;
+        if (a > b)
+            std::swap(a, b);
+        parents[b] = a;
+        minSSAIds[a] = std::min(minSSAIds[a], minSSAIds[b]);
+    }
+};
+
+void AsmRegAllocator::createSSADataByDominators(ISAUsageHandler& usageHandler,
+                ISALinearDepHandler& linDepHandler)
+{
+    if (codeBlocks.empty())
+        return;
+    if (!collectSSAInfos(usageHandler))
+        return;
+
+    const size_t blocksNum = codeBlocks.size();
+    CodeBlockGraph cfg;
+    createCodeBlockGraph(codeBlocks, cfg);
+    std::vector<size_t> rpo;
+    createReversePostOrder(cfg, rpo);
+    std::vector<size_t> rpoIndices;
+    std::vector<size_t> idoms;
+    createDominators(cfg, rpo, rpoIndices, idoms);
+    std::vector<std::vector<size_t> > frontiers;
+    createDominanceFrontiers(cfg, idoms, frontiers);
+
+    // index regvars and collect blocks where regvars are used
+    std::unordered_map<AsmSingleVReg, size_t> svregIndices;
+    // first - block, second - entry index in ssaInfoMap
+    std::vector<std::vector<std::pair<size_t, size_t> > > svregBlocks;
+    // per block: svreg indices of entries in ssaInfoMap
+    std::vector<std::vector<size_t> > blockSVRegs(blocksNum);
+    for (size_t b = 0; b < blocksNum; b++)
+    {
+        CodeBlock& cblock = codeBlocks[b];
+        blockSVRegs[b].resize(cblock.ssaInfoMap.size(), SIZE_MAX);
+        for (size_t k = 0; k < cblock.ssaInfoMap.size(); k++)
+        {
+            const AsmSingleVReg& svreg = cblock.ssaInfoMap[k].first;
+            if (svreg.regVar == nullptr)
+                continue;
+            auto res = svregIndices.insert({ svreg, svregIndices.size() });
+            if (res.second)
+                svregBlocks.push_back(std::vector<std::pair<size_t, size_t> >());
+            svregBlocks[res.first->second].push_back({ b, k });
+            blockSVRegs[b][k] = res.first->second;
+        }
+    }
+
+    const size_t svregsNum = svregBlocks.size();
+    std::vector<DomSSAValues> values(svregsNum);
+    // phi-functions of blocks: first - svreg index, second - value
+    std::vector<std::vector<std::pair<size_t, size_t> > > blockPhis(blocksNum);
+
+    /* place phi-functions (pruned SSA form):
+     * phi-function is placed only if regvar is live at block start */
+    std::vector<size_t> defStamps(blocksNum, SIZE_MAX);
+    std::vector<size_t> liveStamps(blocksNum, SIZE_MAX);
+    std::vector<size_t> phiStamps(blocksNum, SIZE_MAX);
+    std::vector<size_t> addedStamps(blocksNum, SIZE_MAX);
+    std::vector<size_t> workList;
+    for (size_t sv = 0; sv < svregsNum; sv++)
+    {
+        workList.clear();
+        for (const auto& bentry: svregBlocks[sv])
+        {
+            const size_t b = bentry.first;
+            const SSAInfo& sinfo = codeBlocks[b].ssaInfoMap[bentry.second].second;
+            if (sinfo.ssaIdChange != 0)
+                defStamps[b] = sv;
+            if (sinfo.readBeforeWrite)
+            {
+                liveStamps[b] = sv;
+                workList.push_back(b);
+            }
+        }
+        // live at block start: propagate backwards through non-defining blocks
+        while (!workList.empty())
+        {
+            const size_t b = workList.back();
+            workList.pop_back();
+            for (size_t p: cfg.preds[b])
+                if (liveStamps[p] != sv && defStamps[p] != sv)
+                {
+                    liveStamps[p] = sv;
+                    workList.push_back(p);
+                }
+        }
+        // iterated dominance frontier of definitions and start of code
+        workList.clear();
+        for (const auto& bentry: svregBlocks[sv])
+            if (defStamps[bentry.first] == sv && addedStamps[bentry.first] != sv)
+            {
+                addedStamps[bentry.first] = sv;
+                workList.push_back(bentry.first);
+            }
+        if (addedStamps[0] != sv)
+        {
+            addedStamps[0] = sv;
+            workList.push_back(0);
+        }
+        while (!workList.empty())
+        {
+            const size_t x = workList.back();
+            workList.pop_back();
+            for (size_t y: frontiers[x])
+            {
+                if (phiStamps[y] == sv)
+                    continue;
+                phiStamps[y] = sv;
+                if (liveStamps[y] == sv)
+                    blockPhis[y].push_back({ sv, values[sv].addValue(SIZE_MAX) });
+                if (addedStamps[y] != sv)
+                {
+                    addedStamps[y] = sv;
+                    workList.push_back(y);
+                }
+            }
+        }
+    }
+
+    // dominator tree
+    std::vector<std::vector<size_t> > domChildren(blocksNum);
+    for (size_t b: rpo)
+        if (b != 0)
+            domChildren[idoms[b]].push_back(b);
+
+    // current values of regvars (initially value before first write)
+    std::vector<size_t> curValues(svregsNum, 0);
+    // restore log: first - svreg index, second - previous value
+    std::vector<std::pair<size_t, size_t> > restoreLog;
+    // value before block for regvars: first - block, second - entry index, value
+    std::vector<std::pair<std::pair<size_t, size_t>, size_t> > beforeValues;
+
+    /* rename: traverse dominator tree in preorder */
+    // first - block, second - next child index, third - restore log size
+    struct DomStackEntry
+    {
+        size_t block;
+        size_t nextChild;
+        size_t logSize;
+    };
+    std::vector<DomStackEntry> domStack;
+    domStack.push_back({ 0, 0, 0 });
+    while (!domStack.empty())
+    {
+        DomStackEntry& entry = domStack.back();
+        const size_t b = entry.block;
+        if (entry.nextChild == 0)
+        {
+            CodeBlock& cblock = codeBlocks[b];
+            entry.logSize = restoreLog.size();
+            for (const auto& phi: blockPhis[b])
+            {
+                restoreLog.push_back({ phi.first, curValues[phi.first] });
+                curValues[phi.first] = phi.second;
+            }
+            for (size_t k = 0; k < cblock.ssaInfoMap.size(); k++)
+            {
+                SSAInfo& sinfo = cblock.ssaInfoMap[k].second;
+                const size_t sv = blockSVRegs[b][k];
+                if (sv == SIZE_MAX)
+                {
+                    sinfo.ssaIdChange = 0; // zeroing SSA changes for registers
+                    continue;
+                }
+                DomSSAValues& svalues = values[sv];
+                beforeValues.push_back({ { b, k }, curValues[sv] });
+
+                sinfo.ssaId = svalues.totalSSACount;
+                sinfo.ssaIdFirst = sinfo.ssaIdChange!=0 ? svalues.totalSSACount : SIZE_MAX;
+                svalues.totalSSACount += sinfo.ssaIdChange;
+                sinfo.ssaIdLast = sinfo.ssaIdChange!=0 ?
+                            svalues.totalSSACount-1 : SIZE_MAX;
+                if (sinfo.ssaIdChange != 0)
+                {
+                    restoreLog.push_back({ sv, curValues[sv] });
+                    curValues[sv] = svalues.addValue(sinfo.ssaIdLast);
+                }
+            }
+            /* join phi-functions of successors with current values
+             * (value before first write is undefined, it is not joined) */
+            for (size_t succ: cfg.succs[b])
+                for (const auto& phi: blockPhis[succ])
+                    if (curValues[phi.first] != 0)
+                        values[phi.first].join(phi.second, curValues[phi.first]);
+        }
+        if (entry.nextChild < domChildren[b].size())
+        {
+            const size_t child = domChildren[b][entry.nextChild++];
+            domStack.push_back({ child, 0, 0 });
+        }
+        else
+        {
+            // restore values of regvars from dominator
+            for (size_t i = restoreLog.size(); i > entry.logSize; i--)
+                curValues[restoreLog[i-1].first] = restoreLog[i-1].second;
+            restoreLog.resize(entry.logSize);
+            domStack.pop_back();
+        }
+    }
+
+    // resolve values before blocks
+    for (const auto& bv: beforeValues)
+    {
+        const size_t sv = blockSVRegs[bv.first.first][bv.first.second];
+        DomSSAValues& svalues = values[sv];
+        const size_t minSSAId = svalues.minSSAIds[svalues.find(bv.second)];
+        codeBlocks[bv.first.first].ssaInfoMap[bv.first.second].second.ssaIdBefore =
+                (minSSAId != SIZE_MAX) ? minSSAId : 0;
+    }
+
+    // SSA replaces: joined SSA ids are replaced by minimal SSA id in set
+    for (const auto& svEntry: svregIndices)
+    {
+        DomSSAValues& svalues = values[svEntry.second];
+        for (size_t v = 1; v < svalues.parents.size(); v++)
+        {
+            const size_t ssaId = svalues.ssaIds[v];
+            if (ssaId == SIZE_MAX)
+                continue;
+            const size_t minSSAId = svalues.minSSAIds[svalues.find(v)];
+            if (ssaId != minSSAId)
+            {
+                ARDOut << "  domreplace: " << svEntry.first.regVar << ":" <<
+                        svEntry.first.index << ": " << ssaId << ", " << minSSAId << "\n";
+                ssaReplacesMap[svEntry.first].insertValue({ ssaId, minSSAId });
+            }
+        }
+    }
+}
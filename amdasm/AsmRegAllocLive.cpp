@@ -1186,28 +1186,11 @@ static void createRoutineDataLv(LivenessState& ls, RoutineDataLv& rdata,
     }
 }
 
-static inline void revertLastSVReg(LastVRegMap& lastVRegMap, const AsmSingleVReg& svreg)
-{
-    auto lvrit = lastVRegMap.find(svreg);
-    if (lvrit != lastVRegMap.end())
-    {
-        std::vector<LastVRegStackPos>& lastPos = lvrit->second;
-        lastPos.pop_back();
-        if (lastPos.empty()) // just remove from lastVRegs
-            lastVRegMap.erase(lvrit);
-    }
-}
-
-void AsmRegAllocator::createLivenesses(ISAUsageHandler& usageHandler,
-                ISALinearDepHandler& linDepHandler)
+// create var index maps: key - svreg, value - vidxes (graph var indices) of SSA ids
+static void createVarIndexMaps(const std::vector<CodeBlock>& codeBlocks,
+            size_t regTypesNum, const cxuint* regRanges, VarIndexMap* vregIndexMaps,
+            size_t* graphVregsCounts)
 {
-    ARDOut << "----- createLivenesses ------\n";
-    // construct var index maps
-    cxuint regRanges[MAX_REGTYPES_NUM*2];
-    std::fill(graphVregsCounts, graphVregsCounts+MAX_REGTYPES_NUM, size_t(0));
-    size_t regTypesNum;
-    assembler.isaAssembler->getRegisterRanges(regTypesNum, regRanges);
-    
     for (const CodeBlock& cblock: codeBlocks)
         for (const auto& entry: cblock.ssaInfoMap)
         {
@@ -1255,6 +1238,182 @@ void AsmRegAllocator::createLivenesses(ISAUsageHandler& usageHandler,
             if (entry.first.regVar==nullptr && vidxes[0] == SIZE_MAX)
                 vidxes[0] = graphVregsCount++;
         }
+}
+
+// move livenesses to output livenesses (as arrays of regions)
+static void moveLivenesses(size_t regTypesNum, std::vector<Liveness>* livenesses,
+            Array<AsmRegAllocator::OutLiveness>* outLivenesses)
+{
+    for (size_t regType = 0; regType < regTypesNum; regType++)
+    {
+        std::vector<Liveness>& livenesses2 = livenesses[regType];
+        Array<AsmRegAllocator::OutLiveness>& outLivenesses2 = outLivenesses[regType];
+        outLivenesses2.resize(livenesses2.size());
+        for (size_t li = 0; li < livenesses2.size(); li++)
+        {
+            outLivenesses2[li].resize(livenesses2[li].l.size());
+            std::copy(livenesses2[li].l.begin(), livenesses2[li].l.end(),
+                      outLivenesses2[li].begin());
+            livenesses2[li].clear();
+        }
+        livenesses2.clear();
+    }
+}
+
+/* create livenesses inside code block (from usages of the code block)
+ * and linear dependencies. returns number of failed linear dependencies */
+static size_t createBlockLivenesses(CodeBlock& cblock, LivenessState& ls,
+            ISAUsageHandler& usageHandler, ISALinearDepHandler& linDepHandler,
+            LinearDepMap* linearDepMaps)
+{
+    size_t failures = 0;
+    const size_t linearDepSize = linDepHandler.size();
+    SVRegMap ssaIdIdxMap;
+    std::vector<AsmRegVarUsage> instrRVUs;
+    
+    std::vector<AsmSingleVReg> readSVRegs;
+    std::vector<AsmSingleVReg> writtenSVRegs;
+    
+    ISAUsageHandler::ReadPos usagePos = cblock.usagePos;
+    size_t oldOffset = usageHandler.hasNext(usagePos) ?
+            cblock.start : cblock.end;
+    
+    size_t linearDepPos = linDepHandler.findPositionByOffset(cblock.start);
+    
+    // register in liveness
+    bool rvuFirst = true;
+    while (true)
+    {
+        AsmRegVarUsage rvu = { 0U, nullptr, 0U, 0U };
+        bool hasNext = false;
+        if (usageHandler.hasNext(usagePos) && oldOffset < cblock.end)
+        {
+            hasNext = true;
+            rvu = usageHandler.nextUsage(usagePos);
+            if (rvuFirst)
+            {
+                oldOffset = rvu.offset;
+                rvuFirst = false;
+            }
+        }
+        const size_t liveTime = oldOffset;
+        if ((!hasNext || rvu.offset > oldOffset) && oldOffset < cblock.end)
+        {
+            ARDOut << "apply to liveness. offset: " << oldOffset << "\n";
+            // apply to liveness
+            for (AsmSingleVReg svreg: readSVRegs)
+            {
+                auto svrres = ssaIdIdxMap.insert({ svreg, 0 });
+                Liveness& lv = getLiveness(svreg, svrres.first->second,
+                        binaryMapFind(cblock.ssaInfoMap.begin(),
+                            cblock.ssaInfoMap.end(), svreg)->second, ls);
+                if (svrres.second)
+                    // begin region from this block
+                    lv.insert(cblock.start, liveTime+1);
+                else
+                    lv.expand(liveTime+1);
+            }
+            for (AsmSingleVReg svreg: writtenSVRegs)
+            {
+                size_t& ssaIdIdx = ssaIdIdxMap[svreg];
+                if (svreg.regVar != nullptr)
+                    ssaIdIdx++;
+                SSAInfo& sinfo = binaryMapFind(cblock.ssaInfoMap.begin(),
+                            cblock.ssaInfoMap.end(), svreg)->second;
+                Liveness& lv = getLiveness(svreg, ssaIdIdx, sinfo, ls);
+                // works only with ISA where smallest instruction have 2 bytes!
+                // after previous read, but not after instruction.
+                // if var is not used anywhere then this liveness region
+                // blocks assignment for other vars
+                lv.insert(liveTime+1, liveTime+2);
+            }
+            
+            // collecting linear deps for instruction
+            std::vector<AsmRegVarLinearDep> instrLinDeps;
+            AsmRegVarLinearDep linDep = { 0, nullptr, 0, 0 };
+            bool haveLdep = false;
+            if (oldOffset == 0 && linearDepPos < linearDepSize)
+            {
+                // special case: if offset is zero, force get linear dep
+                linDep = linDepHandler.getLinearDep(linearDepPos++);
+                haveLdep = true;
+            }
+            while (linDep.offset < oldOffset && linearDepPos < linearDepSize)
+            {
+                linDep = linDepHandler.getLinearDep(linearDepPos++);
+                haveLdep = true;
+            }
+            // if found
+            if (haveLdep)
+                while (linDep.offset == oldOffset)
+                {
+                    // just put
+                    instrLinDeps.push_back(linDep);
+                    if (linearDepPos < linearDepSize)
+                        linDep = linDepHandler.getLinearDep(linearDepPos++);
+                    else // no data
+                        break;
+                }
+            // get linear deps and equal to
+            cxbyte lDeps[16];
+            usageHandler.getUsageDependencies(instrRVUs.size(),
+                        instrRVUs.data(), lDeps);
+            
+            if (!addUsageDeps(lDeps, instrRVUs, instrLinDeps, linearDepMaps,
+                    cblock.ssaInfoMap, ssaIdIdxMap,
+                    readSVRegs, writtenSVRegs, ls))
+                failures++;
+            
+            readSVRegs.clear();
+            writtenSVRegs.clear();
+            if (!hasNext)
+                break;
+            oldOffset = rvu.offset;
+            instrRVUs.clear();
+        }
+        if (hasNext && oldOffset < cblock.end && !rvu.useRegMode)
+            instrRVUs.push_back(rvu);
+        if (oldOffset >= cblock.end)
+            break;
+        
+        for (uint16_t rindex = rvu.rstart; rindex < rvu.rend; rindex++)
+        {
+            // per register/singlvreg
+            AsmSingleVReg svreg{ rvu.regVar, rindex };
+            if (checkWriteWithSSA(rvu))
+                writtenSVRegs.push_back(svreg);
+            else // read or treat as reading // expand previous region
+                readSVRegs.push_back(svreg);
+        }
+    }
+    return failures;
+}
+
+static inline void revertLastSVReg(LastVRegMap& lastVRegMap, const AsmSingleVReg& svreg)
+{
+    auto lvrit = lastVRegMap.find(svreg);
+    if (lvrit != lastVRegMap.end())
+    {
+        std::vector<LastVRegStackPos>& lastPos = lvrit->second;
+        lastPos.pop_back();
+        if (lastPos.empty()) // just remove from lastVRegs
+            lastVRegMap.erase(lvrit);
+    }
+}
+
+void AsmRegAllocator::createLivenesses(ISAUsageHandler& usageHandler,
+                ISALinearDepHandler& linDepHandler)
+{
+    ARDOut << "----- createLivenesses ------\n";
+    linearDepsFailures = 0;
+    // construct var index maps
+    cxuint regRanges[MAX_REGTYPES_NUM*2];
+    std::fill(graphVregsCounts, graphVregsCounts+MAX_REGTYPES_NUM, size_t(0));
+    // set up regTypesNum for next stages (interference graph and coloring)
+    assembler.isaAssembler->getRegisterRanges(regTypesNum, regRanges);
+    
+    createVarIndexMaps(codeBlocks, regTypesNum, regRanges, vregIndexMaps,
+                graphVregsCounts);
     
     // construct vreg liveness
     std::deque<CallStackEntry> callStack;
@@ -1281,10 +1440,6 @@ void AsmRegAllocator::createLivenesses(ISAUsageHandler& usageHandler,
     for (size_t i = 0; i < regTypesNum; i++)
         livenesses[i].resize(graphVregsCounts[i]);
     
-    // callLiveTime - call live time where routine will be called
-    // reverse counted, begin from SIZE_MAX, used for joining svreg from routines
-    // and svreg used in this time
-    size_t curLiveTime = 0;
     flowStack.push_back({ 0, 0 });
     
     // structure to pass many arguments in compact pack
@@ -1292,8 +1447,6 @@ void AsmRegAllocator::createLivenesses(ISAUsageHandler& usageHandler,
         prevWaysIndexMap, livenesses, vregIndexMaps, vidxCallMap, vidxRoutineMap,
         routineMap, regTypesNum, regRanges };
     
-    const size_t linearDepSize = linDepHandler.size();
-    
     while (!flowStack.empty())
     {
         FlowStackEntry3& entry = flowStack.back();
@@ -1301,7 +1454,6 @@ void AsmRegAllocator::createLivenesses(ISAUsageHandler& usageHandler,
         
         if (entry.nextIndex == 0)
         {
-            curLiveTime = cblock.start;
             // process current block
             if (!visited[entry.blockIndex])
             {
@@ -1327,124 +1479,9 @@ void AsmRegAllocator::createLivenesses(ISAUsageHandler& usageHandler,
                 }
                 
                 // main routine to handle ssaInfos
-                SVRegMap ssaIdIdxMap;
-                std::vector<AsmRegVarUsage> instrRVUs;
-                
-                std::vector<AsmSingleVReg> readSVRegs;
-                std::vector<AsmSingleVReg> writtenSVRegs;
-                
-                ISAUsageHandler::ReadPos usagePos = cblock.usagePos;
-                size_t oldOffset = usageHandler.hasNext(usagePos) ?
-                        cblock.start : cblock.end;
-                
-                size_t linearDepPos = linDepHandler.findPositionByOffset(cblock.start);
-                
-                // register in liveness
-                bool rvuFirst = true;
-                while (true)
-                {
-                    AsmRegVarUsage rvu = { 0U, nullptr, 0U, 0U };
-                    bool hasNext = false;
-                    if (usageHandler.hasNext(usagePos) && oldOffset < cblock.end)
-                    {
-                        hasNext = true;
-                        rvu = usageHandler.nextUsage(usagePos);
-                        if (rvuFirst)
-                        {
-                            oldOffset = rvu.offset;
-                            rvuFirst = false;
-                        }
-                    }
-                    const size_t liveTime = oldOffset;
-                    if ((!hasNext || rvu.offset > oldOffset) && oldOffset < cblock.end)
-                    {
-                        ARDOut << "apply to liveness. offset: " << oldOffset << "\n";
-                        // apply to liveness
-                        for (AsmSingleVReg svreg: readSVRegs)
-                        {
-                            auto svrres = ssaIdIdxMap.insert({ svreg, 0 });
-                            Liveness& lv = getLiveness(svreg, svrres.first->second,
-                                    binaryMapFind(cblock.ssaInfoMap.begin(),
-                                        cblock.ssaInfoMap.end(), svreg)->second, ls);
-                            if (svrres.second)
-                                // begin region from this block
-                                lv.insert(curLiveTime, liveTime+1);
-                            else
-                                lv.expand(liveTime+1);
-                        }
-                        for (AsmSingleVReg svreg: writtenSVRegs)
-                        {
-                            size_t& ssaIdIdx = ssaIdIdxMap[svreg];
-                            if (svreg.regVar != nullptr)
-                                ssaIdIdx++;
-                            SSAInfo& sinfo = binaryMapFind(cblock.ssaInfoMap.begin(),
-                                        cblock.ssaInfoMap.end(), svreg)->second;
-                            Liveness& lv = getLiveness(svreg, ssaIdIdx, sinfo, ls);
-                            // works only with ISA where smallest instruction have 2 bytes!
-                            // after previous read, but not after instruction.
-                            // if var is not used anywhere then this liveness region
-                            // blocks assignment for other vars
-                            lv.insert(liveTime+1, liveTime+2);
-                        }
-                        
-                        // collecting linear deps for instruction
-                        std::vector<AsmRegVarLinearDep> instrLinDeps;
-                        AsmRegVarLinearDep linDep = { 0, nullptr, 0, 0 };
-                        bool haveLdep = false;
-                        if (oldOffset == 0 && linearDepPos < linearDepSize)
-                        {
-                            // special case: if offset is zero, force get linear dep
-                            linDep = linDepHandler.getLinearDep(linearDepPos++);
-                            haveLdep = true;
-                        }
-                        while (linDep.offset < oldOffset && linearDepPos < linearDepSize)
-                        {
-                            linDep = linDepHandler.getLinearDep(linearDepPos++);
-                            haveLdep = true;
-                        }
-                        // if found
-                        if (haveLdep)
-                            while (linDep.offset == oldOffset)
-                            {
-                                // just put
-                                instrLinDeps.push_back(linDep);
-                                if (linearDepPos < linearDepSize)
-                                    linDep = linDepHandler.getLinearDep(linearDepPos++);
-                                else // no data
-                                    break;
-                            }
-                        // get linear deps and equal to
-                        cxbyte lDeps[16];
-                        usageHandler.getUsageDependencies(instrRVUs.size(),
-                                    instrRVUs.data(), lDeps);
-                        
-                        if (!addUsageDeps(lDeps, instrRVUs, instrLinDeps, linearDepMaps,
-                                cblock.ssaInfoMap, ssaIdIdxMap,
-                                readSVRegs, writtenSVRegs, ls))
-                            assembler.printError(nullptr, "Linear deps failed");
-                        
-                        readSVRegs.clear();
-                        writtenSVRegs.clear();
-                        if (!hasNext)
-                            break;
-                        oldOffset = rvu.offset;
-                        instrRVUs.clear();
-                    }
-                    if (hasNext && oldOffset < cblock.end && !rvu.useRegMode)
-                        instrRVUs.push_back(rvu);
-                    if (oldOffset >= cblock.end)
-                        break;
-                    
-                    for (uint16_t rindex = rvu.rstart; rindex < rvu.rend; rindex++)
-                    {
-                        // per register/singlvreg
-                        AsmSingleVReg svreg{ rvu.regVar, rindex };
-                        if (checkWriteWithSSA(rvu))
-                            writtenSVRegs.push_back(svreg);
-                        else // read or treat as reading // expand previous region
-                            readSVRegs.push_back(svreg);
-                    }
-                }
+                // failures will be reported by assembler (not in this thread)
+                linearDepsFailures += createBlockLivenesses(cblock, ls, usageHandler,
+                            linDepHandler, linearDepMaps);
             }
             else
             {
@@ -1666,18 +1703,197 @@ void AsmRegAllocator::createLivenesses(ISAUsageHandler& usageHandler,
     }
     
     // move livenesses to AsmRegAllocator outLivenesses
+    moveLivenesses(regTypesNum, livenesses, outLivenesses);
+}
+
+/* classic backward dataflow liveness analysis: sets of live variables (vidxes)
+ * are dense bitsets, one set per code block and register type. Livenesses
+ * inside code blocks are created from usages (like in createLivenesses),
+ * and the variables that live at end of code block are extended to its end. */
+void AsmRegAllocator::createLivenessesByDataflow(ISAUsageHandler& usageHandler,
+                ISALinearDepHandler& linDepHandler)
+{
+    ARDOut << "----- createLivenessesByDataflow ------\n";
+    linearDepsFailures = 0;
+    cxuint regRanges[MAX_REGTYPES_NUM*2];
+    std::fill(graphVregsCounts, graphVregsCounts+MAX_REGTYPES_NUM, size_t(0));
+    // set up regTypesNum for next stages (interference graph and coloring)
+    assembler.isaAssembler->getRegisterRanges(regTypesNum, regRanges);
+    createVarIndexMaps(codeBlocks, regTypesNum, regRanges, vregIndexMaps,
+                graphVregsCounts);
+    vidxRoutineMap.clear();
+    vidxCallMap.clear();
+    
+    std::vector<Liveness> livenesses[MAX_REGTYPES_NUM];
+    for (size_t i = 0; i < regTypesNum; i++)
+        livenesses[i].resize(graphVregsCounts[i]);
+    if (codeBlocks.empty())
+    {
+        moveLivenesses(regTypesNum, livenesses, outLivenesses);
+        return;
+    }
+    
+    const size_t blocksNum = codeBlocks.size();
+    CodeBlockGraph graph;
+    createCodeBlockGraph(codeBlocks, graph);
+    std::vector<size_t> rpo;
+    createReversePostOrder(graph, rpo);
+    
+    // owners of vidxes (svreg indices) to find variables accessed in code block
+    std::vector<size_t> vidxOwners[MAX_REGTYPES_NUM];
+    size_t ownersNum = 0;
     for (size_t regType = 0; regType < regTypesNum; regType++)
     {
-        std::vector<Liveness>& livenesses2 = livenesses[regType];
-        Array<OutLiveness>& outLivenesses2 = outLivenesses[regType];
-        outLivenesses2.resize(livenesses2.size());
-        for (size_t li = 0; li < livenesses2.size(); li++)
+        vidxOwners[regType].resize(graphVregsCounts[regType]);
+        for (const auto& entry: vregIndexMaps[regType])
         {
-            outLivenesses2[li].resize(livenesses2[li].l.size());
-            std::copy(livenesses2[li].l.begin(), livenesses2[li].l.end(),
-                      outLivenesses2[li].begin());
-            livenesses2[li].clear();
+            for (size_t vidx: entry.second)
+                if (vidx != SIZE_MAX)
+                    vidxOwners[regType][vidx] = ownersNum;
+            ownersNum++;
         }
-        livenesses2.clear();
     }
+    
+    // bitsets: words per code block for every register type
+    size_t setWords[MAX_REGTYPES_NUM];
+    std::vector<uint64_t> useSets[MAX_REGTYPES_NUM];
+    std::vector<uint64_t> defSets[MAX_REGTYPES_NUM];
+    std::vector<uint64_t> liveInSets[MAX_REGTYPES_NUM];
+    std::vector<uint64_t> liveOutSets[MAX_REGTYPES_NUM];
+    for (size_t regType = 0; regType < regTypesNum; regType++)
+    {
+        setWords[regType] = (graphVregsCounts[regType]+63)>>6;
+        const size_t setsSize = setWords[regType]*blocksNum;
+        useSets[regType].assign(setsSize, 0);
+        defSets[regType].assign(setsSize, 0);
+        liveInSets[regType].assign(setsSize, 0);
+        liveOutSets[regType].assign(setsSize, 0);
+    }
+    
+    // fill up use (read before write) and def (written) sets
+    for (size_t b: rpo)
+        for (const auto& entry: codeBlocks[b].ssaInfoMap)
+        {
+            const SSAInfo& sinfo = entry.second;
+            const cxuint regType = getRegType(regTypesNum, regRanges, entry.first);
+            const std::vector<size_t>& vidxes =
+                        vregIndexMaps[regType].find(entry.first)->second;
+            uint64_t* useSet = useSets[regType].data() + b*setWords[regType];
+            uint64_t* defSet = defSets[regType].data() + b*setWords[regType];
+            if (entry.first.regVar == nullptr)
+            {
+                // normal register: only one variable
+                if (sinfo.readBeforeWrite)
+                    useSet[vidxes[0]>>6] |= 1ULL<<(vidxes[0]&63);
+                else
+                    defSet[vidxes[0]>>6] |= 1ULL<<(vidxes[0]&63);
+                continue;
+            }
+            if (sinfo.readBeforeWrite)
+            {
+                const size_t vidx = vidxes[sinfo.ssaIdBefore];
+                useSet[vidx>>6] |= 1ULL<<(vidx&63);
+            }
+            if (sinfo.ssaIdChange != 0)
+            {
+                const size_t firstVIdx = vidxes[sinfo.ssaIdFirst];
+                const size_t lastVIdx = vidxes[sinfo.ssaIdLast];
+                defSet[firstVIdx>>6] |= 1ULL<<(firstVIdx&63);
+                defSet[lastVIdx>>6] |= 1ULL<<(lastVIdx&63);
+                for (size_t ssaId = sinfo.ssaId+1;
+                        ssaId < sinfo.ssaId+sinfo.ssaIdChange-1; ssaId++)
+                    defSet[vidxes[ssaId]>>6] |= 1ULL<<(vidxes[ssaId]&63);
+            }
+        }
+    
+    // solve dataflow equations, iterate in postorder (reverse of RPO) until fixpoint
+    for (size_t regType = 0; regType < regTypesNum; regType++)
+    {
+        const size_t words = setWords[regType];
+        if (words == 0)
+            continue;
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            for (auto bit = rpo.rbegin(); bit != rpo.rend(); ++bit)
+            {
+                const size_t b = *bit;
+                uint64_t* liveOut = liveOutSets[regType].data() + b*words;
+                uint64_t* liveIn = liveInSets[regType].data() + b*words;
+                const uint64_t* useSet = useSets[regType].data() + b*words;
+                const uint64_t* defSet = defSets[regType].data() + b*words;
+                // out = union of ins of successors
+                for (size_t succ: graph.succs[b])
+                {
+                    const uint64_t* succIn = liveInSets[regType].data() + succ*words;
+                    for (size_t w = 0; w < words; w++)
+                        liveOut[w] |= succIn[w];
+                }
+                // in = use | (out & ~def)
+                for (size_t w = 0; w < words; w++)
+                {
+                    const uint64_t newIn = useSet[w] | (liveOut[w] & ~defSet[w]);
+                    if (newIn != liveIn[w])
+                    {
+                        liveIn[w] = newIn;
+                        changed = true;
+                    }
+                }
+            }
+        }
+    }
+    
+    // flow stack, caches and routine map are not used by block livenesses
+    std::deque<FlowStackEntry3> flowStack;
+    std::vector<bool> waysToCache;
+    ResSecondPointsToCache cblocksToCache(0);
+    PrevWaysIndexMap prevWaysIndexMap;
+    RoutineLvMap routineMap;
+    LivenessState ls = { flowStack, codeBlocks, waysToCache, cblocksToCache,
+        prevWaysIndexMap, livenesses, vregIndexMaps, vidxCallMap, vidxRoutineMap,
+        routineMap, regTypesNum, regRanges };
+    
+    // last access positions of svregs in code block
+    std::vector<size_t> ownerLastPos(ownersNum);
+    std::vector<size_t> ownerStamps(ownersNum, SIZE_MAX);
+    for (size_t b: rpo)
+    {
+        CodeBlock& cblock = codeBlocks[b];
+        // livenesses inside code block
+        linearDepsFailures += createBlockLivenesses(cblock, ls, usageHandler,
+                    linDepHandler, linearDepMaps);
+        
+        for (const auto& entry: cblock.ssaInfoMap)
+        {
+            const cxuint regType = getRegType(regTypesNum, regRanges, entry.first);
+            const std::vector<size_t>& vidxes =
+                        vregIndexMaps[regType].find(entry.first)->second;
+            for (size_t vidx: vidxes)
+                if (vidx != SIZE_MAX)
+                {
+                    const size_t owner = vidxOwners[regType][vidx];
+                    ownerStamps[owner] = b;
+                    ownerLastPos[owner] = entry.second.lastPos;
+                    break;
+                }
+        }
+        // extend variables that live at end of code block
+        for (size_t regType = 0; regType < regTypesNum; regType++)
+        {
+            const uint64_t* liveOut = liveOutSets[regType].data() + b*setWords[regType];
+            for (size_t w = 0; w < setWords[regType]; w++)
+                for (uint64_t word = liveOut[w]; word != 0; word &= word-1)
+                {
+                    const size_t vidx = (w<<6) + CTZ64(word);
+                    const size_t owner = vidxOwners[regType][vidx];
+                    // begin after last access in block or from start of block
+                    const size_t start = (ownerStamps[owner] == b) ?
+                            ownerLastPos[owner]+1 : cblock.start;
+                    livenesses[regType][vidx].insert(start, cblock.end);
+                }
+        }
+    }
+    
+    moveLivenesses(regTypesNum, livenesses, outLivenesses);
 }
@@ -1386,17 +1386,16 @@ static void createRoutineData(const std::vector<CodeBlock>& codeBlocks,
     ARDOut << "--------- createRoutineData end ------------\n";
 }
 
-void AsmRegAllocator::createSSAData(ISAUsageHandler& usageHandler,
-                ISALinearDepHandler& linDepHandler)
+/* collect SSA infos of code blocks: positions of usages, read before write and
+ * SSA id changes (writes). returns false if no register usages */
+bool AsmRegAllocator::collectSSAInfos(ISAUsageHandler& usageHandler)
 {
-    if (codeBlocks.empty())
-        return;
     auto cbit = codeBlocks.begin();
     AsmRegVarUsage rvu;
     ISAUsageHandler::ReadPos usagePos{ 0, 0 };
     
     if (!usageHandler.hasNext(usagePos))
-        return; // do nothing if no regusages
+        return false; // do nothing if no regusages
     ISAUsageHandler::ReadPos oldReadPos = usagePos;
     // old linear deps position
     rvu = usageHandler.nextUsage(usagePos);
@@ -1470,6 +1469,16 @@ void AsmRegAllocator::createSSAData(ISAUsageHandler& usageHandler,
     // fill up remaining codeblocks oldReadPos
     for (; cbit != codeBlocks.end(); ++cbit)
         cbit->usagePos = oldReadPos;
+    return true;
+}
+
+void AsmRegAllocator::createSSAData(ISAUsageHandler& usageHandler,
+                ISALinearDepHandler& linDepHandler)
+{
+    if (codeBlocks.empty())
+        return;
+    if (!collectSSAInfos(usageHandler))
+        return;
     
     size_t rbwCount = 0;
     size_t wrCount = 0;
@@ -75,363 +75,138 @@ ISAWaitHandler::ReadPos ISAWaitHandler::findPositionByOffset(size_t offset) cons
 static inline uint16_t qregVal(uint16_t reg, bool write)
 { return reg | (write ? 0x8000 : 0); }
 
-static inline bool qregWrite(uint16_t qreg)
-{ return (qreg & 0x8000)!=0; }
-
-static inline uint16_t qregReg(uint16_t qreg)
-{ return qreg & 0x7fff; }
+/* all temporary registers of spilled register variables are treated
+ * as single register (conservatively) */
+static const cxuint spillTempReg = 0x7fff;
 
 namespace CLRX
 {
 
-struct QueueEntry1
-{
-    std::unordered_set<uint16_t> regs;
-    bool haveDelayedOp;
-    
-    QueueEntry1() : haveDelayedOp(false)
-    { }
-    
-    bool empty() const
-    { return haveDelayedOp || !regs.empty(); }
-    
-    void join(const QueueEntry1& b)
-    {
-        regs.insert(b.regs.begin(), b.regs.end());
-        haveDelayedOp |= b.haveDelayedOp;
-    }
-
-    // toBEntry - difference offset between output orderedStartPos and
-    // b entry orderedStartPos
-    void joinWithRegPlaces(const QueueEntry1& b, uint16_t toBEntry,
-            uint16_t opos, std::unordered_map<uint16_t, uint16_t>& regPlaces)
-    {
-        for (auto e: b.regs)
-            if (regs.insert(e).second)
-            {
-                auto rres = regPlaces.insert(std::make_pair(e, opos));
-                if (rres.second && rres.first->second+toBEntry < opos)
-                    rres.first->second = opos;
-            }
-        regs.insert(b.regs.begin(), b.regs.end());
-        haveDelayedOp |= b.haveDelayedOp;
-    }
-    
-    size_t size() const
-    { return regs.size(); }
-};
-
-// toBEntry - difference offset between output orderedStartPos and
-// regPlaces entry orderedStartPos
-static inline void updateRegPlaces(const QueueEntry1& b, uint16_t toBEntry,
-                uint16_t opos, std::unordered_map<uint16_t, uint16_t>& regPlaces)
-{
-    for (auto e: b.regs)
-    {
-        auto rres = regPlaces.insert(std::make_pair(e, opos));
-        if (rres.second && rres.first->second+toBEntry < opos)
-            rres.first->second = opos;
-    }
-}
-
+/* pending registers in wait queue. key - qreg, value - wait count (queue size)
+ * that guarantees finishing delayed operation (number of ordered operations enqueued
+ * after this operation) */
+typedef std::unordered_map<uint16_t, uint16_t> WaitQueueRegs;
 
-struct CLRX_INTERNAL QueueState1
+struct CLRX_INTERNAL WaitQueueState
 {
-    cxuint maxQueueSize;
-    uint16_t minQueueIndex;
-    uint16_t orderedStartPos;
-    std::deque<QueueEntry1> ordered;  // ordered items
-    QueueEntry1 random;   // items in random order
-    // register place in queue - key - reg, value - position
-    std::unordered_map<uint16_t, uint16_t> regPlaces;
-    // request queue size at start of block (by enqueuing and waiting/flushing)
-    // used while joining with previous block
-    cxuint requestedQueueSize;
-    bool firstFlush;
-    bool reallyFlushed; // if really already flushed (queue size has been shrinked)
-    
-    QueueState1(cxuint _maxQueueSize = 0) : maxQueueSize(_maxQueueSize),
-                minQueueIndex(0), orderedStartPos(0), requestedQueueSize(_maxQueueSize),
-                firstFlush(true), reallyFlushed(false)
-    { }
-    
-    void setMaxQueueSize(cxuint _maxQueueSize)
-    { requestedQueueSize = maxQueueSize = _maxQueueSize; }
-    
-    void pushOrdered(uint16_t reg)
-    {
-        if (reg == UINT16_MAX)
-        {
-            // push same delayed op (no reg)
-            ordered.back().haveDelayedOp = true;
-            return;
-        }
-        regPlaces[reg] = orderedStartPos + ordered.size()-1;
-        ordered.back().regs.insert(reg);
-    }
+    WaitQueueRegs ordered[ASM_WAIT_MAX_TYPES_NUM];
+    // registers of unordered operations (finished only by waiting for empty queue)
+    std::unordered_set<uint16_t> random[ASM_WAIT_MAX_TYPES_NUM];
     
-    void pushRandom(uint16_t reg)
+    // join with state from other way (choose smaller wait counts)
+    bool join(const WaitQueueState& b, cxuint queuesNum)
     {
-        if (reg != UINT16_MAX)
-            random.regs.insert(reg);
-        else
-            // push same delayed op (no reg)
-            random.haveDelayedOp = true;
-    }
-    
-    void nextEntry()
-    {
-        if (ordered.empty() || !ordered.back().empty())
-            // push only if empty or previous is filled
-            ordered.push_back(QueueEntry1());
-        
-        if (ordered.size() == maxQueueSize)
+        bool changed = false;
+        for (cxuint q = 0; q < queuesNum; q++)
         {
-            // move first entry in ordered queue to first ordered
-            QueueEntry1& firstOrdered = ordered.front();
-            orderedStartPos++; // next start pos for ordered queue for first entry
-            if (orderedStartPos-minQueueIndex > 10000)
+            for (const auto& e: b.ordered[q])
             {
-                for (auto e: firstOrdered.regs)
+                auto res = ordered[q].insert(e);
+                if (res.second)
+                    changed = true;
+                else if (e.second < res.first->second)
                 {
-                    auto rpit = regPlaces.find(e);
-                    // update regPlaces for firstOrdered before joining
-                    rpit->second = orderedStartPos;
+                    res.first->second = e.second;
+                    changed = true;
                 }
-                minQueueIndex = orderedStartPos;
-            }
-            auto ordit = ordered.begin();
-            ++ordit; // second entry
-            QueueEntry1& second = *ordit;
-            // to second entry
-            second.regs.insert(firstOrdered.regs.begin(), firstOrdered.regs.end());
-            ordered.pop_front();
-        }
-        requestedQueueSize = std::max(requestedQueueSize+1, maxQueueSize);
-    }
-    void flushTo(cxuint size)
-    {
-        if (firstFlush && ordered.size() < size)
-        {
-            // if higher than queue size and higher than requested queue size
-            requestedQueueSize = size;
-            firstFlush = false;
-            return;
-        }
-        reallyFlushed = (ordered.size() <= size);
-        firstFlush = false;
-        if (size == 0)
-            random.regs.clear(); // clear randomly ordered if must be empty
-        while (size < ordered.size())
-        {
-            for (auto e: ordered.front().regs)
-            {
-                auto prit = regPlaces.find(e);
-                if (prit != regPlaces.end() && prit->second == orderedStartPos)
-                    regPlaces.erase(prit); // remove from regPlaces if in this place
             }
-            ordered.pop_front();
-            orderedStartPos++;
-        }
-        minQueueIndex = orderedStartPos;
-        requestedQueueSize = std::min(size, requestedQueueSize);
-    }
-    
-    uint16_t findMinQueueSizeForReg(uint16_t reg) const
-    {
-        auto it = regPlaces.find(reg);
-        if (it == regPlaces.end())
-            // if found, then 0 otherwize not found (UINT_MAX)
-            return random.regs.find(reg) != random.regs.end() ? 0 : UINT16_MAX;
-        const uint16_t pos = std::min(
-                    int(maxQueueSize), int(it->second - orderedStartPos));
-        return ordered.size()-1 - cxuint(pos);
-    }
-    
-    void joinWay(const QueueState1& way)
-    {
-        random.join(way.random);
-        
-        auto oit1 = ordered.begin();
-        auto oit2 = way.ordered.begin();
-        const int queueSizeDiff = way.ordered.size() - ordered.size();
-        uint16_t qpos = orderedStartPos;
-        uint16_t wayStartPos = way.orderedStartPos;
-        if (queueSizeDiff > 0)
-        {
-            ordered.insert(ordered.begin(), way.ordered.begin(),
-                    way.ordered.begin() + queueSizeDiff);
-            oit2 += queueSizeDiff;
-            orderedStartPos -= queueSizeDiff;
-            oit1 = ordered.begin() + queueSizeDiff;
-            qpos = orderedStartPos;
-            // update regPlaces after pushing to front
-            for (auto oitx = ordered.begin(); oitx != oit1; ++oitx, ++qpos)
-                updateRegPlaces(*oitx, orderedStartPos-wayStartPos, qpos, regPlaces);
-        }
-        else
-        {
-            oit1 -= queueSizeDiff;
-            qpos -= queueSizeDiff;
+            for (uint16_t qreg: b.random[q])
+                changed |= random[q].insert(qreg).second;
         }
-        // join entries
-        for (; oit1 != ordered.end(); ++oit1, ++oit2, ++qpos)
-            oit1->joinWithRegPlaces(*oit2, orderedStartPos-wayStartPos, qpos, regPlaces);
-        
-        firstFlush |= way.firstFlush;
-        requestedQueueSize = std::max(requestedQueueSize, way.requestedQueueSize);
+        return changed;
     }
     
-    bool joinNext(const QueueState1& next)
+    bool equal(const WaitQueueState& b, cxuint queuesNum) const
     {
-        if (!reallyFlushed)
-        {
-            if (next.random.empty() && next.ordered.empty() &&
-                next.requestedQueueSize == maxQueueSize)
-                // no change
+        for (cxuint q = 0; q < queuesNum; q++)
+            if (ordered[q] != b.ordered[q] || random[q] != b.random[q])
                 return false;
-            
-            cxuint nextReqQSize = std::min(next.requestedQueueSize, requestedQueueSize);
-            const cxuint oldOrderedSize = ordered.size();
-            const cxuint prevOrderedSize = (nextReqQSize!=ordered.size() ?
-                    nextReqQSize-ordered.size() : next.ordered.size());
-            ordered.erase(ordered.begin(), ordered.end()-prevOrderedSize);
-            ordered.insert(ordered.end(), next.ordered.begin(), next.ordered.end());
-            orderedStartPos += ordered.size()-oldOrderedSize;
-            uint16_t nextStartPos = next.orderedStartPos - prevOrderedSize;
-            uint16_t qpos = orderedStartPos;
-            // update regplaces for front
-            for (auto oitx = ordered.begin() + prevOrderedSize; oitx != ordered.end();
-                        ++oitx, ++qpos)
-                updateRegPlaces(*oitx, orderedStartPos-nextStartPos, qpos, regPlaces);
-            
-            if (ordered.size() > maxQueueSize)
-            {
-                // push to first ordered
-                size_t toFirst = ordered.size() - maxQueueSize;
-                auto firstOrderedIt = ordered.begin() + toFirst;
-                for (auto it = ordered.begin(); it!=firstOrderedIt; ++it)
-                    firstOrderedIt->joinWithRegPlaces(*it, 0,
-                            orderedStartPos + toFirst, regPlaces);
-                ordered.erase(ordered.begin(), firstOrderedIt);
-                orderedStartPos += toFirst;
-            }
-            random.join(next.random);
-            requestedQueueSize = std::min(nextReqQSize, maxQueueSize);
-            return true;
-        }
-        
-        return false;
+        return true;
     }
     
-    size_t weight() const
-    {
-        size_t w = random.size();
-        for (const QueueEntry1& e: ordered)
-            w += e.size();
-        return w;
-    }
-};
-
-struct CLRX_INTERNAL WaitFirstCacheEntry
-{
-    QueueState1 queues[ASM_WAIT_MAX_TYPES_NUM];
+    bool empty(cxuint q) const
+    { return ordered[q].empty() && random[q].empty(); }
     
-    size_t weight() const
+    // get wait count to finish operation for register (UINT16_MAX if not pending)
+    uint16_t find(cxuint q, uint16_t qreg) const
     {
-        size_t w = 0;
-        for (const QueueState1& q: queues)
-            w += q.weight();
-        return w;
+        if (random[q].find(qreg) != random[q].end())
+            return 0;
+        auto it = ordered[q].find(qreg);
+        return (it != ordered[q].end()) ? it->second : UINT16_MAX;
     }
-};
-
-struct CLRX_INTERNAL RRegInfo
-{
-    size_t offset;  /// offset where is usage
-    uint16_t qsizes[ASM_WAIT_MAX_TYPES_NUM];  /// queue sizes in this reg usage
-    uint16_t waits[ASM_WAIT_MAX_TYPES_NUM];  /// pending waits from block to this place
-};
-
-typedef std::unordered_map<uint16_t, RRegInfo> RRegMap;
-
-struct CLRX_INTERNAL WaitSecRRegTreeEntry
-{
-    size_t blockIndex;
-    std::vector<uint16_t> firstRegs; // sorted
-    std::vector<size_t> nextBlocks;
-};
-
-struct CLRX_INTERNAL WaitSecCacheEntry
-{
-    RRegMap firstRegs;
-    // tree of first regs, first entry is start point
-    // nextBlocks points to next points of ways
-    std::vector<WaitSecCacheEntry> firstRegsOrdering;
-    
-    size_t weight() const
-    { return firstRegs.size() + firstRegsOrdering.size(); }
-};
-
-struct CLRX_INTERNAL WaitFlowStackEntry0
-{
-    size_t blockIndex;
-    size_t nextIndex;
-    bool isCall;
-    bool haveReturn;
-    
-    QueueState1 queues[ASM_WAIT_MAX_TYPES_NUM];
     
-    WaitFlowStackEntry0(size_t _blockIndex, size_t _nextIndex,
-                        const AsmWaitConfig& waitConfig)
-            : blockIndex(_blockIndex), nextIndex(_nextIndex), isCall(false)
+    // finish operations that are waited by wait instruction
+    void flush(const uint16_t* waits, cxuint queuesNum)
     {
-        setMaxQueueSizes(waitConfig);
+        for (cxuint q = 0; q < queuesNum; q++)
+        {
+            if (waits[q] == 0)
+                random[q].clear();
+            for (auto it = ordered[q].begin(); it != ordered[q].end();)
+                if (it->second >= waits[q])
+                    it = ordered[q].erase(it);
+                else
+                    ++it;
+        }
     }
     
-    WaitFlowStackEntry0(size_t _blockIndex, size_t _nextIndex, bool _isCall,
-                        const AsmWaitConfig& waitConfig)
-            : blockIndex(_blockIndex), nextIndex(_nextIndex), isCall(_isCall)
+    // enqueue ordered operation: increase wait counts for previous operations
+    // and remove operations that surely finished (queue can not be greater)
+    void nextOrdered(cxuint q, uint16_t queueSize)
     {
-        setMaxQueueSizes(waitConfig);
+        for (auto it = ordered[q].begin(); it != ordered[q].end();)
+            if (++it->second >= queueSize-1)
+                it = ordered[q].erase(it);
+            else
+                ++it;
     }
     
-    WaitFlowStackEntry0(size_t _blockIndex, size_t _nextIndex,
-                        const WaitFlowStackEntry0& prev,
-                        const AsmWaitConfig& waitConfig)
-            : blockIndex(_blockIndex), nextIndex(_nextIndex)
+    void push(cxuint q, uint16_t qreg, bool isOrdered)
     {
-        setMaxQueueSizes(waitConfig);
-        std::copy(prev.queues, prev.queues + waitConfig.waitQueuesNum, queues);
+        if (isOrdered)
+            ordered[q][qreg] = 0;
+        else
+            random[q].insert(qreg);
     }
     
-    void setMaxQueueSizes(const AsmWaitConfig& waitConfig)
+    // get sorted registers of pending operations (without write flag)
+    void getPendingRegs(cxuint queuesNum, std::vector<uint16_t>& regs) const
     {
-        for (cxuint i = 0; i < waitConfig.waitQueuesNum; i++)
-            queues[i].setMaxQueueSize(waitConfig.waitQueueSizes[i]);
+        regs.clear();
+        for (cxuint q = 0; q < queuesNum; q++)
+        {
+            for (const auto& e: ordered[q])
+                regs.push_back(e.first & 0x7fff);
+            for (uint16_t qreg: random[q])
+                regs.push_back(qreg & 0x7fff);
+        }
+        std::sort(regs.begin(), regs.end());
+        regs.resize(std::unique(regs.begin(), regs.end()) - regs.begin());
     }
 };
 
-struct CLRX_INTERNAL WaitInstrXInfo
+struct CLRX_INTERNAL WaitCodeBlock
 {
-    size_t offset;
-    uint16_t waits[ASM_WAIT_MAX_TYPES_NUM];
-    uint16_t qsizes[ASM_WAIT_MAX_TYPES_NUM];
+    WaitQueueState inState;   // state at start of block
+    WaitQueueState outState;  // state at end of block
+    // generated wait instrs (new or replacing user wait instrs)
+    std::vector<AsmWaitInstr> neededWaitInstrs;
+    bool processed;
+    
+    WaitCodeBlock() : processed(false)
+    { }
 };
 
-struct CLRX_INTERNAL WaitCodeBlock
+// trace of processing of code block (for moving instructions before waits)
+struct CLRX_INTERNAL WaitBlockTrace
 {
-    QueueState1 queues[ASM_WAIT_MAX_TYPES_NUM];
-    std::vector<AsmWaitInstr> waitInstrs;
-    // before wait instrs for delayed op in this block
-    std::vector<WaitInstrXInfo> firstWaitInstrs;
-    std::vector<std::pair<uint16_t, RRegInfo> > firstRegs; ///< first occurence of reg
-    
-    void setMaxQueueSizes(const AsmWaitConfig& waitConfig)
-    {
-        for (cxuint i = 0; i < waitConfig.waitQueuesNum; i++)
-            queues[i].setMaxQueueSize(waitConfig.waitQueueSizes[i]);
-    }
+    // register accesses: instruction offset and qreg (real register and write flag)
+    std::vector<std::pair<size_t, uint16_t> > regAccesses;
+    // enqueued operations: instruction offset and wait queue
+    std::vector<std::pair<size_t, cxuint> > enqueues;
+    // pending registers after generated wait instructions: wait offset and registers
+    std::vector<std::pair<size_t, std::vector<uint16_t> > > waitPendings;
 };
 
 };
@@ -469,10 +244,6 @@ static void getVIdx(const AsmSingleVReg& svreg, size_t ssaIdIdx,
     regType = getRegType(regTypesNum, regRanges, svreg); // regtype
     const VarIndexMap& vregIndexMap = vregIndexMaps[regType];
     const std::vector<size_t>& vidxes = vregIndexMap.find(svreg)->second;
-    /*ARDOut << "lvn[" << regType << "][" << vidxes[ssaId] << "]. ssaIdIdx: " <<
-            ssaIdIdx << ". ssaId: " << ssaId << ". svreg: " << svreg.regVar << ":" <<
-            svreg.index << "\n";*/
-    //return livenesses[regType][ssaIdIndices[ssaId]];
     vidx = vidxes[ssaId];
 }
 
@@ -492,27 +263,61 @@ static cxuint getRRegFromSVReg(const AsmSingleVReg& svreg, size_t outSSAIdIdx,
         size_t vidx;
         getVIdx(svreg, outSSAIdIdx, ssaInfo, vregIndexMaps,
                 regTypesNum, regRanges, regType, vidx);
-        rreg = regRanges[2*regType] + graphColorMaps[regType][vidx];
+        const cxuint color = graphColorMaps[regType][vidx];
+        if (color == UINT_MAX)
+            return UINT_MAX; // spilled register variable (held in memory)
+        rreg = regRanges[2*regType] + color;
     }
     
     return rreg;
 }
 
-static void processQueueBlock(const CodeBlock& cblock, WaitCodeBlock& wblock,
-        ISAWaitHandler& waitHandler, ISAWaitHandler::ReadPos& waitPos,
-        ISAUsageHandler& usageHandler, const AsmWaitConfig& waitConfig,
-        const VarIndexMap* vregIndexMaps, const Array<cxuint>* graphColorMaps,
-        size_t regTypesNum, const cxuint* regRanges, bool onlyWarnings)
+// put registers of delayed operation to wait queue
+static void enqueueDelayedOpRegs(const AsmDelayedOp& delayedOp, cxbyte delOpType,
+            cxbyte rwFlags, const AsmWaitConfig& waitConfig, const SVRegMap& ssaIdIdxMap,
+            const CodeBlock& cblock, const VarIndexMap* vregIndexMaps,
+            const Array<cxuint>* graphColorMaps, size_t regTypesNum,
+            const cxuint* regRanges, WaitQueueState& state)
+{
+    const AsmDelayedOpTypeEntry& delOpEntry = waitConfig.delayOpTypes[delOpType];
+    for (uint16_t rindex = delayedOp.rstart; rindex < delayedOp.rend; rindex++)
+    {
+        AsmSingleVReg svreg{ delayedOp.regVar, rindex };
+        auto ssaIdIdxIt = ssaIdIdxMap.find(svreg);
+        const size_t ssaIdIdx = (ssaIdIdxIt != ssaIdIdxMap.end()) ?
+                    ssaIdIdxIt->second : 0;
+        cxuint rreg = getRRegFromSVReg(svreg, ssaIdIdx, cblock,
+                vregIndexMaps, graphColorMaps, regTypesNum, regRanges);
+        if (rreg == UINT_MAX)
+            rreg = spillTempReg;
+        // register read out must be finished before any write to it
+        if ((rwFlags & ASMRVU_READ) != 0 && delOpEntry.finishOnRegReadOut)
+            state.push(delOpEntry.waitType, qregVal(rreg, false), delOpEntry.ordered);
+        if ((rwFlags & ASMRVU_WRITE) != 0)
+            state.push(delOpEntry.waitType, qregVal(rreg, true), delOpEntry.ordered);
+    }
+}
+
+/* process code block: from state at start of block to state at end of block.
+ * generates wait instructions before instructions that access registers
+ * of unfinished delayed operations. if trace is given, then register accesses,
+ * enqueued operations and pending registers after waits are put to trace */
+static void processWaitBlock(const CodeBlock& cblock, WaitCodeBlock& wblock,
+        ISAWaitHandler& waitHandler, ISAUsageHandler& usageHandler,
+        const AsmWaitConfig& waitConfig, const VarIndexMap* vregIndexMaps,
+        const Array<cxuint>* graphColorMaps, size_t regTypesNum,
+        const cxuint* regRanges, bool onlyWarnings, WaitBlockTrace* trace = nullptr)
 {
-    // fill usage of registers (real access) to wCblock
+    const cxuint queuesNum = waitConfig.waitQueuesNum;
+    WaitQueueState state = wblock.inState;
+    wblock.neededWaitInstrs.clear();
+    
     ISAUsageHandler::ReadPos usagePos = cblock.usagePos;
+    ISAWaitHandler::ReadPos waitPos = waitHandler.findPositionByOffset(cblock.start);
     
     SVRegMap ssaIdIdxMap;
     SVRegMap svregWriteOffsets;
-    std::vector<AsmRegVarUsage> instrRVUs;
     
-    RRegMap firstRegs;
-    // process waits and delayed ops
     AsmWaitInstr waitInstr;
     AsmDelayedOp delayedOp;
     size_t instrOffset = SIZE_MAX;
@@ -522,362 +327,206 @@ static void processQueueBlock(const CodeBlock& cblock, WaitCodeBlock& wblock,
         isWaitInstr = waitHandler.nextInstr(waitPos, delayedOp, waitInstr);
         instrOffset = (isWaitInstr ? waitInstr.offset : delayedOp.offset);
     }
+    AsmRegVarUsage rvu{};
+    bool haveRVU = false;
+    if (usageHandler.hasNext(usagePos))
+    {
+        rvu = usageHandler.nextUsage(usagePos);
+        haveRVU = true;
+    }
     
-    uint16_t curQueueSizes[ASM_WAIT_MAX_TYPES_NUM];
-    uint16_t curWaits[ASM_WAIT_MAX_TYPES_NUM];
-    std::fill(curWaits, curWaits + waitConfig.waitQueuesNum, uint16_t(0));
-    // we assume that current queue size at start is not limited
-    std::fill(curQueueSizes, curQueueSizes + waitConfig.waitQueuesNum, UINT16_MAX);
+    /* last user wait instruction in this block, that can be replaced by
+     * generated wait instruction (if no delayed op between them) */
+    AsmWaitInstr lastUserWait{ SIZE_MAX };
     
-    cxuint flushedQueues = 0;
-    while (usageHandler.hasNext(usagePos))
+    while (true)
     {
-        const AsmRegVarUsage rvu = usageHandler.nextUsage(usagePos);
-        if (rvu.offset >= cblock.end && instrOffset >= cblock.end)
+        const size_t rvuOffset = haveRVU ? rvu.offset : SIZE_MAX;
+        if (rvuOffset >= cblock.end && instrOffset >= cblock.end)
             break;
         
-        bool genWaitCnt = false;
-        // gwaitI - current wait instruction
-        AsmWaitInstr gwaitI { rvu.offset, { } };
-        for (cxuint q = 0; q < waitConfig.waitQueuesNum; q++)
-            gwaitI.waits[q] = waitConfig.waitQueueSizes[q]-1;
-        
-        std::vector<std::pair<uint16_t, RRegInfo> > curRegs;
-        
-        if (rvu.offset < cblock.end && rvu.offset <= instrOffset)
+        if (rvuOffset < cblock.end && rvuOffset <= instrOffset)
         {
-            // process RegVar usage
-            for (uint16_t rindex = rvu.rstart; rindex < rvu.rend; rindex++)
+            // process all register usages of this instruction
+            AsmWaitInstr gwaitI{ rvuOffset, { } };
+            for (cxuint q = 0; q < queuesNum; q++)
+                gwaitI.waits[q] = waitConfig.waitQueueSizes[q]-1;
+            bool genWaitCnt = false;
+            
+            while (haveRVU && rvu.offset == rvuOffset)
             {
-                AsmSingleVReg svreg{ rvu.regVar, rindex };
-                
-                size_t outSSAIdIdx = 0;
-                if (rvu.regVar != nullptr)
+                for (uint16_t rindex = rvu.rstart; rindex < rvu.rend; rindex++)
                 {
-                    // if regvar, get vidx and get from vidx register index
-                    if (checkWriteWithSSA(rvu))
+                    AsmSingleVReg svreg{ rvu.regVar, rindex };
+                    size_t outSSAIdIdx = 0;
+                    if (rvu.regVar != nullptr)
                     {
-                        size_t& ssaIdIdx = ssaIdIdxMap[svreg];
-                        if (svreg.regVar != nullptr)
-                            ssaIdIdx++;
-                        outSSAIdIdx = ssaIdIdx;
-                        svregWriteOffsets.insert({ svreg, rvu.offset });
+                        if (checkWriteWithSSA(rvu))
+                        {
+                            outSSAIdIdx = ++ssaIdIdxMap[svreg];
+                            svregWriteOffsets[svreg] = rvu.offset;
+                        }
+                        else
+                        {
+                            auto svrres = ssaIdIdxMap.insert({ svreg, 0 });
+                            outSSAIdIdx = svrres.first->second;
+                            auto swit = svregWriteOffsets.find(svreg);
+                            if (swit != svregWriteOffsets.end() &&
+                                swit->second == rvu.offset)
+                                outSSAIdIdx--; // before this write
+                        }
                     }
-                    else // insert zero
+                    cxuint rreg = getRRegFromSVReg(svreg, outSSAIdIdx, cblock,
+                                vregIndexMaps, graphColorMaps, regTypesNum, regRanges);
+                    // spilled register variable is restored to temporary register
+                    // before instruction, hence access is also write
+                    bool writeAccess = (rvu.rwFlags & ASMRVU_WRITE) != 0;
+                    if (rreg == UINT_MAX)
                     {
-                        outSSAIdIdx = 0;
-                        auto svrres = ssaIdIdxMap.insert({ svreg, 0 });
-                        outSSAIdIdx = svrres.first->second;
-                        auto swit = svregWriteOffsets.find(svreg);
-                        if (swit != svregWriteOffsets.end() && swit->second == rvu.offset)
-                            outSSAIdIdx--; // before this write
+                        rreg = spillTempReg;
+                        writeAccess = true;
                     }
-                }
-                const cxuint rreg = getRRegFromSVReg(svreg, outSSAIdIdx, cblock,
-                            vregIndexMaps, graphColorMaps, regTypesNum, regRanges);
-                
-                // put to readRegs and writeRegs
-                if ((rvu.rwFlags & ASMRVU_READ) != 0)
-                    curRegs.push_back({ qregVal(rreg, false), { rvu.offset } });
-                if ((rvu.rwFlags & ASMRVU_WRITE) != 0)
-                    curRegs.push_back({ qregVal(rreg, true), { rvu.offset } });
-                
-                // rreg
-                if ((rvu.rwFlags & ASMRVU_READ) != 0)
-                    for (cxuint q = 0; q < waitConfig.waitQueuesNum; q++)
+                    if (trace != nullptr)
                     {
-                        uint16_t waitCnt = wblock.queues[q]
-                            .findMinQueueSizeForReg(qregVal(rreg, false));
-                        if (waitCnt != UINT16_MAX)
-                        {
-                            if (!onlyWarnings)
-                            {
-                                gwaitI.waits[q] = std::min(gwaitI.waits[q], waitCnt);
-                                genWaitCnt = true;
-                            }
-                        }
+                        if ((rvu.rwFlags & ASMRVU_READ) != 0)
+                            trace->regAccesses.push_back({ rvuOffset,
+                                        qregVal(rreg, false) });
+                        if (writeAccess)
+                            trace->regAccesses.push_back({ rvuOffset,
+                                        qregVal(rreg, true) });
                     }
-                if ((rvu.rwFlags & ASMRVU_WRITE) != 0)
-                    for (cxuint q = 0; q < waitConfig.waitQueuesNum; q++)
+                    
+                    for (cxuint q = 0; q < queuesNum; q++)
                     {
-                        uint16_t waitCnt = wblock.queues[q]
-                            .findMinQueueSizeForReg(qregVal(rreg, true));
+                        if (state.empty(q))
+                            continue;
+                        // any access must wait for results of operation
+                        uint16_t waitCnt = state.find(q, qregVal(rreg, true));
+                        // write must wait for register read out
+                        if (writeAccess)
+                            waitCnt = std::min(waitCnt,
+                                        state.find(q, qregVal(rreg, false)));
                         if (waitCnt != UINT16_MAX)
                         {
-                            if (!onlyWarnings)
-                            {
-                                gwaitI.waits[q] = std::min(gwaitI.waits[q], waitCnt);
-                                genWaitCnt = true;
-                            }
+                            gwaitI.waits[q] = std::min(gwaitI.waits[q], waitCnt);
+                            genWaitCnt = true;
                         }
                     }
-            }
-            
-            if (genWaitCnt && rvu.offset != instrOffset)
-            {
-                // generate wait instr
-                wblock.waitInstrs.push_back(gwaitI);
-                for (cxuint w = 0; w < waitConfig.waitQueuesNum; w++)
-                    wblock.queues[w].flushTo(gwaitI.waits[w]);
-            }
-        }
-        
-        if (instrOffset < cblock.end && rvu.offset >= instrOffset && isWaitInstr)
-        {
-            // process wait instr
-            if (genWaitCnt)
-            {
-                // if user waitinstr and generate wait instr
-                // then choose min queue sizes in wait instr and generate new
-                // wait instr.
-                for (cxuint w = 0; w < waitConfig.waitQueuesNum; w++)
-                    gwaitI.waits[w] = std::min(gwaitI.waits[w], waitInstr.waits[w]);
-                wblock.waitInstrs.push_back(gwaitI);
-                for (cxuint w = 0; w < waitConfig.waitQueuesNum; w++)
-                    wblock.queues[w].flushTo(gwaitI.waits[w]);
-            }
-            else
-            {
-                wblock.waitInstrs.push_back(waitInstr);
-                for (cxuint w = 0; w < waitConfig.waitQueuesNum; w++)
-                {
-                    wblock.queues[w].flushTo(waitInstr.waits[w]);
-                    gwaitI.waits[w] = waitInstr.waits[w];
-                    genWaitCnt = true;
                 }
+                haveRVU = usageHandler.hasNext(usagePos);
+                if (haveRVU)
+                    rvu = usageHandler.nextUsage(usagePos);
             }
-        }
-        
-        // update curQueue sizes from curent waitcnt
-        if (genWaitCnt && flushedQueues < waitConfig.waitQueuesNum)
-            for (cxuint q = 0; q < waitConfig.waitQueuesNum; q++)
+            
+            if (genWaitCnt && !onlyWarnings)
             {
-                if (!wblock.queues[q].reallyFlushed)
+                if (lastUserWait.offset != SIZE_MAX)
                 {
-                    // update wait after flush
-                    curQueueSizes[q] = wblock.queues[q].requestedQueueSize;
-                    curWaits[q] = std::min(curWaits[q],
-                                uint16_t(wblock.queues[q].ordered.size()));
+                    // replace last user wait instruction (no delayed op after it)
+                    for (cxuint q = 0; q < queuesNum; q++)
+                        gwaitI.waits[q] = std::min(gwaitI.waits[q],
+                                    lastUserWait.waits[q]);
+                    gwaitI.offset = lastUserWait.offset;
+                    lastUserWait = gwaitI;
                 }
-                else
+                wblock.neededWaitInstrs.push_back(gwaitI);
+                state.flush(gwaitI.waits, queuesNum);
+                if (trace != nullptr)
                 {
-                    // increment flushQueues when queue has been flushed now
-                    if (curWaits[q] != UINT16_MAX)
-                        flushedQueues++;
-                    curWaits[q] = UINT16_MAX;
+                    // replaced user wait instruction gets later pending registers
+                    if (trace->waitPendings.empty() ||
+                        trace->waitPendings.back().first != gwaitI.offset)
+                        trace->waitPendings.push_back({ gwaitI.offset, { } });
+                    state.getPendingRegs(queuesNum, trace->waitPendings.back().second);
                 }
             }
+            continue;
+        }
         
-        if (instrOffset < cblock.end && rvu.offset >= instrOffset)
+        // process wait instruction or delayed op
+        if (isWaitInstr)
         {
-            if (!isWaitInstr)
+            state.flush(waitInstr.waits, queuesNum);
+            lastUserWait = waitInstr;
+        }
+        else
+        {
+            // delayed op. one instruction can have many delayed ops, but it
+            // enqueues only once to every queue
+            cxuint enqueuedQueues = 0;
+            const size_t delOpOffset = delayedOp.offset;
+            while (true)
             {
-                // delayed op
-                const AsmDelayedOpTypeEntry& delOpEntry = waitConfig.delayOpTypes[
-                                delayedOp.delayedOpType];
-                const cxuint queue1Idx = delOpEntry.waitType;
-                const cxuint queue2Idx = delayedOp.delayedOpType!=ASMDELOP_NONE ?
-                        waitConfig.delayOpTypes[delayedOp.delayedOpType].waitType :
-                        UINT_MAX;
-                // next entry
-                wblock.queues[queue1Idx].nextEntry();
-                if (queue2Idx != UINT_MAX)
-                    wblock.queues[queue2Idx].nextEntry();
-                cxuint rcount = 0, rcount2 = 0;
-                
-                for (uint16_t rindex = delayedOp.rstart;
-                                    rindex < delayedOp.rend; rindex++)
+                const cxbyte delOpTypes[2] = { delayedOp.delayedOpType,
+                        delayedOp.delayedOpType2 };
+                const cxbyte rwFlagsTab[2] = { delayedOp.rwFlags, delayedOp.rwFlags2 };
+                for (cxuint k = 0; k < 2; k++)
                 {
-                    AsmSingleVReg svreg{ delayedOp.regVar, rindex };
-                    const size_t ssaIdIdx = ssaIdIdxMap.find(svreg)->second;
-                    const cxuint rreg = getRRegFromSVReg(svreg, ssaIdIdx, cblock,
-                            vregIndexMaps, graphColorMaps, regTypesNum, regRanges);
-                    
-                    if ((delayedOp.rwFlags & ASMRVU_READ) != 0 &&
-                                delOpEntry.finishOnRegReadOut)
+                    if (delOpTypes[k] == ASMDELOP_NONE ||
+                        delOpTypes[k] >= waitConfig.delayedOpTypesNum)
+                        continue;
+                    const AsmDelayedOpTypeEntry& delOpEntry =
+                                waitConfig.delayOpTypes[delOpTypes[k]];
+                    const cxuint q = delOpEntry.waitType;
+                    if ((enqueuedQueues & (1U<<q)) == 0)
                     {
-                        const uint16_t qreg = qregVal(rreg, false);
                         if (delOpEntry.ordered)
-                            wblock.queues[queue1Idx].pushOrdered(qreg);
-                        else
-                            wblock.queues[queue1Idx].pushRandom(qreg);
+                            state.nextOrdered(q, waitConfig.waitQueueSizes[q]);
+                        enqueuedQueues |= 1U<<q;
+                        if (trace != nullptr)
+                            trace->enqueues.push_back({ delOpOffset, q });
                     }
-                    if ((delayedOp.rwFlags & ASMRVU_WRITE) != 0)
-                    {
-                        const uint16_t qreg = qregVal(rreg, true);
-                        if (delOpEntry.ordered)
-                            wblock.queues[queue1Idx].pushOrdered(qreg);
-                        else
-                            wblock.queues[queue1Idx].pushRandom(qreg);
-                    }
-                    // if queue2
-                    if (queue2Idx != UINT_MAX)
-                    {
-                        const AsmDelayedOpTypeEntry& delOpEntry2 =
-                                waitConfig.delayOpTypes[delayedOp.delayedOpType2];
-                        if ((delayedOp.rwFlags2 & ASMRVU_READ) != 0 &&
-                                delOpEntry2.finishOnRegReadOut)
-                        {
-                            const uint16_t qreg = qregVal(rreg, false);
-                            if (delOpEntry2.ordered)
-                                wblock.queues[queue2Idx].pushOrdered(qreg);
-                            else
-                                wblock.queues[queue2Idx].pushRandom(qreg);
-                        }
-                        if ((delayedOp.rwFlags2 & ASMRVU_WRITE) != 0)
-                        {
-                            const uint16_t qreg = qregVal(rreg, true);
-                            if (delOpEntry2.ordered)
-                                wblock.queues[queue2Idx].pushOrdered(qreg);
-                            else
-                                wblock.queues[queue2Idx].pushRandom(qreg);
-                        }
-                        // do next queue entry if registered per element
-                        rcount2 += 4;
-                        if (delOpEntry2.counting!=255 && delOpEntry2.counting <= rcount)
-                        {
-                            // new entry
-                            wblock.queues[queue2Idx].nextEntry();
-                            rcount2 = 0;
-                        }
-                    }
-                    
-                    // do next queue entry if registered per element
-                    rcount += 4;
-                    if (delOpEntry.counting!=255 && delOpEntry.counting <= rcount)
-                    {
-                        // new entry
-                        wblock.queues[queue1Idx].nextEntry();
-                        rcount = 0;
-                    }
-                }
-                
-                // update current queue sizes from last delayed ops
-                if (flushedQueues < waitConfig.waitQueuesNum)
-                {
-                    curQueueSizes[queue1Idx] = wblock.queues[queue1Idx].requestedQueueSize;
-                    // increment curWait for queue1
-                    curWaits[queue1Idx] = std::min(uint16_t(curWaits[queue1Idx]+1),
-                                    waitConfig.waitQueueSizes[queue1Idx]);
-                    if (queue2Idx != UINT_MAX)
-                    {
-                        curQueueSizes[queue2Idx] =
-                                wblock.queues[queue2Idx].requestedQueueSize;
-                        // increment curWait for queue2
-                        curWaits[queue2Idx] = std::min(uint16_t(curWaits[queue2Idx]+1),
-                                    waitConfig.waitQueueSizes[queue2Idx]);
-                    }
-                }
-            }
-            
-            // only if any not flushed queue
-            if (flushedQueues < waitConfig.waitQueuesNum)
-            {
-                // update current queue sizes
-                for (auto& re: curRegs)
-                {
-                    std::copy(curQueueSizes, curQueueSizes + waitConfig.waitQueuesNum,
-                                re.second.qsizes);
-                    std::copy(curWaits, curWaits + waitConfig.waitQueuesNum,
-                                re.second.waits);
+                    enqueueDelayedOpRegs(delayedOp, delOpTypes[k], rwFlagsTab[k],
+                            waitConfig, ssaIdIdxMap, cblock, vregIndexMaps,
+                            graphColorMaps, regTypesNum, regRanges, state);
                 }
-                // put current regs to firstRegs
-                firstRegs.insert(curRegs.begin(), curRegs.end());
-            }
-            // get next instr
-            if (!waitHandler.hasNext(waitPos))
-                instrOffset = SIZE_MAX;
-            else
-            {
-                isWaitInstr = waitHandler.nextInstr(waitPos, delayedOp, waitInstr);
-                instrOffset = (isWaitInstr ? waitInstr.offset : delayedOp.offset);
+                // check next delayed op at this same instruction
+                if (!waitHandler.hasNext(waitPos))
+                    break;
+                ISAWaitHandler::ReadPos nextPos = waitPos;
+                AsmDelayedOp nextDelOp;
+                AsmWaitInstr nextWaitI;
+                if (waitHandler.nextInstr(nextPos, nextDelOp, nextWaitI) ||
+                    nextDelOp.offset != delOpOffset)
+                    break;
+                delayedOp = nextDelOp;
+                waitPos = nextPos;
             }
+            lastUserWait.offset = SIZE_MAX;
         }
-        
-        // copy to wblock as array
-        wblock.firstRegs.resize(firstRegs.size());
-        std::copy(firstRegs.begin(), firstRegs.end(), wblock.firstRegs.begin());
-        mapSort(wblock.firstRegs.begin(), wblock.firstRegs.end());
-    }
-}
-
-static void optimizeWaitInstrs(const AsmWaitConfig& waitConfig,
-                std::vector<WaitInstrXInfo>& waitInstrs)
-{
-    uint16_t extraQSizes[ASM_WAIT_MAX_TYPES_NUM];
-    std::fill(extraQSizes, extraQSizes + waitConfig.waitQueuesNum, uint16_t(UINT16_MAX));
-    for (WaitInstrXInfo& wi: waitInstrs)
-    {
-        cxuint toRemove = 0;
-        for (cxuint q = 0; q < waitConfig.waitQueuesNum; q++)
+        // get next instr
+        if (!waitHandler.hasNext(waitPos))
+            instrOffset = SIZE_MAX;
+        else
         {
-            if (wi.waits[q] - wi.qsizes[q] >= extraQSizes[q])
-            {
-                // mark to remove
-                wi.waits[q] = UINT16_MAX;
-                toRemove++;
-            }
-            else
-                // update new extraQSize for this queue
-                extraQSizes[q] = wi.waits[q] - wi.qsizes[q];
+            isWaitInstr = waitHandler.nextInstr(waitPos, delayedOp, waitInstr);
+            instrOffset = (isWaitInstr ? waitInstr.offset : delayedOp.offset);
         }
-        
-        if (toRemove == waitConfig.waitQueuesNum)
-            wi.offset = SIZE_MAX; // to remove
-        else
-            // correct waits
-            for (cxuint q = 0; q < waitConfig.waitQueuesNum; q++)
-                if (wi.waits[q] == UINT16_MAX)
-                    wi.waits[q] = waitConfig.waitQueueSizes[q] - 1;
     }
     
-    const size_t newSize = std::remove_if(waitInstrs.begin(), waitInstrs.end(),
-                [](const WaitInstrXInfo& wi)
-                { return wi.offset == SIZE_MAX; }) - waitInstrs.begin();
-    waitInstrs.resize(newSize);
+    // join replaced user wait instructions
+    std::vector<AsmWaitInstr>& waitInstrs = wblock.neededWaitInstrs;
+    size_t j = 0;
+    for (size_t i = 0; i < waitInstrs.size(); i++)
+        if (j != 0 && waitInstrs[j-1].offset == waitInstrs[i].offset)
+            waitInstrs[j-1] = waitInstrs[i]; // later has minimal waits
+        else
+            waitInstrs[j++] = waitInstrs[i];
+    waitInstrs.resize(j);
+    wblock.outState = std::move(state);
 }
 
-static void generateWaitInstrsWhileJoining(const AsmWaitConfig& waitConfig,
-        QueueState1* queues, const std::vector<std::pair<uint16_t, RRegInfo> >& firstRegs,
-        std::vector<WaitInstrXInfo>& waitInstrs, uint16_t* extraMinQueueSizes,
-        bool onlyWarnings)
+namespace CLRX
 {
-    std::fill(extraMinQueueSizes,
-              extraMinQueueSizes + waitConfig.waitQueuesNum, UINT16_MAX);
-    for (const auto& entry: firstRegs)
-    {
-        bool genWaitCnt = false;
-        WaitInstrXInfo gwaitI { entry.second.offset, { } };
-        for (cxuint q = 0; q < waitConfig.waitQueuesNum; q++)
-        {
-            gwaitI.waits[q] = waitConfig.waitQueueSizes[q]-1;
-            gwaitI.qsizes[q] = entry.second.qsizes[q];
-        }
-        
-        for (cxuint q = 0; q < waitConfig.waitQueuesNum; q++)
-        {
-            uint16_t waitCnt = queues[q].findMinQueueSizeForReg(entry.first);
-            if (waitCnt != UINT16_MAX)
-            {
-                waitCnt = std::min(gwaitI.waits[q], waitCnt);
-                if (!onlyWarnings && waitCnt < entry.second.qsizes[q])
-                {
-                    gwaitI.waits[q] = waitCnt;
-                    genWaitCnt = true;
-                }
-                extraMinQueueSizes[q] = std::min(
-                            uint16_t(entry.second.qsizes[q] - entry.second.waits[q]),
-                            extraMinQueueSizes[q]);
-            }
-        }
-        if (genWaitCnt)
-            waitInstrs.push_back(gwaitI);
-    }
-    
-    std::sort(waitInstrs.begin(), waitInstrs.end(),
-              [](const WaitInstrXInfo& a, const WaitInstrXInfo& b)
-              { return a.offset < b.offset; });
-    optimizeWaitInstrs(waitConfig, waitInstrs);
+
+// queue states of code blocks and code flow between code blocks
+struct CLRX_INTERNAL AsmWaitBlocksData
+{
+    std::vector<WaitCodeBlock> waitBlocks;
+    std::vector<std::vector<size_t> > succs;
+    std::vector<std::vector<size_t> > preds;
+};
+
 }
 
 AsmWaitScheduler::AsmWaitScheduler(const AsmWaitConfig& _asmWaitConfig,
@@ -886,197 +535,405 @@ AsmWaitScheduler::AsmWaitScheduler(const AsmWaitConfig& _asmWaitConfig,
         bool _onlyWarnings)
         : waitConfig(_asmWaitConfig), assembler(_assembler), codeBlocks(_codeBlocks),
           vregIndexMaps(_vregIndexMaps), graphColorMaps(_graphColorMaps),
-          onlyWarnings(_onlyWarnings)
+          onlyWarnings(_onlyWarnings), processedBlocksNum(0)
+{ }
+
+AsmWaitScheduler::~AsmWaitScheduler()
 { }
 
 void AsmWaitScheduler::schedule(ISAUsageHandler& usageHandler, ISAWaitHandler& waitHandler)
 {
+    blocksData.reset();
+    scheduleBlocks(usageHandler, waitHandler, std::vector<size_t>());
+}
+
+void AsmWaitScheduler::reschedule(ISAUsageHandler& usageHandler,
+            ISAWaitHandler& waitHandler, size_t regionStart, size_t regionEnd)
+{
+    std::vector<size_t> changedBlocks;
+    for (size_t i = 0; i < codeBlocks.size(); i++)
+        if (codeBlocks[i].start < regionEnd && regionStart < codeBlocks[i].end)
+            changedBlocks.push_back(i);
+    if (blocksData != nullptr && blocksData->waitBlocks.size() != codeBlocks.size())
+        blocksData.reset(); // code structure has been changed
+    scheduleBlocks(usageHandler, waitHandler, changedBlocks);
+}
+
+/* forward data flow analysis: state at start of block is join of states
+ * at end of previous blocks. If states of code blocks are kept from previous
+ * scheduling, then only code blocks reachable from changed code blocks are
+ * solved again (other blocks do not depend on changes). Code block whose
+ * state at start is same as before gets previous results without processing */
+void AsmWaitScheduler::scheduleBlocks(ISAUsageHandler& usageHandler,
+            ISAWaitHandler& waitHandler, const std::vector<size_t>& changedBlocks)
+{
+    neededWaitInstrs.clear();
+    processedBlocksNum = 0;
     if (codeBlocks.empty())
+    {
+        blocksData.reset();
         return;
+    }
     
     cxuint regRanges[MAX_REGTYPES_NUM*2];
     size_t regTypesNum;
-    std::vector<WaitCodeBlock> waitCodeBlocks(codeBlocks.size());
-    for(WaitCodeBlock& wblock: waitCodeBlocks)
-        wblock.setMaxQueueSizes(waitConfig);
-    
     assembler.isaAssembler->getRegisterRanges(regTypesNum, regRanges);
+    const cxuint queuesNum = waitConfig.waitQueuesNum;
+    const size_t blocksNum = codeBlocks.size();
     
-    // fill queue states
-    ISAWaitHandler::ReadPos waitPos{ 0, 0 };
-    for (size_t i = 0; i < codeBlocks.size(); i++)
-        processQueueBlock(codeBlocks[i], waitCodeBlocks[i], waitHandler, waitPos,
-                usageHandler, waitConfig, vregIndexMaps, graphColorMaps, regTypesNum,
-                regRanges, onlyWarnings);
-    
-    // key - current res first key, value - previous first key and its flowStack pos
-    PrevWaysIndexMap prevWaysIndexMap;
-    // to track ways last block indices pair: block index, flowStackPos)
-    std::pair<size_t, size_t> lastCommonCacheWayPoint{ SIZE_MAX, SIZE_MAX };
-    ResSecondPointsToCache cblocksToCache(codeBlocks.size());
-    std::vector<bool> waysToCache(codeBlocks.size(), false);
-    // main loop variables
-    std::deque<CallStackEntry> callStack;
-    std::unordered_set<BlockIndex> callBlocks;
-    std::deque<WaitFlowStackEntry0> flowStack;
-    flowStack.push_back(WaitFlowStackEntry0(0, 0, waitConfig));
-    std::vector<bool> visited(codeBlocks.size(), false);
-    
-    /*
-     * main loop to fill up ssaInfos
-     */
-    while (!flowStack.empty())
+    const bool fullSchedule = (blocksData == nullptr);
+    if (fullSchedule)
     {
-        WaitFlowStackEntry0& entry = flowStack.back();
-        const CodeBlock& cblock = codeBlocks[entry.blockIndex];
-        WaitCodeBlock& wblock = waitCodeBlocks[entry.blockIndex];
-        
-        if (entry.nextIndex == 0)
+        blocksData.reset(new AsmWaitBlocksData);
+        blocksData->waitBlocks.resize(blocksNum);
+        std::vector<std::vector<size_t> >& succs = blocksData->succs;
+        std::vector<std::vector<size_t> >& preds = blocksData->preds;
+        succs.resize(blocksNum);
+        preds.resize(blocksNum);
+        // blocks after calls (return from routines)
+        std::vector<size_t> afterCallBlocks;
+        for (size_t i = 0; i < blocksNum; i++)
+            if (codeBlocks[i].haveCalls && i+1 < blocksNum)
+                afterCallBlocks.push_back(i+1);
+        for (size_t i = 0; i < blocksNum; i++)
         {
-            // process current block
-            if (!visited[entry.blockIndex])
-            {
-                uint16_t minExtraQueueSizes[ASM_WAIT_MAX_TYPES_NUM];
-                visited[entry.blockIndex] = true;
-                std::vector<WaitInstrXInfo> thisWaitInstrs;
-                generateWaitInstrsWhileJoining(waitConfig, entry.queues, wblock.firstRegs,
-                            thisWaitInstrs, minExtraQueueSizes, onlyWarnings);
-                // insert to firstWaitInstrs in wblock
-                wblock.firstWaitInstrs.insert(wblock.firstWaitInstrs.end(),
-                            thisWaitInstrs.begin(), thisWaitInstrs.end());
-                // code to join queue state in previous with current block
-                for (cxuint q = 0; q < waitConfig.waitQueuesNum; q++)
+            const CodeBlock& cblock = codeBlocks[i];
+            for (const AsmRegAllocator::NextBlock& next: cblock.nexts)
+                succs[i].push_back(next.block);
+            if ((cblock.nexts.empty() || cblock.haveCalls) &&
+                !cblock.haveReturn && !cblock.haveEnd && i+1 < blocksNum)
+                succs[i].push_back(i+1);
+            if (cblock.haveReturn)
+                // return from routine to all places after calls
+                succs[i].insert(succs[i].end(), afterCallBlocks.begin(),
+                            afterCallBlocks.end());
+            std::sort(succs[i].begin(), succs[i].end());
+            succs[i].resize(std::unique(succs[i].begin(), succs[i].end()) -
+                        succs[i].begin());
+            for (size_t next: succs[i])
+                preds[next].push_back(i);
+        }
+    }
+    std::vector<WaitCodeBlock>& waitCodeBlocks = blocksData->waitBlocks;
+    const std::vector<std::vector<size_t> >& succs = blocksData->succs;
+    const std::vector<std::vector<size_t> >& preds = blocksData->preds;
+    
+    // blocks to solve: all blocks or blocks reachable from changed blocks
+    std::vector<bool> toSolve(blocksNum, fullSchedule);
+    std::vector<bool> changed(blocksNum, fullSchedule);
+    std::vector<WaitCodeBlock> oldWaitBlocks;
+    if (!fullSchedule)
+    {
+        std::vector<size_t> stack(changedBlocks.begin(), changedBlocks.end());
+        for (size_t i: changedBlocks)
+            toSolve[i] = changed[i] = true;
+        while (!stack.empty())
+        {
+            const size_t i = stack.back();
+            stack.pop_back();
+            for (size_t next: succs[i])
+                if (!toSolve[next])
                 {
-                    if (minExtraQueueSizes[q]!=UINT16_MAX &&
-                        !wblock.queues[q].reallyFlushed)
-                        entry.queues[q].requestedQueueSize = std::min(
-                            size_t(entry.queues[q].requestedQueueSize),
-                            minExtraQueueSizes[q] + wblock.queues[q].ordered.size());
-                    entry.queues[q].joinNext(wblock.queues[q]);
+                    toSolve[next] = true;
+                    stack.push_back(next);
                 }
-            }
-            else
+        }
+        oldWaitBlocks.resize(blocksNum);
+        for (size_t i = 0; i < blocksNum; i++)
+            if (toSolve[i])
             {
-                cblocksToCache.increase(entry.blockIndex);
-                ARDOut << "jcblockToCache: " << entry.blockIndex << "=" <<
-                            cblocksToCache.count(entry.blockIndex) << "\n";
-                
-                // back, already visited
-                flowStack.pop_back();
-                
-                size_t curWayBIndex = flowStack.back().blockIndex;
-                if (lastCommonCacheWayPoint.first != SIZE_MAX)
-                {
-                    // mark point of way to cache (res first point)
-                    waysToCache[lastCommonCacheWayPoint.first] = true;
-                    ARDOut << "mark to pfcache " <<
-                            lastCommonCacheWayPoint.first << ", " <<
-                            curWayBIndex << "\n";
-                    prevWaysIndexMap[curWayBIndex] = lastCommonCacheWayPoint;
-                }
-                lastCommonCacheWayPoint = { curWayBIndex, flowStack.size()-1 };
-                ARDOut << "lastCcwP: " << curWayBIndex << "\n";
-                continue;
+                oldWaitBlocks[i] = std::move(waitCodeBlocks[i]);
+                waitCodeBlocks[i] = WaitCodeBlock();
+                // states from blocks that will not be solved again
+                for (size_t prev: preds[i])
+                    if (!toSolve[prev])
+                        waitCodeBlocks[i].inState.join(waitCodeBlocks[prev].outState,
+                                    queuesNum);
             }
+    }
+    
+    std::deque<size_t> workList;
+    std::vector<bool> inWorkList(blocksNum, false);
+    for (size_t i = 0; i < blocksNum; i++)
+        if (toSolve[i])
+        {
+            workList.push_back(i);
+            inWorkList[i] = true;
         }
+    
+    auto joinToNext = [&](size_t next, const WaitQueueState& outState)
+    {
+        WaitCodeBlock& nextWBlock = waitCodeBlocks[next];
+        if (nextWBlock.inState.join(outState, queuesNum) || !nextWBlock.processed)
+            if (!inWorkList[next])
+            {
+                workList.push_back(next);
+                inWorkList[next] = true;
+            }
+    };
+    
+    while (!workList.empty())
+    {
+        const size_t i = workList.front();
+        workList.pop_front();
+        inWorkList[i] = false;
+        const CodeBlock& cblock = codeBlocks[i];
+        WaitCodeBlock& wblock = waitCodeBlocks[i];
         
-        if (!callStack.empty() &&
-            entry.blockIndex == callStack.back().callBlock.index &&
-            entry.nextIndex-1 == callStack.back().callNextIndex)
+        WaitQueueState oldOutState = wblock.outState;
+        if (!changed[i] && oldWaitBlocks[i].processed &&
+            oldWaitBlocks[i].inState.equal(wblock.inState, queuesNum))
         {
-            const BlockIndex routineBlock = callStack.back().routineBlock;
-            callBlocks.erase(routineBlock);
-            callStack.pop_back(); // just return from call
+            // unchanged block with this same state at start, results are same
+            wblock.outState = oldWaitBlocks[i].outState;
+            wblock.neededWaitInstrs = oldWaitBlocks[i].neededWaitInstrs;
         }
-        
-        if (entry.nextIndex < cblock.nexts.size())
+        else
         {
-            size_t nextBlock = cblock.nexts[entry.nextIndex].block;
-            //nextBlock.pass = entry.blockIndex.pass;
-            
-            flowStack.push_back(WaitFlowStackEntry0(nextBlock, 0, waitConfig));
-            entry.nextIndex++;
+            processWaitBlock(cblock, wblock, waitHandler, usageHandler, waitConfig,
+                    vregIndexMaps, graphColorMaps, regTypesNum, regRanges, onlyWarnings);
+            processedBlocksNum++;
         }
+        const bool outChanged = !wblock.processed ||
+                !oldOutState.equal(wblock.outState, queuesNum);
+        wblock.processed = true;
+        if (!outChanged)
+            continue;
         
-        else if (((entry.nextIndex==0 && cblock.nexts.empty()) ||
-                // if have any call then go to next block
-                (cblock.haveCalls && entry.nextIndex==cblock.nexts.size())) &&
-                 !cblock.haveReturn && !cblock.haveEnd)
+        for (size_t next: succs[i])
+            joinToNext(next, wblock.outState);
+    }
+    
+    // collect needed wait instructions from all code blocks
+    for (const WaitCodeBlock& wblock: waitCodeBlocks)
+        neededWaitInstrs.insert(neededWaitInstrs.end(), wblock.neededWaitInstrs.begin(),
+                    wblock.neededWaitInstrs.end());
+    std::stable_sort(neededWaitInstrs.begin(), neededWaitInstrs.end(),
+            [](const AsmWaitInstr& a, const AsmWaitInstr& b)
+            { return a.offset < b.offset; });
+    // join wait instructions at this same offset (choose minimal waits)
+    size_t j = 0;
+    for (size_t i = 0; i < neededWaitInstrs.size(); i++)
+    {
+        if (j != 0 && neededWaitInstrs[j-1].offset == neededWaitInstrs[i].offset)
         {
-            if (entry.nextIndex!=0) // if back from calls (just return from calls)
-            {
-            }
-            flowStack.push_back(WaitFlowStackEntry0(entry.blockIndex+1, 0, waitConfig));
-            entry.nextIndex++;
+            for (cxuint q = 0; q < queuesNum; q++)
+                neededWaitInstrs[j-1].waits[q] = std::min(neededWaitInstrs[j-1].waits[q],
+                            neededWaitInstrs[i].waits[q]);
         }
         else
-        {
-            // back
-            flowStack.pop_back();
-            
-            if (!flowStack.empty() && lastCommonCacheWayPoint.first != SIZE_MAX &&
-                    lastCommonCacheWayPoint.second >= flowStack.size())
-            {
-                lastCommonCacheWayPoint =
-                        { flowStack.back().blockIndex, flowStack.size()-1 };
-                ARDOut << "POPlastCcwP: " << lastCommonCacheWayPoint.first << "\n";
-            }
-        }
+            neededWaitInstrs[j++] = neededWaitInstrs[i];
+    }
+    neededWaitInstrs.resize(j);
+}
+
+// instruction of code block (for moving instructions before waits)
+struct CLRX_INTERNAL WaitBlockInstr
+{
+    size_t offset;
+    size_t size;
+    cxuint cycles;
+    cxbyte reorderClass;
+    bool fixed;     // contains fixed offset (can not be moved)
+    bool moved;
+    size_t accessStart; // register accesses in trace
+    size_t accessEnd;
+};
+
+/* move instructions that follow wait instructions before them, while latency of
+ * waited operations is not hidden. moved instruction must not access registers
+ * of pending operations and must not depend on crossed instructions.
+ * instructions are not moved if they are wait states required by hazards.
+ * cycles are estimated by execution in order (without stalls) */
+static void moveBlockInstrsBeforeWaits(const CodeBlock& cblock,
+        const std::vector<AsmWaitInstr>& waitInstrs, const WaitQueueState& inState,
+        const WaitBlockTrace& trace, const AsmWaitConfig& waitConfig,
+        const ISAAssembler* isaAssembler, size_t codeSize, const cxbyte* code,
+        const std::vector<size_t>& fixedOffsets, std::vector<AsmMovedInstr>& movedInstrs)
+{
+    const cxuint queuesNum = waitConfig.waitQueuesNum;
+    const std::vector<std::pair<size_t, uint16_t> >& regAccesses = trace.regAccesses;
+    std::vector<WaitBlockInstr> instrs;
+    size_t accessIdx = 0;
+    for (size_t offset = cblock.start; offset < std::min(cblock.end, codeSize); )
+    {
+        WaitBlockInstr instr{ offset };
+        instr.size = isaAssembler->getInstructionSize(codeSize - offset, code + offset);
+        if (instr.size == 0)
+            break;
+        instr.cycles = isaAssembler->getInstrSchedInfo(codeSize - offset, code + offset,
+                    instr.reorderClass);
+        auto fixedIt = std::lower_bound(fixedOffsets.begin(), fixedOffsets.end(), offset);
+        instr.fixed = fixedIt != fixedOffsets.end() && *fixedIt < offset + instr.size;
+        instr.moved = false;
+        for (; accessIdx < regAccesses.size() && regAccesses[accessIdx].first < offset;
+                    accessIdx++);
+        instr.accessStart = accessIdx;
+        for (; accessIdx < regAccesses.size() &&
+                    regAccesses[accessIdx].first < offset + instr.size; accessIdx++);
+        instr.accessEnd = accessIdx;
+        instrs.push_back(instr);
+        offset += instr.size;
     }
     
-    // after, that resolve joins (join with already visited code)
-    // next loop
-    flowStack.clear();
-    std::deque<FlowStackEntry2> flowStack2;
-    
-    std::fill(visited.begin(), visited.end(), false);
-    flowStack2.push_back({ 0, 0 });
-    SimpleCache<size_t, WaitFirstCacheEntry> resFirstPointsCache(codeBlocks.size()*256);
-    SimpleCache<size_t, WaitSecCacheEntry> resSecondPointsCache(codeBlocks.size()*128);
-    
-    while (!flowStack2.empty())
+    auto hasWaitAt = [&waitInstrs](size_t offset)
     {
-        FlowStackEntry2& entry = flowStack2.back();
-        const CodeBlock& cblock = codeBlocks[entry.blockIndex];
-        
-        if (entry.nextIndex == 0)
+        auto it = std::lower_bound(waitInstrs.begin(), waitInstrs.end(),
+                AsmWaitInstr{ offset }, [](const AsmWaitInstr& a, const AsmWaitInstr& b)
+                { return a.offset < b.offset; });
+        return it != waitInstrs.end() && it->offset == offset;
+    };
+    auto hasEnqueueAt = [&trace](size_t offset)
+    {
+        auto it = std::lower_bound(trace.enqueues.begin(), trace.enqueues.end(),
+                std::make_pair(offset, cxuint(0)));
+        return it != trace.enqueues.end() && it->first == offset;
+    };
+    
+    // cycles of enqueueing operations that are not finished (from oldest)
+    std::deque<uint64_t> enqueueCycles[ASM_WAIT_MAX_TYPES_NUM];
+    // operations enqueued before block are treated as enqueued at start of block
+    for (cxuint q = 0; q < queuesNum; q++)
+        if (!inState.empty(q))
+            enqueueCycles[q].push_back(0);
+    uint64_t cycle = 0;
+    size_t waitIdx = 0;
+    size_t pendingIdx = 0;
+    size_t enqueueIdx = 0;
+    std::unordered_set<uint16_t> crossReads;
+    std::unordered_set<uint16_t> crossWrites;
+    static const std::vector<uint16_t> noPendingRegs;
+    for (size_t k = 0; k < instrs.size(); k++)
+    {
+        const WaitBlockInstr& instr = instrs[k];
+        if (instr.moved)
+            continue; // already executed before previous wait instruction
+        for (; waitIdx < waitInstrs.size() && waitInstrs[waitIdx].offset < instr.offset;
+                    waitIdx++);
+        if (waitIdx < waitInstrs.size() && waitInstrs[waitIdx].offset == instr.offset)
         {
-            // process current block
-            if (!visited[entry.blockIndex])
-                visited[entry.blockIndex] = true;
-            else
+            // compute cycles needed to finish waited operations
+            const AsmWaitInstr& waitInstr = waitInstrs[waitIdx++];
+            int64_t gap = 0;
+            for (cxuint q = 0; q < queuesNum; q++)
             {
-                /*resolveSSAConflicts(flowStack2, routineMap, codeBlocks,
-                            prevWaysIndexMap, waysToCache, cblocksToCache,
-                            resFirstPointsCache, resSecondPointsCache, ssaReplacesMap);*/
-                
-                // back, already visited
-                flowStack2.pop_back();
-                continue;
+                std::deque<uint64_t>& enqCycles = enqueueCycles[q];
+                if (waitInstr.waits[q] >= enqCycles.size())
+                    continue;
+                const uint64_t enqCycle = enqCycles[enqCycles.size() -
+                            waitInstr.waits[q] - 1];
+                gap = std::max(gap, int64_t(enqCycle + waitConfig.waitQueueLatencies[q]) -
+                            int64_t(cycle));
+                enqCycles.erase(enqCycles.begin(), enqCycles.end() - waitInstr.waits[q]);
+            }
+            for (; pendingIdx < trace.waitPendings.size() &&
+                    trace.waitPendings[pendingIdx].first < instr.offset; pendingIdx++);
+            const std::vector<uint16_t>& pendingRegs =
+                    (pendingIdx < trace.waitPendings.size() &&
+                    trace.waitPendings[pendingIdx].first == instr.offset) ?
+                    trace.waitPendings[pendingIdx].second : noPendingRegs;
+            
+            /* instruction that stops moving. if it needs wait states after previous
+             * instructions (or it is end of block), then instructions just before it
+             * stay in place */
+            size_t stopIdx = k;
+            for (; stopIdx < instrs.size() &&
+                    instrs[stopIdx].reorderClass != ASMREORDER_NONE &&
+                    instrs[stopIdx].reorderClass != ASMREORDER_HAZARD; stopIdx++);
+            const size_t hazardIdx = (stopIdx == instrs.size() ||
+                    instrs[stopIdx].reorderClass == ASMREORDER_HAZARD) ?
+                    stopIdx : SIZE_MAX;
+            // instruction before which wait is put must stay after moved instructions
+            crossReads.clear();
+            crossWrites.clear();
+            // last crossed instruction
+            size_t lastCrossedIdx = k;
+            for (size_t j = k; gap > 0 && j < stopIdx; j++)
+            {
+                WaitBlockInstr& next = instrs[j];
+                if (next.moved)
+                    continue;
+                /* instructions that are wait states after crossed memory instructions
+                 * or before hazard stay in place */
+                bool movable = j != k && next.reorderClass == ASMREORDER_MOVE &&
+                        !next.fixed && !hasWaitAt(next.offset) &&
+                        !hasEnqueueAt(next.offset) &&
+                        instrs[lastCrossedIdx].reorderClass != ASMREORDER_CROSS &&
+                        (hazardIdx == SIZE_MAX ||
+                            hazardIdx - j > waitConfig.hazardWaitStates);
+                for (size_t a = next.accessStart; movable && a < next.accessEnd; a++)
+                {
+                    const uint16_t qreg = regAccesses[a].second;
+                    const uint16_t reg = qreg & 0x7fff;
+                    if (reg == spillTempReg ||
+                        std::binary_search(pendingRegs.begin(), pendingRegs.end(), reg) ||
+                        crossWrites.find(reg) != crossWrites.end() ||
+                        ((qreg & 0x8000) != 0 && crossReads.find(reg) != crossReads.end()))
+                        movable = false;
+                }
+                if (movable)
+                {
+                    movedInstrs.push_back({ next.offset, instr.offset });
+                    next.moved = true;
+                    cycle += next.cycles;
+                    gap -= next.cycles;
+                    continue;
+                }
+                // crossed instruction
+                lastCrossedIdx = j;
+                for (size_t a = next.accessStart; a < next.accessEnd; a++)
+                {
+                    const uint16_t qreg = regAccesses[a].second;
+                    if ((qreg & 0x8000) != 0)
+                        crossWrites.insert(qreg & 0x7fff);
+                    else
+                        crossReads.insert(qreg);
+                }
             }
         }
-        
-        if (entry.nextIndex < cblock.nexts.size())
-        {
-            flowStack2.push_back({ cblock.nexts[entry.nextIndex].block, 0 });
-            entry.nextIndex++;
-        }
-        else if (((entry.nextIndex==0 && cblock.nexts.empty()) ||
-                // if have any call then go to next block
-                (cblock.haveCalls && entry.nextIndex==cblock.nexts.size())) &&
-                 !cblock.haveReturn && !cblock.haveEnd)
-        {
-            flowStack2.push_back({ entry.blockIndex+1, 0 });
-            entry.nextIndex++;
-        }
-        else // back
+        // enqueue operations of this instruction
+        for (; enqueueIdx < trace.enqueues.size() &&
+                    trace.enqueues[enqueueIdx].first < instr.offset; enqueueIdx++);
+        for (; enqueueIdx < trace.enqueues.size() &&
+                    trace.enqueues[enqueueIdx].first == instr.offset; enqueueIdx++)
         {
-            /*if (cblocksToCache.count(entry.blockIndex)==2 &&
-                !resSecondPointsCache.hasKey(entry.blockIndex))
-                // add to cache
-                addResSecCacheEntry(routineMap, codeBlocks, resSecondPointsCache,
-                            entry.blockIndex);*/
-            flowStack2.pop_back();
+            const cxuint q = trace.enqueues[enqueueIdx].second;
+            enqueueCycles[q].push_back(cycle);
+            if (enqueueCycles[q].size() > waitConfig.waitQueueSizes[q])
+                enqueueCycles[q].pop_front();
         }
+        cycle += instr.cycles;
+    }
+}
+
+void AsmWaitScheduler::moveInstrsBeforeWaits(ISAUsageHandler& usageHandler,
+            ISAWaitHandler& waitHandler, size_t codeSize, const cxbyte* code,
+            const std::vector<size_t>& fixedOffsets)
+{
+    movedInstrs.clear();
+    if (blocksData == nullptr || onlyWarnings)
+        return;
+    cxuint regRanges[MAX_REGTYPES_NUM*2];
+    size_t regTypesNum;
+    assembler.isaAssembler->getRegisterRanges(regTypesNum, regRanges);
+    
+    for (size_t i = 0; i < codeBlocks.size(); i++)
+    {
+        const WaitCodeBlock& wblock = blocksData->waitBlocks[i];
+        if (wblock.neededWaitInstrs.empty())
+            continue;
+        // process block again to get register accesses and pending registers
+        WaitBlockTrace trace;
+        WaitCodeBlock traceWBlock;
+        traceWBlock.inState = wblock.inState;
+        processWaitBlock(codeBlocks[i], traceWBlock, waitHandler, usageHandler,
+                waitConfig, vregIndexMaps, graphColorMaps, regTypesNum, regRanges,
+                false, &trace);
+        moveBlockInstrsBeforeWaits(codeBlocks[i], wblock.neededWaitInstrs,
+                wblock.inState, trace, waitConfig, assembler.isaAssembler, codeSize,
+                code, fixedOffsets, movedInstrs);
     }
+    std::sort(movedInstrs.begin(), movedInstrs.end(),
+            [](const AsmMovedInstr& a, const AsmMovedInstr& b)
+            { return a.offset < b.offset; });
 }
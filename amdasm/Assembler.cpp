@@ -26,6 +26,7 @@
 #include <deque>
 #include <utility>
 #include <algorithm>
+#include <unordered_set>
 #include <CLRX/utils/Utilities.h>
 #include <CLRX/utils/MemAccess.h>
 #include <CLRX/utils/GPUId.h>
@@ -760,7 +761,7 @@ Assembler::Assembler(const CString& filename, std::istream& input, Flags _flags,
           deviceType(_deviceType),
           driverVersion(0), llvmVersion(0),
           _64bit(false), newROCmBinFormat(false),
-          policyVersion(ASM_POLICY_DEFAULT),
+          policyVersion(ASM_POLICY_DEFAULT), targetOccupancy(0), spillScratch{},
           isaAssembler(nullptr),
           // initialize global scope: adds '.' to symbols
           globalScope({nullptr,{std::make_pair(".", AsmSymbol(0, uint64_t(0)))}}),
@@ -800,7 +801,7 @@ Assembler::Assembler(const Array<CString>& _filenames, Flags _flags,
           deviceType(_deviceType),
           driverVersion(0), llvmVersion(0),
           _64bit(false), newROCmBinFormat(false),
-          policyVersion(ASM_POLICY_DEFAULT),
+          policyVersion(ASM_POLICY_DEFAULT), targetOccupancy(0), spillScratch{},
           isaAssembler(nullptr),
           // initialize global scope: adds '.' to symbols
           globalScope({nullptr,{std::make_pair(".", AsmSymbol(0, uint64_t(0)))}}),
@@ -2858,11 +2859,585 @@ void Assembler::printUnresolvedSymbols(AsmScope* thisScope)
     }
 }
 
+AsmSourcePos Assembler::findSourcePosByOffset(AsmSectionId sectionId, size_t offset)
+{
+    AsmSourcePosHandler& handler = sections[sectionId].sourcePosHandler;
+    AsmSourcePosHandler::ReadPos rpos = handler.findPositionByOffset(offset);
+    AsmSourcePos sourcePos{};
+    // get last source position before or at this offset
+    while (handler.hasNext(rpos))
+    {
+        const std::pair<size_t, AsmSourcePos> entry = handler.nextSourcePos(rpos);
+        if (entry.first > offset)
+            break;
+        sourcePos = entry.second;
+        if (entry.first == offset)
+            break;
+    }
+    return sourcePos;
+}
+
+void Assembler::updateKernelsAllocRegs(AsmSectionId sectionId,
+            const std::vector<AsmRegAllocator::AllocRegRange>& allocRegRanges,
+            size_t spillScratchSize)
+{
+    if (formatHandler == nullptr || allocRegRanges.empty())
+        return;
+    const AsmKernelId sectKernelId = sections[sectionId].kernelId;
+    for (AsmKernelId k = 0; k < kernels.size(); k++)
+    {
+        if (sectKernelId != k && sectKernelId != ASMKERN_GLOBAL)
+            continue;
+        const std::vector<std::pair<size_t, size_t> >& regions = kernels[k].codeRegions;
+        cxuint regs[MAX_REGTYPES_NUM] = { };
+        bool used = false;
+        for (const AsmRegAllocator::AllocRegRange& range: allocRegRanges)
+        {
+            if (sectKernelId != k)
+            {
+                // code of many kernels, check whether usage is in kernel code
+                bool inRegion = false;
+                for (const std::pair<size_t, size_t>& region: regions)
+                    if (range.offset >= region.first && range.offset < region.second)
+                    {
+                        inRegion = true;
+                        break;
+                    }
+                if (!inRegion)
+                    continue;
+            }
+            regs[range.regType] = std::max(regs[range.regType], range.rend);
+            used = true;
+        }
+        if (!used)
+            continue;
+        formatHandler->updateKernelAllocRegs(k, regs);
+        AsmKernelOccupancy& occupancy = kernelOccupancies[k];
+        occupancy.allocated = true;
+        for (size_t r = 0; r < MAX_REGTYPES_NUM; r++)
+            occupancy.regsNum[r] = std::max(occupancy.regsNum[r], regs[r]);
+        occupancy.spillScratchSize = std::max(occupancy.spillScratchSize,
+                    spillScratchSize);
+    }
+}
+
+void Assembler::countKernelsRemovedInstrs(AsmSectionId sectionId,
+            const std::vector<size_t>& removedInstrs)
+{
+    if (removedInstrs.empty())
+        return;
+    const AsmKernelId sectKernelId = sections[sectionId].kernelId;
+    for (AsmKernelId k = 0; k < kernels.size(); k++)
+    {
+        if (sectKernelId != k && sectKernelId != ASMKERN_GLOBAL)
+            continue;
+        size_t removedNum = 0;
+        for (size_t offset: removedInstrs)
+        {
+            if (sectKernelId != k)
+            {
+                // code of many kernels, check whether instruction is in kernel code
+                bool inRegion = false;
+                for (const std::pair<size_t, size_t>& region: kernels[k].codeRegions)
+                    if (offset >= region.first && offset < region.second)
+                    {
+                        inRegion = true;
+                        break;
+                    }
+                if (!inRegion)
+                    continue;
+            }
+            removedNum++;
+        }
+        kernelOccupancies[k].eliminatedCopies += removedNum;
+    }
+}
+
+void Assembler::computeKernelOccupancies()
+{
+    const GPUArchitecture arch = getGPUArchitectureFromDeviceType(deviceType);
+    for (AsmKernelId k = 0; k < kernels.size(); k++)
+    {
+        AsmKernelOccupancy& occupancy = kernelOccupancies[k];
+        if (!occupancy.allocated)
+            continue;
+        occupancy.targetWaves = (kernels[k].targetOccupancy != 0) ?
+                kernels[k].targetOccupancy : targetOccupancy;
+        // VCC is always counted to SGPRs
+        occupancy.regsNum[REGTYPE_SGPR] += getGPUExtraRegsNum(arch, REGTYPE_SGPR,
+                    GCN_VCC);
+        occupancy.waves = GPU_MAX_WAVES_PER_SIMD;
+        for (cxuint r = REGTYPE_SGPR; r <= REGTYPE_VGPR; r++)
+        {
+            if (occupancy.targetWaves != 0)
+                occupancy.regsLimits[r] = getGPUMaxRegsNumForWaves(arch, r,
+                            occupancy.targetWaves);
+            occupancy.regWaves[r] = getGPUWavesNumForRegs(arch, r, occupancy.regsNum[r]);
+            occupancy.waves = std::min(occupancy.waves, occupancy.regWaves[r]);
+        }
+        // work group size is not known, assume 256 work items (4 waves)
+        occupancy.localSize = formatHandler->getKernelLocalSize(k);
+        occupancy.localSizeWaves = getGPUWavesNumForLocalSize(arch,
+                    occupancy.localSize, 256);
+        occupancy.waves = std::min(occupancy.waves, occupancy.localSizeWaves);
+    }
+}
+
+void Assembler::writeOccupancyReport(std::ostream& os) const
+{
+    for (AsmKernelId k = 0; k < kernelOccupancies.size(); k++)
+    {
+        const AsmKernelOccupancy& occupancy = kernelOccupancies[k];
+        if (!occupancy.allocated)
+            continue;
+        os << "Kernel " << kernels[k].name << ":\n"
+            "  Waves per SIMD: " << occupancy.waves;
+        if (occupancy.targetWaves != 0)
+            os << " (target: " << occupancy.targetWaves << ")";
+        os << "\n  SGPRs: " << occupancy.regsNum[REGTYPE_SGPR];
+        if (occupancy.targetWaves != 0)
+            os << " (limit: " << occupancy.regsLimits[REGTYPE_SGPR] << ")";
+        os << ", waves: " << occupancy.regWaves[REGTYPE_SGPR] << "\n"
+            "  VGPRs: " << occupancy.regsNum[REGTYPE_VGPR];
+        if (occupancy.targetWaves != 0)
+            os << " (limit: " << occupancy.regsLimits[REGTYPE_VGPR] << ")";
+        os << ", waves: " << occupancy.regWaves[REGTYPE_VGPR] << "\n"
+            "  LDS: " << occupancy.localSize << ", waves: " <<
+            occupancy.localSizeWaves << "\n";
+        if ((flags & ASM_COALESCE) != 0)
+            os << "  Eliminated copies: " << occupancy.eliminatedCopies << "\n";
+        if (occupancy.spillScratchSize != 0)
+            os << "  Spill scratch: " << occupancy.spillScratchSize <<
+                    " bytes per lane\n";
+    }
+    os.flush();
+}
+
+// shifts of offsets after inserting code
+/* insertion keys: offset*2 for code inserted after previous instruction,
+ * offset*2+1 for code inserted before instruction (and removed instruction).
+ * shifts are sums of inserted sizes minus removed sizes (modulo size_t) */
+struct CLRX_INTERNAL AsmCodeInsertShifts
+{
+    const std::vector<size_t>& insKeys;
+    const std::vector<size_t>& insShifts;
+    
+    // shift for instruction offset (instruction at insertion point will be moved)
+    size_t instr(size_t offset) const
+    {
+        return insShifts[std::upper_bound(insKeys.begin(), insKeys.end(),
+                    (offset<<1)+1) - insKeys.begin()];
+    }
+    // shift for label (label at insertion point will point to code inserted
+    // before instruction)
+    size_t label(size_t offset) const
+    {
+        return insShifts[std::lower_bound(insKeys.begin(), insKeys.end(),
+                    (offset<<1)+1) - insKeys.begin()];
+    }
+};
+
+static void shiftSymbolsAfterInsertion(AsmScope* scope, AsmSectionId sectionId,
+            const AsmCodeInsertShifts& shifts, std::unordered_set<AsmExpression*>& exprs)
+{
+    for (AsmSymbolEntry& symEntry: scope->symbolMap)
+    {
+        AsmSymbol& symbol = symEntry.second;
+        if (symbol.hasValue && !symbol.regRange && symbol.sectionId == sectionId)
+            symbol.value += shifts.label(symbol.value);
+        for (const AsmExprSymbolOccurrence& occur: symbol.occurrencesInExprs)
+            exprs.insert(occur.expression);
+    }
+    for (const auto& entry: scope->scopeMap)
+        shiftSymbolsAfterInsertion(entry.second, sectionId, shifts, exprs);
+}
+
+static inline bool isSpillSave(const AsmSpillInstr& spillInstr)
+{
+    return spillInstr.type == AsmSpillType::SAVE_SGPR ||
+            spillInstr.type == AsmSpillType::SAVE_VGPR;
+}
+
+// collect expressions that refer symbols from scope and its subscopes
+static void collectSymbolExprs(const AsmScope* scope,
+            std::unordered_set<AsmExpression*>& exprs)
+{
+    for (const AsmSymbolEntry& symEntry: scope->symbolMap)
+        for (const AsmExprSymbolOccurrence& occur: symEntry.second.occurrencesInExprs)
+            exprs.insert(occur.expression);
+    for (const auto& entry: scope->scopeMap)
+        collectSymbolExprs(entry.second, exprs);
+}
+
+void Assembler::getFixedCodeOffsets(AsmSectionId sectionId, std::vector<size_t>& offsets)
+{
+    offsets.clear();
+    for (const AsmRelocation& reloc: relocations)
+        if (reloc.sectionId == sectionId)
+            offsets.push_back(reloc.offset);
+    std::unordered_set<AsmExpression*> exprs(unevalExpressions.begin(),
+                unevalExpressions.end());
+    collectSymbolExprs(&globalScope, exprs);
+    for (AsmSymbolEntry* symEntry: symbolClones)
+        for (const AsmExprSymbolOccurrence& occur: symEntry->second.occurrencesInExprs)
+            exprs.insert(occur.expression);
+    for (AsmExpression* expr: exprs)
+    {
+        if (expr == nullptr)
+            continue;
+        const AsmExprTarget& target = expr->getTarget();
+        if (target.type != ASMXTGT_SYMBOL && target.type != ASMXTGT_CODEFLOW &&
+            target.sectionId == sectionId)
+            offsets.push_back(target.offset);
+    }
+    std::sort(offsets.begin(), offsets.end());
+    offsets.resize(std::unique(offsets.begin(), offsets.end()) - offsets.begin());
+}
+
+void Assembler::insertCode(AsmSectionId sectionId,
+            const std::vector<AsmWaitInstr>& waitInstrs,
+            const std::vector<AsmSpillInstr>& spillInstrs,
+            const std::vector<size_t>& removedInstrs,
+            const std::vector<AsmMovedInstr>& movedInstrs)
+{
+    AsmSection& section = sections[sectionId];
+    std::vector<cxbyte>& content = section.content;
+    std::vector<size_t> insKeys;
+    std::vector<cxbyte> insCode;
+    // start positions of inserted instructions in insCode (last is size of insCode)
+    std::vector<size_t> insCodePos;
+    insCodePos.push_back(0);
+    // sizes of removed instructions after inserted code
+    std::vector<size_t> insRemoved;
+    std::vector<cxbyte> waitCode;
+    auto pushInsertion = [&insKeys, &insCode, &insCodePos, &insRemoved](size_t key,
+                const std::vector<cxbyte>& code, size_t removedSize)
+    {
+        if (code.empty() && removedSize == 0)
+            return;
+        insKeys.push_back(key);
+        insCode.insert(insCode.end(), code.begin(), code.end());
+        insCodePos.push_back(insCode.size());
+        insRemoved.push_back(removedSize);
+    };
+    
+    // spill instructions are sorted by offset, save instructions first
+    auto spillIt = spillInstrs.begin();
+    // encode spill instructions at offset (saves or restores)
+    auto encodeSpills = [this, &spillIt, &spillInstrs](size_t offset, bool save,
+                std::vector<cxbyte>& output)
+    {
+        auto spillEnd = spillIt;
+        for (; spillEnd != spillInstrs.end() && spillEnd->offset == offset &&
+                isSpillSave(*spillEnd) == save; ++spillEnd);
+        if (spillEnd != spillIt)
+            isaAssembler->encodeSpillInstrs(spillEnd - spillIt, &*spillIt, output);
+        spillIt = spillEnd;
+    };
+    // moved instructions are removed from their places
+    std::vector<size_t> allRemovedInstrs(removedInstrs);
+    for (const AsmMovedInstr& movedInstr: movedInstrs)
+        allRemovedInstrs.push_back(movedInstr.offset);
+    std::sort(allRemovedInstrs.begin(), allRemovedInstrs.end());
+    // moved instructions sorted by target (in original order)
+    std::vector<AsmMovedInstr> targetMovedInstrs(movedInstrs);
+    std::stable_sort(targetMovedInstrs.begin(), targetMovedInstrs.end(),
+            [](const AsmMovedInstr& a, const AsmMovedInstr& b)
+            { return a.target < b.target; });
+    
+    auto waitIt = waitInstrs.begin();
+    auto removedIt = allRemovedInstrs.begin();
+    auto movedIt = targetMovedInstrs.begin();
+    while (waitIt != waitInstrs.end() || spillIt != spillInstrs.end() ||
+        removedIt != allRemovedInstrs.end() || movedIt != targetMovedInstrs.end())
+    {
+        const size_t offset = std::min(std::min(std::min(
+                (waitIt != waitInstrs.end()) ? waitIt->offset : SIZE_MAX,
+                (spillIt != spillInstrs.end()) ? spillIt->offset : SIZE_MAX),
+                (removedIt != allRemovedInstrs.end()) ? *removedIt : SIZE_MAX),
+                (movedIt != targetMovedInstrs.end()) ? movedIt->target : SIZE_MAX);
+        waitCode.clear();
+        // save spilled registers after previous instruction
+        encodeSpills(offset, true, waitCode);
+        pushInsertion(offset<<1, waitCode, 0);
+        
+        waitCode.clear();
+        // moved instructions are put before wait instruction
+        for (; movedIt != targetMovedInstrs.end() && movedIt->target == offset; ++movedIt)
+        {
+            const size_t movedSize = isaAssembler->getInstructionSize(
+                        content.size() - movedIt->offset, content.data() + movedIt->offset);
+            waitCode.insert(waitCode.end(), content.begin() + movedIt->offset,
+                        content.begin() + movedIt->offset + movedSize);
+        }
+        if (waitIt != waitInstrs.end() && waitIt->offset == offset)
+        {
+            const AsmWaitInstr& waitInstr = *waitIt++;
+            const size_t waitCodePos = waitCode.size();
+            isaAssembler->encodeWaitInstr(waitInstr, waitCode);
+            // check whether user wait instruction is at this offset
+            bool replace = false;
+            ISAWaitHandler::ReadPos wpos = section.waitHandler->findPositionByOffset(
+                        waitInstr.offset);
+            AsmDelayedOp delOp;
+            AsmWaitInstr oldWaitInstr;
+            while (section.waitHandler->hasNext(wpos))
+            {
+                const bool isWait = section.waitHandler->nextInstr(wpos, delOp,
+                            oldWaitInstr);
+                if ((isWait ? oldWaitInstr.offset : delOp.offset) != waitInstr.offset)
+                    break;
+                if (isWait)
+                {
+                    replace = true;
+                    break;
+                }
+            }
+            if (replace && waitInstr.offset < content.size() &&
+                isaAssembler->getInstructionSize(content.size() - waitInstr.offset,
+                        content.data() + waitInstr.offset) ==
+                        waitCode.size() - waitCodePos)
+            {
+                // replace user wait instruction
+                std::copy(waitCode.begin() + waitCodePos, waitCode.end(),
+                          content.begin() + waitInstr.offset);
+                waitCode.resize(waitCodePos);
+            }
+        }
+        // restore spilled registers before instruction
+        encodeSpills(offset, false, waitCode);
+        size_t removedSize = 0;
+        if (removedIt != allRemovedInstrs.end() && *removedIt == offset)
+        {
+            removedSize = isaAssembler->getInstructionSize(content.size() - offset,
+                        content.data() + offset);
+            ++removedIt;
+        }
+        pushInsertion((offset<<1)+1, waitCode, removedSize);
+    }
+    if (insKeys.empty())
+        return;
+    
+    // build new content
+    std::vector<cxbyte> newContent;
+    newContent.reserve(content.size() + insCode.size());
+    // shifts of offsets after insertions
+    std::vector<size_t> insShifts;
+    insShifts.push_back(0);
+    size_t prevOffset = 0;
+    for (size_t i = 0; i < insKeys.size(); i++)
+    {
+        const size_t insOffset = insKeys[i]>>1;
+        newContent.insert(newContent.end(), content.begin() + prevOffset,
+                    content.begin() + insOffset);
+        newContent.insert(newContent.end(), insCode.begin() + insCodePos[i],
+                    insCode.begin() + insCodePos[i+1]);
+        prevOffset = insOffset + insRemoved[i];
+        insShifts.push_back(insShifts.back() + (insCodePos[i+1]-insCodePos[i]) -
+                    insRemoved[i]);
+    }
+    newContent.insert(newContent.end(), content.begin() + prevOffset, content.end());
+    content.swap(newContent);
+    
+    const AsmCodeInsertShifts shifts{ insKeys, insShifts };
+    
+    // values already computed from labels can not be changed
+    for (const AsmCodeLabelsDiff& diff: codeLabelsDiffs)
+        if (diff.sectionId == sectionId &&
+            shifts.label(diff.minOffset) != shifts.label(diff.maxOffset))
+            printError(diff.sourcePos, "Value computed from labels is changed by "
+                        "inserted or removed code");
+    
+    /* source positions: inserted instruction gets position of next instruction,
+     * positions of removed instructions are dropped */
+    {
+        AsmSourcePosHandler newSourcePosHandler;
+        AsmSourcePosHandler& oldHandler = section.sourcePosHandler;
+        AsmSourcePosHandler::ReadPos rpos{ 0, 0 };
+        size_t insIndex = 0;
+        while (oldHandler.hasNext(rpos))
+        {
+            const std::pair<size_t, AsmSourcePos> entry = oldHandler.nextSourcePos(rpos);
+            for (; insIndex < insKeys.size() && (insKeys[insIndex]>>1) <= entry.first;
+                        insIndex++)
+                if (insCodePos[insIndex] != insCodePos[insIndex+1])
+                    newSourcePosHandler.pushSourcePos((insKeys[insIndex]>>1) +
+                            insShifts[insIndex], entry.second);
+            if (insIndex != 0 && (insKeys[insIndex-1]>>1) == entry.first &&
+                insRemoved[insIndex-1] != 0)
+                continue;
+            newSourcePosHandler.pushSourcePos(entry.first + shifts.instr(entry.first),
+                        entry.second);
+        }
+        section.sourcePosHandler = newSourcePosHandler;
+    }
+    
+    // code flow
+    for (AsmCodeFlowEntry& entry: section.codeFlow)
+        if (entry.type == AsmCodeFlowType::START || entry.type == AsmCodeFlowType::END)
+            entry.offset += shifts.label(entry.offset);
+        else
+        {
+            entry.offset += shifts.instr(entry.offset);
+            if (entry.type == AsmCodeFlowType::JUMP ||
+                entry.type == AsmCodeFlowType::CJUMP || entry.type == AsmCodeFlowType::CALL)
+                entry.target += shifts.label(entry.target);
+        }
+    
+    // symbols and pending expressions
+    std::unordered_set<AsmExpression*> exprs;
+    shiftSymbolsAfterInsertion(&globalScope, sectionId, shifts, exprs);
+    for (AsmSymbolEntry* symEntry: symbolClones)
+    {
+        AsmSymbol& symbol = symEntry->second;
+        if (symbol.hasValue && !symbol.regRange && symbol.sectionId == sectionId)
+            symbol.value += shifts.label(symbol.value);
+        for (const AsmExprSymbolOccurrence& occur: symbol.occurrencesInExprs)
+            exprs.insert(occur.expression);
+    }
+    for (AsmExpression* expr: unevalExpressions)
+        exprs.insert(expr);
+    for (AsmExpression* expr: exprs)
+    {
+        if (expr == nullptr)
+            continue;
+        AsmExprTarget target = expr->getTarget();
+        if (target.type != ASMXTGT_SYMBOL && target.type != ASMXTGT_CODEFLOW &&
+            target.sectionId == sectionId)
+        {
+            target.offset += shifts.instr(target.offset);
+            expr->setTarget(target);
+        }
+    }
+    
+    // relocations
+    for (AsmRelocation& reloc: relocations)
+    {
+        if (reloc.sectionId == sectionId)
+            reloc.offset += shifts.instr(reloc.offset);
+        if (reloc.relSectionId == sectionId)
+            reloc.addend += shifts.label(reloc.addend);
+    }
+    
+    // kernel code regions
+    if (section.kernelId == ASMKERN_GLOBAL)
+        for (AsmKernel& kernel: kernels)
+            for (std::pair<size_t, size_t>& region: kernel.codeRegions)
+            {
+                region.first += shifts.label(region.first);
+                if (region.second != SIZE_MAX)
+                    region.second += shifts.label(region.second);
+            }
+    
+    // encode again jumps
+    for (const AsmCodeFlowEntry& entry: section.codeFlow)
+        if (entry.type == AsmCodeFlowType::JUMP ||
+            entry.type == AsmCodeFlowType::CJUMP || entry.type == AsmCodeFlowType::CALL)
+            isaAssembler->resolveJump(findSourcePosByOffset(sectionId, entry.offset),
+                        content.data(), entry.offset, entry.target);
+    
+    if (currentSection == sectionId)
+        currentOutPos = content.size();
+}
+
+void Assembler::allocateRegsAndInsertWaits()
+{
+    AsmParallelRegAllocator parRegAlloc(*this);
+    try
+    { parRegAlloc.allocateRegisters(); }
+    catch(const AsmException& ex)
+    {
+        const AsmSectionId failedSectionId = parRegAlloc.getFailedSectionId();
+        printError((failedSectionId != ASMSECT_NONE) ?
+                findSourcePosByOffset(failedSectionId, 0) : AsmSourcePos(), ex.what());
+        return;
+    }
+    const std::vector<AsmSectionId>& sectionIds = parRegAlloc.getSectionIds();
+    kernelOccupancies.assign(kernels.size(), AsmKernelOccupancy{});
+    for (size_t i = 0; i < sectionIds.size(); i++)
+    {
+        const AsmRegAllocator& regAlloc = parRegAlloc.getRegAllocator(i);
+        for (size_t k = 0; k < regAlloc.getLinearDepsFailures(); k++)
+            printError(findSourcePosByOffset(sectionIds[i], 0), "Linear deps failed");
+        for (cxuint r = REGTYPE_SGPR; r <= REGTYPE_VGPR; r++)
+            if (regAlloc.isTargetOccupancyMissed(r))
+            {
+                char buf[80];
+                snprintf(buf, 80, "Target occupancy %u can't be reached, "
+                        "too many %s are needed", regAlloc.getTargetOccupancy(),
+                        (r == REGTYPE_SGPR) ? "SGPRs" : "VGPRs");
+                printWarning(findSourcePosByOffset(sectionIds[i], 0), buf);
+            }
+        std::vector<AsmRegAllocator::AllocRegRange> allocRegRanges;
+        if (parRegAlloc.getRegAllocator(i).applyAllocatedRegisters(sectionIds[i],
+                    allocRegRanges))
+        {
+            const size_t spillScratchSize = regAlloc.getSpillScratchSize();
+            if (spillScratchSize != 0)
+            {
+                // scratch buffer is set up by user, so just inform about its size
+                char buf[80];
+                snprintf(buf, 80, "Spilled VGPRs need %u bytes of scratch per lane",
+                        cxuint(spillScratchSize));
+                printWarning(findSourcePosByOffset(sectionIds[i], 0), buf);
+            }
+            updateKernelsAllocRegs(sectionIds[i], allocRegRanges, spillScratchSize);
+            countKernelsRemovedInstrs(sectionIds[i], regAlloc.getRemovedInstrs());
+        }
+    }
+    computeKernelOccupancies();
+    if (!good)
+        return;
+    
+    for (size_t i = 0; i < sectionIds.size(); i++)
+    {
+        AsmSection& section = sections[sectionIds[i]];
+        const AsmRegAllocator& regAlloc = parRegAlloc.getRegAllocator(i);
+        if ((flags & ASM_AUTOWAIT) == 0 || section.usageHandler == nullptr ||
+            section.waitHandler == nullptr)
+        {
+            insertCode(sectionIds[i], std::vector<AsmWaitInstr>(),
+                       regAlloc.getSpillInstrs(), regAlloc.getRemovedInstrs(),
+                       std::vector<AsmMovedInstr>());
+            continue;
+        }
+        AsmWaitScheduler waitScheduler(isaAssembler->getWaitConfig(), *this,
+                regAlloc.getCodeBlocks(), regAlloc.getVregIndexMaps(),
+                regAlloc.getGraphColorMaps(), false);
+        try
+        { waitScheduler.schedule(*section.usageHandler, *section.waitHandler); }
+        catch(const AsmException& ex)
+        {
+            printError(findSourcePosByOffset(sectionIds[i], 0), ex.what());
+            continue;
+        }
+        if ((flags & ASM_LATENCYWAIT) != 0)
+        {
+            // relocations, expressions and removed instructions stay in place
+            std::vector<size_t> fixedOffsets;
+            getFixedCodeOffsets(sectionIds[i], fixedOffsets);
+            const std::vector<size_t>& removedInstrs = regAlloc.getRemovedInstrs();
+            fixedOffsets.insert(fixedOffsets.end(), removedInstrs.begin(),
+                        removedInstrs.end());
+            std::sort(fixedOffsets.begin(), fixedOffsets.end());
+            waitScheduler.moveInstrsBeforeWaits(*section.usageHandler,
+                    *section.waitHandler, section.content.size(),
+                    section.content.data(), fixedOffsets);
+        }
+        insertCode(sectionIds[i], waitScheduler.getNeededWaitInstrs(),
+                   regAlloc.getSpillInstrs(), regAlloc.getRemovedInstrs(),
+                   waitScheduler.getMovedInstrs());
+    }
+}
+
 bool Assembler::assemble()
 {
     resolvingRelocs = false;
     doNotRemoveFromSymbolClones = false;
     sectionDiffsPrepared = false;
+    // source positions are needed to report errors after allocation
+    if ((flags & (ASM_ALLOCREGS|ASM_AUTOWAIT)) != 0)
+        collectSourcePoses = true;
     
     for (const DefSym& defSym: defSyms)
         if (defSym.first!=".")
@@ -3099,6 +3674,10 @@ bool Assembler::assemble()
         clauses.pop();
     }
     
+    if (good && (flags & (ASM_ALLOCREGS|ASM_AUTOWAIT)) != 0 && isaAssembler != nullptr)
+        // allocate registers for regvars and insert wait instructions
+        allocateRegsAndInsertWaits();
+    
     if (withSectionDiffs())
     {
         formatHandler->prepareSectionDiffsResolving();
@@ -3160,10 +3739,13 @@ void Assembler::writeBinary(const char* filename) const
         if (formatHandler!=nullptr)
         {
             std::ofstream ofs(filename, std::ios::binary);
-            if (ofs)
-                formatHandler->writeBinary(ofs);
-            else
+            if (!ofs)
                 throw AsmException(std::string("Can't open output file '")+filename+"'");
+            // generate whole binary in memory and write it at once
+            Array<cxbyte> array;
+            formatHandler->writeBinary(array);
+            ofs.exceptions(std::ios::failbit | std::ios::badbit);
+            ofs.write(reinterpret_cast<const char*>(array.data()), array.size());
         }
         else
             throw AsmException("No output binary");
@@ -25,6 +25,10 @@
 #include <string>
 #include <ostream>
 #include <utility>
+#include <cstring>
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
 #include <CLRX/utils/Utilities.h>
 #include <CLRX/amdbin/AmdBinaries.h>
 #include <CLRX/amdbin/AmdCL2Binaries.h>
@@ -35,6 +39,81 @@
 namespace CLRX
 {
 
+/* fast table-driven number formatting for disassembler output */
+
+// table of two hexadecimal digits for every byte value
+extern CLRX_INTERNAL const char disasmHexDigitPairs[513];
+// table of two decimal digits for values from 0 to 99
+extern CLRX_INTERNAL const char disasmDecDigitPairs[201];
+
+// put 32-bit value as 8 hexadecimal digits (without prefix)
+static inline void putHexU32ToBuf(uint32_t value, char* buf)
+{
+#ifdef __SSSE3__
+    // split bytes to nibbles and translate them to digits by shuffle
+    const __m128i mask0f = _mm_set1_epi8(0xf);
+    const __m128i v = _mm_cvtsi32_si128(value);
+    const __m128i nibbles = _mm_unpacklo_epi8(
+            _mm_and_si128(_mm_srli_epi16(v, 4), mask0f), _mm_and_si128(v, mask0f));
+    // reverse order of bytes (most significant byte first)
+    const __m128i ordered = _mm_shuffle_epi8(nibbles, _mm_setr_epi8(
+            6, 7, 4, 5, 2, 3, 0, 1, -1, -1, -1, -1, -1, -1, -1, -1));
+    const __m128i digits = _mm_shuffle_epi8(_mm_setr_epi8('0', '1', '2', '3',
+            '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'), ordered);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(buf), digits);
+#else
+    ::memcpy(buf, disasmHexDigitPairs + ((value>>23)&0x1fe), 2);
+    ::memcpy(buf+2, disasmHexDigitPairs + ((value>>15)&0x1fe), 2);
+    ::memcpy(buf+4, disasmHexDigitPairs + ((value>>7)&0x1fe), 2);
+    ::memcpy(buf+6, disasmHexDigitPairs + ((value&0xff)<<1), 2);
+#endif
+}
+
+// put 32-bit value in hexadecimal with '0x' prefix and without leading zeroes,
+// returns number of chars
+static inline size_t putHexU32CStyleToBuf(uint32_t value, char* buf)
+{
+    char tmp[8];
+    putHexU32ToBuf(value, tmp);
+    cxuint digitsNum = 8;
+    for (; digitsNum > 1 && tmp[8-digitsNum] == '0'; digitsNum--);
+    buf[0] = '0';
+    buf[1] = 'x';
+    ::memcpy(buf+2, tmp+8-digitsNum, digitsNum);
+    return digitsNum+2;
+}
+
+// put byte value as two hexadecimal digits (without prefix)
+static inline void putHexU8ToBuf(cxuint value, char* buf)
+{
+    ::memcpy(buf, disasmHexDigitPairs + ((value&0xff)<<1), 2);
+}
+
+// put unsigned value in decimal (without leading zeroes), returns number of chars
+static inline size_t putDecU32ToBuf(uint32_t value, char* buf)
+{
+    char tmp[10];
+    char* p = tmp+10;
+    // two digits at a time
+    while (value >= 100U)
+    {
+        const uint32_t q = value/100U;
+        p -= 2;
+        ::memcpy(p, disasmDecDigitPairs + ((value - q*100U)<<1), 2);
+        value = q;
+    }
+    if (value >= 10U)
+    {
+        p -= 2;
+        ::memcpy(p, disasmDecDigitPairs + (value<<1), 2);
+    }
+    else
+        *--p = '0'+value;
+    const size_t len = tmp+10-p;
+    ::memcpy(buf, p, len);
+    return len;
+}
+
 // print data in bytes in assembler format (secondAlign add extra align)
 extern CLRX_INTERNAL void printDisasmData(size_t size, const cxbyte* data,
               std::ostream& output, bool secondAlign = false);
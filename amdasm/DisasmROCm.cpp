@@ -85,6 +85,7 @@ ROCmDisasmInput* CLRX::getROCmDisasmInputFromBinary(const ROCmBinary& binary)
     input->codeSize = binary.getCodeSize();
     input->metadata = binary.getMetadata();
     input->metadataSize = binary.getMetadataSize();
+    input->metadataMsgPack = binary.isMetadataMsgPack();
     input->globalData = binary.getGlobalData();
     input->globalDataSize = binary.getGlobalDataSize();
     input->target = binary.getTarget();
@@ -822,7 +823,11 @@ void CLRX::disassembleROCm(std::ostream& output, const ROCmDisasmInput* rocmInpu
     bool haveMetadataInfo = false;
     if (doDumpConfig && rocmInput->metadata!=nullptr)
     {
-        metadataInfo.parse(rocmInput->metadataSize, rocmInput->metadata);
+        if (rocmInput->metadataMsgPack)
+            metadataInfo.parseMsgPack(rocmInput->metadataSize,
+                        reinterpret_cast<const cxbyte*>(rocmInput->metadata));
+        else
+            metadataInfo.parse(rocmInput->metadataSize, rocmInput->metadata);
         haveMetadataInfo = true;
     }
     
@@ -845,6 +850,8 @@ void CLRX::disassembleROCm(std::ostream& output, const ROCmDisasmInput* rocmInpu
     
     if (rocmInput->newBinFormat)
         output.write(".newbinfmt\n", 11);
+    if (rocmInput->metadataMsgPack)
+        output.write(".md_msgpack\n", 12);
     
     if (!rocmInput->target.empty())
     {
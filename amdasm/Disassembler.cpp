@@ -40,7 +40,8 @@ DisasmException::DisasmException(const std::string& message) : Exception(message
 
 ISADisassembler::ISADisassembler(Disassembler& _disassembler, cxuint outBufSize)
         : disassembler(_disassembler), startOffset(0), labelStartOffset(0),
-          dontPrintLabelsAfterCode(false), output(outBufSize, _disassembler.getOutput())
+          dontPrintLabelsAfterCode(false), instrOutOfCode(false),
+          output(outBufSize, _disassembler.getOutput())
 { }
 
 ISADisassembler::~ISADisassembler()
@@ -263,16 +264,53 @@ bool ISADisassembler::writeRelocation(size_t pos, RelocIter& relocIter)
     return true;
 }
 
+void ISADisassembler::addLabel(size_t pos)
+{
+    /* labels at aligned positions near code are stored in bitmap (no sorting needed),
+     * other labels (unaligned or far out of code) are stored in labels list */
+    if ((pos&3) == 0 && pos < startOffset + inputSize + (size_t(1)<<18))
+    {
+        const size_t wordPos = pos>>2;
+        if ((wordPos>>6) >= labelBitmap.size())
+            labelBitmap.resize((wordPos>>6)+1, 0);
+        labelBitmap[wordPos>>6] |= (uint64_t(1)<<(wordPos&63));
+    }
+    else
+        labels.push_back(pos);
+}
+
 void ISADisassembler::clearNumberedLabels()
 {
     labels.clear();
+    labelBitmap.clear();
 }
 
 void ISADisassembler::prepareLabelsAndRelocations()
 {
+    // sort labels out of bitmap (usually only few)
     std::sort(labels.begin(), labels.end());
     const auto newEnd = std::unique(labels.begin(), labels.end());
     labels.resize(newEnd-labels.begin());
+    if (!labelBitmap.empty())
+    {
+        // merge with labels from bitmap (already sorted and without duplicates)
+        std::vector<size_t> newLabels;
+        newLabels.reserve(labels.size() + labelBitmap.size());
+        auto lit = labels.begin();
+        for (size_t i = 0; i < labelBitmap.size(); i++)
+            for (uint64_t mask = labelBitmap[i]; mask != 0; mask &= mask-1)
+            {
+                const size_t pos = ((i<<6) + CTZ64(mask))<<2;
+                for (; lit != labels.end() && *lit < pos; ++lit)
+                    newLabels.push_back(*lit);
+                if (lit != labels.end() && *lit == pos)
+                    ++lit; // skip duplicate
+                newLabels.push_back(pos);
+            }
+        newLabels.insert(newLabels.end(), lit, labels.end());
+        labels.swap(newLabels);
+        labelBitmap.clear();
+    }
     mapSort(namedLabels.begin(), namedLabels.end());
     mapSort(relocations.begin(), relocations.end());
 }
@@ -371,7 +409,19 @@ Disassembler::Disassembler(GPUDeviceType deviceType, size_t rawCodeSize,
          output(_output), flags(_flags), sectionCount(0)
 {
     isaDisassembler.reset(new GCNDisassembler(*this));
-    rawInput = new RawCodeInput{ deviceType, rawCodeSize, rawCode };
+    rawInput = new RawCodeInput{ deviceType, rawCodeSize, rawCode, nullptr, 0 };
+}
+
+Disassembler::Disassembler(GPUDeviceType deviceType, std::istream& rawCodeStream,
+           std::ostream& _output, Flags _flags, size_t codeWindowSize)
+       : fromBinary(true), binaryFormat(BinaryFormat::RAWCODE),
+         output(_output), flags(_flags), sectionCount(0)
+{
+    if ((codeWindowSize & 3) != 0)
+        throw DisasmException("Code window size must be multiple of 4");
+    isaDisassembler.reset(new GCNDisassembler(*this));
+    rawInput = new RawCodeInput{ deviceType, 0, nullptr, &rawCodeStream,
+                codeWindowSize };
 }
 
 Disassembler::~Disassembler()
@@ -416,6 +466,25 @@ GPUDeviceType Disassembler::getDeviceType() const
     }
 }
 
+// table of two hexadecimal digits for every byte value
+const char CLRX::disasmHexDigitPairs[513] =
+    "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f"
+    "202122232425262728292a2b2c2d2e2f303132333435363738393a3b3c3d3e3f"
+    "404142434445464748494a4b4c4d4e4f505152535455565758595a5b5c5d5e5f"
+    "606162636465666768696a6b6c6d6e6f707172737475767778797a7b7c7d7e7f"
+    "808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f"
+    "a0a1a2a3a4a5a6a7a8a9aaabacadaeafb0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+    "c0c1c2c3c4c5c6c7c8c9cacbcccdcecfd0d1d2d3d4d5d6d7d8d9dadbdcdddedf"
+    "e0e1e2e3e4e5e6e7e8e9eaebecedeeeff0f1f2f3f4f5f6f7f8f9fafbfcfdfeff";
+
+// table of two decimal digits for values from 0 to 99
+const char CLRX::disasmDecDigitPairs[201] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
 void CLRX::printDisasmData(size_t size, const cxbyte* data, std::ostream& output,
                 bool secondAlign)
 {
@@ -449,7 +518,10 @@ void CLRX::printDisasmData(size_t size, const cxbyte* data, std::ostream& output
             memcpy(buf+bufPos, ", 1, ", 5);
             bufPos += 5;
             // value to fill
-            bufPos += itocstrCStyle(data[oldP], buf+bufPos, 6, 16, 2);
+            buf[bufPos++] = '0';
+            buf[bufPos++] = 'x';
+            putHexU8ToBuf(data[oldP], buf+bufPos);
+            bufPos += 2;
             buf[bufPos++] = '\n';
             output.write(buf, bufPos);
             ::memcpy(buf, linePrefix, prefixSize);
@@ -463,19 +535,9 @@ void CLRX::printDisasmData(size_t size, const cxbyte* data, std::ostream& output
         {
             buf[bufPos++] = '0';
             buf[bufPos++] = 'x';
-            {
-                // inline byte in hexadecimal
-                cxuint digit = data[p]>>4;
-                if (digit < 10)
-                    buf[bufPos++] = '0'+digit;
-                else
-                    buf[bufPos++] = 'a'+digit-10;
-                digit = data[p]&0xf;
-                if (digit < 10)
-                    buf[bufPos++] = '0'+digit;
-                else
-                    buf[bufPos++] = 'a'+digit-10;
-            }
+            // inline byte in hexadecimal
+            putHexU8ToBuf(data[p], buf+bufPos);
+            bufPos += 2;
             if (p+1 < lineEnd)
             {
                 buf[bufPos++] = ',';
@@ -522,7 +584,10 @@ void CLRX::printDisasmDataU32(size_t size, const uint32_t* data, std::ostream& o
             memcpy(buf+bufPos, ", 4, ", 5);
             bufPos += 5;
             // print fill value
-            bufPos += itocstrCStyle(ULEV(data[oldP]), buf+bufPos, 12, 16, 8);
+            buf[bufPos++] = '0';
+            buf[bufPos++] = 'x';
+            putHexU32ToBuf(ULEV(data[oldP]), buf+bufPos);
+            bufPos += 8;
             buf[bufPos++] = '\n';
             output.write(buf, bufPos);
             ::memcpy(buf, linePrefix, fillPrefixSize);
@@ -534,7 +599,10 @@ void CLRX::printDisasmDataU32(size_t size, const uint32_t* data, std::ostream& o
         // print four or less (if end of data) dwords
         for (; p < lineEnd; p++)
         {
-            bufPos += itocstrCStyle(ULEV(data[p]), buf+bufPos, 12, 16, 8);
+            buf[bufPos++] = '0';
+            buf[bufPos++] = 'x';
+            putHexU32ToBuf(ULEV(data[p]), buf+bufPos);
+            bufPos += 8;
             if (p+1 < lineEnd)
             {
                 buf[bufPos++] = ',';
@@ -577,10 +645,103 @@ void CLRX::printDisasmLongString(size_t size, const char* data, std::ostream& ou
     }
 }
 
+// default size of window for raw code read from stream (must be multiple of 4)
+static const size_t defaultRawCodeWindowSize = 1U<<20;
+
+// read window of raw code from stream
+static size_t readRawCodeWindow(std::istream& is, size_t offset, size_t size,
+                cxbyte* buffer)
+{
+    is.clear();
+    is.seekg(offset, std::ios::beg);
+    if (is.fail())
+        throw DisasmException("Can't seek raw code stream");
+    is.read(reinterpret_cast<char*>(buffer), size);
+    if (is.bad())
+        throw DisasmException("Can't read raw code stream");
+    return is.gcount();
+}
+
+/* first pass of raw code from stream - collect labels from all windows
+ * (labels are kept in bitmap) and determine windows boundaries
+ * at instruction boundaries. returns window start offsets,
+ * last element is end of code */
+static std::vector<size_t> analyzeRawCodeStream(std::istream& is, size_t windowSize,
+       ISADisassembler* isaDisassembler, Array<cxbyte>& window, bool& lastInstrOutOfCode)
+{
+    // get code size
+    is.clear();
+    is.seekg(0, std::ios::end);
+    const std::streamoff streamSize = is.tellg();
+    if (is.fail() || streamSize < 0)
+        throw DisasmException("Can't get size of raw code stream");
+    const size_t codeSize = streamSize;
+    
+    std::vector<size_t> windowOffsets;
+    lastInstrOutOfCode = false;
+    isaDisassembler->clearNumberedLabels();
+    size_t offset = 0;
+    do {
+        const size_t readSize = readRawCodeWindow(is, offset,
+                    std::min(windowSize, codeSize-offset), window.data());
+        if (readSize == 0 && offset != codeSize)
+            throw DisasmException("Can't read raw code stream");
+        windowOffsets.push_back(offset);
+        isaDisassembler->setInput(readSize, window.data(), offset);
+        isaDisassembler->analyzeBeforeDisassemble();
+        lastInstrOutOfCode = isaDisassembler->isInstrOutOfCode();
+        offset += readSize;
+        if (lastInstrOutOfCode && offset+4 <= codeSize)
+        {
+            // skip second word of last instruction (it belongs to this window)
+            offset += 4;
+            lastInstrOutOfCode = false;
+        }
+        else if (lastInstrOutOfCode)
+            offset = codeSize; // rest of code belongs to unfinished instruction
+    } while (offset < codeSize);
+    windowOffsets.push_back(offset);
+    isaDisassembler->prepareLabelsAndRelocations();
+    return windowOffsets;
+}
+
+/* disassemble raw code from stream in two passes:
+ * first pass - collect labels from all windows (labels are kept in bitmap)
+ * second pass - disassemble windows. windows boundaries are placed
+ * at instruction boundaries (determined in first pass) */
+static void disassembleRawCodeStream(std::istream& is, size_t windowSize,
+       ISADisassembler* isaDisassembler)
+{
+    Array<cxbyte> window(windowSize+4);
+    bool lastInstrOutOfCode = false;
+    const std::vector<size_t> windowOffsets = analyzeRawCodeStream(is, windowSize,
+                isaDisassembler, window, lastInstrOutOfCode);
+    
+    for (size_t i = 0; i+1 < windowOffsets.size(); i++)
+    {
+        const bool lastWindow = (i+2 == windowOffsets.size());
+        const size_t windowOffset = windowOffsets[i];
+        // include literal of last instruction of window
+        const size_t readSize = readRawCodeWindow(is, windowOffset,
+                    windowOffsets[i+1] - windowOffset, window.data());
+        isaDisassembler->setInput(readSize, window.data(), windowOffset,
+                    (i!=0) ? windowOffset+1 : 0);
+        isaDisassembler->setInstrOutOfCode(lastWindow && lastInstrOutOfCode);
+        isaDisassembler->setDontPrintLabels(!lastWindow);
+        isaDisassembler->disassemble();
+    }
+}
+
 static void disassembleRawCode(std::ostream& output, const RawCodeInput* rawInput,
        ISADisassembler* isaDisassembler, Flags flags)
 {
-    if ((flags & DISASM_DUMPCODE) != 0)
+    if ((flags & DISASM_DUMPCODE) != 0 && rawInput->codeStream != nullptr)
+    {
+        output.write(".text\n", 6);
+        disassembleRawCodeStream(*rawInput->codeStream, (rawInput->codeWindowSize!=0) ?
+                rawInput->codeWindowSize : defaultRawCodeWindowSize, isaDisassembler);
+    }
+    else if ((flags & DISASM_DUMPCODE) != 0)
     {
         output.write(".text\n", 6);
         isaDisassembler->setInput(rawInput->codeSize, rawInput->code);
@@ -650,3 +811,282 @@ void Disassembler::disassemble()
     }
     output.exceptions(oldExceptions);
 }
+
+/*
+ * code statistics
+ */
+
+// collect statistics for single code region
+static GCNCodeStats collectGCNRegionStats(GCNDisassembler& gcnDisasm, size_t codeSize,
+            const cxbyte* code)
+{
+    GCNCodeStats stats;
+    gcnDisasm.setInput(codeSize, code);
+    gcnDisasm.beforeDisassemble();
+    gcnDisasm.collectStats(stats);
+    return stats;
+}
+
+std::vector<std::pair<CString, GCNCodeStats> > Disassembler::collectCodeStats()
+{
+    std::vector<std::pair<CString, GCNCodeStats> > stats;
+    GCNDisassembler gcnDisasm(*this);
+    switch(binaryFormat)
+    {
+        case BinaryFormat::AMD:
+            for (const AmdDisasmKernelInput& kinput: amdInput->kernels)
+                stats.push_back(std::make_pair(kinput.kernelName,
+                        collectGCNRegionStats(gcnDisasm, kinput.codeSize, kinput.code)));
+            break;
+        case BinaryFormat::AMDCL2:
+            for (const AmdCL2DisasmKernelInput& kinput: amdCL2Input->kernels)
+                stats.push_back(std::make_pair(kinput.kernelName,
+                        collectGCNRegionStats(gcnDisasm, kinput.codeSize, kinput.code)));
+            break;
+        case BinaryFormat::ROCM:
+            for (const ROCmDisasmRegionInput& region: rocmInput->regions)
+            {
+                if (region.type == ROCmRegionType::DATA)
+                    continue;
+                // skip kernel descriptor (256 bytes) before kernel code
+                const size_t codeOffset = region.offset + 256;
+                if (codeOffset > rocmInput->codeSize ||
+                    codeOffset > region.offset + region.size)
+                    throw DisasmException("Region Offset out of range");
+                const size_t codeSize = std::min(region.offset + region.size,
+                        rocmInput->codeSize) - codeOffset;
+                stats.push_back(std::make_pair(region.regionName,
+                        collectGCNRegionStats(gcnDisasm, codeSize,
+                                    rocmInput->code + codeOffset)));
+            }
+            break;
+        case BinaryFormat::GALLIUM:
+        {
+            // kernel code ends at start of next kernel code
+            std::vector<size_t> offsets;
+            for (const GalliumDisasmKernelInput& kinput: galliumInput->kernels)
+                offsets.push_back(kinput.offset);
+            offsets.push_back(galliumInput->codeSize);
+            std::sort(offsets.begin(), offsets.end());
+            for (const GalliumDisasmKernelInput& kinput: galliumInput->kernels)
+            {
+                if (kinput.offset > galliumInput->codeSize)
+                    throw DisasmException("Kernel code offset out of range");
+                const size_t codeEnd = *std::upper_bound(offsets.begin(),
+                        offsets.end()-1, size_t(kinput.offset));
+                stats.push_back(std::make_pair(kinput.kernelName,
+                        collectGCNRegionStats(gcnDisasm, codeEnd - kinput.offset,
+                                    galliumInput->code + kinput.offset)));
+            }
+            break;
+        }
+        default:
+            if (rawInput->codeStream != nullptr)
+            {
+                // collect statistics from windows of code (like in disassembling)
+                std::istream& is = *rawInput->codeStream;
+                const size_t windowSize = (rawInput->codeWindowSize!=0) ?
+                        rawInput->codeWindowSize : defaultRawCodeWindowSize;
+                Array<cxbyte> window(windowSize+4);
+                bool lastInstrOutOfCode = false;
+                const std::vector<size_t> windowOffsets = analyzeRawCodeStream(is,
+                        windowSize, &gcnDisasm, window, lastInstrOutOfCode);
+                GCNCodeStats codeStats;
+                for (size_t i = 0; i+1 < windowOffsets.size(); i++)
+                {
+                    const size_t readSize = readRawCodeWindow(is, windowOffsets[i],
+                            windowOffsets[i+1] - windowOffsets[i], window.data());
+                    gcnDisasm.setInput(readSize, window.data(), windowOffsets[i]);
+                    gcnDisasm.collectStats(codeStats, i!=0);
+                }
+                stats.push_back(std::make_pair(CString(), codeStats));
+            }
+            else
+                stats.push_back(std::make_pair(CString(),
+                        collectGCNRegionStats(gcnDisasm, rawInput->codeSize,
+                                    rawInput->code)));
+            break;
+    }
+    return stats;
+}
+
+static const char* gcnStatsCategoryNames[GCNSTATS_CATEGORIES_NUM] =
+{ "SALU", "VALU", "SMEM", "VMEM", "LDS", "EXP", "ILLEGAL" };
+
+// write JSON string with escaping
+static void writeJSONString(std::ostream& output, const char* str)
+{
+    output.put('"');
+    for (; *str != 0; str++)
+    {
+        const cxbyte c = *str;
+        if (c == '"' || c == '\\')
+        {
+            output.put('\\');
+            output.put(c);
+        }
+        else if (c < 0x20)
+        {
+            char buf[8] = "\\u00";
+            buf[4] = "0123456789abcdef"[c>>4];
+            buf[5] = "0123456789abcdef"[c&15];
+            output.write(buf, 6);
+        }
+        else
+            output.put(c);
+    }
+    output.put('"');
+}
+
+// write JSON object with counts
+static void writeJSONCounts(std::ostream& output, const char* name,
+            const std::vector<std::pair<CString, size_t> >& counts)
+{
+    output << ",\n    \"" << name << "\": {";
+    for (size_t i = 0; i < counts.size(); i++)
+    {
+        output << ((i!=0) ? ",\n      " : "\n      ");
+        writeJSONString(output, counts[i].first.c_str());
+        output << ": " << counts[i].second;
+    }
+    output << (counts.empty() ? "}" : "\n    }");
+}
+
+// write JSON object of kernel statistics (file name is written if not null)
+static void writeJSONKernelStats(std::ostream& output, const char* fileName,
+            const CString& kernelName, const GCNCodeStats& kstats, bool first)
+{
+    output << (first ? "\n  {\n    " : ",\n  {\n    ");
+    if (fileName != nullptr)
+    {
+        output << "\"file\": ";
+        writeJSONString(output, fileName);
+        output << ",\n    ";
+    }
+    output << "\"kernel\": ";
+    writeJSONString(output, kernelName.c_str());
+    output << ",\n    \"codeSize\": " << kstats.codeSize <<
+        ",\n    \"instrsNum\": " << kstats.instrsNum <<
+        ",\n    \"literalsNum\": " << kstats.literalsNum <<
+        ",\n    \"sdwaNum\": " << kstats.sdwaNum <<
+        ",\n    \"dppNum\": " << kstats.dppNum <<
+        ",\n    \"sgprsNum\": " << kstats.sgprsNum <<
+        ",\n    \"vgprsNum\": " << kstats.vgprsNum <<
+        ",\n    \"categories\": {";
+    for (cxuint i = 0; i < GCNSTATS_CATEGORIES_NUM; i++)
+        output << ((i!=0) ? ",\n      \"" : "\n      \"") <<
+                gcnStatsCategoryNames[i] << "\": " << kstats.categoryCounts[i];
+    output << "\n    }";
+    writeJSONCounts(output, "encodings", kstats.encodingCounts);
+    writeJSONCounts(output, "mnemonics", kstats.mnemonicCounts);
+    output << ",\n    \"blocks\": [";
+    for (size_t i = 0; i < kstats.blocks.size(); i++)
+    {
+        const GCNCodeStats::Block& block = kstats.blocks[i];
+        output << ((i!=0) ? ",\n      " : "\n      ") <<
+            "{ \"offset\": " << block.offset << ", \"size\": " << block.size <<
+            ", \"instrsNum\": " << block.instrsNum << " }";
+    }
+    output << (kstats.blocks.empty() ? "]" : "\n    ]") << "\n  }";
+}
+
+void CLRX::writeGCNCodeStatsJSON(std::ostream& output,
+            const std::vector<std::pair<CString, GCNCodeStats> >& stats)
+{
+    output << "[";
+    for (size_t k = 0; k < stats.size(); k++)
+        writeJSONKernelStats(output, nullptr, stats[k].first, stats[k].second, k==0);
+    output << (stats.empty() ? "]\n" : "\n]\n");
+}
+
+void CLRX::writeGCNCodeStatsJSON(std::ostream& output,
+            const std::vector<GCNFileCodeStats>& filesStats)
+{
+    output << "[";
+    bool first = true;
+    for (const GCNFileCodeStats& fileStats: filesStats)
+        for (const auto& entry: fileStats.second)
+        {
+            writeJSONKernelStats(output, fileStats.first.c_str(), entry.first,
+                        entry.second, first);
+            first = false;
+        }
+    output << (first ? "]\n" : "\n]\n");
+}
+
+// write CSV field with quoting (if needed)
+static void writeCSVField(std::ostream& output, const char* str)
+{
+    if (::strpbrk(str, ",\"\n\r") == nullptr)
+    {
+        output << str;
+        return;
+    }
+    output.put('"');
+    for (; *str != 0; str++)
+    {
+        if (*str == '"')
+            output.put('"');
+        output.put(*str);
+    }
+    output.put('"');
+}
+
+// write single CSV row: [file,]kernel,group,key,value
+static void writeCSVRow(std::ostream& output, const char* fileName,
+            const CString& kernelName, const char* group, const char* key, size_t value)
+{
+    if (fileName != nullptr)
+    {
+        writeCSVField(output, fileName);
+        output.put(',');
+    }
+    writeCSVField(output, kernelName.c_str());
+    output << ',' << group << ',';
+    writeCSVField(output, key);
+    output << ',' << value << '\n';
+}
+
+// write CSV rows of kernel statistics (file name is written if not null)
+static void writeCSVKernelStats(std::ostream& output, const char* fileName,
+            const CString& kname, const GCNCodeStats& kstats)
+{
+    writeCSVRow(output, fileName, kname, "code", "codeSize", kstats.codeSize);
+    writeCSVRow(output, fileName, kname, "code", "instrsNum", kstats.instrsNum);
+    writeCSVRow(output, fileName, kname, "code", "literalsNum", kstats.literalsNum);
+    writeCSVRow(output, fileName, kname, "code", "sdwaNum", kstats.sdwaNum);
+    writeCSVRow(output, fileName, kname, "code", "dppNum", kstats.dppNum);
+    writeCSVRow(output, fileName, kname, "code", "sgprsNum", kstats.sgprsNum);
+    writeCSVRow(output, fileName, kname, "code", "vgprsNum", kstats.vgprsNum);
+    for (cxuint i = 0; i < GCNSTATS_CATEGORIES_NUM; i++)
+        writeCSVRow(output, fileName, kname, "category", gcnStatsCategoryNames[i],
+                    kstats.categoryCounts[i]);
+    for (const auto& enc: kstats.encodingCounts)
+        writeCSVRow(output, fileName, kname, "encoding", enc.first.c_str(), enc.second);
+    for (const auto& mn: kstats.mnemonicCounts)
+        writeCSVRow(output, fileName, kname, "mnemonic", mn.first.c_str(), mn.second);
+    for (const GCNCodeStats::Block& block: kstats.blocks)
+    {
+        char key[24];
+        itocstrCStyle(block.offset, key, 24, 16);
+        writeCSVRow(output, fileName, kname, "block", key, block.instrsNum);
+    }
+}
+
+void CLRX::writeGCNCodeStatsCSV(std::ostream& output,
+            const std::vector<std::pair<CString, GCNCodeStats> >& stats)
+{
+    output << "kernel,group,key,value\n";
+    for (const auto& entry: stats)
+        writeCSVKernelStats(output, nullptr, entry.first, entry.second);
+}
+
+void CLRX::writeGCNCodeStatsCSV(std::ostream& output,
+            const std::vector<GCNFileCodeStats>& filesStats)
+{
+    output << "file,kernel,group,key,value\n";
+    for (const GCNFileCodeStats& fileStats: filesStats)
+        for (const auto& entry: fileStats.second)
+            writeCSVKernelStats(output, fileStats.first.c_str(), entry.first,
+                        entry.second);
+}
@@ -29,6 +29,7 @@
 #include <CLRX/utils/GPUId.h>
 #include <CLRX/amdasm/GCNDefs.h>
 #include "GCNAsmInternals.h"
+#include "GCNDisasmInternals.h"
 
 using namespace CLRX;
 
@@ -145,7 +146,8 @@ void GCNUsageHandler::getUsageDependencies(cxuint rvusNum, const AsmRegVarUsage*
             continue;
         const AsmRegField rf = rvus[i].regField;
         if (rf == GCNFIELD_M_VDATA || rf == GCNFIELD_M_VDATAH ||
-            rf == GCNFIELD_M_VDATALAST ||
+            rf == GCNFIELD_M_VDATALAST || rf == GCNFIELD_SMRD_SDST ||
+            rf == GCNFIELD_SMRD_SDSTH ||
             rf == GCNFIELD_FLAT_VDST || rf == GCNFIELD_FLAT_VDSTLAST)
             linearDeps[2 + count++] = i;
     }
@@ -316,8 +318,10 @@ void GCNAssembler::assemble(const CString& inMnemonic, const char* mnemPlace,
         default:
             break;
     }
-    // register RegVarUsage in tests, do not apply normal usage
-    if (good && (assembler.getFlags() & ASM_TESTRUN) != 0)
+    /* register RegVarUsage in tests, for code analysis, register allocation
+     * or for inserting wait instructions, do not apply normal usage */
+    if (good && (assembler.getFlags() & (ASM_TESTRUN|ASM_CODEANALYSIS|
+                ASM_ALLOCREGS|ASM_AUTOWAIT)) != 0)
     {
         flushInstrRVUs(usageHandler);
         flushWaitInstrs(waitHandler);
@@ -357,13 +361,8 @@ bool GCNAssembler::resolveCode(const AsmSourcePos& sourcePos, cxuint targetSecti
             if (sectionId != targetSectionId)
                 // if jump outside current section (.text)
                 GCN_FAIL_BY_ERROR(sourcePos, "Jump over current section!")
-            int64_t outOffset = (int64_t(value)-int64_t(offset)-4);
-            if (outOffset & 3)
-                GCN_FAIL_BY_ERROR(sourcePos, "Jump is not aligned to word!")
-            outOffset >>= 2;
-            if (outOffset > INT16_MAX || outOffset < INT16_MIN)
-                GCN_FAIL_BY_ERROR(sourcePos, "Jump out of range!")
-            SULEV(*reinterpret_cast<uint16_t*>(sectionData+offset), outOffset);
+            if (!resolveJump(sourcePos, sectionData, offset, value))
+                return false;
             uint16_t insnCode = ULEV(*reinterpret_cast<uint16_t*>(sectionData+offset+2));
             // add codeflow entry
             addCodeFlowEntry(sectionId, { size_t(offset), size_t(value),
@@ -458,6 +457,31 @@ bool GCNAssembler::resolveCode(const AsmSourcePos& sourcePos, cxuint targetSecti
     }
 }
 
+// encode again jump offset after code insertion
+bool GCNAssembler::resolveJump(const AsmSourcePos& sourcePos, cxbyte* sectionData,
+            size_t offset, size_t target)
+{
+    const uint32_t word = ULEV(*reinterpret_cast<const uint32_t*>(sectionData+offset));
+    const cxuint soppOpcode = (word>>16) & 0x7f;
+    const cxuint sopkOpcode = (word>>23) & 0x1f;
+    /* only SOPP branches, S_CBRANCH_I_FORK and S_CALL_B64 have jump offset
+     * (other instructions can be from '.cf_jump') */
+    if (!((word>>23) == 0x17f && (soppOpcode == 2 ||
+            (soppOpcode >= 4 && soppOpcode <= 9) ||
+            (soppOpcode >= 23 && soppOpcode <= 26))) &&
+        !((word>>28) == 0xb && (sopkOpcode == 0x10 || sopkOpcode == 0x11 ||
+            sopkOpcode == 0x15)))
+        return true;
+    int64_t outOffset = (int64_t(target)-int64_t(offset)-4);
+    if (outOffset & 3)
+        GCN_FAIL_BY_ERROR(sourcePos, "Jump is not aligned to word!")
+    outOffset >>= 2;
+    if (outOffset > INT16_MAX || outOffset < INT16_MIN)
+        GCN_FAIL_BY_ERROR(sourcePos, "Jump out of range!")
+    SULEV(*reinterpret_cast<uint16_t*>(sectionData+offset), outOffset);
+    return true;
+}
+
 // check whether name is mnemonic (currently unused anywhere)
 bool GCNAssembler::checkMnemonic(const CString& inMnemonic) const
 {
@@ -716,7 +740,9 @@ static const AsmWaitConfig gcnWaitConfig10 =
         { GCNWAIT_EXPCNT, true, true, 255 },  // GCNDELOP_EXPVMWRITE
         { GCNWAIT_EXPCNT, false, false, 255 }  // GCNDELOP_EXPORT
     },
-    { 16, 8, 8 }
+    { 16, 8, 8 },
+    { 400, 64, 16 },  // latencies: VMCNT, LGKMCNT, EXPCNT
+    5   // VALU write SGPR -> VMEM read that SGPR
 };
 
 
@@ -733,7 +759,9 @@ static const AsmWaitConfig gcnWaitConfig =
         { GCNWAIT_EXPCNT, true, true, 255 },  // GCNDELOP_EXPVMWRITE
         { GCNWAIT_EXPCNT, false, true, 255 }  // GCNDELOP_EXPORT
     },
-    { 16, 16, 8 }
+    { 16, 16, 8 },
+    { 400, 64, 16 },  // latencies: VMCNT, LGKMCNT, EXPCNT
+    5   // VALU write SGPR -> VMEM read that SGPR
 };
 
 // for RX VEGA
@@ -750,7 +778,9 @@ static const AsmWaitConfig gcnWaitConfig14 =
         { GCNWAIT_EXPCNT, true, true, 255 },  // GCNDELOP_EXPVMWRITE
         { GCNWAIT_EXPCNT, false, true, 255 }  // GCNDELOP_EXPORT
     },
-    { 64, 16, 8 }
+    { 64, 16, 8 },
+    { 400, 64, 16 },  // latencies: VMCNT, LGKMCNT, EXPCNT
+    5   // VALU write SGPR -> VMEM read that SGPR
 };
 
 const AsmWaitConfig& GCNAssembler::getWaitConfig() const
@@ -759,3 +789,346 @@ const AsmWaitConfig& GCNAssembler::getWaitConfig() const
         return gcnWaitConfig10;
     return (curArchMask&ARCH_GCN_1_4)!=0 ? gcnWaitConfig14 : gcnWaitConfig;
 }
+
+// set bitfield in 32-bit word of instruction
+static inline void setGCNBitField(cxbyte* data, size_t offset, cxuint shift, cxuint bits,
+            uint32_t value)
+{
+    uint32_t word = ULEV(*reinterpret_cast<const uint32_t*>(data+offset));
+    const uint32_t mask = ((1U<<bits)-1U)<<shift;
+    word = (word & ~mask) | ((value<<shift) & mask);
+    SULEV(*reinterpret_cast<uint32_t*>(data+offset), word);
+}
+
+bool GCNAssembler::resolveRegVarField(cxbyte* sectionData, size_t offset,
+            AsmRegField regField, cxuint rreg)
+{
+    const bool isGCN12 = (curArchMask & ARCH_GCN_1_2_4)!=0;
+    // for 8-bit VGPR fields (VGPR index without 256)
+    const cxuint vreg = rreg & 0xff;
+    switch(regField)
+    {
+        case GCNFIELD_SSRC0:
+            setGCNBitField(sectionData, offset, 0, 8, rreg);
+            break;
+        case GCNFIELD_SSRC1:
+            setGCNBitField(sectionData, offset, 8, 8, rreg);
+            break;
+        case GCNFIELD_SDST:
+            setGCNBitField(sectionData, offset, 16, 7, rreg);
+            break;
+        case GCNFIELD_SMRD_SBASE:
+            setGCNBitField(sectionData, offset, isGCN12 ? 0 : 9, 6, rreg>>1);
+            break;
+        case GCNFIELD_SMRD_SDST:
+            setGCNBitField(sectionData, offset, isGCN12 ? 6 : 15, 7, rreg);
+            break;
+        case GCNFIELD_SMRD_SOFFSET:
+            if (!isGCN12)
+                setGCNBitField(sectionData, offset, 0, 8, rreg);
+            // SMEM: if SOE bit is set then SOFFSET is in top bits of second word
+            else if ((ULEV(*reinterpret_cast<const uint32_t*>(sectionData+offset)) &
+                        0x4000U) != 0)
+                setGCNBitField(sectionData, offset+4, 25, 7, rreg);
+            else
+                setGCNBitField(sectionData, offset+4, 0, 8, rreg);
+            break;
+        case GCNFIELD_VOP_SRC0:
+            setGCNBitField(sectionData, offset, 0, 9, rreg);
+            break;
+        case GCNFIELD_VOP_VSRC1:
+            setGCNBitField(sectionData, offset, 9, 8, vreg);
+            break;
+        case GCNFIELD_VOP_SSRC1:
+            setGCNBitField(sectionData, offset, 9, 8, rreg);
+            break;
+        case GCNFIELD_VOP_VDST:
+            setGCNBitField(sectionData, offset, 17, 8, vreg);
+            break;
+        case GCNFIELD_VOP_SDST:
+            setGCNBitField(sectionData, offset, 17, 8, rreg);
+            break;
+        case GCNFIELD_VOP3_SRC0:
+            setGCNBitField(sectionData, offset+4, 0, 9, rreg);
+            break;
+        case GCNFIELD_VOP3_SRC1:
+            setGCNBitField(sectionData, offset+4, 9, 9, rreg);
+            break;
+        case GCNFIELD_VOP3_SRC2:
+        case GCNFIELD_VOP3_SSRC:
+            setGCNBitField(sectionData, offset+4, 18, 9, rreg);
+            break;
+        case GCNFIELD_VOP3_VDST:
+            setGCNBitField(sectionData, offset, 0, 8, vreg);
+            break;
+        case GCNFIELD_VOP3_SDST0:
+            setGCNBitField(sectionData, offset, 0, 8, rreg);
+            break;
+        case GCNFIELD_VOP3_SDST1:
+            setGCNBitField(sectionData, offset, 8, 7, rreg);
+            break;
+        case GCNFIELD_VINTRP_VSRC0:
+            setGCNBitField(sectionData, offset, 0, 8, vreg);
+            break;
+        case GCNFIELD_VINTRP_VDST:
+            setGCNBitField(sectionData, offset, 18, 8, vreg);
+            break;
+        case GCNFIELD_DS_ADDR:
+        case GCNFIELD_M_VADDR:
+        case GCNFIELD_FLAT_ADDR:
+        case GCNFIELD_EXP_VSRC0:
+        case GCNFIELD_DPPSDWA_SRC0:
+            setGCNBitField(sectionData, offset+4, 0, 8, vreg);
+            break;
+        case GCNFIELD_DS_DATA0:
+        case GCNFIELD_M_VDATA:
+        case GCNFIELD_FLAT_DATA:
+        case GCNFIELD_EXP_VSRC1:
+            setGCNBitField(sectionData, offset+4, 8, 8, vreg);
+            break;
+        case GCNFIELD_DS_DATA1:
+        case GCNFIELD_EXP_VSRC2:
+            setGCNBitField(sectionData, offset+4, 16, 8, vreg);
+            break;
+        case GCNFIELD_DS_VDST:
+        case GCNFIELD_FLAT_VDST:
+        case GCNFIELD_EXP_VSRC3:
+            setGCNBitField(sectionData, offset+4, 24, 8, vreg);
+            break;
+        case GCNFIELD_M_SRSRC:
+            setGCNBitField(sectionData, offset+4, 16, 5, rreg>>2);
+            break;
+        case GCNFIELD_MIMG_SSAMP:
+            setGCNBitField(sectionData, offset+4, 21, 5, rreg>>2);
+            break;
+        case GCNFIELD_M_SOFFSET:
+            setGCNBitField(sectionData, offset+4, 24, 8, rreg);
+            break;
+        case GCNFIELD_FLAT_SADDR:
+            setGCNBitField(sectionData, offset+4, 16, 7, rreg);
+            break;
+        case GCNFIELD_DPPSDWA_SSRC0:
+            setGCNBitField(sectionData, offset+4, 0, 8, rreg);
+            break;
+        case GCNFIELD_SDWAB_SDST:
+            setGCNBitField(sectionData, offset+4, 8, 7, rreg);
+            break;
+        case GCNFIELD_SMRD_SDSTH:
+        case GCNFIELD_M_VDATAH:
+        case GCNFIELD_M_VDATALAST:
+        case GCNFIELD_FLAT_VDSTLAST:
+            // these fields are not encoded (determined by first register)
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
+
+void GCNAssembler::encodeWaitInstr(const AsmWaitInstr& waitInstr,
+            std::vector<cxbyte>& output) const
+{
+    const bool isGCN14 = (curArchMask & ARCH_GCN_1_4)!=0;
+    const uint16_t vmCnt = std::min(waitInstr.waits[GCNWAIT_VMCNT],
+                uint16_t(isGCN14 ? 63 : 15));
+    const uint16_t lgkmCnt = std::min(waitInstr.waits[GCNWAIT_LGKMCNT], uint16_t(15));
+    const uint16_t expCnt = std::min(waitInstr.waits[GCNWAIT_EXPCNT], uint16_t(7));
+    uint32_t imm16 = (vmCnt&15) | (expCnt<<4) | (lgkmCnt<<8);
+    if (isGCN14)
+        imm16 |= (vmCnt&0x30)<<10;
+    uint32_t word;
+    SLEV(word, 0xbf8c0000U | imm16); // S_WAITCNT
+    output.insert(output.end(), reinterpret_cast<cxbyte*>(&word),
+            reinterpret_cast<cxbyte*>(&word)+4);
+}
+
+void GCNAssembler::encodeSpillInstrs(size_t instrsNum, const AsmSpillInstr* instrs,
+            std::vector<cxbyte>& output) const
+{
+    const bool isGCN12 = (curArchMask & ARCH_GCN_1_2_4)!=0;
+    auto putWord = [&output](uint32_t value)
+    {
+        uint32_t word;
+        SLEV(word, value);
+        output.insert(output.end(), reinterpret_cast<cxbyte*>(&word),
+                reinterpret_cast<cxbyte*>(&word)+4);
+    };
+    // wait instruction for counters (UINT16_MAX - no wait)
+    auto putWait = [this, &output](uint16_t vmCnt, uint16_t lgkmCnt)
+    {
+        AsmWaitInstr waitInstr{ 0, { } };
+        std::fill(waitInstr.waits, waitInstr.waits+ASM_WAIT_MAX_TYPES_NUM,
+                    uint16_t(UINT16_MAX));
+        waitInstr.waits[GCNWAIT_VMCNT] = vmCnt;
+        waitInstr.waits[GCNWAIT_LGKMCNT] = lgkmCnt;
+        encodeWaitInstr(waitInstr, output);
+    };
+    bool haveSGPRSaves = false, haveVGPRSaves = false;
+    bool haveSGPRRestores = false, haveVGPRRestores = false;
+    for (size_t i = 0; i < instrsNum; i++)
+    {
+        haveSGPRSaves |= instrs[i].type == AsmSpillType::SAVE_SGPR;
+        haveVGPRSaves |= instrs[i].type == AsmSpillType::SAVE_VGPR;
+        haveSGPRRestores |= instrs[i].type == AsmSpillType::RESTORE_SGPR;
+        haveVGPRRestores |= instrs[i].type == AsmSpillType::RESTORE_VGPR;
+    }
+    // saved register can be result of unfinished memory operation
+    if (haveVGPRSaves)
+        putWait(0, 0);
+    else if (haveSGPRSaves)
+        putWait(UINT16_MAX, 0);
+    
+    for (size_t i = 0; i < instrsNum; i++)
+    {
+        const AsmSpillInstr& instr = instrs[i];
+        // lane as inline constant
+        const uint32_t lane = 128 + instr.spillOffset;
+        switch(instr.type)
+        {
+            case AsmSpillType::SAVE_SGPR:
+                // V_WRITELANE_B32 spillReg, reg, lane
+                if (!isGCN12)
+                    putWord((2U<<25) | ((instr.spillReg&0xff)<<17) | (lane<<9) |
+                            instr.reg);
+                else
+                {
+                    putWord(0xd28a0000U | (instr.spillReg&0xff));
+                    putWord(instr.reg | (lane<<9));
+                }
+                break;
+            case AsmSpillType::RESTORE_SGPR:
+                // V_READLANE_B32 reg, spillReg, lane
+                if (!isGCN12)
+                    putWord((1U<<25) | (instr.reg<<17) | (lane<<9) | instr.spillReg);
+                else
+                {
+                    putWord(0xd2890000U | instr.reg);
+                    putWord(instr.spillReg | (lane<<9));
+                }
+                break;
+            case AsmSpillType::SAVE_VGPR:
+            case AsmSpillType::RESTORE_VGPR:
+            {
+                // BUFFER_STORE_DWORD/BUFFER_LOAD_DWORD reg, off, spillReg,
+                //      scratchOffsetReg offset:spillOffset
+                const uint32_t opcode = (instr.type == AsmSpillType::SAVE_VGPR) ? 28 :
+                        (isGCN12 ? 20 : 12);
+                putWord(0xe0000000U | (opcode<<18) | (instr.spillOffset&0xfff));
+                putWord(((instr.reg&0xff)<<8) | ((instr.spillReg>>2)<<16) |
+                        (instr.scratchOffsetReg<<24));
+                break;
+            }
+        }
+    }
+    
+    // restored VGPRs must be loaded before use
+    if (haveVGPRRestores)
+        putWait(0, UINT16_MAX);
+    // VALU writes SGPR: VMEM and lane selects require 5 wait states
+    if (haveSGPRRestores)
+        putWord(0xbf800004U); // S_NOP 4
+}
+
+bool GCNAssembler::isCopyInstr(size_t codeSize, const cxbyte* code) const
+{
+    if (codeSize < 4)
+        return false;
+    const bool isGCN12 = (curArchMask & ARCH_GCN_1_2_4)!=0;
+    const uint32_t insnCode = ULEV(*reinterpret_cast<const uint32_t*>(code));
+    if ((insnCode & 0xff800000U) == 0xbe800000U)
+        // SOP1: S_MOV_B32 (without literal)
+        return ((insnCode>>8)&0xff) == (isGCN12 ? 0U : 3U) && (insnCode&0xff) != 0xff;
+    if ((insnCode & 0xfe000000U) == 0x7e000000U)
+    {
+        // VOP1: V_MOV_B32 (without literal, SDWA and DPP)
+        const uint32_t src0 = insnCode&0x1ff;
+        return ((insnCode>>9)&0xff) == 1 && src0 != 0xff && src0 != 0xf9 && src0 != 0xfa;
+    }
+    return false;
+}
+
+/* VALU instructions that need wait states after previous VALU instructions
+ * (lane selects, implicit VCC and M0 reads, DPP-like moves of lanes) */
+static const char* gcnHazardVALUPrefixes[] =
+{
+    "v_div_fmas", "v_interp", "v_movrel", "v_readfirstlane", "v_readlane", "v_writelane"
+};
+
+cxuint GCNAssembler::getInstrSchedInfo(size_t codeSize, const cxbyte* code,
+            cxbyte& reorderClass) const
+{
+    reorderClass = ASMREORDER_NONE;
+    if (codeSize < 4)
+        return 4;
+    const GPUDeviceType deviceType = assembler.getDeviceType();
+    const GPUArchitecture arch = getGPUArchitectureFromDeviceType(deviceType);
+    const uint32_t* codeWords = reinterpret_cast<const uint32_t*>(code);
+    size_t pos = 0;
+    cxbyte gcnEncoding;
+    uint32_t insnCode, insnCode2;
+    const GCNInstruction* gcnInsn = decodeGCNInstruction(arch, codeWords, codeSize>>2,
+                pos, gcnEncoding, insnCode, insnCode2);
+    if (gcnInsn == nullptr)
+        return 4;
+    const cxuint cycles = getGCNInstrCycles(*gcnInsn, gcnEncoding, insnCode,
+                1U<<int(arch), getGCNDPFactor(deviceType));
+    const char* mnemonic = gcnInsn->mnemonic;
+    switch (gcnEncoding)
+    {
+        case GCNENC_VOP1:
+        case GCNENC_VOP2:
+        case GCNENC_VOPC:
+        case GCNENC_VOP3A:
+        case GCNENC_VOP3B:
+        {
+            // DPP reads lanes of VGPRs written by previous VALU instructions
+            bool hazard = arch >= GPUArchitecture::GCN1_2 &&
+                (gcnEncoding == GCNENC_VOP1 || gcnEncoding == GCNENC_VOP2 ||
+                gcnEncoding == GCNENC_VOPC) && (insnCode&0x1ff) == 0xfa;
+            for (const char* prefix: gcnHazardVALUPrefixes)
+                if (::strncmp(mnemonic, prefix, ::strlen(prefix)) == 0)
+                {
+                    hazard = true;
+                    break;
+                }
+            if (hazard)
+            {
+                reorderClass = ASMREORDER_HAZARD;
+                break;
+            }
+            /* comparisons and instructions with carry write VCC or SGPRs
+             * (VMEM and lane selects need wait states after them), V_CMPX writes EXEC */
+            if (::strncmp(mnemonic, "v_cmp", 5) == 0 || gcnEncoding == GCNENC_VOPC ||
+                gcnEncoding == GCNENC_VOP3B || (gcnEncoding == GCNENC_VOP2 &&
+                ((gcnInsn->mode & GCN_MASK1) == GCN_DS2_VCC ||
+                 (gcnInsn->mode & GCN_MASK1) == GCN_DST_VCC ||
+                 (gcnInsn->mode & GCN_MASK1) == GCN_DST_VCC_VSRC2)) ||
+                ::strcmp(mnemonic, "v_clrexcp") == 0 || ::strcmp(mnemonic, "v_nop") == 0)
+                break;
+            reorderClass = ASMREORDER_MOVE;
+            break;
+        }
+        case GCNENC_VINTRP:
+            // implicit read of M0
+            reorderClass = ASMREORDER_HAZARD;
+            break;
+        case GCNENC_SMRD:
+        case GCNENC_DS:
+        case GCNENC_MUBUF:
+        case GCNENC_MTBUF:
+        case GCNENC_MIMG:
+        case GCNENC_EXP:
+        case GCNENC_FLAT:
+            // registers of memory instructions are in register usages
+            reorderClass = ASMREORDER_CROSS;
+            break;
+        case GCNENC_SOPP:
+            if (::strcmp(mnemonic, "s_waitcnt") == 0)
+                reorderClass = ASMREORDER_CROSS;
+            break;
+        default:
+            // scalar ALU instructions can change EXEC, M0 and SCC
+            break;
+    }
+    return cycles;
+}
@@ -23,12 +23,14 @@
 #include <cstring>
 #include <mutex>
 #include <memory>
+#include <unordered_map>
 #include <CLRX/utils/Utilities.h>
 #include <CLRX/utils/GPUId.h>
 #include <CLRX/amdasm/Disassembler.h>
 #include <CLRX/utils/MemAccess.h>
 #include "GCNInternals.h"
 #include "GCNDisasmInternals.h"
+#include "DisasmInternals.h"
 
 using namespace CLRX;
 
@@ -182,7 +184,7 @@ static void initializeGCNDisassembler()
 }
 
 GCNDisassembler::GCNDisassembler(Disassembler& disassembler)
-        : ISADisassembler(disassembler), instrOutOfCode(false)
+        : ISADisassembler(disassembler), statsBlockOpen(false)
 {
     callOnce(clrxGCNDisasmOnceFlag, initializeGCNDisassembler);
 }
@@ -278,7 +280,7 @@ void GCNDisassembler::analyzeBeforeDisassemble()
                             // GCN1.1 and GCN1.2 opcodes
                             ((isGCN11 || isGCN12) &&
                                     (opcode >= 23 && opcode <= 26))) // if jump
-                            labels.push_back(startOffset +
+                            addLabel(startOffset +
                                     ((pos+int16_t(insnCode&0xffff)+1)<<2));
                     }
                     else
@@ -288,7 +290,7 @@ void GCNDisassembler::analyzeBeforeDisassemble()
                         if ((!isGCN12 && opcode == 17) ||
                             (isGCN12 && opcode == 16) || // if branch fork
                             (isGCN14 && opcode == 21)) // if s_call_b64
-                            labels.push_back(startOffset +
+                            addLabel(startOffset +
                                     ((pos+int16_t(insnCode&0xffff)+1)<<2));
                         else if ((!isGCN12 && opcode == 21) ||
                             (isGCN12 && opcode == 20))
@@ -445,6 +447,215 @@ static const GCNEncodingOpcodeBits gcnEncodingOpcode12Table[GCNENC_MAXVAL+1] =
 };
 
 
+/* determine GCN encoding of instruction and read second word of instruction
+ * (if instruction have it). pos - position after first word, will be moved
+ * after whole instruction */
+static cxbyte getGCNEncoding(const uint32_t* codeWords, size_t codeWordsNum, size_t& pos,
+            uint32_t insnCode, uint32_t& insnCode2, bool isGCN11, bool isGCN124)
+{
+    cxbyte gcnEncoding = GCNENC_NONE;
+    if ((insnCode & 0x80000000U) != 0)
+    {
+        if ((insnCode & 0x40000000U) == 0)
+        {
+            // SOP???
+            if  ((insnCode & 0x30000000U) == 0x30000000U)
+            {
+                // SOP1/SOPK/SOPC/SOPP
+                const uint32_t encPart = (insnCode & 0x0f800000U);
+                if (encPart == 0x0e800000U)
+                {
+                    // SOP1
+                    if ((insnCode&0xff) == 0xff) // literal
+                    {
+                        if (pos < codeWordsNum)
+                            insnCode2 = ULEV(codeWords[pos++]);
+                    }
+                    gcnEncoding = GCNENC_SOP1;
+                }
+                else if (encPart == 0x0f000000U)
+                {
+                    // SOPC
+                    if ((insnCode&0xff) == 0xff ||
+                        (insnCode&0xff00) == 0xff00) // literal
+                    {
+                        if (pos < codeWordsNum)
+                            insnCode2 = ULEV(codeWords[pos++]);
+                    }
+                    gcnEncoding = GCNENC_SOPC;
+                }
+                else if (encPart == 0x0f800000U) // SOPP
+                    gcnEncoding = GCNENC_SOPP;
+                else // SOPK
+                {
+                    gcnEncoding = GCNENC_SOPK;
+                    const uint32_t opcode = ((insnCode>>23)&0x1f);
+                    if ((!isGCN124 && opcode == 21) ||
+                        (isGCN124 && opcode == 20))
+                    {
+                        if (pos < codeWordsNum)
+                            insnCode2 = ULEV(codeWords[pos++]);
+                    }
+                }
+            }
+            else
+            {
+                // SOP2
+                if ((insnCode&0xff) == 0xff || (insnCode&0xff00) == 0xff00)
+                {
+                    // literal
+                    if (pos < codeWordsNum)
+                        insnCode2 = ULEV(codeWords[pos++]);
+                }
+                gcnEncoding = GCNENC_SOP2;
+            }
+        }
+        else
+        {
+            // SMRD and others
+            const uint32_t encPart = (insnCode&0x3c000000U)>>26;
+            if ((!isGCN124 && gcnSize11Table[encPart] && (encPart != 7 || isGCN11)) ||
+                (isGCN124 && gcnSize12Table[encPart]))
+            {
+                if (pos < codeWordsNum)
+                    insnCode2 = ULEV(codeWords[pos++]);
+            }
+            if (isGCN124)
+                gcnEncoding = gcnEncoding12Table[encPart];
+            else
+                gcnEncoding = gcnEncoding11Table[encPart];
+            if (gcnEncoding == GCNENC_FLAT && !isGCN11 && !isGCN124)
+                gcnEncoding = GCNENC_NONE; // illegal if not GCN1.1
+        }
+    }
+    else
+    {
+        // some vector instructions
+        if ((insnCode & 0x7e000000U) == 0x7c000000U)
+        {
+            // VOPC
+            if ((insnCode&0x1ff) == 0xff || // literal
+                // SDWA, DDP
+                (isGCN124 && ((insnCode&0x1ff) == 0xf9 || (insnCode&0x1ff) == 0xfa)))
+            {
+                if (pos < codeWordsNum)
+                    insnCode2 = ULEV(codeWords[pos++]);
+            }
+            gcnEncoding = GCNENC_VOPC;
+        }
+        else if ((insnCode & 0x7e000000U) == 0x7e000000U)
+        {
+            // VOP1
+            if ((insnCode&0x1ff) == 0xff || // literal
+                // SDWA, DDP
+                (isGCN124 && ((insnCode&0x1ff) == 0xf9 || (insnCode&0x1ff) == 0xfa)))
+            {
+                if (pos < codeWordsNum)
+                    insnCode2 = ULEV(codeWords[pos++]);
+            }
+            gcnEncoding = GCNENC_VOP1;
+        }
+        else
+        {
+            // VOP2
+            const cxuint opcode = (insnCode >> 25)&0x3f;
+            if ((!isGCN124 && (opcode == 32 || opcode == 33)) ||
+                (isGCN124 && (opcode == 23 || opcode == 24 ||
+                opcode == 36 || opcode == 37))) // V_MADMK and V_MADAK
+            {
+                if (pos < codeWordsNum)
+                    insnCode2 = ULEV(codeWords[pos++]);
+            }
+            else if ((insnCode&0x1ff) == 0xff || // literal
+                // SDWA, DDP
+                (isGCN124 && ((insnCode&0x1ff) == 0xf9 || (insnCode&0x1ff) == 0xfa)))
+            {
+                if (pos < codeWordsNum)
+                    insnCode2 = ULEV(codeWords[pos++]);
+            }
+            gcnEncoding = GCNENC_VOP2;
+        }
+    }
+    return gcnEncoding;
+}
+
+// get opcode of instruction in specified encoding
+static inline cxuint getGCNOpcode(cxbyte gcnEncoding, uint32_t insnCode, bool isGCN124)
+{
+    const GCNEncodingOpcodeBits* encodingOpcodeTable = 
+            (isGCN124) ? gcnEncodingOpcode12Table : gcnEncodingOpcodeTable;
+    return (insnCode>>encodingOpcodeTable[gcnEncoding].bitPos) & 
+            ((1U<<encodingOpcodeTable[gcnEncoding].bits)-1U);
+}
+
+/* find instruction in main instruction table.
+ * isIllegal - set true if instruction is illegal for current architecture */
+static const GCNInstruction* findGCNInstruction(cxbyte gcnEncoding, cxuint opcode,
+            uint32_t insnCode, GPUArchMask curArchMask, bool isGCN124, bool isGCN14,
+            bool& isIllegal)
+{
+    const GCNEncodingSpace& encSpace = 
+        (isGCN124) ? gcnInstrTableByCodeSpaces[GCNENC_MAXVAL+3 + gcnEncoding] :
+          gcnInstrTableByCodeSpaces[gcnEncoding];
+    const GCNInstruction* gcnInsn = gcnInstrTableByCode.get() +
+            encSpace.offset + opcode;
+    
+    // try to replace by FMA_MIX for VEGA20
+    if ((curArchMask&ARCH_VEGA20) != 0 && gcnInsn->code>=928 && gcnInsn->code<=930)
+    {
+        const GCNEncodingSpace& encSpace4 =
+            gcnInstrTableByCodeSpaces[2*GCNENC_MAXVAL+4 + 1];
+        const GCNInstruction* thisGCNInstr =
+                gcnInstrTableByCode.get() + encSpace4.offset + opcode;
+        if (thisGCNInstr->mnemonic != nullptr)
+            // replace
+            gcnInsn = thisGCNInstr;
+    }
+    
+    isIllegal = false;
+    if (!isGCN124 && gcnInsn->mnemonic != nullptr &&
+        (curArchMask & gcnInsn->archMask) == 0 &&
+        gcnEncoding == GCNENC_VOP3A)
+    {    /* new overrides (VOP3A) */
+        const GCNEncodingSpace& encSpace2 =
+                gcnInstrTableByCodeSpaces[GCNENC_MAXVAL+1];
+        gcnInsn = gcnInstrTableByCode.get() + encSpace2.offset + opcode;
+        if (gcnInsn->mnemonic == nullptr ||
+                (curArchMask & gcnInsn->archMask) == 0)
+            isIllegal = true; // illegal
+    }
+    else if (isGCN14 && gcnInsn->mnemonic != nullptr &&
+        (curArchMask & gcnInsn->archMask) == 0 &&
+        (gcnEncoding == GCNENC_VOP3A || gcnEncoding == GCNENC_VOP2 ||
+            gcnEncoding == GCNENC_VOP1))
+    {
+        /* new overrides (VOP1/VOP3A/VOP2 for GCN 1.4) */
+        const GCNEncodingSpace& encSpace4 =
+                gcnInstrTableByCodeSpaces[2*GCNENC_MAXVAL+4 +
+                        (gcnEncoding != GCNENC_VOP2) +
+                        (gcnEncoding == GCNENC_VOP1)];
+        gcnInsn = gcnInstrTableByCode.get() + encSpace4.offset + opcode;
+        if (gcnInsn->mnemonic == nullptr ||
+                (curArchMask & gcnInsn->archMask) == 0)
+            isIllegal = true; // illegal
+    }
+    else if (isGCN14 && gcnEncoding == GCNENC_FLAT && ((insnCode>>14)&3)!=0)
+    {
+        // GLOBAL_/SCRATCH_* instructions
+        const GCNEncodingSpace& encSpace4 =
+            gcnInstrTableByCodeSpaces[2*(GCNENC_MAXVAL+1)+2+3 +
+                ((insnCode>>14)&3)-1];
+        gcnInsn = gcnInstrTableByCode.get() + encSpace4.offset + opcode;
+        if (gcnInsn->mnemonic == nullptr ||
+                (curArchMask & gcnInsn->archMask) == 0)
+            isIllegal = true; // illegal
+    }
+    else if (gcnInsn->mnemonic == nullptr ||
+        (curArchMask & gcnInsn->archMask) == 0)
+        isIllegal = true;
+    return gcnInsn;
+}
+
 /* main routine */
 
 void GCNDisassembler::disassemble()
@@ -488,7 +699,6 @@ void GCNDisassembler::disassemble()
             break;
         
         const size_t oldPos = pos;
-        cxbyte gcnEncoding = GCNENC_NONE;
         const uint32_t insnCode = ULEV(codeWords[pos++]);
         if (insnCode == 0)
         {
@@ -511,128 +721,8 @@ void GCNDisassembler::disassemble()
         
         
         /* determine GCN encoding */
-        if ((insnCode & 0x80000000U) != 0)
-        {
-            if ((insnCode & 0x40000000U) == 0)
-            {
-                // SOP???
-                if  ((insnCode & 0x30000000U) == 0x30000000U)
-                {
-                    // SOP1/SOPK/SOPC/SOPP
-                    const uint32_t encPart = (insnCode & 0x0f800000U);
-                    if (encPart == 0x0e800000U)
-                    {
-                        // SOP1
-                        if ((insnCode&0xff) == 0xff) // literal
-                        {
-                            if (pos < codeWordsNum)
-                                insnCode2 = ULEV(codeWords[pos++]);
-                        }
-                        gcnEncoding = GCNENC_SOP1;
-                    }
-                    else if (encPart == 0x0f000000U)
-                    {
-                        // SOPC
-                        if ((insnCode&0xff) == 0xff ||
-                            (insnCode&0xff00) == 0xff00) // literal
-                        {
-                            if (pos < codeWordsNum)
-                                insnCode2 = ULEV(codeWords[pos++]);
-                        }
-                        gcnEncoding = GCNENC_SOPC;
-                    }
-                    else if (encPart == 0x0f800000U) // SOPP
-                        gcnEncoding = GCNENC_SOPP;
-                    else // SOPK
-                    {
-                        gcnEncoding = GCNENC_SOPK;
-                        const uint32_t opcode = ((insnCode>>23)&0x1f);
-                        if ((!isGCN124 && opcode == 21) ||
-                            (isGCN124 && opcode == 20))
-                        {
-                            if (pos < codeWordsNum)
-                                insnCode2 = ULEV(codeWords[pos++]);
-                        }
-                    }
-                }
-                else
-                {
-                    // SOP2
-                    if ((insnCode&0xff) == 0xff || (insnCode&0xff00) == 0xff00)
-                    {
-                        // literal
-                        if (pos < codeWordsNum)
-                            insnCode2 = ULEV(codeWords[pos++]);
-                    }
-                    gcnEncoding = GCNENC_SOP2;
-                }
-            }
-            else
-            {
-                // SMRD and others
-                const uint32_t encPart = (insnCode&0x3c000000U)>>26;
-                if ((!isGCN124 && gcnSize11Table[encPart] && (encPart != 7 || isGCN11)) ||
-                    (isGCN124 && gcnSize12Table[encPart]))
-                {
-                    if (pos < codeWordsNum)
-                        insnCode2 = ULEV(codeWords[pos++]);
-                }
-                if (isGCN124)
-                    gcnEncoding = gcnEncoding12Table[encPart];
-                else
-                    gcnEncoding = gcnEncoding11Table[encPart];
-                if (gcnEncoding == GCNENC_FLAT && !isGCN11 && !isGCN124)
-                    gcnEncoding = GCNENC_NONE; // illegal if not GCN1.1
-            }
-        }
-        else
-        {
-            // some vector instructions
-            if ((insnCode & 0x7e000000U) == 0x7c000000U)
-            {
-                // VOPC
-                if ((insnCode&0x1ff) == 0xff || // literal
-                    // SDWA, DDP
-                    (isGCN124 && ((insnCode&0x1ff) == 0xf9 || (insnCode&0x1ff) == 0xfa)))
-                {
-                    if (pos < codeWordsNum)
-                        insnCode2 = ULEV(codeWords[pos++]);
-                }
-                gcnEncoding = GCNENC_VOPC;
-            }
-            else if ((insnCode & 0x7e000000U) == 0x7e000000U)
-            {
-                // VOP1
-                if ((insnCode&0x1ff) == 0xff || // literal
-                    // SDWA, DDP
-                    (isGCN124 && ((insnCode&0x1ff) == 0xf9 || (insnCode&0x1ff) == 0xfa)))
-                {
-                    if (pos < codeWordsNum)
-                        insnCode2 = ULEV(codeWords[pos++]);
-                }
-                gcnEncoding = GCNENC_VOP1;
-            }
-            else
-            {
-                // VOP2
-                const cxuint opcode = (insnCode >> 25)&0x3f;
-                if ((!isGCN124 && (opcode == 32 || opcode == 33)) ||
-                    (isGCN124 && (opcode == 23 || opcode == 24 ||
-                    opcode == 36 || opcode == 37))) // V_MADMK and V_MADAK
-                {
-                    if (pos < codeWordsNum)
-                        insnCode2 = ULEV(codeWords[pos++]);
-                }
-                else if ((insnCode&0x1ff) == 0xff || // literal
-                    // SDWA, DDP
-                    (isGCN124 && ((insnCode&0x1ff) == 0xf9 || (insnCode&0x1ff) == 0xfa)))
-                {
-                    if (pos < codeWordsNum)
-                        insnCode2 = ULEV(codeWords[pos++]);
-                }
-                gcnEncoding = GCNENC_VOP2;
-            }
-        }
+        const cxbyte gcnEncoding = getGCNEncoding(codeWords, codeWordsNum, pos,
+                    insnCode, insnCode2, isGCN11, isGCN124);
         
         prevIsTwoWord = (oldPos+2 == pos);
         
@@ -650,11 +740,15 @@ void GCNDisassembler::disassemble()
                 buf[bufPos++] = ':';
                 buf[bufPos++] = ' ';
             }
-            bufPos += itocstrCStyle(insnCode, buf+bufPos, 12, 16, 8, false);
+            putHexU32ToBuf(insnCode, buf+bufPos);
+            bufPos += 8;
             buf[bufPos++] = ' ';
             // if instruction is two word long
             if (prevIsTwoWord)
-                bufPos += itocstrCStyle(insnCode2, buf+bufPos, 12, 16, 8, false);
+            {
+                putHexU32ToBuf(insnCode2, buf+bufPos);
+                bufPos += 8;
+            }
             else
                 bufPos += addSpacesOld(buf+bufPos, 8);
             buf[bufPos++] = '*';
@@ -701,76 +795,15 @@ void GCNDisassembler::disassemble()
         }
         else
         {
-            const GCNEncodingOpcodeBits* encodingOpcodeTable = 
-                    (isGCN124) ? gcnEncodingOpcode12Table : gcnEncodingOpcodeTable;
-            const cxuint opcode =
-                    (insnCode>>encodingOpcodeTable[gcnEncoding].bitPos) & 
-                    ((1U<<encodingOpcodeTable[gcnEncoding].bits)-1U);
+            const cxuint opcode = getGCNOpcode(gcnEncoding, insnCode, isGCN124);
             
             /* decode instruction and put to output */
-            const GCNEncodingSpace& encSpace = 
-                (isGCN124) ? gcnInstrTableByCodeSpaces[GCNENC_MAXVAL+3 + gcnEncoding] :
-                  gcnInstrTableByCodeSpaces[gcnEncoding];
-            const GCNInstruction* gcnInsn = gcnInstrTableByCode.get() +
-                    encSpace.offset + opcode;
-            
-            const GCNInstruction defaultInsn = { nullptr, gcnInsn->encoding, GCN_STDMODE,
-                        0, 0 };
-            
-            // try to replace by FMA_MIX for VEGA20
-            if ((curArchMask&ARCH_VEGA20) != 0 && gcnInsn->code>=928 && gcnInsn->code<=930)
-            {
-                const GCNEncodingSpace& encSpace4 =
-                    gcnInstrTableByCodeSpaces[2*GCNENC_MAXVAL+4 + 1];
-                const GCNInstruction* thisGCNInstr =
-                        gcnInstrTableByCode.get() + encSpace4.offset + opcode;
-                if (thisGCNInstr->mnemonic != nullptr)
-                    // replace
-                    gcnInsn = thisGCNInstr;
-            }
-            
             cxuint spacesToAdd = 16;
             bool isIllegal = false;
-            if (!isGCN124 && gcnInsn->mnemonic != nullptr &&
-                (curArchMask & gcnInsn->archMask) == 0 &&
-                gcnEncoding == GCNENC_VOP3A)
-            {    /* new overrides (VOP3A) */
-                const GCNEncodingSpace& encSpace2 =
-                        gcnInstrTableByCodeSpaces[GCNENC_MAXVAL+1];
-                gcnInsn = gcnInstrTableByCode.get() + encSpace2.offset + opcode;
-                if (gcnInsn->mnemonic == nullptr ||
-                        (curArchMask & gcnInsn->archMask) == 0)
-                    isIllegal = true; // illegal
-            }
-            else if (isGCN14 && gcnInsn->mnemonic != nullptr &&
-                (curArchMask & gcnInsn->archMask) == 0 &&
-                (gcnEncoding == GCNENC_VOP3A || gcnEncoding == GCNENC_VOP2 ||
-                    gcnEncoding == GCNENC_VOP1))
-            {
-                /* new overrides (VOP1/VOP3A/VOP2 for GCN 1.4) */
-                const GCNEncodingSpace& encSpace4 =
-                        gcnInstrTableByCodeSpaces[2*GCNENC_MAXVAL+4 +
-                                (gcnEncoding != GCNENC_VOP2) +
-                                (gcnEncoding == GCNENC_VOP1)];
-                gcnInsn = gcnInstrTableByCode.get() + encSpace4.offset + opcode;
-                if (gcnInsn->mnemonic == nullptr ||
-                        (curArchMask & gcnInsn->archMask) == 0)
-                    isIllegal = true; // illegal
-            }
-            else if (isGCN14 && gcnEncoding == GCNENC_FLAT && ((insnCode>>14)&3)!=0)
-            {
-                // GLOBAL_/SCRATCH_* instructions
-                const GCNEncodingSpace& encSpace4 =
-                    gcnInstrTableByCodeSpaces[2*(GCNENC_MAXVAL+1)+2+3 +
-                        ((insnCode>>14)&3)-1];
-                gcnInsn = gcnInstrTableByCode.get() + encSpace4.offset + opcode;
-                if (gcnInsn->mnemonic == nullptr ||
-                        (curArchMask & gcnInsn->archMask) == 0)
-                    isIllegal = true; // illegal
-            }
-            else if (gcnInsn->mnemonic == nullptr ||
-                (curArchMask & gcnInsn->archMask) == 0)
-                isIllegal = true;
+            const GCNInstruction* gcnInsn = findGCNInstruction(gcnEncoding, opcode,
+                        insnCode, curArchMask, isGCN124, isGCN14, isIllegal);
+            const GCNInstruction defaultInsn = { nullptr, gcnInsn->encoding, GCN_STDMODE,
+                        0, 0 };
             
             if (!isIllegal)
             {
@@ -891,3 +924,429 @@ void GCNDisassembler::disassemble()
     output.flush();
     disassembler.getOutput().flush();
 }
+
+/* code statistics */
+
+// update number of used registers by scalar (8-bit) or source (9-bit) operand
+static inline void useGCNOperandRegs(GCNCodeStats& stats, cxuint op, cxuint regsNum,
+                cxuint maxSgprsNum)
+{
+    if (op < maxSgprsNum)
+        stats.sgprsNum = std::max(stats.sgprsNum, std::min(op+regsNum, maxSgprsNum));
+    else if (op >= 256)
+        stats.vgprsNum = std::max(stats.vgprsNum, std::min(op-256+regsNum, 256U));
+}
+
+// update number of used registers by vector register operand
+static inline void useGCNVRegs(GCNCodeStats& stats, cxuint vreg, cxuint regsNum)
+{
+    stats.vgprsNum = std::max(stats.vgprsNum, std::min(vreg+regsNum, 256U));
+}
+
+// update number of used registers by operands of instruction
+static void useGCNInstrRegs(GCNCodeStats& stats, cxbyte gcnEncoding,
+            const GCNInstruction& gcnInsn, uint32_t insnCode, uint32_t insnCode2,
+            bool isGCN124, bool isGCN14)
+{
+    const cxuint maxSgprs = isGCN124 ? 102 : 104;
+    const GCNInsnMode mode = gcnInsn.mode;
+    const cxuint dstRegs = (mode & GCN_REG_DST_64) ? 2 : 1;
+    const cxuint src0Regs = (mode & GCN_REG_SRC0_64) ? 2 : 1;
+    const cxuint src1Regs = (mode & GCN_REG_SRC1_64) ? 2 : 1;
+    const cxuint src2Regs = (mode & GCN_REG_SRC2_64) ? 2 : 1;
+    switch(gcnEncoding)
+    {
+        case GCNENC_SOPC:
+            useGCNOperandRegs(stats, insnCode&0xff, src0Regs, maxSgprs);
+            if ((mode & GCN_MASK1) != GCN_SRC1_IMM)
+                useGCNOperandRegs(stats, (insnCode>>8)&0xff, src1Regs, maxSgprs);
+            break;
+        case GCNENC_SOP1:
+            if ((mode & GCN_MASK1) != GCN_DST_NONE)
+                useGCNOperandRegs(stats, (insnCode>>16)&0x7f, dstRegs, maxSgprs);
+            if ((mode & GCN_MASK1) != GCN_SRC_NONE)
+                useGCNOperandRegs(stats, insnCode&0xff, src0Regs, maxSgprs);
+            break;
+        case GCNENC_SOP2:
+            useGCNOperandRegs(stats, (insnCode>>16)&0x7f, dstRegs, maxSgprs);
+            useGCNOperandRegs(stats, insnCode&0xff, src0Regs, maxSgprs);
+            useGCNOperandRegs(stats, (insnCode>>8)&0xff, src1Regs, maxSgprs);
+            break;
+        case GCNENC_SOPK:
+            if ((mode & GCN_SOPK_CONST) == 0)
+                useGCNOperandRegs(stats, (insnCode>>16)&0x7f, dstRegs, maxSgprs);
+            break;
+        case GCNENC_SMRD:
+        {
+            const cxuint mask1 = mode & GCN_MASK1;
+            if (mask1 == GCN_ARG_NONE || (isGCN124 && mask1 == GCN_SMEM_NOSDATA))
+                break;
+            const cxuint dataRegs = 1U<<((mode & GCN_MASK2)>>GCN_SHIFT2);
+            if (isGCN124)
+            {
+                if (mask1 != GCN_SMEM_SDATA_IMM)
+                    useGCNOperandRegs(stats, (insnCode>>6)&0x7f, dataRegs, maxSgprs);
+                if (mask1 != GCN_SMRD_ONLYDST)
+                {
+                    useGCNOperandRegs(stats, (insnCode&0x3f)<<1,
+                                (mode & GCN_SBASE4) ? 4 : 2, maxSgprs);
+                    if ((insnCode & 0x20000U) == 0)
+                        useGCNOperandRegs(stats, insnCode2&0xff, 1, maxSgprs);
+                }
+            }
+            else
+            {
+                useGCNOperandRegs(stats, (insnCode>>15)&0x7f, dataRegs, maxSgprs);
+                if (mask1 != GCN_SMRD_ONLYDST)
+                {
+                    useGCNOperandRegs(stats, (insnCode>>8)&0x7e,
+                                (mode & GCN_SBASE4) ? 4 : 2, maxSgprs);
+                    if ((insnCode & 0x100U) == 0)
+                        useGCNOperandRegs(stats, insnCode&0xff, 1, maxSgprs);
+                }
+            }
+            break;
+        }
+        case GCNENC_VOPC:
+        case GCNENC_VOP1:
+        case GCNENC_VOP2:
+        {
+            const cxuint mask1 = mode & GCN_MASK1;
+            if (mask1 == GCN_VOP_ARG_NONE)
+                break;
+            if (gcnEncoding != GCNENC_VOPC)
+            {
+                if (mask1 == GCN_DST_SGPR || mask1 == GCN_DS1_SGPR)
+                    useGCNOperandRegs(stats, (insnCode>>17)&0xff, dstRegs, maxSgprs);
+                else
+                    useGCNVRegs(stats, (insnCode>>17)&0xff, dstRegs);
+            }
+            const cxuint src0 = insnCode&0x1ff;
+            if (isGCN124 && (src0 == 0xf9 || src0 == 0xfa))
+                // SDWA or DPP: source0 is vector register in second word
+                useGCNVRegs(stats, insnCode2&0xff, src0Regs);
+            else if (gcnEncoding != GCNENC_VOP1 || mask1 != GCN_SRC12_NONE)
+                useGCNOperandRegs(stats, src0, src0Regs, maxSgprs);
+            if (gcnEncoding != GCNENC_VOP1)
+            {
+                if (mask1 == GCN_SRC1_SGPR || mask1 == GCN_DS1_SGPR)
+                    useGCNOperandRegs(stats, (insnCode>>9)&0xff, src1Regs, maxSgprs);
+                else
+                    useGCNVRegs(stats, (insnCode>>9)&0xff, src1Regs);
+            }
+            break;
+        }
+        case GCNENC_VOP3A:
+        case GCNENC_VOP3B:
+        {
+            const cxuint mask1 = mode & GCN_MASK1;
+            const bool dstSGPR = gcnInsn.encoding == GCNENC_VOPC ||
+                    mask1 == GCN_DST_SGPR || mask1 == GCN_DS1_SGPR ||
+                    (mode & GCN_VOP3_DST_SGPR) != 0;
+            const cxuint vdst = insnCode&0xff;
+            if (dstSGPR)
+                useGCNOperandRegs(stats, vdst, gcnInsn.encoding == GCNENC_VOPC ? 2 :
+                            dstRegs, maxSgprs);
+            else
+                useGCNVRegs(stats, vdst, dstRegs);
+            if (gcnInsn.encoding == GCNENC_VOP3B ||
+                (gcnInsn.encoding == GCNENC_VOP2 && mask1 == GCN_DS2_VCC))
+                // VOP3B extra scalar destination
+                useGCNOperandRegs(stats, (insnCode>>8)&0x7f, 2, maxSgprs);
+            if (mask1 == GCN_VOP_ARG_NONE)
+                break;
+            useGCNOperandRegs(stats, insnCode2&0x1ff, src0Regs, maxSgprs);
+            if (gcnInsn.encoding == GCNENC_VOP1 || mask1 == GCN_SRC12_NONE)
+                break;
+            useGCNOperandRegs(stats, (insnCode2>>9)&0x1ff, src1Regs, maxSgprs);
+            if ((gcnInsn.encoding == GCNENC_VOP3A || gcnInsn.encoding == GCNENC_VOP3B) &&
+                mask1 != GCN_SRC2_NONE)
+                useGCNOperandRegs(stats, (insnCode2>>18)&0x1ff, src2Regs, maxSgprs);
+            break;
+        }
+        case GCNENC_VINTRP:
+            useGCNVRegs(stats, (insnCode>>18)&0xff, 1);
+            if ((mode & GCN_MASK1) != GCN_P0_P10_P20)
+                useGCNVRegs(stats, insnCode&0xff, 1);
+            break;
+        case GCNENC_DS:
+        {
+            const cxuint dataRegs = (mode & GCN_DS_128) ? 4 : (mode & GCN_DS_96) ? 3 :
+                        (mode & GCN_REG_DST_64) ? 2 : 1;
+            const cxuint addrMode = mode & (GCN_ADDR_DST|GCN_ADDR_SRC);
+            if ((mode & GCN_ONLYDST) == 0)
+                useGCNVRegs(stats, insnCode2&0xff, 1);
+            if ((mode & GCN_ONLYDST) == 0 && (mode & GCN_NOSRC) == 0 &&
+                addrMode != GCN_ADDR_SRC)
+            {
+                useGCNVRegs(stats, (insnCode2>>8)&0xff, dataRegs);
+                if ((mode & GCN_2SRCS) != 0)
+                    useGCNVRegs(stats, (insnCode2>>16)&0xff, dataRegs);
+            }
+            if (addrMode != GCN_ADDR_DST)
+                useGCNVRegs(stats, insnCode2>>24, (mode & GCN_DST128) ? 4 : dataRegs);
+            break;
+        }
+        case GCNENC_MUBUF:
+        case GCNENC_MTBUF:
+        {
+            const bool offen = (insnCode & 0x1000U) != 0;
+            const bool idxen = (insnCode & 0x2000U) != 0;
+            const bool addr64 = !isGCN124 && (insnCode & 0x8000U) != 0;
+            if (offen || idxen || addr64)
+                useGCNVRegs(stats, insnCode2&0xff, ((offen && idxen) || addr64) ? 2 : 1);
+            if ((mode & GCN_MASK1) != GCN_MUBUF_NOVAD)
+            {
+                cxuint dataRegs = ((mode & GCN_MUBUF_XYZW)>>GCN_SHIFT2) + 1;
+                if ((mode & GCN_CMPSWAP) != 0)
+                    dataRegs <<= 1;
+                if ((insnCode2 & 0x800000U) != 0) // tfe
+                    dataRegs++;
+                useGCNVRegs(stats, (insnCode2>>8)&0xff, dataRegs);
+            }
+            useGCNOperandRegs(stats, (insnCode2>>14)&0x7c, 4, maxSgprs);
+            useGCNOperandRegs(stats, insnCode2>>24, 1, maxSgprs);
+            break;
+        }
+        case GCNENC_MIMG:
+        {
+            const cxuint dmask = (insnCode>>8)&15;
+            cxuint dataRegs = ((mode & GCN_MIMG_VDATA4) != 0) ? 4 :
+                    ((dmask&1) + ((dmask>>1)&1) + ((dmask>>2)&1) + ((dmask>>3)&1));
+            if (dataRegs == 0)
+                dataRegs = 1;
+            if ((insnCode2 & 0x800000U) != 0) // tfe
+                dataRegs++;
+            useGCNVRegs(stats, insnCode2&0xff, (mode & GCN_MIMG_VA_MASK) + 1);
+            useGCNVRegs(stats, (insnCode2>>8)&0xff, dataRegs);
+            useGCNOperandRegs(stats, (insnCode2>>14)&0x7c,
+                        (insnCode & 0x8000U) ? 4 : 8, maxSgprs);
+            if ((mode & GCN_MIMG_SAMPLE) != 0)
+                useGCNOperandRegs(stats, (insnCode2>>19)&0x7c, 4, maxSgprs);
+            break;
+        }
+        case GCNENC_EXP:
+            for (cxuint i = 0; i < 4; i++)
+                if ((insnCode & (1U<<i)) != 0)
+                    useGCNVRegs(stats, (insnCode2>>(i<<3))&0xff, 1);
+            break;
+        case GCNENC_FLAT:
+        {
+            const cxuint dataRegs = ((mode & GCN_DSIZE_MASK)>>GCN_SHIFT2) + 1;
+            const cxuint flatMode = (mode & GCN_FLAT_MODEMASK);
+            // address is 32-bit for GLOBAL/SCRATCH with SADDR
+            const bool haveSaddr = isGCN14 && flatMode != 0 &&
+                        ((insnCode2>>16)&0x7f) != 0x7f;
+            useGCNVRegs(stats, insnCode2&0xff, haveSaddr ? 1 : 2);
+            if (haveSaddr)
+                useGCNOperandRegs(stats, (insnCode2>>16)&0x7f, 2, maxSgprs);
+            if ((mode & GCN_MASK1) != GCN_FLAT_NODATA && (mode & GCN_FLAT_STORE) != 0)
+                useGCNVRegs(stats, (insnCode2>>8)&0xff,
+                            ((mode & GCN_CMPSWAP) != 0) ? dataRegs<<1 : dataRegs);
+            if ((mode & GCN_FLAT_NODST) == 0)
+                useGCNVRegs(stats, insnCode2>>24, dataRegs);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// categories for encodings
+static const cxuint gcnEncodingStatsCategories[GCNENC_MAXVAL+1] =
+{
+    GCNSTATS_ILLEGAL, GCNSTATS_SALU, GCNSTATS_SALU, GCNSTATS_SALU, GCNSTATS_SALU,
+    GCNSTATS_SALU, GCNSTATS_SMEM, GCNSTATS_VALU, GCNSTATS_VALU, GCNSTATS_VALU,
+    GCNSTATS_VALU, GCNSTATS_VALU, GCNSTATS_VALU, GCNSTATS_LDS, GCNSTATS_VMEM,
+    GCNSTATS_VMEM, GCNSTATS_VMEM, GCNSTATS_EXP, GCNSTATS_VMEM
+};
+
+// returns true if instruction ends basic block (branch, jump or end of program)
+static bool isGCNBlockEndInstr(const char* mnemonic)
+{
+    return ::strncmp(mnemonic, "s_cbranch", 9) == 0 ||
+        ::strcmp(mnemonic, "s_branch") == 0 || ::strcmp(mnemonic, "s_endpgm") == 0 ||
+        ::strcmp(mnemonic, "s_setpc_b64") == 0 || ::strcmp(mnemonic, "s_swappc_b64") == 0 ||
+        ::strcmp(mnemonic, "s_call_b64") == 0;
+}
+
+// add counts to sorted list of counts
+static void mergeStatsCounts(std::vector<std::pair<CString, size_t> >& counts,
+            const std::vector<std::pair<CString, size_t> >& newCounts)
+{
+    std::vector<std::pair<CString, size_t> > merged;
+    merged.reserve(counts.size() + newCounts.size());
+    auto it = counts.cbegin();
+    auto newIt = newCounts.cbegin();
+    while (it != counts.cend() || newIt != newCounts.cend())
+    {
+        if (newIt == newCounts.cend() || (it != counts.cend() && it->first < newIt->first))
+            merged.push_back(*it++);
+        else if (it == counts.cend() || newIt->first < it->first)
+            merged.push_back(*newIt++);
+        else
+        {
+            merged.push_back(std::make_pair(it->first, it->second + newIt->second));
+            ++it, ++newIt;
+        }
+    }
+    counts.swap(merged);
+}
+
+void GCNDisassembler::collectStats(GCNCodeStats& stats, bool append)
+{
+    const uint32_t* codeWords = reinterpret_cast<const uint32_t*>(input);
+    const GPUArchitecture arch = getGPUArchitectureFromDeviceType(
+                disassembler.getDeviceType());
+    const bool isGCN11 = (arch == GPUArchitecture::GCN1_1);
+    const bool isGCN124 = (arch >= GPUArchitecture::GCN1_2);
+    const bool isGCN14 = (arch >= GPUArchitecture::GCN1_4);
+    const GPUArchMask curArchMask = 1U<<int(arch);
+    const size_t codeWordsNum = (inputSize>>2);
+    
+    GCNCodeStats::Block curBlock = { startOffset, 0, 0 };
+    if (!append)
+    {
+        stats.codeSize = 0;
+        stats.instrsNum = 0;
+        std::fill(stats.categoryCounts, stats.categoryCounts+GCNSTATS_CATEGORIES_NUM, 0);
+        stats.literalsNum = stats.sdwaNum = stats.dppNum = 0;
+        stats.sgprsNum = stats.vgprsNum = 0;
+        stats.encodingCounts.clear();
+        stats.mnemonicCounts.clear();
+        stats.blocks.clear();
+    }
+    else if (statsBlockOpen && !stats.blocks.empty())
+    {
+        // continue last block from previous part
+        curBlock = stats.blocks.back();
+        stats.blocks.pop_back();
+    }
+    stats.codeSize += inputSize;
+    
+    size_t encodingCounts[GCNENC_MAXVAL+1];
+    std::fill(encodingCounts, encodingCounts+GCNENC_MAXVAL+1, 0);
+    // key - mnemonic (from instruction table), value - count
+    std::unordered_map<const char*, size_t> mnemonicCounts;
+    
+    LabelIter curLabel = std::lower_bound(labels.begin(), labels.end(), startOffset);
+    size_t pos = 0;
+    while (pos < codeWordsNum)
+    {
+        // labels starts new block
+        bool haveLabel = false;
+        for (; curLabel != labels.end() && *curLabel <= startOffset + (pos<<2);
+                    ++curLabel)
+            haveLabel = true;
+        if (haveLabel && curBlock.instrsNum != 0)
+        {
+            curBlock.size = startOffset + (pos<<2) - curBlock.offset;
+            stats.blocks.push_back(curBlock);
+            curBlock = { startOffset + (pos<<2), 0, 0 };
+        }
+        
+        const size_t oldPos = pos;
+        const uint32_t insnCode = ULEV(codeWords[pos++]);
+        if (insnCode == 0)
+        {
+            // zero words are printed as '.fill' by disassembler (not instructions)
+            for (; pos < codeWordsNum && codeWords[pos]==0; pos++);
+            if (curBlock.instrsNum == 0)
+                // block starts after zeros
+                curBlock.offset = startOffset + (pos<<2);
+            continue;
+        }
+        uint32_t insnCode2 = 0;
+        const cxbyte gcnEncoding = getGCNEncoding(codeWords, codeWordsNum, pos,
+                    insnCode, insnCode2, isGCN11, isGCN124);
+        stats.instrsNum++;
+        curBlock.instrsNum++;
+        encodingCounts[gcnEncoding]++;
+        
+        bool blockEnd = false;
+        if (gcnEncoding == GCNENC_NONE)
+            stats.categoryCounts[GCNSTATS_ILLEGAL]++;
+        else
+        {
+            bool isIllegal = false;
+            const cxuint opcode = getGCNOpcode(gcnEncoding, insnCode, isGCN124);
+            const GCNInstruction* gcnInsn = findGCNInstruction(gcnEncoding, opcode,
+                        insnCode, curArchMask, isGCN124, isGCN14, isIllegal);
+            if (isIllegal)
+                stats.categoryCounts[GCNSTATS_ILLEGAL]++;
+            else
+            {
+                stats.categoryCounts[gcnEncodingStatsCategories[gcnEncoding]]++;
+                mnemonicCounts[gcnInsn->mnemonic]++;
+                useGCNInstrRegs(stats, gcnEncoding, *gcnInsn, insnCode, insnCode2,
+                            isGCN124, isGCN14);
+                blockEnd = isGCNBlockEndInstr(gcnInsn->mnemonic);
+            }
+            
+            if (gcnEncoding == GCNENC_VOP1 || gcnEncoding == GCNENC_VOP2 ||
+                gcnEncoding == GCNENC_VOPC)
+            {
+                const cxuint src0 = insnCode&0x1ff;
+                if (isGCN124 && src0 == 0xf9)
+                    stats.sdwaNum++;
+                else if (isGCN124 && src0 == 0xfa)
+                    stats.dppNum++;
+                else if (oldPos+2 == pos)
+                    stats.literalsNum++; // literal or constant (v_madmk, v_madak)
+            }
+            else if ((gcnEncoding == GCNENC_SOP1 || gcnEncoding == GCNENC_SOP2 ||
+                gcnEncoding == GCNENC_SOPC || gcnEncoding == GCNENC_SOPK) &&
+                oldPos+2 == pos)
+                stats.literalsNum++;
+        }
+        
+        if (blockEnd)
+        {
+            curBlock.size = startOffset + (pos<<2) - curBlock.offset;
+            stats.blocks.push_back(curBlock);
+            curBlock = { startOffset + (pos<<2), 0, 0 };
+        }
+    }
+    statsBlockOpen = (curBlock.instrsNum != 0);
+    if (curBlock.instrsNum != 0)
+    {
+        curBlock.size = startOffset + std::min(pos<<2, inputSize) - curBlock.offset;
+        stats.blocks.push_back(curBlock);
+    }
+    
+    // encoding counts (by encoding name)
+    std::vector<std::pair<CString, size_t> > newCounts;
+    for (cxuint i = 0; i <= GCNENC_MAXVAL; i++)
+        if (encodingCounts[i] != 0)
+            newCounts.push_back(std::make_pair(
+                    CString((isGCN124 && i == GCNENC_SMEM) ? "SMEM" : gcnEncodingNames[i]),
+                    encodingCounts[i]));
+    mapSort(newCounts.begin(), newCounts.end());
+    mergeStatsCounts(stats.encodingCounts, newCounts);
+    newCounts.clear();
+    for (const auto& entry: mnemonicCounts)
+        newCounts.push_back(std::make_pair(CString(entry.first), entry.second));
+    mapSort(newCounts.begin(), newCounts.end());
+    mergeStatsCounts(stats.mnemonicCounts, newCounts);
+}
+
+const GCNInstruction* CLRX::decodeGCNInstruction(GPUArchitecture arch,
+            const uint32_t* codeWords, size_t codeWordsNum, size_t& pos,
+            cxbyte& gcnEncoding, uint32_t& insnCode, uint32_t& insnCode2)
+{
+    callOnce(clrxGCNDisasmOnceFlag, initializeGCNDisassembler);
+    const bool isGCN11 = (arch == GPUArchitecture::GCN1_1);
+    const bool isGCN124 = (arch >= GPUArchitecture::GCN1_2);
+    const bool isGCN14 = (arch >= GPUArchitecture::GCN1_4);
+    insnCode = ULEV(codeWords[pos++]);
+    insnCode2 = 0;
+    gcnEncoding = getGCNEncoding(codeWords, codeWordsNum, pos, insnCode, insnCode2,
+                isGCN11, isGCN124);
+    if (gcnEncoding == GCNENC_NONE)
+        return nullptr;
+    bool isIllegal = false;
+    const GCNInstruction* gcnInsn = findGCNInstruction(gcnEncoding,
+                getGCNOpcode(gcnEncoding, insnCode, isGCN124), insnCode,
+                1U<<int(arch), isGCN124, isGCN14, isIllegal);
+    return isIllegal ? nullptr : gcnInsn;
+}
@@ -29,6 +29,7 @@
 #include <CLRX/utils/MemAccess.h>
 #include "GCNInternals.h"
 #include "GCNDisasmInternals.h"
+#include "DisasmInternals.h"
 
 using namespace CLRX;
 
@@ -60,30 +61,35 @@ union CLRX_INTERNAL FloatUnion
 
 static inline void putByteToBuf(cxuint op, char*& bufPtr)
 {
-    cxuint val = op;
-    if (val >= 100U)
+    if (op >= 100U)
     {
-        cxuint digit2 = val/100U;
+        const cxuint digit2 = op/100U;
         *bufPtr++ = digit2+'0';
-        val -= digit2*100U;
+        op -= digit2*100U;
+        // two digits from table
+        ::memcpy(bufPtr, disasmDecDigitPairs + (op<<1), 2);
+        bufPtr += 2;
     }
+    else if (op >= 10U)
     {
-        const cxuint digit1 = val/10U;
-        if (digit1 != 0 || op >= 100U)
-            *bufPtr++ = digit1 + '0';
-        *bufPtr++ = val-digit1*10U + '0';
+        ::memcpy(bufPtr, disasmDecDigitPairs + (op<<1), 2);
+        bufPtr += 2;
     }
+    else
+        *bufPtr++ = op+'0';
 }
 
 static inline void putHexByteToBuf(cxuint op, char*& bufPtr)
 {
-    const cxuint digit0 = op&0xf;
-    const cxuint digit1 = (op&0xf0)>>4;
     *bufPtr++ = '0';
     *bufPtr++ = 'x';
-    if (digit1 != 0)
-        *bufPtr++ = (digit1<=9)?'0'+digit1:'a'+digit1-10;
-    *bufPtr++ = (digit0<=9)?'0'+digit0:'a'+digit0-10;
+    if (op >= 16U)
+    {
+        putHexU8ToBuf(op, bufPtr);
+        bufPtr += 2;
+    }
+    else
+        *bufPtr++ = disasmHexDigitPairs[(op<<1)+1];
 }
 
 // print regranges
@@ -128,7 +134,7 @@ void GCNDisasmUtils::printLiteral(GCNDisassembler& dasm, size_t codePos,
         *bufPtr++ = ')';
     }
     else
-        bufPtr += itocstrCStyle(literal, bufPtr, 11, 16);
+        bufPtr += putHexU32CStyleToBuf(literal, bufPtr);
     if (floatLit != FLTLIT_NONE)
     {
         // print float point (FP16 or FP32) literal in comment
@@ -492,7 +498,7 @@ void GCNDisasmUtils::decodeSOPPEncoding(GCNDisassembler& dasm, cxuint spacesToAd
                 /* additional info about imm16 */
                 if (prevLock)
                     putChars(bufPtr, " :", 2);
-                bufPtr += itocstrCStyle(imm16, bufPtr, 11, 16);
+                bufPtr += putHexU32CStyleToBuf(imm16, bufPtr);
             }
             break;
         }
@@ -540,7 +546,7 @@ void GCNDisasmUtils::decodeSOPPEncoding(GCNDisassembler& dasm, cxuint spacesToAd
             {
                 *bufPtr++ = ' ';
                 *bufPtr++ = ':';
-                bufPtr += itocstrCStyle(imm16, bufPtr, 11, 16);
+                bufPtr += putHexU32CStyleToBuf(imm16, bufPtr);
             }
             break;
         }
@@ -548,12 +554,12 @@ void GCNDisasmUtils::decodeSOPPEncoding(GCNDisassembler& dasm, cxuint spacesToAd
             if (imm16 != 0)
             {
                 addSpaces(bufPtr, spacesToAdd);
-                bufPtr += itocstrCStyle(imm16, bufPtr, 11, 16);
+                bufPtr += putHexU32CStyleToBuf(imm16, bufPtr);
             }
             break;
         default:
             addSpaces(bufPtr, spacesToAdd);
-            bufPtr += itocstrCStyle(imm16, bufPtr, 11, 16);
+            bufPtr += putHexU32CStyleToBuf(imm16, bufPtr);
             break;
     }
     output.forward(bufPtr-bufStart);
@@ -700,7 +706,7 @@ void GCNDisasmUtils::decodeSOPKEncoding(GCNDisassembler& dasm, size_t codePos,
         *bufPtr++ = ')';
     }
     else
-        bufPtr += itocstrCStyle(imm16, bufPtr, 11, 16);
+        bufPtr += putHexU32CStyleToBuf(imm16, bufPtr);
     
     if (gcnInsn.mode & GCN_IMM_DST)
     {
@@ -709,7 +715,7 @@ void GCNDisasmUtils::decodeSOPKEncoding(GCNDisassembler& dasm, size_t codePos,
         if (gcnInsn.mode & GCN_SOPK_CONST)
         {
             // for S_SETREG_IMM32_B32
-            bufPtr += itocstrCStyle(literal, bufPtr, 11, 16);
+            bufPtr += putHexU32CStyleToBuf(literal, bufPtr);
             if (((insnCode>>16)&0x7f) != 0)
             {
                 putChars(bufPtr, " sdst=", 6);
@@ -1933,7 +1939,7 @@ void GCNDisasmUtils::decodeDSEncoding(GCNDisassembler& dasm, cxuint spacesToAdd,
         if ((gcnInsn.mode & GCN_2OFFSETS) == 0) /* single offset */
         {
             putChars(bufPtr, " offset:", 8);
-            bufPtr += itocstrCStyle(offset, bufPtr, 7, 10);
+            bufPtr += putDecU32ToBuf(offset, bufPtr);
         }
         else
         {
@@ -2049,7 +2055,7 @@ void GCNDisasmUtils::decodeMUBUFEncoding(GCNDisassembler& dasm, cxuint spacesToA
     if (offset != 0)
     {
         putChars(bufPtr, " offset:", 8);
-        bufPtr += itocstrCStyle(offset, bufPtr, 7, 10);
+        bufPtr += putDecU32ToBuf(offset, bufPtr);
     }
     if (insnCode & 0x4000U)
         putChars(bufPtr, " glc", 4);
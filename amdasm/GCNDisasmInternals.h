@@ -124,6 +124,21 @@ struct CLRX_INTERNAL GCNDisasmUtils
              uint32_t insnCode2);
 };
 
+/* decode single instruction without disassembling (for code analysis).
+ * pos - position of instruction in words (will be moved to next instruction).
+ * returns instruction or null if instruction is illegal */
+CLRX_INTERNAL const GCNInstruction* decodeGCNInstruction(GPUArchitecture arch,
+            const uint32_t* codeWords, size_t codeWordsNum, size_t& pos,
+            cxbyte& gcnEncoding, uint32_t& insnCode, uint32_t& insnCode2);
+
+/* get number of cycles of instruction (from GcnTimings.md).
+ * dpFactor - DPFACTOR (1,2,4,8) */
+CLRX_INTERNAL cxuint getGCNInstrCycles(const GCNInstruction& gcnInsn, cxbyte gcnEncoding,
+            uint32_t insnCode, GPUArchMask archMask, cxuint dpFactor);
+
+// get DPFACTOR for device type
+CLRX_INTERNAL cxuint getGCNDPFactor(GPUDeviceType deviceType);
+
 };
 
 #endif
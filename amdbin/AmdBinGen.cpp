@@ -178,17 +178,18 @@ void AmdInput::addEmptyKernel(const char* kernelName)
     kernels.push_back(std::move(kernel));
 }
 
-AmdGPUBinGenerator::AmdGPUBinGenerator() : manageable(false), input(nullptr)
+AmdGPUBinGenerator::AmdGPUBinGenerator() : manageable(false), input(nullptr),
+        mergeStrTables(false)
 { }
 
 AmdGPUBinGenerator::AmdGPUBinGenerator(const AmdInput* amdInput)
-        : manageable(false), input(amdInput)
+        : manageable(false), input(amdInput), mergeStrTables(false)
 { }
 
 AmdGPUBinGenerator::AmdGPUBinGenerator(bool _64bitMode, GPUDeviceType deviceType,
        uint32_t driverVersion, size_t globalDataSize, const cxbyte* globalData,
        const std::vector<AmdKernelInput>& kernelInputs)
-        : manageable(true), input(nullptr)
+        : manageable(true), input(nullptr), mergeStrTables(false)
 {
     std::unique_ptr<AmdInput> _input(new AmdInput{});
     _input->is64Bit = _64bitMode;
@@ -205,7 +206,7 @@ AmdGPUBinGenerator::AmdGPUBinGenerator(bool _64bitMode, GPUDeviceType deviceType
 AmdGPUBinGenerator::AmdGPUBinGenerator(bool _64bitMode, GPUDeviceType deviceType,
        uint32_t driverVersion, size_t globalDataSize, const cxbyte* globalData,
        std::vector<AmdKernelInput>&& kernelInputs)
-        : manageable(true), input(nullptr)
+        : manageable(true), input(nullptr), mergeStrTables(false)
 {
     std::unique_ptr<AmdInput> _input(new AmdInput{});
     _input->is64Bit = _64bitMode;
@@ -1635,11 +1636,17 @@ void AmdGPUBinGenerator::generateInternal(std::ostream* osPtr, std::vector<char>
         throw BinGenException("Unsupported GPU device type by OpenCL 1.2 binary format");
     
     if (input->is64Bit)
+    {
         elfBinGen64.reset(new ElfBinaryGen64({ 0, 0, ELFOSABI_SYSV, 0, ET_EXEC, 
             gpuDeviceCodeTable[cxuint(input->deviceType)], EV_CURRENT, UINT_MAX, 0, 0 }));
+        elfBinGen64->setMergeStrTables(mergeStrTables);
+    }
     else
+    {
         elfBinGen32.reset(new ElfBinaryGen32({ 0, 0, ELFOSABI_SYSV, 0, ET_EXEC, 
             gpuDeviceCodeTable[cxuint(input->deviceType)], EV_CURRENT, UINT_MAX, 0, 0 }));
+        elfBinGen32->setMergeStrTables(mergeStrTables);
+    }
     
     Array<TempAmdKernelData> tempAmdKernelDatas(kernelsNum);
     cxuint uniqueId = 1024;
@@ -1742,6 +1749,7 @@ void AmdGPUBinGenerator::generateInternal(std::ostream* osPtr, std::vector<char>
         
         kelfBinGen.setHeader({ 0, 0, 0x64, 1, ET_EXEC, 0x7dU, EV_CURRENT,
                     UINT_MAX, 0, 1 });
+        kelfBinGen.setMergeStrTables(mergeStrTables);
         kelfBinGen.addRegion(ElfRegion32::programHeaderTable());
         // CALNoteDir entries
         kelfBinGen.addRegion(ElfRegion32(sizeof(CALEncodingEntry),
@@ -1821,29 +1829,33 @@ void AmdGPUBinGenerator::generateInternal(std::ostream* osPtr, std::vector<char>
     /****
      * prepare for write binary to output
      ****/
-    std::unique_ptr<std::ostream> outStreamHolder;
+    std::unique_ptr<FastOutputBuffer> outBufHolder;
     std::ostream* os = nullptr;
     if (aPtr != nullptr)
     {
+        // binary size is known, so write directly to array
         aPtr->resize(binarySize);
-        outStreamHolder.reset(
-            new ArrayOStream(binarySize, reinterpret_cast<char*>(aPtr->data())));
-        os = outStreamHolder.get();
+        outBufHolder.reset(new FastOutputBuffer(binarySize,
+                    reinterpret_cast<char*>(aPtr->data())));
     }
     else if (vPtr != nullptr)
     {
         vPtr->resize(binarySize);
-        outStreamHolder.reset(new VectorOStream(*vPtr));
-        os = outStreamHolder.get();
+        outBufHolder.reset(new FastOutputBuffer(binarySize, vPtr->data()));
     }
     else // from argument
+    {
         os = osPtr;
+        outBufHolder.reset(new FastOutputBuffer(256, *os));
+    }
+    FastOutputBuffer& fob = *outBufHolder;
     
-    const std::ios::iostate oldExceptions = os->exceptions();
-    FastOutputBuffer fob(256, *os);
+    const std::ios::iostate oldExceptions = (os != nullptr) ?
+                os->exceptions() : std::ios::goodbit;
     try
     {
-        os->exceptions(std::ios::failbit | std::ios::badbit);
+        if (os != nullptr)
+            os->exceptions(std::ios::failbit | std::ios::badbit);
         if (input->is64Bit)
             elfBinGen64->generate(fob);
         else
@@ -1851,10 +1863,12 @@ void AmdGPUBinGenerator::generateInternal(std::ostream* osPtr, std::vector<char>
     }
     catch(...)
     {
-        os->exceptions(oldExceptions);
+        if (os != nullptr)
+            os->exceptions(oldExceptions);
         throw;
     }
-    os->exceptions(oldExceptions);
+    if (os != nullptr)
+        os->exceptions(oldExceptions);
     assert(fob.getWritten() == binarySize);
 }
 
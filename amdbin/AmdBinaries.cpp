@@ -370,11 +370,9 @@ static size_t getKernelInfosInternal(const typename Types::ElfBinary& elf,
 {
     if (!elf) return 0;
     
-    cxuint rodataIndex = SHN_UNDEF;
-    try
-    { rodataIndex = elf.getSectionIndex(".rodata"); }
-    catch(const Exception& ex)
-    { return 0; /* no section */ }
+    cxuint rodataIndex = elf.findSectionIndex(".rodata");
+    if (rodataIndex == SHN_UNDEF)
+        return 0; /* no section */
     
     const typename Types::Shdr& rodataHdr = elf.getSectionHeader(rodataIndex);
     
@@ -1116,11 +1114,7 @@ AmdMainGPUBinaryBase::AmdMainGPUBinaryBase(AmdMainType type)
 template<typename Types>
 void AmdMainGPUBinaryBase::initMainGPUBinary(typename Types::ElfBinary& mainElf)
 {
-    cxuint textIndex = SHN_UNDEF;
-    try
-    { textIndex = mainElf.getSectionIndex(".text"); }
-    catch(const Exception& ex)
-    { } // ignore failed
+    cxuint textIndex = mainElf.findSectionIndex(".text");
     
     std::vector<size_t> choosenSyms;
     std::vector<size_t> choosenSymsMetadata;
@@ -1188,11 +1182,7 @@ void AmdMainGPUBinaryBase::initMainGPUBinary(typename Types::ElfBinary& mainElf)
     if (doInfoStrings)
     {
         // put driver info
-        uint16_t commentShIndex = SHN_UNDEF;
-        try
-        { commentShIndex = mainElf.getSectionIndex(".comment"); }
-        catch(const Exception& ex)
-        { }
+        uint16_t commentShIndex = mainElf.findSectionIndex(".comment");
         if (commentShIndex != SHN_UNDEF)
         {
             size_t offset = 0;
@@ -1433,11 +1423,7 @@ AmdMainX86Binary32::AmdMainX86Binary32(size_t binaryCodeSize, cxbyte* binaryCode
        Flags creationFlags) : AmdMainBinaryBase(AmdMainType::X86_BINARY),
        ElfBinary32(binaryCodeSize, binaryCode, creationFlags)
 {
-    cxuint textIndex = SHN_UNDEF;
-    try
-    { textIndex = getSectionIndex(".text"); }
-    catch(const Exception& ex)
-    { } // ignore failed
+    cxuint textIndex = findSectionIndex(".text");
     
     if (textIndex != SHN_UNDEF)
     {
@@ -1479,11 +1465,7 @@ AmdMainX86Binary32::AmdMainX86Binary32(size_t binaryCodeSize, cxbyte* binaryCode
         }
         
         // put driver info
-        uint16_t commentShIndex = SHN_UNDEF;
-        try
-        { commentShIndex = getSectionIndex(".comment"); }
-        catch(const Exception& ex)
-        { }
+        uint16_t commentShIndex = findSectionIndex(".comment");
         if (commentShIndex != SHN_UNDEF)
         {
             size_t offset = 0;
@@ -1518,11 +1500,7 @@ AmdMainX86Binary64::AmdMainX86Binary64(size_t binaryCodeSize, cxbyte* binaryCode
        Flags creationFlags) : AmdMainBinaryBase(AmdMainType::X86_64_BINARY),
        ElfBinary64(binaryCodeSize, binaryCode, creationFlags)
 {
-    cxuint textIndex = SHN_UNDEF;
-    try
-    { textIndex = getSectionIndex(".text"); }
-    catch(const Exception& ex)
-    { } // ignore failed
+    cxuint textIndex = findSectionIndex(".text");
     
     if (textIndex != SHN_UNDEF)
     {
@@ -1563,11 +1541,7 @@ AmdMainX86Binary64::AmdMainX86Binary64(size_t binaryCodeSize, cxbyte* binaryCode
         }
         
         // put driver info
-        uint16_t commentShIndex = SHN_UNDEF;
-        try
-        { commentShIndex = getSectionIndex(".comment"); }
-        catch(const Exception& ex)
-        { }
+        uint16_t commentShIndex = findSectionIndex(".comment");
         if (commentShIndex != SHN_UNDEF)
         {
             size_t offset = 0;
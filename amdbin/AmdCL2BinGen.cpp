@@ -52,11 +52,12 @@ void AmdCL2Input::addEmptyKernel(const char* kernelName)
     kernels.push_back(std::move(kernel));
 }
 
-AmdCL2GPUBinGenerator::AmdCL2GPUBinGenerator() : manageable(false), input(nullptr)
+AmdCL2GPUBinGenerator::AmdCL2GPUBinGenerator() : manageable(false), input(nullptr),
+        mergeStrTables(false)
 { }
 
 AmdCL2GPUBinGenerator::AmdCL2GPUBinGenerator(const AmdCL2Input* amdInput)
-        : manageable(false), input(amdInput)
+        : manageable(false), input(amdInput), mergeStrTables(false)
 { }
 
 AmdCL2GPUBinGenerator::AmdCL2GPUBinGenerator(bool _64bitMode,
@@ -64,7 +65,7 @@ AmdCL2GPUBinGenerator::AmdCL2GPUBinGenerator(bool _64bitMode,
        uint32_t driverVersion, size_t globalDataSize, const cxbyte* globalData,
        size_t rwDataSize, const cxbyte* rwData, 
        const std::vector<AmdCL2KernelInput>& kernelInputs)
-        : manageable(true), input(nullptr)
+        : manageable(true), input(nullptr), mergeStrTables(false)
 {
     std::unique_ptr<AmdCL2Input> _input(new AmdCL2Input{});
     _input->is64Bit = _64bitMode;
@@ -90,7 +91,7 @@ AmdCL2GPUBinGenerator::AmdCL2GPUBinGenerator(bool _64bitMode,
        uint32_t driverVersion, size_t globalDataSize, const cxbyte* globalData,
        size_t rwDataSize, const cxbyte* rwData,
        std::vector<AmdCL2KernelInput>&& kernelInputs)
-        : manageable(true), input(nullptr)
+        : manageable(true), input(nullptr), mergeStrTables(false)
 {
     std::unique_ptr<AmdCL2Input> _input(new AmdCL2Input{});
     _input->is64Bit = _64bitMode;
@@ -2419,11 +2420,17 @@ void AmdCL2GPUBinGenerator::generateInternal(std::ostream* osPtr, std::vector<ch
     std::unique_ptr<ElfBinaryGen64> elfBinGen64;
     
     if (input->is64Bit)
+    {
         elfBinGen64.reset(new ElfBinaryGen64({ 0, 0, ELFOSABI_SYSV, 0, ET_EXEC, 0xaf5b,
                 EV_CURRENT, UINT_MAX, 0, deviceCodeTable[cxuint(input->deviceType)] }));
+        elfBinGen64->setMergeStrTables(mergeStrTables);
+    }
     else
+    {
         elfBinGen32.reset(new ElfBinaryGen32({ 0, 0, ELFOSABI_SYSV, 0, ET_EXEC, 0xaf5a,
                 EV_CURRENT, UINT_MAX, 0, deviceCodeTable[cxuint(input->deviceType)] }));
+        elfBinGen32->setMergeStrTables(mergeStrTables);
+    }
     
     CString aclVersion = input->aclVersion;
     if (aclVersion.empty())
@@ -2546,6 +2553,7 @@ void AmdCL2GPUBinGenerator::generateInternal(std::ostream* osPtr, std::vector<ch
                         UINT_MAX, 0, 0 }, (input->driverVersion>=200406), true, true, 
                         /* globaldata sectionid: for 200406 - 4, for older - 1 */
                         (!is16_3Ver) ? 1 : 4));
+        innerBinGen->setMergeStrTables(mergeStrTables);
         innerBinGen->addRegion(ElfRegion64::programHeaderTable());
         
         if (is16_3Ver)
@@ -2787,29 +2795,33 @@ void AmdCL2GPUBinGenerator::generateInternal(std::ostream* osPtr, std::vector<ch
     /****
      * prepare for write binary to output
      ****/
-    std::unique_ptr<std::ostream> outStreamHolder;
+    std::unique_ptr<FastOutputBuffer> outBufHolder;
     std::ostream* os = nullptr;
     if (aPtr != nullptr)
     {
+        // binary size is known, so write directly to array
         aPtr->resize(binarySize);
-        outStreamHolder.reset(
-            new ArrayOStream(binarySize, reinterpret_cast<char*>(aPtr->data())));
-        os = outStreamHolder.get();
+        outBufHolder.reset(new FastOutputBuffer(binarySize,
+                    reinterpret_cast<char*>(aPtr->data())));
     }
     else if (vPtr != nullptr)
     {
         vPtr->resize(binarySize);
-        outStreamHolder.reset(new VectorOStream(*vPtr));
-        os = outStreamHolder.get();
+        outBufHolder.reset(new FastOutputBuffer(binarySize, vPtr->data()));
     }
     else // from argument
+    {
         os = osPtr;
+        outBufHolder.reset(new FastOutputBuffer(256, *os));
+    }
+    FastOutputBuffer& fob = *outBufHolder;
     
-    const std::ios::iostate oldExceptions = os->exceptions();
-    FastOutputBuffer fob(256, *os);
+    const std::ios::iostate oldExceptions = (os != nullptr) ?
+                os->exceptions() : std::ios::goodbit;
     try
     {
-        os->exceptions(std::ios::failbit | std::ios::badbit);
+        if (os != nullptr)
+            os->exceptions(std::ios::failbit | std::ios::badbit);
         if (input->is64Bit)
             elfBinGen64->generate(fob);
         else
@@ -2817,10 +2829,12 @@ void AmdCL2GPUBinGenerator::generateInternal(std::ostream* osPtr, std::vector<ch
     }
     catch(...)
     {
-        os->exceptions(oldExceptions);
+        if (os != nullptr)
+            os->exceptions(oldExceptions);
         throw;
     }
-    os->exceptions(oldExceptions);
+    if (os != nullptr)
+        os->exceptions(oldExceptions);
     assert(fob.getWritten() == binarySize);
 }
 
@@ -24,6 +24,8 @@
 #include <cstdint>
 #include <utility>
 #include <vector>
+#include <string>
+#include <algorithm>
 #include <CLRX/amdbin/Elf.h>
 #include <CLRX/utils/Utilities.h>
 #include <CLRX/utils/MemAccess.h>
@@ -55,11 +57,7 @@ AmdCL2OldInnerGPUBinary::AmdCL2OldInnerGPUBinary(ElfBinaryTemplate<Types>* mainB
 {
     if ((creationFlags & (AMDCL2BIN_CREATE_KERNELDATA|AMDCL2BIN_CREATE_KERNELSTUBS)) == 0)
         return; // nothing to initialize
-    uint16_t textIndex = SHN_UNDEF;
-    try
-    { textIndex = mainBinary->getSectionIndex(".text"); }
-    catch(const Exception& ex)
-    { }
+    uint16_t textIndex = mainBinary->findSectionIndex(".text");
     // find symbols of ISA kernel binary
     std::vector<size_t> choosenSyms;
     const size_t symbolsNum = mainBinary->getSymbolsNum();
@@ -213,69 +211,63 @@ AmdCL2InnerGPUBinary::AmdCL2InnerGPUBinary(size_t binaryCodeSize, cxbyte* binary
             mapSort(kernelDataMap.begin(), kernelDataMap.end());
     }
     // get global data - from section
-    try
+    const uint16_t gdataIndex = findSectionIndex(".hsadata_readonly_agent");
+    if (gdataIndex != SHN_UNDEF)
     {
-        const Elf64_Shdr& gdataShdr = getSectionHeader(".hsadata_readonly_agent");
+        const Elf64_Shdr& gdataShdr = getSectionHeader(gdataIndex);
         globalDataSize = ULEV(gdataShdr.sh_size);
         globalData = binaryCode + ULEV(gdataShdr.sh_offset);
     }
-    catch(const Exception& ex)
-    { }
     
     // get hsadata_global_agent (used by atomics)
-    try
+    const uint16_t rwIndex = findSectionIndex(".hsadata_global_agent");
+    if (rwIndex != SHN_UNDEF)
     {
-        const Elf64_Shdr& rwShdr = getSectionHeader(".hsadata_global_agent");
+        const Elf64_Shdr& rwShdr = getSectionHeader(rwIndex);
         rwDataSize = ULEV(rwShdr.sh_size);
         rwData = binaryCode + ULEV(rwShdr.sh_offset);
     }
-    catch(const Exception& ex)
-    { }
     // get hsabss_gobal_agent
-    try
+    const uint16_t bssIndex = findSectionIndex(".hsabss_global_agent");
+    if (bssIndex != SHN_UNDEF)
     {
-        const Elf64_Shdr& bssShdr = getSectionHeader(".hsabss_global_agent");
+        const Elf64_Shdr& bssShdr = getSectionHeader(bssIndex);
         bssSize = ULEV(bssShdr.sh_size);
         bssAlignment = ULEV(bssShdr.sh_addralign);
     }
-    catch(const Exception& ex)
-    { }
     
     // get ssection with sampler data '.hsaimage_samplerinit'
-    try
+    const uint16_t samplerInitIndex = findSectionIndex(".hsaimage_samplerinit");
+    if (samplerInitIndex != SHN_UNDEF)
     {
-        const Elf64_Shdr& dataShdr = getSectionHeader(".hsaimage_samplerinit");
+        const Elf64_Shdr& dataShdr = getSectionHeader(samplerInitIndex);
         samplerInitSize = ULEV(dataShdr.sh_size);
         samplerInit = binaryCode + ULEV(dataShdr.sh_offset);
     }
-    catch(const Exception& ex)
-    { }
     
     // get relocation section for text
-    try
+    const uint16_t textRelaIndex = findSectionIndex(".rela.hsatext");
+    if (textRelaIndex != SHN_UNDEF)
     {
-        const Elf64_Shdr& relaShdr = getSectionHeader(".rela.hsatext");
+        const Elf64_Shdr& relaShdr = getSectionHeader(textRelaIndex);
         textRelEntrySize = ULEV(relaShdr.sh_entsize);
         if (textRelEntrySize==0)
             textRelEntrySize = sizeof(Elf64_Rela);
         textRelsNum = ULEV(relaShdr.sh_size)/textRelEntrySize;
         textRela = binaryCode + ULEV(relaShdr.sh_offset);
     }
-    catch(const Exception& ex)
-    { }
     
     /// get relocation for hsadata_readonly_agent (readonly data section)
-    try
+    const uint16_t gdataRelaIndex = findSectionIndex(".rela.hsadata_readonly_agent");
+    if (gdataRelaIndex != SHN_UNDEF)
     {
-        const Elf64_Shdr& relaShdr = getSectionHeader(".rela.hsadata_readonly_agent");
+        const Elf64_Shdr& relaShdr = getSectionHeader(gdataRelaIndex);
         globalDataRelEntrySize = ULEV(relaShdr.sh_entsize);
         if (globalDataRelEntrySize==0)
             globalDataRelEntrySize = sizeof(Elf64_Rela);
         globalDataRelsNum = ULEV(relaShdr.sh_size)/globalDataRelEntrySize;
         globalDataRela = binaryCode + ULEV(relaShdr.sh_offset);
     }
-    catch(const Exception& ex)
-    { }
 }
 
 /* AmdCL2MainGPUBinary64 */
@@ -633,14 +625,13 @@ void AmdCL2MainGPUBinaryBase::initMainGPUBinary(typename Types::ElfBinary& elfBi
     }
     
     const bool newInnerBinary = choosenBinSyms.empty();
-    uint16_t textIndex = SHN_UNDEF;
+    const uint16_t textIndex = elfBin.findSectionIndex(".text");
     driverVersion = newInnerBinary ? 191205: 180005;
-    try
-    { textIndex = elfBin.getSectionIndex(".text"); }
-    catch(const Exception& ex)
+    if (textIndex == SHN_UNDEF)
     {
         if (!choosenMetadataSyms.empty())
-            throw;  // throw exception if least one kernel is present
+            // throw exception if least one kernel is present
+            throw BinException(std::string("Can't find Elf")+Types::bitName+" Section");
         else // old driver version
             driverVersion = 180005;
     }
@@ -656,17 +647,16 @@ void AmdCL2MainGPUBinaryBase::initMainGPUBinary(typename Types::ElfBinary& elfBi
             const auto& innerBin = getInnerBinary();
             driverVersion = (innerBin.getSymbolsNum()!=0 &&
                     innerBin.getSymbolName(0)[0]==0) ? 200406 : 191205;
-            try
+            // special detection for first AMDGPU-PRO driver (may be bug in driver)
+            const uint16_t noteIndex = innerBin.findSectionIndex(".note");
+            if (noteIndex != SHN_UNDEF)
             {
-                // special detection for first AMDGPU-PRO driver (may be bug in driver)
-                const Elf64_Shdr& noteShdr = innerBin.getSectionHeader(".note");
-                const cxbyte* noteContent = innerBin.getSectionContent(".note");
+                const Elf64_Shdr& noteShdr = innerBin.getSectionHeader(noteIndex);
+                const cxbyte* noteContent = innerBin.getSectionContent(noteIndex);
                 const size_t noteSize = ULEV(noteShdr.sh_size);
                 if (noteSize == 200 && noteContent[197]!=0)
                     driverVersion = 203603;
             }
-            catch(const Exception& ex)
-            { }
         }
         else // old driver
             innerBinary.reset(new AmdCL2OldInnerGPUBinary(&elfBin, ULEV(textShdr.sh_size),
@@ -1250,3 +1240,72 @@ bool CLRX::isAmdCL2Binary(size_t binarySize, const cxbyte* binary)
     }
     return true;
 }
+
+bool CLRX::patchAmdCL2Kernel(AmdCL2MainGPUBinary64& binary, const char* kernelName,
+            size_t codeSize, const cxbyte* code, const cxbyte* setup,
+            Array<cxbyte>& output)
+{
+    if (!binary.hasInnerBinary() || binary.getDriverVersion() < 191205)
+        throw BinException("Kernel patching is supported only for new binary format");
+    AmdCL2InnerGPUBinary& innerBin = binary.getInnerBinary();
+    const std::string symName = std::string("&__OpenCL_") + kernelName + "_kernel";
+    // first symbol can be kernel symbol in inner binary
+    size_t symIndex = 0;
+    const size_t symbolsNum = innerBin.getSymbolsNum();
+    for (; symIndex < symbolsNum; symIndex++)
+        if (symName == innerBin.getSymbolName(symIndex))
+            break;
+    if (symIndex == symbolsNum)
+        throw BinException("Kernel not found");
+    const Elf64_Sym& sym = innerBin.getSymbol(symIndex);
+    const uint16_t textIndex = ULEV(sym.st_shndx);
+    if (textIndex == SHN_UNDEF || textIndex >= innerBin.getSectionHeadersNum())
+        throw BinException("Kernel section index out of range");
+    const size_t kernelOffset = ULEV(sym.st_value);
+    const size_t kernelSize = ULEV(sym.st_size);
+    // find space for kernel (to next symbol)
+    size_t kernelEnd = ULEV(innerBin.getSectionHeader(textIndex).sh_size);
+    for (size_t i = 0; i < symbolsNum; i++)
+    {
+        const Elf64_Sym& nextSym = innerBin.getSymbol(i);
+        const size_t offset = ULEV(nextSym.st_value);
+        if (ULEV(nextSym.st_shndx) == textIndex && offset > kernelOffset &&
+            offset < kernelEnd)
+            kernelEnd = offset;
+    }
+    if (kernelOffset + kernelSize > kernelEnd)
+        throw BinException("Kernel offset and size out of range");
+    // relocations in old kernel code can not be moved
+    for (size_t i = 0; i < innerBin.getTextRelaEntriesNum(); i++)
+    {
+        const size_t relOffset = ULEV(innerBin.getTextRelaEntry(i).r_offset);
+        if (relOffset >= kernelOffset && relOffset < kernelOffset + kernelSize)
+            throw BinException("Kernel with relocations can not be patched");
+    }
+    
+    if (setup == nullptr)
+        setup = innerBin.getSectionContent(textIndex) + kernelOffset;
+    // code offset after setup (offset 16 of setup)
+    const size_t setupSize = ULEV(*reinterpret_cast<const uint32_t*>(setup+16));
+    if (setupSize < 256 || setupSize > kernelEnd - kernelOffset)
+        throw BinException("Wrong kernel code offset in setup");
+    if (codeSize > SIZE_MAX - setupSize)
+        throw BinException("Kernel code is too big");
+    Array<cxbyte> content(setupSize + codeSize);
+    std::copy(setup, setup + 256, content.data());
+    std::fill(content.data() + 256, content.data() + setupSize, cxbyte(0));
+    std::copy(code, code + codeSize, content.data() + setupSize);
+    
+    Array<cxbyte> innerOutput;
+    if (patchElfSectionRegion(innerBin, textIndex, kernelOffset, kernelSize,
+                kernelEnd - kernelOffset, content.size(), content.data(), innerOutput))
+        return true;
+    
+    // inner binary is content of main code section
+    const uint16_t mainTextIndex = binary.getSectionIndex(".text");
+    growElfSection(static_cast<const ElfBinary64&>(binary), mainTextIndex,
+                   innerOutput.size(), output);
+    std::copy(innerOutput.begin(), innerOutput.end(), output.data() +
+                ULEV(binary.getSectionHeader(mainTextIndex).sh_offset));
+    return false;
+}
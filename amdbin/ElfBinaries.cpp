@@ -23,9 +23,17 @@
 #include <cstring>
 #include <cstdint>
 #include <climits>
+#include <limits>
+#include <cmath>
 #include <utility>
 #include <string>
+#include <vector>
+#include <memory>
 #include <cassert>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <unordered_map>
 #include <CLRX/amdbin/Elf.h>
 #include <CLRX/utils/Utilities.h>
 #include <CLRX/utils/MemAccess.h>
@@ -60,6 +68,143 @@ static size_t unfinishedRegionOfStringTable(const cxbyte* table, size_t size)
     return (table[k]==0)?k+1:k;
 }
 
+/* ELF hash function (used by .hash sections) */
+static uint32_t elfHashOfName(const char* name)
+{
+    uint32_t h = 0, g;
+    const cxbyte* cname = reinterpret_cast<const cxbyte*>(name);
+    while(*cname!=0)
+    {
+        h = (h<<4) + *cname++;
+        g = h & 0xf0000000U;
+        if (g) h ^= g>>24;
+        h &= ~g;
+    }
+    return h;
+}
+
+/* GNU hash function (used by .gnu.hash sections) */
+static uint32_t gnuHashOfName(const char* name)
+{
+    uint32_t h = 5381;
+    for (const cxbyte* cname = reinterpret_cast<const cxbyte*>(name); *cname!=0; cname++)
+        h = (h<<5) + h + *cname;
+    return h;
+}
+
+/* create hash table in .hash layout: bucketsNum, hashNum, buckets, chains
+ * entries in chains are ordered by index */
+static void createHashTable(uint32_t bucketsNum, uint32_t hashNum, bool skipFirst,
+                           const uint32_t* hashCodes, uint32_t* output)
+{
+    SLEV(output[0], bucketsNum);
+    SLEV(output[1], hashNum);
+    uint32_t* buckets = output + 2;
+    uint32_t* chains = output + bucketsNum + 2;
+    std::fill(buckets, buckets + bucketsNum, 0U);
+    std::fill(chains, chains + hashNum, STN_UNDEF);
+    
+    std::unique_ptr<uint32_t[]> lastNodes(new uint32_t[bucketsNum]);
+    std::fill(lastNodes.get(), lastNodes.get() + bucketsNum, UINT32_MAX);
+    for (uint32_t i = skipFirst; i < hashNum; i++)
+    {
+        const uint32_t bucket = hashCodes[i] % bucketsNum;
+        if (lastNodes[bucket] == UINT32_MAX)
+        {
+            // first entry of chain
+            SLEV(buckets[bucket], i);
+            lastNodes[bucket] = i;
+        }
+        else
+        {
+            SLEV(chains[lastNodes[bucket]], i);
+            lastNodes[bucket] = i;
+        }
+    }
+}
+
+/* create hash index of names (one bucket per entry), first entry is not indexed */
+static void createNameHashIndex(uint32_t entriesNum, const uint32_t* hashCodes,
+                        Array<uint32_t>& hashIndex)
+{
+    const uint32_t bucketsNum = std::max(entriesNum, 1U);
+    hashIndex.resize(2 + bucketsNum + entriesNum);
+    createHashTable(bucketsNum, entriesNum, true, hashCodes, hashIndex.data());
+}
+
+/* check .hash section for table with entriesNum entries */
+static bool checkElfHashTable(const cxbyte* content, uint64_t size, size_t entriesNum)
+{
+    if (size < 8)
+        return false;
+    const uint32_t* table = reinterpret_cast<const uint32_t*>(content);
+    const uint32_t bucketsNum = ULEV(table[0]);
+    const uint32_t chainsNum = ULEV(table[1]);
+    return bucketsNum != 0 && chainsNum == entriesNum &&
+            (uint64_t(2) + bucketsNum + chainsNum)*4 <= size;
+}
+
+/* check .gnu.hash section for table with entriesNum entries */
+static bool checkGnuHashTable(const cxbyte* content, uint64_t size, size_t entriesNum,
+                        size_t wordSize)
+{
+    if (size < 16)
+        return false;
+    const uint32_t* table = reinterpret_cast<const uint32_t*>(content);
+    const uint32_t bucketsNum = ULEV(table[0]);
+    const uint32_t symOffset = ULEV(table[1]);
+    const uint32_t bloomSize = ULEV(table[2]);
+    return bucketsNum != 0 && symOffset <= entriesNum &&
+            16 + uint64_t(bloomSize)*wordSize +
+            (uint64_t(bucketsNum) + entriesNum - symOffset)*4 <= size;
+}
+
+/* find name in hash table in .hash layout, returns 0 if not found */
+template<typename GetName>
+static size_t findInElfHashTable(const uint32_t* table, const char* name, GetName getName)
+{
+    const uint32_t bucketsNum = ULEV(table[0]);
+    const uint32_t chainsNum = ULEV(table[1]);
+    const uint32_t* chains = table + 2 + bucketsNum;
+    uint32_t index = ULEV(table[2 + elfHashOfName(name) % bucketsNum]);
+    // number of steps is limited to avoid infinite loop for malformed tables
+    for (uint32_t steps = 0; index != STN_UNDEF && index < chainsNum && steps < chainsNum;
+                steps++)
+    {
+        if (::strcmp(getName(index), name) == 0)
+            return index;
+        index = ULEV(chains[index]);
+    }
+    return 0;
+}
+
+/* find name in .gnu.hash table, returns 0 if not found */
+template<typename GetName>
+static size_t findInGnuHashTable(const uint32_t* table, size_t entriesNum, size_t wordSize,
+                const char* name, GetName getName)
+{
+    const uint32_t bucketsNum = ULEV(table[0]);
+    const uint32_t symOffset = ULEV(table[1]);
+    const uint32_t bloomSize = ULEV(table[2]);
+    const uint32_t* buckets = table + 4 + bloomSize*(wordSize>>2);
+    const uint32_t* chains = buckets + bucketsNum;
+    const uint32_t hash = gnuHashOfName(name);
+    for (size_t index = ULEV(buckets[hash % bucketsNum]);
+                index >= symOffset && index < entriesNum; index++)
+    {
+        const uint32_t chainHash = ULEV(chains[index - symOffset]);
+        if ((hash|1) == (chainHash|1) && ::strcmp(getName(index), name) == 0)
+            return index;
+        if ((chainHash&1) != 0) // end of chain
+            break;
+    }
+    // symbols before symOffset are not hashed
+    for (size_t index = 1; index < symOffset; index++)
+        if (::strcmp(getName(index), name) == 0)
+            return index;
+    return 0;
+}
+
 /* elf32 types */
 
 const cxbyte CLRX::Elf32Types::ELFCLASS = ELFCLASS32;
@@ -78,7 +223,9 @@ template<typename Types>
 ElfBinaryTemplate<Types>::ElfBinaryTemplate() : binaryCodeSize(0), binaryCode(nullptr),
         sectionStringTable(nullptr), symbolStringTable(nullptr),
         symbolTable(nullptr), dynSymStringTable(nullptr), dynSymTable(nullptr),
-        noteTable(nullptr), symbolsNum(0), dynSymbolsNum(0),
+        noteTable(nullptr), symbolElfHash(nullptr), dynSymElfHash(nullptr),
+        dynSymGnuHash(nullptr), symTableIndex(SHN_UNDEF), dynSymTableIndex(SHN_UNDEF),
+        symbolsNum(0), dynSymbolsNum(0),
         noteTableSize(0), dynamicsNum(0), symbolEntSize(0), dynSymEntSize(0),
         dynamicEntSize(0)
 { }
@@ -93,7 +240,9 @@ ElfBinaryTemplate<Types>::ElfBinaryTemplate(size_t _binaryCodeSize, cxbyte* _bin
         binaryCodeSize(_binaryCodeSize), binaryCode(_binaryCode),
         sectionStringTable(nullptr), symbolStringTable(nullptr),
         symbolTable(nullptr), dynSymStringTable(nullptr), dynSymTable(nullptr),
-        noteTable(nullptr), symbolsNum(0), dynSymbolsNum(0),
+        noteTable(nullptr), symbolElfHash(nullptr), dynSymElfHash(nullptr),
+        dynSymGnuHash(nullptr), symTableIndex(SHN_UNDEF), dynSymTableIndex(SHN_UNDEF),
+        symbolsNum(0), dynSymbolsNum(0),
         noteTableSize(0), dynamicsNum(0), symbolEntSize(0), dynSymEntSize(0),
         dynamicEntSize(0)     
 {
@@ -111,6 +260,10 @@ ElfBinaryTemplate<Types>::ElfBinaryTemplate(size_t _binaryCodeSize, cxbyte* _bin
     if (ehdr->e_ident[EI_DATA] != ELFDATA2LSB)
         throw BinException("Other than little-endian binaries are not supported!");
     
+    const bool lazy = (creationFlags & ELF_CREATE_LAZY) != 0;
+    if (lazy)
+        indexOnceFlags.flags.reset(new OnceFlag[3]);
+    
     if ((ULEV(ehdr->e_phoff) == 0 && ULEV(ehdr->e_phnum) != 0))
         throw BinException("Elf invalid phoff and phnum combination");
     if (ULEV(ehdr->e_phoff) != 0)
@@ -123,8 +276,8 @@ ElfBinaryTemplate<Types>::ElfBinaryTemplate(size_t _binaryCodeSize, cxbyte* _bin
                    binaryCodeSize))
             throw BinException("ProgramHeaders offset+size out of range!");
         
-        cxuint phnum = ULEV(ehdr->e_phnum);
         // checking program header segment offset ranges
+        cxuint phnum = ULEV(ehdr->e_phnum);
         for (cxuint i = 0; i < phnum; i++)
         {
             const typename Types::Phdr& phdr = getProgramHeader(i);
@@ -149,59 +302,42 @@ ElfBinaryTemplate<Types>::ElfBinaryTemplate(size_t _binaryCodeSize, cxbyte* _bin
         if (ULEV(ehdr->e_shstrndx) >= ULEV(ehdr->e_shnum))
             throw BinException("Shstrndx out of range!");
         
-        typename Types::Shdr& shstrShdr = getSectionHeader(ULEV(ehdr->e_shstrndx));
+        // checking section offset ranges
+        auto checkSectionRange = [this](const typename Types::Shdr& shdr)
+        {
+            if (ULEV(shdr.sh_offset) > binaryCodeSize)
+                throw BinException("Section offset out of range!");
+            if (ULEV(shdr.sh_type) != SHT_NOBITS)
+                if (usumGt(ULEV(shdr.sh_offset), ULEV(shdr.sh_size), binaryCodeSize))
+                    throw BinException("Section offset+size out of range!");
+        };
+        
+        const typename Types::Shdr& shstrShdr = getSectionHeader(ULEV(ehdr->e_shstrndx));
         sectionStringTable = binaryCode + ULEV(shstrShdr.sh_offset);
-        const size_t unfinishedShstrPos = unfinishedRegionOfStringTable(
-                    sectionStringTable, ULEV(shstrShdr.sh_size));
         
-        const typename Types::Shdr* symTableHdr = nullptr;
-        const typename Types::Shdr* dynSymTableHdr = nullptr;
         const typename Types::Shdr* noteTableHdr = nullptr;
         const typename Types::Shdr* dynamicTableHdr = nullptr;
         
         cxuint shnum = ULEV(ehdr->e_shnum);
-        if ((creationFlags & ELF_CREATE_SECTIONMAP) != 0)
-            sectionIndexMap.resize(shnum);
         for (cxuint i = 0; i < shnum; i++)
         {
             const typename Types::Shdr& shdr = getSectionHeader(i);
-            /// checking section offset ranges
-            if (ULEV(shdr.sh_offset) > binaryCodeSize)
-                throw BinException("Section offset out of range!");
-            if (ULEV(shdr.sh_type) != SHT_NOBITS)
-                if (usumGt(ULEV(shdr.sh_offset), ULEV(shdr.sh_size), binaryCodeSize))
-                    throw BinException("Section offset+size out of range!");
+            checkSectionRange(shdr);
             if (ULEV(shdr.sh_link) >= ULEV(ehdr->e_shnum))
                 throw BinException("Section link out of range!");
-            
-            const typename Types::Size sh_nameindx = ULEV(shdr.sh_name);
-            if (sh_nameindx >= ULEV(shstrShdr.sh_size))
-                throw BinException("Section name index out of range!");
-            
-            if (sh_nameindx >= unfinishedShstrPos)
-                throw BinException("Unfinished section name!");
-            
-            const char* shname =
-                reinterpret_cast<const char*>(sectionStringTable + sh_nameindx);
-            
-            if ((creationFlags & ELF_CREATE_SECTIONMAP) != 0)
-                sectionIndexMap[i] = std::make_pair(shname, i);
             // set symbol table and dynamic symbol table pointers
             if (ULEV(shdr.sh_type) == SHT_SYMTAB)
-                symTableHdr = &shdr;
+                symTableIndex = i;
             if (ULEV(shdr.sh_type) == SHT_DYNSYM)
-                dynSymTableHdr = &shdr;
+                dynSymTableIndex = i;
             if (ULEV(shdr.sh_type) == SHT_NOTE)
                 noteTableHdr = &shdr;
             if (ULEV(shdr.sh_type) == SHT_DYNAMIC)
                 dynamicTableHdr = &shdr;
         }
-        // sort section's map (really is array of sections)
-        if ((creationFlags & ELF_CREATE_SECTIONMAP) != 0)
-            mapSort(sectionIndexMap.begin(), sectionIndexMap.end(), CStringLess());
-        
-        if (symTableHdr != nullptr)
+        if (symTableIndex != SHN_UNDEF)
         {
+            const typename Types::Shdr* symTableHdr = &getSectionHeader(symTableIndex);
             // indexing symbols
             if (ULEV(symTableHdr->sh_entsize) < sizeof(typename Types::Sym))
                 throw BinException("SymTable entry size is too small!");
@@ -213,36 +349,11 @@ ElfBinaryTemplate<Types>::ElfBinaryTemplate(size_t _binaryCodeSize, cxbyte* _bin
             
             typename Types::Shdr& symstrShdr = getSectionHeader(ULEV(symTableHdr->sh_link));
             symbolStringTable = binaryCode + ULEV(symstrShdr.sh_offset);
-            
-            const size_t unfinishedSymstrPos = unfinishedRegionOfStringTable(
-                    symbolStringTable, ULEV(symstrShdr.sh_size));
             symbolsNum = ULEV(symTableHdr->sh_size)/ULEV(symTableHdr->sh_entsize);
-            if ((creationFlags & ELF_CREATE_SYMBOLMAP) != 0)
-                symbolIndexMap.resize(symbolsNum);
-            
-            for (typename Types::Size i = 0; i < symbolsNum; i++)
-            {
-                /* verify symbol names */
-                const typename Types::Sym& sym = getSymbol(i);
-                const typename Types::Size symnameindx = ULEV(sym.st_name);
-                if (symnameindx >= ULEV(symstrShdr.sh_size))
-                    throw BinException("Symbol name index out of range!");
-                // check whether name is finished in string section content
-                if (symnameindx >= unfinishedSymstrPos)
-                    throw BinException("Unfinished symbol name!");
-                
-                const char* symname =
-                    reinterpret_cast<const char*>(symbolStringTable + symnameindx);
-                // add to symbol map
-                if ((creationFlags & ELF_CREATE_SYMBOLMAP) != 0)
-                    symbolIndexMap[i] = std::make_pair(symname, i);
-            }
-            // sort symbol's map (really is array of symbols)
-            if ((creationFlags & ELF_CREATE_SYMBOLMAP) != 0)
-                mapSort(symbolIndexMap.begin(), symbolIndexMap.end(), CStringLess());
         }
-        if (dynSymTableHdr != nullptr)
+        if (dynSymTableIndex != SHN_UNDEF)
         {
+            const typename Types::Shdr* dynSymTableHdr = &getSectionHeader(dynSymTableIndex);
             // indexing dynamic symbols
             if (ULEV(dynSymTableHdr->sh_entsize) < sizeof(typename Types::Sym))
                 throw BinException("DynSymTable entry size is too small!");
@@ -255,35 +366,12 @@ ElfBinaryTemplate<Types>::ElfBinaryTemplate(size_t _binaryCodeSize, cxbyte* _bin
             typename Types::Shdr& dynSymstrShdr =
                     getSectionHeader(ULEV(dynSymTableHdr->sh_link));
             dynSymbolsNum = ULEV(dynSymTableHdr->sh_size)/ULEV(dynSymTableHdr->sh_entsize);
-            
             dynSymStringTable = binaryCode + ULEV(dynSymstrShdr.sh_offset);
-            const size_t unfinishedSymstrPos = unfinishedRegionOfStringTable(
-                    dynSymStringTable, ULEV(dynSymstrShdr.sh_size));
-            
-            if ((creationFlags & ELF_CREATE_DYNSYMMAP) != 0)
-                dynSymIndexMap.resize(dynSymbolsNum);
-            
-            for (typename Types::Size i = 0; i < dynSymbolsNum; i++)
-            {
-                /* verify symbol names */
-                const typename Types::Sym& sym = getDynSymbol(i);
-                const typename Types::Size symnameindx = ULEV(sym.st_name);
-                if (symnameindx >= ULEV(dynSymstrShdr.sh_size))
-                    throw BinException("DynSymbol name index out of range!");
-                // check whether name is finished in string section content
-                if (symnameindx >= unfinishedSymstrPos)
-                    throw BinException("Unfinished dynsymbol name!");
-                
-                const char* symname =
-                    reinterpret_cast<const char*>(dynSymStringTable + symnameindx);
-                // add to symbol map
-                if ((creationFlags & ELF_CREATE_DYNSYMMAP) != 0)
-                    dynSymIndexMap[i] = std::make_pair(symname, i);
-            }
-            // sort dynamic symbol's map (really is array of dynamic symbols)
-            if ((creationFlags & ELF_CREATE_DYNSYMMAP) != 0)
-                mapSort(dynSymIndexMap.begin(), dynSymIndexMap.end(), CStringLess());
         }
+        // in lazy mode, only names are checked, indexes will be created at first use
+        createSectionIndex(lazy);
+        createSymbolIndex(false, lazy);
+        createSymbolIndex(true, lazy);
         if (noteTableHdr != nullptr)
         {
             noteTable = binaryCode + ULEV(noteTableHdr->sh_offset);
@@ -305,47 +393,231 @@ ElfBinaryTemplate<Types>::ElfBinaryTemplate(size_t _binaryCodeSize, cxbyte* _bin
 }
 
 template<typename Types>
-uint16_t ElfBinaryTemplate<Types>::getSectionIndex(const char* name) const
+void ElfBinaryTemplate<Types>::createSectionIndex(bool onlyCheck) const
+{
+    if (sectionStringTable == nullptr)
+        return;
+    const typename Types::Shdr& shstrShdr = getSectionHeader(ULEV(getHeader().e_shstrndx));
+    const size_t unfinishedShstrPos = unfinishedRegionOfStringTable(
+                sectionStringTable, ULEV(shstrShdr.sh_size));
+    
+    const cxuint shnum = getSectionHeadersNum();
+    const bool createMap = !onlyCheck && (creationFlags & ELF_CREATE_SECTIONMAP) != 0;
+    const bool buildHash = !onlyCheck && (creationFlags & ELF_CREATE_HASHINDEX) != 0;
+    std::unique_ptr<uint32_t[]> hashCodes;
+    if (createMap)
+        sectionIndexMap.resize(shnum);
+    if (buildHash)
+        hashCodes.reset(new uint32_t[shnum]);
+    for (cxuint i = 0; i < shnum; i++)
+    {
+        const typename Types::Shdr& shdr = getSectionHeader(i);
+        const typename Types::Size sh_nameindx = ULEV(shdr.sh_name);
+        if (sh_nameindx >= ULEV(shstrShdr.sh_size))
+            throw BinException("Section name index out of range!");
+        
+        if (sh_nameindx >= unfinishedShstrPos)
+            throw BinException("Unfinished section name!");
+        
+        const char* shname =
+            reinterpret_cast<const char*>(sectionStringTable + sh_nameindx);
+        
+        if (createMap)
+            sectionIndexMap[i] = std::make_pair(shname, i);
+        if (buildHash)
+            hashCodes[i] = elfHashOfName(shname);
+    }
+    // sort section's map (really is array of sections)
+    if (createMap)
+        mapSort(sectionIndexMap.begin(), sectionIndexMap.end(), CStringLess());
+    // create hash index of sections
+    if (buildHash)
+        createNameHashIndex(shnum, hashCodes.get(), sectionHashTable);
+}
+
+template<typename Types>
+const uint32_t* ElfBinaryTemplate<Types>::findElfHashSection(uint16_t symTabIndex,
+            size_t entriesNum, uint32_t type) const
+{
+    for (cxuint i = 0; i < getSectionHeadersNum(); i++)
+    {
+        const typename Types::Shdr& hashHdr = getSectionHeader(i);
+        if (ULEV(hashHdr.sh_type) != type || ULEV(hashHdr.sh_link) != symTabIndex)
+            continue;
+        const uint64_t offset = ULEV(hashHdr.sh_offset);
+        const uint64_t size = ULEV(hashHdr.sh_size);
+        if (offset > binaryCodeSize || usumGt(offset, size, binaryCodeSize))
+            continue; // out of range
+        const cxbyte* content = binaryCode + offset;
+        if ((type == SHT_HASH && checkElfHashTable(content, size, entriesNum)) ||
+            (type == SHT_GNU_HASH && checkGnuHashTable(content, size, entriesNum,
+                        sizeof(typename Types::Word))))
+            return reinterpret_cast<const uint32_t*>(content);
+    }
+    return nullptr;
+}
+
+template<typename Types>
+void ElfBinaryTemplate<Types>::createSymbolIndex(bool dynamic, bool onlyCheck) const
+{
+    const uint16_t tableIndex = dynamic ? dynSymTableIndex : symTableIndex;
+    if (tableIndex == SHN_UNDEF)
+        return;
+    const typename Types::Size symsNum = dynamic ? dynSymbolsNum : symbolsNum;
+    const cxbyte* strTable = dynamic ? dynSymStringTable : symbolStringTable;
+    SymbolIndexMap& indexMap = dynamic ? dynSymIndexMap : symbolIndexMap;
+    const bool createMap = !onlyCheck && (creationFlags &
+                (dynamic ? ELF_CREATE_DYNSYMMAP : ELF_CREATE_SYMBOLMAP)) != 0;
+    
+    const typename Types::Shdr& symstrShdr =
+            getSectionHeader(ULEV(getSectionHeader(tableIndex).sh_link));
+    const size_t unfinishedSymstrPos = unfinishedRegionOfStringTable(
+                strTable, ULEV(symstrShdr.sh_size));
+    
+    bool buildHash = false;
+    if (!onlyCheck && (creationFlags & ELF_CREATE_HASHINDEX) != 0)
+    {
+        // prefer .hash, because .gnu.hash omits first (undefined) symbols
+        const uint32_t* elfHash = findElfHashSection(tableIndex, symsNum, SHT_HASH);
+        (dynamic ? dynSymElfHash : symbolElfHash) = elfHash;
+        if (dynamic && elfHash == nullptr)
+            elfHash = dynSymGnuHash = findElfHashSection(tableIndex, symsNum,
+                            SHT_GNU_HASH);
+        buildHash = elfHash == nullptr;
+    }
+    std::unique_ptr<uint32_t[]> hashCodes;
+    if (buildHash)
+        hashCodes.reset(new uint32_t[symsNum]);
+    if (createMap)
+        indexMap.resize(symsNum);
+    
+    for (typename Types::Size i = 0; i < symsNum; i++)
+    {
+        /* verify symbol names */
+        const typename Types::Sym& sym = dynamic ? getDynSymbol(i) : getSymbol(i);
+        const typename Types::Size symnameindx = ULEV(sym.st_name);
+        if (symnameindx >= ULEV(symstrShdr.sh_size))
+            throw BinException(dynamic ? "DynSymbol name index out of range!" :
+                        "Symbol name index out of range!");
+        // check whether name is finished in string section content
+        if (symnameindx >= unfinishedSymstrPos)
+            throw BinException(dynamic ? "Unfinished dynsymbol name!" :
+                        "Unfinished symbol name!");
+        
+        const char* symname = reinterpret_cast<const char*>(strTable + symnameindx);
+        // add to symbol map
+        if (createMap)
+            indexMap[i] = std::make_pair(symname, i);
+        if (buildHash)
+            hashCodes[i] = elfHashOfName(symname);
+    }
+    // sort symbol's map (really is array of symbols)
+    if (createMap)
+        mapSort(indexMap.begin(), indexMap.end(), CStringLess());
+    // create hash index of symbols if no ELF hash section
+    if (buildHash)
+        createNameHashIndex(symsNum, hashCodes.get(),
+                    dynamic ? dynSymHashTable : symbolHashTable);
+}
+
+template<typename Types>
+uint16_t ElfBinaryTemplate<Types>::findSectionIndex(const char* name) const
 {
+    ensureSectionIndex();
+    if (!sectionHashTable.empty())
+        // find in hash index
+        return findInElfHashTable(sectionHashTable.data(), name,
+                    [this](size_t i) { return getSectionName(i); });
     if (hasSectionMap())
     {
         // find in section map (sorted array)
         SectionIndexMap::const_iterator it = binaryMapFind(
                     sectionIndexMap.begin(), sectionIndexMap.end(), name, CStringLess());
-        if (it == sectionIndexMap.end())
-            throw BinException(std::string("Can't find Elf")+Types::bitName+" Section");
-        return it->second;
+        return (it != sectionIndexMap.end()) ? it->second : SHN_UNDEF;
     }
-    else
-    {
-        // find in section headers (fallback)
+    // find in section headers (fallback)
+    if (sectionStringTable != nullptr)
         for (cxuint i = 0; i < getSectionHeadersNum(); i++)
-        {
             if (::strcmp(getSectionName(i), name) == 0)
                 return i;
-        }
-        throw BinException(std::string("Can't find Elf")+Types::bitName+" Section");
+    return SHN_UNDEF;
+}
+
+template<typename Types>
+typename Types::Size ElfBinaryTemplate<Types>::findSymbolIndex(const char* name) const
+{
+    ensureSymbolIndex();
+    auto getName = [this](size_t i) { return getSymbolName(i); };
+    if (symbolElfHash != nullptr)
+        return findInElfHashTable(symbolElfHash, name, getName);
+    if (!symbolHashTable.empty())
+        return findInElfHashTable(symbolHashTable.data(), name, getName);
+    if (hasSymbolMap())
+    {
+        SymbolIndexMap::const_iterator it = binaryMapFind(
+                    symbolIndexMap.begin(), symbolIndexMap.end(), name, CStringLess());
+        return (it != symbolIndexMap.end()) ? it->second : STN_UNDEF;
+    }
+    for (typename Types::Size i = 0; i < symbolsNum; i++)
+        if (::strcmp(getSymbolName(i), name) == 0)
+            return i;
+    return STN_UNDEF;
+}
+
+template<typename Types>
+typename Types::Size ElfBinaryTemplate<Types>::findDynSymbolIndex(const char* name) const
+{
+    ensureDynSymbolIndex();
+    auto getName = [this](size_t i) { return getDynSymbolName(i); };
+    if (dynSymElfHash != nullptr)
+        return findInElfHashTable(dynSymElfHash, name, getName);
+    if (dynSymGnuHash != nullptr)
+        return findInGnuHashTable(dynSymGnuHash, dynSymbolsNum,
+                    sizeof(typename Types::Word), name, getName);
+    if (!dynSymHashTable.empty())
+        return findInElfHashTable(dynSymHashTable.data(), name, getName);
+    if (hasDynSymbolMap())
+    {
+        SymbolIndexMap::const_iterator it = binaryMapFind(
+                    dynSymIndexMap.begin(), dynSymIndexMap.end(), name, CStringLess());
+        return (it != dynSymIndexMap.end()) ? it->second : STN_UNDEF;
     }
+    for (typename Types::Size i = 0; i < dynSymbolsNum; i++)
+        if (::strcmp(getDynSymbolName(i), name) == 0)
+            return i;
+    return STN_UNDEF;
+}
+
+template<typename Types>
+uint16_t ElfBinaryTemplate<Types>::getSectionIndex(const char* name) const
+{
+    const uint16_t index = findSectionIndex(name);
+    // first (null) section is not indexed, check its name
+    if (index == SHN_UNDEF && (sectionStringTable == nullptr ||
+            getSectionHeadersNum() == 0 || ::strcmp(getSectionName(0), name) != 0))
+        throw BinException(std::string("Can't find Elf")+Types::bitName+" Section");
+    return index;
 }
 
 template<typename Types>
 typename Types::Size ElfBinaryTemplate<Types>::getSymbolIndex(const char* name) const
 {
-    SymbolIndexMap::const_iterator it = binaryMapFind(
-                    symbolIndexMap.begin(), symbolIndexMap.end(), name, CStringLess());
-    if (it == symbolIndexMap.end())
+    const typename Types::Size index = findSymbolIndex(name);
+    // first (null) symbol is not indexed, check its name
+    if (index == STN_UNDEF && (symbolsNum == 0 || ::strcmp(getSymbolName(0), name) != 0))
         throw BinException(std::string("Can't find Elf")+Types::bitName+" Symbol");
-    return it->second;
+    return index;
 }
 
 template<typename Types>
 typename Types::Size ElfBinaryTemplate<Types>::getDynSymbolIndex(const char* name) const
 {
-    SymbolIndexMap::const_iterator it = binaryMapFind(
-                    dynSymIndexMap.begin(), dynSymIndexMap.end(), name, CStringLess());
-    if (it == dynSymIndexMap.end())
+    const typename Types::Size index = findDynSymbolIndex(name);
+    // first (null) symbol is not indexed, check its name
+    if (index == STN_UNDEF && (dynSymbolsNum == 0 ||
+                ::strcmp(getDynSymbolName(0), name) != 0))
         throw BinException(std::string("Can't find Elf")+Types::bitName+" DynSymbol");
-    return it->second;
+    return index;
 }
 
 template class CLRX::ElfBinaryTemplate<CLRX::Elf32Types>;
@@ -368,6 +640,240 @@ bool CLRX::isElfBinary(size_t binarySize, const cxbyte* binary)
     return true;
 }
 
+/*
+ * Elf binary patching
+ */
+
+template<typename Types>
+void CLRX::growElfSection(const ElfBinaryTemplate<Types>& elfBin, uint16_t sectionIndex,
+            typename Types::Word newSize, Array<cxbyte>& output)
+{
+    typedef typename Types::Word Word;
+    if (sectionIndex == SHN_UNDEF || sectionIndex >= elfBin.getSectionHeadersNum())
+        throw BinException("Section index out of range");
+    const typename Types::Ehdr& ehdr = elfBin.getHeader();
+    const typename Types::Shdr& secShdr = elfBin.getSectionHeader(sectionIndex);
+    const Word secSize = ULEV(secShdr.sh_size);
+    if (newSize < secSize)
+        throw BinException("New section size is smaller than old size");
+    if (ULEV(secShdr.sh_type) == SHT_NOBITS)
+        throw BinException("Section without content can not be grown");
+    const Word growth = newSize - secSize;
+    const Word secOffset = ULEV(secShdr.sh_offset);
+    const Word secEnd = secOffset + secSize;
+    const Word secAddr = ULEV(secShdr.sh_addr);
+    const Word secAddrEnd = secAddr + secSize;
+    // addresses are never moved, because code can refer to other loaded content
+    // by relative offsets (section in loaded binary must fit in free address space)
+    const bool loaded = (ULEV(secShdr.sh_flags) & SHF_ALLOC) != 0 &&
+            ULEV(ehdr.e_type) != ET_REL && secAddr != 0;
+    const size_t binarySize = elfBin.getSize();
+
+    // find free space after section (to next content and next address)
+    Word nextOffset = std::numeric_limits<Word>::max();
+    Word nextAddress = std::numeric_limits<Word>::max();
+    Word maxAlign = 1;
+    const uint16_t sectionsNum = elfBin.getSectionHeadersNum();
+    for (uint16_t i = 1; i < sectionsNum; i++)
+    {
+        if (i == sectionIndex)
+            continue;
+        const typename Types::Shdr& shdr = elfBin.getSectionHeader(i);
+        if (ULEV(shdr.sh_type) == SHT_NULL)
+            continue;
+        if (ULEV(shdr.sh_offset) >= secEnd)
+        {
+            nextOffset = std::min(nextOffset, Word(ULEV(shdr.sh_offset)));
+            maxAlign = std::max(maxAlign, Word(ULEV(shdr.sh_addralign)));
+        }
+        if (loaded && (ULEV(shdr.sh_flags) & SHF_ALLOC) != 0 &&
+            ULEV(shdr.sh_addr) >= secAddrEnd)
+            nextAddress = std::min(nextAddress, Word(ULEV(shdr.sh_addr)));
+    }
+    if (ULEV(ehdr.e_shoff) >= secEnd)
+    {
+        nextOffset = std::min(nextOffset, Word(ULEV(ehdr.e_shoff)));
+        maxAlign = std::max(maxAlign, Word(sizeof(Word)));
+    }
+    if (ULEV(ehdr.e_phoff) >= secEnd)
+    {
+        nextOffset = std::min(nextOffset, Word(ULEV(ehdr.e_phoff)));
+        maxAlign = std::max(maxAlign, Word(sizeof(Word)));
+    }
+    const uint16_t phdrsNum = elfBin.getProgramHeadersNum();
+    for (uint16_t i = 0; i < phdrsNum; i++)
+    {
+        const typename Types::Phdr& phdr = elfBin.getProgramHeader(i);
+        if (ULEV(phdr.p_filesz) == 0 && ULEV(phdr.p_memsz) == 0)
+            continue;
+        if (ULEV(phdr.p_offset) >= secEnd)
+        {
+            nextOffset = std::min(nextOffset, Word(ULEV(phdr.p_offset)));
+            maxAlign = std::max(maxAlign, Word(ULEV(phdr.p_align)));
+        }
+        if (loaded && ULEV(phdr.p_type) == PT_LOAD && ULEV(phdr.p_vaddr) >= secAddrEnd)
+            nextAddress = std::min(nextAddress, Word(ULEV(phdr.p_vaddr)));
+    }
+    if (nextAddress != std::numeric_limits<Word>::max() &&
+        growth > nextAddress-secAddrEnd)
+        throw BinException("No free address space after section");
+
+    // shift of content after section (keeps alignment of all moved content)
+    Word shift = 0;
+    if (nextOffset != std::numeric_limits<Word>::max() && growth > nextOffset-secEnd)
+        shift = (growth + maxAlign-1) / maxAlign * maxAlign;
+    if (loaded && shift != 0)
+        for (uint16_t i = 0; i < phdrsNum; i++)
+        {
+            // loaded content after section in this same segment can not be moved
+            const typename Types::Phdr& phdr = elfBin.getProgramHeader(i);
+            const Word pOffset = ULEV(phdr.p_offset);
+            if (pOffset <= secOffset && pOffset + ULEV(phdr.p_filesz) > secEnd)
+                throw BinException("Segment content after section can not be moved");
+        }
+
+    output.allocate(std::max(size_t(binarySize + shift), size_t(secEnd + growth)));
+    const cxbyte* binary = elfBin.getBinaryCode();
+    cxbyte* out = output.data();
+    std::copy(binary, binary + secEnd, out);
+    std::fill(out + secEnd, out + secEnd + (shift!=0 ? shift : growth), cxbyte(0));
+    std::copy(binary + secEnd, binary + binarySize, out + secEnd + shift);
+    if (secEnd + growth > binarySize + shift)
+        // section at end of binary
+        std::fill(out + binarySize, out + secEnd + growth, cxbyte(0));
+
+    // update ELF header
+    typename Types::Ehdr& outEhdr = *reinterpret_cast<typename Types::Ehdr*>(out);
+    if (ULEV(outEhdr.e_shoff) >= secEnd)
+        SLEV(outEhdr.e_shoff, ULEV(outEhdr.e_shoff) + shift);
+    if (ULEV(outEhdr.e_phoff) >= secEnd)
+        SLEV(outEhdr.e_phoff, ULEV(outEhdr.e_phoff) + shift);
+
+    // update section headers
+    const size_t shentSize = ULEV(outEhdr.e_shentsize);
+    cxbyte* outShdrs = out + ULEV(outEhdr.e_shoff);
+    for (uint16_t i = 1; i < sectionsNum; i++)
+    {
+        typename Types::Shdr& shdr = *reinterpret_cast<typename Types::Shdr*>(
+                    outShdrs + shentSize*i);
+        if (ULEV(shdr.sh_type) == SHT_NULL)
+            continue;
+        if (i == sectionIndex)
+            SLEV(shdr.sh_size, newSize);
+        else if (ULEV(shdr.sh_offset) >= secEnd)
+            SLEV(shdr.sh_offset, ULEV(shdr.sh_offset) + shift);
+    }
+
+    // update program headers
+    const size_t phentSize = ULEV(outEhdr.e_phentsize);
+    cxbyte* outPhdrs = out + ULEV(outEhdr.e_phoff);
+    for (uint16_t i = 0; i < phdrsNum; i++)
+    {
+        typename Types::Phdr& phdr = *reinterpret_cast<typename Types::Phdr*>(
+                    outPhdrs + phentSize*i);
+        const Word pOffset = ULEV(phdr.p_offset);
+        const Word pFileSize = ULEV(phdr.p_filesz);
+        const Word pAddr = ULEV(phdr.p_vaddr);
+        const Word pMemSize = ULEV(phdr.p_memsz);
+        if (pFileSize == 0 && pMemSize == 0)
+            continue;
+        if (pOffset >= secEnd)
+            SLEV(phdr.p_offset, pOffset + shift);
+        else if (pOffset <= secOffset && pOffset + pFileSize >= secEnd)
+        {
+            // segment contains section
+            const Word fileExtra = (pOffset + pFileSize > secEnd) ? shift : growth;
+            SLEV(phdr.p_filesz, pFileSize + fileExtra);
+            if (!loaded)
+                SLEV(phdr.p_memsz, pMemSize + fileExtra);
+            else if (pAddr <= secAddr && pAddr + pMemSize < secAddrEnd + growth)
+                SLEV(phdr.p_memsz, secAddrEnd + growth - pAddr);
+        }
+    }
+}
+
+template<typename Types>
+bool CLRX::patchElfSectionRegion(ElfBinaryTemplate<Types>& elfBin,
+            uint16_t sectionIndex, typename Types::Word regionOffset,
+            typename Types::Word regionSize, typename Types::Word regionSpace,
+            size_t contentSize, const cxbyte* content, Array<cxbyte>& output)
+{
+    typedef typename Types::Word Word;
+    if (sectionIndex == SHN_UNDEF || sectionIndex >= elfBin.getSectionHeadersNum())
+        throw BinException("Section index out of range");
+    typename Types::Shdr& shdr = elfBin.getSectionHeader(sectionIndex);
+    const Word secSize = ULEV(shdr.sh_size);
+    if (regionOffset > secSize || usumGt(regionOffset, regionSpace, secSize) ||
+        regionSize > regionSpace)
+        throw BinException("Region offset and size out of range");
+    const bool relocatable = ULEV(elfBin.getHeader().e_type) == ET_REL;
+    const Word oldValue = regionOffset + (relocatable ? 0 : Word(ULEV(shdr.sh_addr)));
+
+    // update symbols that pointing to region
+    auto updateSymbols = [sectionIndex, oldValue, contentSize]
+            (ElfBinaryTemplate<Types>& elf, Word newValue)
+    {
+        for (size_t i = 0; i < elf.getSymbolsNum(); i++)
+        {
+            typename Types::Sym& sym = elf.getSymbol(i);
+            const cxbyte type = ELF32_ST_TYPE(sym.st_info);
+            if (ULEV(sym.st_shndx) == sectionIndex && ULEV(sym.st_value) == oldValue &&
+                type != STT_SECTION && type != STT_NOTYPE)
+            {
+                SLEV(sym.st_value, newValue);
+                SLEV(sym.st_size, contentSize);
+            }
+        }
+        for (size_t i = 0; i < elf.getDynSymbolsNum(); i++)
+        {
+            typename Types::Sym& sym = elf.getDynSymbol(i);
+            const cxbyte type = ELF32_ST_TYPE(sym.st_info);
+            if (ULEV(sym.st_shndx) == sectionIndex && ULEV(sym.st_value) == oldValue &&
+                type != STT_SECTION && type != STT_NOTYPE)
+            {
+                SLEV(sym.st_value, newValue);
+                SLEV(sym.st_size, contentSize);
+            }
+        }
+    };
+
+    if (contentSize <= regionSpace)
+    {
+        // in place
+        cxbyte* region = elfBin.getSectionContent(sectionIndex) + regionOffset;
+        std::copy(content, content + contentSize, region);
+        if (contentSize < regionSize)
+            std::fill(region + contentSize, region + regionSize, cxbyte(0));
+        updateSymbols(elfBin, oldValue);
+        return true;
+    }
+
+    // move region to end of section (or grow section if region is last)
+    const Word align = std::max(Word(ULEV(shdr.sh_addralign)), Word(1));
+    const Word newOffset = (regionOffset + regionSpace == secSize) ? regionOffset :
+            (secSize + align-1) / align * align;
+    growElfSection(elfBin, sectionIndex, newOffset + contentSize, output);
+    ElfBinaryTemplate<Types> outBin(output.size(), output.data(), 0);
+    const typename Types::Shdr& outShdr = outBin.getSectionHeader(sectionIndex);
+    std::copy(content, content + contentSize, output.data() +
+                ULEV(outShdr.sh_offset) + newOffset);
+    updateSymbols(outBin, newOffset + (relocatable ? 0 : Word(ULEV(outShdr.sh_addr))));
+    return false;
+}
+
+template void CLRX::growElfSection<CLRX::Elf32Types>(const ElfBinary32& elfBin,
+            uint16_t sectionIndex, uint32_t newSize, Array<cxbyte>& output);
+template void CLRX::growElfSection<CLRX::Elf64Types>(const ElfBinary64& elfBin,
+            uint16_t sectionIndex, uint64_t newSize, Array<cxbyte>& output);
+template bool CLRX::patchElfSectionRegion<CLRX::Elf32Types>(ElfBinary32& elfBin,
+            uint16_t sectionIndex, uint32_t regionOffset, uint32_t regionSize,
+            uint32_t regionSpace, size_t contentSize, const cxbyte* content,
+            Array<cxbyte>& output);
+template bool CLRX::patchElfSectionRegion<CLRX::Elf64Types>(ElfBinary64& elfBin,
+            uint16_t sectionIndex, uint64_t regionOffset, uint64_t regionSize,
+            uint64_t regionSpace, size_t contentSize, const cxbyte* content,
+            Array<cxbyte>& output);
+
 /*
  * Elf binary generator
  */
@@ -397,6 +903,106 @@ uint16_t CLRX::convertSectionId(cxuint sectionIndex, const uint16_t* builtinSect
 ElfRegionContent::~ElfRegionContent()
 { }
 
+/*
+ * ELF string table builder
+ */
+
+ElfStrTabBuilder::ElfStrTabBuilder(bool _addNull) : addNull(_addNull)
+{ }
+
+void ElfStrTabBuilder::clear(bool _addNull)
+{
+    addNull = _addNull;
+    strings.clear();
+    offsets.reset();
+    table.clear();
+}
+
+namespace
+{
+
+struct StrTabEntry
+{
+    const char* str;
+    size_t len;
+    uint32_t offset;
+};
+
+struct CStringHash
+{
+    size_t operator()(const char* str) const
+    { return gnuHashOfName(str); }
+};
+
+struct CStringEqual
+{
+    bool operator()(const char* str1, const char* str2) const
+    { return ::strcmp(str1, str2)==0; }
+};
+
+}
+
+void ElfStrTabBuilder::build()
+{
+    table.clear();
+    if (addNull)
+        table.push_back(0);
+    offsets.reset(new uint32_t[strings.size()]);
+    
+    // remove duplicates
+    std::unordered_map<const char*, size_t, CStringHash, CStringEqual> stringMap;
+    std::vector<StrTabEntry> entries;
+    std::unique_ptr<size_t[]> entryIndices(new size_t[strings.size()]);
+    for (size_t i = 0; i < strings.size(); i++)
+    {
+        const char* str = (strings[i] != nullptr) ? strings[i] : "";
+        auto res = stringMap.insert(std::make_pair(str, entries.size()));
+        if (res.second)
+            entries.push_back({ str, ::strlen(str), 0 });
+        entryIndices[i] = res.first->second;
+    }
+    
+    /* sort by reversed strings in descending order.
+     * string that is suffix of other strings is placed after these strings */
+    std::vector<size_t> order(entries.size());
+    for (size_t i = 0; i < entries.size(); i++)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&entries](size_t a, size_t b)
+    {
+        const StrTabEntry& ea = entries[a];
+        const StrTabEntry& eb = entries[b];
+        const cxbyte* pa = reinterpret_cast<const cxbyte*>(ea.str) + ea.len;
+        const cxbyte* pb = reinterpret_cast<const cxbyte*>(eb.str) + eb.len;
+        for (size_t n = std::min(ea.len, eb.len); n != 0; n--)
+        {
+            --pa; --pb;
+            if (*pa != *pb)
+                return *pa > *pb;
+        }
+        return ea.len > eb.len;
+    });
+    
+    // put strings and merge tails
+    const StrTabEntry* prev = nullptr;
+    for (size_t idx: order)
+    {
+        StrTabEntry& entry = entries[idx];
+        if (entry.len == 0 && addNull)
+            entry.offset = 0; // null string
+        else if (prev != nullptr && prev->len >= entry.len &&
+            ::memcmp(prev->str + prev->len - entry.len, entry.str, entry.len) == 0)
+            entry.offset = prev->offset + prev->len - entry.len;
+        else
+        {
+            entry.offset = table.size();
+            table.insert(table.end(), entry.str, entry.str + entry.len + 1);
+            prev = &entry;
+        }
+    }
+    for (size_t i = 0; i < strings.size(); i++)
+        offsets[i] = entries[entryIndices[i]].offset;
+}
+
 template<typename Types>
 static std::unique_ptr<uint32_t[]> calculateHashValuesForSymbols(bool addNullSymbol,
             const std::vector<ElfSymbolTemplate<Types> >& symbols)
@@ -407,21 +1013,25 @@ static std::unique_ptr<uint32_t[]> calculateHashValuesForSymbols(bool addNullSym
         hashCodes[0] = 0;
     for (size_t i = 0; i < symbols.size(); i++)
     {
-        // main routine of hash
-        uint32_t h = 0, g;
-        const cxbyte* name = reinterpret_cast<const cxbyte*>(symbols[i].name);
-        while(*name!=0)
-        {
-            h = (h<<4) + *name++;
-            g = h & 0xf0000000U;
-            if (g) h ^= g>>24;
-            h &= ~g;
-        }
-        hashCodes[i+addNullSymbol] = h;
+        hashCodes[i+addNullSymbol] = elfHashOfName(symbols[i].name);
     }
     return hashCodes;
 }
 
+// cost of hash table with buckets, smaller is better
+static uint64_t hashBucketsCost(uint32_t buckets, uint32_t hashNum, bool skipFirst,
+                    const uint32_t* hashCodes, uint32_t* chainLengths)
+{
+    std::fill(chainLengths, chainLengths + buckets, 0U);
+    // calculate chain lengths
+    for (size_t i = skipFirst; i < hashNum; i++)
+        chainLengths[hashCodes[i] % buckets]++;
+    uint64_t value = uint64_t(buckets);
+    for (uint32_t i = 0; i < buckets; i++)
+        value += uint64_t(chainLengths[i])*chainLengths[i];
+    return value;
+}
+
 /// return bucket number
 static uint32_t optimizeHashBucketsNum(uint32_t hashNum, bool skipFirst,
                            const uint32_t* hashCodes)
@@ -430,27 +1040,61 @@ static uint32_t optimizeHashBucketsNum(uint32_t hashNum, bool skipFirst,
     uint64_t bestValue = UINT64_MAX;
     uint32_t firstStep = std::max(uint32_t(hashNum>>2), 1U);
     uint64_t maxSteps = (uint64_t(hashNum)<<1) - (firstStep) + 1;
-    // limit step of optimizations to 4000
-    const uint32_t steps = std::min(maxSteps, uint64_t(4000U));
-    
     std::unique_ptr<uint32_t[]> chainLengths(new uint32_t[(hashNum<<2)+1]);
-    const uint32_t stepSize = maxSteps / steps;
-    for (uint32_t buckets = firstStep; buckets <= (hashNum<<1); buckets += stepSize)
-    {   //
-        std::fill(chainLengths.get(), chainLengths.get() + buckets, 0U);
-        // calculate chain lengths
-        for (size_t i = skipFirst; i < hashNum; i++)
-            chainLengths[hashCodes[i] % buckets]++;
-        /// value, smaller is better
-        uint64_t value = uint64_t(buckets);
-        for (uint32_t i = 0; i < buckets; i++)
-            value += chainLengths[i]*chainLengths[i];
+    
+    if (hashNum <= 2048)
+    {
+        // limit step of optimizations to 4000
+        const uint32_t steps = std::min(maxSteps, uint64_t(4000U));
+        const uint32_t stepSize = maxSteps / steps;
+        for (uint32_t buckets = firstStep; buckets <= (hashNum<<1); buckets += stepSize)
+        {
+            const uint64_t value = hashBucketsCost(buckets, hashNum, skipFirst,
+                            hashCodes, chainLengths.get());
+            if (value < bestValue)
+            {
+                bestBucketNum = buckets;
+                bestValue = value;
+            }
+        }
+        return bestBucketNum;
+    }
+    
+    /* for big tables, estimate best bucket number from histogram of hash values:
+     * symbols with equal hash values always share a chain, other pairs
+     * collide with probability 1/buckets, hence cost is about
+     * buckets + S + (N*N-S)/buckets (S - sum of squared hash value counts),
+     * and it is minimal for buckets = sqrt(N*N-S) */
+    const size_t entriesNum = hashNum - skipFirst;
+    std::unique_ptr<uint32_t[]> sortedCodes(new uint32_t[entriesNum]);
+    std::copy(hashCodes + skipFirst, hashCodes + hashNum, sortedCodes.get());
+    std::sort(sortedCodes.get(), sortedCodes.get() + entriesNum);
+    uint64_t sameSquares = 0;
+    for (size_t i = 0; i < entriesNum; )
+    {
+        size_t j = i+1;
+        for (; j < entriesNum && sortedCodes[j] == sortedCodes[i]; j++);
+        sameSquares += uint64_t(j-i)*(j-i);
+        i = j;
+    }
+    const uint64_t estimate = uint64_t(::sqrt(double(uint64_t(entriesNum)*entriesNum -
+                sameSquares)));
+    // check only few bucket numbers around estimate
+    const uint64_t first = std::max(uint64_t(firstStep), estimate >= 8 ? estimate-8 : 0);
+    const uint64_t last = std::min(uint64_t(hashNum)<<1, estimate+8);
+    for (uint64_t buckets = first; buckets <= last; buckets++)
+    {
+        const uint64_t value = hashBucketsCost(buckets, hashNum, skipFirst,
+                        hashCodes, chainLengths.get());
         if (value < bestValue)
         {
             bestBucketNum = buckets;
             bestValue = value;
         }
     }
+    if (bestBucketNum == 0) // if estimate out of range
+        bestBucketNum = std::min(std::max(uint64_t(firstStep), estimate),
+                            uint64_t(hashNum)<<1);
     return bestBucketNum;
 }
 
@@ -458,7 +1102,9 @@ template<typename Types>
 ElfBinaryGenTemplate<Types>::ElfBinaryGenTemplate()
         : sizeComputed(false), addNullSym(true), addNullDynSym(true), addNullSection(true),
           addrStartRegion(0), shStrTab(0), strTab(0), dynStr(0), shdrTabRegion(0),
-          phdrTabRegion(0), bucketsNum(0), isHashDynSym(false)
+          phdrTabRegion(0), bucketsNum(0), isHashDynSym(false), gnuBucketsNum(0),
+          gnuSymOffset(0), gnuBloomSize(0), nullSymNameOffset(0),
+          nullDynSymNameOffset(0), nullSectionNameOffset(0), mergeStrTables(false)
 { }
 
 template<typename Types>
@@ -468,7 +1114,9 @@ ElfBinaryGenTemplate<Types>::ElfBinaryGenTemplate(const ElfHeaderTemplate<Types>
         : sizeComputed(false), addNullSym(_addNullSym), addNullDynSym(_addNullDynSym),
           addNullSection(_addNullSection),  addrStartRegion(addrCountingFromRegion),
           shStrTab(0), strTab(0), dynStr(0), shdrTabRegion(0), phdrTabRegion(0),
-          header(_header), bucketsNum(0), isHashDynSym(false)
+          header(_header), bucketsNum(0), isHashDynSym(false), gnuBucketsNum(0),
+          gnuSymOffset(0), gnuBloomSize(0), nullSymNameOffset(0),
+          nullDynSymNameOffset(0), nullSectionNameOffset(0), mergeStrTables(false)
 { }
 
 template<typename Types>
@@ -500,30 +1148,106 @@ static inline typename Types::Word resolveSectionAddress(
         return 0;
 }
 
+/* bloom filter shift in .gnu.hash */
+static const uint32_t gnuHashBloomShift = 26;
+
 template<typename Types>
-void ElfBinaryGenTemplate<Types>::computeSize()
+void ElfBinaryGenTemplate<Types>::prepareGnuHash()
 {
-    if (sizeComputed) return;
+    const size_t symsNum = dynSymbols.size();
+    // local symbols are not hashed and they must be before hashed symbols
+    std::unique_ptr<uint32_t[]> symHashes(new uint32_t[symsNum]);
+    std::unique_ptr<uint32_t[]> hashes(new uint32_t[symsNum]);
+    size_t hashedNum = 0;
+    for (size_t i = 0; i < symsNum; i++)
+        if (ELF32_ST_BIND(dynSymbols[i].info) != STB_LOCAL)
+            hashes[hashedNum++] = symHashes[i] = gnuHashOfName(dynSymbols[i].name);
+    gnuBucketsNum = (hashedNum != 0) ?
+            optimizeHashBucketsNum(hashedNum, false, hashes.get()) : 1;
+    gnuSymOffset = addNullDynSym + (symsNum - hashedNum);
+    // bloom filter: about 8 bits per symbol
+    const size_t bloomWords = hashedNum / sizeof(typename Types::Word);
+    for (gnuBloomSize = 1; gnuBloomSize < bloomWords; gnuBloomSize <<= 1);
     
-    /* verify data */
-    if (header.entryRegion != UINT_MAX && header.entryRegion >= regions.size())
-        throw BinGenException("Header entry region out of range");
+    // symbols must be sorted by bucket
+    std::unique_ptr<uint32_t[]> order(new uint32_t[symsNum]);
+    for (size_t i = 0; i < symsNum; i++)
+        order[i] = i;
+    std::stable_sort(order.get(), order.get() + symsNum,
+        [this, &symHashes](uint32_t a, uint32_t b)
+        {
+            const bool aLocal = ELF32_ST_BIND(dynSymbols[a].info) == STB_LOCAL;
+            const bool bLocal = ELF32_ST_BIND(dynSymbols[b].info) == STB_LOCAL;
+            if (aLocal || bLocal)
+                return aLocal && !bLocal;
+            return (symHashes[a] % gnuBucketsNum) < (symHashes[b] % gnuBucketsNum);
+        });
     
-    regionOffsets.reset(new typename Types::Word[regions.size()]);
-    regionAddresses.reset(new typename Types::Word[regions.size()]);
+    std::vector<ElfSymbolTemplate<Types> > sortedSymbols(symsNum);
+    dynSymOutIndices.reset(new uint32_t[symsNum]);
+    gnuHashCodes.reset(new uint32_t[hashedNum]);
+    const size_t localsNum = symsNum - hashedNum;
+    for (size_t i = 0; i < symsNum; i++)
+    {
+        sortedSymbols[i] = dynSymbols[order[i]];
+        dynSymOutIndices[order[i]] = i + addNullDynSym;
+        if (i >= localsNum)
+            gnuHashCodes[i - localsNum] = symHashes[order[i]];
+    }
+    dynSymbols.swap(sortedSymbols);
+}
+
+template<typename Types>
+void ElfBinaryGenTemplate<Types>::buildStrTables()
+{
+    strTabBuilder.clear(addNullSym);
+    for (const auto& sym: symbols)
+        strTabBuilder.add(sym.name);
+    strTabBuilder.build();
+    dynStrBuilder.clear(addNullDynSym);
+    for (const auto& sym: dynSymbols)
+        dynStrBuilder.add(sym.name);
+    dynStrBuilder.build();
+    shStrTabBuilder.clear(addNullSection);
+    for (const auto& region: regions)
+        if (region.type == ElfRegionType::SECTION)
+            shStrTabBuilder.add(region.section.name);
+    shStrTabBuilder.build();
+}
+
+template<typename Types>
+void ElfBinaryGenTemplate<Types>::computeSize()
+{
+    if (sizeComputed) return;
+    
+    /* verify data */
+    if (header.entryRegion != UINT_MAX && header.entryRegion >= regions.size())
+        throw BinGenException("Header entry region out of range");
+    
+    regionOffsets.reset(new typename Types::Word[regions.size()]);
+    regionAddresses.reset(new typename Types::Word[regions.size()]);
     size = sizeof(typename Types::Ehdr);
     sectionsNum = addNullSection; // if add null section
     cxuint hashSymSectionIdx = UINT_MAX;
     bool haveDynamic = false;
+    bool haveGnuHash = false;
     for (const auto& region: regions)
         if (region.type == ElfRegionType::SECTION)
         {
             if (region.section.type==SHT_HASH)
                 hashSymSectionIdx = region.section.link;
+            else if (region.section.type==SHT_GNU_HASH)
+                haveGnuHash = true;
             else if (region.section.type==SHT_DYNAMIC)
                 haveDynamic = true;
             sectionsNum++;
         }
+    // sort dynamic symbols before calculating any hash table
+    if (haveGnuHash)
+        prepareGnuHash();
+    if (mergeStrTables)
+        buildStrTables();
+    typename Types::Word gnuHashAddress = 0;
     
     /// determine symbol name
     cxuint sectionCount = addNullSection;
@@ -657,6 +1381,10 @@ void ElfBinaryGenTemplate<Types>::computeSize()
                         dynValTable[DT_HASH] = resolveSectionAddress(header, region,
                                  regionAddresses[i]);
                         break;
+                    case SHT_GNU_HASH:
+                        gnuHashAddress = resolveSectionAddress(header, region,
+                                 regionAddresses[i]);
+                        break;
                     case SHT_RELA:
                         dynValTable[DT_RELA] = resolveSectionAddress(header, region,
                                  regionAddresses[i]);
@@ -689,12 +1417,16 @@ void ElfBinaryGenTemplate<Types>::computeSize()
                         (isHashDynSym) ? dynSymbols : symbols;
                     bool addNullHashSym = (isHashDynSym) ? addNullDynSym : addNullSym;
                     // calculating hashes of symbols and optimizing hash buckets
-                    hashCodes = calculateHashValuesForSymbols(addNullDynSym, hashSymbols);
+                    hashCodes = calculateHashValuesForSymbols(addNullHashSym, hashSymbols);
                     bucketsNum = optimizeHashBucketsNum(hashSymbols.size()+addNullHashSym,
                            addNullHashSym, hashCodes.get());
                     // and add these hash size to size
                     size += 4*(bucketsNum + hashSymbols.size()+addNullHashSym + 2);
                 }
+                else if (region.section.type == SHT_GNU_HASH)
+                    size += 16 + uint64_t(gnuBloomSize)*sizeof(typename Types::Word) +
+                            4*(uint64_t(gnuBucketsNum) + dynSymbols.size() +
+                                addNullDynSym - gnuSymOffset);
                 else if (region.section.type == SHT_DYNAMIC)
                     size += (dynamics.size()+1) * sizeof(typename Types::Dyn);
                 else if (region.section.type == SHT_NOTE)
@@ -713,7 +1445,16 @@ void ElfBinaryGenTemplate<Types>::computeSize()
                 }
                 else if (region.section.type == SHT_STRTAB)
                 {
-                    if (::strcmp(region.section.name, ".strtab") == 0)
+                    if (mergeStrTables)
+                    {
+                        if (::strcmp(region.section.name, ".strtab") == 0)
+                            size += strTabBuilder.getSize();
+                        else if (::strcmp(region.section.name, ".dynstr") == 0)
+                            size += dynStrBuilder.getSize();
+                        else if (::strcmp(region.section.name, ".shstrtab") == 0)
+                            size += shStrTabBuilder.getSize();
+                    }
+                    else if (::strcmp(region.section.name, ".strtab") == 0)
                     {
                         size += (addNullSym);
                         for (const auto& sym: symbols)
@@ -772,6 +1513,31 @@ void ElfBinaryGenTemplate<Types>::computeSize()
         for (size_t i = 0; i < dynamics.size(); i++)
             if (dynamics[i] >= 0 && dynamics[i] < dynTableSize)
                 dynamicValues[i] = dynValTable[dynamics[i]];
+            else if (dynamics[i] == DT_GNU_HASH)
+                dynamicValues[i] = gnuHashAddress;
+    }
+    
+    nullSymNameOffset = 0;
+    // if addNullSym is not set, then no empty symbol name added, then we
+    // find first null character
+    if (!addNullSym && !symbols.empty())
+        nullSymNameOffset = ::strlen(symbols[0].name);
+    nullDynSymNameOffset = 0;
+    // if addNullDynSym is not set, then no empty dynamic symbol name added, then we
+    // find first null character
+    if (!addNullDynSym && !dynSymbols.empty())
+        nullDynSymNameOffset = ::strlen(dynSymbols[0].name);
+    // if addNullSection is not set, then no empty section name added, then we
+    // find first null character
+    nullSectionNameOffset = 0;
+    if (!addNullSection)
+    {
+        for (const ElfRegionTemplate<Types>& reg: regions)
+            if (reg.type == ElfRegionType::SECTION)
+            {
+                nullSectionNameOffset = ::strlen(reg.section.name);
+                break;
+            }
     }
     
     sizeComputed = true;
@@ -784,465 +1550,542 @@ uint64_t ElfBinaryGenTemplate<Types>::countSize()
     return size;
 }
 
-// create hash table, really bucket chains and fill buckets
-static void createHashTable(uint32_t bucketsNum, uint32_t hashNum, bool skipFirst,
-                           const uint32_t* hashCodes, uint32_t* output)
+// write .gnu.hash content (dynamic symbols are already sorted by buckets)
+template<typename Types>
+void ElfBinaryGenTemplate<Types>::generateGnuHash(FastOutputBuffer& fob) const
 {
-    SLEV(output[0], bucketsNum);
-    SLEV(output[1], hashNum);
-    uint32_t* buckets = output + 2;
-    uint32_t* chains = output + bucketsNum + 2;
-    std::fill(buckets, buckets + bucketsNum, 0U);
-    std::fill(chains, chains + hashNum, STN_UNDEF);
+    typedef typename Types::Word Word;
+    const size_t hashedNum = dynSymbols.size() + addNullDynSym - gnuSymOffset;
+    const uint32_t wordBits = sizeof(Word)<<3;
+    uint32_t header[4];
+    SLEV(header[0], gnuBucketsNum);
+    SLEV(header[1], gnuSymOffset);
+    SLEV(header[2], gnuBloomSize);
+    SLEV(header[3], gnuHashBloomShift);
+    fob.writeArray(4, header);
     
-    std::unique_ptr<uint32_t[]> lastNodes(new uint32_t[bucketsNum]);
-    std::fill(lastNodes.get(), lastNodes.get() + bucketsNum, UINT32_MAX);
-    for (uint32_t i = skipFirst; i < hashNum; i++)
+    Array<Word> bloom(gnuBloomSize);
+    std::fill(bloom.begin(), bloom.end(), Word(0));
+    Array<uint32_t> buckets(gnuBucketsNum);
+    std::fill(buckets.begin(), buckets.end(), 0U);
+    Array<uint32_t> chains(hashedNum);
+    for (size_t i = 0; i < hashedNum; i++)
     {
-        const uint32_t bucket = hashCodes[i] % bucketsNum;
-        if (lastNodes[bucket] == UINT32_MAX)
-        {
-            // first entry of chain
-            SLEV(buckets[bucket], i);
-            lastNodes[bucket] = i;
-        }
-        else
-        {
-            SLEV(chains[lastNodes[bucket]], i);
-            lastNodes[bucket] = i;
-        }
+        const uint32_t hash = gnuHashCodes[i];
+        bloom[(hash / wordBits) & (gnuBloomSize-1)] |= (Word(1) << (hash % wordBits)) |
+                    (Word(1) << ((hash >> gnuHashBloomShift) % wordBits));
+        const uint32_t bucket = hash % gnuBucketsNum;
+        if (i == 0 || gnuHashCodes[i-1] % gnuBucketsNum != bucket)
+            buckets[bucket] = i + gnuSymOffset; // first symbol in chain
+        // last symbol in chain has set lowest bit
+        const bool last = i+1 == hashedNum || gnuHashCodes[i+1] % gnuBucketsNum != bucket;
+        chains[i] = last ? (hash | 1U) : (hash & ~1U);
     }
+    for (Word& v: bloom)
+        SLEV(v, v);
+    for (uint32_t& v: buckets)
+        SLEV(v, v);
+    for (uint32_t& v: chains)
+        SLEV(v, v);
+    fob.writeArray(bloom.size(), bloom.data());
+    fob.writeArray(buckets.size(), buckets.data());
+    fob.writeArray(chains.size(), chains.data());
 }
 
+// write ELF header
 template<typename Types>
-void ElfBinaryGenTemplate<Types>::generate(FastOutputBuffer& fob)
+void ElfBinaryGenTemplate<Types>::generateHeader(FastOutputBuffer& fob) const
 {
-    computeSize();
-    const uint64_t startOffset = fob.getWritten();
-    /* write elf header */
+    typename Types::Ehdr ehdr;
+    ::memset(ehdr.e_ident, 0, EI_NIDENT);
+    ehdr.e_ident[0] = 0x7f;
+    ehdr.e_ident[1] = 'E';
+    ehdr.e_ident[2] = 'L';
+    ehdr.e_ident[3] = 'F';
+    ehdr.e_ident[4] = Types::ELFCLASS;
+    ehdr.e_ident[5] = ELFDATA2LSB;
+    ehdr.e_ident[6] = EV_CURRENT;
+    ehdr.e_ident[EI_OSABI] = header.osABI;
+    ehdr.e_ident[EI_ABIVERSION] = header.abiVersion;
+    SLEV(ehdr.e_type, header.type);
+    SLEV(ehdr.e_machine, header.machine);
+    SLEV(ehdr.e_version, header.version);
+    SLEV(ehdr.e_flags, header.flags);
+    if (header.entryRegion != UINT_MAX)
     {
-        typename Types::Ehdr ehdr;
-        ::memset(ehdr.e_ident, 0, EI_NIDENT);
-        ehdr.e_ident[0] = 0x7f;
-        ehdr.e_ident[1] = 'E';
-        ehdr.e_ident[2] = 'L';
-        ehdr.e_ident[3] = 'F';
-        ehdr.e_ident[4] = Types::ELFCLASS;
-        ehdr.e_ident[5] = ELFDATA2LSB;
-        ehdr.e_ident[6] = EV_CURRENT;
-        ehdr.e_ident[EI_OSABI] = header.osABI;
-        ehdr.e_ident[EI_ABIVERSION] = header.abiVersion;
-        SLEV(ehdr.e_type, header.type);
-        SLEV(ehdr.e_machine, header.machine);
-        SLEV(ehdr.e_version, header.version);
-        SLEV(ehdr.e_flags, header.flags);
-        if (header.entryRegion != UINT_MAX)
-        {
-            // if have entry
-            typename Types::Word entry = regionOffsets[header.entryRegion] + header.entry;
-            if (regions[header.entryRegion].type == ElfRegionType::SECTION &&
-                regions[header.entryRegion].section.addrBase != 0)
-            {
-                auto addrBase = regions[header.entryRegion].section.addrBase;
-                entry += addrBase != Types::nobase ? addrBase : 0;
-            }
-            else
-                entry += header.vaddrBase;
-            
-            SLEV(ehdr.e_entry, entry);
-        }
-        else
-            SLEV(ehdr.e_entry, 0);
-        SLEV(ehdr.e_ehsize, sizeof(typename Types::Ehdr));
-        // if no program headers then fill by zeroes, otherwise fill fields
-        if (!progHeaders.empty())
+        // if have entry
+        typename Types::Word entry = regionOffsets[header.entryRegion] + header.entry;
+        if (regions[header.entryRegion].type == ElfRegionType::SECTION &&
+            regions[header.entryRegion].section.addrBase != 0)
         {
-            SLEV(ehdr.e_phentsize, sizeof(typename Types::Phdr));
-            SLEV(ehdr.e_phoff, regionOffsets[phdrTabRegion]);
+            auto addrBase = regions[header.entryRegion].section.addrBase;
+            entry += addrBase != Types::nobase ? addrBase : 0;
         }
         else
-        {
-            SLEV(ehdr.e_phentsize, 0);
-            SLEV(ehdr.e_phoff, 0);
-        }
-        SLEV(ehdr.e_phnum, progHeaders.size());
-        SLEV(ehdr.e_shentsize, sizeof(typename Types::Shdr));
-        SLEV(ehdr.e_shnum, sectionsNum);
-        SLEV(ehdr.e_shoff, regionOffsets[shdrTabRegion]);
-        SLEV(ehdr.e_shstrndx, shStrTab);
+            entry += header.vaddrBase;
         
-        fob.writeObject(ehdr);
+        SLEV(ehdr.e_entry, entry);
     }
-    
-    size_t nullSymNameOffset = 0;
-    // if addNullSym is not set, then no empty symbol name added, then we
-    // find first null character
-    if (!addNullSym && !symbols.empty())
-        nullSymNameOffset = ::strlen(symbols[0].name);
-    size_t nullDynSymNameOffset = 0;
-    // if addNullDynSym is not set, then no empty dynamic symbol name added, then we
-    // find first null character
-    if (!addNullDynSym && !dynSymbols.empty())
-        nullDynSymNameOffset = ::strlen(dynSymbols[0].name);
-    // if addNullSection is not set, then no empty section name added, then we
-    // find first null character
-    size_t nullSectionNameOffset = 0;
-    if (!addNullSection)
+    else
+        SLEV(ehdr.e_entry, 0);
+    SLEV(ehdr.e_ehsize, sizeof(typename Types::Ehdr));
+    // if no program headers then fill by zeroes, otherwise fill fields
+    if (!progHeaders.empty())
     {
-        for (const ElfRegionTemplate<Types>& reg: regions)
-            if (reg.type == ElfRegionType::SECTION)
-            {
-                nullSectionNameOffset = ::strlen(reg.section.name);
-                break;
-            }
+        SLEV(ehdr.e_phentsize, sizeof(typename Types::Phdr));
+        SLEV(ehdr.e_phoff, regionOffsets[phdrTabRegion]);
     }
+    else
+    {
+        SLEV(ehdr.e_phentsize, 0);
+        SLEV(ehdr.e_phoff, 0);
+    }
+    SLEV(ehdr.e_phnum, progHeaders.size());
+    SLEV(ehdr.e_shentsize, sizeof(typename Types::Shdr));
+    SLEV(ehdr.e_shnum, sectionsNum);
+    SLEV(ehdr.e_shoff, regionOffsets[shdrTabRegion]);
+    SLEV(ehdr.e_shstrndx, shStrTab);
     
-    /* write regions */
-    for (size_t i = 0; i < regions.size(); i++)
-    {   
-        const ElfRegionTemplate<Types>& region = regions[i];
-        // fix alignment
-        uint64_t toFill = 0;
-        typename Types::Word ralign = (region.type==ElfRegionType::SECTION) ?
-                        region.section.align : 0;
-        ralign = std::max(region.align, ralign);
-        if (ralign > 1)
-        {
-            const uint64_t curOffset = (fob.getWritten()-startOffset);
-            if (ralign!=0 && (curOffset&(ralign-1))!=0)
-                toFill = ralign - (curOffset&(ralign-1));
-            fob.fill(toFill, 0);
-        }
-        assert(regionOffsets[i] == fob.getWritten()-startOffset);
-        
-        // write content
-        if (region.type == ElfRegionType::PHDR_TABLE)
+    fob.writeObject(ehdr);
+}
+
+// write content of region (without alignment before region)
+template<typename Types>
+void ElfBinaryGenTemplate<Types>::generateRegion(FastOutputBuffer& fob, size_t i) const
+{
+    const ElfRegionTemplate<Types>& region = regions[i];
+    if (region.type == ElfRegionType::PHDR_TABLE)
+    {
+        /* write program headers */
+        for (const auto& progHeader: progHeaders)
         {
-            /* write program headers */
-            for (const auto& progHeader: progHeaders)
+            typename Types::Phdr phdr;
+            SLEV(phdr.p_type, progHeader.type);
+            SLEV(phdr.p_flags, progHeader.flags);
+            const ElfRegionTemplate<Types> startRegion(sizeof(typename Types::Ehdr),
+                    (const cxbyte*)nullptr, sizeof(typename Types::Word));
+            // get first region of program header and it offset, index and address
+            const ElfRegionTemplate<Types>& sregion = 
+                    (progHeader.regionStart==PHREGION_FILESTART) ? startRegion :
+                    regions[progHeader.regionStart];
+            const cxuint rstart = (progHeader.regionStart!=PHREGION_FILESTART) ?
+                        progHeader.regionStart : 0;
+            const typename Types::Word sroffset =
+                    (progHeader.regionStart!=PHREGION_FILESTART) ?
+                        regionOffsets[progHeader.regionStart] : 0;
+            const typename Types::Word sraddress =
+                    (progHeader.regionStart!=PHREGION_FILESTART) ?
+                        regionAddresses[progHeader.regionStart] : 0;
+            
+            // zero offset, allow to set zero offset of section
+            bool zeroOffset = sregion.type == ElfRegionType::SECTION &&
+                    sregion.section.zeroOffset;
+            SLEV(phdr.p_offset, !zeroOffset ? sroffset : 0);
+            if (progHeader.align==0 && progHeader.regionsNum==0)
+                SLEV(phdr.p_align, 0);
+            else if (progHeader.align==0)
             {
-                typename Types::Phdr phdr;
-                SLEV(phdr.p_type, progHeader.type);
-                SLEV(phdr.p_flags, progHeader.flags);
-                const ElfRegionTemplate<Types> startRegion(sizeof(typename Types::Ehdr),
-                        (const cxbyte*)nullptr, sizeof(typename Types::Word));
-                // get first region of program header and it offset, index and address
-                const ElfRegionTemplate<Types>& sregion = 
-                        (progHeader.regionStart==PHREGION_FILESTART) ? startRegion :
-                        regions[progHeader.regionStart];
-                const cxuint rstart = (progHeader.regionStart!=PHREGION_FILESTART) ?
-                            progHeader.regionStart : 0;
-                const typename Types::Word sroffset =
-                        (progHeader.regionStart!=PHREGION_FILESTART) ?
-                            regionOffsets[progHeader.regionStart] : 0;
-                const typename Types::Word sraddress =
-                        (progHeader.regionStart!=PHREGION_FILESTART) ?
-                            regionAddresses[progHeader.regionStart] : 0;
-                
-                // zero offset, allow to set zero offset of section
-                bool zeroOffset = sregion.type == ElfRegionType::SECTION &&
-                        sregion.section.zeroOffset;
-                SLEV(phdr.p_offset, !zeroOffset ? sroffset : 0);
-                if (progHeader.align==0 && progHeader.regionsNum==0)
-                    SLEV(phdr.p_align, 0);
-                else if (progHeader.align==0)
-                {
-                    typename Types::Word align = (sregion.type==ElfRegionType::SECTION) ?
-                            sregion.section.align : 0;
-                    align = std::max(sregion.align, align);
-                    SLEV(phdr.p_align, align);
-                }
-                else
-                    SLEV(phdr.p_align, progHeader.align);
-                
-                /* paddrBase and vaddrBase is base to program header virtual and physical
-                 * addresses for program header. if not defined then get address base
-                 * from ELF header */
-                if (progHeader.paddrBase == Types::nobase)
-                    SLEV(phdr.p_paddr, sraddress);
-                else if (progHeader.paddrBase != 0)
-                    SLEV(phdr.p_paddr, progHeader.paddrBase + sraddress);
-                else if (header.paddrBase != 0)
-                    SLEV(phdr.p_paddr, header.paddrBase + sraddress);
-                else
-                    SLEV(phdr.p_paddr, 0);
-                
-                // these same rule for vaddrBase
-                if (progHeader.vaddrBase == Types::nobase)
-                    SLEV(phdr.p_vaddr, sraddress);
-                else if (progHeader.vaddrBase != 0)
-                    SLEV(phdr.p_vaddr, progHeader.vaddrBase + sraddress);
-                else if (header.vaddrBase != 0)
-                    SLEV(phdr.p_vaddr, header.vaddrBase + sraddress);
-                else
-                    SLEV(phdr.p_vaddr, 0);
+                typename Types::Word align = (sregion.type==ElfRegionType::SECTION) ?
+                        sregion.section.align : 0;
+                align = std::max(sregion.align, align);
+                SLEV(phdr.p_align, align);
+            }
+            else
+                SLEV(phdr.p_align, progHeader.align);
+            
+            /* paddrBase and vaddrBase is base to program header virtual and physical
+             * addresses for program header. if not defined then get address base
+             * from ELF header */
+            if (progHeader.paddrBase == Types::nobase)
+                SLEV(phdr.p_paddr, sraddress);
+            else if (progHeader.paddrBase != 0)
+                SLEV(phdr.p_paddr, progHeader.paddrBase + sraddress);
+            else if (header.paddrBase != 0)
+                SLEV(phdr.p_paddr, header.paddrBase + sraddress);
+            else
+                SLEV(phdr.p_paddr, 0);
+            
+            // these same rule for vaddrBase
+            if (progHeader.vaddrBase == Types::nobase)
+                SLEV(phdr.p_vaddr, sraddress);
+            else if (progHeader.vaddrBase != 0)
+                SLEV(phdr.p_vaddr, progHeader.vaddrBase + sraddress);
+            else if (header.vaddrBase != 0)
+                SLEV(phdr.p_vaddr, header.vaddrBase + sraddress);
+            else
+                SLEV(phdr.p_vaddr, 0);
+            
+            // last region size for file - if nobits section then we assume zero size
+            if (progHeader.regionsNum!=0)
+            {
+                const auto& lastReg = regions[rstart + progHeader.regionsNum-1];
+                uint64_t fileLastRegSize =(lastReg.type!=ElfRegionType::SECTION ||
+                    lastReg.section.type!=SHT_NOBITS) ? lastReg.size : 0;
+                /// fileSize - add offset of first region to simulate region alignment
+                const typename Types::Word fileSize = regionOffsets[rstart+
+                        progHeader.regionsNum-1] + fileLastRegSize - sroffset;
+                const typename Types::Word phSize = regionAddresses[rstart+
+                        progHeader.regionsNum-1]+regions[rstart+
+                        progHeader.regionsNum-1].size - sraddress;
                 
-                // last region size for file - if nobits section then we assume zero size
-                if (progHeader.regionsNum!=0)
+                if (progHeader.haveMemSize)
                 {
-                    const auto& lastReg = regions[rstart + progHeader.regionsNum-1];
-                    uint64_t fileLastRegSize =(lastReg.type!=ElfRegionType::SECTION ||
-                        lastReg.section.type!=SHT_NOBITS) ? lastReg.size : 0;
-                    /// fileSize - add offset of first region to simulate region alignment
-                    const typename Types::Word fileSize = regionOffsets[rstart+
-                            progHeader.regionsNum-1] + fileLastRegSize - sroffset;
-                    const typename Types::Word phSize = regionAddresses[rstart+
-                            progHeader.regionsNum-1]+regions[rstart+
-                            progHeader.regionsNum-1].size - sraddress;
-                    
-                    if (progHeader.haveMemSize)
-                    {
-                        if (progHeader.memSize != 0)
-                            SLEV(phdr.p_memsz, progHeader.memSize);
-                        else
-                            SLEV(phdr.p_memsz, phSize);
-                    }
+                    if (progHeader.memSize != 0)
+                        SLEV(phdr.p_memsz, progHeader.memSize);
                     else
-                        SLEV(phdr.p_memsz, 0);
-                    SLEV(phdr.p_filesz, fileSize);
+                        SLEV(phdr.p_memsz, phSize);
                 }
                 else
-                {
                     SLEV(phdr.p_memsz, 0);
-                    SLEV(phdr.p_filesz, 0);
-                }
-                fob.writeObject(phdr);
+                SLEV(phdr.p_filesz, fileSize);
             }
+            else
+            {
+                SLEV(phdr.p_memsz, 0);
+                SLEV(phdr.p_filesz, 0);
+            }
+            fob.writeObject(phdr);
         }
-        else if (region.type == ElfRegionType::SHDR_TABLE)
+    }
+    else if (region.type == ElfRegionType::SHDR_TABLE)
+    {
+        /* write section headers table */
+        if (addNullSection)
+            fob.fill(sizeof(typename Types::Shdr), 0);
+        uint32_t nameOffset = (addNullSection);
+        size_t sectionIdx = 0;
+        for (cxuint j = 0; j < regions.size(); j++)
         {
-            /* write section headers table */
-            if (addNullSection)
-                fob.fill(sizeof(typename Types::Shdr), 0);
-            uint32_t nameOffset = (addNullSection);
-            for (cxuint j = 0; j < regions.size(); j++)
+            const auto& region2 = regions[j];
+            if (region2.type == ElfRegionType::SECTION)
             {
-                const auto& region2 = regions[j];
-                if (region2.type == ElfRegionType::SECTION)
+                typename Types::Shdr shdr;
+                if (mergeStrTables)
+                    SLEV(shdr.sh_name, shStrTabBuilder.getOffset(sectionIdx++));
+                else if (region2.section.name!=nullptr && region2.section.name[0]!=0)
+                    SLEV(shdr.sh_name, nameOffset);
+                else // set empty name offset
+                    SLEV(shdr.sh_name, nullSectionNameOffset);
+                SLEV(shdr.sh_type, region2.section.type);
+                SLEV(shdr.sh_flags, region2.section.flags);
+                SLEV(shdr.sh_offset, (!region2.section.zeroOffset) ?
+                            regionOffsets[j] : 0);
+                SLEV(shdr.sh_addr, resolveSectionAddress(header, region2,
+                                 regionAddresses[j]));
+                
+                if (region2.align != 0 || j+1 >= regions.size() ||
+                    regionOffsets[j]+region2.size == regionOffsets[j+1])
+                    SLEV(shdr.sh_size, region2.size);
+                else // otherwise if not match this size
+                    SLEV(shdr.sh_size, regionOffsets[j+1]-regionOffsets[j]);
+                
+                if ((region2.section.type!=SHT_SYMTAB &&
+                     region2.section.type!=SHT_DYNSYM) ||
+                        region2.section.info != BINGEN_DEFAULT)
+                    // put set info
+                    SLEV(shdr.sh_info, region2.section.info);
+                else // if symbtabs
                 {
-                    typename Types::Shdr shdr;
-                    if (region2.section.name!=nullptr && region2.section.name[0]!=0)
-                        SLEV(shdr.sh_name, nameOffset);
-                    else // set empty name offset
-                        SLEV(shdr.sh_name, nullSectionNameOffset);
-                    SLEV(shdr.sh_type, region2.section.type);
-                    SLEV(shdr.sh_flags, region2.section.flags);
-                    SLEV(shdr.sh_offset, (!region2.section.zeroOffset) ?
-                                regionOffsets[j] : 0);
-                    SLEV(shdr.sh_addr, resolveSectionAddress(header, region2,
-                                     regionAddresses[j]));
-                    
-                    if (region2.align != 0 || j+1 >= regions.size() ||
-                        regionOffsets[j]+region2.size == regionOffsets[j+1])
-                        SLEV(shdr.sh_size, region2.size);
-                    else // otherwise if not match this size
-                        SLEV(shdr.sh_size, regionOffsets[j+1]-regionOffsets[j]);
-                    
-                    if ((region2.section.type!=SHT_SYMTAB &&
-                         region2.section.type!=SHT_DYNSYM) ||
-                            region2.section.info != BINGEN_DEFAULT)
-                        // put set info
-                        SLEV(shdr.sh_info, region2.section.info);
-                    else // if symbtabs
-                    {
-                        // otherwise if default for symtabs, put count of last local
-                        const auto& symbolsList = (region2.section.type == SHT_SYMTAB) ?
-                            symbols : dynSymbols;
-                        cxuint lastLocal = 0;
-                        for (size_t l = 0; l < symbolsList.size(); l++)
-                            if (ELF32_ST_BIND(symbolsList[l].info)==STB_LOCAL)
-                                lastLocal = l+1;
-                        if ((region2.section.type==SHT_SYMTAB && addNullSym) ||
-                            (region2.section.type==SHT_DYNSYM && addNullDynSym))
-                            lastLocal++;
-                        SLEV(shdr.sh_info, lastLocal);
-                    }
-                    
-                    SLEV(shdr.sh_addralign, (region2.section.align==0) ?
-                            region2.align : region2.section.align);
-                    if (region2.section.link == 0)
-                    {
-                        // set up link (for symtab is .strtab for .dynsym is dynstr)
-                        if (::strcmp(region2.section.name, ".symtab") == 0)
-                            SLEV(shdr.sh_link, strTab);
-                        else if (::strcmp(region2.section.name, ".dynsym") == 0)
-                            SLEV(shdr.sh_link, dynStr);
-                        else // otherwise is value is link (zero)
-                            SLEV(shdr.sh_link, region2.section.link);
-                    }
-                    else
+                    // otherwise if default for symtabs, put count of last local
+                    const auto& symbolsList = (region2.section.type == SHT_SYMTAB) ?
+                        symbols : dynSymbols;
+                    cxuint lastLocal = 0;
+                    for (size_t l = 0; l < symbolsList.size(); l++)
+                        if (ELF32_ST_BIND(symbolsList[l].info)==STB_LOCAL)
+                            lastLocal = l+1;
+                    if ((region2.section.type==SHT_SYMTAB && addNullSym) ||
+                        (region2.section.type==SHT_DYNSYM && addNullDynSym))
+                        lastLocal++;
+                    SLEV(shdr.sh_info, lastLocal);
+                }
+                
+                SLEV(shdr.sh_addralign, (region2.section.align==0) ?
+                        region2.align : region2.section.align);
+                if (region2.section.link == 0)
+                {
+                    // set up link (for symtab is .strtab for .dynsym is dynstr)
+                    if (::strcmp(region2.section.name, ".symtab") == 0)
+                        SLEV(shdr.sh_link, strTab);
+                    else if (::strcmp(region2.section.name, ".dynsym") == 0)
+                        SLEV(shdr.sh_link, dynStr);
+                    else // otherwise is value is link (zero)
                         SLEV(shdr.sh_link, region2.section.link);
-                    
-                    // set up entry size for sections
-                    if (region2.section.type == SHT_SYMTAB ||
-                        region2.section.type == SHT_DYNSYM)
-                        SLEV(shdr.sh_entsize, sizeof(typename Types::Sym));
-                    else if (region2.section.type == SHT_DYNAMIC)
-                        SLEV(shdr.sh_entsize, sizeof(typename Types::Dyn));
-                    else // if not default
-                        SLEV(shdr.sh_entsize, region2.section.entSize);
-                    if (region2.section.name!=nullptr && region2.section.name[0]!=0)
-                        nameOffset += ::strlen(region2.section.name)+1;
-                    fob.writeObject(shdr);
                 }
+                else
+                    SLEV(shdr.sh_link, region2.section.link);
+                
+                // set up entry size for sections
+                if (region2.section.type == SHT_SYMTAB ||
+                    region2.section.type == SHT_DYNSYM)
+                    SLEV(shdr.sh_entsize, sizeof(typename Types::Sym));
+                else if (region2.section.type == SHT_DYNAMIC)
+                    SLEV(shdr.sh_entsize, sizeof(typename Types::Dyn));
+                else // if not default
+                    SLEV(shdr.sh_entsize, region2.section.entSize);
+                if (region2.section.name!=nullptr && region2.section.name[0]!=0)
+                    nameOffset += ::strlen(region2.section.name)+1;
+                fob.writeObject(shdr);
             }
         }
-        else if (region.type == ElfRegionType::USER)
-        {
-            if (region.dataFromPointer)
-                fob.writeArray(region.size, region.data);
-            else
-                (*region.dataGen)(fob);
-        }
-        else if (region.type == ElfRegionType::SECTION)
+    }
+    else if (region.type == ElfRegionType::USER)
+    {
+        if (region.dataFromPointer)
+            fob.writeArray(region.size, region.data);
+        else
+            (*region.dataGen)(fob);
+    }
+    else if (region.type == ElfRegionType::SECTION)
+    {
+        if (region.data == nullptr)
         {
-            if (region.data == nullptr)
+            if (region.section.type == SHT_SYMTAB || region.section.type == SHT_DYNSYM)
             {
-                if (region.section.type == SHT_SYMTAB || region.section.type == SHT_DYNSYM)
+                uint32_t nameOffset = 0;
+                // put null symbol if addNullSym or addNumDynSym is true
+                if (region.section.type == SHT_SYMTAB && addNullSym)
                 {
-                    uint32_t nameOffset = 0;
-                    // put null symbol if addNullSym or addNumDynSym is true
-                    if (region.section.type == SHT_SYMTAB && addNullSym)
-                    {
-                        fob.fill(sizeof(typename Types::Sym), 0);
-                        nameOffset = 1;
-                    }
-                    if (region.section.type == SHT_DYNSYM && addNullDynSym)
-                    {
-                        fob.fill(sizeof(typename Types::Sym), 0);
-                        nameOffset = 1;
-                    }
-                    const auto& symbolsList = (region.section.type == SHT_SYMTAB) ?
-                            symbols : dynSymbols;
-                    for (const auto& inSym: symbolsList)
-                    {
-                        typename Types::Sym sym;
-                        if (inSym.name != nullptr && inSym.name[0] != 0)
-                            SLEV(sym.st_name, nameOffset);
-                        else  // set empty name offset (symbol or dynamic symbol)
-                            SLEV(sym.st_name, (region.section.type == SHT_SYMTAB) ?
-                                        nullSymNameOffset : nullDynSymNameOffset);
-                        
-                        SLEV(sym.st_shndx, inSym.sectionIndex);
-                        SLEV(sym.st_size, inSym.size);
-                        /// if value defined as address
-                        if (!inSym.valueIsAddr)
-                            SLEV(sym.st_value, inSym.value);
-                        // if not use conversion to address with section addrBase
-                        else if ((inSym.sectionIndex != 0 || !addNullSection) &&
-                                regions[sectionRegions[
-                                    inSym.sectionIndex]].section.addrBase != 0)
-                        {
-                            // store symbol value as address or value
-                            typename Types::Word addrBase = regions[sectionRegions[
-                                    inSym.sectionIndex]].section.addrBase;
-                            SLEV(sym.st_value, inSym.value + regionOffsets[
-                                    sectionRegions[inSym.sectionIndex]] +
-                                    (addrBase!=Types::nobase ? addrBase : 0));
-                        }
-                        else if (header.vaddrBase!=Types::nobase)
-                            // use elf headerf virtual address base
-                            SLEV(sym.st_value, inSym.value + regionOffsets[
-                                sectionRegions[inSym.sectionIndex]] +
-                                (header.vaddrBase!=Types::nobase ? header.vaddrBase : 0));
-                        sym.st_other = inSym.other;
-                        sym.st_info = inSym.info;
-                        if (inSym.name != nullptr && inSym.name[0] != 0)
-                            nameOffset += ::strlen(inSym.name)+1;
-                        fob.writeObject(sym);
-                    }
+                    fob.fill(sizeof(typename Types::Sym), 0);
+                    nameOffset = 1;
                 }
-                else if (region.section.type == SHT_DYNAMIC)
+                if (region.section.type == SHT_DYNSYM && addNullDynSym)
+                {
+                    fob.fill(sizeof(typename Types::Sym), 0);
+                    nameOffset = 1;
+                }
+                const auto& symbolsList = (region.section.type == SHT_SYMTAB) ?
+                        symbols : dynSymbols;
+                const ElfStrTabBuilder& symStrBuilder =
+                        (region.section.type == SHT_SYMTAB) ? strTabBuilder : dynStrBuilder;
+                for (size_t k = 0; k < symbolsList.size(); k++)
                 {
-                    // dynamic table
-                    typename Types::Dyn dyn;
-                    for (size_t k = 0; k < dynamics.size(); k++)
+                    const auto& inSym = symbolsList[k];
+                    typename Types::Sym sym;
+                    if (mergeStrTables)
+                        SLEV(sym.st_name, symStrBuilder.getOffset(k));
+                    else if (inSym.name != nullptr && inSym.name[0] != 0)
+                        SLEV(sym.st_name, nameOffset);
+                    else  // set empty name offset (symbol or dynamic symbol)
+                        SLEV(sym.st_name, (region.section.type == SHT_SYMTAB) ?
+                                    nullSymNameOffset : nullDynSymNameOffset);
+                    
+                    SLEV(sym.st_shndx, inSym.sectionIndex);
+                    SLEV(sym.st_size, inSym.size);
+                    /// if value defined as address
+                    if (!inSym.valueIsAddr)
+                        SLEV(sym.st_value, inSym.value);
+                    // if not use conversion to address with section addrBase
+                    else if ((inSym.sectionIndex != 0 || !addNullSection) &&
+                            regions[sectionRegions[
+                                inSym.sectionIndex]].section.addrBase != 0)
                     {
-                        SLEV(dyn.d_tag, dynamics[k]);
-                        SLEV(dyn.d_un.d_val, dynamicValues[k]);
-                        fob.writeObject(dyn);
+                        // store symbol value as address or value
+                        typename Types::Word addrBase = regions[sectionRegions[
+                                inSym.sectionIndex]].section.addrBase;
+                        SLEV(sym.st_value, inSym.value + regionOffsets[
+                                sectionRegions[inSym.sectionIndex]] +
+                                (addrBase!=Types::nobase ? addrBase : 0));
                     }
-                    SLEV(dyn.d_tag, DT_NULL);
-                    SLEV(dyn.d_un.d_val, 0U);
-                    fob.writeObject(dyn);
+                    else if (header.vaddrBase!=Types::nobase)
+                        // use elf headerf virtual address base
+                        SLEV(sym.st_value, inSym.value + regionOffsets[
+                            sectionRegions[inSym.sectionIndex]] +
+                            (header.vaddrBase!=Types::nobase ? header.vaddrBase : 0));
+                    sym.st_other = inSym.other;
+                    sym.st_info = inSym.info;
+                    if (inSym.name != nullptr && inSym.name[0] != 0)
+                        nameOffset += ::strlen(inSym.name)+1;
+                    fob.writeObject(sym);
                 }
-                else if (region.section.type == SHT_HASH)
+            }
+            else if (region.section.type == SHT_DYNAMIC)
+            {
+                // dynamic table
+                typename Types::Dyn dyn;
+                for (size_t k = 0; k < dynamics.size(); k++)
                 {
-                    // creating hash table and put it
-                    const std::vector<ElfSymbolTemplate<Types> >& hashSymbols = 
-                        (isHashDynSym) ? dynSymbols : symbols;
-                    bool addNullHashSym = (isHashDynSym) ? addNullDynSym : addNullSym;
-                    Array<uint32_t> hashTable(2 + hashSymbols.size() + addNullHashSym +
-                                bucketsNum);
-                    createHashTable(bucketsNum, hashSymbols.size()+addNullHashSym,
-                                addNullHashSym, hashCodes.get(), hashTable.data());
-                    fob.writeArray(hashTable.size(), hashTable.data());
+                    SLEV(dyn.d_tag, dynamics[k]);
+                    SLEV(dyn.d_un.d_val, dynamicValues[k]);
+                    fob.writeObject(dyn);
                 }
-                else if (region.section.type == SHT_NOTE)
+                SLEV(dyn.d_tag, DT_NULL);
+                SLEV(dyn.d_un.d_val, 0U);
+                fob.writeObject(dyn);
+            }
+            else if (region.section.type == SHT_HASH)
+            {
+                // creating hash table and put it
+                const std::vector<ElfSymbolTemplate<Types> >& hashSymbols = 
+                    (isHashDynSym) ? dynSymbols : symbols;
+                bool addNullHashSym = (isHashDynSym) ? addNullDynSym : addNullSym;
+                Array<uint32_t> hashTable(2 + hashSymbols.size() + addNullHashSym +
+                            bucketsNum);
+                createHashTable(bucketsNum, hashSymbols.size()+addNullHashSym,
+                            addNullHashSym, hashCodes.get(), hashTable.data());
+                fob.writeArray(hashTable.size(), hashTable.data());
+            }
+            else if (region.section.type == SHT_GNU_HASH)
+                generateGnuHash(fob);
+            else if (region.section.type == SHT_NOTE)
+            {
+                // putting ELF notes
+                for (const ElfNote& note: notes)
                 {
-                    // putting ELF notes
-                    for (const ElfNote& note: notes)
-                    {
-                        typename Types::Nhdr nhdr;
-                        size_t nameSize = ::strlen(note.name)+1;
-                        size_t descSize = note.descSize;
-                        SLEV(nhdr.n_namesz, nameSize);
-                        SLEV(nhdr.n_descsz, descSize);
-                        SLEV(nhdr.n_type, note.type);
-                        fob.writeObject(nhdr);
-                        fob.write(nameSize, note.name);
-                        if ((nameSize&3) != 0)
-                            fob.fill(4 - (nameSize&3), 0);
-                        fob.writeArray(descSize, note.desc);
-                        if ((descSize&3) != 0)
-                            fob.fill(4 - (descSize&3), 0);
-                    }
+                    typename Types::Nhdr nhdr;
+                    size_t nameSize = ::strlen(note.name)+1;
+                    size_t descSize = note.descSize;
+                    SLEV(nhdr.n_namesz, nameSize);
+                    SLEV(nhdr.n_descsz, descSize);
+                    SLEV(nhdr.n_type, note.type);
+                    fob.writeObject(nhdr);
+                    fob.write(nameSize, note.name);
+                    if ((nameSize&3) != 0)
+                        fob.fill(4 - (nameSize&3), 0);
+                    fob.writeArray(descSize, note.desc);
+                    if ((descSize&3) != 0)
+                        fob.fill(4 - (descSize&3), 0);
                 }
-                else if (region.section.type == SHT_STRTAB)
+            }
+            else if (region.section.type == SHT_STRTAB)
+            {
+                // put symbol names and section names
+                if (mergeStrTables)
                 {
-                    // put symbol names and section names
+                    const ElfStrTabBuilder* builder = nullptr;
                     if (::strcmp(region.section.name, ".strtab") == 0)
-                    {
-                        if (addNullSym)
-                            fob.put(0);
-                        for (const auto& sym: symbols)
-                            if (sym.name != nullptr && sym.name[0] != 0)
-                                fob.write(::strlen(sym.name)+1, sym.name);
-                    }
+                        builder = &strTabBuilder;
                     else if (::strcmp(region.section.name, ".dynstr") == 0)
-                    {
-                        if (addNullDynSym)
-                            fob.put(0);
-                        for (const auto& sym: dynSymbols)
-                            if (sym.name != nullptr && sym.name[0] != 0)
-                                fob.write(::strlen(sym.name)+1, sym.name);
-                    }
+                        builder = &dynStrBuilder;
                     else if (::strcmp(region.section.name, ".shstrtab") == 0)
-                    {
-                        if (addNullSection)
-                            fob.put(0);
-                        for (const auto& region2: regions)
-                            if (region2.type == ElfRegionType::SECTION &&
-                                region2.section.name != nullptr &&
-                                region2.section.name[0] != 0)
-                                fob.write(::strlen(region2.section.name)+1,
-                                          region2.section.name);
-                    }
+                        builder = &shStrTabBuilder;
+                    if (builder != nullptr)
+                        fob.write(builder->getSize(), builder->getTable());
+                }
+                else if (::strcmp(region.section.name, ".strtab") == 0)
+                {
+                    if (addNullSym)
+                        fob.put(0);
+                    for (const auto& sym: symbols)
+                        if (sym.name != nullptr && sym.name[0] != 0)
+                            fob.write(::strlen(sym.name)+1, sym.name);
+                }
+                else if (::strcmp(region.section.name, ".dynstr") == 0)
+                {
+                    if (addNullDynSym)
+                        fob.put(0);
+                    for (const auto& sym: dynSymbols)
+                        if (sym.name != nullptr && sym.name[0] != 0)
+                            fob.write(::strlen(sym.name)+1, sym.name);
+                }
+                else if (::strcmp(region.section.name, ".shstrtab") == 0)
+                {
+                    if (addNullSection)
+                        fob.put(0);
+                    for (const auto& region2: regions)
+                        if (region2.type == ElfRegionType::SECTION &&
+                            region2.section.name != nullptr &&
+                            region2.section.name[0] != 0)
+                            fob.write(::strlen(region2.section.name)+1,
+                                      region2.section.name);
                 }
             }
-            else if (region.section.type != SHT_NOBITS)
-            {
-                if (region.dataFromPointer)
-                    fob.writeArray(region.size, region.data);
-                else
-                    (*region.dataGen)(fob);
-            }
+        }
+        else if (region.section.type != SHT_NOBITS)
+        {
+            if (region.dataFromPointer)
+                fob.writeArray(region.size, region.data);
+            else
+                (*region.dataGen)(fob);
         }
     }
+}
+
+template<typename Types>
+void ElfBinaryGenTemplate<Types>::generate(FastOutputBuffer& fob)
+{
+    computeSize();
+    const uint64_t startOffset = fob.getWritten();
+    generateHeader(fob);
+    
+    /* write regions */
+    for (size_t i = 0; i < regions.size(); i++)
+    {   
+        const ElfRegionTemplate<Types>& region = regions[i];
+        // fix alignment
+        uint64_t toFill = 0;
+        typename Types::Word ralign = (region.type==ElfRegionType::SECTION) ?
+                        region.section.align : 0;
+        ralign = std::max(region.align, ralign);
+        if (ralign > 1)
+        {
+            const uint64_t curOffset = (fob.getWritten()-startOffset);
+            if (ralign!=0 && (curOffset&(ralign-1))!=0)
+                toFill = ralign - (curOffset&(ralign-1));
+            fob.fill(toFill, 0);
+        }
+        assert(regionOffsets[i] == fob.getWritten()-startOffset);
+        
+        generateRegion(fob, i);
+    }
     fob.flush();
-    fob.getOStream().flush();
+    if (!fob.isMemoryOutput())
+        fob.getOStream().flush();
     assert(size == fob.getWritten()-startOffset);
 }
 
+template<typename Types>
+void ElfBinaryGenTemplate<Types>::generate(cxbyte* output, cxuint threadsNum)
+{
+    computeSize();
+    const size_t regionsNum = regions.size();
+    {
+        FastOutputBuffer fob(sizeof(typename Types::Ehdr), (char*)output);
+        generateHeader(fob);
+    }
+    // zeroing space between header and first region
+    const size_t firstOffset = (regionsNum != 0) ? regionOffsets[0] : size;
+    ::memset(output + sizeof(typename Types::Ehdr), 0,
+             firstOffset - sizeof(typename Types::Ehdr));
+    
+    // each region is written to own slot (with alignment padding after it),
+    // exception from task will be rethrown after finishing all tasks
+    std::vector<std::exception_ptr> exceptions(regionsNum);
+    std::atomic<size_t> nextRegion(0);
+    auto worker = [&]()
+    {
+        for (size_t i; (i = nextRegion.fetch_add(1)) < regionsNum; )
+            try
+            {
+                const size_t slotSize = ((i+1 < regionsNum) ?
+                        regionOffsets[i+1] : size) - regionOffsets[i];
+                FastOutputBuffer fob(slotSize, (char*)output + regionOffsets[i]);
+                generateRegion(fob, i);
+                // padding is always filled by zeroes
+                fob.fill(slotSize - fob.getWritten(), 0);
+            }
+            catch(...)
+            { exceptions[i] = std::current_exception(); }
+    };
+    
+    if (threadsNum == 0)
+        threadsNum = std::max(std::thread::hardware_concurrency(), 1U);
+    const size_t workersNum = std::min(size_t(threadsNum), regionsNum);
+    if (workersNum <= 1)
+        worker(); // in this thread
+    else
+    {
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < workersNum; i++)
+            threads.push_back(std::thread(worker));
+        worker();
+        for (std::thread& thread: threads)
+            thread.join();
+    }
+    
+    for (size_t i = 0; i < regionsNum; i++)
+        if (exceptions[i])
+            std::rethrow_exception(exceptions[i]);
+}
+
 template class CLRX::ElfBinaryGenTemplate<CLRX::Elf32Types>;
 template class CLRX::ElfBinaryGenTemplate<CLRX::Elf64Types>;
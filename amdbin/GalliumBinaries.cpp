@@ -44,17 +44,9 @@ GalliumElfBinaryBase::GalliumElfBinaryBase() :
 template<typename ElfBinary>
 void GalliumElfBinaryBase::loadFromElf(ElfBinary& elfBinary, size_t kernelsNum)
 {
-    uint16_t amdGpuConfigIndex = SHN_UNDEF;
-    try
-    { amdGpuConfigIndex = elfBinary.getSectionIndex(".AMDGPU.config"); }
-    catch(const Exception& ex)
-    { }
+    uint16_t amdGpuConfigIndex = elfBinary.findSectionIndex(".AMDGPU.config");
     
-    uint16_t amdGpuDisasmIndex = SHN_UNDEF;
-    try
-    { amdGpuDisasmIndex = elfBinary.getSectionIndex(".AMDGPU.disasm"); }
-    catch(const Exception& ex)
-    { }
+    uint16_t amdGpuDisasmIndex = elfBinary.findSectionIndex(".AMDGPU.disasm");
     if (amdGpuDisasmIndex != SHN_UNDEF)
     {
         // set disassembler section
@@ -63,15 +55,10 @@ void GalliumElfBinaryBase::loadFromElf(ElfBinary& elfBinary, size_t kernelsNum)
         disasmSize = ULEV(shdr.sh_size);
     }
     
-    uint16_t textIndex = SHN_UNDEF;
+    uint16_t textIndex = elfBinary.findSectionIndex(".text");
     size_t textSize = 0;
-    try
-    {
-        textIndex = elfBinary.getSectionIndex(".text");
+    if (textIndex != SHN_UNDEF)
         textSize = ULEV(elfBinary.getSectionHeader(textIndex).sh_size);
-    }
-    catch(const Exception& ex)
-    { }
     
     if (amdGpuConfigIndex == SHN_UNDEF || textIndex == SHN_UNDEF)
         return;
@@ -174,17 +161,16 @@ GalliumElfBinary32::GalliumElfBinary32(size_t binaryCodeSize, cxbyte* binaryCode
     loadFromElf(static_cast<const ElfBinary32&>(*this), kernelsNum);
     
     // get relocation section for text
-    try
+    const uint16_t textRelIndex = findSectionIndex(".rel.text");
+    if (textRelIndex != SHN_UNDEF)
     {
-        const Elf32_Shdr& relShdr = getSectionHeader(".rel.text");
+        const Elf32_Shdr& relShdr = getSectionHeader(textRelIndex);
         textRelEntrySize = ULEV(relShdr.sh_entsize);
         if (textRelEntrySize==0)
             textRelEntrySize = sizeof(Elf32_Rel);
         textRelsNum = ULEV(relShdr.sh_size)/textRelEntrySize;
         textRel = binaryCode + ULEV(relShdr.sh_offset);
     }
-    catch(const Exception& ex)
-    { }
     
     innerBinaryGetScratchRelocs(*this, scratchRelocs);
 }
@@ -203,17 +189,16 @@ GalliumElfBinary64::GalliumElfBinary64(size_t binaryCodeSize, cxbyte* binaryCode
 {
     loadFromElf(static_cast<const ElfBinary64&>(*this), kernelsNum);
     // get relocation section for text
-    try
+    const uint16_t textRelIndex = findSectionIndex(".rel.text");
+    if (textRelIndex != SHN_UNDEF)
     {
-        const Elf64_Shdr& relShdr = getSectionHeader(".rel.text");
+        const Elf64_Shdr& relShdr = getSectionHeader(textRelIndex);
         textRelEntrySize = ULEV(relShdr.sh_entsize);
         if (textRelEntrySize==0)
             textRelEntrySize = sizeof(Elf64_Rel);
         textRelsNum = ULEV(relShdr.sh_size)/textRelEntrySize;
         textRel = binaryCode + ULEV(relShdr.sh_offset);
     }
-    catch(const Exception& ex)
-    { }
     
     innerBinaryGetScratchRelocs(*this, scratchRelocs);
 }
@@ -250,11 +235,9 @@ static void verifyKernelSymbols(size_t kernelsNum, const GalliumKernel* kernels,
     for (uint32_t i = 0; i < kernelsNum; i++)
     {
         const GalliumKernel& kernel = kernels[i];
-        size_t symIndex = 0;
-        try 
-        { symIndex = elfBinary.getSymbolIndex(kernel.kernelName.c_str()); }
-        catch(const Exception& ex)
-        { throw BinException("Kernel symbol not found"); }
+        const size_t symIndex = elfBinary.findSymbolIndex(kernel.kernelName.c_str());
+        if (symIndex == 0)
+            throw BinException("Kernel symbol not found");
         const auto& sym = elfBinary.getSymbol(symIndex);
         const char* symName = elfBinary.getSymbolName(symIndex);
         // kernel symol must be defined as global and must be bound to text section
@@ -450,18 +433,19 @@ void GalliumInput::addEmptyKernel(const char* kernelName, cxuint llvmVersion)
  * GalliumBinGenerator 
  */
 
-GalliumBinGenerator::GalliumBinGenerator() : manageable(false), input(nullptr)
+GalliumBinGenerator::GalliumBinGenerator() : manageable(false), input(nullptr),
+        mergeStrTables(false)
 { }
 
 GalliumBinGenerator::GalliumBinGenerator(const GalliumInput* galliumInput)
-        : manageable(false), input(galliumInput)
+        : manageable(false), input(galliumInput), mergeStrTables(false)
 { }
 
 GalliumBinGenerator::GalliumBinGenerator(bool _64bitMode, GPUDeviceType deviceType,
         size_t codeSize, const cxbyte* code,
         size_t globalDataSize, const cxbyte* globalData,
         const std::vector<GalliumKernelInput>& kernels)
-        : manageable(true), input(nullptr)
+        : manageable(true), input(nullptr), mergeStrTables(false)
 {
     std::unique_ptr<GalliumInput> _input(new GalliumInput{});
     _input->is64BitElf = _64bitMode;
@@ -481,7 +465,7 @@ GalliumBinGenerator::GalliumBinGenerator(bool _64bitMode, GPUDeviceType deviceTy
         size_t codeSize, const cxbyte* code,
         size_t globalDataSize, const cxbyte* globalData,
         std::vector<GalliumKernelInput>&& kernels)
-        : manageable(true), input(nullptr)
+        : manageable(true), input(nullptr), mergeStrTables(false)
 {
     std::unique_ptr<GalliumInput> _input(new GalliumInput{});
     _input->is64BitElf = _64bitMode;
@@ -825,6 +809,7 @@ void GalliumBinGenerator::generateInternal(std::ostream* osPtr, std::vector<char
         else
             elfBinGen32.reset(new ElfBinaryGen32({ 0, 0, 0x40, 0,  ET_REL, 0xe0,
                         EV_CURRENT, UINT_MAX, 0, 0 }));
+        elfBinGen32->setMergeStrTables(mergeStrTables);
         putSectionsAndSymbols(*elfBinGen32, input, kernelsOrder, amdGpuConfigContent,
                         relTextContent32);
         elfSize = elfBinGen32->countSize();
@@ -838,6 +823,7 @@ void GalliumBinGenerator::generateInternal(std::ostream* osPtr, std::vector<char
         else // new Mesa3D 17.0.0
             elfBinGen64.reset(new ElfBinaryGen64({ 0, 0, 0x40, 0,  ET_REL, 0xe0,
                         EV_CURRENT, UINT_MAX, 0, 0 }));
+        elfBinGen64->setMergeStrTables(mergeStrTables);
         putSectionsAndSymbols(*elfBinGen64, input, kernelsOrder, amdGpuConfigContent,
                         relTextContent64);
         elfSize = elfBinGen64->countSize();
@@ -859,32 +845,36 @@ void GalliumBinGenerator::generateInternal(std::ostream* osPtr, std::vector<char
     /****
      * prepare for write binary to output
      ****/
-    std::unique_ptr<std::ostream> outStreamHolder;
+    std::unique_ptr<FastOutputBuffer> outBufHolder;
     std::ostream* os = nullptr;
     if (aPtr != nullptr)
     {
+        // binary size is known, so write directly to array
         aPtr->resize(binarySize);
-        outStreamHolder.reset(
-                new ArrayOStream(binarySize, reinterpret_cast<char*>(aPtr->data())));
-        os = outStreamHolder.get();
+        outBufHolder.reset(new FastOutputBuffer(binarySize,
+                    reinterpret_cast<char*>(aPtr->data())));
     }
     else if (vPtr != nullptr)
     {
         vPtr->resize(binarySize);
-        outStreamHolder.reset(new VectorOStream(*vPtr));
-        os = outStreamHolder.get();
+        outBufHolder.reset(new FastOutputBuffer(binarySize, vPtr->data()));
     }
     else // from argument
+    {
         os = osPtr;
+        outBufHolder.reset(new FastOutputBuffer(256, *os));
+    }
+    FastOutputBuffer& bos = *outBufHolder;
     
-    const std::ios::iostate oldExceptions = os->exceptions();
+    const std::ios::iostate oldExceptions = (os != nullptr) ?
+                os->exceptions() : std::ios::goodbit;
     try
     {
-    os->exceptions(std::ios::failbit | std::ios::badbit);
+    if (os != nullptr)
+        os->exceptions(std::ios::failbit | std::ios::badbit);
     /****
      * write binary to output
      ****/
-    FastOutputBuffer bos(256, *os);
     bos.writeObject<uint32_t>(LEV(kernelsNum));
     // write Gallium kernel info
     for (uint32_t korder: kernelsOrder)
@@ -924,10 +914,12 @@ void GalliumBinGenerator::generateInternal(std::ostream* osPtr, std::vector<char
     }
     catch(...)
     {
-        os->exceptions(oldExceptions);
+        if (os != nullptr)
+            os->exceptions(oldExceptions);
         throw;
     }
-    os->exceptions(oldExceptions);
+    if (os != nullptr)
+        os->exceptions(oldExceptions);
 }
 
 void GalliumBinGenerator::generate(Array<cxbyte>& array) const
@@ -22,6 +22,7 @@
 #include <cstdio>
 #include <cstring>
 #include <cstdint>
+#include <climits>
 #include <string>
 #include <vector>
 #include <algorithm>
@@ -65,6 +66,13 @@ void ROCmMetadata::initialize()
     version[1] = 0;
 }
 
+// find end of line (newline or end of stream), memchr is vectorized in most libc
+static inline const char* findLineEnd(const char* ptr, const char* end)
+{
+    const char* nl = reinterpret_cast<const char*>(::memchr(ptr, '\n', end-ptr));
+    return nl!=nullptr ? nl : end;
+}
+
 // return trailing spaces
 static size_t skipSpacesAndComments(const char*& ptr, const char* end, size_t& lineNo)
 {
@@ -78,7 +86,7 @@ static size_t skipSpacesAndComments(const char*& ptr, const char* end, size_t& l
         if (*ptr=='#')
         {
             // skip comment
-            while (ptr != end && *ptr!='\n') ptr++;
+            ptr = findLineEnd(ptr, end);
             if (ptr == end)
                 return 0; // no trailing spaces and end
         }
@@ -105,7 +113,7 @@ static void skipSpacesToNextLine(const char*& ptr, const char* end, size_t& line
         throw ParseException(lineNo, "Garbages at line");
     if (ptr != end && *ptr == '#')
         // skip comment at end of line
-        while (ptr!=end && *ptr!='\n') ptr++;
+        ptr = findLineEnd(ptr, end);
     if (ptr!=end)
     {   // newline
         ptr++;
@@ -161,9 +169,71 @@ static YAMLValType parseYAMLType(const char*& ptr, const char* end, size_t lineN
     throw ParseException(lineNo, "Unknown YAML value type");
 }
 
+/// perfect hash of metadata keywords (recognized keys)
+/** seed and table size are choosen while construction to get table without collisions,
+ * hence lookup is just one hash calculation and one string comparison */
+class CLRX_INTERNAL MetadataKeywordsHash
+{
+private:
+    size_t keywordsNum;
+    const char** keywords;
+    uint32_t seed;
+    uint32_t mask;
+    std::unique_ptr<cxbyte[]> slots; // keyword index+1, zero - empty slot
+    
+    uint32_t hashOf(const char* key, const char* keyEnd) const
+    {
+        uint32_t h = 2166136261U ^ seed;
+        for (; key != keyEnd; key++)
+            h = (h ^ cxbyte(*key)) * 16777619U;
+        return (h ^ (h>>16)) & mask;
+    }
+public:
+    MetadataKeywordsHash(size_t _keywordsNum, const char** _keywords)
+            : keywordsNum(_keywordsNum), keywords(_keywords), seed(0), mask(1)
+    {
+        while (mask+1 < 2*keywordsNum)
+            mask = (mask<<1) | 1;
+        while (true)
+        {
+            slots.reset(new cxbyte[mask+1]);
+            // try seeds for current table size
+            for (seed = 0; seed < 256; seed++)
+            {
+                std::fill(slots.get(), slots.get()+mask+1, cxbyte(0));
+                size_t i = 0;
+                for (; i < keywordsNum; i++)
+                {
+                    const char* kw = keywords[i];
+                    const uint32_t slot = hashOf(kw, kw + ::strlen(kw));
+                    if (slots[slot] != 0)
+                        break; // collision
+                    slots[slot] = i+1;
+                }
+                if (i == keywordsNum)
+                    return; // no collisions
+            }
+            mask = (mask<<1) | 1;
+        }
+    }
+    
+    /// find keyword, return keywordsNum if not found
+    size_t find(const char* key, const char* keyEnd) const
+    {
+        const cxbyte slot = slots[hashOf(key, keyEnd)];
+        if (slot == 0)
+            return keywordsNum;
+        const char* kw = keywords[slot-1];
+        const size_t len = keyEnd-key;
+        if (::strncmp(kw, key, len)==0 && kw[len]==0)
+            return slot-1;
+        return keywordsNum;
+    }
+};
+
 // parse YAML key (keywords - recognized keys)
 static size_t parseYAMLKey(const char*& ptr, const char* end, size_t lineNo,
-            size_t keywordsNum, const char** keywords)
+            const MetadataKeywordsHash& keywordsHash)
 {
     const char* keyPtr = ptr;
     while (ptr != end && (isAlnum(*ptr) || *ptr=='_')) ptr++;
@@ -179,10 +249,7 @@ static size_t parseYAMLKey(const char*& ptr, const char* end, size_t lineNo,
     if (afterColon == ptr && ptr != end && *ptr!='\n')
         // only if not immediate newline
         throw ParseException(lineNo, "After key and colon must be space");
-    CString keyword(keyPtr, keyEnd);
-    const size_t index = binaryFind(keywords, keywords+keywordsNum,
-                        keyword.c_str(), CStringLess()) - keywords;
-    return index;
+    return keywordsHash.find(keyPtr, keyEnd);
 }
 
 // parse YAML integer value
@@ -237,12 +304,12 @@ static bool parseYAMLBoolValue(const char*& ptr, const char* end, size_t& lineNo
     
     const char* wordPtr = ptr;
     while(ptr != end && isAlnum(*ptr)) ptr++;
-    CString word(wordPtr, ptr);
+    const size_t wordLen = ptr-wordPtr;
     
     bool value = false;
     bool isSet = false;
     for (const char* v: { "1", "true", "t", "on", "yes", "y"})
-        if (::strcasecmp(word.c_str(), v) == 0)
+        if (::strncasecmp(wordPtr, v, wordLen) == 0 && v[wordLen] == 0)
         {
             isSet = true;
             value = true;
@@ -250,7 +317,7 @@ static bool parseYAMLBoolValue(const char*& ptr, const char* end, size_t& lineNo
         }
     if (!isSet)
         for (const char* v: { "0", "false", "f", "off", "no", "n"})
-            if (::strcasecmp(word.c_str(), v) == 0)
+            if (::strncasecmp(wordPtr, v, wordLen) == 0 && v[wordLen] == 0)
             {
                 isSet = true;
                 value = false;
@@ -264,22 +331,10 @@ static bool parseYAMLBoolValue(const char*& ptr, const char* end, size_t& lineNo
     return value;
 }
 
-// trim spaces (remove spaces from start and end)
-static std::string trimStrSpaces(const std::string& str)
+// parse quoted YAML string, result is view to source or to buf (if string has escapes)
+static void parseYAMLString(const char*& linePtr, const char* end, size_t& lineNo,
+            std::string& buf, const char*& valStart, const char*& valEnd)
 {
-    size_t i = 0;
-    const size_t sz = str.size();
-    while (i!=sz && isSpace(str[i])) i++;
-    if (i == sz) return "";
-    size_t j = sz-1;
-    while (j>i && isSpace(str[j])) j--;
-    return str.substr(i, j-i+1);
-}
-
-static std::string parseYAMLString(const char*& linePtr, const char* end,
-            size_t& lineNo)
-{
-    std::string strarray;
     if (linePtr == end || (*linePtr != '"' && *linePtr != '\''))
     {
         while (linePtr != end && !isSpace(*linePtr) && *linePtr != ',') linePtr++;
@@ -288,6 +343,19 @@ static std::string parseYAMLString(const char*& linePtr, const char* end,
     const char termChar = *linePtr;
     linePtr++;
     
+    // fast path: string without escapes is just view to source
+    const char* strEnd = reinterpret_cast<const char*>(
+                ::memchr(linePtr, termChar, end-linePtr));
+    if (strEnd != nullptr && ::memchr(linePtr, '\\', strEnd-linePtr) == nullptr)
+    {
+        lineNo += std::count(linePtr, strEnd, '\n');
+        valStart = linePtr;
+        valEnd = strEnd;
+        linePtr = strEnd+1;
+        return;
+    }
+    
+    buf.clear();
     // main loop, where is character parsing
     while (linePtr != end && *linePtr != termChar)
     {
@@ -377,42 +445,47 @@ static std::string parseYAMLString(const char*& linePtr, const char* end,
                         value = c;
                 }
             }
-            strarray.push_back(value);
+            buf.push_back(value);
         }
         else // regular character
         {
             if (*linePtr=='\n')
                 lineNo++;
-            strarray.push_back(*linePtr++);
+            buf.push_back(*linePtr++);
         }
     }
     if (linePtr == end)
         throw ParseException(lineNo, "Unterminated string");
     linePtr++;
-    return strarray;
+    valStart = buf.c_str();
+    valEnd = buf.c_str() + buf.size();
 }
 
-static std::string parseYAMLStringValue(const char*& ptr, const char* end, size_t& lineNo,
-                    cxuint prevIndent, bool singleValue = false, bool blockAccept = true)
+// parse YAML string value, result is view to source or to buf
+// (only if string has escapes or it is block string)
+static void parseYAMLStringValueView(const char*& ptr, const char* end, size_t& lineNo,
+            cxuint prevIndent, std::string& buf, const char*& valStart,
+            const char*& valEnd, bool singleValue = false, bool blockAccept = true)
 {
     skipSpacesToLineEnd(ptr, end);
+    valStart = valEnd = ptr;
     if (ptr == end)
-        return "";
+        return;
     
     // skip !!str
     YAMLValType valType = parseYAMLType(ptr, end, lineNo);
     if (valType == YAMLValType::STRING)
     {   // if 
         skipSpacesToLineEnd(ptr, end);
+        valStart = valEnd = ptr;
         if (ptr == end)
-            return "";
+            return;
     }
     else if (valType != YAMLValType::NONE)
         throw ParseException(lineNo, "Expected value of string type");
     
-    std::string buf;
     if (*ptr=='"' || *ptr== '\'')
-        buf = parseYAMLString(ptr, end, lineNo);
+        parseYAMLString(ptr, end, lineNo, buf, valStart, valEnd);
     // otherwise parse stream
     else if (*ptr == '|' || *ptr == '>')
     {
@@ -425,7 +498,7 @@ static std::string parseYAMLStringValue(const char*& ptr, const char* end, size_
         if (ptr!=end && *ptr!='\n')
             throw ParseException(lineNo, "Garbages at string block");
         if (ptr == end)
-            return ""; // end
+            return; // end
         lineNo++;
         ptr++; // skip newline
         const char* lineStart = ptr;
@@ -434,11 +507,11 @@ static std::string parseYAMLStringValue(const char*& ptr, const char* end, size_
         if (indent <= prevIndent)
             throw ParseException(lineNo, "Unindented string block");
         
-        std::string buf;
+        buf.clear();
         while(ptr != end)
         {
             const char* strStart = ptr;
-            while (ptr != end && *ptr!='\n') ptr++;
+            ptr = findLineEnd(ptr, end);
             buf.append(strStart, ptr);
             
             if (ptr != end) // if new line
@@ -471,7 +544,9 @@ static std::string parseYAMLStringValue(const char*& ptr, const char* end, size_
                     buf.append("\n"); // always add newline at last line
                     if (ptr != end)
                         ptr = lineStart;
-                    return buf;
+                    valStart = buf.c_str();
+                    valEnd = buf.c_str() + buf.size();
+                    return;
                 }
                 else // if this same and not end of line
                     break;
@@ -484,7 +559,9 @@ static std::string parseYAMLStringValue(const char*& ptr, const char* end, size_
             // to indent
             ptr = lineStart + indent;
         }
-        return buf;
+        valStart = buf.c_str();
+        valEnd = buf.c_str() + buf.size();
+        return;
     }
     else
     {
@@ -501,12 +578,58 @@ static std::string parseYAMLStringValue(const char*& ptr, const char* end, size_
         if (strEnd != end && !isSpace(*strEnd))
             strEnd++;
         
-        buf.assign(strStart, strEnd);
+        valStart = strStart;
+        valEnd = strEnd;
     }
     
     if (singleValue)
         skipSpacesToNextLine(ptr, end, lineNo);
-    return buf;
+}
+
+static std::string parseYAMLStringValue(const char*& ptr, const char* end, size_t& lineNo,
+                    cxuint prevIndent, bool singleValue = false, bool blockAccept = true)
+{
+    std::string buf;
+    const char* valStart;
+    const char* valEnd;
+    parseYAMLStringValueView(ptr, end, lineNo, prevIndent, buf, valStart, valEnd,
+                singleValue, blockAccept);
+    if (valStart == buf.c_str())
+        return buf;
+    return std::string(valStart, valEnd);
+}
+
+// parse YAML string value and trim spaces, return view to source or to buf
+static void parseYAMLTrimmedStringView(const char*& ptr, const char* end,
+            size_t& lineNo, cxuint prevIndent, std::string& buf,
+            const char*& valStart, const char*& valEnd)
+{
+    parseYAMLStringValueView(ptr, end, lineNo, prevIndent, buf, valStart, valEnd, true);
+    while (valStart != valEnd && isSpace(*valStart)) valStart++;
+    while (valStart != valEnd && isSpace(valEnd[-1])) valEnd--;
+}
+
+// compare null-terminated name with string view
+static inline bool equalStrView(const char* name, const char* valStart,
+            const char* valEnd)
+{
+    const size_t len = valEnd-valStart;
+    return ::strncmp(name, valStart, len)==0 && name[len]==0;
+}
+
+// find value name in sorted name map
+template<typename T>
+static size_t findMetadataEnumValue(const std::pair<const char*, T>* map, size_t mapSize,
+            const char* valStart, const char* valEnd)
+{
+    const size_t len = valEnd-valStart;
+    // exact name is first name that begins with value
+    const std::pair<const char*, T>* it = std::lower_bound(map, map + mapSize,
+            valStart, [len](const std::pair<const char*, T>& entry, const char* val)
+            { return ::strncmp(entry.first, val, len) < 0; });
+    if (it != map + mapSize && equalStrView(it->first, valStart, valEnd))
+        return it - map;
+    return mapSize;
 }
 
 /// element consumer class
@@ -623,11 +746,50 @@ public:
     }
 };
 
+// parse printf info string (callId:argsNum:argSize0:...:format)
+static void parseROCmPrintfInfo(const char* ptr2, const char* end2,
+            std::unordered_set<cxuint>& printfIds, ROCmPrintfInfo& printfInfo)
+{
+    skipSpacesToLineEnd(ptr2, end2);
+    printfInfo.id = cstrtovCStyle<uint32_t>(ptr2, end2, ptr2);
+    
+    // check printf id uniqueness
+    if (!printfIds.insert(printfInfo.id).second)
+        throw ParseException("Duplicate of printf id");
+    
+    skipSpacesToLineEnd(ptr2, end2);
+    if (ptr2==end2 || *ptr2!=':')
+        throw ParseException("No colon after printf callId");
+    ptr2++;
+    skipSpacesToLineEnd(ptr2, end2);
+    uint32_t argsNum = cstrtovCStyle<uint32_t>(ptr2, end2, ptr2);
+    skipSpacesToLineEnd(ptr2, end2);
+    if (ptr2==end2 || *ptr2!=':')
+        throw ParseException("No colon after printf argsNum");
+    ptr2++;
+    
+    printfInfo.argSizes.resize(argsNum);
+    
+    // parse arg sizes
+    for (size_t i = 0; i < argsNum; i++)
+    {
+        skipSpacesToLineEnd(ptr2, end2);
+        printfInfo.argSizes[i] = cstrtovCStyle<uint32_t>(ptr2, end2, ptr2);
+        skipSpacesToLineEnd(ptr2, end2);
+        if (ptr2==end2 || *ptr2!=':')
+            throw ParseException("No colon after printf argsNum");
+        ptr2++;
+    }
+    // format
+    printfInfo.format.assign(ptr2, end2);
+}
+
 // printf info string consumer
 class CLRX_INTERNAL YAMLPrintfVectorConsumer: public YAMLElemConsumer
 {
 private:
     std::unordered_set<cxuint> printfIds;
+    std::string strBuf;
 public:
     std::vector<ROCmPrintfInfo>& printfInfos;
     
@@ -639,49 +801,17 @@ public:
                 cxuint prevIndent, bool singleValue, bool blockAccept)
     {
         const size_t oldLineNo = lineNo;
-        std::string str = parseYAMLStringValue(ptr, end, lineNo, prevIndent,
+        const char* ptr2;
+        const char* end2;
+        parseYAMLStringValueView(ptr, end, lineNo, prevIndent, strBuf, ptr2, end2,
                                 singleValue, blockAccept);
         // parse printf string
         ROCmPrintfInfo printfInfo{};
-        
-        const char* ptr2 = str.c_str();
-        const char* end2 = str.c_str() + str.size();
-        skipSpacesToLineEnd(ptr2, end2);
         try
-        { printfInfo.id = cstrtovCStyle<uint32_t>(ptr2, end2, ptr2); }
+        { parseROCmPrintfInfo(ptr2, end2, printfIds, printfInfo); }
         catch(const ParseException& ex)
         { throw ParseException(oldLineNo, ex.what()); }
         
-        // check printf id uniqueness
-        if (!printfIds.insert(printfInfo.id).second)
-            throw ParseException(oldLineNo, "Duplicate of printf id");
-        
-        skipSpacesToLineEnd(ptr2, end2);
-        if (ptr2==end || *ptr2!=':')
-            throw ParseException(oldLineNo, "No colon after printf callId");
-        ptr2++;
-        skipSpacesToLineEnd(ptr2, end2);
-        uint32_t argsNum = cstrtovCStyle<uint32_t>(ptr2, end2, ptr2);
-        skipSpacesToLineEnd(ptr2, end2);
-        if (ptr2==end || *ptr2!=':')
-            throw ParseException(oldLineNo, "No colon after printf argsNum");
-        ptr2++;
-        
-        printfInfo.argSizes.resize(argsNum);
-        
-        // parse arg sizes
-        for (size_t i = 0; i < argsNum; i++)
-        {
-            skipSpacesToLineEnd(ptr2, end2);
-            printfInfo.argSizes[i] = cstrtovCStyle<uint32_t>(ptr2, end2, ptr2);
-            skipSpacesToLineEnd(ptr2, end2);
-            if (ptr2==end || *ptr2!=':')
-                throw ParseException(lineNo, "No colon after printf argsNum");
-            ptr2++;
-        }
-        // format
-        printfInfo.format.assign(ptr2, end2);
-        
         printfInfos.push_back(printfInfo);
     }
 };
@@ -701,7 +831,7 @@ static void skipYAMLValue(const char*& ptr, const char* end, size_t& lineNo,
     if (ptr==end || (*ptr!='\'' && *ptr!='"' && *ptr!='|' && *ptr!='>' && *ptr !='[' &&
                 *ptr!='#' && *ptr!='\n'))
     {
-        while (ptr!=end && *ptr!='\n') ptr++;
+        ptr = findLineEnd(ptr, end);
         skipSpacesToNextLine(ptr, end, lineNo);
         return;
     }
@@ -762,11 +892,13 @@ static void skipYAMLValue(const char*& ptr, const char* end, size_t& lineNo,
             blockValue = true;
         }
         if (ptr!=end && *ptr=='#')
-            while (ptr!=end && *ptr!='\n') ptr++;
+            ptr = findLineEnd(ptr, end);
         else
             skipSpacesToLineEnd(ptr, end);
         if (ptr!=end && *ptr!='\n')
             throw ParseException(lineNo, "Garbages before block or children");
+        if (ptr == end)
+            return;
         ptr++;
         lineNo++;
         // skip all lines indented beyound previous level
@@ -775,11 +907,7 @@ static void skipYAMLValue(const char*& ptr, const char* end, size_t& lineNo,
             const char* lineStart = ptr;
             skipSpacesToLineEnd(ptr, end);
             if (ptr == end)
-            {
-                ptr++;
-                lineNo++;
-                continue;
-            }
+                break;
             if (size_t(ptr-lineStart) <= prevIndent && *ptr!='\n' &&
                 (blockValue || *ptr!='#'))
                 // if indent is short and not empty line (same spaces) or
@@ -789,7 +917,7 @@ static void skipYAMLValue(const char*& ptr, const char* end, size_t& lineNo,
                 break;
             }
             
-            while (ptr!=end && *ptr!='\n') ptr++;
+            ptr = findLineEnd(ptr, end);
             if (ptr!=end)
             {
                 lineNo++;
@@ -811,6 +939,9 @@ static const char* mainMetadataKeywords[] =
 static const size_t mainMetadataKeywordsNum =
         sizeof(mainMetadataKeywords) / sizeof(const char*);
 
+static const MetadataKeywordsHash mainMetadataKeywordsHash(
+            mainMetadataKeywordsNum, mainMetadataKeywords);
+
 enum {
     ROCMMT_KERNEL_ARGS = 0, ROCMMT_KERNEL_ATTRS, ROCMMT_KERNEL_CODEPROPS,
     ROCMMT_KERNEL_LANGUAGE, ROCMMT_KERNEL_LANGUAGE_VERSION,
@@ -825,6 +956,9 @@ static const char* kernelMetadataKeywords[] =
 static const size_t kernelMetadataKeywordsNum =
         sizeof(kernelMetadataKeywords) / sizeof(const char*);
 
+static const MetadataKeywordsHash kernelMetadataKeywordsHash(
+            kernelMetadataKeywordsNum, kernelMetadataKeywords);
+
 enum {
     ROCMMT_ATTRS_REQD_WORK_GROUP_SIZE = 0, ROCMMT_ATTRS_RUNTIME_HANDLE,
     ROCMMT_ATTRS_VECTYPEHINT, ROCMMT_ATTRS_WORK_GROUP_SIZE_HINT
@@ -838,6 +972,9 @@ static const char* kernelAttrMetadataKeywords[] =
 static const size_t kernelAttrMetadataKeywordsNum =
         sizeof(kernelAttrMetadataKeywords) / sizeof(const char*);
 
+static const MetadataKeywordsHash kernelAttrMetadataKeywordsHash(
+            kernelAttrMetadataKeywordsNum, kernelAttrMetadataKeywords);
+
 enum {
     ROCMMT_CODEPROPS_FIXED_WORK_GROUP_SIZE = 0, ROCMMT_CODEPROPS_GROUP_SEGMENT_FIXED_SIZE,
     ROCMMT_CODEPROPS_KERNARG_SEGMENT_ALIGN, ROCMMT_CODEPROPS_KERNARG_SEGMENT_SIZE,
@@ -858,6 +995,9 @@ static const char* kernelCodePropsKeywords[] =
 static const size_t kernelCodePropsKeywordsNum =
         sizeof(kernelCodePropsKeywords) / sizeof(const char*);
 
+static const MetadataKeywordsHash kernelCodePropsKeywordsHash(
+            kernelCodePropsKeywordsNum, kernelCodePropsKeywords);
+
 enum {
     ROCMMT_ARGS_ACCQUAL = 0, ROCMMT_ARGS_ACTUALACCQUAL, ROCMMT_ARGS_ADDRSPACEQUAL,
     ROCMMT_ARGS_ALIGN, ROCMMT_ARGS_ISCONST, ROCMMT_ARGS_ISPIPE, ROCMMT_ARGS_ISRESTRICT,
@@ -876,6 +1016,9 @@ static const char* kernelArgInfosKeywords[] =
 static const size_t kernelArgInfosKeywordsNum =
         sizeof(kernelArgInfosKeywords) / sizeof(const char*);
 
+static const MetadataKeywordsHash kernelArgInfosKeywordsHash(
+            kernelArgInfosKeywordsNum, kernelArgInfosKeywords);
+
 static const std::pair<const char*, ROCmValueKind> rocmValueKindNamesMap[] =
 {
     { "ByValue", ROCmValueKind::BY_VALUE },
@@ -945,6 +1088,11 @@ static void parseROCmMetadata(size_t metadataSize, const char* metadata,
     bool inKernelAttrs = false;
     bool canToNextLevel = false;
     
+    // buffer and view for string values that are not stored
+    std::string strBuf;
+    const char* valStart;
+    const char* valEnd;
+    
     size_t oldLineNo = 0;
     while (ptr != end)
     {
@@ -1014,7 +1162,7 @@ static void parseROCmMetadata(size_t metadataSize, const char* metadata,
                 break; // end of the document
             
             const size_t keyIndex = parseYAMLKey(ptr, end, lineNo,
-                        mainMetadataKeywordsNum, mainMetadataKeywords);
+                        mainMetadataKeywordsHash);
             
             switch(keyIndex)
             {
@@ -1060,7 +1208,7 @@ static void parseROCmMetadata(size_t metadataSize, const char* metadata,
         {
             // in kernel
             const size_t keyIndex = parseYAMLKey(ptr, end, lineNo,
-                        kernelMetadataKeywordsNum, kernelMetadataKeywords);
+                        kernelMetadataKeywordsHash);
             
             ROCmKernelMetadata& kernel = kernels.back();
             switch(keyIndex)
@@ -1126,7 +1274,7 @@ static void parseROCmMetadata(size_t metadataSize, const char* metadata,
         {
             // in kernel attributes
             const size_t keyIndex = parseYAMLKey(ptr, end, lineNo,
-                        kernelAttrMetadataKeywordsNum, kernelAttrMetadataKeywords);
+                        kernelAttrMetadataKeywordsHash);
             
             ROCmKernelMetadata& kernel = kernels.back();
             switch(keyIndex)
@@ -1161,7 +1309,7 @@ static void parseROCmMetadata(size_t metadataSize, const char* metadata,
         {
             // in kernel codeProps
             const size_t keyIndex = parseYAMLKey(ptr, end, lineNo,
-                        kernelCodePropsKeywordsNum, kernelCodePropsKeywords);
+                        kernelCodePropsKeywordsHash);
             
             ROCmKernelMetadata& kernel = kernels.back();
             switch(keyIndex)
@@ -1235,7 +1383,7 @@ static void parseROCmMetadata(size_t metadataSize, const char* metadata,
         {
             // in kernel argument
             const size_t keyIndex = parseYAMLKey(ptr, end, lineNo,
-                        kernelArgInfosKeywordsNum, kernelArgInfosKeywords);
+                        kernelArgInfosKeywordsHash);
             
             ROCmKernelArgInfo& kernelArg = kernels.back().argInfos.back();
             
@@ -1245,11 +1393,12 @@ static void parseROCmMetadata(size_t metadataSize, const char* metadata,
                 case ROCMMT_ARGS_ACCQUAL:
                 case ROCMMT_ARGS_ACTUALACCQUAL:
                 {
-                    const std::string acc = trimStrSpaces(parseYAMLStringValue(
-                                    ptr, end, lineNo, level, true));
+                    parseYAMLTrimmedStringView(ptr, end, lineNo, level,
+                                    strBuf, valStart, valEnd);
                     size_t accIndex = 0;
-                    for (; accIndex < 6; accIndex++)
-                        if (::strcmp(rocmAccessQualifierTbl[accIndex], acc.c_str())==0)
+                    for (; accIndex < 4; accIndex++)
+                        if (equalStrView(rocmAccessQualifierTbl[accIndex],
+                                    valStart, valEnd))
                             break;
                     if (accIndex == 4)
                         throw ParseException(lineNo, "Wrong access qualifier");
@@ -1261,12 +1410,12 @@ static void parseROCmMetadata(size_t metadataSize, const char* metadata,
                 }
                 case ROCMMT_ARGS_ADDRSPACEQUAL:
                 {
-                    const std::string aspace = trimStrSpaces(parseYAMLStringValue(
-                                    ptr, end, lineNo, level, true));
+                    parseYAMLTrimmedStringView(ptr, end, lineNo, level,
+                                    strBuf, valStart, valEnd);
                     size_t aspaceIndex = 0;
                     for (; aspaceIndex < 6; aspaceIndex++)
-                        if (::strcmp(rocmAddrSpaceTypesTbl[aspaceIndex],
-                                    aspace.c_str())==0)
+                        if (equalStrView(rocmAddrSpaceTypesTbl[aspaceIndex],
+                                    valStart, valEnd))
                             break;
                     if (aspaceIndex == 6)
                         throw ParseException(valLineNo, "Wrong address space");
@@ -1304,11 +1453,10 @@ static void parseROCmMetadata(size_t metadataSize, const char* metadata,
                     break;
                 case ROCMMT_ARGS_VALUEKIND:
                 {
-                    const std::string vkind = trimStrSpaces(parseYAMLStringValue(
-                                ptr, end, lineNo, level, true));
-                    const size_t vkindIndex = binaryMapFind(rocmValueKindNamesMap,
-                            rocmValueKindNamesMap + rocmValueKindNamesNum, vkind.c_str(),
-                            CStringLess()) - rocmValueKindNamesMap;
+                    parseYAMLTrimmedStringView(ptr, end, lineNo, level,
+                                    strBuf, valStart, valEnd);
+                    const size_t vkindIndex = findMetadataEnumValue(rocmValueKindNamesMap,
+                            rocmValueKindNamesNum, valStart, valEnd);
                     // if unknown kind
                     if (vkindIndex == rocmValueKindNamesNum)
                         throw ParseException(valLineNo, "Wrong argument value kind");
@@ -1317,11 +1465,10 @@ static void parseROCmMetadata(size_t metadataSize, const char* metadata,
                 }
                 case ROCMMT_ARGS_VALUETYPE:
                 {
-                    const std::string vtype = trimStrSpaces(parseYAMLStringValue(
-                                    ptr, end, lineNo, level, true));
-                    const size_t vtypeIndex = binaryMapFind(rocmValueTypeNamesMap,
-                            rocmValueTypeNamesMap + rocmValueTypeNamesNum, vtype.c_str(),
-                            CStringLess()) - rocmValueTypeNamesMap;
+                    parseYAMLTrimmedStringView(ptr, end, lineNo, level,
+                                    strBuf, valStart, valEnd);
+                    const size_t vtypeIndex = findMetadataEnumValue(rocmValueTypeNamesMap,
+                            rocmValueTypeNamesNum, valStart, valEnd);
                     // if unknown type
                     if (vtypeIndex == rocmValueTypeNamesNum)
                         throw ParseException(valLineNo, "Wrong argument value type");
@@ -1341,6 +1488,598 @@ void ROCmMetadata::parse(size_t metadataSize, const char* metadata)
     parseROCmMetadata(metadataSize, metadata, *this);
 }
 
+/*
+ * ROCm metadata MsgPack parser (code object v3)
+ */
+
+// read big-endian value from MsgPack data
+static uint64_t readMsgPackBE(const cxbyte*& dataPtr, const cxbyte* dataEnd, cxuint size)
+{
+    if (size_t(dataEnd-dataPtr) < size)
+        throw ParseException("MsgPack: Unexpected end of data");
+    uint64_t value = 0;
+    for (cxuint i = 0; i < size; i++)
+        value = (value<<8) | *dataPtr++;
+    return value;
+}
+
+// skip MsgPack object (with all children)
+static void skipMsgPackObject(const cxbyte*& dataPtr, const cxbyte* dataEnd)
+{
+    // number of objects to skip (children of arrays and maps are added)
+    uint64_t toSkip = 1;
+    while (toSkip != 0)
+    {
+        if (dataPtr >= dataEnd)
+            throw ParseException("MsgPack: Unexpected end of data");
+        const cxbyte code = *dataPtr++;
+        toSkip--;
+        size_t size = 0;
+        if (code < 0x80 || code >= 0xe0 || code == 0xc0 || code == 0xc2 || code == 0xc3)
+            continue; // fixint, nil, bool
+        else if (code < 0x90) // fixmap
+            toSkip += uint64_t(code&15)<<1;
+        else if (code < 0xa0) // fixarray
+            toSkip += code&15;
+        else if (code < 0xc0) // fixstr
+            size = code&31;
+        else
+            switch (code)
+            {
+                case 0xc4: // bin8
+                case 0xd9: // str8
+                    size = readMsgPackBE(dataPtr, dataEnd, 1);
+                    break;
+                case 0xc5: // bin16
+                case 0xda: // str16
+                    size = readMsgPackBE(dataPtr, dataEnd, 2);
+                    break;
+                case 0xc6: // bin32
+                case 0xdb: // str32
+                    size = readMsgPackBE(dataPtr, dataEnd, 4);
+                    break;
+                case 0xc7: // ext8
+                    size = readMsgPackBE(dataPtr, dataEnd, 1) + 1;
+                    break;
+                case 0xc8: // ext16
+                    size = readMsgPackBE(dataPtr, dataEnd, 2) + 1;
+                    break;
+                case 0xc9: // ext32
+                    size = readMsgPackBE(dataPtr, dataEnd, 4) + 1;
+                    break;
+                case 0xca: // float32
+                case 0xce: // uint32
+                case 0xd2: // int32
+                    size = 4;
+                    break;
+                case 0xcb: // float64
+                case 0xcf: // uint64
+                case 0xd3: // int64
+                    size = 8;
+                    break;
+                case 0xcc: // uint8
+                case 0xd0: // int8
+                    size = 1;
+                    break;
+                case 0xcd: // uint16
+                case 0xd1: // int16
+                    size = 2;
+                    break;
+                case 0xd4: // fixext1
+                case 0xd5: // fixext2
+                case 0xd6: // fixext4
+                case 0xd7: // fixext8
+                case 0xd8: // fixext16
+                    size = (1U<<(code-0xd4)) + 1;
+                    break;
+                case 0xdc: // array16
+                    toSkip += readMsgPackBE(dataPtr, dataEnd, 2);
+                    break;
+                case 0xdd: // array32
+                    toSkip += readMsgPackBE(dataPtr, dataEnd, 4);
+                    break;
+                case 0xde: // map16
+                    toSkip += readMsgPackBE(dataPtr, dataEnd, 2)<<1;
+                    break;
+                case 0xdf: // map32
+                    toSkip += readMsgPackBE(dataPtr, dataEnd, 4)<<1;
+                    break;
+                default:
+                    throw ParseException("MsgPack: Unknown object type");
+            }
+        if (size_t(dataEnd-dataPtr) < size)
+            throw ParseException("MsgPack: Unexpected end of data");
+        dataPtr += size;
+    }
+}
+
+// parse MsgPack unsigned integer
+static uint64_t parseMsgPackUInt(const cxbyte*& dataPtr, const cxbyte* dataEnd)
+{
+    if (dataPtr >= dataEnd)
+        throw ParseException("MsgPack: Unexpected end of data");
+    const cxbyte code = *dataPtr++;
+    if (code < 0x80)
+        return code; // positive fixint
+    if (code >= 0xcc && code <= 0xcf)
+        return readMsgPackBE(dataPtr, dataEnd, 1U<<(code-0xcc));
+    if (code >= 0xd0 && code <= 0xd3)
+    {
+        // signed integer
+        const cxuint size = 1U<<(code-0xd0);
+        const uint64_t value = readMsgPackBE(dataPtr, dataEnd, size);
+        if (((value >> (size*8-1)) & 1) != 0)
+            throw ParseException("MsgPack: Negative integer value");
+        return value;
+    }
+    throw ParseException("MsgPack: Expected unsigned integer value");
+}
+
+// parse MsgPack unsigned integer that must fit to cxuint
+static cxuint parseMsgPackUInt32(const cxbyte*& dataPtr, const cxbyte* dataEnd)
+{
+    const uint64_t value = parseMsgPackUInt(dataPtr, dataEnd);
+    if (value > UINT_MAX)
+        throw ParseException("MsgPack: Integer value out of range");
+    return value;
+}
+
+// parse MsgPack boolean
+static bool parseMsgPackBool(const cxbyte*& dataPtr, const cxbyte* dataEnd)
+{
+    if (dataPtr >= dataEnd)
+        throw ParseException("MsgPack: Unexpected end of data");
+    const cxbyte code = *dataPtr++;
+    if (code != 0xc2 && code != 0xc3)
+        throw ParseException("MsgPack: Expected boolean value");
+    return code == 0xc3;
+}
+
+// parse MsgPack string, return view to source
+static void parseMsgPackStringView(const cxbyte*& dataPtr, const cxbyte* dataEnd,
+            const char*& strStart, const char*& strEnd)
+{
+    if (dataPtr >= dataEnd)
+        throw ParseException("MsgPack: Unexpected end of data");
+    const cxbyte code = *dataPtr++;
+    size_t size = 0;
+    if (code >= 0xa0 && code < 0xc0)
+        size = code&31;
+    else if (code >= 0xd9 && code <= 0xdb)
+        size = readMsgPackBE(dataPtr, dataEnd, 1U<<(code-0xd9));
+    else
+        throw ParseException("MsgPack: Expected string");
+    if (size_t(dataEnd-dataPtr) < size)
+        throw ParseException("MsgPack: Unexpected end of data");
+    strStart = reinterpret_cast<const char*>(dataPtr);
+    strEnd = strStart + size;
+    dataPtr += size;
+}
+
+static CString parseMsgPackString(const cxbyte*& dataPtr, const cxbyte* dataEnd)
+{
+    const char* strStart;
+    const char* strEnd;
+    parseMsgPackStringView(dataPtr, dataEnd, strStart, strEnd);
+    return CString(strStart, strEnd);
+}
+
+// parse MsgPack array header, return number of elements
+static size_t parseMsgPackArraySize(const cxbyte*& dataPtr, const cxbyte* dataEnd)
+{
+    if (dataPtr >= dataEnd)
+        throw ParseException("MsgPack: Unexpected end of data");
+    const cxbyte code = *dataPtr++;
+    size_t elemsNum = 0;
+    if (code >= 0x90 && code < 0xa0)
+        elemsNum = code&15;
+    else if (code == 0xdc || code == 0xdd)
+        elemsNum = readMsgPackBE(dataPtr, dataEnd, code==0xdc ? 2 : 4);
+    else
+        throw ParseException("MsgPack: Expected array");
+    // any element takes at least one byte
+    if (elemsNum > size_t(dataEnd - dataPtr))
+        throw ParseException("MsgPack: Unexpected end of data");
+    return elemsNum;
+}
+
+// parse MsgPack map header, return number of entries
+static size_t parseMsgPackMapSize(const cxbyte*& dataPtr, const cxbyte* dataEnd)
+{
+    if (dataPtr >= dataEnd)
+        throw ParseException("MsgPack: Unexpected end of data");
+    const cxbyte code = *dataPtr++;
+    size_t entriesNum = 0;
+    if (code >= 0x80 && code < 0x90)
+        entriesNum = code&15;
+    else if (code == 0xde || code == 0xdf)
+        entriesNum = readMsgPackBE(dataPtr, dataEnd, code==0xde ? 2 : 4);
+    else
+        throw ParseException("MsgPack: Expected map");
+    // any entry (key and value) takes at least two bytes
+    if (entriesNum > size_t(dataEnd - dataPtr)>>1)
+        throw ParseException("MsgPack: Unexpected end of data");
+    return entriesNum;
+}
+
+// parse MsgPack array of unsigned integers (elemsNum - required number of elements)
+template<typename T>
+static void parseMsgPackUIntArray(const cxbyte*& dataPtr, const cxbyte* dataEnd,
+            size_t elemsNum, T* array)
+{
+    if (parseMsgPackArraySize(dataPtr, dataEnd) != elemsNum)
+        throw ParseException("MsgPack: Wrong number of array elements");
+    for (size_t i = 0; i < elemsNum; i++)
+        array[i] = parseMsgPackUInt32(dataPtr, dataEnd);
+}
+
+enum {
+    ROCMMP_MAIN_KERNELS = 0, ROCMMP_MAIN_PRINTF, ROCMMP_MAIN_VERSION
+};
+
+static const char* mainMsgPackKeywords[] =
+{
+    "amdhsa.kernels", "amdhsa.printf", "amdhsa.version"
+};
+
+static const size_t mainMsgPackKeywordsNum =
+        sizeof(mainMsgPackKeywords) / sizeof(const char*);
+
+static const MetadataKeywordsHash mainMsgPackKeywordsHash(
+            mainMsgPackKeywordsNum, mainMsgPackKeywords);
+
+enum {
+    ROCMMP_KERNEL_ARGS = 0, ROCMMP_KERNEL_DEVICE_ENQUEUE_SYMBOL,
+    ROCMMP_KERNEL_GROUP_SEGMENT_FIXED_SIZE, ROCMMP_KERNEL_KERNARG_SEGMENT_ALIGN,
+    ROCMMP_KERNEL_KERNARG_SEGMENT_SIZE, ROCMMP_KERNEL_LANGUAGE,
+    ROCMMP_KERNEL_LANGUAGE_VERSION, ROCMMP_KERNEL_MAX_FLAT_WORKGROUP_SIZE,
+    ROCMMP_KERNEL_NAME, ROCMMP_KERNEL_PRIVATE_SEGMENT_FIXED_SIZE,
+    ROCMMP_KERNEL_REQD_WORKGROUP_SIZE, ROCMMP_KERNEL_SGPR_COUNT,
+    ROCMMP_KERNEL_SGPR_SPILL_COUNT, ROCMMP_KERNEL_SYMBOL,
+    ROCMMP_KERNEL_VEC_TYPE_HINT, ROCMMP_KERNEL_VGPR_COUNT,
+    ROCMMP_KERNEL_VGPR_SPILL_COUNT, ROCMMP_KERNEL_WAVEFRONT_SIZE,
+    ROCMMP_KERNEL_WORKGROUP_SIZE_HINT
+};
+
+static const char* kernelMsgPackKeywords[] =
+{
+    ".args", ".device_enqueue_symbol", ".group_segment_fixed_size",
+    ".kernarg_segment_align", ".kernarg_segment_size", ".language",
+    ".language_version", ".max_flat_workgroup_size", ".name",
+    ".private_segment_fixed_size", ".reqd_workgroup_size", ".sgpr_count",
+    ".sgpr_spill_count", ".symbol", ".vec_type_hint", ".vgpr_count",
+    ".vgpr_spill_count", ".wavefront_size", ".workgroup_size_hint"
+};
+
+static const size_t kernelMsgPackKeywordsNum =
+        sizeof(kernelMsgPackKeywords) / sizeof(const char*);
+
+static const MetadataKeywordsHash kernelMsgPackKeywordsHash(
+            kernelMsgPackKeywordsNum, kernelMsgPackKeywords);
+
+enum {
+    ROCMMP_ARG_ACCESS = 0, ROCMMP_ARG_ACTUAL_ACCESS, ROCMMP_ARG_ADDRESS_SPACE,
+    ROCMMP_ARG_IS_CONST, ROCMMP_ARG_IS_PIPE, ROCMMP_ARG_IS_RESTRICT,
+    ROCMMP_ARG_IS_VOLATILE, ROCMMP_ARG_NAME, ROCMMP_ARG_OFFSET,
+    ROCMMP_ARG_POINTEE_ALIGN, ROCMMP_ARG_SIZE, ROCMMP_ARG_TYPE_NAME,
+    ROCMMP_ARG_VALUE_KIND, ROCMMP_ARG_VALUE_TYPE
+};
+
+static const char* kernelArgMsgPackKeywords[] =
+{
+    ".access", ".actual_access", ".address_space", ".is_const", ".is_pipe",
+    ".is_restrict", ".is_volatile", ".name", ".offset", ".pointee_align",
+    ".size", ".type_name", ".value_kind", ".value_type"
+};
+
+static const size_t kernelArgMsgPackKeywordsNum =
+        sizeof(kernelArgMsgPackKeywords) / sizeof(const char*);
+
+static const MetadataKeywordsHash kernelArgMsgPackKeywordsHash(
+            kernelArgMsgPackKeywordsNum, kernelArgMsgPackKeywords);
+
+static const std::pair<const char*, ROCmValueKind> rocmMPValueKindNamesMap[] =
+{
+    { "by_value", ROCmValueKind::BY_VALUE },
+    { "dynamic_shared_pointer", ROCmValueKind::DYN_SHARED_PTR },
+    { "global_buffer", ROCmValueKind::GLOBAL_BUFFER },
+    { "hidden_completion_action", ROCmValueKind::HIDDEN_COMPLETION_ACTION },
+    { "hidden_default_queue", ROCmValueKind::HIDDEN_DEFAULT_QUEUE },
+    { "hidden_global_offset_x", ROCmValueKind::HIDDEN_GLOBAL_OFFSET_X },
+    { "hidden_global_offset_y", ROCmValueKind::HIDDEN_GLOBAL_OFFSET_Y },
+    { "hidden_global_offset_z", ROCmValueKind::HIDDEN_GLOBAL_OFFSET_Z },
+    { "hidden_none", ROCmValueKind::HIDDEN_NONE },
+    { "hidden_printf_buffer", ROCmValueKind::HIDDEN_PRINTF_BUFFER },
+    { "image", ROCmValueKind::IMAGE },
+    { "pipe", ROCmValueKind::PIPE },
+    { "queue", ROCmValueKind::QUEUE },
+    { "sampler", ROCmValueKind::SAMPLER }
+};
+
+static const size_t rocmMPValueKindNamesNum = sizeof(rocmMPValueKindNamesMap) /
+            sizeof(std::pair<const char*, ROCmValueKind>);
+
+static const std::pair<const char*, ROCmValueType> rocmMPValueTypeNamesMap[] =
+{
+    { "f16", ROCmValueType::FLOAT16 },
+    { "f32", ROCmValueType::FLOAT32 },
+    { "f64", ROCmValueType::FLOAT64 },
+    { "i16", ROCmValueType::INT16 },
+    { "i32", ROCmValueType::INT32 },
+    { "i64", ROCmValueType::INT64 },
+    { "i8", ROCmValueType::INT8 },
+    { "struct", ROCmValueType::STRUCTURE },
+    { "u16", ROCmValueType::UINT16 },
+    { "u32", ROCmValueType::UINT32 },
+    { "u64", ROCmValueType::UINT64 },
+    { "u8", ROCmValueType::UINT8 }
+};
+
+static const size_t rocmMPValueTypeNamesNum = sizeof(rocmMPValueTypeNamesMap) /
+            sizeof(std::pair<const char*, ROCmValueType>);
+
+static const char* rocmMPAddrSpaceTypesTbl[] =
+{ "private", "global", "constant", "local", "generic", "region" };
+
+static const char* rocmMPAccessQualifierTbl[] =
+{ "default", "read_only", "write_only", "read_write" };
+
+static void parseROCmMsgPackKernelArg(const cxbyte*& dataPtr, const cxbyte* dataEnd,
+            ROCmKernelArgInfo& argInfo)
+{
+    uint64_t argOffset = 0;
+    const size_t entriesNum = parseMsgPackMapSize(dataPtr, dataEnd);
+    for (size_t i = 0; i < entriesNum; i++)
+    {
+        const char* keyStart;
+        const char* keyEnd;
+        parseMsgPackStringView(dataPtr, dataEnd, keyStart, keyEnd);
+        const size_t keyIndex = kernelArgMsgPackKeywordsHash.find(keyStart, keyEnd);
+        const char* valStart;
+        const char* valEnd;
+        switch(keyIndex)
+        {
+            case ROCMMP_ARG_ACCESS:
+            case ROCMMP_ARG_ACTUAL_ACCESS:
+            {
+                parseMsgPackStringView(dataPtr, dataEnd, valStart, valEnd);
+                size_t accIndex = 0;
+                for (; accIndex < 4; accIndex++)
+                    if (equalStrView(rocmMPAccessQualifierTbl[accIndex], valStart, valEnd))
+                        break;
+                if (accIndex == 4)
+                    throw ParseException("MsgPack: Wrong access qualifier");
+                if (keyIndex == ROCMMP_ARG_ACCESS)
+                    argInfo.accessQual = ROCmAccessQual(accIndex);
+                else
+                    argInfo.actualAccessQual = ROCmAccessQual(accIndex);
+                break;
+            }
+            case ROCMMP_ARG_ADDRESS_SPACE:
+            {
+                parseMsgPackStringView(dataPtr, dataEnd, valStart, valEnd);
+                size_t aspaceIndex = 0;
+                for (; aspaceIndex < 6; aspaceIndex++)
+                    if (equalStrView(rocmMPAddrSpaceTypesTbl[aspaceIndex],
+                                valStart, valEnd))
+                        break;
+                if (aspaceIndex == 6)
+                    throw ParseException("MsgPack: Wrong address space");
+                argInfo.addressSpace = ROCmAddressSpace(aspaceIndex+1);
+                break;
+            }
+            case ROCMMP_ARG_IS_CONST:
+                argInfo.isConst = parseMsgPackBool(dataPtr, dataEnd);
+                break;
+            case ROCMMP_ARG_IS_PIPE:
+                argInfo.isPipe = parseMsgPackBool(dataPtr, dataEnd);
+                break;
+            case ROCMMP_ARG_IS_RESTRICT:
+                argInfo.isRestrict = parseMsgPackBool(dataPtr, dataEnd);
+                break;
+            case ROCMMP_ARG_IS_VOLATILE:
+                argInfo.isVolatile = parseMsgPackBool(dataPtr, dataEnd);
+                break;
+            case ROCMMP_ARG_NAME:
+                argInfo.name = parseMsgPackString(dataPtr, dataEnd);
+                break;
+            case ROCMMP_ARG_OFFSET:
+                argOffset = parseMsgPackUInt(dataPtr, dataEnd);
+                break;
+            case ROCMMP_ARG_POINTEE_ALIGN:
+                argInfo.pointeeAlign = parseMsgPackUInt(dataPtr, dataEnd);
+                break;
+            case ROCMMP_ARG_SIZE:
+                argInfo.size = parseMsgPackUInt(dataPtr, dataEnd);
+                break;
+            case ROCMMP_ARG_TYPE_NAME:
+                argInfo.typeName = parseMsgPackString(dataPtr, dataEnd);
+                break;
+            case ROCMMP_ARG_VALUE_KIND:
+            {
+                parseMsgPackStringView(dataPtr, dataEnd, valStart, valEnd);
+                const size_t vkindIndex = findMetadataEnumValue(rocmMPValueKindNamesMap,
+                            rocmMPValueKindNamesNum, valStart, valEnd);
+                if (vkindIndex == rocmMPValueKindNamesNum)
+                    throw ParseException("MsgPack: Wrong argument value kind");
+                argInfo.valueKind = rocmMPValueKindNamesMap[vkindIndex].second;
+                break;
+            }
+            case ROCMMP_ARG_VALUE_TYPE:
+            {
+                parseMsgPackStringView(dataPtr, dataEnd, valStart, valEnd);
+                const size_t vtypeIndex = findMetadataEnumValue(rocmMPValueTypeNamesMap,
+                            rocmMPValueTypeNamesNum, valStart, valEnd);
+                if (vtypeIndex == rocmMPValueTypeNamesNum)
+                    throw ParseException("MsgPack: Wrong argument value type");
+                argInfo.valueType = rocmMPValueTypeNamesMap[vtypeIndex].second;
+                break;
+            }
+            default:
+                skipMsgPackObject(dataPtr, dataEnd);
+                break;
+        }
+    }
+    // code object v3 has no argument alignment, hence get it from offset
+    if (argOffset != 0)
+        argInfo.align = argOffset & (~argOffset+1);
+    else
+        for (argInfo.align = 1; argInfo.align < argInfo.size; argInfo.align <<= 1);
+}
+
+static void parseROCmMsgPackKernel(const cxbyte*& dataPtr, const cxbyte* dataEnd,
+            ROCmKernelMetadata& kernel)
+{
+    // code properties are always in kernel map
+    kernel.kernargSegmentSize = BINGEN64_DEFAULT;
+    kernel.groupSegmentFixedSize = BINGEN64_DEFAULT;
+    kernel.privateSegmentFixedSize = BINGEN64_DEFAULT;
+    kernel.kernargSegmentAlign = BINGEN64_DEFAULT;
+    kernel.wavefrontSize = BINGEN_DEFAULT;
+    kernel.sgprsNum = BINGEN_DEFAULT;
+    kernel.vgprsNum = BINGEN_DEFAULT;
+    kernel.maxFlatWorkGroupSize = BINGEN64_DEFAULT;
+    
+    const size_t entriesNum = parseMsgPackMapSize(dataPtr, dataEnd);
+    for (size_t i = 0; i < entriesNum; i++)
+    {
+        const char* keyStart;
+        const char* keyEnd;
+        parseMsgPackStringView(dataPtr, dataEnd, keyStart, keyEnd);
+        const size_t keyIndex = kernelMsgPackKeywordsHash.find(keyStart, keyEnd);
+        switch(keyIndex)
+        {
+            case ROCMMP_KERNEL_ARGS:
+            {
+                const size_t argsNum = parseMsgPackArraySize(dataPtr, dataEnd);
+                kernel.argInfos.resize(argsNum);
+                for (size_t k = 0; k < argsNum; k++)
+                    parseROCmMsgPackKernelArg(dataPtr, dataEnd, kernel.argInfos[k]);
+                break;
+            }
+            case ROCMMP_KERNEL_DEVICE_ENQUEUE_SYMBOL:
+                kernel.runtimeHandle = parseMsgPackString(dataPtr, dataEnd);
+                break;
+            case ROCMMP_KERNEL_GROUP_SEGMENT_FIXED_SIZE:
+                kernel.groupSegmentFixedSize = parseMsgPackUInt(dataPtr, dataEnd);
+                break;
+            case ROCMMP_KERNEL_KERNARG_SEGMENT_ALIGN:
+                kernel.kernargSegmentAlign = parseMsgPackUInt(dataPtr, dataEnd);
+                break;
+            case ROCMMP_KERNEL_KERNARG_SEGMENT_SIZE:
+                kernel.kernargSegmentSize = parseMsgPackUInt(dataPtr, dataEnd);
+                break;
+            case ROCMMP_KERNEL_LANGUAGE:
+                kernel.language = parseMsgPackString(dataPtr, dataEnd);
+                break;
+            case ROCMMP_KERNEL_LANGUAGE_VERSION:
+                parseMsgPackUIntArray(dataPtr, dataEnd, 2, kernel.langVersion);
+                break;
+            case ROCMMP_KERNEL_MAX_FLAT_WORKGROUP_SIZE:
+                kernel.maxFlatWorkGroupSize = parseMsgPackUInt(dataPtr, dataEnd);
+                break;
+            case ROCMMP_KERNEL_NAME:
+                kernel.name = parseMsgPackString(dataPtr, dataEnd);
+                break;
+            case ROCMMP_KERNEL_PRIVATE_SEGMENT_FIXED_SIZE:
+                kernel.privateSegmentFixedSize = parseMsgPackUInt(dataPtr, dataEnd);
+                break;
+            case ROCMMP_KERNEL_REQD_WORKGROUP_SIZE:
+                parseMsgPackUIntArray(dataPtr, dataEnd, 3, kernel.reqdWorkGroupSize);
+                break;
+            case ROCMMP_KERNEL_SGPR_COUNT:
+                kernel.sgprsNum = parseMsgPackUInt32(dataPtr, dataEnd);
+                break;
+            case ROCMMP_KERNEL_SGPR_SPILL_COUNT:
+                kernel.spilledSgprs = parseMsgPackUInt32(dataPtr, dataEnd);
+                break;
+            case ROCMMP_KERNEL_SYMBOL:
+                kernel.symbolName = parseMsgPackString(dataPtr, dataEnd);
+                break;
+            case ROCMMP_KERNEL_VEC_TYPE_HINT:
+                kernel.vecTypeHint = parseMsgPackString(dataPtr, dataEnd);
+                break;
+            case ROCMMP_KERNEL_VGPR_COUNT:
+                kernel.vgprsNum = parseMsgPackUInt32(dataPtr, dataEnd);
+                break;
+            case ROCMMP_KERNEL_VGPR_SPILL_COUNT:
+                kernel.spilledVgprs = parseMsgPackUInt32(dataPtr, dataEnd);
+                break;
+            case ROCMMP_KERNEL_WAVEFRONT_SIZE:
+                kernel.wavefrontSize = parseMsgPackUInt32(dataPtr, dataEnd);
+                break;
+            case ROCMMP_KERNEL_WORKGROUP_SIZE_HINT:
+                parseMsgPackUIntArray(dataPtr, dataEnd, 3, kernel.workGroupSizeHint);
+                break;
+            default:
+                skipMsgPackObject(dataPtr, dataEnd);
+                break;
+        }
+    }
+}
+
+// streaming MsgPack parser: fills metadata info directly without document tree
+static void parseROCmMetadataMsgPack(size_t metadataSize, const cxbyte* metadata,
+                ROCmMetadata& metadataInfo)
+{
+    const cxbyte* dataPtr = metadata;
+    const cxbyte* dataEnd = metadata + metadataSize;
+    // init metadata info object
+    metadataInfo.kernels.clear();
+    metadataInfo.printfInfos.clear();
+    metadataInfo.version[0] = metadataInfo.version[1] = 0;
+    
+    const size_t entriesNum = parseMsgPackMapSize(dataPtr, dataEnd);
+    for (size_t i = 0; i < entriesNum; i++)
+    {
+        const char* keyStart;
+        const char* keyEnd;
+        parseMsgPackStringView(dataPtr, dataEnd, keyStart, keyEnd);
+        const size_t keyIndex = mainMsgPackKeywordsHash.find(keyStart, keyEnd);
+        switch(keyIndex)
+        {
+            case ROCMMP_MAIN_KERNELS:
+            {
+                const size_t kernelsNum = parseMsgPackArraySize(dataPtr, dataEnd);
+                metadataInfo.kernels.resize(kernelsNum);
+                for (size_t k = 0; k < kernelsNum; k++)
+                {
+                    ROCmKernelMetadata& kernel = metadataInfo.kernels[k];
+                    kernel.initialize();
+                    parseROCmMsgPackKernel(dataPtr, dataEnd, kernel);
+                }
+                break;
+            }
+            case ROCMMP_MAIN_PRINTF:
+            {
+                std::unordered_set<cxuint> printfIds;
+                const size_t printfsNum = parseMsgPackArraySize(dataPtr, dataEnd);
+                metadataInfo.printfInfos.resize(printfsNum);
+                for (size_t k = 0; k < printfsNum; k++)
+                {
+                    const char* strStart;
+                    const char* strEnd;
+                    parseMsgPackStringView(dataPtr, dataEnd, strStart, strEnd);
+                    parseROCmPrintfInfo(strStart, strEnd, printfIds,
+                                metadataInfo.printfInfos[k]);
+                }
+                break;
+            }
+            case ROCMMP_MAIN_VERSION:
+                parseMsgPackUIntArray(dataPtr, dataEnd, 2, metadataInfo.version);
+                break;
+            default:
+                skipMsgPackObject(dataPtr, dataEnd);
+                break;
+        }
+    }
+}
+
+void ROCmMetadata::parseMsgPack(size_t metadataSize, const cxbyte* metadata)
+{
+    parseROCmMetadataMsgPack(metadataSize, metadata, *this);
+}
+
 /*
  * ROCm binary reader and generator
  */
@@ -1351,13 +2090,9 @@ ROCmBinary::ROCmBinary(size_t binaryCodeSize, cxbyte* binaryCode, Flags creation
         : ElfBinary64(binaryCodeSize, binaryCode, creationFlags),
           regionsNum(0), codeSize(0), code(nullptr),
           globalDataSize(0), globalData(nullptr), metadataSize(0), metadata(nullptr),
-          newBinFormat(false)
+          metadataMsgPack(false), newBinFormat(false)
 {
-    cxuint textIndex = SHN_UNDEF;
-    try
-    { textIndex = getSectionIndex(".text"); }
-    catch(const Exception& ex)
-    { } // ignore failed
+    cxuint textIndex = findSectionIndex(".text");
     uint64_t codeOffset = 0;
     // find '.text' section
     if (textIndex!=SHN_UNDEF)
@@ -1368,11 +2103,7 @@ ROCmBinary::ROCmBinary(size_t binaryCodeSize, cxbyte* binaryCode, Flags creation
         codeOffset = ULEV(textShdr.sh_offset);
     }
     
-    cxuint rodataIndex = SHN_UNDEF;
-    try
-    { rodataIndex = getSectionIndex(".rodata"); }
-    catch(const Exception& ex)
-    { } // ignore failed
+    cxuint rodataIndex = findSectionIndex(".rodata");
     // find '.text' section
     if (rodataIndex!=SHN_UNDEF)
     {
@@ -1381,24 +2112,12 @@ ROCmBinary::ROCmBinary(size_t binaryCodeSize, cxbyte* binaryCode, Flags creation
         globalDataSize = ULEV(rodataShdr.sh_size);
     }
     
-    cxuint gpuConfigIndex = SHN_UNDEF;
-    try
-    { gpuConfigIndex = getSectionIndex(".AMDGPU.config"); }
-    catch(const Exception& ex)
-    { } // ignore failed
+    cxuint gpuConfigIndex = findSectionIndex(".AMDGPU.config");
     newBinFormat = (gpuConfigIndex == SHN_UNDEF);
     
-    cxuint relaDynIndex = SHN_UNDEF;
-    try
-    { relaDynIndex = getSectionIndex(".rela.dyn"); }
-    catch(const Exception& ex)
-    { } // ignore failed
+    cxuint relaDynIndex = findSectionIndex(".rela.dyn");
     
-    cxuint gotIndex = SHN_UNDEF;
-    try
-    { gotIndex = getSectionIndex(".got"); }
-    catch(const Exception& ex)
-    { } // ignore failed
+    cxuint gotIndex = findSectionIndex(".got");
     
     // counts regions (symbol or kernel)
     regionsNum = 0;
@@ -1524,12 +2243,21 @@ ROCmBinary::ROCmBinary(size_t binaryCodeSize, cxbyte* binaryCode, Flags creation
             {
                 metadata = (char*)(noteContent+offset+sizeof(Elf64_Nhdr) + 4);
                 metadataSize = descsz;
+                metadataMsgPack = false;
             }
             else if (noteType == 0xb)
                 target.assign((char*)(noteContent+offset+sizeof(Elf64_Nhdr) + 4), descsz);
         }
-        size_t align = (((namesz+descsz)&3)!=0) ? 4-((namesz+descsz)&3) : 0;
-        offset += sizeof(Elf64_Nhdr) + namesz + descsz + align;
+        else if (namesz==7 && ULEV(nhdr->n_type) == 32 &&
+            ::strcmp((const char*)noteContent+offset+ sizeof(Elf64_Nhdr), "AMDGPU")==0)
+        {
+            // NT_AMDGPU_METADATA (MsgPack metadata from code object v3)
+            metadata = (char*)(noteContent+offset+sizeof(Elf64_Nhdr) + 8);
+            metadataSize = descsz;
+            metadataMsgPack = true;
+        }
+        // name and description are aligned separately
+        offset += sizeof(Elf64_Nhdr) + ((namesz+3)&~size_t(3)) + ((descsz+3)&~size_t(3));
     }
     
     if (hasRegionMap())
@@ -1546,7 +2274,10 @@ ROCmBinary::ROCmBinary(size_t binaryCodeSize, cxbyte* binaryCode, Flags creation
         metadata != nullptr && metadataSize != 0)
     {
         metadataInfo.reset(new ROCmMetadata());
-        parseROCmMetadata(metadataSize, metadata, *metadataInfo);
+        if (metadataMsgPack)
+            parseROCmMetadataMsgPack(metadataSize, (const cxbyte*)metadata, *metadataInfo);
+        else
+            parseROCmMetadata(metadataSize, metadata, *metadataInfo);
         
         if (hasKernelInfoMap())
         {
@@ -1590,8 +2321,9 @@ GPUDeviceType ROCmBinary::determineGPUDeviceType(uint32_t& outArchMinor,
                 archMinor = ULEV(content[2]);
                 archStepping = ULEV(content[3]);
             }
-            size_t align = (((namesz+descsz)&3)!=0) ? 4-((namesz+descsz)&3) : 0;
-            offset += sizeof(Elf64_Nhdr) + namesz + descsz + align;
+            // name and description are aligned separately
+            offset += sizeof(Elf64_Nhdr) + ((namesz+3)&~size_t(3)) +
+                        ((descsz+3)&~size_t(3));
         }
     }
     // determine device type
@@ -1635,6 +2367,78 @@ bool CLRX::isROCmBinary(size_t binarySize, const cxbyte* binary)
     return true;
 }
 
+bool CLRX::patchROCmKernel(ROCmBinary& binary, const char* kernelName,
+            size_t codeSize, const cxbyte* code, const cxbyte* setup,
+            Array<cxbyte>& output)
+{
+    const uint16_t textIndex = binary.findSectionIndex(".text");
+    if (textIndex == SHN_UNDEF)
+        throw BinException("No code section in binary");
+    const Elf64_Shdr& textShdr = binary.getSectionHeader(textIndex);
+    const size_t textAddr = ULEV(textShdr.sh_addr);
+    const size_t textEnd = textAddr + ULEV(textShdr.sh_size);
+    // find kernel region and its space (to next region)
+    const ROCmRegion* kernelRegion = nullptr;
+    for (size_t i = 0; i < binary.getRegionsNum(); i++)
+    {
+        const ROCmRegion& region = binary.getRegion(i);
+        if (region.type != ROCmRegionType::DATA && region.regionName == kernelName)
+        {
+            kernelRegion = &region;
+            break;
+        }
+    }
+    if (kernelRegion == nullptr)
+        throw BinException("Kernel not found");
+    size_t regionEnd = textEnd;
+    for (size_t i = 0; i < binary.getRegionsNum(); i++)
+    {
+        const size_t offset = binary.getRegion(i).offset;
+        if (offset > kernelRegion->offset && offset < regionEnd)
+            regionEnd = offset;
+    }
+    
+    const size_t regionSpace = regionEnd - kernelRegion->offset;
+    // relocations in old kernel code can not be moved
+    for (uint16_t i = 1; i < binary.getSectionHeadersNum(); i++)
+    {
+        const Elf64_Shdr& shdr = binary.getSectionHeader(i);
+        if (ULEV(shdr.sh_type) != SHT_RELA && ULEV(shdr.sh_type) != SHT_REL)
+            continue;
+        const size_t entSize = ULEV(shdr.sh_entsize);
+        if (entSize < sizeof(Elf64_Rel))
+            throw BinException("Relocation entry size is too small");
+        const cxbyte* relocs = binary.getSectionContent(i);
+        for (size_t pos = 0; pos + entSize <= ULEV(shdr.sh_size); pos += entSize)
+        {
+            // r_offset is first field in Rel and Rela
+            const size_t relOffset = ULEV(reinterpret_cast<const Elf64_Rel*>(
+                        relocs + pos)->r_offset);
+            if (relOffset >= kernelRegion->offset &&
+                relOffset < kernelRegion->offset + kernelRegion->size)
+                throw BinException("Kernel with relocations can not be patched");
+        }
+    }
+    
+    const cxbyte* oldSetup = binary.getBinaryCode() + ULEV(textShdr.sh_offset) +
+                (kernelRegion->offset - textAddr);
+    if (setup == nullptr)
+        setup = oldSetup;
+    // code offset after setup (kernel_code_entry_byte_offset)
+    const uint64_t setupSize = ULEV(*reinterpret_cast<const uint64_t*>(setup+16));
+    if (setupSize < 256 || setupSize > regionSpace)
+        throw BinException("Wrong kernel code entry offset in setup");
+    if (codeSize > SIZE_MAX - setupSize)
+        throw BinException("Kernel code is too big");
+    Array<cxbyte> content(setupSize + codeSize);
+    std::copy(setup, setup + 256, content.data());
+    std::fill(content.data() + 256, content.data() + setupSize, cxbyte(0));
+    std::copy(code, code + codeSize, content.data() + setupSize);
+    
+    return patchElfSectionRegion(binary, textIndex, kernelRegion->offset - textAddr,
+                kernelRegion->size, regionSpace, content.size(), content.data(), output);
+}
+
 
 void ROCmInput::addEmptyKernel(const char* kernelName)
 {
@@ -1715,6 +2519,31 @@ static std::string escapePrintfFormat(const std::string& fmt)
     return out;
 }
 
+// check printf ids uniqueness and assign free ids to printfs with default id
+static void prepareROCmPrintfIds(const std::vector<ROCmPrintfInfo>& printfInfos,
+            Array<uint32_t>& outPrintfIds)
+{
+    std::unordered_set<cxuint> printfIds;
+    for (const ROCmPrintfInfo& printfInfo: printfInfos)
+        if (printfInfo.id!=BINGEN_DEFAULT)
+            if (!printfIds.insert(printfInfo.id).second)
+                throw BinGenException("Duplicate of printf id");
+    outPrintfIds.resize(printfInfos.size());
+    uint32_t freePrintfId = 1;
+    for (size_t i = 0; i < printfInfos.size(); i++)
+    {
+        uint32_t printfId = printfInfos[i].id;
+        if (printfId == BINGEN_DEFAULT)
+        {
+            // skip used printfids
+            for (; printfIds.find(freePrintfId) != printfIds.end(); ++freePrintfId);
+            // just use this free printfid
+            printfId = freePrintfId++;
+        }
+        outPrintfIds[i] = printfId;
+    }
+}
+
 static void generateROCmMetadata(const ROCmMetadata& mdInfo,
                     const ROCmKernelConfig** kconfigs, std::string& output)
 {
@@ -1729,29 +2558,15 @@ static void generateROCmMetadata(const ROCmMetadata& mdInfo,
         output += "[ 1, 0 ]\n";
     if (!mdInfo.printfInfos.empty())
         output += "Printf:          \n";
-    // check print ids uniquness
     {
-        std::unordered_set<cxuint> printfIds;
-        for (const ROCmPrintfInfo& printfInfo: mdInfo.printfInfos)
-            if (printfInfo.id!=BINGEN_DEFAULT)
-                if (!printfIds.insert(printfInfo.id).second)
-                    throw BinGenException("Duplicate of printf id");
+        Array<uint32_t> printfIds;
+        prepareROCmPrintfIds(mdInfo.printfInfos, printfIds);
         // printfs
-        uint32_t freePrintfId = 1;
-        for (const ROCmPrintfInfo& printfInfo: mdInfo.printfInfos)
+        for (size_t i = 0; i < mdInfo.printfInfos.size(); i++)
         {
-            // skip used printfids;
-            uint32_t printfId = printfInfo.id;
-            if (printfId == BINGEN_DEFAULT)
-            {
-                // skip used printfids
-                for (; printfIds.find(freePrintfId) != printfIds.end(); ++freePrintfId);
-                // just use this free printfid
-                printfId = freePrintfId++;
-            }
-            
+            const ROCmPrintfInfo& printfInfo = mdInfo.printfInfos[i];
             output += "  - '";
-            itocstrCStyle(printfId, numBuf, 24);
+            itocstrCStyle(printfIds[i], numBuf, 24);
             output += numBuf;
             output += ':';
             itocstrCStyle(printfInfo.argSizes.size(), numBuf, 24);
@@ -1983,6 +2798,399 @@ static void generateROCmMetadata(const ROCmMetadata& mdInfo,
     output += "...\n";
 }
 
+/*
+ * ROCm MsgPack metadata generator (code object v3)
+ */
+
+// put big-endian value to MsgPack data
+static void putMsgPackBE(uint64_t value, cxuint size, std::string& output)
+{
+    for (cxuint i = size; i > 0; i--)
+        output.push_back(char(value >> ((i-1)*8)));
+}
+
+static void putMsgPackUInt(uint64_t value, std::string& output)
+{
+    if (value < 0x80)
+        output.push_back(char(value)); // positive fixint
+    else if (value < 0x100)
+    {
+        output.push_back(char(0xcc));
+        putMsgPackBE(value, 1, output);
+    }
+    else if (value < 0x10000)
+    {
+        output.push_back(char(0xcd));
+        putMsgPackBE(value, 2, output);
+    }
+    else if (value < 0x100000000ULL)
+    {
+        output.push_back(char(0xce));
+        putMsgPackBE(value, 4, output);
+    }
+    else
+    {
+        output.push_back(char(0xcf));
+        putMsgPackBE(value, 8, output);
+    }
+}
+
+static inline void putMsgPackBool(bool value, std::string& output)
+{
+    output.push_back(char(value ? 0xc3 : 0xc2));
+}
+
+static void putMsgPackString(const char* str, size_t size, std::string& output)
+{
+    if (size < 32)
+        output.push_back(char(0xa0 | size)); // fixstr
+    else if (size < 0x100)
+    {
+        output.push_back(char(0xd9));
+        putMsgPackBE(size, 1, output);
+    }
+    else if (size < 0x10000)
+    {
+        output.push_back(char(0xda));
+        putMsgPackBE(size, 2, output);
+    }
+    else
+    {
+        output.push_back(char(0xdb));
+        putMsgPackBE(size, 4, output);
+    }
+    output.append(str, size);
+}
+
+static inline void putMsgPackString(const char* str, std::string& output)
+{
+    putMsgPackString(str, ::strlen(str), output);
+}
+
+static void putMsgPackArraySize(size_t size, std::string& output)
+{
+    if (size < 16)
+        output.push_back(char(0x90 | size)); // fixarray
+    else if (size < 0x10000)
+    {
+        output.push_back(char(0xdc));
+        putMsgPackBE(size, 2, output);
+    }
+    else
+    {
+        output.push_back(char(0xdd));
+        putMsgPackBE(size, 4, output);
+    }
+}
+
+static void putMsgPackUIntArray(cxuint n, const cxuint* values, std::string& output)
+{
+    putMsgPackArraySize(n, output);
+    for (cxuint i = 0; i < n; i++)
+        putMsgPackUInt(values[i], output);
+}
+
+/// MsgPack map writer (number of entries is stored while finishing map)
+class CLRX_INTERNAL MsgPackMapWriter
+{
+private:
+    std::string& output;
+    size_t headerPos;
+    uint32_t entriesNum;
+public:
+    explicit MsgPackMapWriter(std::string& _output)
+            : output(_output), headerPos(_output.size()), entriesNum(0)
+    {
+        // map32 header with number of entries filled later
+        output.push_back(char(0xdf));
+        output.append(4, '\0');
+    }
+    
+    /// put key of next entry (value should be put after this call)
+    void key(const char* name)
+    {
+        putMsgPackString(name, output);
+        entriesNum++;
+    }
+    
+    /// store number of entries in map header
+    void finish()
+    {
+        for (cxuint i = 0; i < 4; i++)
+            output[headerPos+1+i] = char(entriesNum >> ((3-i)*8));
+    }
+};
+
+// find name of enum value in metadata name map
+template<typename T>
+static const char* getMetadataEnumName(const std::pair<const char*, T>* map,
+            size_t mapSize, T value)
+{
+    for (size_t i = 0; i < mapSize; i++)
+        if (map[i].second == value)
+            return map[i].first;
+    return nullptr;
+}
+
+static void generateROCmMsgPackKernelArgs(const ROCmKernelMetadata& kernel,
+            std::string& output)
+{
+    putMsgPackArraySize(kernel.argInfos.size(), output);
+    uint64_t argOffset = 0;
+    for (const ROCmKernelArgInfo& argInfo: kernel.argInfos)
+    {
+        MsgPackMapWriter argMap(output);
+        if (!argInfo.name.empty())
+        {
+            argMap.key(".name");
+            putMsgPackString(argInfo.name.c_str(), argInfo.name.size(), output);
+        }
+        if (!argInfo.typeName.empty())
+        {
+            argMap.key(".type_name");
+            putMsgPackString(argInfo.typeName.c_str(), argInfo.typeName.size(), output);
+        }
+        // code object v3 holds offsets instead alignments
+        if (argInfo.align > 1)
+            argOffset = (argOffset + argInfo.align-1) & ~(argInfo.align-1);
+        argMap.key(".offset");
+        putMsgPackUInt(argOffset, output);
+        argOffset += argInfo.size;
+        argMap.key(".size");
+        putMsgPackUInt(argInfo.size, output);
+        
+        const char* vkindName = getMetadataEnumName(rocmMPValueKindNamesMap,
+                    rocmMPValueKindNamesNum, argInfo.valueKind);
+        if (vkindName == nullptr)
+            throw BinGenException("Unknown ValueKind");
+        argMap.key(".value_kind");
+        putMsgPackString(vkindName, output);
+        
+        const char* vtypeName = getMetadataEnumName(rocmMPValueTypeNamesMap,
+                    rocmMPValueTypeNamesNum, argInfo.valueType);
+        if (vtypeName == nullptr)
+            throw BinGenException("Unknown ValueType");
+        argMap.key(".value_type");
+        putMsgPackString(vtypeName, output);
+        
+        if (argInfo.valueKind == ROCmValueKind::DYN_SHARED_PTR)
+        {
+            argMap.key(".pointee_align");
+            putMsgPackUInt(argInfo.pointeeAlign, output);
+        }
+        if (argInfo.valueKind == ROCmValueKind::DYN_SHARED_PTR ||
+            argInfo.valueKind == ROCmValueKind::GLOBAL_BUFFER)
+        {
+            if (argInfo.addressSpace > ROCmAddressSpace::MAX_VALUE ||
+                argInfo.addressSpace == ROCmAddressSpace::NONE)
+                throw BinGenException("Unknown AddressSpace");
+            argMap.key(".address_space");
+            putMsgPackString(rocmMPAddrSpaceTypesTbl[cxuint(argInfo.addressSpace)-1],
+                        output);
+        }
+        // default access qualifiers are not stored in code object v3
+        if (argInfo.valueKind == ROCmValueKind::IMAGE ||
+            argInfo.valueKind == ROCmValueKind::PIPE)
+        {
+            if (argInfo.accessQual > ROCmAccessQual::MAX_VALUE)
+                throw BinGenException("Unknown AccessQualifier");
+            if (argInfo.accessQual != ROCmAccessQual::DEFAULT)
+            {
+                argMap.key(".access");
+                putMsgPackString(rocmMPAccessQualifierTbl[cxuint(argInfo.accessQual)],
+                            output);
+            }
+        }
+        if (argInfo.valueKind == ROCmValueKind::GLOBAL_BUFFER ||
+            argInfo.valueKind == ROCmValueKind::IMAGE ||
+            argInfo.valueKind == ROCmValueKind::PIPE)
+        {
+            if (argInfo.actualAccessQual > ROCmAccessQual::MAX_VALUE)
+                throw BinGenException("Unknown ActualAccessQualifier");
+            if (argInfo.actualAccessQual != ROCmAccessQual::DEFAULT)
+            {
+                argMap.key(".actual_access");
+                putMsgPackString(rocmMPAccessQualifierTbl[
+                            cxuint(argInfo.actualAccessQual)], output);
+            }
+        }
+        if (argInfo.isConst)
+        {
+            argMap.key(".is_const");
+            putMsgPackBool(true, output);
+        }
+        if (argInfo.isRestrict)
+        {
+            argMap.key(".is_restrict");
+            putMsgPackBool(true, output);
+        }
+        if (argInfo.isVolatile)
+        {
+            argMap.key(".is_volatile");
+            putMsgPackBool(true, output);
+        }
+        if (argInfo.isPipe)
+        {
+            argMap.key(".is_pipe");
+            putMsgPackBool(true, output);
+        }
+        argMap.finish();
+    }
+}
+
+static void generateROCmMetadataMsgPack(const ROCmMetadata& mdInfo,
+                    const ROCmKernelConfig** kconfigs, std::string& output)
+{
+    output.clear();
+    MsgPackMapWriter mainMap(output);
+    // version
+    mainMap.key("amdhsa.version");
+    if (hasValue(mdInfo.version[0]))
+        putMsgPackUIntArray(2, mdInfo.version, output);
+    else
+    {
+        // default
+        const cxuint defaultVersion[2] = { 1, 0 };
+        putMsgPackUIntArray(2, defaultVersion, output);
+    }
+    // printfs
+    if (!mdInfo.printfInfos.empty())
+    {
+        mainMap.key("amdhsa.printf");
+        putMsgPackArraySize(mdInfo.printfInfos.size(), output);
+        Array<uint32_t> printfIds;
+        prepareROCmPrintfIds(mdInfo.printfInfos, printfIds);
+        char numBuf[24];
+        for (size_t i = 0; i < mdInfo.printfInfos.size(); i++)
+        {
+            const ROCmPrintfInfo& printfInfo = mdInfo.printfInfos[i];
+            // format is not escaped in MsgPack string
+            std::string printfStr;
+            itocstrCStyle(printfIds[i], numBuf, 24);
+            printfStr += numBuf;
+            printfStr += ':';
+            itocstrCStyle(printfInfo.argSizes.size(), numBuf, 24);
+            printfStr += numBuf;
+            printfStr += ':';
+            for (size_t argSize: printfInfo.argSizes)
+            {
+                itocstrCStyle(argSize, numBuf, 24);
+                printfStr += numBuf;
+                printfStr += ':';
+            }
+            printfStr.append(printfInfo.format.c_str(), printfInfo.format.size());
+            putMsgPackString(printfStr.c_str(), printfStr.size(), output);
+        }
+    }
+    
+    if (!mdInfo.kernels.empty())
+    {
+        mainMap.key("amdhsa.kernels");
+        putMsgPackArraySize(mdInfo.kernels.size(), output);
+    }
+    for (size_t i = 0; i < mdInfo.kernels.size(); i++)
+    {
+        const ROCmKernelMetadata& kernel = mdInfo.kernels[i];
+        MsgPackMapWriter kernelMap(output);
+        kernelMap.key(".name");
+        putMsgPackString(kernel.name.c_str(), kernel.name.size(), output);
+        kernelMap.key(".symbol");
+        if (!kernel.symbolName.empty())
+            putMsgPackString(kernel.symbolName.c_str(), kernel.symbolName.size(), output);
+        else
+        {
+            // default is kernel name + '@kd'
+            std::string symName = kernel.name.c_str();
+            symName += "@kd";
+            putMsgPackString(symName.c_str(), symName.size(), output);
+        }
+        if (!kernel.language.empty())
+        {
+            kernelMap.key(".language");
+            putMsgPackString(kernel.language.c_str(), kernel.language.size(), output);
+        }
+        if (kernel.langVersion[0] != BINGEN_NOTSUPPLIED)
+        {
+            kernelMap.key(".language_version");
+            putMsgPackUIntArray(2, kernel.langVersion, output);
+        }
+        // kernel attributes
+        if (kernel.workGroupSizeHint[0] != 0 || kernel.workGroupSizeHint[1] != 0 ||
+            kernel.workGroupSizeHint[2] != 0)
+        {
+            kernelMap.key(".workgroup_size_hint");
+            putMsgPackUIntArray(3, kernel.workGroupSizeHint, output);
+        }
+        if (kernel.reqdWorkGroupSize[0] != 0 || kernel.reqdWorkGroupSize[1] != 0 ||
+            kernel.reqdWorkGroupSize[2] != 0)
+        {
+            kernelMap.key(".reqd_workgroup_size");
+            putMsgPackUIntArray(3, kernel.reqdWorkGroupSize, output);
+        }
+        if (!kernel.vecTypeHint.empty())
+        {
+            kernelMap.key(".vec_type_hint");
+            putMsgPackString(kernel.vecTypeHint.c_str(), kernel.vecTypeHint.size(),
+                        output);
+        }
+        if (!kernel.runtimeHandle.empty())
+        {
+            kernelMap.key(".device_enqueue_symbol");
+            putMsgPackString(kernel.runtimeHandle.c_str(), kernel.runtimeHandle.size(),
+                        output);
+        }
+        // kernel arguments
+        if (!kernel.argInfos.empty())
+        {
+            kernelMap.key(".args");
+            generateROCmMsgPackKernelArgs(kernel, output);
+        }
+        
+        // kernel code properties
+        const ROCmKernelConfig& kconfig = *kconfigs[i];
+        kernelMap.key(".kernarg_segment_size");
+        putMsgPackUInt(hasValue(kernel.kernargSegmentSize) ?
+                kernel.kernargSegmentSize : ULEV(kconfig.kernargSegmentSize), output);
+        kernelMap.key(".group_segment_fixed_size");
+        putMsgPackUInt(hasValue(kernel.groupSegmentFixedSize) ?
+                kernel.groupSegmentFixedSize :
+                uint64_t(ULEV(kconfig.workgroupGroupSegmentSize)), output);
+        kernelMap.key(".private_segment_fixed_size");
+        putMsgPackUInt(hasValue(kernel.privateSegmentFixedSize) ?
+                kernel.privateSegmentFixedSize :
+                uint64_t(ULEV(kconfig.workitemPrivateSegmentSize)), output);
+        kernelMap.key(".kernarg_segment_align");
+        putMsgPackUInt(hasValue(kernel.kernargSegmentAlign) ?
+                kernel.kernargSegmentAlign :
+                uint64_t(1ULL<<kconfig.kernargSegmentAlignment), output);
+        kernelMap.key(".wavefront_size");
+        putMsgPackUInt(hasValue(kernel.wavefrontSize) ? kernel.wavefrontSize :
+                cxuint(1U<<kconfig.wavefrontSize), output);
+        kernelMap.key(".sgpr_count");
+        putMsgPackUInt(hasValue(kernel.sgprsNum) ? kernel.sgprsNum :
+                cxuint(ULEV(kconfig.wavefrontSgprCount)), output);
+        kernelMap.key(".vgpr_count");
+        putMsgPackUInt(hasValue(kernel.vgprsNum) ? kernel.vgprsNum :
+                cxuint(ULEV(kconfig.workitemVgprCount)), output);
+        // spilled registers
+        if (hasValue(kernel.spilledSgprs))
+        {
+            kernelMap.key(".sgpr_spill_count");
+            putMsgPackUInt(kernel.spilledSgprs, output);
+        }
+        if (hasValue(kernel.spilledVgprs))
+        {
+            kernelMap.key(".vgpr_spill_count");
+            putMsgPackUInt(kernel.spilledVgprs, output);
+        }
+        kernelMap.key(".max_flat_workgroup_size");
+        putMsgPackUInt(hasValue(kernel.maxFlatWorkGroupSize) ?
+                    kernel.maxFlatWorkGroupSize : uint64_t(256), output);
+        kernelMap.finish();
+    }
+    mainMap.finish();
+}
+
 /* ROCm section generators */
 
 class CLRX_INTERNAL ROCmGotGen: public ElfRegionContent
@@ -2029,18 +3237,20 @@ public:
  * ROCm Binary Generator
  */
 
-ROCmBinGenerator::ROCmBinGenerator() : manageable(false), input(nullptr)
+ROCmBinGenerator::ROCmBinGenerator() : manageable(false), input(nullptr),
+        mergeStrTables(false)
 { }
 
 ROCmBinGenerator::ROCmBinGenerator(const ROCmInput* rocmInput)
-        : manageable(false), input(rocmInput), rocmGotGen(nullptr), rocmRelaDynGen(nullptr)
+        : manageable(false), input(rocmInput), mergeStrTables(false),
+          rocmGotGen(nullptr), rocmRelaDynGen(nullptr)
 { }
 
 ROCmBinGenerator::ROCmBinGenerator(GPUDeviceType deviceType,
         uint32_t archMinor, uint32_t archStepping, size_t codeSize, const cxbyte* code,
         size_t globalDataSize, const cxbyte* globalData,
         const std::vector<ROCmSymbolInput>& symbols) :
-        rocmGotGen(nullptr), rocmRelaDynGen(nullptr)
+        mergeStrTables(false), rocmGotGen(nullptr), rocmRelaDynGen(nullptr)
 {
     std::unique_ptr<ROCmInput> _input(new ROCmInput{});
     _input->deviceType = deviceType;
@@ -2060,6 +3270,7 @@ ROCmBinGenerator::ROCmBinGenerator(GPUDeviceType deviceType,
     _input->metadataSize = 0;
     _input->metadata = nullptr;
     _input->useMetadataInfo = false;
+    _input->metadataMsgPack = false;
     _input->metadataInfo = ROCmMetadata{};
     input = _input.release();
 }
@@ -2068,7 +3279,7 @@ ROCmBinGenerator::ROCmBinGenerator(GPUDeviceType deviceType,
         uint32_t archMinor, uint32_t archStepping, size_t codeSize, const cxbyte* code,
         size_t globalDataSize, const cxbyte* globalData,
         std::vector<ROCmSymbolInput>&& symbols) :
-        rocmGotGen(nullptr), rocmRelaDynGen(nullptr)
+        mergeStrTables(false), rocmGotGen(nullptr), rocmRelaDynGen(nullptr)
 {
     std::unique_ptr<ROCmInput> _input(new ROCmInput{});
     _input->deviceType = deviceType;
@@ -2088,6 +3299,7 @@ ROCmBinGenerator::ROCmBinGenerator(GPUDeviceType deviceType,
     _input->metadataSize = 0;
     _input->metadata = nullptr;
     _input->useMetadataInfo = false;
+    _input->metadataMsgPack = false;
     _input->metadataInfo = ROCmMetadata{};
     input = _input.release();
 }
@@ -2178,6 +3390,7 @@ void ROCmBinGenerator::prepareBinaryGen()
     elfBinGen64.reset(new ElfBinaryGen64({ 0U, 0U, 0x40, 0, ET_DYN, 0xe0, EV_CURRENT,
             cxuint(input->newBinFormat ? execProgHeaderRegionIndex : UINT_MAX), 0, eflags },
             true, true, true, PHREGION_FILESTART));
+    elfBinGen64->setMergeStrTables(mergeStrTables);
     
     static const int32_t dynTags[] = {
         DT_SYMTAB, DT_SYMENT, DT_STRTAB, DT_STRSZ, DT_HASH };
@@ -2254,13 +3467,24 @@ void ROCmBinGenerator::prepareBinaryGen()
                         input->code + input->symbols[it->second].offset);
         }
         // just generate ROCm metadata from info
-        generateROCmMetadata(input->metadataInfo, kernelConfigPtrs.get(), metadataStr);
+        if (input->metadataMsgPack)
+            generateROCmMetadataMsgPack(input->metadataInfo, kernelConfigPtrs.get(),
+                        metadataStr);
+        else
+            generateROCmMetadata(input->metadataInfo, kernelConfigPtrs.get(),
+                        metadataStr);
         metadataSize = metadataStr.size();
         metadata = metadataStr.c_str();
     }
     
     if (metadataSize != 0)
-        elfBinGen64->addNote({"AMD", metadataSize, (const cxbyte*)metadata, 0xaU});
+    {
+        if (input->metadataMsgPack)
+            // NT_AMDGPU_METADATA note (code object v3)
+            elfBinGen64->addNote({"AMDGPU", metadataSize, (const cxbyte*)metadata, 32U});
+        else
+            elfBinGen64->addNote({"AMD", metadataSize, (const cxbyte*)metadata, 0xaU});
+    }
     
     /// region and sections
     elfBinGen64->addRegion(ElfRegion64::programHeaderTable());
@@ -2377,41 +3601,50 @@ void ROCmBinGenerator::updateSymbols()
 }
 
 void ROCmBinGenerator::generateInternal(std::ostream* osPtr, std::vector<char>* vPtr,
-             Array<cxbyte>* aPtr)
+             Array<cxbyte>* aPtr, cxuint threadsNum)
 {
     if (elfBinGen64 == nullptr)
         prepareBinaryGen();
     /****
      * prepare for write binary to output
      ****/
-    std::unique_ptr<std::ostream> outStreamHolder;
+    std::unique_ptr<FastOutputBuffer> outBufHolder;
     std::ostream* os = nullptr;
     if (aPtr != nullptr)
     {
+        // binary size is known, so write directly to array
         aPtr->resize(binarySize);
-        outStreamHolder.reset(
-                new ArrayOStream(binarySize, reinterpret_cast<char*>(aPtr->data())));
-        os = outStreamHolder.get();
+        if (threadsNum == 1)
+            outBufHolder.reset(new FastOutputBuffer(binarySize,
+                        reinterpret_cast<char*>(aPtr->data())));
     }
     else if (vPtr != nullptr)
     {
         vPtr->resize(binarySize);
-        outStreamHolder.reset(new VectorOStream(*vPtr));
-        os = outStreamHolder.get();
+        outBufHolder.reset(new FastOutputBuffer(binarySize, vPtr->data()));
     }
     else // from argument
+    {
         os = osPtr;
+        outBufHolder.reset(new FastOutputBuffer(256, *os));
+    }
     
-    const std::ios::iostate oldExceptions = os->exceptions();
+    const std::ios::iostate oldExceptions = (os != nullptr) ?
+                os->exceptions() : std::ios::goodbit;
     try
     {
-    os->exceptions(std::ios::failbit | std::ios::badbit);
+    if (os != nullptr)
+        os->exceptions(std::ios::failbit | std::ios::badbit);
     /****
      * write binary to output
      ****/
-    FastOutputBuffer bos(256, *os);
-    elfBinGen64->generate(bos);
-    assert(bos.getWritten() == binarySize);
+    if (outBufHolder != nullptr)
+    {
+        elfBinGen64->generate(*outBufHolder);
+        assert(outBufHolder->getWritten() == binarySize);
+    }
+    else // regions are written in parallel
+        elfBinGen64->generate(aPtr->data(), threadsNum);
     
     if (rocmGotGen != nullptr)
     {
@@ -2426,10 +3659,12 @@ void ROCmBinGenerator::generateInternal(std::ostream* osPtr, std::vector<char>*
     }
     catch(...)
     {
-        os->exceptions(oldExceptions);
+        if (os != nullptr)
+            os->exceptions(oldExceptions);
         throw;
     }
-    os->exceptions(oldExceptions);
+    if (os != nullptr)
+        os->exceptions(oldExceptions);
 }
 
 void ROCmBinGenerator::generate(Array<cxbyte>& array)
@@ -2437,6 +3672,11 @@ void ROCmBinGenerator::generate(Array<cxbyte>& array)
     generateInternal(nullptr, nullptr, &array);
 }
 
+void ROCmBinGenerator::generate(Array<cxbyte>& array, cxuint threadsNum)
+{
+    generateInternal(nullptr, nullptr, &array, threadsNum);
+}
+
 void ROCmBinGenerator::generate(std::ostream& os)
 {
     generateInternal(&os, nullptr, nullptr);
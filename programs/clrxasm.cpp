@@ -24,6 +24,7 @@
 #include <cstring>
 #include <CLRX/utils/Utilities.h>
 #include <CLRX/utils/CLIParser.h>
+#include <CLRX/utils/GPUId.h>
 #include <CLRX/amdbin/AmdBinaries.h>
 #include <CLRX/amdbin/GalliumBinaries.h>
 #include <CLRX/amdasm/Assembler.h>
@@ -53,6 +54,8 @@ static const CLIOption programOptions[] =
         "enable new ROCm binary format", nullptr },
     { "forceAddSymbols", 'S', CLIArgType::NONE, false, false,
         "force add symbols to binaries", nullptr },
+    { "mergeStrTabs", 0, CLIArgType::NONE, false, false,
+        "merge string tables in binaries (remove duplicates and merge tails)", nullptr },
     { "alternate", 'a', CLIArgType::NONE, false, false,
         "enable alternate macro mode", nullptr }, 
     { "buggyFPLit", 0, CLIArgType::NONE, false, false,
@@ -64,6 +67,24 @@ static const CLIOption programOptions[] =
     { "policy", 0, CLIArgType::UINT, false, false,
         "set policy version", "VERSION" },
     { "noWarnings", 'w', CLIArgType::NONE, false, false, "disable warnings", nullptr },
+    { "perfReport", 0, CLIArgType::NONE, false, false,
+        "print static performance estimation of code", nullptr },
+    { "allocRegs", 0, CLIArgType::NONE, false, false,
+        "allocate registers for register variables", nullptr },
+    { "autoWait", 0, CLIArgType::NONE, false, false,
+        "insert wait instructions automatically", nullptr },
+    { "latencyWait", 0, CLIArgType::NONE, false, false,
+        "move independent instructions before inserted wait instructions", nullptr },
+    { "domSSA", 0, CLIArgType::NONE, false, false,
+        "use dominator-based SSA construction in register allocation", nullptr },
+    { "dfLiveness", 0, CLIArgType::NONE, false, false,
+        "compute livenesses by dataflow analysis in register allocation", nullptr },
+    { "coalesce", 0, CLIArgType::NONE, false, false,
+        "coalesce copies of register variables in register allocation", nullptr },
+    { "targetOccupancy", 0, CLIArgType::UINT, false, false,
+        "set target occupancy (waves per SIMD) for register allocation", "WAVES" },
+    { "occupancyReport", 0, CLIArgType::NONE, false, false,
+        "print occupancy of kernels after register allocation", nullptr },
     CLRX_CLI_AUTOHELP
     { nullptr, 0 }
 };
@@ -137,6 +158,22 @@ try
         flags |= ASM_MACRONOCASE;
     if (cli.hasLongOption("oldModParam"))
         flags |= ASM_OLDMODPARAM;
+    if (cli.hasLongOption("perfReport"))
+        flags |= ASM_CODEANALYSIS;
+    if (cli.hasLongOption("allocRegs"))
+        flags |= ASM_ALLOCREGS;
+    if (cli.hasLongOption("autoWait"))
+        flags |= ASM_AUTOWAIT;
+    if (cli.hasLongOption("latencyWait"))
+        flags |= ASM_AUTOWAIT|ASM_LATENCYWAIT;
+    if (cli.hasLongOption("domSSA"))
+        flags |= ASM_DOMSSA;
+    if (cli.hasLongOption("dfLiveness"))
+        flags |= ASM_DFLIVENESS;
+    if (cli.hasLongOption("coalesce"))
+        flags |= ASM_COALESCE;
+    if (cli.hasLongOption("mergeStrTabs"))
+        flags |= ASM_MERGESTRTABS;
     if (cli.hasLongOption("newROCmBinFormat"))
         newROCmBinFormat = true;
     if (cli.hasLongOption("policy"))
@@ -161,6 +198,17 @@ try
     assembler->setNewROCmBinFormat(newROCmBinFormat);
     if (havePolicy)
         assembler->setPolicyVersion(policyVersion);
+    if (cli.hasLongOption("targetOccupancy"))
+    {
+        const cxuint waves = cli.getLongOptArg<cxuint>("targetOccupancy");
+        if (waves == 0 || waves > GPU_MAX_WAVES_PER_SIMD)
+        {
+            std::cerr << "Target occupancy out of range (1-" <<
+                    cxuint(GPU_MAX_WAVES_PER_SIMD) << ")" << std::endl;
+            return 1;
+        }
+        assembler->setTargetOccupancy(waves);
+    }
     
     size_t defSymsNum = 0;
     const char* const* defSyms = nullptr;
@@ -228,6 +276,14 @@ try
     if (cli.hasShortOption('o'))
         outputName = cli.getShortOptArg<const char*>('o');
     assembler->writeBinary(outputName);
+    if (cli.hasLongOption("perfReport"))
+    {
+        AsmPerfEstimator perfEstimator(*assembler);
+        perfEstimator.estimate();
+        perfEstimator.writeReport(std::cout);
+    }
+    if (cli.hasLongOption("occupancyReport"))
+        assembler->writeOccupancyReport(std::cout);
     return 0;
 }
 catch(const Exception& ex)
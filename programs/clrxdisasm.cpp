@@ -19,7 +19,11 @@
 
 #include <CLRX/Config.h>
 #include <iostream>
+#include <fstream>
+#include <cstring>
 #include <memory>
+#include <vector>
+#include <utility>
 #include <CLRX/utils/Utilities.h>
 #include <CLRX/utils/CLIParser.h>
 #include <CLRX/amdbin/AmdBinaries.h>
@@ -47,6 +51,8 @@ static const CLIOption programOptions[] =
     { "all", 'a', CLIArgType::NONE, false, false,
         "dump all (including hexcode and float literals)", nullptr },
     { "raw", 'r', CLIArgType::NONE, false, false, "treat input as raw GCN code", nullptr },
+    { "stream", 'S', CLIArgType::NONE, false, false,
+        "read raw GCN code in windows (for very large inputs)", nullptr },
     { "gpuType", 'g', CLIArgType::TRIMMED_STRING, false, false,
         "set GPU type for Gallium/raw binaries", "DEVICE" },
     { "arch", 'A', CLIArgType::TRIMMED_STRING, false, false,
@@ -57,10 +63,30 @@ static const CLIOption programOptions[] =
         "set LLVM version (for Gallium)", "VERSION" },
     { "buggyFPLit", 0, CLIArgType::NONE, false, false,
         "use old and buggy fplit rules", nullptr },
+    { "stats", 0, CLIArgType::TRIMMED_STRING, true, false,
+        "print code statistics instead disassembly (json or csv)", "FORMAT" },
     CLRX_CLI_AUTOHELP
     { nullptr, 0 }
 };
 
+enum class StatsFormat
+{
+    NONE = 0,
+    JSON,
+    CSV
+};
+
+// disassemble or collect code statistics (printed after all files)
+static void runDisassembler(Disassembler& disasm, StatsFormat statsFormat,
+            const char* fileName, std::vector<GCNFileCodeStats>& filesStats)
+{
+    if (statsFormat != StatsFormat::NONE)
+        filesStats.push_back(std::make_pair(CString(fileName),
+                    disasm.collectCodeStats()));
+    else
+        disasm.disassemble();
+}
+
 int main(int argc, const char** argv)
 try
 {
@@ -92,6 +118,7 @@ try
     
     GPUDeviceType gpuDeviceType = GPUDeviceType::CAPE_VERDE;
     const bool fromRawCode = cli.hasShortOption('r');
+    const bool rawCodeStream = cli.hasShortOption('S');
     if (cli.hasShortOption('g'))
         gpuDeviceType = getGPUDeviceTypeFromName(cli.getShortOptArg<const char*>('g'));
     else if (cli.hasShortOption('A'))
@@ -105,15 +132,47 @@ try
     if (cli.hasLongOption("llvmVersion"))
         llvmVersion = cli.getLongOptArg<cxuint>("llvmVersion");
     
+    StatsFormat statsFormat = StatsFormat::NONE;
+    if (cli.hasLongOption("stats"))
+    {
+        statsFormat = StatsFormat::JSON;
+        if (cli.hasLongOptArg("stats"))
+        {
+            const char* format = cli.getLongOptArg<const char*>("stats");
+            if (::strcmp(format, "csv") == 0)
+                statsFormat = StatsFormat::CSV;
+            else if (::strcmp(format, "json") != 0)
+            {
+                std::cerr << "Unknown statistics format '" << format << "'" << std::endl;
+                return 1;
+            }
+        }
+    }
+    
     int ret = 0;
+    std::vector<GCNFileCodeStats> filesStats;
     for (const char* const* args = cli.getArgs();*args != nullptr; args++)
     {
-        std::cout << "/* Disassembling '" << *args << "\' */" << std::endl;
-        Array<cxbyte> binaryData;
+        if (statsFormat == StatsFormat::NONE)
+            std::cout << "/* Disassembling '" << *args << "\' */" << std::endl;
+        // binary file must be destroyed after binary object
+        std::unique_ptr<MappedFile> binaryFile;
         std::unique_ptr<AmdMainBinaryBase> base = nullptr;
         try
         {
-            binaryData = loadDataFromFile(*args);
+            if (fromRawCode && rawCodeStream)
+            {
+                /* raw binaries read from stream */
+                std::ifstream ifs(*args, std::ios::binary);
+                if (!ifs)
+                    throw Exception("Can't open file");
+                Disassembler disasm(gpuDeviceType, ifs, std::cout, disasmFlags);
+                runDisassembler(disasm, statsFormat, *args, filesStats);
+                continue;
+            }
+            binaryFile.reset(new MappedFile(*args));
+            const size_t binarySize = binaryFile->size();
+            cxbyte* binaryCode = binaryFile->data();
             
             if (!fromRawCode)
             {
@@ -128,43 +187,43 @@ try
                 if ((disasmFlags & (DISASM_METADATA|DISASM_CONFIG)) != 0)
                     binFlags |= AMDBIN_CREATE_INFOSTRINGS;
                 
-                if (isAmdBinary(binaryData.size(), binaryData.data()))
+                if (isAmdBinary(binarySize, binaryCode))
                 {
                     // if amd binary
-                    base.reset(createAmdBinaryFromCode(binaryData.size(),
-                            binaryData.data(), binFlags));
+                    base.reset(createAmdBinaryFromCode(binarySize,
+                            binaryCode, binFlags));
                     if (base->getType() == AmdMainType::GPU_BINARY)
                     {
                         AmdMainGPUBinary32* amdGpuBin =
                                 static_cast<AmdMainGPUBinary32*>(base.get());
                         Disassembler disasm(*amdGpuBin, std::cout, disasmFlags);
-                        disasm.disassemble();
+                        runDisassembler(disasm, statsFormat, *args, filesStats);
                     }
                     else if (base->getType() == AmdMainType::GPU_64_BINARY)
                     {
                         AmdMainGPUBinary64* amdGpuBin =
                                 static_cast<AmdMainGPUBinary64*>(base.get());
                         Disassembler disasm(*amdGpuBin, std::cout, disasmFlags);
-                        disasm.disassemble();
+                        runDisassembler(disasm, statsFormat, *args, filesStats);
                     }
                     else
                         throw Exception("This is not AMDGPU binary file!");
                 }
-                else if (isAmdCL2Binary(binaryData.size(), binaryData.data()))
+                else if (isAmdCL2Binary(binarySize, binaryCode))
                 {   // AMD OpenCL 2.0 binary
                     // extra (extra data) flags for OpenCL 2.0 disassembler
                     binFlags |= AMDCL2BIN_INNER_CREATE_KERNELDATA |
                                 AMDCL2BIN_INNER_CREATE_KERNELDATAMAP |
                                 AMDCL2BIN_INNER_CREATE_KERNELSTUBS;
-                    base.reset(createAmdCL2BinaryFromCode(binaryData.size(),
-                                           binaryData.data(), binFlags));
+                    base.reset(createAmdCL2BinaryFromCode(binarySize,
+                                           binaryCode, binFlags));
                     if (base->getType() == AmdMainType::GPU_CL2_BINARY)
                     {
                         AmdCL2MainGPUBinary32* amdGpuBin =
                                 static_cast<AmdCL2MainGPUBinary32*>(base.get());
                         Disassembler disasm(*amdGpuBin, std::cout, disasmFlags,
                                             driverVersion);
-                        disasm.disassemble();
+                        runDisassembler(disasm, statsFormat, *args, filesStats);
                     }
                     else if (base->getType() == AmdMainType::GPU_CL2_64_BINARY)
                     {
@@ -172,43 +231,49 @@ try
                                 static_cast<AmdCL2MainGPUBinary64*>(base.get());
                         Disassembler disasm(*amdGpuBin, std::cout, disasmFlags,
                                             driverVersion);
-                        disasm.disassemble();
+                        runDisassembler(disasm, statsFormat, *args, filesStats);
                     }
                     else
                         throw Exception("This is not AMDGPU binary file!");
                 }
-                else if (isROCmBinary(binaryData.size(), binaryData.data()))
+                else if (isROCmBinary(binarySize, binaryCode))
                 {
                     // ROCm binary
-                    ROCmBinary rocmBin(binaryData.size(), binaryData.data(), 0);
+                    ROCmBinary rocmBin(*binaryFile, 0);
                     Disassembler disasm(rocmBin, std::cout, disasmFlags);
-                    disasm.disassemble();
+                    runDisassembler(disasm, statsFormat, *args, filesStats);
                 }
                 else
                 {
                     // if gallium binary
-                    GalliumBinary galliumBin(binaryData.size(),binaryData.data(), 0);
+                    GalliumBinary galliumBin(*binaryFile, 0);
                     Disassembler disasm(gpuDeviceType, galliumBin, std::cout,
                             disasmFlags, llvmVersion);
-                    disasm.disassemble();
+                    runDisassembler(disasm, statsFormat, *args, filesStats);
                 }
             }
             else
             {
                 /* raw binaries */
-                Disassembler disasm(gpuDeviceType, binaryData.size(), binaryData.data(),
+                Disassembler disasm(gpuDeviceType, binarySize, binaryCode,
                         std::cout, disasmFlags);
-                disasm.disassemble();
+                runDisassembler(disasm, statsFormat, *args, filesStats);
             }
         }
         catch(const std::exception& ex)
         {
             ret = 1;
-            std::cout << "/* ERROR for '" << *args << "\' */" << std::endl;
+            if (statsFormat == StatsFormat::NONE)
+                std::cout << "/* ERROR for '" << *args << "\' */" << std::endl;
             std::cerr << "Error during disassemblying '" << *args << "': " <<
                     ex.what() << std::endl;
         }
     }
+    // statistics from all files in single document
+    if (statsFormat == StatsFormat::JSON)
+        writeGCNCodeStatsJSON(std::cout, filesStats);
+    else if (statsFormat == StatsFormat::CSV)
+        writeGCNCodeStatsCSV(std::cout, filesStats);
     
     return ret;
 }
@@ -0,0 +1,505 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <CLRX/Config.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <CLRX/utils/Utilities.h>
+#include <CLRX/utils/MemAccess.h>
+#include <CLRX/amdasm/Assembler.h>
+#include "../TestUtils.h"
+
+using namespace CLRX;
+
+struct AutoWaitTestCase
+{
+    const char* input;
+    Flags flags;
+    std::vector<uint32_t> code;
+    // expected values of labels
+    std::vector<std::pair<const char*, uint64_t> > labels;
+    bool good;
+    const char* errorMessages;
+};
+
+static const AutoWaitTestCase autoWaitTestCasesTbl[] =
+{
+    {   /* 0 - allocation only */
+        R"ffDXD(.gpu Fiji
+.rawcode
+    .regvar sa:s:8, va:v:8
+    s_mov_b32 sa[2], s4
+    s_mov_b32 sa[3], s5
+    s_load_dwordx2 sa[0:1], sa[2:3], 0
+    v_mov_b32 va[0], v1
+    v_add_f32 va[1], sa[0], va[0]
+    s_endpgm
+)ffDXD", ASM_ALLOCREGS,
+        { 0xbe800004U, 0xbe810005U, 0xc0060000U, 0x00000000U, 0x7e000301U,
+          0x02000000U, 0xbf810000U },
+        { }, true, ""
+    },
+    {   /* 1 - wait for scalar load */
+        R"ffDXD(.gpu Fiji
+.rawcode
+    .regvar sa:s:8, va:v:8
+    s_mov_b32 sa[2], s4
+    s_mov_b32 sa[3], s5
+    s_load_dwordx2 sa[0:1], sa[2:3], 0
+    v_mov_b32 va[0], v1
+    v_add_f32 va[1], sa[0], va[0]
+    s_endpgm
+)ffDXD", ASM_AUTOWAIT,
+        { 0xbe800004U, 0xbe810005U, 0xc0060000U, 0x00000000U, 0x7e000301U,
+          0xbf8c007fU, 0x02000000U, 0xbf810000U },
+        { }, true, ""
+    },
+    {   /* 2 - waits after joining ways, jumps and labels must be moved */
+        R"ffDXD(.gpu Fiji
+.rawcode
+    .regvar sa:s:8, va:v:8, vb:v:4
+    s_mov_b32 sa[2], s4
+    s_mov_b32 sa[3], s5
+    s_load_dwordx2 sa[0:1], sa[2:3], 0
+    v_mov_b32 va[0], v1
+    s_cmp_eq_u32 s6, 0
+    s_cbranch_scc1 skip
+    buffer_load_dword vb[0], va[0], s[8:11], 0 offen
+    buffer_load_dword vb[1], va[0], s[8:11], 0 offen
+    v_mov_b32 vb[2], 1.0
+    s_branch join
+skip:
+    v_mov_b32 vb[0], 0
+    v_mov_b32 vb[1], 0
+    v_mov_b32 vb[2], 1.0
+join:
+    v_add_f32 va[1], vb[0], vb[2]
+    v_add_f32 va[2], vb[1], va[1]
+    v_add_f32 va[1], sa[0], va[2]
+    buffer_store_dword va[1], va[0], s[8:11], 0 offen
+    s_endpgm
+)ffDXD", ASM_AUTOWAIT,
+        { 0xbe800004U, 0xbe810005U, 0xc0060000U, 0x00000000U, 0x7e000301U,
+          0xbf068006U, 0xbf850006U, 0xe0501000U, 0x80020200U, 0xe0501000U,
+          0x80020100U, 0x7e0602f2U, 0xbf820003U, 0x7e040280U, 0x7e020280U,
+          0x7e0602f2U, 0xbf8c0f71U, 0x02040702U, 0xbf8c0f70U, 0x02020501U,
+          0xbf8c007fU, 0x02020200U, 0xe0701000U, 0x80020100U, 0xbf810000U },
+        { { "skip", 0x34 }, { "join", 0x40 } }, true, ""
+    },
+    {   /* 3 - replace user wait instruction */
+        R"ffDXD(.gpu Fiji
+.rawcode
+    .regvar va:v:4
+    buffer_load_dword va[0], v1, s[8:11], 0 offen
+    s_load_dword s12, s[4:5], 0
+    s_waitcnt lgkmcnt(0)
+    v_mov_b32 va[1], s12
+    v_add_f32 va[2], va[0], va[1]
+    buffer_store_dword va[2], v1, s[8:11], 0 offen
+    s_endpgm
+)ffDXD", ASM_AUTOWAIT,
+        { 0xe0501000U, 0x80020001U, 0xc0020302U, 0x00000000U, 0xbf8c0070U,
+          0x7e04020cU, 0x02000500U, 0xe0701000U, 0x80020001U, 0xbf810000U },
+        { }, true, ""
+    },
+    {   /* 4 - target occupancy can not be reached */
+        R"ffDXD(.gpu Fiji
+.rawcode
+.target_occupancy 10
+    .regvar va:v:28
+    buffer_load_dwordx4 va[0:3], v0, s[8:11], 0 offen
+    buffer_load_dwordx4 va[4:7], v0, s[8:11], 0 offen
+    buffer_load_dwordx4 va[8:11], v0, s[8:11], 0 offen
+    buffer_load_dwordx4 va[12:15], v0, s[8:11], 0 offen
+    buffer_load_dwordx4 va[16:19], v0, s[8:11], 0 offen
+    buffer_load_dwordx4 va[20:23], v0, s[8:11], 0 offen
+    buffer_load_dwordx4 va[24:27], v0, s[8:11], 0 offen
+    buffer_store_dwordx4 va[0:3], v0, s[8:11], 0 offen
+    buffer_store_dwordx4 va[4:7], v0, s[8:11], 0 offen
+    buffer_store_dwordx4 va[8:11], v0, s[8:11], 0 offen
+    buffer_store_dwordx4 va[12:15], v0, s[8:11], 0 offen
+    buffer_store_dwordx4 va[16:19], v0, s[8:11], 0 offen
+    buffer_store_dwordx4 va[20:23], v0, s[8:11], 0 offen
+    buffer_store_dwordx4 va[24:27], v0, s[8:11], 0 offen
+    s_endpgm
+)ffDXD", ASM_ALLOCREGS,
+        { 0xe05c1000U, 0x80020100U, 0xe05c1000U, 0x80020500U, 0xe05c1000U,
+          0x80020900U, 0xe05c1000U, 0x80020d00U, 0xe05c1000U, 0x80021100U,
+          0xe05c1000U, 0x80021500U, 0xe05c1000U, 0x80021900U, 0xe07c1000U,
+          0x80020100U, 0xe07c1000U, 0x80020500U, 0xe07c1000U, 0x80020900U,
+          0xe07c1000U, 0x80020d00U, 0xe07c1000U, 0x80021100U, 0xe07c1000U,
+          0x80021500U, 0xe07c1000U, 0x80021900U, 0xbf810000U },
+        { }, true, "test.s:5:5: Warning: Target occupancy 10 can't be reached, "
+        "too many VGPRs are needed\n"
+    },
+    {   /* 5 - wrong target occupancy */
+        R"ffDXD(.gpu Fiji
+.rawcode
+.target_occupancy 11
+.target_occupancy 0
+    s_endpgm
+)ffDXD", ASM_ALLOCREGS, { }, { }, false,
+        "test.s:3:19: Error: Target occupancy out of range (1-10)\n"
+        "test.s:4:19: Error: Target occupancy out of range (1-10)\n"
+    },
+    {   /* 6 - SSA data created by dominators */
+        R"ffDXD(.gpu Fiji
+.rawcode
+    .regvar sa:s:8, va:v:8, vb:v:4
+    s_mov_b32 sa[2], s4
+    s_mov_b32 sa[3], s5
+    s_load_dwordx2 sa[0:1], sa[2:3], 0
+    v_mov_b32 va[0], v1
+    s_cmp_eq_u32 s6, 0
+    s_cbranch_scc1 skip
+    buffer_load_dword vb[0], va[0], s[8:11], 0 offen
+    buffer_load_dword vb[1], va[0], s[8:11], 0 offen
+    v_mov_b32 vb[2], 1.0
+    s_branch join
+skip:
+    v_mov_b32 vb[0], 0
+    v_mov_b32 vb[1], 0
+    v_mov_b32 vb[2], 1.0
+join:
+    v_add_f32 va[1], vb[0], vb[2]
+    v_add_f32 va[2], vb[1], va[1]
+    v_add_f32 va[1], sa[0], va[2]
+    buffer_store_dword va[1], va[0], s[8:11], 0 offen
+    s_endpgm
+)ffDXD", ASM_AUTOWAIT|ASM_DOMSSA,
+        { 0xbe800004U, 0xbe810005U, 0xc0060000U, 0x00000000U, 0x7e000301U,
+          0xbf068006U, 0xbf850006U, 0xe0501000U, 0x80020200U, 0xe0501000U,
+          0x80020100U, 0x7e0602f2U, 0xbf820003U, 0x7e040280U, 0x7e020280U,
+          0x7e0602f2U, 0xbf8c0f71U, 0x02040702U, 0xbf8c0f70U, 0x02020501U,
+          0xbf8c007fU, 0x02020200U, 0xe0701000U, 0x80020100U, 0xbf810000U },
+        { { "skip", 0x34 }, { "join", 0x40 } }, true, ""
+    },
+    {   /* 7 - livenesses created by dataflow analysis */
+        R"ffDXD(.gpu Fiji
+.rawcode
+    .regvar sa:s:8, va:v:8, vb:v:4
+    s_mov_b32 sa[2], s4
+    s_mov_b32 sa[3], s5
+    s_load_dwordx2 sa[0:1], sa[2:3], 0
+    v_mov_b32 va[0], v1
+    s_cmp_eq_u32 s6, 0
+    s_cbranch_scc1 skip
+    buffer_load_dword vb[0], va[0], s[8:11], 0 offen
+    buffer_load_dword vb[1], va[0], s[8:11], 0 offen
+    v_mov_b32 vb[2], 1.0
+    s_branch join
+skip:
+    v_mov_b32 vb[0], 0
+    v_mov_b32 vb[1], 0
+    v_mov_b32 vb[2], 1.0
+join:
+    v_add_f32 va[1], vb[0], vb[2]
+    v_add_f32 va[2], vb[1], va[1]
+    v_add_f32 va[1], sa[0], va[2]
+    buffer_store_dword va[1], va[0], s[8:11], 0 offen
+    s_endpgm
+)ffDXD", ASM_AUTOWAIT|ASM_DFLIVENESS,
+        { 0xbe800004U, 0xbe810005U, 0xc0060000U, 0x00000000U, 0x7e000301U,
+          0xbf068006U, 0xbf850006U, 0xe0501000U, 0x80020200U, 0xe0501000U,
+          0x80020100U, 0x7e0602f2U, 0xbf820003U, 0x7e040280U, 0x7e020280U,
+          0x7e0602f2U, 0xbf8c0f71U, 0x02040702U, 0xbf8c0f70U, 0x02020501U,
+          0xbf8c007fU, 0x02020200U, 0xe0701000U, 0x80020100U, 0xbf810000U },
+        { { "skip", 0x34 }, { "join", 0x40 } }, true, ""
+    },
+    {   /* 8 - independent instructions moved before wait (to scalar instruction) */
+        R"ffDXD(.gpu Fiji
+.rawcode
+    .regvar va:v:4
+    buffer_load_dword va[0], v1, s[8:11], 0 offen
+    v_add_f32 va[1], va[0], v2
+    v_mul_f32 v10, v3, v4
+    v_mul_f32 v11, v5, v10
+after:
+    v_mul_f32 v12, v7, va[1]
+    s_mov_b32 s20, s21
+    v_mul_f32 v13, v7, v8
+    buffer_store_dword va[1], v1, s[8:11], 0 offen
+    s_endpgm
+)ffDXD", ASM_AUTOWAIT|ASM_LATENCYWAIT,
+        { 0xe0501000U, 0x80020001U, 0x0a140903U, 0x0a161505U, 0xbf8c0f70U,
+          0x02000500U, 0x0a180107U, 0xbe940015U, 0x0a1a1107U, 0xe0701000U,
+          0x80020001U, 0xbf810000U },
+        { { "after", 0x18 } }, true, ""
+    },
+    {   /* 9 - instruction that uses result of pending load is not moved */
+        R"ffDXD(.gpu Fiji
+.rawcode
+    .regvar va:v:4
+    buffer_load_dword va[0], v1, s[8:11], 0 offen
+    buffer_load_dword va[2], v1, s[8:11], 0 offen offset:4
+    v_add_f32 va[1], va[0], v2
+    v_mul_f32 v10, va[2], v4
+    v_mul_f32 v11, v5, v6
+    v_add_f32 va[1], va[1], v10
+    buffer_store_dword va[1], v1, s[8:11], 0 offen
+    s_endpgm
+)ffDXD", ASM_AUTOWAIT|ASM_LATENCYWAIT,
+        { 0xe0501000U, 0x80020001U, 0xe0501004U, 0x80020301U, 0x0a160d05U,
+          0xbf8c0f71U, 0x02000500U, 0xbf8c0f70U, 0x0a140903U, 0x02001500U,
+          0xe0701000U, 0x80020001U, 0xbf810000U },
+        { }, true, ""
+    },
+    {   /* 10 - values from labels around inserted wait instruction */
+        R"ffDXD(.gpu Fiji
+.rawcode
+    .regvar va:v:4
+l1:
+    buffer_load_dword va[0], v1, s[8:11], 0 offen
+    v_add_f32 va[1], va[0], v2
+l2:
+    s_mov_b32 s0, l2-l1
+    s_mov_b32 s1, l4-l3
+l3:
+    buffer_store_dword va[1], v1, s[8:11], 0 offen
+l4:
+    s_endpgm
+)ffDXD", ASM_AUTOWAIT, { }, { }, false,
+        "test.s:8:19: Error: Value computed from labels is changed by "
+        "inserted or removed code\n"
+    },
+    {   /* 11 - values from labels after inserted wait instruction */
+        R"ffDXD(.gpu Fiji
+.rawcode
+    .regvar va:v:4
+    buffer_load_dword va[0], v1, s[8:11], 0 offen
+    v_add_f32 va[1], va[0], v2
+l1:
+    s_mov_b32 s0, l2-l1
+l2:
+    buffer_store_dword va[1], v1, s[8:11], 0 offen
+    s_endpgm
+)ffDXD", ASM_AUTOWAIT,
+        { 0xe0501000U, 0x80020001U, 0xbf8c0f70U, 0x02000500U, 0xbe8000ffU,
+          0x00000008U, 0xe0701000U, 0x80020001U, 0xbf810000U },
+        { { "l1", 0x10 }, { "l2", 0x18 } }, true, ""
+    },
+    {   /* 12 - VCC writer is not moved across V_DIV_FMAS (implicit VCC read) */
+        R"ffDXD(.gpu Fiji
+.rawcode
+    .regvar va:v:4
+    buffer_load_dword va[0], v1, s[8:11], 0 offen
+    v_add_f32 va[1], va[0], v2
+    v_div_fmas_f32 v5, v6, v7, v8
+    v_add_u32 v9, vcc, v10, v11
+    buffer_store_dword va[1], v1, s[8:11], 0 offen
+    s_endpgm
+)ffDXD", ASM_AUTOWAIT|ASM_LATENCYWAIT,
+        { 0xe0501000U, 0x80020001U, 0xbf8c0f70U, 0x02000500U, 0xd1e20005U,
+          0x04220f06U, 0x3212170aU, 0xe0701000U, 0x80020001U, 0xbf810000U },
+        { }, true, ""
+    },
+    {   /* 13 - instruction between VALU write and DPP read is not moved (hazard) */
+        R"ffDXD(.gpu Fiji
+.rawcode
+    .regvar va:v:4
+    buffer_load_dword va[0], v1, s[8:11], 0 offen
+    v_add_f32 va[1], va[0], v2
+    v_mul_f32 v10, va[1], v4
+    v_mul_f32 v11, v5, v6
+    v_mov_b32 v12, v10 quad_perm:[1,0,3,2]
+    buffer_store_dword va[1], v1, s[8:11], 0 offen
+    s_endpgm
+)ffDXD", ASM_AUTOWAIT|ASM_LATENCYWAIT,
+        { 0xe0501000U, 0x80020001U, 0xbf8c0f70U, 0x02000500U, 0x0a140900U,
+          0x0a160d05U, 0x7e1802faU, 0xff00b10aU, 0xe0701000U, 0x80020001U,
+          0xbf810000U },
+        { }, true, ""
+    }
+};
+
+static void testAutoWaitCase(cxuint testId, const AutoWaitTestCase& testCase)
+{
+    std::istringstream input(testCase.input);
+    std::ostringstream errorStream;
+
+    Assembler assembler("test.s", input, (ASM_ALL&~ASM_ALTMACRO) | testCase.flags,
+                    BinaryFormat::RAWCODE, GPUDeviceType::CAPE_VERDE, errorStream);
+    bool good = assembler.assemble();
+    std::ostringstream oss;
+    oss << "testAutoWait#" << testId;
+    const std::string testCaseName = oss.str();
+    assertValue("testAutoWait", testCaseName+".good", testCase.good, good);
+    if (testCase.errorMessages != nullptr)
+        assertString("testAutoWait", testCaseName+".errorMessages",
+                testCase.errorMessages, errorStream.str());
+    if (!testCase.good)
+        return;
+
+    const std::vector<cxbyte>& content = assembler.getSections()[0].content;
+    assertValue("testAutoWait", testCaseName+".size", testCase.code.size()*4,
+                content.size());
+    for (size_t i = 0; i < testCase.code.size(); i++)
+    {
+        std::ostringstream wOss;
+        wOss << testCaseName << ".word#" << i;
+        assertValue("testAutoWait", wOss.str(), testCase.code[i],
+                    ULEV(reinterpret_cast<const uint32_t*>(content.data())[i]));
+    }
+    for (const auto& label: testCase.labels)
+    {
+        auto it = assembler.getSymbolMap().find(label.first);
+        assertTrue("testAutoWait", testCaseName+".label."+label.first,
+                   it != assembler.getSymbolMap().end());
+        assertValue("testAutoWait", testCaseName+".label."+label.first+".value",
+                    label.second, it->second.value);
+    }
+}
+
+// first code and code with replaced load in second block (this same code structure)
+static const char* rescheduleCodesTbl[2] =
+{
+    R"ffDXD(.gpu Fiji
+.rawcode
+    s_load_dword s2, s[0:1], 0
+    s_cmp_eq_u32 s4, 0
+    s_cbranch_scc0 b2
+    s_add_u32 s5, s2, s5
+    s_load_dword s8, s[0:1], 4
+b2: s_add_u32 s6, s5, s6
+    s_add_u32 s7, s8, s7
+    s_endpgm
+)ffDXD",
+    R"ffDXD(.gpu Fiji
+.rawcode
+    s_load_dword s2, s[0:1], 0
+    s_cmp_eq_u32 s4, 0
+    s_cbranch_scc0 b2
+    s_add_u32 s5, s2, s5
+    s_mov_b32 s8, s9
+    s_nop 0
+b2: s_add_u32 s6, s5, s6
+    s_add_u32 s7, s8, s7
+    s_endpgm
+)ffDXD"
+};
+
+static void checkWaitInstrs(const std::string& testName,
+            const std::vector<AsmWaitInstr>& expected,
+            const std::vector<AsmWaitInstr>& result)
+{
+    assertValue("testReschedule", testName+".size", expected.size(), result.size());
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+        std::ostringstream wOss;
+        wOss << testName << ".wait#" << i;
+        assertValue("testReschedule", wOss.str()+".offset", expected[i].offset,
+                    result[i].offset);
+        for (cxuint q = 0; q < ASM_WAIT_MAX_TYPES_NUM; q++)
+        {
+            std::ostringstream qOss;
+            qOss << wOss.str() << ".waits#" << q;
+            assertValue("testReschedule", qOss.str(), expected[i].waits[q],
+                    result[i].waits[q]);
+        }
+    }
+}
+
+// incremental wait scheduling must give this same result as full scheduling
+static void testReschedule()
+{
+    std::unique_ptr<Assembler> assemblers[2];
+    std::unique_ptr<AsmRegAllocator> regAllocs[2];
+    std::ostringstream errorStream;
+    for (cxuint i = 0; i < 2; i++)
+    {
+        std::istringstream input(rescheduleCodesTbl[i]);
+        assemblers[i].reset(new Assembler("test.s", input,
+                    (ASM_ALL&~ASM_ALTMACRO) | ASM_TESTRUN | ASM_TESTRESOLVE,
+                    BinaryFormat::RAWCODE, GPUDeviceType::CAPE_VERDE, errorStream));
+        assertTrue("testReschedule", "good", assemblers[i]->assemble());
+        regAllocs[i].reset(new AsmRegAllocator(*assemblers[i]));
+        regAllocs[i]->allocateRegisters(0);
+    }
+    const AsmWaitConfig& waitConfig = assemblers[0]->getISAAssembler()->getWaitConfig();
+    const AsmSection& section0 = assemblers[0]->getSections()[0];
+    const AsmSection& section1 = assemblers[1]->getSections()[0];
+    // changed load instruction
+    const size_t changedOffset = 0x14;
+    
+    // expected waits: full scheduling of changed code
+    AsmWaitScheduler fullScheduler(waitConfig, *assemblers[1],
+            regAllocs[1]->getCodeBlocks(), regAllocs[1]->getVregIndexMaps(),
+            regAllocs[1]->getGraphColorMaps(), false);
+    fullScheduler.schedule(*section1.usageHandler, *section1.waitHandler);
+    const std::vector<AsmWaitInstr> expected = fullScheduler.getNeededWaitInstrs();
+    const size_t blocksNum = regAllocs[1]->getCodeBlocks().size();
+    assertValue("testReschedule", "blocksNum", size_t(3), blocksNum);
+    assertValue("testReschedule", "full.processed", blocksNum,
+                fullScheduler.getProcessedBlocksNum());
+    
+    std::vector<AsmRegAllocator::CodeBlock> codeBlocks = regAllocs[0]->getCodeBlocks();
+    AsmWaitScheduler scheduler(waitConfig, *assemblers[0], codeBlocks,
+            regAllocs[0]->getVregIndexMaps(), regAllocs[0]->getGraphColorMaps(), false);
+    scheduler.schedule(*section0.usageHandler, *section0.waitHandler);
+    assertValue("testReschedule", "first.waitsNum", expected.size()+1,
+                scheduler.getNeededWaitInstrs().size());
+    // change code: first block is not processed again
+    codeBlocks = regAllocs[1]->getCodeBlocks();
+    scheduler.reschedule(*section1.usageHandler, *section1.waitHandler,
+                changedOffset, changedOffset+8);
+    checkWaitInstrs("changed", expected, scheduler.getNeededWaitInstrs());
+    assertValue("testReschedule", "changed.processed", size_t(2),
+                scheduler.getProcessedBlocksNum());
+    // second block without change: state at start of last block is not changed
+    scheduler.reschedule(*section1.usageHandler, *section1.waitHandler,
+                changedOffset, changedOffset+8);
+    checkWaitInstrs("samestate", expected, scheduler.getNeededWaitInstrs());
+    assertValue("testReschedule", "samestate.processed", size_t(1),
+                scheduler.getProcessedBlocksNum());
+    // change in last block
+    scheduler.reschedule(*section1.usageHandler, *section1.waitHandler,
+                changedOffset+8, changedOffset+12);
+    checkWaitInstrs("last", expected, scheduler.getNeededWaitInstrs());
+    assertValue("testReschedule", "last.processed", size_t(1),
+                scheduler.getProcessedBlocksNum());
+    // no change
+    scheduler.reschedule(*section1.usageHandler, *section1.waitHandler, 0, 0);
+    checkWaitInstrs("nochange", expected, scheduler.getNeededWaitInstrs());
+    assertValue("testReschedule", "nochange.processed", size_t(0),
+                scheduler.getProcessedBlocksNum());
+}
+
+int main(int argc, const char** argv)
+{
+    int retVal = 0;
+    for (size_t i = 0; i < sizeof(autoWaitTestCasesTbl)/sizeof(AutoWaitTestCase); i++)
+        try
+        { testAutoWaitCase(i, autoWaitTestCasesTbl[i]); }
+        catch(const std::exception& ex)
+        {
+            std::cerr << ex.what() << std::endl;
+            retVal = 1;
+        }
+    try
+    { testReschedule(); }
+    catch(const std::exception& ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        retVal = 1;
+    }
+    return retVal;
+}
@@ -0,0 +1,241 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <CLRX/Config.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <CLRX/utils/Utilities.h>
+#include <CLRX/utils/MemAccess.h>
+#include <CLRX/amdasm/Assembler.h>
+#include "../TestUtils.h"
+
+using namespace CLRX;
+
+typedef AsmRegAllocator::InterGraph InterGraph;
+typedef AsmRegAllocator::CopyInstr CopyInstr;
+
+struct CoalesceTestCase
+{
+    const char* input;
+    Flags flags;    // additional assembler flags
+    size_t coalescedNum;    // number of copies with coalesced nodes
+    std::vector<uint32_t> words;    // code after allocation
+};
+
+static const CoalesceTestCase coalesceTestCasesTbl[] =
+{
+    {   /* 0 - copy va[3]=va[4] gets this same register only after coalescing */
+        R"ffDXD(.gpu Fiji
+.rawcode
+    .regvar va:v:6
+    v_mov_b32 va[0], v1
+    v_mov_b32 va[1], v2
+    v_mov_b32 va[2], v3
+    v_add_f32 va[5], va[2], va[0]
+    v_add_f32 va[0], va[2], va[2]
+    v_add_f32 va[4], va[2], va[0]
+    v_mov_b32 va[3], va[4]
+    v_mov_b32 va[1], va[2]
+    v_mov_b32 va[4], va[0]
+    v_add_f32 va[5], va[0], va[5]
+    v_add_f32 v10, v10, va[0]
+    v_add_f32 v10, v10, va[1]
+    v_add_f32 v10, v10, va[2]
+    v_add_f32 v10, v10, va[5]
+    v_add_f32 v10, v10, va[4]
+    v_add_f32 v10, v10, va[3]
+    s_endpgm
+)ffDXD", 0, 1,
+        { 0x7e000301U, 0x7e020302U, 0x7e020303U, 0x020a0101U, 0x02000301U,
+          0x02060101U, 0x7e040301U, 0x7e080300U, 0x020a0b00U, 0x0214010aU,
+          0x0214050aU, 0x0214030aU, 0x02140b0aU, 0x0214090aU, 0x0214070aU,
+          0xbf810000U }
+    },
+    {   /* 1 - copies in loop, backward jump must be encoded again */
+        R"ffDXD(.gpu Fiji
+.rawcode
+    .regvar va:v:4, sa:s:4
+    v_mov_b32 va[0], v1
+    v_mov_b32 va[1], va[0]
+    s_mov_b32 sa[0], s2
+    s_mov_b32 sa[1], sa[0]
+loop:
+    v_add_f32 va[2], va[1], 1.0
+    v_mov_b32 va[1], va[2]
+    s_sub_u32 sa[1], sa[1], 1
+    s_cmp_eq_u32 sa[1], 0
+    s_cbranch_scc0 loop
+    v_mov_b32 v3, va[1]
+    s_endpgm
+)ffDXD", 0, 3,
+        { 0x7e000301U, 0xbe800002U, 0xd1010000U, 0x0001e500U, 0x80808100U,
+          0xbf068000U, 0xbf84fffbU, 0x7e060300U, 0xbf810000U }
+    },
+    {   /* 2 - copies with inserted waits */
+        R"ffDXD(.gpu Fiji
+.rawcode
+    .regvar sa:s:4, va:v:4
+    s_load_dword sa[0], s[0:1], 0
+    s_mov_b32 sa[1], sa[0]
+    s_add_u32 sa[2], sa[1], s4
+    v_mov_b32 va[0], sa[2]
+    buffer_load_dword va[1], v0, s[8:11], 0 offen
+    v_mov_b32 va[2], va[1]
+    v_add_f32 va[3], va[2], va[0]
+    v_mov_b32 va[0], va[3]
+    buffer_store_dword va[0], v0, s[8:11], 0 offen
+    s_endpgm
+)ffDXD", ASM_AUTOWAIT, 3,
+        { 0xc0020000U, 0x00000000U, 0xbf8c007fU, 0x80000400U, 0x7e020200U,
+          0xe0501000U, 0x80020200U, 0xbf8c0f70U, 0x02020302U, 0xe0701000U,
+          0x80020100U, 0xbf810000U }
+    }
+};
+
+static void testCoalesceCase(cxuint testId, const CoalesceTestCase& testCase)
+{
+    std::ostringstream oss;
+    oss << "testCoalesce#" << testId;
+    const std::string testCaseName = oss.str();
+    {
+        // check coalesced nodes in graph
+        std::istringstream input(testCase.input);
+        std::ostringstream errorStream;
+        Assembler assembler("test.s", input, (ASM_ALL&~ASM_ALTMACRO) | ASM_COALESCE |
+                    ASM_TESTRUN | ASM_TESTRESOLVE, BinaryFormat::RAWCODE,
+                    GPUDeviceType::CAPE_VERDE, errorStream);
+        assertTrue("testCoalesce", testCaseName+".testgood", assembler.assemble());
+        AsmRegAllocator regAlloc(assembler);
+        regAlloc.prepareAllocation(0);
+        regAlloc.createInterferenceGraph();
+        InterGraph origGraphs[MAX_REGTYPES_NUM];
+        for (size_t r = 0; r < MAX_REGTYPES_NUM; r++)
+            origGraphs[r] = regAlloc.getInterGraphs()[r];
+        regAlloc.colorInterferenceGraph();
+
+        size_t coalescedNum = 0;
+        for (size_t r = 0; r < 2; r++)
+        {
+            std::ostringstream rOss;
+            rOss << testCaseName << ".regtype#" << r;
+            const std::string rtname = rOss.str();
+            const Array<cxuint>& gcMap = regAlloc.getGraphColorMaps()[r];
+            const std::vector<size_t>& reps = regAlloc.getCoalescedNodes()[r];
+            for (size_t n = 0; n < gcMap.size(); n++)
+            {
+                std::ostringstream nOss;
+                nOss << rtname << ".color#" << n;
+                assertTrue("testCoalesce", nOss.str() + ".colored", gcMap[n] != UINT_MAX);
+                // coloring must be valid for graph before coalescing
+                origGraphs[r].forEachNeighbor(n, [&](size_t nb)
+                {
+                    std::ostringstream nbOss;
+                    nbOss << nOss.str() << ".nb#" << nb;
+                    assertTrue("testCoalesce", nbOss.str(), gcMap[n] != gcMap[nb]);
+                });
+            }
+            for (const CopyInstr& copy: regAlloc.getCopyInstrs()[r])
+                if (!reps.empty() && reps[copy.dstNode] == reps[copy.srcNode])
+                {
+                    std::ostringstream cOss;
+                    cOss << rtname << ".copy#" << copy.offset;
+                    assertValue("testCoalesce", cOss.str() + ".color",
+                                gcMap[copy.srcNode], gcMap[copy.dstNode]);
+                    coalescedNum++;
+                }
+        }
+        assertValue("testCoalesce", testCaseName+".coalescedNum",
+                    testCase.coalescedNum, coalescedNum);
+    }
+
+    std::istringstream input(testCase.input);
+    std::ostringstream errorStream;
+    Assembler assembler("test.s", input, (ASM_ALL&~ASM_ALTMACRO) | ASM_ALLOCREGS |
+                ASM_COALESCE | testCase.flags, BinaryFormat::RAWCODE,
+                GPUDeviceType::CAPE_VERDE, errorStream);
+    bool good = assembler.assemble();
+    assertTrue("testCoalesce", testCaseName+".good", good);
+    assertString("testCoalesce", testCaseName+".errorMessages", "", errorStream.str());
+
+    const std::vector<cxbyte>& content = assembler.getSections()[0].content;
+    const uint32_t* words = reinterpret_cast<const uint32_t*>(content.data());
+    assertValue("testCoalesce", testCaseName+".size", testCase.words.size()<<2,
+                content.size());
+    for (size_t i = 0; i < testCase.words.size(); i++)
+    {
+        std::ostringstream wOss;
+        wOss << testCaseName << ".word#" << i;
+        assertValue("testCoalesce", wOss.str(), testCase.words[i], ULEV(words[i]));
+    }
+}
+
+// eliminated copies are counted per kernel
+static void testKernelEliminatedCopies()
+{
+    std::istringstream input(R"ffDXD(.amd
+.gpu Fiji
+.kernel a
+    .config
+        .dims x
+.text
+a:
+    .regvar va:v:4
+    v_mov_b32 va[0], v1
+    v_mov_b32 va[1], v2
+    v_mov_b32 va[2], va[0]
+    v_add_f32 va[3], va[2], va[1]
+    v_mov_b32 va[0], va[3]
+    v_mul_f32 va[1], va[0], va[1]
+    v_mov_b32 v3, va[1]
+    s_endpgm
+)ffDXD");
+    std::ostringstream errorStream;
+    Assembler assembler("test.s", input, (ASM_ALL&~ASM_ALTMACRO) | ASM_ALLOCREGS |
+                ASM_COALESCE, BinaryFormat::AMD, GPUDeviceType::CAPE_VERDE, errorStream);
+    assertTrue("testCoalesce", "kernel.good", assembler.assemble());
+    const std::vector<AsmKernelOccupancy>& occupancies =
+            assembler.getKernelOccupancies();
+    assertValue("testCoalesce", "kernel.occupancies", size_t(1), occupancies.size());
+    assertTrue("testCoalesce", "kernel.allocated", occupancies[0].allocated);
+    assertValue("testCoalesce", "kernel.eliminatedCopies", size_t(2),
+                occupancies[0].eliminatedCopies);
+}
+
+int main(int argc, const char** argv)
+{
+    int retVal = 0;
+    for (size_t i = 0; i < sizeof(coalesceTestCasesTbl)/sizeof(CoalesceTestCase); i++)
+        try
+        { testCoalesceCase(i, coalesceTestCasesTbl[i]); }
+        catch(const std::exception& ex)
+        {
+            std::cerr << ex.what() << std::endl;
+            retVal = 1;
+        }
+    try
+    { testKernelEliminatedCopies(); }
+    catch(const std::exception& ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        retVal = 1;
+    }
+    return retVal;
+}
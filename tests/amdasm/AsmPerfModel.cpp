@@ -0,0 +1,133 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <CLRX/Config.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <CLRX/utils/Utilities.h>
+#include <CLRX/amdasm/Assembler.h>
+#include "../TestUtils.h"
+
+using namespace CLRX;
+
+struct AsmPerfModelCase
+{
+    const char* input;
+    GPUDeviceType deviceType;
+    const char* expectedReport;
+};
+
+static const AsmPerfModelCase asmPerfModelCases[] =
+{
+    {   /* 0 - dependencies, hazards and code flow */
+        R"ffDXD(        s_mov_b32 s1, s2
+        v_rcp_f32 v1, v2
+        v_mul_f32 v3, v1, v1
+        s_cmp_eq_u32 s1, 0
+        s_cbranch_scc0 skip
+        v_sqrt_f64 v[4:5], v[6:7]
+        v_add_i32 v4, vcc, v1, v4
+        s_add_u32 s4, s1, s1
+skip:   s_endpgm
+)ffDXD",
+        GPUDeviceType::PITCAIRN,
+        "Performance estimation (single wavefront, DPFACTOR=8)\n"
+        "Kernel '.text':\n"
+        "  block 0x0-0x14: instrs 5, issue 32, stalls 4, cycles 36, critical path 20\n"
+        "  block 0x14-0x20: instrs 3, issue 72, stalls 12, cycles 84, "
+        "critical path 68\n"
+        "  block 0x20-0x24: instrs 1, issue 4, stalls 0, cycles 4, critical path 4\n"
+        "  total: instrs 9, issue 108, stalls 16, cycles 124, critical path 124\n"
+    },
+    {   /* 1 - penalty for 2-dword instruction (GCN 1.0) */
+        R"ffDXD(        s_nop 0
+        s_nop 0
+        s_nop 0
+        v_mov_b32 v1, 0x12345
+        v_mul_f32 v2, v1, v1
+        s_endpgm
+)ffDXD",
+        GPUDeviceType::PITCAIRN,
+        "Performance estimation (single wavefront, DPFACTOR=8)\n"
+        "Kernel '.text':\n"
+        "  block 0x0-0x1c: instrs 6, issue 28, stalls 0, cycles 28, critical path 12\n"
+        "  total: instrs 6, issue 28, stalls 0, cycles 28, critical path 28\n"
+    },
+    {   /* 2 - no penalty for 2-dword instruction (GCN 1.2) */
+        R"ffDXD(        s_nop 0
+        s_nop 0
+        s_nop 0
+        v_mov_b32 v1, 0x12345
+        v_mul_f32 v2, v1, v1
+        s_endpgm
+)ffDXD",
+        GPUDeviceType::TONGA,
+        "Performance estimation (single wavefront, DPFACTOR=8)\n"
+        "Kernel '.text':\n"
+        "  block 0x0-0x1c: instrs 6, issue 24, stalls 0, cycles 24, critical path 8\n"
+        "  total: instrs 6, issue 24, stalls 0, cycles 24, critical path 24\n"
+    },
+    {   /* 3 - double precision timings (Hawaii) */
+        R"ffDXD(        v_mul_f64 v[0:1], v[2:3], v[4:5]
+        v_fma_f32 v6, v0, v1, v7
+        s_endpgm
+)ffDXD",
+        GPUDeviceType::HAWAII,
+        "Performance estimation (single wavefront, DPFACTOR=4)\n"
+        "Kernel '.text':\n"
+        "  block 0x0-0x14: instrs 3, issue 40, stalls 0, cycles 40, critical path 36\n"
+        "  total: instrs 3, issue 40, stalls 0, cycles 40, critical path 40\n"
+    }
+};
+
+static void testAsmPerfModel(cxuint i, const AsmPerfModelCase& testCase)
+{
+    std::istringstream input(testCase.input);
+    std::ostringstream errorStream;
+    
+    Assembler assembler("test.s", input, (ASM_ALL&~ASM_ALTMACRO) | ASM_CODEANALYSIS,
+                    BinaryFormat::RAWCODE, testCase.deviceType, errorStream);
+    std::ostringstream oss;
+    oss << "testAsmPerfModel#" << i;
+    const std::string testCaseName = oss.str();
+    assertValue<bool>("testAsmPerfModel", testCaseName+".good", true,
+                      assembler.assemble());
+    
+    AsmPerfEstimator perfEstimator(assembler);
+    perfEstimator.estimate();
+    std::ostringstream reportOss;
+    perfEstimator.writeReport(reportOss);
+    assertString("testAsmPerfModel", testCaseName+".report",
+                 testCase.expectedReport, reportOss.str());
+}
+
+int main(int argc, const char** argv)
+{
+    int retVal = 0;
+    for (cxuint i = 0; i < sizeof(asmPerfModelCases)/sizeof(AsmPerfModelCase); i++)
+        try
+        { testAsmPerfModel(i, asmPerfModelCases[i]); }
+        catch(const std::exception& ex)
+        {
+            std::cerr << ex.what() << std::endl;
+            retVal = 1;
+        }
+    return retVal;
+}
@@ -20,6 +20,8 @@
 #include <CLRX/Config.h>
 #include <algorithm>
 #include <iostream>
+#include <map>
+#include <set>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -287,6 +289,175 @@ static void testCreateSSAData(cxuint testSuiteId, cxuint i, const AsmSSADataCase
     }
 }
 
+// SSA values of regvar in code: key - (block, svreg, kind), value - SSA id
+typedef std::map<std::pair<std::pair<size_t, TestSingleVReg>, cxuint>, size_t> SSAValuesMap;
+
+static void getSSAValues(const std::vector<CodeBlock>& codeBlocks,
+        const std::unordered_map<const AsmRegVar*, CString>& rvMap, SSAValuesMap& values)
+{
+    for (size_t j = 0; j < codeBlocks.size(); j++)
+        for (const auto& entry: codeBlocks[j].ssaInfoMap)
+        {
+            const SSAInfo& sinfo = entry.second;
+            if (entry.first.regVar == nullptr || sinfo.ssaId == SIZE_MAX)
+                continue; // skip registers and unreachable code blocks
+            const TestSingleVReg svreg = getTestSingleVReg(entry.first, rvMap);
+            if (sinfo.readBeforeWrite && sinfo.ssaIdBefore != SIZE_MAX)
+                values[{ { j, svreg }, 0 }] = sinfo.ssaIdBefore;
+            if (sinfo.ssaIdChange != 0)
+            {
+                values[{ { j, svreg }, 1 }] = sinfo.ssaIdFirst;
+                values[{ { j, svreg }, 2 }] = sinfo.ssaIdLast;
+            }
+        }
+}
+
+/* check SSA data by following all code paths (calls go to routine and returns
+ * go back to block after call): value read before write in code block must be
+ * value written last before on every path. Undefined values are skipped. */
+static void checkSSAValuesByPaths(const std::string& testCaseName,
+        const std::vector<CodeBlock>& codeBlocks,
+        const std::unordered_map<const AsmRegVar*, CString>& rvMap)
+{
+    // maximal depth of calls (for recursive routines)
+    const size_t maxCallDepth = 8;
+    std::vector<AsmSingleVReg> svregs;
+    for (const CodeBlock& cblock: codeBlocks)
+        for (const auto& entry: cblock.ssaInfoMap)
+            if (entry.first.regVar != nullptr)
+                svregs.push_back(entry.first);
+    std::sort(svregs.begin(), svregs.end());
+    svregs.resize(std::unique(svregs.begin(), svregs.end()) - svregs.begin());
+    
+    // state: block, current value and return blocks
+    typedef std::pair<std::pair<size_t, size_t>, std::vector<size_t> > PathState;
+    for (const AsmSingleVReg& svreg: svregs)
+    {
+        std::set<PathState> visited;
+        std::vector<PathState> stack;
+        stack.push_back({ { 0, 0 }, { } });
+        visited.insert(stack.back());
+        while (!stack.empty())
+        {
+            const PathState state = stack.back();
+            stack.pop_back();
+            const size_t b = state.first.first;
+            size_t value = state.first.second;
+            const CodeBlock& cblock = codeBlocks[b];
+            auto sinfoIt = binaryMapFind(cblock.ssaInfoMap.begin(),
+                        cblock.ssaInfoMap.end(), svreg);
+            if (sinfoIt != cblock.ssaInfoMap.end())
+            {
+                const SSAInfo& sinfo = sinfoIt->second;
+                if (sinfo.readBeforeWrite && value != 0)
+                {
+                    std::ostringstream valOss;
+                    valOss << ".block#" << b << "." <<
+                            getTestSingleVReg(svreg, rvMap) << ".path";
+                    assertValue("testAsmDomSSAData", testCaseName + valOss.str(),
+                                value, sinfo.ssaIdBefore);
+                }
+                if (sinfo.ssaIdChange != 0)
+                    value = sinfo.ssaIdLast;
+            }
+            auto pushState = [&visited, &stack](size_t next, size_t value,
+                        const std::vector<size_t>& returns)
+            {
+                PathState nextState{ { next, value }, returns };
+                if (visited.insert(nextState).second)
+                    stack.push_back(nextState);
+            };
+            if (cblock.haveReturn)
+            {
+                if (!state.second.empty())
+                    pushState(state.second.back(), value, std::vector<size_t>(
+                            state.second.begin(), state.second.end()-1));
+                continue;
+            }
+            for (const NextBlock& next: cblock.nexts)
+                if (!next.isCall)
+                    pushState(next.block, value, state.second);
+                else if (state.second.size() < maxCallDepth)
+                {
+                    std::vector<size_t> returns(state.second);
+                    returns.push_back(b+1);
+                    pushState(next.block, value, returns);
+                }
+            if (!cblock.haveEnd && cblock.nexts.empty() && b+1 < codeBlocks.size())
+                pushState(b+1, value, state.second);
+        }
+    }
+}
+
+/* compare SSA data created by dominators with SSA data created by createSSAData:
+ * after applying SSA replaces, both must join same values. Undefined values are
+ * ignored. For code with routines, only reached code blocks and usages are compared,
+ * because routines are not handled in same way by these methods. */
+static void testCreateSSADataByDominators(cxuint testSuiteId, cxuint i,
+                const AsmSSADataCase& testCase)
+{
+    if (!testCase.good)
+        return;
+    SSAValuesMap values[2];
+    bool haveCalls = false;
+    std::ostringstream oss;
+    oss << " testAsmDomSSAData" << testSuiteId << " case#" << i;
+    const std::string testCaseName = oss.str();
+    for (cxuint k = 0; k < 2; k++)
+    {
+        std::istringstream input(testCase.input);
+        std::ostringstream errorStream;
+        Assembler assembler("test.s", input,
+                    (ASM_ALL&~ASM_ALTMACRO) | ASM_TESTRUN | ASM_TESTRESOLVE,
+                    BinaryFormat::RAWCODE, GPUDeviceType::CAPE_VERDE, errorStream);
+        assembler.assemble();
+        const AsmSection& section = assembler.getSections()[0];
+        
+        AsmRegAllocator regAlloc(assembler);
+        regAlloc.createCodeStructure(section.codeFlow, section.getSize(),
+                            section.content.data());
+        if (k == 0)
+            regAlloc.createSSAData(*section.usageHandler, *section.linearDepHandler);
+        else
+            regAlloc.createSSADataByDominators(*section.usageHandler,
+                            *section.linearDepHandler);
+        regAlloc.applySSAReplaces();
+        std::unordered_map<const AsmRegVar*, CString> regVarNamesMap;
+        for (const auto& rvEntry: assembler.getRegVarMap())
+            regVarNamesMap.insert(std::make_pair(&rvEntry.second, rvEntry.first));
+        getSSAValues(regAlloc.getCodeBlocks(), regVarNamesMap, values[k]);
+        for (const CodeBlock& cblock: regAlloc.getCodeBlocks())
+            haveCalls |= cblock.haveCalls;
+        if (k == 1)
+            checkSSAValuesByPaths(testCaseName, regAlloc.getCodeBlocks(),
+                        regVarNamesMap);
+    }
+    
+    // mappings between SSA ids: key - (svreg, SSA id)
+    std::map<std::pair<TestSingleVReg, size_t>, size_t> oldToNew, newToOld;
+    for (const auto& entry: values[0])
+    {
+        std::ostringstream valOss;
+        valOss << ".block#" << entry.first.first.first << "." <<
+                entry.first.first.second << ".kind" << entry.first.second;
+        auto it = values[1].find(entry.first);
+        assertTrue("testAsmDomSSAData", testCaseName + valOss.str() + ".found",
+                    it != values[1].end());
+        /* skip undefined values (SSA id 0), they can be joined with any value.
+         * createSSAData joins more values around routines, then code with calls
+         * is checked by paths */
+        if (haveCalls || entry.second == 0 || it->second == 0)
+            continue;
+        const TestSingleVReg& svreg = entry.first.first.second;
+        auto res = oldToNew.insert({ { svreg, entry.second }, it->second });
+        assertValue("testAsmDomSSAData", testCaseName + valOss.str() + ".oldToNew",
+                    res.first->second, it->second);
+        res = newToOld.insert({ { svreg, it->second }, entry.second });
+        assertValue("testAsmDomSSAData", testCaseName + valOss.str() + ".newToOld",
+                    res.first->second, entry.second);
+    }
+}
+
 int main(int argc, const char** argv)
 {
     int retVal = 0;
@@ -322,5 +493,29 @@ int main(int argc, const char** argv)
             std::cerr << ex.what() << std::endl;
             retVal = 1;
         }
+    for (size_t i = 0; ssaDataTestCases1Tbl[i].input!=nullptr; i++)
+        try
+        { testCreateSSADataByDominators(0, i, ssaDataTestCases1Tbl[i]); }
+        catch(const std::exception& ex)
+        {
+            std::cerr << ex.what() << std::endl;
+            retVal = 1;
+        }
+    for (size_t i = 0; ssaDataTestCases2Tbl[i].input!=nullptr; i++)
+        try
+        { testCreateSSADataByDominators(1, i, ssaDataTestCases2Tbl[i]); }
+        catch(const std::exception& ex)
+        {
+            std::cerr << ex.what() << std::endl;
+            retVal = 1;
+        }
+    for (size_t i = 0; ssaDataTestCases3Tbl[i].input!=nullptr; i++)
+        try
+        { testCreateSSADataByDominators(2, i, ssaDataTestCases3Tbl[i]); }
+        catch(const std::exception& ex)
+        {
+            std::cerr << ex.what() << std::endl;
+            retVal = 1;
+        }
     return retVal;
 }
@@ -2991,7 +2991,10 @@ static void checkVIdxSetEntries(const std::string& testCaseName, const char* vva
     }
 }
 
-static void testCreateLivenessesCase(cxuint i, const AsmLivenessesCase& testCase)
+/* if dataflow is true, then livenesses are created by createLivenessesByDataflow
+ * (only for code without routines) */
+static void testCreateLivenessesCase(cxuint i, const AsmLivenessesCase& testCase,
+                bool dataflow)
 {
     std::cout << "-----------------------------------------------\n"
     "           Test " << i << "\n"
@@ -3016,12 +3019,20 @@ static void testCreateLivenessesCase(cxuint i, const AsmLivenessesCase& testCase
     
     regAlloc.createCodeStructure(section.codeFlow, section.getSize(),
                             section.content.data());
+    if (dataflow)
+        for (const CodeBlock& cblock: regAlloc.getCodeBlocks())
+            if (cblock.haveCalls)
+                return;
     regAlloc.createSSAData(*section.usageHandler, *section.linearDepHandler);
     regAlloc.applySSAReplaces();
-    regAlloc.createLivenesses(*section.usageHandler, *section.linearDepHandler);
+    if (dataflow)
+        regAlloc.createLivenessesByDataflow(*section.usageHandler,
+                        *section.linearDepHandler);
+    else
+        regAlloc.createLivenesses(*section.usageHandler, *section.linearDepHandler);
     
     std::ostringstream oss;
-    oss << " testAsmLivenesses case#" << i;
+    oss << " testAsmLivenesses" << (dataflow ? "Dataflow" : "") << " case#" << i;
     const std::string testCaseName = oss.str();
     
     assertValue<bool>("testAsmLivenesses", testCaseName+".good",
@@ -3172,7 +3183,15 @@ int main(int argc, const char** argv)
     int retVal = 0;
     for (size_t i = 0; i < sizeof(createLivenessesCasesTbl)/sizeof(AsmLivenessesCase); i++)
         try
-        { testCreateLivenessesCase(i, createLivenessesCasesTbl[i]); }
+        { testCreateLivenessesCase(i, createLivenessesCasesTbl[i], false); }
+        catch(const std::exception& ex)
+        {
+            std::cerr << ex.what() << std::endl;
+            retVal = 1;
+        }
+    for (size_t i = 0; i < sizeof(createLivenessesCasesTbl)/sizeof(AsmLivenessesCase); i++)
+        try
+        { testCreateLivenessesCase(i, createLivenessesCasesTbl[i], true); }
         catch(const std::exception& ex)
         {
             std::cerr << ex.what() << std::endl;
@@ -0,0 +1,348 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <CLRX/Config.h>
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <CLRX/utils/Utilities.h>
+#include <CLRX/amdasm/Assembler.h>
+#include <CLRX/utils/Containers.h>
+#include "../TestUtils.h"
+#include "AsmRegAlloc.h"
+
+using namespace CLRX;
+
+typedef AsmRegAllocator::OutLiveness OutLiveness;
+typedef AsmRegAllocator::InterGraph InterGraph;
+
+static const char* interGraphCasesTbl[] =
+{
+    // 0 - simple case
+    R"ffDXD(.regvar sa:s:8, va:v:10
+        s_mov_b32 sa[4], sa[2]
+        s_add_u32 sa[4], sa[4], s3
+        v_xor_b32 va[4], va[2], v3
+        v_add_f32 va[5], va[4], va[3]
+        v_mul_f32 va[6], va[5], va[2]
+        s_endpgm
+)ffDXD",
+    // 1 - branches and many overlapping variables
+    R"ffDXD(.regvar sa:s:8, va:v:10
+        s_mov_b32 sa[0], s1
+        s_mov_b32 sa[1], s2
+        s_mov_b32 sa[2], s3
+        v_mov_b32 va[0], v1
+        v_mov_b32 va[1], v2
+        v_mov_b32 va[2], v3
+        s_cmp_eq_u32 sa[0], sa[1]
+        s_cbranch_scc0 b0
+        v_add_f32 va[3], va[0], va[1]
+        s_add_u32 sa[3], sa[0], sa[2]
+        s_branch b1
+b0:     v_sub_f32 va[3], va[1], va[2]
+        s_sub_u32 sa[3], sa[1], sa[2]
+b1:     v_mul_f32 va[4], va[3], va[0]
+        s_mul_i32 sa[4], sa[3], sa[0]
+        v_add_f32 va[4], va[4], sa[4]
+        s_endpgm
+)ffDXD"
+};
+
+static bool overlaps(const OutLiveness& a, const OutLiveness& b)
+{
+    for (const auto& ra: a)
+        for (const auto& rb: b)
+            if (ra.first != ra.second && rb.first != rb.second &&
+                ra.first < rb.second && rb.first < ra.second)
+                return true;
+    return false;
+}
+
+// compare graph with graph generated by comparing all pairs of livenesses
+static void checkInterGraph(const std::string& testName,
+            const Array<OutLiveness>& livenesses, const InterGraph& graph)
+{
+    const size_t nodesNum = livenesses.size();
+    assertValue("testInterGraph", testName + ".size", nodesNum, graph.size());
+    for (size_t i = 0; i < nodesNum; i++)
+    {
+        std::vector<size_t> expNbs;
+        for (size_t j = 0; j < nodesNum; j++)
+            if (i != j && overlaps(livenesses[i], livenesses[j]))
+                expNbs.push_back(j);
+        std::vector<size_t> resNbs;
+        graph.forEachNeighbor(i, [&resNbs](size_t nb) { resNbs.push_back(nb); });
+
+        std::ostringstream oss;
+        oss << testName << ".node#" << i;
+        const std::string nodeName = oss.str();
+        assertValue("testInterGraph", nodeName + ".degree", expNbs.size(),
+                    graph.degree(i));
+        assertValue("testInterGraph", nodeName + ".nbsNum", expNbs.size(),
+                    resNbs.size());
+        for (size_t k = 0; k < expNbs.size(); k++)
+        {
+            std::ostringstream nbOss;
+            nbOss << nodeName << ".nb#" << k;
+            assertValue("testInterGraph", nbOss.str(), expNbs[k], resNbs[k]);
+            assertTrue("testInterGraph", nbOss.str() + ".interferes",
+                    graph.interferes(i, expNbs[k]));
+        }
+    }
+}
+
+static void testInterGraphCase(cxuint i, const char* inputString)
+{
+    std::istringstream input(inputString);
+    std::ostringstream errorStream;
+
+    Assembler assembler("test.s", input,
+                    (ASM_ALL&~ASM_ALTMACRO) | ASM_TESTRUN | ASM_TESTRESOLVE,
+                    BinaryFormat::RAWCODE, GPUDeviceType::CAPE_VERDE, errorStream);
+    bool good = assembler.assemble();
+    std::ostringstream oss;
+    oss << " testInterGraph case#" << i;
+    const std::string testCaseName = oss.str();
+    assertTrue("testInterGraph", testCaseName+".good", good);
+
+    const AsmSection& section = assembler.getSections()[0];
+    AsmRegAllocator regAlloc(assembler);
+    regAlloc.createCodeStructure(section.codeFlow, section.getSize(),
+                            section.content.data());
+    regAlloc.createSSAData(*section.usageHandler, *section.linearDepHandler);
+    regAlloc.applySSAReplaces();
+    regAlloc.createLivenesses(*section.usageHandler, *section.linearDepHandler);
+
+    // livenesses will be cleared by createInterferenceGraph
+    Array<OutLiveness> livenesses[MAX_REGTYPES_NUM];
+    for (size_t r = 0; r < MAX_REGTYPES_NUM; r++)
+        livenesses[r] = regAlloc.getOutLivenesses()[r];
+
+    regAlloc.createInterferenceGraph();
+    regAlloc.colorInterferenceGraph();
+
+    const InterGraph* interGraphs = regAlloc.getInterGraphs();
+    const Array<cxuint>* gcMaps = regAlloc.getGraphColorMaps();
+    for (size_t r = 0; r < 2; r++)
+    {
+        std::ostringstream rOss;
+        rOss << testCaseName << ".regtype#" << r;
+        const std::string rtname = rOss.str();
+        checkInterGraph(rtname, livenesses[r], interGraphs[r]);
+
+        // check both forms of graph
+        InterGraph graph;
+        graph.build(livenesses[r].size(), livenesses[r], InterGraph::DENSE);
+        assertTrue("testInterGraph", rtname + ".dense", graph.isDense());
+        checkInterGraph(rtname + ".dense", livenesses[r], graph);
+        graph.build(livenesses[r].size(), livenesses[r], InterGraph::SPARSE);
+        assertTrue("testInterGraph", rtname + ".sparse", !graph.isDense());
+        checkInterGraph(rtname + ".sparse", livenesses[r], graph);
+
+        // check coloring: all nodes colored, neighbors have different colors
+        const Array<cxuint>& gcMap = gcMaps[r];
+        assertValue("testInterGraph", rtname + ".colorsSize",
+                    interGraphs[r].size(), gcMap.size());
+        for (size_t n = 0; n < gcMap.size(); n++)
+        {
+            std::ostringstream nOss;
+            nOss << rtname << ".color#" << n;
+            assertTrue("testInterGraph", nOss.str() + ".colored", gcMap[n] != UINT_MAX);
+            interGraphs[r].forEachNeighbor(n, [&](size_t nb)
+            {
+                std::ostringstream nbOss;
+                nbOss << nOss.str() << ".nb#" << nb;
+                assertTrue("testInterGraph", nbOss.str(), gcMap[n] != gcMap[nb]);
+            });
+        }
+    }
+}
+
+// large graph (interval graph), stored as adjacency lists in auto mode
+static void testLargeInterGraph()
+{
+    const size_t nodesNum = 6000;
+    Array<OutLiveness> livenesses(nodesNum);
+    for (size_t i = 0; i < nodesNum; i++)
+    {
+        const size_t start = (i*7919) % 30000;
+        livenesses[i].resize(1);
+        livenesses[i][0] = std::make_pair(start, start + 1 + (i*31)%23);
+    }
+    InterGraph graph;
+    graph.build(nodesNum, livenesses);
+    assertTrue("testInterGraph", "large.sparse", !graph.isDense());
+    // check degrees and symmetry against pairwise comparison
+    for (size_t i = 0; i < nodesNum; i++)
+    {
+        size_t degree = 0;
+        const auto& a = livenesses[i][0];
+        for (size_t j = 0; j < nodesNum; j++)
+        {
+            const auto& b = livenesses[j][0];
+            if (i != j && a.first < b.second && b.first < a.second)
+            {
+                degree++;
+                if (!graph.interferes(i, j))
+                {
+                    std::ostringstream oss;
+                    oss << "large.edge#" << i << "-" << j;
+                    assertTrue("testInterGraph", oss.str(), false);
+                }
+            }
+        }
+        std::ostringstream oss;
+        oss << "large.degree#" << i;
+        assertValue("testInterGraph", oss.str(), degree, graph.degree(i));
+    }
+}
+
+static const char* parallelRegAllocSource = R"ffDXD(.amd
+.gpu CapeVerde
+.regvar sa:s:8, va:v:10
+.kernel a
+    .config
+        .dims x
+.text
+        s_mov_b32 sa[0], s1
+        s_mov_b32 sa[1], s2
+        v_mov_b32 va[0], v1
+        v_mov_b32 va[1], v2
+        s_cmp_eq_u32 sa[0], sa[1]
+        s_cbranch_scc0 a0
+        v_add_f32 va[3], va[0], va[1]
+        s_add_u32 sa[3], sa[0], sa[1]
+        s_branch a1
+a0:     v_sub_f32 va[3], va[1], va[0]
+        s_sub_u32 sa[3], sa[1], sa[0]
+a1:     v_mul_f32 va[4], va[3], va[0]
+        s_mul_i32 sa[4], sa[3], sa[0]
+        v_add_f32 va[4], va[4], sa[4]
+        s_endpgm
+.kernel b
+    .config
+        .dims x
+.text
+        s_mov_b32 sa[2], s3
+        v_mov_b32 va[2], v3
+        v_mov_b32 va[5], v4
+        v_add_f32 va[6], va[2], va[5]
+        v_mul_f32 va[6], va[6], sa[2]
+        s_endpgm
+.kernel c
+    .config
+        .dims x
+.text
+        v_mov_b32 va[0], v0
+        v_mov_b32 va[1], v1
+        v_mov_b32 va[2], v2
+        v_add_f32 va[3], va[0], va[1]
+        v_add_f32 va[4], va[1], va[2]
+        v_add_f32 va[5], va[3], va[4]
+        v_mul_f32 va[5], va[5], va[0]
+        s_endpgm
+)ffDXD";
+
+// compare parallel allocation with serial allocation
+static void testParallelRegAlloc(cxuint threadsNum)
+{
+    std::istringstream input(parallelRegAllocSource);
+    std::ostringstream errorStream;
+    Assembler assembler("test.s", input,
+                    (ASM_ALL&~ASM_ALTMACRO) | ASM_TESTRUN | ASM_TESTRESOLVE,
+                    BinaryFormat::AMD, GPUDeviceType::CAPE_VERDE, errorStream);
+    std::ostringstream oss;
+    oss << "parallel#" << threadsNum;
+    const std::string testName = oss.str();
+    assertTrue("testParallelRegAlloc", testName + ".good", assembler.assemble());
+    
+    AsmParallelRegAllocator parRegAlloc(assembler, threadsNum);
+    parRegAlloc.allocateRegisters();
+    const std::vector<AsmSectionId>& sectionIds = parRegAlloc.getSectionIds();
+    assertValue("testParallelRegAlloc", testName + ".sectionsNum",
+                size_t(3), sectionIds.size());
+    
+    for (size_t i = 0; i < sectionIds.size(); i++)
+    {
+        AsmRegAllocator regAlloc(assembler);
+        regAlloc.allocateRegisters(sectionIds[i]);
+        const AsmRegAllocator& resRegAlloc = parRegAlloc.getRegAllocator(i);
+        
+        std::ostringstream sOss;
+        sOss << testName << ".section#" << sectionIds[i];
+        const std::string sname = sOss.str();
+        for (size_t r = 0; r < 2; r++)
+        {
+            std::ostringstream rOss;
+            rOss << sname << ".regtype#" << r;
+            const std::string rtname = rOss.str();
+            const InterGraph& expGraph = regAlloc.getInterGraphs()[r];
+            const InterGraph& resGraph = resRegAlloc.getInterGraphs()[r];
+            assertValue("testParallelRegAlloc", rtname + ".graphSize",
+                        expGraph.size(), resGraph.size());
+            for (size_t n = 0; n < expGraph.size(); n++)
+            {
+                std::vector<size_t> expNbs, resNbs;
+                expGraph.forEachNeighbor(n, [&expNbs](size_t nb)
+                        { expNbs.push_back(nb); });
+                resGraph.forEachNeighbor(n, [&resNbs](size_t nb)
+                        { resNbs.push_back(nb); });
+                std::ostringstream nOss;
+                nOss << rtname << ".node#" << n;
+                assertTrue("testParallelRegAlloc", nOss.str(), expNbs == resNbs);
+            }
+            const Array<cxuint>& expColors = regAlloc.getGraphColorMaps()[r];
+            const Array<cxuint>& resColors = resRegAlloc.getGraphColorMaps()[r];
+            assertArray("testParallelRegAlloc", rtname + ".colors",
+                        expColors, resColors);
+        }
+    }
+}
+
+int main(int argc, const char** argv)
+{
+    int retVal = 0;
+    for (size_t i = 0; i < sizeof(interGraphCasesTbl)/sizeof(const char*); i++)
+        try
+        { testInterGraphCase(i, interGraphCasesTbl[i]); }
+        catch(const std::exception& ex)
+        {
+            std::cerr << ex.what() << std::endl;
+            retVal = 1;
+        }
+    try
+    { testLargeInterGraph(); }
+    catch(const std::exception& ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        retVal = 1;
+    }
+    for (cxuint threadsNum: { 1, 2, 4 })
+        try
+        { testParallelRegAlloc(threadsNum); }
+        catch(const std::exception& ex)
+        {
+            std::cerr << ex.what() << std::endl;
+            retVal = 1;
+        }
+    return retVal;
+}
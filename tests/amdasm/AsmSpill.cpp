@@ -0,0 +1,177 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <CLRX/Config.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <set>
+#include <cstring>
+#include <CLRX/utils/Utilities.h>
+#include <CLRX/utils/MemAccess.h>
+#include <CLRX/amdasm/Assembler.h>
+#include "../TestUtils.h"
+
+using namespace CLRX;
+
+struct SpillTestCase
+{
+    const char* gpuName;
+    bool vgprs;     // spill VGPRs (otherwise SGPRs)
+    cxuint regsNum; // number of live register variables
+    const char* prologue;   // pseudo-ops before code
+    bool good;
+    const char* errorMessages;
+};
+
+static const SpillTestCase spillTestCasesTbl[] =
+{
+    {   /* 0 - SGPRs to lanes of VGPR (VOP3 encoding) */
+        "Fiji", false, 110, "", true, ""
+    },
+    {   /* 1 - SGPRs to lanes of VGPR (VOP2 encoding) */
+        "Pitcairn", false, 110, "", true, ""
+    },
+    {   /* 2 - VGPRs to scratch buffer */
+        "Fiji", true, 260, ".spill_scratch s[12:15], s16\n", true,
+        "test.s:5:5: Warning: Spilled VGPRs need 36 bytes of scratch per lane\n"
+    },
+    {   /* 3 - VGPRs to scratch buffer (GCN 1.0) */
+        "Pitcairn", true, 260, ".spill_scratch s[12:15], s16\n", true,
+        "test.s:5:5: Warning: Spilled VGPRs need 36 bytes of scratch per lane\n"
+    },
+    {   /* 4 - VGPRs without scratch buffer */
+        "Fiji", true, 260, "", false, "test.s:4:5: Error: Too many register is needed "
+        "(scratch buffer to spill VGPRs is not defined)\n"
+    },
+    {   /* 5 - wrong scratch buffer registers */
+        "Fiji", false, 2, ".spill_scratch s[13:16], s17\n"
+        ".spill_scratch s[12:15], s[16:17]\n.spill_scratch v[0:3], s16\n", false,
+        "test.s:3:16: Error: Scratch resource must be 4 aligned SGPRs\n"
+        "test.s:4:26: Error: Scratch offset must be single SGPR\n"
+        "test.s:5:16: Error: Scratch resource must be 4 aligned SGPRs\n"
+    }
+};
+
+// generate code: regsNum live values summed into first register variable
+static std::string generateSpillCode(const SpillTestCase& testCase)
+{
+    std::ostringstream oss;
+    oss << ".gpu " << testCase.gpuName << "\n.rawcode\n" << testCase.prologue;
+    const char* rvName = testCase.vgprs ? "va" : "sa";
+    oss << "    .regvar " << rvName << (testCase.vgprs ? ":v:" : ":s:") <<
+            testCase.regsNum << "\n";
+    for (cxuint i = 0; i < testCase.regsNum; i++)
+        oss << (testCase.vgprs ? "    v_mov_b32 " : "    s_mov_b32 ") <<
+                rvName << "[" << i << "], " << (i&63) << "\n";
+    for (cxuint i = 1; i < testCase.regsNum; i++)
+        oss << (testCase.vgprs ? "    v_add_f32 " : "    s_add_u32 ") <<
+                rvName << "[0], " << rvName << "[0], " << rvName << "[" << i << "]\n";
+    if (testCase.vgprs)
+        oss << "    buffer_store_dword va[0], v0, s[8:11], 0 offen\n";
+    else
+        oss << "    s_mov_b32 s0, sa[0]\n";
+    oss << "    s_endpgm\n";
+    return oss.str();
+}
+
+static void testSpillCase(cxuint testId, const SpillTestCase& testCase)
+{
+    std::istringstream input(generateSpillCode(testCase));
+    std::ostringstream errorStream;
+
+    Assembler assembler("test.s", input, (ASM_ALL&~ASM_ALTMACRO) | ASM_ALLOCREGS,
+                    BinaryFormat::RAWCODE, GPUDeviceType::CAPE_VERDE, errorStream);
+    bool good = assembler.assemble();
+    std::ostringstream oss;
+    oss << "testSpill#" << testId;
+    const std::string testCaseName = oss.str();
+    assertValue("testSpill", testCaseName+".good", testCase.good, good);
+    assertString("testSpill", testCaseName+".errorMessages",
+                testCase.errorMessages, errorStream.str());
+    if (!testCase.good)
+        return;
+
+    const std::vector<cxbyte>& content = assembler.getSections()[0].content;
+    const uint32_t* words = reinterpret_cast<const uint32_t*>(content.data());
+    const size_t wordsNum = content.size()>>2;
+    const bool isGCN12 = ::strcmp(testCase.gpuName, "Fiji")==0;
+    // saved lanes (or scratch offsets) and restores that read saved slot
+    std::set<cxuint> savedSlots;
+    cxuint savesNum = 0, restoresNum = 0;
+    for (size_t i = 0; i < wordsNum; )
+    {
+        const uint32_t word = ULEV(words[i]);
+        const uint32_t word1 = (i+1 < wordsNum) ? ULEV(words[i+1]) : 0;
+        // VOP3 and MUBUF instructions have 8 bytes
+        const bool twoWords = (word>>26)==0x34 || (word>>26)==0x38;
+        bool isSave = false, isRestore = false;
+        cxuint slot = 0;
+        if (!testCase.vgprs)
+        {
+            // V_WRITELANE_B32 and V_READLANE_B32
+            if (isGCN12 && (word&0xffff0000U)==0xd28a0000U)
+            { isSave = true; slot = ((word1>>9)&0x1ff)-128; }
+            else if (isGCN12 && (word&0xffff0000U)==0xd2890000U)
+            { isRestore = true; slot = ((word1>>9)&0x1ff)-128; }
+            else if (!isGCN12 && (word&0xfe000000U)==(2U<<25))
+            { isSave = true; slot = ((word>>9)&0xff)-128; }
+            else if (!isGCN12 && (word&0xfe000000U)==(1U<<25))
+            { isRestore = true; slot = ((word>>9)&0xff)-128; }
+        }
+        // BUFFER_STORE_DWORD and BUFFER_LOAD_DWORD with scratch buffer s[12:15]
+        else if ((word>>26)==0x38 && ((word1>>16)&0x1f)==3 && (word1>>24)==16)
+        {
+            const uint32_t op = (word>>18)&0x7f;
+            isSave = op==28;
+            isRestore = op==(isGCN12 ? 20U : 12U);
+            slot = word&0xfff;
+        }
+        if (isSave)
+        {
+            savesNum++;
+            savedSlots.insert(slot);
+        }
+        if (isRestore)
+        {
+            restoresNum++;
+            std::ostringstream rOss;
+            rOss << testCaseName << ".restore#" << i;
+            assertTrue("testSpill", rOss.str(), savedSlots.find(slot)!=savedSlots.end());
+        }
+        i += twoWords ? 2 : 1;
+    }
+    assertTrue("testSpill", testCaseName+".saves", savesNum!=0);
+    assertTrue("testSpill", testCaseName+".restores", restoresNum!=0);
+}
+
+int main(int argc, const char** argv)
+{
+    int retVal = 0;
+    for (size_t i = 0; i < sizeof(spillTestCasesTbl)/sizeof(SpillTestCase); i++)
+        try
+        { testSpillCase(i, spillTestCasesTbl[i]); }
+        catch(const std::exception& ex)
+        {
+            std::cerr << ex.what() << std::endl;
+            retVal = 1;
+        }
+    return retVal;
+}
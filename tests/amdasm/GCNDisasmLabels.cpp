@@ -61,6 +61,12 @@ static const GCNDisasmLabelCase decGCNLabelCases[] =
         "        s_branch        .L2320_0\n        s_branch        .L1056_0\n"
         "        s_branch        .L1056_0\n.org 0x420\n.L1056_0:\n.org 0x910\n.L2320_0:\n"
     },
+    {   /* labels in and out of code, duplicates */
+        { 0xbf820002U, 0xbf820105U, 0xbf820000U, 0xbf82fffeU, 0xbf820102U },
+        "        s_branch        .L12_0\n        s_branch        .L1052_0\n"
+        ".L8_0:\n        s_branch        .L12_0\n.L12_0:\n        s_branch        .L8_0\n"
+        "        s_branch        .L1052_0\n.org 0x41c\n.L1052_0:\n"
+    },
     /* testing label symbols */
     { { 0xbf820001U, 0xb1abd3b9U, 0xbf82fffeU },  /* SOPK */
       "        s_branch        .L8_0\n.L4_0:\n        s_cmpk_eq_i32   s43, 0xd3b9\n.L8_0:\n"
@@ -468,6 +474,41 @@ static void testDecGCNRelocations()
         throw Exception("FAILED relocationTest: result: "+disOss.str());
 }
 
+/* disassemble raw code from stream in small windows (instructions and labels
+ * crosses windows boundaries) and compare with disassembled code from memory */
+static void testDecGCNStreamWindows(cxuint i, const GCNDisasmLabelCase& testCase,
+                      GPUDeviceType deviceType)
+{
+    Array<uint32_t> code(testCase.words.size());
+    for (size_t k = 0; k < testCase.words.size(); k++)
+        code[k] = LEV(testCase.words[k]);
+    const size_t codeSize = testCase.words.size()<<2;
+    const cxbyte* codeBytes = reinterpret_cast<const cxbyte*>(code.data());
+    std::ostringstream expectedOss;
+    {
+        Disassembler disasm(deviceType, codeSize, codeBytes, expectedOss,
+                    DISASM_DUMPCODE | DISASM_FLOATLITS);
+        disasm.disassemble();
+    }
+    for (size_t windowSize = 4; windowSize <= 16; windowSize += 4)
+    {
+        std::istringstream codeStream(std::string(
+                    reinterpret_cast<const char*>(codeBytes), codeSize));
+        std::ostringstream disOss;
+        Disassembler disasm(deviceType, codeStream, disOss,
+                    DISASM_DUMPCODE | DISASM_FLOATLITS, windowSize);
+        disasm.disassemble();
+        if (disOss.str() != expectedOss.str())
+        {
+            std::ostringstream oss;
+            oss << "FAILED for " << getGPUDeviceTypeName(deviceType) <<
+                " decGCNStreamCase#" << i << ": window=" << windowSize << std::endl;
+            oss << "\nExpected: " << expectedOss.str() << ", Result: " << disOss.str();
+            throw Exception(oss.str());
+        }
+    }
+}
+
 int main(int argc, const char** argv)
 {
     int retVal = 0;
@@ -496,6 +537,23 @@ int main(int argc, const char** argv)
             retVal = 1;
         }
     
+    for (cxuint i = 0; i < sizeof(decGCNLabelCases)/sizeof(GCNDisasmLabelCase); i++)
+        try
+        { testDecGCNStreamWindows(i, decGCNLabelCases[i], GPUDeviceType::PITCAIRN); }
+        catch(const std::exception& ex)
+        {
+            std::cerr << ex.what() << std::endl;
+            retVal = 1;
+        }
+    for (cxuint i = 0; i < sizeof(decGCN12LabelCases)/sizeof(GCNDisasmLabelCase); i++)
+        try
+        { testDecGCNStreamWindows(i, decGCN12LabelCases[i], GPUDeviceType::TONGA); }
+        catch(const std::exception& ex)
+        {
+            std::cerr << ex.what() << std::endl;
+            retVal = 1;
+        }
+    
     try
     {
         testDecGCNNamedLabels();
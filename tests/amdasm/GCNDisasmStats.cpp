@@ -0,0 +1,284 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <CLRX/Config.h>
+#include <iostream>
+#include <sstream>
+#include <CLRX/utils/Utilities.h>
+#include <CLRX/utils/Containers.h>
+#include <CLRX/amdasm/Disassembler.h>
+#include <CLRX/utils/MemAccess.h>
+
+using namespace CLRX;
+
+struct GCNDisasmStatsCase
+{
+    GPUDeviceType deviceType;
+    Array<uint32_t> words;
+    const char* expectedJSON;
+    const char* expectedCSV;
+};
+
+static const GCNDisasmStatsCase gcnDisasmStatsCases[] =
+{
+    {   /* 0 - simple code with branch */
+        GPUDeviceType::PITCAIRN,
+        {
+            0xbe850307U, // s_mov_b32 s5, s7
+            0x8015ff04U, 0x0000007bU, // s_add_u32 s21, s4, 0x7b
+            0x06020702U, // v_add_f32 v1, v2, v3
+            0xbf840001U, // s_cbranch_scc0 .L24_0
+            0x06020702U, // v_add_f32 v1, v2, v3
+            0xbf810000U  // s_endpgm
+        },
+        "[\n"
+        "  {\n"
+        "    \"kernel\": \"\",\n"
+        "    \"codeSize\": 28,\n"
+        "    \"instrsNum\": 6,\n"
+        "    \"literalsNum\": 1,\n"
+        "    \"sdwaNum\": 0,\n"
+        "    \"dppNum\": 0,\n"
+        "    \"sgprsNum\": 22,\n"
+        "    \"vgprsNum\": 4,\n"
+        "    \"categories\": {\n"
+        "      \"SALU\": 4,\n"
+        "      \"VALU\": 2,\n"
+        "      \"SMEM\": 0,\n"
+        "      \"VMEM\": 0,\n"
+        "      \"LDS\": 0,\n"
+        "      \"EXP\": 0,\n"
+        "      \"ILLEGAL\": 0\n"
+        "    },\n"
+        "    \"encodings\": {\n"
+        "      \"SOP1\": 1,\n"
+        "      \"SOP2\": 1,\n"
+        "      \"SOPP\": 2,\n"
+        "      \"VOP2\": 2\n"
+        "    },\n"
+        "    \"mnemonics\": {\n"
+        "      \"s_add_u32\": 1,\n"
+        "      \"s_cbranch_scc0\": 1,\n"
+        "      \"s_endpgm\": 1,\n"
+        "      \"s_mov_b32\": 1,\n"
+        "      \"v_add_f32\": 2\n"
+        "    },\n"
+        "    \"blocks\": [\n"
+        "      { \"offset\": 0, \"size\": 20, \"instrsNum\": 4 },\n"
+        "      { \"offset\": 20, \"size\": 4, \"instrsNum\": 1 },\n"
+        "      { \"offset\": 24, \"size\": 4, \"instrsNum\": 1 }\n"
+        "    ]\n"
+        "  }\n"
+        "]\n",
+        "kernel,group,key,value\n"
+        ",code,codeSize,28\n"
+        ",code,instrsNum,6\n"
+        ",code,literalsNum,1\n"
+        ",code,sdwaNum,0\n"
+        ",code,dppNum,0\n"
+        ",code,sgprsNum,22\n"
+        ",code,vgprsNum,4\n"
+        ",category,SALU,4\n"
+        ",category,VALU,2\n"
+        ",category,SMEM,0\n"
+        ",category,VMEM,0\n"
+        ",category,LDS,0\n"
+        ",category,EXP,0\n"
+        ",category,ILLEGAL,0\n"
+        ",encoding,SOP1,1\n"
+        ",encoding,SOP2,1\n"
+        ",encoding,SOPP,2\n"
+        ",encoding,VOP2,2\n"
+        ",mnemonic,s_add_u32,1\n"
+        ",mnemonic,s_cbranch_scc0,1\n"
+        ",mnemonic,s_endpgm,1\n"
+        ",mnemonic,s_mov_b32,1\n"
+        ",mnemonic,v_add_f32,2\n"
+        ",block,0x0,4\n"
+        ",block,0x14,1\n"
+        ",block,0x18,1\n"
+    },
+    {   /* 1 - zero words (printed as .fill) are not instructions */
+        GPUDeviceType::PITCAIRN,
+        {
+            0x00000000U, 0x00000000U, // .fill 2, 4, 0
+            0x7e020302U, // v_mov_b32 v1, v2
+            0x00000000U, // .fill 1, 4, 0
+            0xbf810000U  // s_endpgm
+        },
+        "[\n"
+        "  {\n"
+        "    \"kernel\": \"\",\n"
+        "    \"codeSize\": 20,\n"
+        "    \"instrsNum\": 2,\n"
+        "    \"literalsNum\": 0,\n"
+        "    \"sdwaNum\": 0,\n"
+        "    \"dppNum\": 0,\n"
+        "    \"sgprsNum\": 0,\n"
+        "    \"vgprsNum\": 3,\n"
+        "    \"categories\": {\n"
+        "      \"SALU\": 1,\n"
+        "      \"VALU\": 1,\n"
+        "      \"SMEM\": 0,\n"
+        "      \"VMEM\": 0,\n"
+        "      \"LDS\": 0,\n"
+        "      \"EXP\": 0,\n"
+        "      \"ILLEGAL\": 0\n"
+        "    },\n"
+        "    \"encodings\": {\n"
+        "      \"SOPP\": 1,\n"
+        "      \"VOP1\": 1\n"
+        "    },\n"
+        "    \"mnemonics\": {\n"
+        "      \"s_endpgm\": 1,\n"
+        "      \"v_mov_b32\": 1\n"
+        "    },\n"
+        "    \"blocks\": [\n"
+        "      { \"offset\": 8, \"size\": 12, \"instrsNum\": 2 }\n"
+        "    ]\n"
+        "  }\n"
+        "]\n",
+        "kernel,group,key,value\n"
+        ",code,codeSize,20\n"
+        ",code,instrsNum,2\n"
+        ",code,literalsNum,0\n"
+        ",code,sdwaNum,0\n"
+        ",code,dppNum,0\n"
+        ",code,sgprsNum,0\n"
+        ",code,vgprsNum,3\n"
+        ",category,SALU,1\n"
+        ",category,VALU,1\n"
+        ",category,SMEM,0\n"
+        ",category,VMEM,0\n"
+        ",category,LDS,0\n"
+        ",category,EXP,0\n"
+        ",category,ILLEGAL,0\n"
+        ",encoding,SOPP,1\n"
+        ",encoding,VOP1,1\n"
+        ",mnemonic,s_endpgm,1\n"
+        ",mnemonic,v_mov_b32,1\n"
+        ",block,0x8,2\n"
+    }
+};
+
+static void testGCNDisasmStats(cxuint i, const GCNDisasmStatsCase& testCase)
+{
+    Array<uint32_t> code(testCase.words.size());
+    for (size_t j = 0; j < code.size(); j++)
+        SULEV(code[j], testCase.words[j]);
+    std::ostringstream disOss;
+    Disassembler disasm(testCase.deviceType, code.size()<<2,
+                reinterpret_cast<const cxbyte*>(code.data()), disOss, 0);
+    const std::vector<std::pair<CString, GCNCodeStats> > stats =
+                disasm.collectCodeStats();
+    
+    std::ostringstream jsonOss;
+    writeGCNCodeStatsJSON(jsonOss, stats);
+    if (jsonOss.str() != testCase.expectedJSON)
+    {
+        std::ostringstream oss;
+        oss << "FAILED for decGCNStats#" << i << ": JSON\nResult:\n" <<
+                jsonOss.str() << "\nExpected:\n" << testCase.expectedJSON;
+        throw Exception(oss.str());
+    }
+    std::ostringstream csvOss;
+    writeGCNCodeStatsCSV(csvOss, stats);
+    if (csvOss.str() != testCase.expectedCSV)
+    {
+        std::ostringstream oss;
+        oss << "FAILED for decGCNStats#" << i << ": CSV\nResult:\n" <<
+                csvOss.str() << "\nExpected:\n" << testCase.expectedCSV;
+        throw Exception(oss.str());
+    }
+    
+    // statistics collected from stream in small windows must be this same
+    for (size_t windowSize = 4; windowSize <= 12; windowSize += 4)
+    {
+        std::istringstream codeStream(std::string(
+                reinterpret_cast<const char*>(code.data()), code.size()<<2));
+        Disassembler streamDisasm(testCase.deviceType, codeStream, disOss, 0,
+                    windowSize);
+        std::ostringstream streamJsonOss;
+        writeGCNCodeStatsJSON(streamJsonOss, streamDisasm.collectCodeStats());
+        if (streamJsonOss.str() != testCase.expectedJSON)
+        {
+            std::ostringstream oss;
+            oss << "FAILED for decGCNStats#" << i << ": stream window=" <<
+                    windowSize << "\nResult:\n" << streamJsonOss.str() <<
+                    "\nExpected:\n" << testCase.expectedJSON;
+            throw Exception(oss.str());
+        }
+    }
+}
+
+// statistics from many files must be written in single document
+static void testGCNFilesStats()
+{
+    uint32_t code[1];
+    SULEV(code[0], 0xbf810000U); // s_endpgm
+    std::ostringstream disOss;
+    Disassembler disasm(GPUDeviceType::PITCAIRN, 4,
+                reinterpret_cast<const cxbyte*>(code), disOss, 0);
+    std::vector<GCNFileCodeStats> filesStats;
+    filesStats.push_back(std::make_pair(CString("a.clo"), disasm.collectCodeStats()));
+    filesStats.push_back(std::make_pair(CString("b,c.hsaco"),
+                disasm.collectCodeStats()));
+    
+    std::ostringstream jsonOss;
+    writeGCNCodeStatsJSON(jsonOss, filesStats);
+    const std::string json = jsonOss.str();
+    const size_t secondPos = json.find("\n  },\n  {\n    \"file\": \"b,c.hsaco\",\n"
+                "    \"kernel\": \"\",\n");
+    // single top-level array (closed only at end)
+    const std::string jsonStart = "[\n  {\n    \"file\": \"a.clo\",\n";
+    if (json.compare(0, jsonStart.size(), jsonStart) != 0 ||
+        secondPos == std::string::npos || json.find("\n]\n") != json.size()-3)
+        throw Exception("FAILED for decGCNFilesStats: JSON\nResult:\n" + json);
+    
+    std::ostringstream csvOss;
+    writeGCNCodeStatsCSV(csvOss, filesStats);
+    const std::string csv = csvOss.str();
+    const std::string csvHeader = "file,kernel,group,key,value\n";
+    if (csv.compare(0, csvHeader.size(), csvHeader) != 0 ||
+        csv.find("kernel,group", csvHeader.size()) != std::string::npos ||
+        csv.find("\na.clo,,code,instrsNum,1\n") == std::string::npos ||
+        csv.find("\n\"b,c.hsaco\",,code,instrsNum,1\n") == std::string::npos)
+        throw Exception("FAILED for decGCNFilesStats: CSV\nResult:\n" + csv);
+}
+
+int main(int argc, const char** argv)
+{
+    int retVal = 0;
+    for (cxuint i = 0; i < sizeof(gcnDisasmStatsCases)/sizeof(GCNDisasmStatsCase); i++)
+        try
+        { testGCNDisasmStats(i, gcnDisasmStatsCases[i]); }
+        catch(const std::exception& ex)
+        {
+            std::cerr << ex.what() << std::endl;
+            retVal = 1;
+        }
+    try
+    { testGCNFilesStats(); }
+    catch(const std::exception& ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        retVal = 1;
+    }
+    return retVal;
+}
@@ -0,0 +1,386 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <CLRX/Config.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <CLRX/utils/Containers.h>
+#include <CLRX/utils/Utilities.h>
+#include <CLRX/utils/MemAccess.h>
+#include <CLRX/amdbin/ROCmBinaries.h>
+#include <CLRX/amdbin/AmdCL2Binaries.h>
+#include "../TestUtils.h"
+
+using namespace CLRX;
+
+struct BinPatchTestCase
+{
+    const char* filename;
+    const char* kernelName;
+    size_t codeSize;    // size of new code
+    bool inPlace;       // expected in place patching
+    const char* error;  // expected error (if null then no error)
+};
+
+static const BinPatchTestCase rocmPatchTestCasesTbl[] =
+{
+    // code fits in kernel space
+    { "/tests/amdbin/rocmbins/rijndael.hsaco.regen", "rijndael128_decrypt", 0x100,
+        true, nullptr },
+    // kernel moved to end of code
+    { "/tests/amdbin/rocmbins/consttest1-kaveri.hsaco.regen", "test1", 0x180,
+        false, nullptr },
+    // code does not fit in address space to dynamic section
+    { "/tests/amdbin/rocmbins/rijndael.hsaco.regen", "rijndael128_decrypt", 0x5000,
+        false, "No free address space after section" },
+    // last kernel grown (dynamic section is never moved)
+    { "/tests/amdbin/rocmbins/vectoradd-rocm.clo.regen", "vectorAdd", 0x80,
+        true, nullptr },
+    { "/tests/amdbin/rocmbins/vectoradd-rocm.clo.regen", "vectorAdd", 0x200,
+        false, nullptr },
+    { "/tests/amdbin/rocmbins/vectoradd-rocm.clo.regen", "vectorAdd", 0x1800,
+        false, "No free address space after section" }
+};
+
+static const BinPatchTestCase amdCL2PatchTestCasesTbl[] =
+{
+    { "/tests/amdbin/amdcl2bins/piper.clo.regen", "Piper2", 0x100, true, nullptr },
+    { "/tests/amdbin/amdcl2bins/piper.clo.regen", "Piper2", 0x1000, false, nullptr },
+    { "/tests/amdbin/amdcl2bins/piper.clo.regen", "Piper4", 0x4000, false, nullptr },
+    { "/tests/amdbin/amdcl2bins/BinarySearchDeviceSideEnqueue_Kernels.clo.regen",
+        "binarySearch", 0x800, false, nullptr }
+};
+
+static Array<cxbyte> loadTestBinary(const char* filename)
+{
+    std::string filenameStr(CLRX_SOURCE_DIR);
+    filenameStr += filename;
+    filesystemPath(filenameStr); // convert to system path (native separators)
+    return loadDataFromFile(filenameStr.c_str());
+}
+
+static Array<cxbyte> genPatchCode(size_t codeSize)
+{
+    Array<cxbyte> code(codeSize);
+    for (size_t i = 0; i < codeSize; i++)
+        code[i] = cxbyte(i*7 + (i>>8) + 1);
+    return code;
+}
+
+static void testROCmPatchCase(cxuint testId, const BinPatchTestCase& testCase)
+{
+    std::ostringstream oss;
+    oss << "rocmPatch#" << testId;
+    const std::string testCaseName = oss.str();
+
+    const Array<cxbyte> origData = loadTestBinary(testCase.filename);
+    const ROCmBinary origBin(origData.size(), (cxbyte*)origData.data(), 0);
+    Array<cxbyte> data = origData;
+    ROCmBinary binary(data.size(), data.data(), 0);
+    const Array<cxbyte> code = genPatchCode(testCase.codeSize);
+
+    Array<cxbyte> output;
+    if (testCase.error != nullptr)
+    {
+        assertCLRXException("testROCmPatch", testCaseName+".error", testCase.error,
+                [&binary, &testCase, &code, &output]()
+                { patchROCmKernel(binary, testCase.kernelName, code.size(),
+                        code.data(), nullptr, output); });
+        return;
+    }
+    const bool inPlace = patchROCmKernel(binary, testCase.kernelName, code.size(),
+                code.data(), nullptr, output);
+    assertValue("testROCmPatch", testCaseName+".inPlace", testCase.inPlace, inPlace);
+    if (inPlace)
+        output = std::move(data);
+
+    const ROCmBinary newBin(output.size(), output.data(), ROCMBIN_CREATE_REGIONMAP);
+    assertValue("testROCmPatch", testCaseName+".regionsNum", origBin.getRegionsNum(),
+                newBin.getRegionsNum());
+    for (size_t i = 0; i < origBin.getRegionsNum(); i++)
+    {
+        const ROCmRegion& origRegion = origBin.getRegion(i);
+        const ROCmRegion& region = newBin.getRegion(origRegion.regionName.c_str());
+        const std::string regionName = testCaseName + "." + origRegion.regionName.c_str();
+        const cxbyte* origContent = origData.data() + origRegion.offset;
+        const cxbyte* content = output.data() + region.offset;
+        if (origRegion.regionName != testCase.kernelName)
+        {
+            // other regions must be unchanged
+            assertValue("testROCmPatch", regionName+".offset", origRegion.offset,
+                        region.offset);
+            assertValue("testROCmPatch", regionName+".size", origRegion.size,
+                        region.size);
+            assertTrue("testROCmPatch", regionName+".content",
+                        std::equal(origContent, origContent + origRegion.size, content));
+            continue;
+        }
+        if (inPlace)
+            assertValue("testROCmPatch", regionName+".offset", origRegion.offset,
+                        region.offset);
+        const size_t setupSize = ULEV(*reinterpret_cast<const uint64_t*>(content+16));
+        assertValue("testROCmPatch", regionName+".size", setupSize + code.size(),
+                    region.size);
+        assertTrue("testROCmPatch", regionName+".setup",
+                    std::equal(origContent, origContent + 256, content));
+        assertTrue("testROCmPatch", regionName+".code",
+                    std::equal(code.begin(), code.end(), content + setupSize));
+    }
+
+    // check sections and dynamic entries after code
+    const uint16_t textIndex = newBin.getSectionIndex(".text");
+    const Elf64_Shdr& textShdr = newBin.getSectionHeader(textIndex);
+    for (uint16_t i = 1; i < origBin.getSectionHeadersNum(); i++)
+    {
+        const Elf64_Shdr& origShdr = origBin.getSectionHeader(i);
+        const Elf64_Shdr& shdr = newBin.getSectionHeader(i);
+        const std::string secName = testCaseName + "." + origBin.getSectionName(i);
+        assertString("testROCmPatch", secName+".name", origBin.getSectionName(i),
+                    newBin.getSectionName(i));
+        // addresses are never changed
+        assertValue("testROCmPatch", secName+".addr", ULEV(origShdr.sh_addr),
+                    ULEV(shdr.sh_addr));
+        if (i == textIndex)
+            continue;
+        if (ULEV(shdr.sh_addr) != 0)
+        {
+            assertValue("testROCmPatch", secName+".offset", ULEV(shdr.sh_addr),
+                        ULEV(shdr.sh_offset));
+            if (ULEV(shdr.sh_offset) > ULEV(textShdr.sh_offset))
+                assertTrue("testROCmPatch", secName+".after",
+                    ULEV(shdr.sh_addr) >= ULEV(textShdr.sh_addr)+ULEV(textShdr.sh_size));
+        }
+        if (ULEV(shdr.sh_type) != SHT_SYMTAB && ULEV(shdr.sh_type) != SHT_DYNSYM)
+            assertTrue("testROCmPatch", secName+".content",
+                    ULEV(origShdr.sh_size) == ULEV(shdr.sh_size) &&
+                    std::equal(origBin.getSectionContent(i),
+                        origBin.getSectionContent(i) + ULEV(origShdr.sh_size),
+                        newBin.getSectionContent(i)));
+    }
+    const uint16_t dynIndex = newBin.getSectionIndex(".dynamic");
+    const uint64_t dynAddr = ULEV(newBin.getSectionHeader(dynIndex).sh_addr);
+    assertValue("testROCmPatch", testCaseName+"._DYNAMIC", dynAddr,
+                uint64_t(ULEV(newBin.getSymbol("_DYNAMIC").st_value)));
+    for (uint16_t i = 0; i < newBin.getProgramHeadersNum(); i++)
+    {
+        const Elf64_Phdr& phdr = newBin.getProgramHeader(i);
+        if (ULEV(phdr.p_type) == PT_DYNAMIC)
+            assertValue("testROCmPatch", testCaseName+".dynSegment", dynAddr,
+                        uint64_t(ULEV(phdr.p_vaddr)));
+        if (ULEV(phdr.p_type) == PT_LOAD && (ULEV(phdr.p_flags) & PF_X) != 0)
+            assertValue("testROCmPatch", testCaseName+".textSegment",
+                    uint64_t(ULEV(textShdr.sh_size)), uint64_t(ULEV(phdr.p_filesz)));
+    }
+}
+
+// generate ROCm binary with two kernels and GOT that refers to these kernels
+static Array<cxbyte> genROCmGotBinary()
+{
+    Array<cxbyte> code(0x400);
+    std::fill(code.begin(), code.end(), cxbyte(0));
+    for (size_t k = 0; k < 2; k++)
+    {
+        // kernel code entry offset in setup
+        SULEV(*reinterpret_cast<uint64_t*>(code.data() + k*0x200 + 16), uint64_t(256));
+        std::fill(code.data() + k*0x200 + 256, code.data() + (k+1)*0x200, cxbyte(k+1));
+    }
+    ROCmInput rocmInput{};
+    rocmInput.deviceType = GPUDeviceType::FIJI;
+    rocmInput.archMinor = 0;
+    rocmInput.archStepping = 3;
+    rocmInput.newBinFormat = true;
+    rocmInput.target = "amdgcn-amd-amdhsa-amdgizcl-gfx803";
+    rocmInput.symbols.push_back({ "kernel0", 0, 0x200, ROCmRegionType::KERNEL });
+    rocmInput.symbols.push_back({ "kernel1", 0x200, 0x200, ROCmRegionType::KERNEL });
+    rocmInput.gotSymbols = { 0, 1 };
+    rocmInput.codeSize = code.size();
+    rocmInput.code = code.data();
+    Array<cxbyte> output;
+    ROCmBinGenerator binGen(&rocmInput);
+    binGen.generate(output);
+    return output;
+}
+
+// patch kernel in binary with GOT (GOT and its relocations must not be changed)
+static void testROCmGotPatch()
+{
+    const Array<cxbyte> origData = genROCmGotBinary();
+    const ROCmBinary origBin(origData.size(), (cxbyte*)origData.data(), 0);
+    assertValue("testROCmGotPatch", "gotSymbolsNum", size_t(2),
+                origBin.getGotSymbolsNum());
+    Array<cxbyte> data = origData;
+    ROCmBinary binary(data.size(), data.data(), 0);
+    const Array<cxbyte> code = genPatchCode(0x300);
+    Array<cxbyte> output;
+    // first kernel moved to end of code
+    assertValue("testROCmGotPatch", "inPlace", false, patchROCmKernel(binary,
+                "kernel0", code.size(), code.data(), nullptr, output));
+    
+    const ROCmBinary newBin(output.size(), output.data(), ROCMBIN_CREATE_REGIONMAP);
+    const uint64_t textAddr = ULEV(newBin.getSectionHeader(".text").sh_addr);
+    const ROCmRegion& region0 = newBin.getRegion("kernel0");
+    assertValue("testROCmGotPatch", "kernel0.offset", size_t(textAddr + 0x400),
+                region0.offset);
+    assertTrue("testROCmGotPatch", "kernel0.code", std::equal(code.begin(), code.end(),
+                output.data() + region0.offset + 256));
+    const ROCmRegion& region1 = newBin.getRegion("kernel1");
+    assertValue("testROCmGotPatch", "kernel1.offset", size_t(textAddr + 0x200),
+                region1.offset);
+    // GOT still refers to kernel symbols
+    assertValue("testROCmGotPatch", "gotSymbolsNum", size_t(2),
+                newBin.getGotSymbolsNum());
+    assertValue("testROCmGotPatch", "gotSymbol0", origBin.getGotSymbol(0),
+                newBin.getGotSymbol(0));
+    assertValue("testROCmGotPatch", "gotSymbol1", origBin.getGotSymbol(1),
+                newBin.getGotSymbol(1));
+    const char* gotSections[3] = { ".got", ".rela.dyn", ".dynamic" };
+    for (const char* secName: gotSections)
+    {
+        const Elf64_Shdr& origShdr = origBin.getSectionHeader(secName);
+        const Elf64_Shdr& shdr = newBin.getSectionHeader(secName);
+        assertValue("testROCmGotPatch", std::string(secName)+".addr",
+                    ULEV(origShdr.sh_addr), ULEV(shdr.sh_addr));
+        assertTrue("testROCmGotPatch", std::string(secName)+".content",
+                    ULEV(origShdr.sh_size) == ULEV(shdr.sh_size) &&
+                    std::equal(origBin.getSectionContent(secName),
+                        origBin.getSectionContent(secName) + ULEV(origShdr.sh_size),
+                        newBin.getSectionContent(secName)));
+    }
+    
+    // code that does not fit before GOT and dynamic section
+    const Array<cxbyte> bigCode = genPatchCode(0x1000);
+    assertCLRXException("testROCmGotPatch", "bigCode",
+            "No free address space after section", [&binary, &bigCode, &output]()
+            { patchROCmKernel(binary, "kernel1", bigCode.size(), bigCode.data(),
+                        nullptr, output); });
+    
+    // relocation that points to kernel code
+    Elf64_Rela& rela = *reinterpret_cast<Elf64_Rela*>(
+                binary.getSectionContent(".rela.dyn"));
+    SLEV(rela.r_offset, ULEV(binary.getSectionHeader(".text").sh_addr) + 0x280);
+    assertCLRXException("testROCmGotPatch", "relocation",
+            "Kernel with relocations can not be patched", [&binary, &code, &output]()
+            { patchROCmKernel(binary, "kernel1", code.size(), code.data(),
+                        nullptr, output); });
+}
+
+static void testAmdCL2PatchCase(cxuint testId, const BinPatchTestCase& testCase)
+{
+    std::ostringstream oss;
+    oss << "amdCL2Patch#" << testId;
+    const std::string testCaseName = oss.str();
+
+    Array<cxbyte> origData = loadTestBinary(testCase.filename);
+    const AmdCL2MainGPUBinary64 origBin(origData.size(), origData.data());
+    Array<cxbyte> data = origData;
+    AmdCL2MainGPUBinary64 binary(data.size(), data.data());
+    const Array<cxbyte> code = genPatchCode(testCase.codeSize);
+
+    Array<cxbyte> output;
+    if (testCase.error != nullptr)
+    {
+        assertCLRXException("testAmdCL2Patch", testCaseName+".error", testCase.error,
+                [&binary, &testCase, &code, &output]()
+                { patchAmdCL2Kernel(binary, testCase.kernelName, code.size(),
+                        code.data(), nullptr, output); });
+        return;
+    }
+    const bool inPlace = patchAmdCL2Kernel(binary, testCase.kernelName, code.size(),
+                code.data(), nullptr, output);
+    assertValue("testAmdCL2Patch", testCaseName+".inPlace", testCase.inPlace, inPlace);
+    if (inPlace)
+        output = std::move(data);
+
+    const AmdCL2MainGPUBinary64 newBin(output.size(), output.data());
+    const AmdCL2InnerGPUBinary& origInner = origBin.getInnerBinary();
+    const AmdCL2InnerGPUBinary& inner = newBin.getInnerBinary();
+    assertValue("testAmdCL2Patch", testCaseName+".kernelsNum",
+                origBin.getKernelInfosNum(), newBin.getKernelInfosNum());
+    assertValue("testAmdCL2Patch", testCaseName+".kernelDatasNum",
+                origInner.getKernelsNum(), inner.getKernelsNum());
+    for (size_t i = 0; i < origInner.getKernelsNum(); i++)
+    {
+        const AmdCL2GPUKernel& origKernel = origInner.getKernelData(i);
+        const AmdCL2GPUKernel& kernel = inner.getKernelData(
+                    origKernel.kernelName.c_str());
+        const std::string kernelName = testCaseName + "." + origKernel.kernelName.c_str();
+        assertTrue("testAmdCL2Patch", kernelName+".setup",
+                std::equal(origKernel.setup, origKernel.setup + 256, kernel.setup));
+        if (origKernel.kernelName != testCase.kernelName)
+        {
+            // other kernels must be unchanged
+            assertValue("testAmdCL2Patch", kernelName+".codeSize", origKernel.codeSize,
+                        kernel.codeSize);
+            assertTrue("testAmdCL2Patch", kernelName+".code",
+                    std::equal(origKernel.code, origKernel.code + origKernel.codeSize,
+                            kernel.code));
+            continue;
+        }
+        assertValue("testAmdCL2Patch", kernelName+".codeSize", code.size(),
+                    kernel.codeSize);
+        assertTrue("testAmdCL2Patch", kernelName+".code",
+                    std::equal(code.begin(), code.end(), kernel.code));
+    }
+
+    // sections after inner binary must be unchanged
+    for (uint16_t i = 1; i < origBin.getSectionHeadersNum(); i++)
+    {
+        const std::string secName = testCaseName + "." + origBin.getSectionName(i);
+        const Elf64_Shdr& origShdr = origBin.getSectionHeader(i);
+        if (::strcmp(origBin.getSectionName(i), ".text") == 0)
+            continue;
+        assertTrue("testAmdCL2Patch", secName+".content",
+                    ULEV(origShdr.sh_size) == ULEV(newBin.getSectionHeader(i).sh_size) &&
+                    std::equal(origBin.getSectionContent(i),
+                        origBin.getSectionContent(i) + ULEV(origShdr.sh_size),
+                        newBin.getSectionContent(i)));
+    }
+    // inner code segment must cover code section
+    const Elf64_Shdr& hsaTextShdr = inner.getSectionHeader(".hsatext");
+    assertValue("testAmdCL2Patch", testCaseName+".codeSegment",
+                uint64_t(ULEV(hsaTextShdr.sh_size)),
+                uint64_t(ULEV(inner.getProgramHeader(0).p_filesz)));
+}
+
+int main(int argc, const char** argv)
+{
+    int retVal = 0;
+    for (cxuint i = 0; i < sizeof(rocmPatchTestCasesTbl)/sizeof(BinPatchTestCase); i++)
+        try
+        { testROCmPatchCase(i, rocmPatchTestCasesTbl[i]); }
+        catch(const std::exception& ex)
+        {
+            std::cerr << ex.what() << std::endl;
+            retVal = 1;
+        }
+    retVal |= callTest(testROCmGotPatch);
+    for (cxuint i = 0; i < sizeof(amdCL2PatchTestCasesTbl)/sizeof(BinPatchTestCase); i++)
+        try
+        { testAmdCL2PatchCase(i, amdCL2PatchTestCasesTbl[i]); }
+        catch(const std::exception& ex)
+        {
+            std::cerr << ex.what() << std::endl;
+            retVal = 1;
+        }
+    return retVal;
+}
@@ -0,0 +1,244 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <CLRX/Config.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <CLRX/utils/Containers.h>
+#include <CLRX/utils/Utilities.h>
+#include <CLRX/utils/MemAccess.h>
+#include <CLRX/amdbin/ElfBinaries.h>
+#include "../TestUtils.h"
+
+using namespace CLRX;
+
+static uint32_t gnuHash(const char* name)
+{
+    uint32_t h = 5381;
+    for (; *name!=0; name++)
+        h = (h<<5) + h + cxbyte(*name);
+    return h;
+}
+
+// generate ELF with .gnu.hash (and optionally .hash) and look up all dynamic symbols
+static void testGnuHashCase(cxuint testId, size_t symbolsNum, bool withElfHash)
+{
+    std::ostringstream oss;
+    oss << "testGnuHash#" << testId;
+    const std::string testCaseName = oss.str();
+
+    std::vector<std::string> names(symbolsNum);
+    for (size_t i = 0; i < symbolsNum; i++)
+    {
+        std::ostringstream nOss;
+        nOss << "symbol_" << i;
+        names[i] = nOss.str();
+    }
+    ElfBinaryGen64 elfBinGen({ 0, 0, ELFOSABI_SYSV, 0, ET_DYN, 0, EV_CURRENT,
+                UINT_MAX, 0, 0 });
+    elfBinGen.addRegion(ElfRegion64::dynsymSection());
+    elfBinGen.addRegion(ElfRegion64::gnuHashSection(1));
+    if (withElfHash)
+        elfBinGen.addRegion(ElfRegion64::hashSection(1));
+    elfBinGen.addRegion(ElfRegion64::dynstrSection());
+    elfBinGen.addRegion(ElfRegion64::shstrtabSection());
+    elfBinGen.addRegion(ElfRegion64::sectionHeaderTable());
+    // local symbol must be moved before hashed symbols
+    for (size_t i = 0; i < symbolsNum; i++)
+        elfBinGen.addDynSymbol(ElfSymbol64(names[i].c_str(), 0,
+                ELF64_ST_INFO((i==symbolsNum/2) ? STB_LOCAL : STB_GLOBAL, STT_OBJECT),
+                0, false, i, 0));
+
+    Array<cxbyte> output(elfBinGen.countSize());
+    elfBinGen.generate(output.data(), 2);
+
+    const ElfBinary64 elfBin(output.size(), output.data(), ELF_CREATE_HASHINDEX);
+    assertValue("testGnuHash", testCaseName+".dynSymsNum", symbolsNum+1,
+                size_t(elfBin.getDynSymbolsNum()));
+    assertValue("testGnuHash", testCaseName+".local", size_t(1),
+                elfBinGen.getDynSymbolOutIndex(symbolsNum/2));
+    for (size_t i = 0; i < symbolsNum; i++)
+    {
+        const std::string symName = testCaseName + "." + names[i];
+        const size_t outIndex = elfBinGen.getDynSymbolOutIndex(i);
+        assertString("testGnuHash", symName+".name", names[i].c_str(),
+                     elfBin.getDynSymbolName(outIndex));
+        assertValue("testGnuHash", symName+".value", uint64_t(i),
+                    ULEV(elfBin.getDynSymbol(outIndex).st_value));
+        // local symbol is not hashed
+        if (i != symbolsNum/2)
+            assertValue("testGnuHash", symName+".index", outIndex,
+                    size_t(elfBin.findDynSymbolIndex(names[i].c_str())));
+    }
+    assertValue("testGnuHash", testCaseName+".nosymbol", size_t(STN_UNDEF),
+                size_t(elfBin.findDynSymbolIndex("nosymbol")));
+
+    // check bloom filter and chains of .gnu.hash
+    const uint32_t* table = reinterpret_cast<const uint32_t*>(
+                elfBin.getSectionContent(".gnu.hash"));
+    const uint32_t bucketsNum = ULEV(table[0]);
+    const uint32_t symOffset = ULEV(table[1]);
+    const uint32_t bloomSize = ULEV(table[2]);
+    const uint32_t bloomShift = ULEV(table[3]);
+    assertValue("testGnuHash", testCaseName+".symOffset", 2U, symOffset);
+    const uint64_t* bloom = reinterpret_cast<const uint64_t*>(table + 4);
+    const uint32_t* buckets = table + 4 + bloomSize*2;
+    const uint32_t* chains = buckets + bucketsNum;
+    for (size_t i = symOffset; i <= symbolsNum; i++)
+    {
+        const std::string symName = testCaseName + ".sym#" + std::to_string(i);
+        const uint32_t hash = gnuHash(elfBin.getDynSymbolName(i));
+        const uint64_t word = ULEV(bloom[(hash>>6) & (bloomSize-1)]);
+        assertTrue("testGnuHash", symName+".bloom", ((word >> (hash&63)) &
+                    (word >> ((hash>>bloomShift)&63)) & 1) != 0);
+        assertValue("testGnuHash", symName+".chainHash", hash|1U,
+                    ULEV(chains[i-symOffset])|1U);
+        // symbols must be sorted by bucket
+        if (i > symOffset)
+            assertTrue("testGnuHash", symName+".order",
+                    gnuHash(elfBin.getDynSymbolName(i-1)) % bucketsNum <=
+                    hash % bucketsNum);
+    }
+}
+
+static void testStrTabBuilder()
+{
+    static const char* strings[] = { "", "kernel", "__OpenCL_kernel", "nel", "kernel",
+            nullptr, "abc", "c", "__OpenCL_kernel" };
+    const size_t stringsNum = sizeof(strings)/sizeof(const char*);
+    for (cxuint addNull = 0; addNull < 2; addNull++)
+    {
+        std::ostringstream oss;
+        oss << "strTabBuilder#" << addNull;
+        const std::string testCaseName = oss.str();
+        ElfStrTabBuilder builder(addNull!=0);
+        for (size_t i = 0; i < stringsNum; i++)
+            assertValue("testStrTab", testCaseName+".index", i, builder.add(strings[i]));
+        builder.build();
+        // only "__OpenCL_kernel" and "abc" must be stored
+        assertValue("testStrTab", testCaseName+".size", size_t(addNull + 16 + 4),
+                    builder.getSize());
+        if (addNull)
+            assertValue("testStrTab", testCaseName+".nullOffset", uint32_t(0),
+                        builder.getOffset(0));
+        for (size_t i = 0; i < stringsNum; i++)
+        {
+            std::ostringstream sOss;
+            sOss << testCaseName << ".str#" << i;
+            assertTrue("testStrTab", sOss.str()+".offset",
+                        builder.getOffset(i) < builder.getSize());
+            assertString("testStrTab", sOss.str(), strings[i]!=nullptr ? strings[i] : "",
+                        builder.getTable() + builder.getOffset(i));
+        }
+    }
+}
+
+// generate ELF with merged string tables
+static void testMergeStrTables()
+{
+    static const char* symNames[] = { "__OpenCL_a_kernel", "a_kernel", "kernel",
+            "__OpenCL_a_kernel", "", "__OpenCL_b_kernel", "b" };
+    const size_t symbolsNum = sizeof(symNames)/sizeof(const char*);
+    uint64_t strTabSizes[2];
+    for (cxuint merge = 0; merge < 2; merge++)
+    {
+        std::ostringstream oss;
+        oss << "mergeStrTables#" << merge;
+        const std::string testCaseName = oss.str();
+        static const cxbyte text[4] = { 1, 2, 3, 4 };
+        ElfBinaryGen64 elfBinGen({ 0, 0, ELFOSABI_SYSV, 0, ET_REL, 0, EV_CURRENT,
+                    UINT_MAX, 0, 0 });
+        elfBinGen.setMergeStrTables(merge!=0);
+        elfBinGen.addRegion(ElfRegion64(4, text, 4, ".text", SHT_PROGBITS,
+                    SHF_ALLOC|SHF_EXECINSTR));
+        elfBinGen.addRegion(ElfRegion64(4, text, 4, ".rela.text", SHT_PROGBITS, 0));
+        elfBinGen.addRegion(ElfRegion64::symtabSection());
+        elfBinGen.addRegion(ElfRegion64::strtabSection());
+        elfBinGen.addRegion(ElfRegion64::shstrtabSection());
+        elfBinGen.addRegion(ElfRegion64::sectionHeaderTable());
+        for (size_t i = 0; i < symbolsNum; i++)
+            elfBinGen.addSymbol(ElfSymbol64(symNames[i], 1,
+                    ELF64_ST_INFO(STB_GLOBAL, STT_FUNC), 0, false, i, 0));
+        
+        std::ostringstream binOss;
+        elfBinGen.generate(binOss);
+        const std::string binStr = binOss.str();
+        Array<cxbyte> binary(binStr.size());
+        std::copy(binStr.begin(), binStr.end(), binary.begin());
+        const ElfBinary64 elfBin(binary.size(), binary.data(), 0);
+        
+        assertValue("testMergeStrTab", testCaseName+".symbolsNum", symbolsNum+1,
+                    size_t(elfBin.getSymbolsNum()));
+        for (size_t i = 0; i < symbolsNum; i++)
+        {
+            std::ostringstream sOss;
+            sOss << testCaseName << ".sym#" << i;
+            assertString("testMergeStrTab", sOss.str(), symNames[i],
+                        elfBin.getSymbolName(i+1));
+        }
+        static const char* sectionNames[] = { "", ".text", ".rela.text", ".symtab",
+                ".strtab", ".shstrtab" };
+        assertValue("testMergeStrTab", testCaseName+".sectionsNum", size_t(6),
+                    size_t(elfBin.getSectionHeadersNum()));
+        for (size_t i = 0; i < 6; i++)
+        {
+            std::ostringstream sOss;
+            sOss << testCaseName << ".section#" << i;
+            assertString("testMergeStrTab", sOss.str(), sectionNames[i],
+                        elfBin.getSectionName(i));
+        }
+        strTabSizes[merge] = ULEV(elfBin.getSectionHeader(".strtab").sh_size);
+    }
+    assertValue("testMergeStrTab", "strTabSizes", uint64_t(1 + 18 + 18 + 2),
+                strTabSizes[1]);
+    assertTrue("testMergeStrTab", "strTabSizes", strTabSizes[1] < strTabSizes[0]);
+}
+
+int main(int argc, const char** argv)
+{
+    int retVal = 0;
+    try
+    { testStrTabBuilder(); }
+    catch(const std::exception& ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        retVal = 1;
+    }
+    try
+    { testMergeStrTables(); }
+    catch(const std::exception& ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        retVal = 1;
+    }
+    static const size_t symbolsNums[4] = { 3, 100, 1000, 5000 };
+    for (cxuint i = 0; i < 4; i++)
+        try
+        { testGnuHashCase(i, symbolsNums[i], (i&1)!=0); }
+        catch(const std::exception& ex)
+        {
+            std::cerr << ex.what() << std::endl;
+            retVal = 1;
+        }
+    return retVal;
+}
@@ -21,6 +21,8 @@
 #include <iostream>
 #include <sstream>
 #include <memory>
+#include <cstring>
+#include <algorithm>
 #include <CLRX/utils/Containers.h>
 #include <CLRX/amdbin/ROCmBinaries.h>
 
@@ -59,6 +61,7 @@ static ROCmInput genROCmInput(const ROCmBinary& binary)
     rocmInput.globalDataSize = binary.getGlobalDataSize();
     rocmInput.globalData = binary.getGlobalData();
     rocmInput.useMetadataInfo = false;
+    rocmInput.metadataMsgPack = binary.isMetadataMsgPack();
     
     {
         // load .note to determine architecture (major, minor and stepping)
@@ -144,6 +147,168 @@ static void testOrigBinary(cxuint testCase, const char* origBinaryFilename)
                     ": byte=" << i;
             throw Exception(oss.str());
         }
+    
+    // output written through stream must be this same as output written to memory
+    std::ostringstream streamOutput;
+    {
+        ROCmBinGenerator binGen2(&rocmInput);
+        binGen2.generate(streamOutput);
+    }
+    if (streamOutput.str() != std::string(reinterpret_cast<const char*>(output.data()),
+                output.size()))
+    {
+        std::ostringstream oss;
+        oss << "Failed for #" << testCase << " file=" << origBinaryFilename <<
+                ": stream output differs";
+        throw Exception(oss.str());
+    }
+    // and output with regions written in parallel
+    Array<cxbyte> parOutput;
+    {
+        ROCmBinGenerator binGen2(&rocmInput);
+        binGen2.generate(parOutput, 4);
+    }
+    if (parOutput.size() != output.size() ||
+        !std::equal(output.begin(), output.end(), parOutput.begin()))
+    {
+        std::ostringstream oss;
+        oss << "Failed for #" << testCase << " file=" << origBinaryFilename <<
+                ": parallel output differs";
+        throw Exception(oss.str());
+    }
+
+    // binary with merged string tables must give this same binary after regeneration
+    Array<cxbyte> mergedOutput;
+    {
+        ROCmBinGenerator binGen2(&rocmInput);
+        binGen2.setMergeStrTables(true);
+        binGen2.generate(mergedOutput);
+    }
+    ROCmBinary mergedBin(mergedOutput.size(), mergedOutput.data(), 0);
+    ROCmInput mergedInput = genROCmInput(mergedBin);
+    Array<cxbyte> regenOutput;
+    {
+        ROCmBinGenerator binGen2(&mergedInput);
+        binGen2.generate(regenOutput);
+    }
+    if (mergedOutput.size() > output.size() || regenOutput.size() != output.size() ||
+        !std::equal(output.begin(), output.end(), regenOutput.begin()))
+    {
+        std::ostringstream oss;
+        oss << "Failed for #" << testCase << " file=" << origBinaryFilename <<
+                ": output regenerated from merged string tables differs";
+        throw Exception(oss.str());
+    }
+}
+
+// compare lookups by hash indexes with lookups by scanning tables
+static void testNameLookup(cxuint testCase, const char* origBinaryFilename)
+{
+    std::string origBinFilenameStr(origBinaryFilename);
+    filesystemPath(origBinFilenameStr); // convert to system path (native separators)
+    Array<cxbyte> inputData = loadDataFromFile(origBinFilenameStr.c_str());
+    const ElfBinary64 hashedElf(inputData.size(), inputData.data(), ELF_CREATE_HASHINDEX);
+    const ElfBinary64 plainElf(inputData.size(), inputData.data(), 0);
+    // lazy view (from mapped file) creates maps and indexes while first lookup
+    MappedFile mappedFile(origBinFilenameStr.c_str());
+    const ElfBinary64 lazyElf(mappedFile, ELF_CREATE_ALL | ELF_CREATE_LAZY);
+    
+    auto failed = [testCase, origBinaryFilename](const char* what, const char* name)
+    {
+        std::ostringstream oss;
+        oss << "Failed for #" << testCase << " file=" << origBinaryFilename <<
+                ": " << what << "='" << name << "'";
+        throw Exception(oss.str());
+    };
+    for (uint16_t i = 1; i < plainElf.getSectionHeadersNum(); i++)
+    {
+        const char* name = plainElf.getSectionName(i);
+        if (hashedElf.findSectionIndex(name) != plainElf.findSectionIndex(name) ||
+            lazyElf.findSectionIndex(name) != plainElf.findSectionIndex(name))
+            failed("section", name);
+    }
+    for (size_t i = 1; i < plainElf.getSymbolsNum(); i++)
+    {
+        const char* name = plainElf.getSymbolName(i);
+        if (hashedElf.findSymbolIndex(name) != plainElf.findSymbolIndex(name) ||
+            lazyElf.findSymbolIndex(name) != plainElf.findSymbolIndex(name))
+            failed("symbol", name);
+    }
+    for (size_t i = 1; i < plainElf.getDynSymbolsNum(); i++)
+    {
+        const char* name = plainElf.getDynSymbolName(i);
+        if (hashedElf.findDynSymbolIndex(name) != plainElf.findDynSymbolIndex(name) ||
+            lazyElf.findDynSymbolIndex(name) != plainElf.findDynSymbolIndex(name))
+            failed("dynsymbol", name);
+    }
+    // names that do not exist
+    if (hashedElf.findSectionIndex(".nosection") != SHN_UNDEF)
+        failed("section", ".nosection");
+    if (hashedElf.findSymbolIndex("nosymbol") != STN_UNDEF)
+        failed("symbol", "nosymbol");
+    if (hashedElf.findDynSymbolIndex("nosymbol") != STN_UNDEF)
+        failed("dynsymbol", "nosymbol");
+    // null section is found only by get* functions
+    if (hashedElf.getSectionIndex("") != SHN_UNDEF)
+        failed("section", "");
+}
+
+// returns true if lazy view rejects binary with changed field
+template<typename T>
+static bool lazyRejectsMalformed(const Array<cxbyte>& inputData, const T& field, T value)
+{
+    Array<cxbyte> malformed = inputData;
+    const size_t fieldOffset = (const cxbyte*)&field - inputData.data();
+    SULEV(*reinterpret_cast<T*>(malformed.data() + fieldOffset), value);
+    try
+    {
+        ElfBinary64 lazyElf(malformed.size(), malformed.data(),
+                    ELF_CREATE_ALL | ELF_CREATE_LAZY);
+    }
+    catch(const BinException& ex)
+    { return true; }
+    return false;
+}
+
+// lazy view must check binary while construction like other views
+static void testLazyMalformed(cxuint testCase, const char* origBinaryFilename)
+{
+    std::string origBinFilenameStr(origBinaryFilename);
+    filesystemPath(origBinFilenameStr); // convert to system path (native separators)
+    Array<cxbyte> inputData = loadDataFromFile(origBinFilenameStr.c_str());
+    const ElfBinary64 plainElf(inputData.size(), inputData.data(), 0);
+    const uint16_t shnum = plainElf.getSectionHeadersNum();
+    uint16_t progSectIndex = SHN_UNDEF;
+    for (uint16_t i = 1; i < shnum && progSectIndex == SHN_UNDEF; i++)
+        if (ULEV(plainElf.getSectionHeader(i).sh_type) != SHT_NOBITS)
+            progSectIndex = i;
+    const Elf64_Shdr& progShdr = plainElf.getSectionHeader(progSectIndex);
+    
+    auto failed = [testCase, origBinaryFilename](const char* what)
+    {
+        std::ostringstream oss;
+        oss << "Failed for #" << testCase << " file=" << origBinaryFilename <<
+                ": lazy view accepts malformed " << what;
+        throw Exception(oss.str());
+    };
+    const uint64_t outOfRange = inputData.size() + 1;
+    if (!lazyRejectsMalformed(inputData, progShdr.sh_offset, outOfRange))
+        failed("section offset");
+    if (!lazyRejectsMalformed(inputData, progShdr.sh_size, outOfRange))
+        failed("section size");
+    if (!lazyRejectsMalformed(inputData, progShdr.sh_link, uint32_t(shnum)))
+        failed("section link");
+    if (!lazyRejectsMalformed(inputData, progShdr.sh_name, uint32_t(outOfRange)))
+        failed("section name");
+    if (plainElf.getProgramHeadersNum() != 0 && !lazyRejectsMalformed(inputData,
+                plainElf.getProgramHeader(0).p_offset, outOfRange))
+        failed("segment offset");
+    if (plainElf.getSymbolsNum() > 1 && !lazyRejectsMalformed(inputData,
+                plainElf.getSymbol(1).st_name, uint32_t(outOfRange)))
+        failed("symbol name");
+    if (plainElf.getDynSymbolsNum() > 1 && !lazyRejectsMalformed(inputData,
+                plainElf.getDynSymbol(1).st_name, uint32_t(outOfRange)))
+        failed("dynsymbol name");
 }
 
 int main(int argc, const char** argv)
@@ -151,7 +316,11 @@ int main(int argc, const char** argv)
     int retVal = 0;
     for (cxuint i = 0; i < sizeof(origBinaryFiles)/sizeof(const char*); i++)
         try
-        { testOrigBinary(i, origBinaryFiles[i]); }
+        {
+            testOrigBinary(i, origBinaryFiles[i]);
+            testNameLookup(i, origBinaryFiles[i]);
+            testLazyMalformed(i, origBinaryFiles[i]);
+        }
         catch(const std::exception& ex)
         {
             std::cerr << ex.what() << std::endl;
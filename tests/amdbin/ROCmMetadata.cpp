@@ -23,6 +23,8 @@
 #include <string>
 #include <cstring>
 #include <memory>
+#include <chrono>
+#include <algorithm>
 #include <CLRX/utils/Containers.h>
 #include <CLRX/amdbin/ROCmBinaries.h>
 #include "../TestUtils.h"
@@ -1334,46 +1336,10 @@ Kernels:
     }
 };
 
-static void testROCmMetadataCase(cxuint testId, const ROCmMetadataTestCase& testCase)
+// check metadata info (msgPack - skip fields that are not in code object v3)
+static void checkROCmMetadata(const char* testName, const ROCmMetadata& expected,
+            const ROCmMetadata& result, bool msgPack)
 {
-    ROCmInput rocmInput{};
-    rocmInput.deviceType = GPUDeviceType::FIJI;
-    rocmInput.archMinor = 0;
-    rocmInput.archStepping = 3;
-    rocmInput.newBinFormat = true;
-    rocmInput.target = "amdgcn-amd-amdhsa-amdgizcl-gfx803";
-    rocmInput.metadataSize = ::strlen(testCase.input);
-    rocmInput.metadata = testCase.input;
-    // generate simple binary with metadata
-    Array<cxbyte> output;
-    {
-        ROCmBinGenerator binGen(&rocmInput);
-        binGen.generate(output);
-    }
-    // now we load binary
-    const ROCmMetadata& expected = testCase.expected;
-    ROCmMetadata result;
-    bool good = true;
-    CString error;
-    try
-    {
-        ROCmBinary binary(output.size(), output.data(), ROCMBIN_CREATE_METADATAINFO);
-        result = binary.getMetadataInfo();
-    }
-    catch(const ParseException& ex)
-    {
-        good = false;
-        error = ex.what();
-    }
-    
-    char testName[30];
-    snprintf(testName, 30, "Test #%u", testId);
-    assertValue(testName, "good", testCase.good, good);
-    assertString(testName, "error", testCase.error, error.c_str());
-    if (!good)
-        // do not check if test failed
-        return;
-    
     assertValue(testName, "version[0]", expected.version[0], result.version[0]);
     assertValue(testName, "version[1]", expected.version[1], result.version[1]);
     assertValue(testName, "printfInfosNum", expected.printfInfos.size(),
@@ -1427,7 +1393,9 @@ static void testROCmMetadataCase(cxuint testId, const ROCmMetadataTestCase& test
                         expArgInfo.typeName, resArgInfo.typeName);
             assertValue(testName, caseName2+"size",
                         expArgInfo.size, resArgInfo.size);
-            assertValue(testName, caseName2+"align",
+            if (!msgPack)
+                // alignments are not stored in code object v3
+                assertValue(testName, caseName2+"align",
                         expArgInfo.align, resArgInfo.align);
             assertValue(testName, caseName2+"pointeeAlign",
                         expArgInfo.pointeeAlign, resArgInfo.pointeeAlign);
@@ -1486,12 +1454,16 @@ static void testROCmMetadataCase(cxuint testId, const ROCmMetadataTestCase& test
         assertValue(testName, caseName+"vgprsNum", expKernel.vgprsNum, resKernel.vgprsNum);
         assertValue(testName, caseName+"maxFlatWorkGroupSize",
                     expKernel.maxFlatWorkGroupSize, resKernel.maxFlatWorkGroupSize);
-        assertValue(testName, caseName+"fixedWorkGroupSize[0]",
-                    expKernel.fixedWorkGroupSize[0], resKernel.fixedWorkGroupSize[0]);
-        assertValue(testName, caseName+"fixedWorkGroupSize[1]",
-                    expKernel.fixedWorkGroupSize[1], resKernel.fixedWorkGroupSize[1]);
-        assertValue(testName, caseName+"fixedWorkGroupSize[2]",
-                    expKernel.fixedWorkGroupSize[2], resKernel.fixedWorkGroupSize[2]);
+        if (!msgPack)
+        {
+            // no fixed work group size in code object v3
+            assertValue(testName, caseName+"fixedWorkGroupSize[0]",
+                        expKernel.fixedWorkGroupSize[0], resKernel.fixedWorkGroupSize[0]);
+            assertValue(testName, caseName+"fixedWorkGroupSize[1]",
+                        expKernel.fixedWorkGroupSize[1], resKernel.fixedWorkGroupSize[1]);
+            assertValue(testName, caseName+"fixedWorkGroupSize[2]",
+                        expKernel.fixedWorkGroupSize[2], resKernel.fixedWorkGroupSize[2]);
+        }
         assertValue(testName, caseName+"spilledSgprs",
                     expKernel.spilledSgprs, resKernel.spilledSgprs);
         assertValue(testName, caseName+"spilledVgprs",
@@ -1499,6 +1471,243 @@ static void testROCmMetadataCase(cxuint testId, const ROCmMetadataTestCase& test
     }
 }
 
+static void testROCmMetadataCase(cxuint testId, const ROCmMetadataTestCase& testCase)
+{
+    ROCmInput rocmInput{};
+    rocmInput.deviceType = GPUDeviceType::FIJI;
+    rocmInput.archMinor = 0;
+    rocmInput.archStepping = 3;
+    rocmInput.newBinFormat = true;
+    rocmInput.target = "amdgcn-amd-amdhsa-amdgizcl-gfx803";
+    rocmInput.metadataSize = ::strlen(testCase.input);
+    rocmInput.metadata = testCase.input;
+    // generate simple binary with metadata
+    Array<cxbyte> output;
+    {
+        ROCmBinGenerator binGen(&rocmInput);
+        binGen.generate(output);
+    }
+    // now we load binary
+    const ROCmMetadata& expected = testCase.expected;
+    ROCmMetadata result;
+    bool good = true;
+    CString error;
+    try
+    {
+        ROCmBinary binary(output.size(), output.data(), ROCMBIN_CREATE_METADATAINFO);
+        result = binary.getMetadataInfo();
+    }
+    catch(const ParseException& ex)
+    {
+        good = false;
+        error = ex.what();
+    }
+    
+    char testName[30];
+    snprintf(testName, 30, "Test #%u", testId);
+    assertValue(testName, "good", testCase.good, good);
+    assertString(testName, "error", testCase.error, error.c_str());
+    if (!good)
+        // do not check if test failed
+        return;
+    checkROCmMetadata(testName, expected, result, false);
+}
+
+// generate binaries with YAML and MsgPack metadata from this same metadata info
+// and compare metadata infos loaded from these binaries
+static void testROCmMsgPackMetadataCase(cxuint testId,
+            const ROCmMetadataTestCase& testCase)
+{
+    if (!testCase.good)
+        return;
+    ROCmInput rocmInput{};
+    rocmInput.deviceType = GPUDeviceType::FIJI;
+    rocmInput.archMinor = 0;
+    rocmInput.archStepping = 3;
+    rocmInput.newBinFormat = true;
+    rocmInput.target = "amdgcn-amd-amdhsa-amdgizcl-gfx803";
+    rocmInput.useMetadataInfo = true;
+    rocmInput.metadataInfo.parse(::strlen(testCase.input), testCase.input);
+    // kernels with zeroed kernel configs
+    const size_t kernelsNum = rocmInput.metadataInfo.kernels.size();
+    Array<cxbyte> code(kernelsNum*256);
+    std::fill(code.begin(), code.end(), cxbyte(0));
+    for (size_t k = 0; k < kernelsNum; k++)
+        rocmInput.symbols.push_back({ rocmInput.metadataInfo.kernels[k].name,
+                    k*256, 256, ROCmRegionType::KERNEL });
+    rocmInput.codeSize = code.size();
+    rocmInput.code = code.data();
+    
+    char testName[40];
+    snprintf(testName, 40, "MsgPackTest #%u", testId);
+    ROCmMetadata results[2];
+    for (cxuint msgPack = 0; msgPack < 2; msgPack++)
+    {
+        rocmInput.metadataMsgPack = (msgPack != 0);
+        Array<cxbyte> output;
+        {
+            ROCmBinGenerator binGen(&rocmInput);
+            binGen.generate(output);
+        }
+        ROCmBinary binary(output.size(), output.data(), ROCMBIN_CREATE_METADATAINFO);
+        assertValue(testName, "metadataMsgPack", rocmInput.metadataMsgPack,
+                    binary.isMetadataMsgPack());
+        results[msgPack] = binary.getMetadataInfo();
+    }
+    checkROCmMetadata(testName, results[0], results[1], true);
+}
+
+// generate metadata with many kernels (names of odd kernels are escaped)
+static std::string generateLargeMetadata(cxuint kernelsNum)
+{
+    std::ostringstream oss;
+    oss << "---\nVersion:         [ 1, 0 ]\nKernels:\n";
+    for (cxuint i = 0; i < kernelsNum; i++)
+    {
+        if ((i&1) == 0)
+            oss << "  - Name:            kernel" << i << "\n";
+        else
+            oss << "  - Name:            'kern\\x65l" << i << "'\n";
+        oss << "    SymbolName:      'kernel" << i << "@kd'\n"
+            "    Language:        OpenCL C\n"
+            "    LanguageVersion: [ 1, 2 ]\n"
+            "    Attrs:\n"
+            "      ReqdWorkGroupSize: [ 64, 1, 1 ]\n"
+            "      VecTypeHint:     int\n"
+            "    Args:\n";
+        for (cxuint j = 0; j < 6; j++)
+            oss << "      - Name:            arg" << j << "\n"
+                "        TypeName:        'float*'\n"
+                "        Size:            8\n"
+                "        Align:           8\n"
+                "        ValueKind:       GlobalBuffer\n"
+                "        ValueType:       F32\n"
+                "        AddrSpaceQual:   Global   # comment\n"
+                "        AccQual:         ReadOnly\n"
+                "        IsConst:         true\n";
+        oss << "    CodeProps:\n"
+            "      KernargSegmentSize: 64\n"
+            "      GroupSegmentFixedSize: 0\n"
+            "      PrivateSegmentFixedSize: 0\n"
+            "      KernargSegmentAlign: 8\n"
+            "      WavefrontSize:   64\n"
+            "      NumSGPRs:        14\n"
+            "      NumVGPRs:        " << (i&63) << "\n"
+            "      MaxFlatWorkGroupSize: 256\n";
+    }
+    oss << "...\n";
+    return oss.str();
+}
+
+static void testLargeMetadata()
+{
+    const std::string input = generateLargeMetadata(100);
+    ROCmMetadata result;
+    result.parse(input.size(), input.c_str());
+    assertValue("LargeMetadata", "kernelsNum", size_t(100), result.kernels.size());
+    char buf[32];
+    for (cxuint i = 0; i < 100; i++)
+    {
+        snprintf(buf, 32, "Kernel[%u].", i);
+        std::string caseName(buf);
+        const ROCmKernelMetadata& kernel = result.kernels[i];
+        snprintf(buf, 32, "kernel%u", i);
+        assertString("LargeMetadata", caseName+"name", buf, kernel.name.c_str());
+        snprintf(buf, 32, "kernel%u@kd", i);
+        assertString("LargeMetadata", caseName+"symbolName", buf,
+                    kernel.symbolName.c_str());
+        assertString("LargeMetadata", caseName+"vecTypeHint", "int",
+                    kernel.vecTypeHint.c_str());
+        assertValue("LargeMetadata", caseName+"vgprsNum", i&63, kernel.vgprsNum);
+        assertValue("LargeMetadata", caseName+"argsNum", size_t(6),
+                    kernel.argInfos.size());
+        const ROCmKernelArgInfo& argInfo = kernel.argInfos[5];
+        assertString("LargeMetadata", caseName+"args[5].typeName", "float*",
+                    argInfo.typeName.c_str());
+        assertValue("LargeMetadata", caseName+"args[5].valueKind",
+                cxuint(ROCmValueKind::GLOBAL_BUFFER), cxuint(argInfo.valueKind));
+        assertValue("LargeMetadata", caseName+"args[5].valueType",
+                cxuint(ROCmValueType::FLOAT32), cxuint(argInfo.valueType));
+        assertValue("LargeMetadata", caseName+"args[5].addressSpace",
+                cxuint(ROCmAddressSpace::GLOBAL), cxuint(argInfo.addressSpace));
+        assertValue("LargeMetadata", caseName+"args[5].accessQual",
+                cxuint(ROCmAccessQual::READ_ONLY), cxuint(argInfo.accessQual));
+        assertValue("LargeMetadata", caseName+"args[5].isConst",
+                cxuint(true), cxuint(argInfo.isConst));
+    }
+}
+
+struct MalformedMsgPackCase
+{
+    Array<cxbyte> input;
+    const char* error;
+};
+
+// malformed MsgPack metadata (too large counts and values out of range)
+static const MalformedMsgPackCase malformedMsgPackCases[] =
+{
+    {   // array of kernels with too many elements
+        { 0x81, 0xae, 'a', 'm', 'd', 'h', 's', 'a', '.', 'k', 'e', 'r', 'n', 'e', 'l', 's',
+          0xdd, 0xff, 0xff, 0xff, 0xff, 0x80 },
+        "MsgPack: Unexpected end of data"
+    },
+    {   // main map with too many entries
+        { 0xdf, 0x7f, 0xff, 0xff, 0xff, 0xa1, 'a', 0x00 },
+        "MsgPack: Unexpected end of data"
+    },
+    {   // array of printf infos with too many elements
+        { 0x81, 0xad, 'a', 'm', 'd', 'h', 's', 'a', '.', 'p', 'r', 'i', 'n', 't', 'f',
+          0xdc, 0x00, 0x10, 0xa1, '1' },
+        "MsgPack: Unexpected end of data"
+    },
+    {   // sgpr count out of range
+        { 0x81, 0xae, 'a', 'm', 'd', 'h', 's', 'a', '.', 'k', 'e', 'r', 'n', 'e', 'l', 's',
+          0x91, 0x81, 0xab, '.', 's', 'g', 'p', 'r', '_', 'c', 'o', 'u', 'n', 't',
+          0xcf, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00 },
+        "MsgPack: Integer value out of range"
+    },
+    {   // version out of range
+        { 0x81, 0xae, 'a', 'm', 'd', 'h', 's', 'a', '.', 'v', 'e', 'r', 's', 'i', 'o', 'n',
+          0x92, 0x01, 0xcf, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00 },
+        "MsgPack: Integer value out of range"
+    }
+};
+
+static void testMalformedMsgPack(cxuint testId, const MalformedMsgPackCase& testCase)
+{
+    char testName[40];
+    snprintf(testName, 40, "MalformedMsgPack #%u", testId);
+    ROCmMetadata result;
+    assertCLRXException(testName, "error", testCase.error,
+            [&result, &testCase]()
+            { result.parseMsgPack(testCase.input.size(), testCase.input.data()); });
+}
+
+// benchmark: parse inputs of good test cases and large metadata many times
+static void benchmarkMetadata(cxuint iterations)
+{
+    const std::string largeInput = generateLargeMetadata(100);
+    size_t totalSize = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (cxuint it = 0; it < iterations; it++)
+    {
+        for (const ROCmMetadataTestCase& testCase: rocmMetadataTestCases)
+            if (testCase.good)
+            {
+                ROCmMetadata result;
+                const size_t inputSize = ::strlen(testCase.input);
+                result.parse(inputSize, testCase.input);
+                totalSize += inputSize;
+            }
+        ROCmMetadata result;
+        result.parse(largeInput.size(), largeInput.c_str());
+        totalSize += largeInput.size();
+    }
+    const std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+    std::cout << "Parsed " << totalSize << " bytes in " << time.count() << " s (" <<
+            (totalSize / time.count() / 1048576.0) << " MB/s)" << std::endl;
+}
+
 int main(int argc, const char** argv)
 {
     int retVal = 0;
@@ -1510,5 +1719,34 @@ int main(int argc, const char** argv)
             std::cerr << ex.what() << std::endl;
             retVal = 1;
         }
+    for (cxuint i = 0; i < sizeof(rocmMetadataTestCases)/sizeof(ROCmMetadataTestCase); i++)
+        try
+        { testROCmMsgPackMetadataCase(i, rocmMetadataTestCases[i]); }
+        catch(const std::exception& ex)
+        {
+            std::cerr << ex.what() << std::endl;
+            retVal = 1;
+        }
+    for (cxuint i = 0; i < sizeof(malformedMsgPackCases)/sizeof(MalformedMsgPackCase); i++)
+        retVal |= callTest(testMalformedMsgPack, i, malformedMsgPackCases[i]);
+    try
+    { testLargeMetadata(); }
+    catch(const std::exception& ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        retVal = 1;
+    }
+    // run benchmark only if iterations number given
+    if (argc >= 2)
+        try
+        {
+            const char* outend;
+            benchmarkMetadata(cstrtovCStyle<cxuint>(argv[1], nullptr, outend));
+        }
+        catch(const std::exception& ex)
+        {
+            std::cerr << ex.what() << std::endl;
+            retVal = 1;
+        }
     return retVal;
 }
@@ -307,6 +307,115 @@ static void testGetGPUExtraRegsNum()
     }
 }
 
+struct GPUWavesRegsTestCase
+{
+    GPUArchitecture arch;
+    cxuint regType;
+    cxuint wavesNum;
+    cxuint regsNum;
+};
+
+// getGPUMaxRegsNumForWaves testcase table
+static const GPUWavesRegsTestCase gpuMaxRegsForWavesTestTable[] =
+{
+    { GPUArchitecture::GCN1_0, REGTYPE_VGPR, 10, 24 },
+    { GPUArchitecture::GCN1_2, REGTYPE_VGPR, 9, 28 },
+    { GPUArchitecture::GCN1_2, REGTYPE_VGPR, 6, 40 },
+    { GPUArchitecture::GCN1_4, REGTYPE_VGPR, 3, 84 },
+    { GPUArchitecture::GCN1_4, REGTYPE_VGPR, 1, 256 },
+    { GPUArchitecture::GCN1_0, REGTYPE_SGPR, 10, 48 },
+    { GPUArchitecture::GCN1_1, REGTYPE_SGPR, 8, 64 },
+    { GPUArchitecture::GCN1_1, REGTYPE_SGPR, 5, 96 },
+    { GPUArchitecture::GCN1_0, REGTYPE_SGPR, 4, 106 },
+    { GPUArchitecture::GCN1_1, REGTYPE_SGPR, 4, 108 },
+    { GPUArchitecture::GCN1_2, REGTYPE_SGPR, 10, 80 },
+    { GPUArchitecture::GCN1_2, REGTYPE_SGPR, 9, 80 },
+    { GPUArchitecture::GCN1_2, REGTYPE_SGPR, 8, 96 },
+    { GPUArchitecture::GCN1_4, REGTYPE_SGPR, 7, 108 }
+};
+
+static void testGetGPUMaxRegsNumForWaves()
+{
+    char descBuf[60];
+    for (cxuint i = 0; i < sizeof gpuMaxRegsForWavesTestTable/
+                sizeof(GPUWavesRegsTestCase); i++)
+    {
+        const GPUWavesRegsTestCase testCase = gpuMaxRegsForWavesTestTable[i];
+        snprintf(descBuf, sizeof descBuf, "Test %d", i);
+        const cxuint result = getGPUMaxRegsNumForWaves(testCase.arch, testCase.regType,
+                                testCase.wavesNum);
+        assertValue("testGetGPUMaxRegsNumForWaves", descBuf,
+                    testCase.regsNum, result);
+    }
+}
+
+// getGPUWavesNumForRegs testcase table
+static const GPUWavesRegsTestCase gpuWavesForRegsTestTable[] =
+{
+    { GPUArchitecture::GCN1_0, REGTYPE_VGPR, 10, 0 },
+    { GPUArchitecture::GCN1_0, REGTYPE_VGPR, 10, 24 },
+    { GPUArchitecture::GCN1_0, REGTYPE_VGPR, 9, 25 },
+    { GPUArchitecture::GCN1_2, REGTYPE_VGPR, 4, 64 },
+    { GPUArchitecture::GCN1_2, REGTYPE_VGPR, 3, 65 },
+    { GPUArchitecture::GCN1_2, REGTYPE_VGPR, 1, 256 },
+    { GPUArchitecture::GCN1_1, REGTYPE_SGPR, 10, 48 },
+    { GPUArchitecture::GCN1_1, REGTYPE_SGPR, 9, 50 },
+    { GPUArchitecture::GCN1_2, REGTYPE_SGPR, 10, 80 },
+    { GPUArchitecture::GCN1_2, REGTYPE_SGPR, 8, 81 },
+    { GPUArchitecture::GCN1_2, REGTYPE_SGPR, 7, 108 }
+};
+
+static void testGetGPUWavesNumForRegs()
+{
+    char descBuf[60];
+    for (cxuint i = 0; i < sizeof gpuWavesForRegsTestTable/
+                sizeof(GPUWavesRegsTestCase); i++)
+    {
+        const GPUWavesRegsTestCase testCase = gpuWavesForRegsTestTable[i];
+        snprintf(descBuf, sizeof descBuf, "Test %d", i);
+        const cxuint result = getGPUWavesNumForRegs(testCase.arch, testCase.regType,
+                                testCase.regsNum);
+        assertValue("testGetGPUWavesNumForRegs", descBuf,
+                    testCase.wavesNum, result);
+    }
+}
+
+struct GPUWavesLocalSizeTestCase
+{
+    GPUArchitecture arch;
+    size_t localSize;
+    cxuint workGroupSize;
+    cxuint wavesNum;
+};
+
+// getGPUWavesNumForLocalSize testcase table
+static const GPUWavesLocalSizeTestCase gpuWavesForLocalSizeTestTable[] =
+{
+    { GPUArchitecture::GCN1_0, 0, 256, 10 },
+    { GPUArchitecture::GCN1_0, 6400, 256, 10 },
+    { GPUArchitecture::GCN1_0, 7000, 256, 9 },
+    { GPUArchitecture::GCN1_2, 6400, 256, 9 },
+    { GPUArchitecture::GCN1_2, 20000, 256, 3 },
+    { GPUArchitecture::GCN1_2, 32768, 256, 2 },
+    { GPUArchitecture::GCN1_2, 32768, 64, 1 },
+    { GPUArchitecture::GCN1_2, 4096, 1024, 10 },
+    { GPUArchitecture::GCN1_4, 16384, 512, 8 }
+};
+
+static void testGetGPUWavesNumForLocalSize()
+{
+    char descBuf[60];
+    for (cxuint i = 0; i < sizeof gpuWavesForLocalSizeTestTable/
+                sizeof(GPUWavesLocalSizeTestCase); i++)
+    {
+        const GPUWavesLocalSizeTestCase testCase = gpuWavesForLocalSizeTestTable[i];
+        snprintf(descBuf, sizeof descBuf, "Test %d", i);
+        const cxuint result = getGPUWavesNumForLocalSize(testCase.arch,
+                    testCase.localSize, testCase.workGroupSize);
+        assertValue("testGetGPUWavesNumForLocalSize", descBuf,
+                    testCase.wavesNum, result);
+    }
+}
 
 int main(int argc, const char** argv)
 {
@@ -315,5 +424,8 @@ int main(int argc, const char** argv)
     retVal |= callTest(testGetGPUArchitectureFromName);
     retVal |= callTest(testGetGPUMaxRegistersNum);
     retVal |= callTest(testGetGPUExtraRegsNum);
+    retVal |= callTest(testGetGPUMaxRegsNumForWaves);
+    retVal |= callTest(testGetGPUWavesNumForRegs);
+    retVal |= callTest(testGetGPUWavesNumForLocalSize);
     return retVal;
 }
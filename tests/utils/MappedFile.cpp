@@ -0,0 +1,96 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <CLRX/Config.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <cstring>
+#include <CLRX/utils/Utilities.h>
+#include <CLRX/utils/Containers.h>
+#include "../TestUtils.h"
+
+using namespace CLRX;
+
+static const char* testFilename =
+        CLRX_SOURCE_DIR "/tests/amdbin/rocmbins/vectoradd-rocm.clo.regen";
+
+static std::string getTestFilePath()
+{
+    std::string path(testFilename);
+    filesystemPath(path); // convert to system path (native separators)
+    return path;
+}
+
+static void testMappedFileContent()
+{
+    const std::string path = getTestFilePath();
+    Array<cxbyte> loaded = loadDataFromFile(path.c_str());
+    const MappedFile mappedFile(path.c_str());
+    assertValue("testMappedFile", "size", loaded.size(), mappedFile.size());
+    assertTrue("testMappedFile", "content",
+            ::memcmp(mappedFile.data(), loaded.data(), loaded.size()) == 0);
+    // mapped content without copy-on-write is read-only
+    assertTrue("testMappedFile", "writable",
+            !mappedFile.isMapped() || !mappedFile.isWritable());
+}
+
+static void testMappedFileCopyOnWrite()
+{
+    const std::string path = getTestFilePath();
+    Array<cxbyte> loaded = loadDataFromFile(path.c_str());
+    const MappedFile mappedFile(path.c_str());
+    {
+        // changes in copy-on-write mapping are not visible in other mappings
+        MappedFile cowFile(path.c_str(), MAPFILE_COPYONWRITE);
+        assertTrue("testMappedFileCOW", "writable", cowFile.isWritable());
+        cowFile.data()[0] ^= 0xff;
+        assertValue("testMappedFileCOW", "changed", int(cxbyte(loaded[0]^0xff)),
+                int(cowFile.data()[0]));
+        assertValue("testMappedFileCOW", "content", int(loaded[0]),
+                int(mappedFile.data()[0]));
+    }
+    // file is not changed
+    Array<cxbyte> loaded2 = loadDataFromFile(path.c_str());
+    assertTrue("testMappedFileCOW", "file",
+            loaded.size() == loaded2.size() &&
+            ::memcmp(loaded.data(), loaded2.data(), loaded.size()) == 0);
+}
+
+static void testMappedFileErrors()
+{
+    std::string dirPath(CLRX_SOURCE_DIR "/tests/amdbin/rocmbins");
+    filesystemPath(dirPath);
+    assertCLRXException("testMappedFileErrors", "directory", "This is directory!",
+            [&dirPath]() { MappedFile mappedFile(dirPath.c_str()); });
+    std::string noFilePath(CLRX_SOURCE_DIR "/tests/amdbin/rocmbins/nofile.xxx");
+    filesystemPath(noFilePath);
+    assertCLRXException("testMappedFileErrors", "nofile",
+            "File or directory doesn't exists",
+            [&noFilePath]() { MappedFile mappedFile(noFilePath.c_str()); });
+}
+
+int main(int argc, const char** argv)
+{
+    int retVal = 0;
+    retVal |= callTest(testMappedFileContent);
+    retVal |= callTest(testMappedFileCopyOnWrite);
+    retVal |= callTest(testMappedFileErrors);
+    return retVal;
+}
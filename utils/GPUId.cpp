@@ -22,6 +22,7 @@
 #include <utility>
 #include <cstdint>
 #include <climits>
+#include <algorithm>
 #include <CLRX/utils/Utilities.h>
 #include <CLRX/utils/GPUId.h>
 
@@ -332,6 +333,52 @@ cxuint CLRX::getGPUExtraRegsNum(GPUArchitecture architecture, cxuint regType, Fl
     return 0;
 }
 
+cxuint CLRX::getGPUMaxRegsNumForWaves(GPUArchitecture architecture, cxuint regType,
+              cxuint wavesNum)
+{
+    if (architecture > GPUArchitecture::GPUARCH_MAX)
+        throw GPUIdException("Unknown GPU architecture");
+    wavesNum = std::min(std::max(wavesNum, 1U), cxuint(GPU_MAX_WAVES_PER_SIMD));
+    cxuint regsNum;
+    if (regType == REGTYPE_VGPR)
+        // 256 VGPRs per SIMD lane, allocated in 4 register blocks
+        regsNum = (256U/wavesNum) & ~3U;
+    else if (architecture >= GPUArchitecture::GCN1_2)
+        // 800 SGPRs per SIMD, allocated in 16 register blocks
+        regsNum = (800U/wavesNum) & ~15U;
+    else
+        // 512 SGPRs per SIMD, allocated in 8 register blocks
+        regsNum = (512U/wavesNum) & ~7U;
+    const cxuint maxRegsNum = (regType == REGTYPE_VGPR) ? 256 :
+            getGPUMaxRegistersNum(architecture, regType) +
+            getGPUExtraRegsNum(architecture, regType, GCN_VCC|GCN_FLAT);
+    return std::min(regsNum, maxRegsNum);
+}
+
+cxuint CLRX::getGPUWavesNumForRegs(GPUArchitecture architecture, cxuint regType,
+              cxuint regsNum)
+{
+    cxuint wavesNum = GPU_MAX_WAVES_PER_SIMD;
+    for (; wavesNum > 1; wavesNum--)
+        if (regsNum <= getGPUMaxRegsNumForWaves(architecture, regType, wavesNum))
+            break;
+    return wavesNum;
+}
+
+cxuint CLRX::getGPUWavesNumForLocalSize(GPUArchitecture architecture, size_t localSize,
+              cxuint workGroupSize)
+{
+    if (localSize == 0)
+        return GPU_MAX_WAVES_PER_SIMD;
+    // 64 KB of LDS per compute unit, allocation granularity depends on architecture
+    const size_t granularity = (architecture == GPUArchitecture::GCN1_0) ? 256 : 512;
+    localSize = (localSize + granularity-1) & ~(granularity-1);
+    const size_t groupsNum = 65536 / localSize;
+    // waves of work groups are distributed between 4 SIMDs
+    const size_t wavesNum = (groupsNum * ((std::max(workGroupSize, 1U)+63)>>6) + 3) >> 2;
+    return std::min(wavesNum, size_t(GPU_MAX_WAVES_PER_SIMD));
+}
+
 uint32_t CLRX::calculatePgmRSrc1(GPUArchitecture arch, cxuint vgprsNum, cxuint sgprsNum,
             cxuint priority, cxuint floatMode, bool privMode, bool dx10Clamp,
             bool debugMode, bool ieeeMode)
@@ -30,6 +30,7 @@
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
+#include <sys/mman.h>
 #endif
 #include <fstream>
 #include <fcntl.h>
@@ -463,6 +464,84 @@ Array<cxbyte> CLRX::loadDataFromFile(const char* filename)
     return buf;
 }
 
+MappedFile::MappedFile() : fileSize(0), content(nullptr), mapped(false), writable(false)
+{ }
+
+MappedFile::MappedFile(const char* filename, Flags flags)
+        : fileSize(0), content(nullptr), mapped(false), writable(false)
+{
+    if (isDirectory(filename))
+        throw Exception("This is directory!");
+    const bool copyOnWrite = (flags & MAPFILE_COPYONWRITE) != 0;
+#ifdef HAVE_WINDOWS
+    HANDLE file = CreateFile(filename, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        throw Exception("Can't open file");
+    LARGE_INTEGER size;
+    // map only regular (disk) files
+    if (GetFileType(file) == FILE_TYPE_DISK && GetFileSizeEx(file, &size) &&
+        size.QuadPart > 0 && uint64_t(size.QuadPart) <= SIZE_MAX)
+    {
+        HANDLE mapping = CreateFileMapping(file, nullptr,
+                copyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr);
+        if (mapping != nullptr)
+        {
+            void* ptr = MapViewOfFile(mapping,
+                    copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping); // view holds mapping
+            if (ptr != nullptr)
+            {
+                content = reinterpret_cast<cxbyte*>(ptr);
+                fileSize = size.QuadPart;
+                mapped = true;
+            }
+        }
+    }
+    CloseHandle(file);
+#elif defined(HAVE_LINUX) || defined(HAVE_BSD)
+    int fd = ::open(filename, O_RDONLY);
+    if (fd < 0)
+        throw Exception("Can't open file");
+    struct stat stBuf;
+    // map only regular files
+    if (::fstat(fd, &stBuf) == 0 && S_ISREG(stBuf.st_mode) && stBuf.st_size > 0 &&
+        uint64_t(stBuf.st_size) <= SIZE_MAX)
+    {
+        void* ptr = ::mmap(nullptr, stBuf.st_size,
+                copyOnWrite ? (PROT_READ|PROT_WRITE) : PROT_READ, MAP_PRIVATE, fd, 0);
+        if (ptr != MAP_FAILED)
+        {
+            content = reinterpret_cast<cxbyte*>(ptr);
+            fileSize = stBuf.st_size;
+            mapped = true;
+        }
+    }
+    ::close(fd); // mapping is still valid
+#endif
+    if (mapped)
+        writable = copyOnWrite;
+    else
+    {
+        // fallback: just load file
+        loadedContent = loadDataFromFile(filename);
+        content = loadedContent.data();
+        fileSize = loadedContent.size();
+        writable = true;
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    if (!mapped)
+        return;
+#ifdef HAVE_WINDOWS
+    UnmapViewOfFile(content);
+#elif defined(HAVE_LINUX) || defined(HAVE_BSD)
+    ::munmap(content, fileSize);
+#endif
+}
+
 void CLRX::filesystemPath(char* path)
 {
     while (*path != 0)  // change to native dir separator